@@ -22,6 +22,8 @@
 
 #include "vmaware.hpp"
 #include <iostream>
+#include <fstream>
+#include <iterator>
 #include <string>
 #include <cmath>
 
@@ -81,6 +83,74 @@ public:
     }
 };
 
+#if defined(__linux__)
+// how util::read_file() and util::read_file_binary() used to read files, to compare against the current ones
+static std::string legacy_read_file(const char* path) {
+    std::ifstream file(path);
+    std::string data;
+    std::string line;
+
+    while (std::getline(file, line)) {
+        data += line + "\n";
+    }
+
+    return data;
+}
+
+static std::vector<uint8_t> legacy_read_file_binary(const char* path) {
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> buffer;
+
+    try {
+        std::istreambuf_iterator<char> it(file);
+        const std::istreambuf_iterator<char> end;
+
+        while (it != end) {
+            buffer.push_back(static_cast<uint8_t>(*it));
+            ++it;
+        }
+    } catch (...) {}
+
+    return buffer;
+}
+
+static void benchmark_file_reading() {
+    const char* files[] = {
+        "/proc/cpuinfo",
+        "/proc/self/status",
+        "/proc/modules",
+        "/proc/iomem",
+        "/sys/class/dmi/id/sys_vendor"
+    };
+
+    constexpr int rounds = 200;
+
+    auto time_rounds = [&](void(*read_one)(const char*)) -> double {
+        const uint64_t begin = VMAwareBenchmark::get_timestamp();
+
+        for (int i = 0; i < rounds; ++i) {
+            for (const char* file : files) {
+                read_one(file);
+            }
+        }
+
+        const uint64_t finish = VMAwareBenchmark::get_timestamp();
+        return VMAwareBenchmark::get_elapsed(begin, finish) / rounds;
+    };
+
+    const double legacy_text = time_rounds([](const char* path) { (void)legacy_read_file(path); });
+    const double current_text = time_rounds([](const char* path) { (void)VM::util::read_file_uncached(path); });
+    const double legacy_binary = time_rounds([](const char* path) { (void)legacy_read_file_binary(path); });
+    const double current_binary = time_rounds([](const char* path) { (void)VM::util::read_file_binary(path); });
+
+    std::cout << "\nBenchmark Results (file reading, per round of " << (sizeof(files) / sizeof(files[0])) << " files):\n"
+        << "getline read_file():            " << VMAwareBenchmark::format_duration(legacy_text) << "\n"
+        << "util::read_file_uncached():     " << VMAwareBenchmark::format_duration(current_text) << "\n"
+        << "istreambuf read_file_binary():  " << VMAwareBenchmark::format_duration(legacy_binary) << "\n"
+        << "util::read_file_binary():       " << VMAwareBenchmark::format_duration(current_binary) << "\n";
+}
+#endif
+
 static void enable_ansi_on_windows() {
 #if defined(_WIN32)
     HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
@@ -139,7 +209,15 @@ int main(void) {
         << "VM::percentage(): " << VMAwareBenchmark::format_duration(percent_time) << "\n\n"
         << "Benchmark Results (not cached):\n";
 
-    for (const VM::enum_flags technique_enum : VM::technique_vector) {
+    for (uint8_t i = VM::technique_begin; i < VM::technique_end; ++i) {
+        const VM::enum_flags technique_enum = static_cast<VM::enum_flags>(i);
+
+        if (!VM::core::technique_table.at(i).run) {
+            continue;
+        }
+
+        VM::memo::uncache(technique_enum);
+
         start = VMAwareBenchmark::get_timestamp();
 
         VM::check(technique_enum);
@@ -155,6 +233,50 @@ int main(void) {
             "\n";
     }
 
+    // VM::vmaware struct versus fetching the same fields one function at a time (how the struct used to be built)
+    auto sequential = []() {
+        const std::string brand = VM::brand();
+        const std::string type = VM::type();
+        const std::string conclusion = VM::conclusion();
+        const bool is_vm = VM::detect();
+        const bool hardened = VM::is_hardened();
+        const uint8_t percent = VM::percentage();
+        const uint8_t count = VM::detected_count();
+        const std::vector<VM::enum_flags> detected = VM::detected_enums();
+        (void)brand; (void)type; (void)conclusion; (void)is_vm; (void)hardened; (void)percent; (void)count; (void)detected;
+    };
+
+    auto measure = [](const bool cold, void(*fn)()) -> double {
+        if (cold) {
+            VM::memo::reset();
+        }
+
+        const uint64_t begin = VMAwareBenchmark::get_timestamp();
+        fn();
+        const uint64_t finish = VMAwareBenchmark::get_timestamp();
+        return VMAwareBenchmark::get_elapsed(begin, finish);
+    };
+
+    auto single_pass = []() {
+        const VM::vmaware vm;
+        (void)vm;
+    };
+
+    const double sequential_cold = measure(true, sequential);
+    const double sequential_warm = measure(false, sequential);
+    const double struct_cold = measure(true, single_pass);
+    const double struct_warm = measure(false, single_pass);
+
+    std::cout << "\nBenchmark Results (VM::vmaware struct):\n"
+        << "one function at a time (cold): " << VMAwareBenchmark::format_duration(sequential_cold) << "\n"
+        << "VM::vmaware (cold):            " << VMAwareBenchmark::format_duration(struct_cold) << "\n"
+        << "one function at a time (warm): " << VMAwareBenchmark::format_duration(sequential_warm) << "\n"
+        << "VM::vmaware (warm):            " << VMAwareBenchmark::format_duration(struct_warm) << "\n";
+
+#if defined(__linux__)
+    benchmark_file_reading();
+#endif
+
     std::cout << "\n";
 
     return 0;
@@ -0,0 +1,207 @@
+#include "../src/vmaware.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+static int pass_count = 0;
+static int fail_count = 0;
+
+static void check(bool condition, const char* label) {
+    if (condition) {
+        std::cout << "  PASS  " << label << "\n";
+        ++pass_count;
+    } else {
+        std::cerr << "  FAIL  " << label << "\n";
+        ++fail_count;
+    }
+}
+
+static std::string lowercase(std::string text) {
+    for (char& c : text) {
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c | 0x20);
+        }
+    }
+    return text;
+}
+
+// what the matchers replaced: one std::string::find() per pattern
+static std::uint64_t naive_scan(const std::string& buffer, const std::vector<const char*>& patterns, const bool ignore_case) {
+    const std::string haystack = ignore_case ? lowercase(buffer) : buffer;
+    std::uint64_t found = 0;
+
+    for (std::size_t i = 0; i < patterns.size(); ++i) {
+        const std::string needle = ignore_case ? lowercase(patterns[i]) : patterns[i];
+
+        if (haystack.find(needle) != std::string::npos) {
+            found |= (1ULL << i);
+        }
+    }
+
+    return found;
+}
+
+// random bytes mixed with pieces of the patterns, with a few whole patterns dropped in at random places
+static std::string random_buffer(std::mt19937& rng, const std::vector<const char*>& patterns, const bool mix_case) {
+    std::string buffer;
+    const std::size_t length = rng() % 300;
+
+    for (std::size_t i = 0; i < length; ++i) {
+        if (rng() % 3 == 0) {
+            buffer += static_cast<char>(rng());
+        } else {
+            const char* pattern = patterns[rng() % patterns.size()];
+            buffer += pattern[rng() % std::char_traits<char>::length(pattern)];
+        }
+    }
+
+    for (int inserts = static_cast<int>(rng() % 3); inserts > 0; --inserts) {
+        std::string pattern = patterns[rng() % patterns.size()];
+
+        if (mix_case) {
+            for (char& c : pattern) {
+                if ((rng() % 2) && (c >= 'a' && c <= 'z')) {
+                    c = static_cast<char>(c & 0xDF);
+                }
+            }
+        }
+
+        buffer.insert(rng() % (buffer.size() + 1), pattern);
+    }
+
+    return buffer;
+}
+
+static bool matches_naive(const std::vector<const char*>& patterns, const bool ignore_case, const unsigned seed) {
+    const VM::util::pattern_matcher matcher(patterns.data(), patterns.size(), ignore_case);
+    std::mt19937 rng(seed);
+
+    for (int round = 0; round < 20000; ++round) {
+        const std::string buffer = random_buffer(rng, patterns, ignore_case);
+        const std::uint64_t found = matcher.scan(reinterpret_cast<const std::uint8_t*>(buffer.data()), buffer.size());
+
+        if (found != naive_scan(buffer, patterns, ignore_case)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main() {
+    std::cout << "=== util::pattern_matcher ===\n";
+    {
+        std::vector<const char*> firmware;
+
+        for (const auto& target : VM::util::firmware_targets()) {
+            firmware.push_back(target.first);
+        }
+
+        std::vector<const char*> vendors;
+
+        for (const auto& vendor : VM::util::dmi_vendors()) {
+            vendors.push_back(vendor.first);
+        }
+
+        // overlapping prefixes and suffixes, which is where the failure links matter
+        const std::vector<const char*> overlapping = { "aaab", "aab", "ab", "b", "abab", "ba", "bab", "a" };
+
+        check(firmware.size() <= 64, "FIRMWARE targets fit in the 64 bit mask");
+        check(vendors.size() <= 32, "DMI vendors fit in the 32 bit masks of util::smbios_matches");
+        check(matches_naive(firmware, false, 1), "FIRMWARE targets match std::string::find() on random buffers");
+        check(matches_naive(vendors, true, 2), "DMI vendors match a lowercase std::string::find() on random buffers");
+        check(matches_naive(overlapping, false, 3), "overlapping patterns match std::string::find() on random buffers");
+        check(matches_naive(overlapping, true, 4), "overlapping patterns match without case on random buffers");
+
+        const VM::util::pattern_matcher matcher(firmware.data(), firmware.size());
+        const std::string empty;
+        check(matcher.scan(reinterpret_cast<const std::uint8_t*>(empty.data()), 0) == 0, "an empty buffer matches nothing");
+    }
+
+    std::cout << "\n=== util::perfect_hash ===\n";
+    {
+        const std::vector<VM::util::pci_id>& ids = VM::util::known_pci_ids();
+        const VM::util::perfect_hash<VM::util::pci_id> table(ids.data(), ids.size());
+
+        std::set<std::uint64_t> keys;
+        bool all_found = true;
+
+        for (const VM::util::pci_id& id : ids) {
+            keys.insert(id.key);
+
+            const VM::util::pci_id* const match = table.find(id.key);
+            all_found = all_found && (match != nullptr) && (match->key == id.key) && (match->brand == id.brand);
+        }
+
+        check(keys.size() == ids.size(), "every PCI ID is listed only once");
+        check(all_found, "every PCI ID finds its own entry");
+
+        // what the table replaced: a linear lookup, here over keys near the real ones and random ones
+        std::mt19937_64 rng(5);
+        bool same_as_linear = true;
+
+        for (int round = 0; round < 200000; ++round) {
+            std::uint64_t key = rng();
+
+            switch (round % 4) {
+                case 0: key = ids[static_cast<std::size_t>(key % ids.size())].key ^ (1ULL << (rng() % 48)); break;
+                case 1: key = ids[static_cast<std::size_t>(key % ids.size())].key ^ VM::util::pci_id::WIDE; break;
+                case 2: key &= 0xFFFFFFFFULL; break;
+                default: break;
+            }
+
+            const bool listed = (keys.count(key) != 0);
+            const VM::util::pci_id* const match = table.find(key);
+
+            if (listed != ((match != nullptr) && (match->key == key))) {
+                same_as_linear = false;
+                break;
+            }
+        }
+
+        check(same_as_linear, "unknown PCI IDs are never matched");
+
+        // random key sets of other sizes, so adding IDs can't run into a table that fails to build
+        bool random_sets = true;
+
+        for (std::size_t size = 1; size <= 2000; size += 37) {
+            std::vector<VM::util::pci_id> random_ids;
+            std::set<std::uint64_t> used;
+
+            while (random_ids.size() < size) {
+                const std::uint64_t key = rng();
+
+                if (used.insert(key).second) {
+                    random_ids.push_back({ key, VM::brand_enum::NULL_BRAND, nullptr });
+                }
+            }
+
+            const VM::util::perfect_hash<VM::util::pci_id> random_table(random_ids.data(), random_ids.size());
+
+            for (const VM::util::pci_id& id : random_ids) {
+                random_sets = random_sets && (random_table.find(id.key) == &id);
+            }
+
+            for (int miss = 0; miss < 1000; ++miss) {
+                const std::uint64_t key = rng();
+                random_sets = random_sets && ((used.count(key) != 0) || (random_table.find(key) == nullptr));
+            }
+        }
+
+        check(random_sets, "random key sets of up to 2000 keys are all found and nothing else is");
+    }
+
+    std::cout << "\n-----------\n";
+    std::cout << "PASSED: " << pass_count << "\n";
+    if (fail_count > 0) {
+        std::cerr << "FAILED: " << fail_count << "\n";
+    } else {
+        std::cout << "FAILED: " << fail_count << "\n";
+    }
+
+    return (fail_count > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
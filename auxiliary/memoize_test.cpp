@@ -1,8 +1,12 @@
 #include "../src/vmaware.hpp"
 #include <array>
+#include <atomic>
 #include <cstdlib>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 static int pass_count = 0;
 static int fail_count = 0;
@@ -41,15 +45,94 @@ static bool scoreboard_non_decreasing(
     return true;
 }
 
+// every technique in the table is wrapped so the number of times it actually ran can be checked
+static std::array<std::atomic<int>, VM::enum_size + 1> run_counts{};
+static std::array<bool(*)(), VM::enum_size + 1> original_runs{};
+
+template <std::size_t I>
+static bool counted_run() {
+    run_counts[I].fetch_add(1);
+    return original_runs[I]();
+}
+
+template <std::size_t... I>
+static void count_technique_runs(std::index_sequence<I...>) {
+    ((original_runs[I] = VM::core::technique_table[I].run,
+      VM::core::technique_table[I].run = (original_runs[I] != nullptr) ? &counted_run<I> : nullptr), ...);
+}
+
 int main() {
-    // Phase 1: Mixed-flag behavior (MUST run first, cold caches)
+    count_technique_runs(std::make_index_sequence<VM::enum_size + 1>{});
+
+    // Phase 0: Concurrent cold-cache detections (MUST run first, nothing cached yet)
+    //
+    // Every thread reaches every uncached technique at about the same time. One of
+    // them claims it and the others wait for its result, so each technique must
+    // still run at most once and all threads must agree on the verdicts.
+
+    std::cout << "=== Concurrent VM::detect() and VM::brand() ===\n";
+    {
+        constexpr std::size_t thread_count = 8;
+
+        std::atomic<bool> go{ false };
+        std::array<bool, thread_count> detect_results{};
+        std::array<std::string, thread_count> brand_results{};
+        std::vector<std::thread> threads;
+
+        for (std::size_t i = 0; i < thread_count; ++i) {
+            threads.emplace_back([&, i]() {
+                while (!go.load()) {
+                    std::this_thread::yield();
+                }
+
+                // half of the threads ask for the brand first so both paths race for the same techniques
+                if (i % 2 == 0) {
+                    detect_results[i] = VM::detect();
+                    brand_results[i] = VM::brand();
+                } else {
+                    brand_results[i] = VM::brand();
+                    detect_results[i] = VM::detect();
+                }
+            });
+        }
+
+        go.store(true);
+
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        bool same_detect = true;
+        bool same_brand = true;
+
+        for (std::size_t i = 1; i < thread_count; ++i) {
+            same_detect = same_detect && (detect_results[i] == detect_results[0]);
+            same_brand = same_brand && (brand_results[i] == brand_results[0]);
+        }
+
+        int ran = 0;
+        bool at_most_once = true;
+
+        for (const std::atomic<int>& count : run_counts) {
+            ran += (count.load() > 0);
+            at_most_once = at_most_once && (count.load() <= 1);
+        }
+
+        check(ran > 0, "techniques were run by the concurrent detections");
+        check(at_most_once, "every technique ran at most once across all threads");
+        check(same_detect, "every thread got the same VM::detect() verdict");
+        check(same_brand, "every thread got the same VM::brand() verdict");
+        check(detect_results[0] == VM::detect(), "concurrent VM::detect() verdict matches a later call");
+    }
+
+    // Phase 1: Mixed-flag behavior
     //
     // run_all() resets detected_count_num and brand_scoreboard to zero at the
     // start of every call, then re-accumulates from the technique cache for
     // only the enabled techniques. This means values are per-call scoped, not
     // globally accumulated. These tests verify that invariant.
 
-    std::cout << "=== Mixed-flag: detected_count_num per-call scoping ===\n";
+    std::cout << "\n=== Mixed-flag: detected_count_num per-call scoping ===\n";
     {
         VM::detected_count(VM::HYPERVISOR_BIT);
         const auto num_single = VM::detected_count_num.load();
@@ -159,6 +242,87 @@ int main() {
         check(conc1 == conc3, "VM::conclusion() 3rd call matches 1st");
     }
 
+    std::cout << "\n=== VM::detect_async() ===\n";
+    {
+        VM::async_result<bool> handle = VM::detect_async();
+        const bool async_result = handle.get();
+
+        check(async_result == VM::detect(), "VM::detect_async() matches VM::detect()");
+        check(!handle.is_ready(), "is_ready() is false once get() took the result");
+
+        VM::async_result<std::string> first = VM::brand_async();
+        VM::async_result<std::string> second = std::move(first);
+        const bool moved = (!first.worker.joinable() && second.worker.joinable());
+
+        second = VM::async_result<std::string>(); // cancels and joins the detection it owned
+        check(moved && !second.worker.joinable(), "a handle owns the thread of its detection until it's dropped");
+    }
+
+    // Phase 3: VM::refresh() and VM::memo::reset() while other threads keep detecting
+    //
+    // Both take published results back, so they have to wait for the detections in
+    // progress and the new ones have to wait for them. The verdicts must not change
+    // since nothing on the system did.
+
+    std::cout << "\n=== Concurrent VM::refresh() and VM::detect() ===\n";
+    {
+        const bool expected_detect = VM::detect();
+        const std::string expected_brand = VM::brand();
+        const std::string expected_conclusion = VM::conclusion();
+
+        constexpr std::size_t thread_count = 4;
+        constexpr int refresh_rounds = 20;
+
+        std::atomic<bool> done{ false };
+        std::atomic<int> mismatches{ 0 };
+        std::atomic<int> detections{ 0 };
+        std::vector<std::thread> threads;
+
+        for (std::size_t i = 0; i < thread_count; ++i) {
+            threads.emplace_back([&]() {
+                while (!done.load()) {
+                    const bool ok = (
+                        (VM::detect() == expected_detect) &&
+                        (VM::brand() == expected_brand) &&
+                        (VM::conclusion() == expected_conclusion)
+                    );
+
+                    if (!ok) {
+                        mismatches.fetch_add(1);
+                    }
+
+                    detections.fetch_add(1);
+                }
+            });
+        }
+
+        std::uint8_t refreshed_percentage = 0;
+
+        for (int round = 0; round < refresh_rounds; ++round) {
+            // every result looks older than its lifetime, so the ones that can change are forgotten and run again
+            for (VM::memo::cache_entry& entry : VM::memo::cache_table) {
+                entry.stored_at.store(0);
+            }
+
+            refreshed_percentage = VM::refresh();
+
+            if (round % 5 == 4) {
+                VM::memo::reset();
+            }
+        }
+
+        done.store(true);
+
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        check(detections.load() > 0, "detections ran while refreshing");
+        check(mismatches.load() == 0, "every detection during the refreshes got the same verdicts");
+        check(refreshed_percentage == VM::percentage(), "VM::refresh() percentage matches VM::percentage()");
+        check(VM::brand() == expected_brand, "VM::brand() unchanged after the refreshes");
+    }
+
     std::cout << "\n-----------\n";
     std::cout << "PASSED: " << pass_count << "\n";
     if (fail_count > 0) {
@@ -0,0 +1,160 @@
+// the tiers promise to leave every file, directory and process alone below VM::TIER_IO, so every libc
+// function the library opens those with is replaced here by one that records the path first
+#undef _FORTIFY_SOURCE
+
+#include "../src/vmaware.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+static int pass_count = 0;
+static int fail_count = 0;
+
+static void check(bool condition, const char* label) {
+    if (condition) {
+        std::cout << "  PASS  " << label << "\n";
+        ++pass_count;
+    } else {
+        std::cerr << "  FAIL  " << label << "\n";
+        ++fail_count;
+    }
+}
+
+static std::atomic<bool> watching{ false };
+static std::mutex opened_mutex;
+static std::vector<std::string> opened;
+
+static void record(const char* path) {
+    if (watching.load() && path != nullptr) {
+        const std::lock_guard<std::mutex> lock(opened_mutex);
+        opened.push_back(path);
+    }
+}
+
+template <typename F>
+static F real(const char* name) {
+    return reinterpret_cast<F>(dlsym(RTLD_NEXT, name));
+}
+
+static mode_t mode_of(const int flags, va_list args) {
+    if ((flags & O_CREAT) || ((flags & O_TMPFILE) == O_TMPFILE)) {
+        return static_cast<mode_t>(va_arg(args, unsigned int));
+    }
+
+    return 0;
+}
+
+extern "C" {
+    int open(const char* path, int flags, ...) {
+        va_list args;
+        va_start(args, flags);
+        const mode_t mode = mode_of(flags, args);
+        va_end(args);
+
+        record(path);
+        return real<int(*)(const char*, int, ...)>("open")(path, flags, mode);
+    }
+
+    int open64(const char* path, int flags, ...) {
+        va_list args;
+        va_start(args, flags);
+        const mode_t mode = mode_of(flags, args);
+        va_end(args);
+
+        record(path);
+        return real<int(*)(const char*, int, ...)>("open64")(path, flags, mode);
+    }
+
+    int openat(int dir, const char* path, int flags, ...) {
+        va_list args;
+        va_start(args, flags);
+        const mode_t mode = mode_of(flags, args);
+        va_end(args);
+
+        record(path);
+        return real<int(*)(int, const char*, int, ...)>("openat")(dir, path, flags, mode);
+    }
+
+    FILE* fopen(const char* path, const char* mode) {
+        record(path);
+        return real<FILE*(*)(const char*, const char*)>("fopen")(path, mode);
+    }
+
+    FILE* fopen64(const char* path, const char* mode) {
+        record(path);
+        return real<FILE*(*)(const char*, const char*)>("fopen64")(path, mode);
+    }
+
+    DIR* opendir(const char* path) {
+        record(path);
+        return real<DIR*(*)(const char*)>("opendir")(path);
+    }
+
+    FILE* popen(const char* command, const char* mode) {
+        record(command);
+        return real<FILE*(*)(const char*, const char*)>("popen")(command, mode);
+    }
+}
+
+static bool nothing_opened(const char* label) {
+    const std::lock_guard<std::mutex> lock(opened_mutex);
+
+    for (const std::string& path : opened) {
+        std::cerr << "        " << label << " opened " << path << "\n";
+    }
+
+    const bool clean = opened.empty();
+    opened.clear();
+    return clean;
+}
+
+int main() {
+    // Every call below runs on cold caches, so whatever the library
+    // would normally open for a full detection isn't there yet
+
+    watching = true;
+
+    std::cout << "=== VM::TIER_FAST ===\n";
+    {
+        const bool detected = VM::detect(VM::TIER_FAST, VM::HIGH_THRESHOLD);
+        VMAWARE_UNUSED(detected);
+        check(nothing_opened("VM::detect()"), "VM::detect(VM::TIER_FAST, VM::HIGH_THRESHOLD) opens nothing");
+
+        const VM::budget_result<bool> within = VM::detect_within(std::chrono::seconds(10), VM::TIER_FAST);
+        VMAWARE_UNUSED(within);
+        check(nothing_opened("VM::detect_within()"), "VM::detect_within(..., VM::TIER_FAST) opens nothing");
+
+        const std::string conclusion = VM::conclusion(VM::TIER_FAST);
+        check(nothing_opened("VM::conclusion()"), "VM::conclusion(VM::TIER_FAST) opens nothing");
+
+        const VM::vmaware vm(VM::TIER_FAST);
+        check(nothing_opened("VM::vmaware"), "VM::vmaware(VM::TIER_FAST) opens nothing");
+
+        VM::context context(VM::TIER_FAST);
+        const bool context_detected = context.detect();
+        VMAWARE_UNUSED(context_detected);
+        const std::string context_conclusion = context.conclusion();
+        check(nothing_opened("VM::context"), "VM::context(VM::TIER_FAST) opens nothing");
+    }
+
+    watching = false;
+
+    std::cout << "\n-----------\n";
+    std::cout << "PASSED: " << pass_count << "\n";
+    if (fail_count > 0) {
+        std::cerr << "FAILED: " << fail_count << "\n";
+    } else {
+        std::cout << "FAILED: " << fail_count << "\n";
+    }
+
+    return (fail_count > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -544,7 +544,7 @@ void general(bool high_threshold, bool all, bool dynamic, const char* output_fil
     checker(VM::CVENDOR, "chassis vendor");
     checker(VM::CTYPE, "chassis type");
     checker(VM::DOCKERENV, "Dockerenv");
-    checker(VM::DMIDECODE, "dmidecode output");
+    checker(VM::DMIDECODE, "SMBIOS system info");
     checker(VM::DMESG, "dmesg output");
     checker(VM::HWMON, "hwmon presence");
     checker(VM::DLL, "DLLs");
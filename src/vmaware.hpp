@@ -385,6 +385,12 @@
 #include <numeric>
 #include <atomic>
 #include <random>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <chrono>
+#include <future>
+#include <memory>
 
 #if (WINDOWS)
     #include <windows.h>
@@ -406,12 +412,18 @@
         #include <immintrin.h>
     #endif
     #include <sys/stat.h>
+    #include <sys/mman.h>
     #include <sys/statvfs.h>
     #include <sys/ioctl.h>
+    #include <sys/klog.h>
     #include <sys/syscall.h>
     #include <sys/sysinfo.h>
     #include <net/if.h> 
     #include <netinet/in.h>
+    #include <net/if_arp.h>
+    #include <sys/socket.h>
+    #include <linux/netlink.h>
+    #include <linux/rtnetlink.h>
     #include <unistd.h>
     #include <dirent.h>
     #include <memory>
@@ -423,6 +435,17 @@
     #include <pthread.h>     
     #include <sched.h>      
     #include <cerrno>   
+    #if defined(__has_include)
+        #if __has_include(<linux/io_uring.h>)
+            #include <linux/io_uring.h>
+        #endif
+    #endif
+    // openat, read and close through io_uring need 5.6 headers, used by VM::PREFETCH
+    #if (defined(IORING_FEAT_RW_CUR_POS) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter))
+        #define VMA_IO_URING 1
+    #else
+        #define VMA_IO_URING 0
+    #endif
 #elif (APPLE)
     #if (x86)
         #include <cpuid.h>
@@ -677,7 +700,14 @@ public:
         HIGH_THRESHOLD,
         EXPERIMENTAL,
         DYNAMIC,
-        MULTIPLE
+        MULTIPLE,
+        PARALLEL,
+        TIER_FAST,
+        TIER_IO,
+        TIER_EXEC,
+        PERSIST,
+        SHARED,
+        PREFETCH
     };
 
     enum class brand_enum : u8 {
@@ -755,8 +785,8 @@ public:
         NULL_BRAND // do not modify the placement for this, as it's used to count the number of brands here
     };
 
-    static constexpr u8 enum_size = MULTIPLE; // get enum size through value of last element
-    static constexpr u8 settings_count = static_cast<u8>(MULTIPLE - HIGH_THRESHOLD + 1); // get number of settings technique flags
+    static constexpr u8 enum_size = PREFETCH; // get enum size through value of last element
+    static constexpr u8 settings_count = static_cast<u8>(PREFETCH - HIGH_THRESHOLD + 1); // get number of settings technique flags
     static constexpr u8 INVALID = 255; // explicit invalid technique macro
     static constexpr u16 base_technique_count = HIGH_THRESHOLD; // original technique count, constant on purpose (can also be used as a base count value if custom techniques are added)
     static constexpr u16 threshold_score = 150; // standard threshold score
@@ -3151,36 +3181,199 @@ public:
             bool cached;
             brand_enum brand_name;
         };
+
+        // a single core::add() call made by a technique, kept along with its cached result
+        struct brand_contribution {
+            brand_enum brand;
+            brand_enum extra_brand;
+        };
+
+        // Every cached value below is published only once: the first thread claims the slot, 
+        // fills in the value and releases it, so readers only need a single acquire load to 
+        // see a complete value. Only VM::refresh() and memo::reset() ever take a value back, see refresh_lock
+        enum slot_state : u8 {
+            SLOT_EMPTY = 0,
+            SLOT_BUSY = 1,
+            SLOT_READY = 2
+        };
+
+        // true if the caller gets to fill in the slot, otherwise it waits until whoever did is done
+        static bool claim(std::atomic<u8>& state) noexcept {
+            u8 expected = SLOT_EMPTY;
+
+            if (state.compare_exchange_strong(expected, SLOT_BUSY, std::memory_order_acquire, std::memory_order_relaxed)) {
+                return true;
+            }
+
+            while (state.load(std::memory_order_acquire) == SLOT_BUSY) {
+                std::this_thread::yield();
+            }
+
+            return false;
+        }
+
+        static void publish(std::atomic<u8>& state) noexcept {
+            state.store(SLOT_READY, std::memory_order_release);
+        }
+
+        static bool is_ready(const std::atomic<u8>& state) noexcept {
+            return (state.load(std::memory_order_acquire) == SLOT_READY);
+        }
+
+        // VM::refresh() and memo::reset() hold this exclusively while they empty published slots, and every 
+        // detection holds it shared for the whole call. So a journal or a verdict can't be cleared and filled 
+        // in again by someone else while a detection is still reading it. A waiting refresh goes before any 
+        // new detection, otherwise a busy daemon could hold it off forever
+        struct refresh_lock {
+            static std::mutex mutex;
+            static std::condition_variable changed;
+            static u32 readers;
+            static u32 writers_waiting;
+            static bool writer;
+            static thread_local u32 depth; // public functions call each other, only the outermost one locks
+        };
+
+        class detection_guard {
+        public:
+            detection_guard() {
+                if (refresh_lock::depth++ != 0) {
+                    return;
+                }
+
+                std::unique_lock<std::mutex> lock(refresh_lock::mutex);
+                refresh_lock::changed.wait(lock, []() {
+                    return (!refresh_lock::writer && (refresh_lock::writers_waiting == 0));
+                });
+                refresh_lock::readers++;
+            }
+
+            ~detection_guard() {
+                if (--refresh_lock::depth != 0) {
+                    return;
+                }
+
+                const std::lock_guard<std::mutex> lock(refresh_lock::mutex);
+
+                if (--refresh_lock::readers == 0) {
+                    refresh_lock::changed.notify_all();
+                }
+            }
+
+            detection_guard(const detection_guard&) = delete;
+            detection_guard& operator=(const detection_guard&) = delete;
+        };
+
+        // for a thread that works for another one which already holds the lock, like the VM::PARALLEL workers
+        class inherited_detection {
+        public:
+            inherited_detection() { refresh_lock::depth++; }
+            ~inherited_detection() { refresh_lock::depth--; }
+
+            inherited_detection(const inherited_detection&) = delete;
+            inherited_detection& operator=(const inherited_detection&) = delete;
+        };
+
+        class refresh_guard {
+        public:
+            refresh_guard() {
+                // waiting for our own detection to finish would never end
+                if (refresh_lock::depth != 0) {
+                    throw std::logic_error("VM::refresh() and VM::memo::reset() can't be called from inside a detection");
+                }
+
+                std::unique_lock<std::mutex> lock(refresh_lock::mutex);
+                refresh_lock::writers_waiting++;
+                refresh_lock::changed.wait(lock, []() {
+                    return (!refresh_lock::writer && (refresh_lock::readers == 0));
+                });
+                refresh_lock::writers_waiting--;
+                refresh_lock::writer = true;
+                refresh_lock::depth++;
+            }
+
+            ~refresh_guard() {
+                refresh_lock::depth--;
+
+                const std::lock_guard<std::mutex> lock(refresh_lock::mutex);
+                refresh_lock::writer = false;
+                refresh_lock::changed.notify_all();
+            }
+
+            refresh_guard(const refresh_guard&) = delete;
+            refresh_guard& operator=(const refresh_guard&) = delete;
+        };
+
+        // the whole verdict of a technique fits in a single word, see pack()
         struct cache_entry {
-            bool result;
-            u8 points;
-            bool has_value;
-            brand_enum brand_name;
+            std::atomic<u32> word{ 0 };
+            std::atomic<u64> stored_at{ 0 }; // steady clock milliseconds, for the techniques that expire
+            std::vector<brand_contribution> journal; // written before the word is published
         };
 
         static std::array<cache_entry, enum_size + 1> cache_table;
 
+        // bumped whenever a technique result is stored or forgotten, so the scoreboard knows when it's stale
+        static std::atomic<u32> cache_generation;
+
+        // bits 0-1: slot state, bit 2: result, bits 8-15: points, bits 16-23: brand
+        static constexpr u32 pack(const u8 state, const bool result, const u8 points, const brand_enum brand) noexcept {
+            return (
+                static_cast<u32>(state) |
+                (static_cast<u32>(result) << 2) |
+                (static_cast<u32>(points) << 8) |
+                (static_cast<u32>(brand) << 16)
+            );
+        }
+
+        // a claimed or empty entry carries no verdict at all, not even NULL_BRAND
+        static constexpr u32 EMPTY_WORD = SLOT_EMPTY;
+        static constexpr u32 BUSY_WORD = SLOT_BUSY;
+
+        static constexpr u8 state_of(const u32 word) noexcept {
+            return static_cast<u8>(word & 0x3u);
+        }
+
+        static u64 now_ms() noexcept {
+            return static_cast<u64>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()
+            ).count());
+        }
+
         static void cache_store(u16 flag, bool result, u8 points, const brand_enum brand = brand_enum::NULL_BRAND) {
             if (flag <= enum_size) {
-                cache_table.at(flag) = { result, points, true, brand };
+                cache_table.at(flag).stored_at.store(now_ms(), std::memory_order_relaxed);
+                cache_table.at(flag).word.store(pack(SLOT_READY, result, points, brand), std::memory_order_release);
+                cache_generation.fetch_add(1, std::memory_order_release);
+            }
+        }
+
+        // same as above, but also keeps the brand contributions of the technique for the scoreboard
+        static void cache_store(u16 flag, bool result, u8 points, const brand_enum brand, std::vector<brand_contribution>&& journal) {
+            if (flag <= enum_size) {
+                cache_table.at(flag).journal = std::move(journal);
+                cache_store(flag, result, points, brand);
             }
         }
 
         static bool is_cached(u16 flag) {
             if (flag <= enum_size) {
-                return cache_table.at(flag).has_value;
+                return (state_of(cache_table.at(flag).word.load(std::memory_order_acquire)) == SLOT_READY);
             }
             return false;
         }
 
         static data_t cache_fetch(u16 flag) {
-            if (flag <= enum_size && cache_table.at(flag).has_value) {
-                return { 
-                    /* result */ cache_table.at(flag).result, 
-                    /* points */ cache_table.at(flag).points, 
-                    /* cached */ true, 
-                    /* brand_name */ cache_table.at(flag).brand_name
-                };
+            if (flag <= enum_size) {
+                const u32 word = cache_table.at(flag).word.load(std::memory_order_acquire);
+
+                if (state_of(word) == SLOT_READY) {
+                    return { 
+                        /* result */ ((word >> 2) & 1u) != 0, 
+                        /* points */ static_cast<u8>(word >> 8), 
+                        /* cached */ true, 
+                        /* brand_name */ static_cast<brand_enum>(static_cast<u8>(word >> 16))
+                    };
+                }
             }
 
             return { 
@@ -3191,24 +3384,83 @@ public:
             };
         }
 
+        // makes the calling thread the only one running the technique, it has to cache_store() or release() it afterwards
+        static bool claim_technique(u16 flag) {
+            if (flag > enum_size) {
+                return true;
+            }
+
+            u32 expected = EMPTY_WORD;
+            return cache_table.at(flag).word.compare_exchange_strong(
+                expected, 
+                BUSY_WORD, 
+                std::memory_order_acquire, 
+                std::memory_order_relaxed
+            );
+        }
+
+        // gives up a claim without caching anything, for when the technique failed
+        static void release_technique(u16 flag) {
+            if (flag <= enum_size) {
+                cache_table.at(flag).word.store(EMPTY_WORD, std::memory_order_release);
+            }
+        }
+
+        // waits for the thread that claimed the technique to either cache its result or give up
+        static void wait_for_technique(u16 flag) {
+            if (flag > enum_size) {
+                return;
+            }
+
+            while (state_of(cache_table.at(flag).word.load(std::memory_order_acquire)) == SLOT_BUSY) {
+                std::this_thread::yield();
+            }
+        }
+
         static void uncache(u16 flag) {
             if (flag <= enum_size) {
-                cache_table.at(flag).has_value = false;
-                cache_table.at(flag).brand_name = brand_enum::NULL_BRAND;
+                cache_table.at(flag).word.store(EMPTY_WORD, std::memory_order_release);
+                cache_generation.fetch_add(1, std::memory_order_release);
+            }
+        }
+
+        // forgets a cached result once it's older than its lifetime, a lifetime of 0 never expires
+        static bool expire(u16 flag, const u32 lifetime_ms, const u64 now) {
+            if ((flag > enum_size) || (lifetime_ms == 0)) {
+                return false;
+            }
+
+            cache_entry& entry = cache_table.at(flag);
+            u32 word = entry.word.load(std::memory_order_acquire);
+
+            if ((state_of(word) != SLOT_READY) || (now - entry.stored_at.load(std::memory_order_relaxed) < lifetime_ms)) {
+                return false;
+            }
+
+            // a result that got stored again in the meantime is fresh anyway
+            if (!entry.word.compare_exchange_strong(word, EMPTY_WORD, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                return false;
             }
+
+            cache_generation.fetch_add(1, std::memory_order_release);
+            return true;
         }
 
         struct single_brand {
             static brand_enum brand_cache;
-            static bool cached;
+            static std::atomic<u8> state;
 
             static void store(const brand_enum s) {
+                if (!claim(state)) {
+                    return;
+                }
+
                 brand_cache = s;
-                cached = true;
+                publish(state);
                 debug("VM::brand(): cached brand string");
             }
 
-            static bool is_cached() { return cached; }
+            static bool is_cached() { return is_ready(state); }
             static brand_enum fetch() { 
                 debug("VM::brand(): returned brand from cache");
                 return brand_cache; 
@@ -3217,15 +3469,19 @@ public:
 
         struct multi_brand {
             static std::string brand_cache;
-            static bool cached;
+            static std::atomic<u8> state;
 
             static void store(const std::string& s) {
+                if (!claim(state)) {
+                    return;
+                }
+
                 brand_cache = s;
-                cached = true;
+                publish(state);
                 debug("VM::brand(): cached multiple brand string");
             }
 
-            static bool is_cached() { return cached; }
+            static bool is_cached() { return is_ready(state); }
             static std::string fetch() { 
                 debug("VM::brand(): returned multi brand from cache");
                 return brand_cache; 
@@ -3234,15 +3490,19 @@ public:
 
         struct brand_list {
             static brand_list_t cache;
-            static bool cached;
+            static std::atomic<u8> state;
 
             static void store(const brand_list_t& list) {
+                if (!claim(state)) {
+                    return;
+                }
+
                 cache = list;
-                cached = true;
+                publish(state);
                 debug("VM::brand(): cached internal brand list");
             }
 
-            static bool is_cached() { return cached; }
+            static bool is_cached() { return is_ready(state); }
             static brand_list_t fetch() { 
                 debug("VM::brand(): returned internal brand list from cache");
                 return cache;
@@ -3252,45 +3512,61 @@ public:
         // helper specifically for conclusion strings
         struct conclusion {
             static char cache[512];
-            static bool cached;
+            static std::atomic<u8> state;
             static void store(const char* s) {
+                if (!claim(state)) {
+                    return;
+                }
+
                 str_copy(cache, s, sizeof(cache));
-                cached = true;
+                publish(state);
             }
+            static bool is_cached() { return is_ready(state); }
             static const char* fetch() { return cache; }
         };
 
         struct cpu_brand {
             static char brand_cache[128];
-            static bool cached;
+            static std::atomic<u8> state;
             static void store(const char* s) {
+                if (!claim(state)) {
+                    return;
+                }
+
                 str_copy(brand_cache, s, sizeof(brand_cache));
-                cached = true;
+                publish(state);
             }
-            static bool is_cached() { return cached; }
+            static bool is_cached() { return is_ready(state); }
             static const char* fetch() { return brand_cache; }
         };
 
         struct threadcount {
-            static u32 threadcount_cache;
+            static std::atomic<u32> threadcount_cache;
             static u32 fetch() {
-                if (threadcount_cache != 0) {
-                    return threadcount_cache;
+                const u32 count = threadcount_cache.load(std::memory_order_relaxed);
+
+                if (count != 0) {
+                    return count;
                 }
-                threadcount_cache = std::thread::hardware_concurrency();
-                return threadcount_cache;
+
+                threadcount_cache.store(std::thread::hardware_concurrency(), std::memory_order_relaxed);
+                return threadcount_cache.load(std::memory_order_relaxed);
             }
         };
 
         struct hyperx {
             static hyperx_state state;
-            static bool cached;
+            static std::atomic<u8> slot;
             static hyperx_state fetch() { return state; }
             static void store(const hyperx_state p_state) {
+                if (!claim(slot)) {
+                    return;
+                }
+
                 state = p_state;
-                cached = true;
+                publish(slot);
             }
-            static bool is_cached() { return cached; }
+            static bool is_cached() { return is_ready(slot); }
         };
 
         struct leaf_entry { 
@@ -3299,13 +3575,17 @@ public:
             bool has_value; 
         };
 
+        // only used while techniques run, so a plain lock is fine here
         struct leaf_cache {
             static constexpr std::size_t CAPACITY = 128;
             static std::array<leaf_entry, CAPACITY> table;
             static std::size_t count;      
             static std::size_t next_index; 
+            static std::mutex mutex;
 
             static bool fetch(u32 leaf, bool& out) {
+                const std::lock_guard<std::mutex> lock(mutex);
+
                 for (std::size_t i = 0; i < count; ++i) {
                     if (table.at(i).has_value && table.at(i).leaf == leaf) { 
                         out = table.at(i).value; 
@@ -3316,6 +3596,8 @@ public:
             }
 
             static void store(u32 leaf, bool val) {
+                const std::lock_guard<std::mutex> lock(mutex);
+
                 for (std::size_t i = 0; i < count; ++i) {
                     if (table.at(i).leaf == leaf) { 
                         table.at(i).value = val; 
@@ -3337,8951 +3619,11577 @@ public:
         struct bios_info {
             static char manufacturer[256];
             static char model[128];
-            static bool cached;
-
-            static void store_manufacturer(const char* s) noexcept {
-                if (!s) { manufacturer[0] = '\0'; return; }
-                const size_t n = strlen(s);
-                const size_t cap = sizeof(manufacturer) - 1;
-                const size_t tocopy = (n > cap) ? cap : n;
-                memcpy(manufacturer, s, tocopy);
-                *(manufacturer + tocopy) = '\0';
-                cached = true;
-            }
-            static void store_model(const char* s) noexcept {
-                if (!s) { model[0] = '\0'; return; }
-                const size_t n = strlen(s);
-                const size_t cap = sizeof(model) - 1;
-                const size_t tocopy = (n > cap) ? cap : n;
-                memcpy(model, s, tocopy);
-                *(model + tocopy) = '\0';
-                cached = true;
-            }
-
-            static bool is_cached() noexcept { return cached; }
+            static std::atomic<u8> state;
+
+            static void store(const char* p_manufacturer, const char* p_model) noexcept {
+                if (!claim(state)) {
+                    return;
+                }
+
+                str_copy(manufacturer, p_manufacturer, sizeof(manufacturer));
+                str_copy(model, p_model, sizeof(model));
+                publish(state);
+            }
+
+            static bool is_cached() noexcept { return is_ready(state); }
             static const char* fetch_manufacturer() noexcept { return manufacturer; }
             static const char* fetch_model() noexcept { return model; }
         };
 
         struct hardened {
             static bool result;
-            static bool cached;
-        };
-    };
+            static std::atomic<u8> state;
 
-#if (WINDOWS)
-    // timer helper functionalities
-    struct timer {
-    #if (x86_64)
-        using timer_tick_t = u64;
-    #else
-        using timer_tick_t = u32;
-    #endif
+            static void store(const bool p_result) {
+                if (!claim(state)) {
+                    return;
+                }
 
-        #if (MSVC)
-            #pragma warning(push)
-            #pragma warning(disable: 4324) 
-        #endif
-        // align to prevent false sharing when triggering hypervisor exits with the intentional data race condition
-        struct alignas(64) cache_state {
-            alignas(64) volatile timer_tick_t counter { 0 };
-            alignas(64) std::atomic<bool> start_test { false };
-            alignas(64) std::atomic<bool> test_done  { false };
+                result = p_result;
+                publish(state);
+            }
+            static bool is_cached() { return is_ready(state); }
+            static bool fetch() { return result; }
         };
-        #if (MSVC)
-            #pragma warning(pop)
-        #endif
 
-        #define VMAWARE_STR2(x) #x
-        #define VMAWARE_STR(x) VMAWARE_STR2(x)
-        [[nodiscard]] static u32 get_ct_seed() {
-            constexpr char s[] = __DATE__ " " __TIME__ " " __FILE__ " " VMAWARE_STR(__LINE__);
-            u32 h = 2166136261u;
-            for (char c : s) {
-                if (!c) break;
-                h ^= static_cast<unsigned char>(c);
-                h *= 16777619u;
+        // opt-in with VM::PERSIST, keeps the technique results in a file until the next reboot so other 
+        // processes don't have to run them again. Volatile techniques are never stored, see core::is_volatile()
+        struct persist {
+            static constexpr u32 MAGIC = 0x43414D56; // "VMAC"
+            static constexpr u32 FORMAT = 1;
+
+            static std::atomic<u8> state; // the file is only loaded once per process
+            static std::atomic<u32> saved_generation;
+
+            // everything that has to match for a file to be trusted
+            struct key_t {
+                u32 magic;
+                u32 format;
+                u32 layout;
+                u32 cpu_signature[4];
+                char boot_id[40];
+            };
+
+        #if (LINUX)
+            static std::string path() {
+                const char* runtime_dir = std::getenv("XDG_RUNTIME_DIR");
+
+                if ((runtime_dir != nullptr) && (runtime_dir[0] == '/')) {
+                    return std::string(runtime_dir) + "/vmaware.cache";
+                }
+
+                return "/tmp/vmaware-" + std::to_string(geteuid()) + ".cache";
             }
-            return h;
-        }
 
-        /*
-            Golden Rules (must happen ALWAYS; if they don't happen the check should be aborted):
-            1. The check needs AT LEAST two different cores, so if one single core is detected, returns
-            2. The counter thread should always be in the middle available logical CPU when there's more than 2 cores, and in the core 2 (1-indexed) when there's 2 cores
+            // the version of the technique table, so a file written by an older build is ignored
+            static u32 layout() noexcept {
+                u32 hash = 2166136261u; // FNV-1a
 
-            Silver Rules (in order of priority):
-            1. The trigger and the counter thread must not be in the same physical core (avoid SMT siblings) WHENEVER POSSIBLE
-            2. The trigger and the counter thread should be within the same NUMA node or AMD CCD to minimize baseline latency WHENEVER POSSIBLE
-            3. The counter and trigger thread should not be in the first or last logical CPU WHENEVER POSSIBLE
-            4. If after reaching here, there are multiple valid candidates (core indexes), then randomize it to avoid hypervisors from predicting where the trigger thread is
+                auto mix = [&hash](const u32 value) noexcept {
+                    hash ^= value;
+                    hash *= 16777619u;
+                };
 
-            Example: Imagine we have a CPU with 2 cores and 4 threads (with SMT enabled), then:
-            1. We process golden rules first:
-            - CPU has more than 1 core -> OK
-            - Counter thread is pinned to core 2
+                mix(enum_size);
+                mix(static_cast<u32>(MAX_BRANDS));
 
-            2. We process the silver rules, in order:
-            - Counter and trigger thread must not be in the same physical core -> Trigger thread is pinned to core 4
-            - Trigger and the counter thread should be within the same NUMA node -> FAILED
-            - Counter and trigger thread should not be in the first or last logical CPU -> FAILED, trigger thread had to be put in core 4 due to a silver rule with more priority
-        */
-        [[nodiscard]] static DWORD_PTR getmask(u32 ct_seed, bool trigger) {
-            const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
+                for (u8 i = technique_begin; i < technique_end; ++i) {
+                    const core::technique& entry = core::technique_table.at(i);
+                    mix(entry.points);
+                    mix(static_cast<u32>(entry.cost_class));
+                    mix(entry.run ? 1u : 0u);
+                }
 
-            DWORD_PTR proc_mask = 0, sys_mask = 0;
-            if (!GetProcessAffinityMask(current_process, &proc_mask, &sys_mask) || !proc_mask) {
-                return 0ull;
+                return hash;
             }
 
-            DWORD idxs[64]{};
-            DWORD n = 0;
-            for (DWORD i = 0; i < 64; ++i) {
-                if (proc_mask & (1ull << i)) {
-                    idxs[n++] = i;
+            static bool make_key(key_t& key) {
+                key = {};
+                key.magic = MAGIC;
+                key.format = FORMAT;
+                key.layout = layout();
+
+                // vendor string and family/model/stepping
+                u32 unused = 0;
+                cpu::cpuid(unused, key.cpu_signature[0], key.cpu_signature[1], key.cpu_signature[2], 0);
+                cpu::cpuid(key.cpu_signature[3], unused, unused, unused, 1);
+
+                const int fd = open("/proc/sys/kernel/random/boot_id", O_RDONLY | O_CLOEXEC);
+
+                if (fd < 0) {
+                    return false;
                 }
-            }
 
-            if (n < 2) {
-                return 0ull;
-            }
+                const ssize_t n = read(fd, key.boot_id, sizeof(key.boot_id) - 1);
+                close(fd);
 
-            // first null buffer then use size
-            DWORD len = 0;
-            SetLastError(ERROR_SUCCESS);
-            GetLogicalProcessorInformationEx(RelationAll, nullptr, &len);
-            if (GetLastError() != ERROR_INSUFFICIENT_BUFFER || !len) {
-                return 0ull;
+                return (n >= 36);
             }
 
-            std::vector<BYTE> topo(len);
-            if (!GetLogicalProcessorInformationEx(
-                RelationAll,
-                reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(topo.data()),
-                &len)) {
-                return 0ull;
+            static void load() {
+                if (!claim(state)) {
+                    return;
+                }
+
+                read_entries();
+
+                // nothing new to write back until a technique actually runs
+                saved_generation.store(cache_generation.load(std::memory_order_acquire));
+                publish(state);
             }
 
-            constexpr DWORD INVALID_CPU = 0xFFFFFFFFu;
+            static void read_entries() {
+                key_t key{};
 
-            DWORD logical_to_core[64];
-            DWORD logical_to_numa[64];
-            std::fill_n(logical_to_core, 64, INVALID_CPU);
-            std::fill_n(logical_to_numa, 64, INVALID_CPU);
+                if (!make_key(key)) {
+                    return;
+                }
 
-            DWORD core_count = 0;
+                const std::string file_path = path();
+                const int fd = open(file_path.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
 
-            size_t offset = 0;
-            while (offset + sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX) <= len) {
-                auto* ptr = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(topo.data() + offset);
+                if (fd < 0) {
+                    return;
+                }
 
-                switch (ptr->Relationship) {
-                case RelationProcessorCore: {
-                    const DWORD core_id = core_count++;
+                // the results are taken as they are, so whoever can write to the file decides the verdict. It's
+                // only trusted if it looks exactly like save() left it: a single link to a regular file of this 
+                // user that nobody else has any access to (0600)
+                struct stat info{};
+                std::vector<u8> buffer;
+
+                if (
+                    (fstat(fd, &info) == 0) &&
+                    S_ISREG(info.st_mode) &&
+                    (info.st_uid == geteuid()) &&
+                    ((info.st_mode & (S_IRWXG | S_IRWXO)) == 0) &&
+                    (info.st_nlink == 1) &&
+                    (info.st_size > 0) &&
+                    (info.st_size < 65536)
+                ) {
+                    buffer.resize(static_cast<size_t>(info.st_size));
 
-                    for (DWORD g = 0; g < ptr->Processor.GroupCount; ++g) {
-                        const KAFFINITY mask = ptr->Processor.GroupMask[g].Mask;
-                        for (DWORD bit = 0; bit < 64; ++bit) {
-                            if (mask & (1ull << bit)) {
-                                logical_to_core[bit] = core_id;
-                            }
-                        }
+                    if (read(fd, buffer.data(), buffer.size()) != static_cast<ssize_t>(buffer.size())) {
+                        buffer.clear();
                     }
-                    break;
                 }
 
-                case RelationNumaNode: {
-                    const DWORD node_id = ptr->NumaNode.NodeNumber;
-                    const KAFFINITY mask = ptr->NumaNode.GroupMask.Mask;
-                    for (DWORD bit = 0; bit < 64; ++bit) {
-                        if (mask & (1ull << bit)) {
-                            logical_to_numa[bit] = node_id;
-                        }
-                    }
-                    break;
-                }
+                close(fd);
 
-                default:
-                    break;
+                if ((buffer.size() < sizeof(key_t)) || (std::memcmp(buffer.data(), &key, sizeof(key_t)) != 0)) {
+                    debug("PERSIST: no usable cache at ", file_path);
+                    return;
                 }
 
-                if (!ptr->Size) {
-                    return 0ull;
-                }
-                offset += ptr->Size;
-            }
+                size_t offset = sizeof(key_t);
 
-            // abort if only one physical core exists in the allowed affinity set
-            {
-                bool seen_core[64]{};
-                DWORD physical_cores = 0;
+                // entry: technique id, packed cache word, journal length, then the journal itself
+                while (offset + 6 <= buffer.size()) {
+                    const u8 id = buffer.at(offset);
+                    u32 word = 0;
+                    std::memcpy(&word, buffer.data() + offset + 1, sizeof(word));
+                    const u8 journal_size = buffer.at(offset + 5);
+                    offset += 6;
 
-                for (DWORD i = 0; i < n; ++i) {
-                    const DWORD log = idxs[i];
-                    const DWORD core = logical_to_core[log];
-                    if (core == INVALID_CPU) {
-                        return 0ull;
+                    if (offset + (journal_size * 2u) > buffer.size()) {
+                        return;
                     }
-                    if (!seen_core[core]) {
-                        seen_core[core] = true;
-                        ++physical_cores;
+
+                    std::vector<brand_contribution> journal;
+                    bool valid = (
+                        (id < technique_end) && 
+                        (state_of(word) == SLOT_READY) && 
+                        ((word >> 16) < MAX_BRANDS) &&
+                        !core::is_volatile(static_cast<enum_flags>(id))
+                    );
+
+                    for (u8 i = 0; i < journal_size; ++i) {
+                        const u8 brand = buffer.at(offset + (i * 2u));
+                        const u8 extra_brand = buffer.at(offset + (i * 2u) + 1);
+
+                        valid = valid && (brand < MAX_BRANDS) && (extra_brand < MAX_BRANDS);
+                        journal.push_back({ static_cast<brand_enum>(brand), static_cast<brand_enum>(extra_brand) });
                     }
-                }
 
-                if (physical_cores < 2) {
-                    return 0ull;
+                    offset += (journal_size * 2u);
+
+                    if (!valid || !claim_technique(id)) {
+                        continue;
+                    }
+
+                    cache_store(
+                        id, 
+                        ((word >> 2) & 1u) != 0, 
+                        static_cast<u8>(word >> 8), 
+                        static_cast<brand_enum>(static_cast<u8>(word >> 16)), 
+                        std::move(journal)
+                    );
                 }
-            }
 
-            // counter: middle available logical CPU when >2, otherwise second available logical CPU
-            const DWORD counter_pos0 = (n == 2) ? 1u : (n / 2u);
-            if (counter_pos0 >= n) {
-                return 0ull;
+                debug("PERSIST: loaded cached results from ", file_path);
             }
 
-            const DWORD counter_logical = idxs[counter_pos0];
-            const DWORD counter_core = logical_to_core[counter_logical];
-            const DWORD counter_numa = logical_to_numa[counter_logical];
+            // writes every cached result that isn't volatile, but only if something changed since the last time
+            static void save() {
+                const u32 generation = cache_generation.load(std::memory_order_acquire);
 
-            if (counter_core == INVALID_CPU || counter_numa == INVALID_CPU) {
-                return 0ull;
-            }
+                if (saved_generation.exchange(generation) == generation) {
+                    return;
+                }
 
-            if (!trigger) {
-                return 1ull << counter_logical;
-            }
+                key_t key{};
 
-            auto is_edge = [&](DWORD logical) -> bool {
-                return logical == idxs[0] || logical == idxs[n - 1];
-            };
+                if (!make_key(key)) {
+                    return;
+                }
 
-            auto same_numa = [&](DWORD logical) -> bool {
-                return logical_to_numa[logical] != INVALID_CPU && logical_to_numa[logical] == counter_numa;
-            };
+                std::vector<u8> buffer(sizeof(key_t));
+                std::memcpy(buffer.data(), &key, sizeof(key_t));
 
-            auto build_candidates = [&](bool require_same_numa, bool avoid_edges) {
-                std::vector<DWORD> out;
-                out.reserve(n);
+                for (u8 id = technique_begin; id < technique_end; ++id) {
+                    const u32 word = cache_table.at(id).word.load(std::memory_order_acquire);
 
-                for (DWORD i = 0; i < n; ++i) {
-                    const DWORD logical = idxs[i];
-                    if (logical == counter_logical) {
+                    if ((state_of(word) != SLOT_READY) || core::is_volatile(static_cast<enum_flags>(id))) {
                         continue;
                     }
 
-                    // never same physical core when possible
-                    if (logical_to_core[logical] == counter_core) {
-                        continue;
-                    }
+                    const std::vector<brand_contribution>& journal = cache_table.at(id).journal;
+                    const u8 journal_size = static_cast<u8>(std::min<size_t>(journal.size(), 255));
 
-                    if (avoid_edges && is_edge(logical)) {
-                        continue;
-                    }
+                    buffer.push_back(id);
+                    buffer.insert(buffer.end(), reinterpret_cast<const u8*>(&word), reinterpret_cast<const u8*>(&word) + sizeof(word));
+                    buffer.push_back(journal_size);
 
-                    if (require_same_numa && !same_numa(logical)) {
-                        continue;
+                    for (u8 i = 0; i < journal_size; ++i) {
+                        buffer.push_back(static_cast<u8>(journal.at(i).brand));
+                        buffer.push_back(static_cast<u8>(journal.at(i).extra_brand));
                     }
+                }
 
-                    out.push_back(logical);
+                // written next to the real one and renamed over it, so readers never see half a file
+                const std::string file_path = path();
+                const std::string tmp_path = file_path + "." + std::to_string(getpid()) + ".tmp";
+                const int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+
+                if (fd < 0) {
+                    return;
                 }
 
-                return out;
-            };
+                const bool written = (write(fd, buffer.data(), buffer.size()) == static_cast<ssize_t>(buffer.size()));
+                close(fd);
 
-            // priority order
-            // 1) different physical core + same NUMA + not first/last
-            // 2) different physical core + same NUMA
-            // 3) different physical core + not first/last
-            // 4) different physical core
-            std::vector<DWORD> candidates = build_candidates(true, true);
-            if (candidates.empty()) candidates = build_candidates(true, false);
-            if (candidates.empty()) candidates = build_candidates(false, true);
-            if (candidates.empty()) candidates = build_candidates(false, false);
+                if (!written || (rename(tmp_path.c_str(), file_path.c_str()) != 0)) {
+                    unlink(tmp_path.c_str());
+                    return;
+                }
 
-            if (candidates.empty()) {
-                return 0ull;
+                debug("PERSIST: saved cached results to ", file_path);
             }
+        #else
+            static void load() {}
+            static void save() {}
+        #endif
+        };
 
-            u64 seed = 0;
-            seed ^= static_cast<u64>(ct_seed);
-            seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&proc_mask));
-            seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&sys_mask)) << 1;
-            seed ^= static_cast<u64>(counter_logical) << 2;
-            seed ^= static_cast<u64>(counter_core) << 3;
-            seed ^= seed >> 33;
-            seed *= 0xff51afd7ed558ccdULL;
-            seed ^= seed >> 33;
-            seed *= 0xc4ceb9fe1a85ec53ULL;
-            seed ^= seed >> 33;
+        // opt-in with VM::SHARED, a small shared memory segment under /dev/shm where one process publishes 
+        // the technique results for every other process of the same user. Readers never block the writer 
+        // or each other, they just retry when the sequence number changed while they were copying
+        struct shared {
+            static constexpr u8 MAX_JOURNAL = 8;
 
-            std::seed_seq seq{
-                static_cast<u32>(seed),
-                static_cast<u32>(seed >> 32),
-                static_cast<u32>(seed ^ 0x9e3779b9u),
-                ct_seed
+            struct slot_t {
+                u32 word;
+                u8 journal_size;
+                u8 journal[MAX_JOURNAL * 2];
             };
 
-            std::mt19937 gen(seq);
-            const DWORD logical = candidates[std::uniform_int_distribution<size_t>(0, candidates.size() - 1)(gen)];
-            return 1ull << logical;
-        }
-
-        // we dont use cpu::cpuid on purpose
-        static VMAWARE_FORCE_INLINE void vmexit() {
-        #if (GCC || CLANG)
-            u32 a = 0, c = 0, d = 0;
-            #if (x86_64)
-            __asm__ volatile (
-                "pushq %%rbx\n\t" // better than doing something like xchgq %%rbx, %%rdi\n\t to swap rbx to rdi avoiding GCC pushing/popping rbx on the stack
-                "cpuid\n\t"
-                "popq %%rbx\n\t"
-                : "+a"(a), "+c"(c), "=d"(d) // + mapping forces compiler to use registers, avoids stack spills
-                :
-                : "cc"
-                );
-            #else
-            __asm__ volatile (
-                "pushl %%ebx\n\t"
-                "cpuid\n\t"
-                "popl %%ebx\n\t"
-                : "+a"(a), "+c"(c), "=d"(d)
-                :
-                : "cc"
-                );
-            #endif
-        #else
-            i32 dummy[4];
-            __cpuidex(dummy, 0x0, 0); // leaf 0 because it's the most stable one for making ratio checks, even if at first glance it may be abusable because it's the fastest one
-        #endif
-        }
+            struct payload_t {
+                persist::key_t key;
+                slot_t slots[technique_end];
+            };
 
-        [[nodiscard]] static timer_tick_t calculate_latency(const std::vector<timer_tick_t>& samples_in) {
-            if (samples_in.empty()) return 0;
-            const size_t N = samples_in.size();
-            if (N == 1) return samples_in[0];
+            struct segment_t {
+                std::atomic<u32> sequence; // odd while a process is writing
+                std::atomic<u64> lock;     // 0 if free, otherwise when the writer took it in steady_clock milliseconds
+                payload_t payload;
+            };
 
-            // create a local copy to sort
-            std::vector<timer_tick_t> s = samples_in;
-            std::sort(s.begin(), s.end());
+            // writing the payload takes microseconds, so a lock held for this long belongs to a writer that died halfway
+            static constexpr u64 LOCK_EXPIRY = 1000;
 
-            // discard the lower 25% and upper 25%, leaving the middle 50%
-            const size_t low_idx = N / 4;
-            const size_t high_idx = (3 * N) / 4;
+            static std::atomic<u8> state; // the segment is only attached and read once per process
+            static std::atomic<u32> published_generation;
+            static segment_t* segment;
 
-            double sum = 0;
-            size_t count = 0;
-            for (size_t i = low_idx; i < high_idx; ++i) {
-                sum += s[i];
-                count++;
+        #if (LINUX)
+            static std::string path() {
+                return "/dev/shm/vmaware-" + std::to_string(geteuid());
             }
 
-            // fallback to the median if the dataset is too small
-            if (count == 0) return s[N / 2];
-
-            // compute the average of the middle 50% and round to the nearest integer
-            return static_cast<timer_tick_t>((sum / count) + 0.5);
-        }
+            static segment_t* attach() {
+                const std::string segment_path = path();
+                const int fd = open(segment_path.c_str(), O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0600);
 
-        static VMAWARE_FORCE_INLINE void burn_random_cycles(u32 ct_seed, timer_tick_t v_post, timer_tick_t r_post) {
-            // the internal pseudo-random number generator (PRNG) variables like u64 seed and volatile u64 x can be kept as u64 
-            // because they are simple register-only PRNG arithmetic and benefit from the extra 64-bit entropy space even on 32-bit platforms
-            u64 seed = ct_seed;
-            seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&seed));
-            seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&v_post)) << 1;
-            seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&r_post)) << 2;
-            seed ^= seed >> 33;
-            seed *= 0xff51afd7ed558ccdULL;
-            seed ^= seed >> 33;
-            seed *= 0xc4ceb9fe1a85ec53ULL;
-            seed ^= seed >> 33;
+                if (fd < 0) {
+                    return nullptr;
+                }
 
-            // 64u is the minimum amount of work every time, 0x1FFu controls how much the count varies
-            const u32 rounds = 64u + static_cast<u32>(seed & 0x7FFu); // variable per iteration
-            volatile u64 x = seed | 1ULL;
+                struct stat info{};
+                void* address = MAP_FAILED;
+
+                // same rules as memo::persist, and a segment of a different size is from another build
+                if (
+                    (fstat(fd, &info) == 0) &&
+                    S_ISREG(info.st_mode) &&
+                    (info.st_uid == geteuid()) &&
+                    ((info.st_mode & (S_IWGRP | S_IWOTH)) == 0) &&
+                    ((info.st_size == 0) || (info.st_size == static_cast<off_t>(sizeof(segment_t)))) &&
+                    (ftruncate(fd, static_cast<off_t>(sizeof(segment_t))) == 0)
+                ) {
+                    address = mmap(nullptr, sizeof(segment_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                }
 
-            for (u32 i = 0; i < rounds; ++i) {
-                x = x * 6364136223846793005ULL + 1ULL;
-                x ^= x >> 17;
-            }
+                close(fd);
 
-            std::atomic_signal_fence(std::memory_order_acq_rel);
-        }
-    };
-#endif
+                if (address == MAP_FAILED) {
+                    debug("SHARED: couldn't attach to ", segment_path);
+                    return nullptr;
+                }
 
-    // miscellaneous functionalities
-    struct util {
-        static bool is_unsupported(const VM::enum_flags flag) {
-            // cross platform?
-            if (
-                (flag >= VM::HYPERVISOR_BIT) &&
-                (flag <= VM::KGT_SIGNATURE)
-            ) {
-                return false;
+                return static_cast<segment_t*>(address);
             }
 
-            #if (LINUX)
-                return (!(
-                    (flag >= LINUX_START) &&
-                    (flag <= LINUX_END)
-                ));
-            #elif (WINDOWS)
-                return (!(
-                    (flag >= WINDOWS_START) &&
-                    (flag <= WINDOWS_END)
-                ));
-            #elif (APPLE) 
-                return (!(
-                    (flag >= MACOS_START) &&
-                    (flag <= MACOS_END)
-                ));
-            #else
-                return false;
-            #endif
-        }
+            // a consistent copy of the payload, or false if a writer kept getting in the way
+            static bool read_payload(payload_t& copy) {
+                for (u8 attempt = 0; attempt < 64; ++attempt) {
+                    const u32 before = segment->sequence.load(std::memory_order_acquire);
 
-    #if (LINUX)
-        // fetch file data
-        [[nodiscard]] static std::string read_file(const char* raw_path) {
-            std::string path;
-            const std::string raw_path_str = raw_path;
+                    if ((before & 1u) == 0) {
+                        std::memcpy(&copy, &segment->payload, sizeof(payload_t));
+                        std::atomic_thread_fence(std::memory_order_acquire);
 
-            // replace the "~" part with the home directory
-            if (raw_path[0] == '~') {
-                const char* home = std::getenv("HOME");
-                if (home) {
-                    path = std::string(home) + raw_path_str.substr(1);
+                        if (segment->sequence.load(std::memory_order_relaxed) == before) {
+                            return (before != 0);
+                        }
+                    }
+
+                    std::this_thread::yield();
                 }
-            } else {
-                path = raw_path;
-            }
 
-            if (!exists(path.c_str())) {
-                return "";
+                return false;
             }
 
-            std::ifstream file{};
-            std::string data{};
-            std::string line{};
+            static void load() {
+                if (!claim(state)) {
+                    return;
+                }
 
-            file.open(path);
+                segment = attach();
 
-            if (file.is_open()) {
-                while (std::getline(file, line)) {
-                    data += line + "\n";
+                if (segment != nullptr) {
+                    read_entries();
                 }
+
+                published_generation.store(cache_generation.load(std::memory_order_acquire));
+                publish(state);
             }
 
-            file.close();
-            return data;
-        }
-
-        [[nodiscard]] static bool exists(const char* path) {
-        #if (VMA_CPP >= 17)
-            return std::filesystem::exists(path);
-        #elif (VMA_CPP >= 11)
-            struct stat buffer;
-            return (stat(path, &buffer) == 0);
-        #endif
-        }
-
-        static bool is_directory(const char* path) {
-            struct stat info{};
-            if (stat(path, &info) != 0) {
-                return false;
-            }
-            return (info.st_mode & S_IFDIR); // check if directory
-        };
-    #endif
-
-        // fetch the file but in binary form
-        [[nodiscard]] static std::vector<u8> read_file_binary(const char* file_path) {
-            std::ifstream file(file_path, std::ios::binary);
+            static void read_entries() {
+                persist::key_t key{};
+                std::unique_ptr<payload_t> copy(new payload_t());
 
-            if (!file) {
-                return {};
-            }
-
-            std::vector<u8> buffer;
-            std::istreambuf_iterator<char> it(file);
-            const std::istreambuf_iterator<char> end;
+                if (!persist::make_key(key) || !read_payload(*copy)) {
+                    return;
+                }
 
-            while (it != end) {
-                buffer.push_back(static_cast<u8>(*it));
-                ++it;
-            }
+                // stale or from another build, so this process falls back to running the techniques
+                if (std::memcmp(&copy->key, &key, sizeof(key)) != 0) {
+                    debug("SHARED: segment doesn't match this boot or build");
+                    return;
+                }
 
-            file.close();
+                for (u8 id = technique_begin; id < technique_end; ++id) {
+                    const slot_t& slot = copy->slots[id];
 
-            return buffer;
-        }
+                    if (
+                        (state_of(slot.word) != SLOT_READY) ||
+                        ((slot.word >> 16) >= MAX_BRANDS) ||
+                        (slot.journal_size > MAX_JOURNAL) ||
+                        core::is_volatile(static_cast<enum_flags>(id))
+                    ) {
+                        continue;
+                    }
 
+                    std::vector<brand_contribution> journal;
+                    bool valid = true;
 
-        // wrapper for std::make_unique because it's not available for C++11
-        template<typename T, typename... Args>
-        [[nodiscard]] static std::unique_ptr<T> make_unique(Args&&... args) {
-        #if (VMA_CPP < 14)
-            return std::unique_ptr<T>(new T(std::forward<Args>(args)...));
-        #else
-            return std::make_unique<T>(std::forward<Args>(args)...);
-        #endif
-        }
+                    for (u8 i = 0; i < slot.journal_size; ++i) {
+                        const u8 brand = slot.journal[i * 2];
+                        const u8 extra_brand = slot.journal[(i * 2) + 1];
 
+                        valid = valid && (brand < MAX_BRANDS) && (extra_brand < MAX_BRANDS);
+                        journal.push_back({ static_cast<brand_enum>(brand), static_cast<brand_enum>(extra_brand) });
+                    }
 
-        [[nodiscard]] static bool is_admin() noexcept {
-        #if (LINUX || APPLE)
-            const uid_t uid = getuid();
-            const uid_t euid = geteuid();
+                    if (!valid || !claim_technique(id)) {
+                        continue;
+                    }
 
-            return (
-                (uid != euid) ||
-                (euid == 0)
-            );
-        #elif (WINDOWS)
-            bool is_admin = false;
-            HANDLE hToken = nullptr;
-            const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
-            if (OpenProcessToken(current_process, TOKEN_QUERY, &hToken)) {
-                TOKEN_ELEVATION elevation{};
-                DWORD dwSize;
-                if (GetTokenInformation(hToken, TokenElevation, &elevation, sizeof(elevation), &dwSize)) {
-                    if (elevation.TokenIsElevated)
-                        is_admin = true;
+                    cache_store(
+                        id, 
+                        ((slot.word >> 2) & 1u) != 0, 
+                        static_cast<u8>(slot.word >> 8), 
+                        static_cast<brand_enum>(static_cast<u8>(slot.word >> 16)), 
+                        std::move(journal)
+                    );
                 }
-                CloseHandle(hToken);
-            }
-            return is_admin;
-        #else
-            return true;
-        #endif
-        }
-
-
-        [[nodiscard]] static bool find(const std::string& base_str, const char* keyword) noexcept {
-            return (base_str.find(keyword) != std::string::npos);
-        };
-
-        [[nodiscard]] static i32 popcount(u64 v) {
-        #if (GCC) || (CLANG)
-            return __builtin_popcountll(v);
-        #elif (MSVC)
-        #if (x86_32)
-            return static_cast<int>(
-                __popcnt(static_cast<unsigned int>(v)) +
-                __popcnt(static_cast<unsigned int>(v >> 32))
-            );
-        #else
-            return static_cast<int>(__popcnt64(static_cast<unsigned long long>(v)));
-        #endif
-        #else
-            int c = 0;
-            while (v) { c += static_cast<int>(v & 1ull); v >>= 1; }
-            return c;
-        #endif
-        };
-
-        static std::string narrow_wide(const wchar_t* wstr) {
-            if (!wstr) {
-                return {};
-            }
 
-            const std::wstring ws(wstr);
-            std::string result;
-            result.reserve(ws.size());
-            for (const wchar_t wc : ws) {
-                result.push_back((static_cast<uint32_t>(wc) < 128)
-                    ? static_cast<char>(wc)
-                    : '?');
+                debug("SHARED: loaded cached results from the segment");
             }
-            return result;
-        }
-
-        // choose correct << or narrow for each type
-        static void write_arg_impl(std::ostream& os, const wchar_t* arg) {
-            os << narrow_wide(arg);
-        }
-        static void write_arg_impl(std::ostream& os, wchar_t* arg) {
-            os << narrow_wide(arg);
-        }
-
-        static void write_arg_impl(std::ostream& os, const std::wstring& ws) {
-            os << narrow_wide(ws.c_str());
-        }
-
-        // everything else that is not std::string or wchar_t
-        template <typename T>
-        static typename std::enable_if<!std::is_convertible<T, std::wstring>::value
-            && !std::is_same<typename std::decay<T>::type, wchar_t*>::value,
-            void>::type
-            write_arg_impl(std::ostream& os, T&& arg) {
-            os << std::forward<T>(arg);
-        }
 
-        // variadic pack printer for C++11
-        static void print_to_stream(std::ostream& /*unused*/) noexcept {}
+            // only one process writes at a time, the others just skip publishing since the result is the same anyway
+            static void save() {
+                const u32 generation = cache_generation.load(std::memory_order_acquire);
 
-        // forward the first, then expand the rest in an initializer list
-        template <typename T, typename... Args>
-        static void print_to_stream(std::ostream& os,
-            T&& first,
-            Args&&... args) noexcept
-        {
-            write_arg_impl(os, std::forward<T>(first));
-            // trick to expand the pack
-            using expander = int[];
-            (void)expander {
-                0, ((void)write_arg_impl(os, std::forward<Args>(args)), 0)...
-            };
-        }
+                if ((segment == nullptr) || (published_generation.exchange(generation) == generation)) {
+                    return;
+                }
 
-        template <typename... Args>
-        static void debug_msg(Args&&... message) noexcept {
-            static std::unordered_set<std::string> printed_messages;
+                std::unique_ptr<payload_t> payload(new payload_t());
 
-            std::stringstream ss;
-            print_to_stream(ss, std::forward<Args>(message)...);
-            std::string msg_content = ss.str();
+                if (!persist::make_key(payload->key)) {
+                    return;
+                }
 
-            if (printed_messages.find(msg_content) == printed_messages.end()) {
-            #if (LINUX || APPLE)
-                constexpr const char* black_bg = "\x1B[48;2;0;0;0m";
-                constexpr const char* bold = "\033[1m";
-                constexpr const char* blue = "\x1B[38;2;00;59;193m";
-                constexpr const char* ansiexit = "\x1B[0m";
+                for (u8 id = technique_begin; id < technique_end; ++id) {
+                    const u32 word = cache_table.at(id).word.load(std::memory_order_acquire);
+                    slot_t& slot = payload->slots[id];
 
-                std::cerr.setf(std::ios::fixed, std::ios::floatfield);
-                std::cerr.setf(std::ios::showpoint);
+                    if ((state_of(word) != SLOT_READY) || core::is_volatile(static_cast<enum_flags>(id))) {
+                        continue;
+                    }
 
-                std::cerr << black_bg
-                    << bold << "["
-                    << blue << "DEBUG"
-                    << ansiexit << bold << black_bg << "]"
-                    << ansiexit << " ";
-            #else
-                std::cerr << "[DEBUG] ";
-            #endif
-                std::cerr << msg_content;
-                std::cerr << std::dec << "\n";
+                    const std::vector<brand_contribution>& journal = cache_table.at(id).journal;
 
-                printed_messages.insert(std::move(msg_content));
-            }
-        }
+                    // doesn't fit, so other processes will just run this one themselves
+                    if (journal.size() > MAX_JOURNAL) {
+                        continue;
+                    }
 
+                    slot.word = word;
+                    slot.journal_size = static_cast<u8>(journal.size());
 
-        [[nodiscard]] static std::unique_ptr<std::string> sys_result(const char* cmd) {
-        #if (VMA_CPP < 14)
-            VMAWARE_UNUSED(cmd);
-            return util::make_unique<std::string>();
-        #else
-            #if (LINUX || APPLE)
-                struct file_deleter {
-                    void operator()(FILE* f) const noexcept {
-                        if (f) {
-                            pclose(f);
-                        };
+                    for (u8 i = 0; i < slot.journal_size; ++i) {
+                        slot.journal[i * 2] = static_cast<u8>(journal.at(i).brand);
+                        slot.journal[(i * 2) + 1] = static_cast<u8>(journal.at(i).extra_brand);
                     }
-                };
-
-                std::unique_ptr<FILE, file_deleter> const pipe(popen(cmd, "r"), file_deleter()); // NOLINT(bugprone-command-processor)
-                if (!pipe) {
-                    return util::make_unique<std::string>();
                 }
 
-                std::string result;
-                char buf[4096];
-                while (std::fgets(buf, sizeof(buf), pipe.get()) != nullptr) {
-                    result.append(buf);
-                }
+                // most processes only ran the volatile techniques on top of what they loaded, nothing to publish then
+                std::unique_ptr<payload_t> current(new payload_t());
 
-                if (!result.empty() && result.back() == '\n') {
-                    result.pop_back();
+                if (read_payload(*current) && (std::memcmp(current.get(), payload.get(), sizeof(payload_t)) == 0)) {
+                    return;
                 }
 
-                return util::make_unique<std::string>(std::move(result));
-            #else
-                VMAWARE_UNUSED(cmd);
-                return std::make_unique<std::string>();
-            #endif
-        #endif
-        }
+                // steady_clock is CLOCK_MONOTONIC on Linux, so every process on the boot agrees on it
+                const u64 now = std::max<u64>(1, static_cast<u64>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()
+                ).count()));
 
+                u64 taken_at = 0;
 
-        [[nodiscard]] static bool is_proc_running(const char* executable) {
-        #if (LINUX)
-            #if (VMA_CPP >= 17)
-                for (const auto& entry : std::filesystem::directory_iterator("/proc")) {
-                    if (!entry.is_directory()) {
-                        continue;
+                // a writer that died halfway would otherwise keep the segment locked until the next reboot,
+                // so an expired lock is taken over, with the same compare and swap as a free one
+                if (!segment->lock.compare_exchange_strong(taken_at, now, std::memory_order_acquire, std::memory_order_relaxed)) {
+                    if ((taken_at > now) || ((now - taken_at) < LOCK_EXPIRY)) {
+                        return;
                     }
 
-                    const std::string filename = entry.path().filename().string();
-            #else
-                std::unique_ptr<DIR, decltype(&closedir)> dir(opendir("/proc"), closedir);
-                if (!dir) {
-                    debug("util::is_proc_running: ", "failed to open /proc directory");
-                    return false;
-                }
-
-                struct dirent* entry;
-                while ((entry = readdir(dir.get())) != nullptr) {
-                    std::string filename(entry->d_name);
-                    if (filename == "." || filename == "..") {
-                        continue;
+                    if (!segment->lock.compare_exchange_strong(taken_at, now, std::memory_order_acquire, std::memory_order_relaxed)) {
+                        return;
                     }
-            #endif
-                if (!std::all_of(filename.begin(), filename.end(), [](u8 c) { return std::isdigit(c); })) {
-                    continue;
-                }
-
-                const std::string cmdline_file = "/proc/" + filename + "/cmdline";
 
-                // read raw bytes (binary) to preserve embedded NULs
-                std::ifstream ifs(cmdline_file, std::ios::in | std::ios::binary);
-                if (!ifs.is_open()) {
-                    continue;
+                    debug("SHARED: took over the lock of a writer that didn't finish");
                 }
 
-                // read entire file into vector<char>
-                std::vector<char> buf((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
-                ifs.close();
+                // odd while locked, and taking over from a dead writer keeps it odd
+                const u32 sequence = segment->sequence.load(std::memory_order_relaxed);
+                u32 locked = sequence + (((sequence & 1u) != 0) ? 2u : 1u);
 
-                if (buf.empty()) {
-                    continue;
-                }
+                segment->sequence.store(locked, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                std::memcpy(&segment->payload, payload.get(), sizeof(payload_t));
 
-                // cmdline is argv0\0argv1\0..., so argv0 is bytes up to first NUL
-                const auto it_nul = std::find(buf.begin(), buf.end(), '\0');
-                if (it_nul == buf.begin()) {
-                    continue;
+                // if this process stalled long enough for another one to take the lock over, the sequence 
+                // and the lock are that one's to release
+                if (segment->sequence.compare_exchange_strong(locked, locked + 1, std::memory_order_release, std::memory_order_relaxed)) {
+                    u64 owned = now;
+                    segment->lock.compare_exchange_strong(owned, 0, std::memory_order_release, std::memory_order_relaxed);
                 }
 
-                std::string const argv0(buf.begin(), it_nul);
-                if (argv0.empty()) {
-                    continue;
-                }
+                debug("SHARED: published cached results to the segment");
+            }
+        #else
+            static void load() {}
+            static void save() {}
+        #endif
+        };
 
-                // extract basename of argv0
-                const std::size_t slash_index = argv0.find_last_of('/');
-                std::string const basename = (slash_index == std::string::npos) ? argv0 : argv0.substr(slash_index + 1);
+        // forgets every detection result so the next call runs the techniques again. Hardware 
+        // information like the CPU brand or the cpuid leaves stays cached since it can't change.
+        // Detections running on other threads finish first, and new ones wait until this is done
+        static void reset() {
+            const refresh_guard guard;
 
-                if (basename != executable) {
-                    continue;
-                }
+            for (cache_entry& entry : cache_table) {
+                entry.word.store(EMPTY_WORD, std::memory_order_relaxed);
+                entry.journal.clear();
+            }
 
-                return true;
+            cache_generation.fetch_add(1, std::memory_order_release);
+            reset_verdicts();
+
+            {
+                const std::lock_guard<std::mutex> lock(core::scoreboard_mutex);
+                core::external_journal.clear();
             }
 
-            return false;
-        #else
-            VMAWARE_UNUSED(executable);
-            return false;
-        #endif
+            // the scoreboard is derived from the cached results
+            core::rebuild_scoreboard();
         }
 
+        // forgets everything that was derived from the technique results, but not the results themselves
+        static void reset_verdicts() {
+            single_brand::state.store(SLOT_EMPTY);
+            multi_brand::state.store(SLOT_EMPTY);
+            brand_list::state.store(SLOT_EMPTY);
+            conclusion::state.store(SLOT_EMPTY);
+            hardened::state.store(SLOT_EMPTY);
+        }
+    };
 
-        [[nodiscard]] static bool is_running_under_translator() {
-        #if (WINDOWS && _WIN32_WINNT >= _WIN32_WINNT_WIN10)
-            const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
-            USHORT procMachine = 0, nativeMachine = 0;
-            const auto pIsWow64Process2 = &IsWow64Process2;
+#if (WINDOWS)
+    // timer helper functionalities
+    struct timer {
+    #if (x86_64)
+        using timer_tick_t = u64;
+    #else
+        using timer_tick_t = u32;
+    #endif
 
-            if (pIsWow64Process2(current_process, &procMachine, &nativeMachine)) {
-                if (nativeMachine == IMAGE_FILE_MACHINE_ARM64 &&
-                    (procMachine == IMAGE_FILE_MACHINE_AMD64 || procMachine == IMAGE_FILE_MACHINE_I386)) {
-                    debug("Translator detected x64/x86 process on ARM64");
-                    return true;
-                }
+        #if (MSVC)
+            #pragma warning(push)
+            #pragma warning(disable: 4324) 
+        #endif
+        // align to prevent false sharing when triggering hypervisor exits with the intentional data race condition
+        struct alignas(64) cache_state {
+            alignas(64) volatile timer_tick_t counter { 0 };
+            alignas(64) std::atomic<bool> start_test { false };
+            alignas(64) std::atomic<bool> test_done  { false };
+        };
+        #if (MSVC)
+            #pragma warning(pop)
+        #endif
+
+        #define VMAWARE_STR2(x) #x
+        #define VMAWARE_STR(x) VMAWARE_STR2(x)
+        [[nodiscard]] static u32 get_ct_seed() {
+            constexpr char s[] = __DATE__ " " __TIME__ " " __FILE__ " " VMAWARE_STR(__LINE__);
+            u32 h = 2166136261u;
+            for (char c : s) {
+                if (!c) break;
+                h ^= static_cast<unsigned char>(c);
+                h *= 16777619u;
             }
+            return h;
+        }
 
-            // only if we got MACHINE_UNKNOWN on process but native is ARM64
-            if (nativeMachine == IMAGE_FILE_MACHINE_ARM64) {
-                using get_process_information = BOOL(__stdcall*)(HANDLE, PROCESS_INFORMATION_CLASS, PVOID, DWORD);
-                const HMODULE ntdll = util::get_ntdll();
-                if (ntdll == nullptr) {
-                    return false;
-                }
+        /*
+            Golden Rules (must happen ALWAYS; if they don't happen the check should be aborted):
+            1. The check needs AT LEAST two different cores, so if one single core is detected, returns
+            2. The counter thread should always be in the middle available logical CPU when there's more than 2 cores, and in the core 2 (1-indexed) when there's 2 cores
 
-                const char* names[] = { "GetProcessInformation" };
-                void* funcs[ARRAYSIZE(names)] = {};
-                util::get_function_address(ntdll, names, funcs, 1);
+            Silver Rules (in order of priority):
+            1. The trigger and the counter thread must not be in the same physical core (avoid SMT siblings) WHENEVER POSSIBLE
+            2. The trigger and the counter thread should be within the same NUMA node or AMD CCD to minimize baseline latency WHENEVER POSSIBLE
+            3. The counter and trigger thread should not be in the first or last logical CPU WHENEVER POSSIBLE
+            4. If after reaching here, there are multiple valid candidates (core indexes), then randomize it to avoid hypervisors from predicting where the trigger thread is
 
-                get_process_information get_proc_info = reinterpret_cast<get_process_information>(funcs[0]);
-                if (get_proc_info) {
-                    struct PROCESS_MACHINE_INFORMATION {
-                        USHORT ProcessMachine;
-                        USHORT Res0;
-                        DWORD  MachineAttributes;
-                    } pmInfo = {};
-                    // ProcessMachineTypeInfo == 9 per MS Q&A
-                    if (get_proc_info(current_process, (PROCESS_INFORMATION_CLASS)9, &pmInfo, sizeof(pmInfo))) {
-                        if (pmInfo.ProcessMachine == IMAGE_FILE_MACHINE_AMD64 || pmInfo.ProcessMachine == IMAGE_FILE_MACHINE_I386) {
-                            debug("Translator detected x64/x86 process on ARM64 by fallback");
-                            return true;
-                        }
-                    }
-                }
+            Example: Imagine we have a CPU with 2 cores and 4 threads (with SMT enabled), then:
+            1. We process golden rules first:
+            - CPU has more than 1 core -> OK
+            - Counter thread is pinned to core 2
+
+            2. We process the silver rules, in order:
+            - Counter and trigger thread must not be in the same physical core -> Trigger thread is pinned to core 4
+            - Trigger and the counter thread should be within the same NUMA node -> FAILED
+            - Counter and trigger thread should not be in the first or last logical CPU -> FAILED, trigger thread had to be put in core 4 due to a silver rule with more priority
+        */
+        [[nodiscard]] static DWORD_PTR getmask(u32 ct_seed, bool trigger) {
+            const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
+
+            DWORD_PTR proc_mask = 0, sys_mask = 0;
+            if (!GetProcessAffinityMask(current_process, &proc_mask, &sys_mask) || !proc_mask) {
+                return 0ull;
             }
-        #endif
 
-            if (cpu::is_leaf_supported(cpu::leaf::hypervisor)) {
-                const std::string vendor = cpu::cpu_manufacturer(cpu::leaf::hypervisor);
-                
-                if (vendor == "VirtualApple" ||   // Apple Rosetta
-                    vendor == "PowerVM Lx86")     // IBM PowerVM Lx86
-                {
-                    return true;
+            DWORD idxs[64]{};
+            DWORD n = 0;
+            for (DWORD i = 0; i < 64; ++i) {
+                if (proc_mask & (1ull << i)) {
+                    idxs[n++] = i;
                 }
             }
 
-        #if (WINDOWS)
-            const std::string& brand = cpu::get_brand();
-            if (brand.find("Virtual CPU") != std::string::npos) {
-                return true;
+            if (n < 2) {
+                return 0ull;
             }
-        #endif
-
-            return false;
-        }
 
-
-        /**
-         * @brief Check whether the system is running in a Hyper-V virtual machine or if the host system has Hyper-V enabled
-         * @note Hyper-V's presence on a host system can set certain hypervisor-related CPU flags that may appear similar to those in a virtualized environment, which can make it challenging to differentiate between an actual Hyper-V virtual machine (VM) and a host system with Hyper-V enabled.
-         *       This can lead to false conclusions, where the system might mistakenly be identified as running in a Hyper-V VM, when in reality, it's simply the host system with Hyper-V features active.
-         *       This check aims to distinguish between these two cases by identifying specific CPU flags and hypervisor-related artifacts that are indicative of a Hyper-V VM rather than a host system with Hyper-V enabled.
-         * @returns hyperx_state enum indicating the detected state:
-         *          - HYPERV_ARTIFACT_VM for host with Hyper-V enabled
-         *          - HYPERV_REAL_VM for real Hyper-V VM
-         *          - HYPERV_ENLIGHTENMENT for QEMU with Hyper-V enlightenments
-         *          - HYPERV_UNKNOWN for unknown/undetected state
-         */
-        [[nodiscard]] static hyperx_state hyper_x() {
-        #if (!WINDOWS)
-            return HYPERV_UNKNOWN;
-        #else
-            if (memo::hyperx::is_cached()) {
-                debug("HYPER_X: returned from cache");
-                return memo::hyperx::fetch();
+            // first null buffer then use size
+            DWORD len = 0;
+            SetLastError(ERROR_SUCCESS);
+            GetLogicalProcessorInformationEx(RelationAll, nullptr, &len);
+            if (GetLastError() != ERROR_INSUFFICIENT_BUFFER || !len) {
+                return 0ull;
             }
 
-            // Check if hypervisor feature bit in CPUID Leaf 1, ECX bit 31 is enabled
-            auto is_hyperv_present = []() noexcept -> bool {
-                u32 unused, ecx = 0;
-                cpu::cpuid(unused, unused, ecx, unused, 1);
-
-                return (ecx >> 31) & 1;
-            };
+            std::vector<BYTE> topo(len);
+            if (!GetLogicalProcessorInformationEx(
+                RelationAll,
+                reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(topo.data()),
+                &len)) {
+                return 0ull;
+            }
 
-            // 0x40000003 on EBX indicates the flags that a parent partition specified to create a child partition (https://learn.microsoft.com/en-us/virtualization/hyper-v-on-windows/tlfs/datatypes/hv_partition_privilege_mask)
-            // some CPU models like N-models (N4200, etc) expose 0x40000003 leaves without exposing the hypervisor bit
-            auto is_root_partition = []() noexcept -> bool {
-                u32 ebx, unused = 0;
-                cpu::cpuid(unused, ebx, unused, unused, 0x40000003);
+            constexpr DWORD INVALID_CPU = 0xFFFFFFFFu;
 
-                return (ebx & 1);
-            };
+            DWORD logical_to_core[64];
+            DWORD logical_to_numa[64];
+            std::fill_n(logical_to_core, 64, INVALID_CPU);
+            std::fill_n(logical_to_numa, 64, INVALID_CPU);
 
-            /**
-              * On Hyper-V virtual machines, the cpuid function reports an EAX value of 11
-              * This value is tied to the Hyper-V partition model, where each virtual machine runs as a child partition
-              * These child partitions have limited privileges and access to hypervisor resources, 
-              * which is reflected in the maximum input value for hypervisor CPUID information as 11
-              * Essentially, it indicates that the hypervisor is managing the VM and that the VM is not running directly on hardware but rather in a virtualized environment
-            */
-            auto eax = []() noexcept -> u32 {
-                u32 eax_reg, unused = 0;
-                cpu::cpuid(eax_reg, unused, unused, unused, cpu::leaf::hypervisor);
+            DWORD core_count = 0;
 
-                // truncation is intentional
-                return eax_reg & 0xFF;
-            };
+            size_t offset = 0;
+            while (offset + sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX) <= len) {
+                auto* ptr = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(topo.data() + offset);
 
-            hyperx_state state = HYPERV_UNKNOWN;
+                switch (ptr->Relationship) {
+                case RelationProcessorCore: {
+                    const DWORD core_id = core_count++;
 
-            if (!is_root_partition()) {
-                if (eax() == 11 && is_hyperv_present()) {
-                    // Windows machine running under Hyper-V type 2
-                    debug("HYPER-X: Detected Hyper-V guest VM");
-                    core::add(brand_enum::HYPERV);
-                    state = HYPERV_REAL_VM;
+                    for (DWORD g = 0; g < ptr->Processor.GroupCount; ++g) {
+                        const KAFFINITY mask = ptr->Processor.GroupMask[g].Mask;
+                        for (DWORD bit = 0; bit < 64; ++bit) {
+                            if (mask & (1ull << bit)) {
+                                logical_to_core[bit] = core_id;
+                            }
+                        }
+                    }
+                    break;
                 }
-                else {
-                    debug("HYPER-X: Hyper-V is not active");
-                    state = HYPERV_UNKNOWN;
+
+                case RelationNumaNode: {
+                    const DWORD node_id = ptr->NumaNode.NodeNumber;
+                    const KAFFINITY mask = ptr->NumaNode.GroupMask.Mask;
+                    for (DWORD bit = 0; bit < 64; ++bit) {
+                        if (mask & (1ull << bit)) {
+                            logical_to_numa[bit] = node_id;
+                        }
+                    }
+                    break;
                 }
-            }
-            else {
-                // Windows machine running under Hyper-V type 1
-                std::string brand_str = cpu::cpu_manufacturer(cpu::leaf::hypervisor + 0x100);
 
-                if (util::find(brand_str, "KVM")) {
-                    debug("HYPER-X: Detected Hyper-V enlightenments");
-                    core::add(brand_enum::QEMU_KVM_HYPERV);
-                    state = HYPERV_ENLIGHTENMENT;
+                default:
+                    break;
                 }
-                else {
-                    // If we reach here, we do some sanity checks to ensure a hypervisor is not trying to spoof itself as Hyper-V, attempting to bypass some detections
-                    brand_str = cpu::cpu_manufacturer(cpu::leaf::hypervisor);
 
-                    bool is_hyper_v_host = false;
+                if (!ptr->Size) {
+                    return 0ull;
+                }
+                offset += ptr->Size;
+            }
 
-                #if (x86_64)
-                    u8 idtr_buffer[10] = { 0 };
+            // abort if only one physical core exists in the allowed affinity set
+            {
+                bool seen_core[64]{};
+                DWORD physical_cores = 0;
 
-                    // we know we're not using SEH here, it's on purpose, and doesn't matter in what CPU core this runs on
-                    #if (CLANG || GCC)
-                        __asm__ volatile("sidt %0" : "=m"(idtr_buffer));
-                    #elif (MSVC)
-                        #pragma pack(push, 1)
-                        struct {
-                            USHORT Limit;
-                            ULONG_PTR Base;
-                        } idtr = { 0 };
-                        #pragma pack(pop)       
-                        __sidt(&idtr);
-
-                        volatile u8* idtr_ptr = (volatile u8*)&idtr;
-                        for (size_t j = 0; j < sizeof(idtr); ++j) {
-                            idtr_buffer[j] = idtr_ptr[j];
-                        }
-                    #endif
-
-                    ULONG_PTR idt_base = 0;
-                    memcpy(&idt_base, &idtr_buffer[2], sizeof(idt_base));
-
-                    // if running under Hyper-V in AMD64 (doesnt matter the VTL/partition level), this value is hardcoded and intercepted/emulated at kernel level
-                    // specifically at KiPreprocessFault -> KiOpDecode -> KiOpLocateDecodeEntry (KiOp_SLDTSTRSMSW)
-                    // this is intercepted by the kernel before handling execution to the hypervisor, so it's a decent safeguard against basic cpuid spoofing
-                    // additionally, brand has to be "Microsoft Hv"
-                    is_hyper_v_host = idt_base == 0xfffff80000001000 && brand_str == "Microsoft Hv";
-                #else
-                    is_hyper_v_host = brand_str == "Microsoft Hv";
-                #endif
-
-                    if (is_hyper_v_host) {
-                        debug("HYPER-X: Detected Hyper-V host machine");
-                        core::add(brand_enum::HYPERV_ROOT);
-                        state = HYPERV_ARTIFACT_VM;
+                for (DWORD i = 0; i < n; ++i) {
+                    const DWORD log = idxs[i];
+                    const DWORD core = logical_to_core[log];
+                    if (core == INVALID_CPU) {
+                        return 0ull;
                     }
-                    else {
-                        debug("HYPER-X: Detected hypervisor trying to spoof itself as Hyper-V");
-                        state = HYPERV_UNKNOWN; // doing this is enough to trigger a VM detection, we dont need to mark a 100% vm score as our techniques will do the job for us
-                    } 
-                } 
-            }
+                    if (!seen_core[core]) {
+                        seen_core[core] = true;
+                        ++physical_cores;
+                    }
+                }
 
-            memo::hyperx::store(state);
+                if (physical_cores < 2) {
+                    return 0ull;
+                }
+            }
 
-            return state;
-        #endif
-        }
+            // counter: middle available logical CPU when >2, otherwise second available logical CPU
+            const DWORD counter_pos0 = (n == 2) ? 1u : (n / 2u);
+            if (counter_pos0 >= n) {
+                return 0ull;
+            }
 
-        // For strings shorter than 16-32 bytes, the overhead of setting up the _mm_crc32_u64 (or 32) loop, then checking length, handling the tail bytes, and finally handling alignment, 
-        // will always make it slower or equal to a simple unrolled u8 loop, and not every cpu model fits in u32/u64
-        #if (x86 && (CLANG || GCC))
-            __attribute__((__target__("crc32")))
-        #endif
-        static u32 crc32(u32 crc, char data) {
-        #if (x86)
-            return _mm_crc32_u8(crc, static_cast<u8>(data));
-        #else
-            // Fallback for non-x86: use software CRC32-C
-            crc ^= static_cast<u8>(data);
-            for (int i = 0; i < 8; ++i)
-                crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78u : 0);
-            return crc;
-        #endif
-        }
+            const DWORD counter_logical = idxs[counter_pos0];
+            const DWORD counter_core = logical_to_core[counter_logical];
+            const DWORD counter_numa = logical_to_numa[counter_logical];
 
-        // to search in our databases, we want to precompute hashes at compile time for C++11 and later
-        // so we need to match the hardware _mm_crc32_u8, it is based on CRC32-C (Castagnoli) polynomial
-        struct constexpr_hash {
-            // it does 8 rounds of CRC32-C bit reflection recursively
-            static constexpr u32 crc32_bits(u32 crc, int bits) {
-                return (bits == 0) ? crc :
-                    crc32_bits((crc >> 1) ^ ((crc & 1) ? 0x82F63B78u : 0), bits - 1);
+            if (counter_core == INVALID_CPU || counter_numa == INVALID_CPU) {
+                return 0ull;
             }
 
-            // over string
-            static constexpr u32 crc32_str(const char* s, u32 crc) {
-                return (*s == '\0') ? crc :
-                    crc32_str(s + 1, crc32_bits(crc ^ static_cast<u8>(*s), 8));
+            if (!trigger) {
+                return 1ull << counter_logical;
             }
 
-            static constexpr u32 get(const char* s) {
-                return crc32_str(s, 0);
-            }
-        };
+            auto is_edge = [&](DWORD logical) -> bool {
+                return logical == idxs[0] || logical == idxs[n - 1];
+            };
 
-        // this forces the compiler to calculate the hash when initializing the array while staying C++11 compatible
-        struct thread_entry {
-            u32 hash;
-            u32 threads;
-            constexpr thread_entry(const char* m, u32 t) : hash(constexpr_hash::get(m)), threads(t) {}
-        };
+            auto same_numa = [&](DWORD logical) -> bool {
+                return logical_to_numa[logical] != INVALID_CPU && logical_to_numa[logical] == counter_numa;
+            };
 
-        enum class cpu_type : u8 {
-            INTEL_I,
-            INTEL_XEON,
-            AMD
-        };
+            auto build_candidates = [&](bool require_same_numa, bool avoid_edges) {
+                std::vector<DWORD> out;
+                out.reserve(n);
 
-        // 4 arguments to stay compliant with x64 __fastcall (just in case)
-        [[nodiscard]] static bool verify_thread_count(const thread_entry* db, size_t db_size, size_t max_model_len, cpu_type type) {
-            // to save a few cycles
-            struct hasher {
-                static u32 crc32_sw(u32 crc, char data) {
-                    crc ^= static_cast<u8>(data);
-                    for (int i = 0; i < 8; ++i) {
-                        crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78u : 0);
+                for (DWORD i = 0; i < n; ++i) {
+                    const DWORD logical = idxs[i];
+                    if (logical == counter_logical) {
+                        continue;
                     }
-                    return crc;
-                }
 
-                using hashfc = u32(*)(u32, char);
-
-                static hashfc get() {
-                    // yes, vmaware runs on dinosaur cpus without sse4.2 pretty often
-                    i32 regs[4];
-                    cpu::cpuid(regs, 1);
-                    const bool has_sse42 = (regs[2] & (1 << 20)) != 0;
+                    // never same physical core when possible
+                    if (logical_to_core[logical] == counter_core) {
+                        continue;
+                    }
 
-                    return has_sse42 ? util::crc32 : crc32_sw;
-                }
-            };
+                    if (avoid_edges && is_edge(logical)) {
+                        continue;
+                    }
 
-            std::string model_string;
-            const char* debug_tag = ""; // NOLINT(clang-analyzer-deadcode.DeadStores)
+                    if (require_same_numa && !same_numa(logical)) {
+                        continue;
+                    }
 
-            if (type == cpu_type::AMD) {
-                if (!cpu::is_amd()) {
-                    return false;
-                }
-                model_string = cpu::get_brand();
-                debug_tag = "AMD_THREAD_MISMATCH";
-            }
-            else {
-                if (!cpu::is_intel()) {
-                    return false;
+                    out.push_back(logical);
                 }
 
-                const cpu::model_struct model = cpu::get_model();
+                return out;
+            };
 
-                if (!model.found) {
-                    return false;
-                }
+            // priority order
+            // 1) different physical core + same NUMA + not first/last
+            // 2) different physical core + same NUMA
+            // 3) different physical core + not first/last
+            // 4) different physical core
+            std::vector<DWORD> candidates = build_candidates(true, true);
+            if (candidates.empty()) candidates = build_candidates(true, false);
+            if (candidates.empty()) candidates = build_candidates(false, true);
+            if (candidates.empty()) candidates = build_candidates(false, false);
 
-                if (type == cpu_type::INTEL_I) {
-                    if (!model.is_i_series) {
-                        return false;
-                    }
-                    debug_tag = "INTEL_THREAD_MISMATCH";
-                }
-                else {
-                    if (!model.is_xeon) {
-                        return false;
-                    }
-                    debug_tag = "XEON_THREAD_MISMATCH";
-                }
-                model_string = model.string;
+            if (candidates.empty()) {
+                return 0ull;
             }
 
-            if (model_string.empty()) {
-                return false;
-            }
+            u64 seed = 0;
+            seed ^= static_cast<u64>(ct_seed);
+            seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&proc_mask));
+            seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&sys_mask)) << 1;
+            seed ^= static_cast<u64>(counter_logical) << 2;
+            seed ^= static_cast<u64>(counter_core) << 3;
+            seed ^= seed >> 33;
+            seed *= 0xff51afd7ed558ccdULL;
+            seed ^= seed >> 33;
+            seed *= 0xc4ceb9fe1a85ec53ULL;
+            seed ^= seed >> 33;
 
-            debug(debug_tag, ": CPU model = ", model_string);
+            std::seed_seq seq{
+                static_cast<u32>(seed),
+                static_cast<u32>(seed >> 32),
+                static_cast<u32>(seed ^ 0x9e3779b9u),
+                ct_seed
+            };
 
-            const char* str = model_string.c_str();
-            u32 expected_threads = 0;
-            bool found = false;
-            size_t best_len = 0;
+            std::mt19937 gen(seq);
+            const DWORD logical = candidates[std::uniform_int_distribution<size_t>(0, candidates.size() - 1)(gen)];
+            return 1ull << logical;
+        }
 
-            // manual collision fix for Z1 Extreme (16) vs Z1 (12)
-            // this is a special runtime check because "z1" is a substring of "z1 extreme" tokens
-            // and both might be hashed. VMAware should prioritize 'extreme' if found
-            u32 z_series_threads = 0;
+        // we dont use cpu::cpuid on purpose
+        static VMAWARE_FORCE_INLINE void vmexit() {
+        #if (GCC || CLANG)
+            u32 a = 0, c = 0, d = 0;
+            #if (x86_64)
+            __asm__ volatile (
+                "pushq %%rbx\n\t" // better than doing something like xchgq %%rbx, %%rdi\n\t to swap rbx to rdi avoiding GCC pushing/popping rbx on the stack
+                "cpuid\n\t"
+                "popq %%rbx\n\t"
+                : "+a"(a), "+c"(c), "=d"(d) // + mapping forces compiler to use registers, avoids stack spills
+                :
+                : "cc"
+                );
+            #else
+            __asm__ volatile (
+                "pushl %%ebx\n\t"
+                "cpuid\n\t"
+                "popl %%ebx\n\t"
+                : "+a"(a), "+c"(c), "=d"(d)
+                :
+                : "cc"
+                );
+            #endif
+        #else
+            i32 dummy[4];
+            __cpuidex(dummy, 0x0, 0); // leaf 0 because it's the most stable one for making ratio checks, even if at first glance it may be abusable because it's the fastest one
+        #endif
+        }
 
-            const auto hash_func = hasher::get();
+        [[nodiscard]] static timer_tick_t calculate_latency(const std::vector<timer_tick_t>& samples_in) {
+            if (samples_in.empty()) return 0;
+            const size_t N = samples_in.size();
+            if (N == 1) return samples_in[0];
 
-            for (size_t i = 0; str[i] != '\0'; ) {
-                char const c = str[i];
-                if (!((c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'))) {
-                    i++;
-                    continue;
-                }
+            // create a local copy to sort
+            std::vector<timer_tick_t> s = samples_in;
+            std::sort(s.begin(), s.end());
 
-                u32 current_hash = 0;
-                size_t current_len = 0;
-                size_t j = i;
+            // discard the lower 25% and upper 25%, leaving the middle 50%
+            const size_t low_idx = N / 4;
+            const size_t high_idx = (3 * N) / 4;
 
-                while (true) {
-                    char k = str[j];
-                    const bool is_valid = (
-                        (k >= '0' && k <= '9') ||
-                        (k >= 'A' && k <= 'Z') ||
-                        (k >= 'a' && k <= 'z') ||
-                        (k == '-') // models have hyphen
-                    );
-    
-                    if (!is_valid) {
-                        break;
-                    }
+            double sum = 0;
+            size_t count = 0;
+            for (size_t i = low_idx; i < high_idx; ++i) {
+                sum += s[i];
+                count++;
+            }
 
-                    if (current_len >= max_model_len) {
-                        while (str[j] != '\0' && str[j] != ' ') {
-                            j++; // fast forward to space/null
-                        }
-                        break;
-                    }
+            // fallback to the median if the dataset is too small
+            if (count == 0) return s[N / 2];
 
-                    /*
-                       models are usually 8 or more bytes long, i.e. i9-10900K
-                       so imagine we want to use u64, you hash the first 8 bytes i9-10900
-                       but then you are left with K. You have to handle the tail
-                       fetching 8 bytes would include the characters after the token, corrupting the hash
-                       so a byte-by-byte loop is the most optimal choice here
-                    */
+            // compute the average of the middle 50% and round to the nearest integer
+            return static_cast<timer_tick_t>((sum / count) + 0.5);
+        }
 
-                    // convert to lowercase on-the-fly to match compile-time keys
-                    if (type == cpu_type::AMD && (k >= 'A' && k <= 'Z')) {
-                        k += 32;
-                    }
+        static VMAWARE_FORCE_INLINE void burn_random_cycles(u32 ct_seed, timer_tick_t v_post, timer_tick_t r_post) {
+            // the internal pseudo-random number generator (PRNG) variables like u64 seed and volatile u64 x can be kept as u64 
+            // because they are simple register-only PRNG arithmetic and benefit from the extra 64-bit entropy space even on 32-bit platforms
+            u64 seed = ct_seed;
+            seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&seed));
+            seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&v_post)) << 1;
+            seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&r_post)) << 2;
+            seed ^= seed >> 33;
+            seed *= 0xff51afd7ed558ccdULL;
+            seed ^= seed >> 33;
+            seed *= 0xc4ceb9fe1a85ec53ULL;
+            seed ^= seed >> 33;
 
-                    // since this technique is cross-platform, we cannot use a standard C++ try-catch block to catch a missing CPU instruction
-                    // we could use preprocessor directives and add an exception handler (VEH/SEH or SIGHANDLER) but nah
-                    current_hash = hash_func(current_hash, k);
-                    current_len++;
-                    j++;
+            // 64u is the minimum amount of work every time, 0x1FFu controls how much the count varies
+            const u32 rounds = 64u + static_cast<u32>(seed & 0x7FFu); // variable per iteration
+            volatile u64 x = seed | 1ULL;
 
-                    // only verify match if the token has ended (next char is not alphanumeric)
-                    const char next = str[j];
-                    const bool next_is_alnum = (next >= '0' && next <= '9') ||
-                        (next >= 'A' && next <= 'Z') ||
-                        (next >= 'a' && next <= 'z');
+            for (u32 i = 0; i < rounds; ++i) {
+                x = x * 6364136223846793005ULL + 1ULL;
+                x ^= x >> 17;
+            }
 
-                    if (!next_is_alnum) {
-                        // Check specific Z1 Extreme token
-                        // Hash for "extreme" (CRC32-C) is 0x3D09D5B4
-                        if (type == cpu_type::AMD && current_hash == 0x3D09D5B4) { z_series_threads = 16; }
+            std::atomic_signal_fence(std::memory_order_acq_rel);
+        }
+    };
+#endif
 
-                        // since it's a contiguous block of integers in .rodata/.rdata, this is extremely fast
-                        for (size_t idx = 0; idx < db_size; ++idx) {
-                            if (db[idx].hash != current_hash) {
-                                continue;
-                            }
+    // miscellaneous functionalities
+    struct util {
+        static bool is_unsupported(const VM::enum_flags flag) {
+            // cross platform?
+            if (
+                (flag >= VM::HYPERVISOR_BIT) &&
+                (flag <= VM::KGT_SIGNATURE)
+            ) {
+                return false;
+            }
 
-                            if (current_len > best_len) {
-                                best_len = current_len;
-                                expected_threads = db[idx].threads;
-                                found = true;
-                            }
-                            // since hashing implies uniqueness in this dataset, you might say we could break here,
-                            // but we continue to ensure we find the longest substring match if overlaps exist,
-                            // so like it finds both "i9-11900" and "i9-11900K" i.e.
-                        }
-                    }
-                }
-                i = j;
+            #if (LINUX)
+                return (!(
+                    (flag >= LINUX_START) &&
+                    (flag <= LINUX_END)
+                ));
+            #elif (WINDOWS)
+                return (!(
+                    (flag >= WINDOWS_START) &&
+                    (flag <= WINDOWS_END)
+                ));
+            #elif (APPLE) 
+                return (!(
+                    (flag >= MACOS_START) &&
+                    (flag <= MACOS_END)
+                ));
+            #else
+                return false;
+            #endif
+        }
+
+    #if (LINUX)
+        // everything the container techniques look at, gathered once per detection run, see util::containers()
+        struct container_info {
+            // /proc/self/cgroup
+            bool cgroup_readable = false;
+            bool cgroup_docker = false;
+            bool cgroup_containerd = false;
+            bool cgroup_container_id = false;   // a 64 hex digit path component, which is how runtimes name cgroup v1 groups
+            bool cgroup_namespace_root = false; // "0::/", what a cgroup v2 namespace shows from the inside
+
+            // /proc/self/mountinfo, the files a runtime bind mounts into the container (hostname, resolv.conf, ...)
+            bool mount_docker = false;
+            bool mount_podman = false;
+            bool mount_containerd = false;
+
+            // /proc/self/status
+            bool pid_one = false;
+            bool ppid_zero = false;
+
+            bool dockerenv = false;    // /.dockerenv or /.dockerinit
+            bool containerenv = false; // /run/.containerenv
+            bool proc_vz = false;
+
+            // whichever runtime the bind mounts point to, NULL_BRAND if they don't
+            brand_enum mount_brand() const noexcept {
+                if (mount_podman) { return brand_enum::PODMAN; }
+                if (mount_containerd) { return brand_enum::CONTAINERD; }
+                if (mount_docker) { return brand_enum::DOCKER; }
+                return brand_enum::NULL_BRAND;
             }
+        };
 
-            // Z1 Extreme fix
-            if (type == cpu_type::AMD && z_series_threads != 0 && expected_threads == 12) {
-                expected_threads = z_series_threads;
+        // one file of /sys/firmware/acpi/tables, see util::acpi_tables(). Only the standard 36 byte header is
+        // kept, body() reads the whole table again every time so a long running process doesn't hold on to 
+        // tables that can be megabytes big (sysfs can't map them either, so it would always be a heap copy)
+        struct acpi_table {
+            static constexpr size_t HEADER_SIZE = 36;
+
+            std::string name; // like "DSDT" or "SSDT2"
+            std::string path;
+            std::array<u8, HEADER_SIZE> header{};
+            size_t header_size = 0; // FACS and the like can be shorter
+            u32 length = 0;         // as declared in the header
+
+            std::string signature() const { return field(0, 4); }
+            std::string oem_id() const { return field(10, 6); }
+            std::string oem_table_id() const { return field(16, 8); }
+            std::string creator_id() const { return field(28, 4); }
+
+            std::vector<u8> body() const {
+                return read_file_binary(path.c_str());
             }
 
-            if (found) {
-                const u32 actual = memo::threadcount::fetch();
-                if (actual != expected_threads) {
-                    debug(debug_tag, ": Expected threads -> ", expected_threads);
-                    VMAWARE_UNUSED(debug_tag); // if compiled in release mode, silence the unused variable warning
-                    return true;
+        private:
+            std::string field(const size_t offset, const size_t size) const {
+                if (offset + size > header_size) {
+                    return {};
                 }
+
+                return std::string(reinterpret_cast<const char*>(header.data() + offset), size);
             }
+        };
 
-            return false;
-        }
+        struct acpi_table_index {
+            std::vector<acpi_table> tables; // in directory order
+            std::unordered_map<std::string, size_t> by_name;
 
-    #if (WINDOWS)
-        // retrieves the addresses of specified functions from a loaded module using the export directory, manual implementation of GetProcAddress
-        static void get_function_address(const HMODULE hModule, const char* names[], void** functions, size_t count) {
-            using func_map = std::unordered_map<std::string, void*>;
-            static std::unordered_map<HMODULE, func_map> function_cache;
+            const acpi_table* find(const std::string& table_name) const {
+                const auto it = by_name.find(table_name);
+                return ((it == by_name.end()) ? nullptr : &tables.at(it->second));
+            }
+        };
+    #endif
 
-            for (size_t i = 0; i < count; ++i) functions[i] = nullptr;
-            if (!hModule) return;
+        // file contents that are only read once per detection run and shared by every technique, 
+        // see file_cache_scope. Aliases like /sys/class/dmi/id and /sys/devices/virtual/dmi/id 
+        // resolve to the same canonical path, so they share a single read as well
+        struct file_cache {
+            std::mutex mutex;
+            std::unordered_map<std::string, std::string> aliases;  // path as it was asked for -> canonical path
+            std::unordered_map<std::string, std::string> contents; // canonical path -> contents, never moved once inserted
+            u32 reads = 0;
+            u32 hits = 0;
 
-            BYTE* base = reinterpret_cast<BYTE*>(hModule);
+        #if (LINUX)
+            // see util::swept_processes()
+            std::once_flag processes_swept;
+            std::unordered_set<std::string> processes;
 
-            size_t module_size = 0;
-            {
-                MEMORY_BASIC_INFORMATION mbi = {};
-                if (VirtualQuery(base, &mbi, sizeof(mbi))) {
-                    module_size = static_cast<size_t>(mbi.RegionSize);
-                }
-                else {
-                    return;
+            // see util::containers()
+            std::once_flag containers_checked;
+            container_info containers;
+
+            // see util::acpi_tables()
+            std::once_flag acpi_indexed;
+            acpi_table_index acpi;
+        #endif
+
+            // process-wide totals, to see how many reads the cache saved
+            static std::atomic<u32> total_reads;
+            static std::atomic<u32> total_hits;
+
+        #if (LINUX)
+            const std::string& fetch(const std::string& path) {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                const auto alias = aliases.find(path);
+
+                if (alias != aliases.end()) {
+                    ++hits;
+                    return contents.at(alias->second);
                 }
-            }
 
-            auto valid_range = [&](size_t offset, size_t sz) noexcept -> bool {
-                return (sz > 0) && (offset < module_size) && (sz <= module_size - offset);
-            };
+                lock.unlock();
 
-            auto cstr_from_rva = [&](DWORD rva) noexcept -> const char* {
-                if (!valid_range(static_cast<size_t>(rva), 1)) return nullptr;
+                char resolved[PATH_MAX] = {};
+                const std::string canonical = ((realpath(path.c_str(), resolved) != nullptr) ? std::string(resolved) : path);
 
-                const char* start = reinterpret_cast<const char*>(base + rva);
-                const size_t remaining = module_size - static_cast<size_t>(rva);
+                lock.lock();
 
-                if (std::memchr(start, '\0', remaining)) {
-                    return start;
+                const auto existing = contents.find(canonical);
+
+                if (existing != contents.end()) {
+                    aliases.emplace(path, canonical);
+                    ++hits;
+                    return existing->second;
                 }
 
-                return nullptr;
-            };
+                lock.unlock();
 
-            // Validate DOS header 
-            if (!valid_range(0, sizeof(IMAGE_DOS_HEADER))) return;
-            const auto* dosHeader = reinterpret_cast<const IMAGE_DOS_HEADER*>(base);
-            if (dosHeader->e_magic != IMAGE_DOS_SIGNATURE) return;
+                // missing files are cached too, as an empty string
+                std::string data = read_file_uncached(canonical);
 
-            // e_lfanew -> NT headers
-            if (dosHeader->e_lfanew < 0) return;
-            const size_t e_lfanew = static_cast<size_t>(dosHeader->e_lfanew);
-            if (!valid_range(e_lfanew, sizeof(IMAGE_NT_HEADERS))) return;
-            const auto* ntHeaders = reinterpret_cast<const IMAGE_NT_HEADERS*>(base + e_lfanew);
-            if (ntHeaders->Signature != IMAGE_NT_SIGNATURE) return;
+                lock.lock();
 
-            const size_t sizeOfImage = static_cast<size_t>(ntHeaders->OptionalHeader.SizeOfImage);
-            if (sizeOfImage != 0 && sizeOfImage > module_size) {
-                module_size = sizeOfImage;
-            }
+                // another thread might have read it in the meantime, the first one wins
+                const auto inserted = contents.emplace(canonical, std::move(data));
+                aliases.emplace(path, canonical);
 
-            // Check export data directory exists
-            if (ntHeaders->OptionalHeader.NumberOfRvaAndSizes <= IMAGE_DIRECTORY_ENTRY_EXPORT) {
-                return; // no export directory
-            }
+                if (inserted.second) {
+                    ++reads;
+                } else {
+                    ++hits;
+                }
 
-            const auto& dd = ntHeaders->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT];
-            if (dd.VirtualAddress == 0 || dd.Size == 0) {
-                return; // no exports
+                return inserted.first->second;
             }
 
-            // Validate export directory fits
-            if (!valid_range(static_cast<size_t>(dd.VirtualAddress), sizeof(IMAGE_EXPORT_DIRECTORY))) {
-                return;
+            // the contents if this exact path was already read, without reading it otherwise
+            const std::string* find(const std::string& path) {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                const auto alias = aliases.find(path);
+
+                if (alias == aliases.end()) {
+                    return nullptr;
+                }
+
+                ++hits;
+                return &contents.at(alias->second);
             }
 
-            const auto* exportDir = reinterpret_cast<const IMAGE_EXPORT_DIRECTORY*>(base + dd.VirtualAddress);
+            // for VM::PREFETCH, which reads files before anything asked for them. The path is kept as
+            // it is instead of being resolved, so another spelling of the same file is just read again
+            void store(const std::string& path, std::string data) {
+                std::lock_guard<std::mutex> lock(mutex);
 
-            const DWORD nameCount = exportDir->NumberOfNames;
-            const DWORD funcCount = exportDir->NumberOfFunctions;
+                if (contents.emplace(path, std::move(data)).second) {
+                    ++reads;
+                }
 
-            constexpr DWORD MAX_NAMES = 1u << 20; // 1M names is absurd but protective
-            if (nameCount == 0 || nameCount > MAX_NAMES) return;
-            if (funcCount == 0 || funcCount > MAX_NAMES) return;
+                aliases.emplace(path, path);
+            }
+        #endif
+        };
 
-            const DWORD addr_names = exportDir->AddressOfNames;
-            const DWORD addr_funcs = exportDir->AddressOfFunctions;
-            const DWORD addr_ord = exportDir->AddressOfNameOrdinals;
+        // the cache every read_file() call of this thread goes through, if there is one
+        static thread_local file_cache* active_file_cache;
 
-            if (!valid_range(static_cast<size_t>(addr_names), static_cast<size_t>(nameCount) * sizeof(DWORD))) return;
-            if (!valid_range(static_cast<size_t>(addr_funcs), static_cast<size_t>(funcCount) * sizeof(DWORD))) return;
-            if (!valid_range(static_cast<size_t>(addr_ord), static_cast<size_t>(nameCount) * sizeof(WORD))) return;
+        // what util::cached_file() reads outside of a run, dropped once the thread opens a new cache
+        // so that it doesn't hold on to stale contents
+        static thread_local std::unique_ptr<file_cache> idle_file_cache;
 
-            const DWORD* nameRvas = reinterpret_cast<const DWORD*>(base + addr_names);
-            const DWORD* funcRvas = reinterpret_cast<const DWORD*>(base + addr_funcs);
-            const WORD* ordinals = reinterpret_cast<const WORD*>(base + addr_ord);
+        // makes a file cache active for the current scope, either a new one or one shared by another thread
+        struct file_cache_scope {
+            std::unique_ptr<file_cache> owned;
+            file_cache* previous;
 
-            func_map& module_cache = function_cache[hModule];
+            // starts a new cache, unless there's already one active on this thread
+            file_cache_scope() : previous(active_file_cache) {
+                if (active_file_cache == nullptr) {
+                    owned.reset(new file_cache());
+                    active_file_cache = owned.get();
+                    idle_file_cache.reset();
+                }
+            }
 
-            for (size_t i = 0; i < count; ++i) {
-                const char* current_name = names[i];
-                if (!current_name) continue;
-                const std::string s_name(current_name);
+            // for worker threads, which share the cache of the thread that started the run
+            explicit file_cache_scope(file_cache* shared) : previous(active_file_cache) {
+                active_file_cache = shared;
+            }
 
-                // check cache first
-                const auto cache_it = module_cache.find(s_name);
-                if (cache_it != module_cache.end()) {
-                    functions[i] = cache_it->second;
-                    continue;
+            ~file_cache_scope() {
+                active_file_cache = previous;
+
+                if (owned) {
+                    file_cache::total_reads.fetch_add(owned->reads, std::memory_order_relaxed);
+                    file_cache::total_hits.fetch_add(owned->hits, std::memory_order_relaxed);
+                    debug("FILE_CACHE: ", owned->reads, " files read, ", owned->hits, " redundant reads avoided");
                 }
+            }
 
-                // binary search over names (names array is typically sorted)
-                DWORD lo = 0, hi = nameCount;
-                while (lo < hi) {
-                    const DWORD mid = lo + (hi - lo) / 2;
-                    const DWORD midNameRva = nameRvas[mid];
-                    const char* midName = cstr_from_rva(midNameRva);
-                    if (!midName) { // corrupted string table or something
-                        lo = hi;
-                        break;
-                    }
+            file_cache_scope(const file_cache_scope&) = delete;
+            file_cache_scope& operator=(const file_cache_scope&) = delete;
+        };
 
-                    const int cmp = strcmp(current_name, midName);
-                    if (cmp > 0) {
-                        lo = mid + 1;
-                    }
-                    else {
-                        hi = mid;
-                    }
-                }
+    #if (LINUX)
+        // fetch file data
+        [[nodiscard]] static std::string read_file(const char* raw_path) {
+            std::string path;
+            const std::string raw_path_str = raw_path;
 
-                if (lo < nameCount) {
-                    const char* candidateName = cstr_from_rva(nameRvas[lo]);
-                    if (candidateName && strcmp(current_name, candidateName) == 0) {
-                        const WORD nameOrdinal = ordinals[lo];
-                        if (static_cast<DWORD>(nameOrdinal) >= funcCount) continue;
-                        const DWORD funcRva = funcRvas[nameOrdinal];
-                        if (!valid_range(static_cast<size_t>(funcRva), 1)) continue;
-                        void* addr = reinterpret_cast<void*>(base + funcRva);
-                        functions[i] = addr;
-                        module_cache[s_name] = addr;
-                        continue;
-                    }
+            // replace the "~" part with the home directory
+            if (raw_path[0] == '~') {
+                const char* home = std::getenv("HOME");
+                if (home) {
+                    path = std::string(home) + raw_path_str.substr(1);
                 }
+            } else {
+                path = raw_path;
+            }
+
+            if (active_file_cache != nullptr) {
+                return active_file_cache->fetch(path);
             }
+
+            return read_file_uncached(path);
         }
 
+        // same as above without the "~" expansion, and without copying the contents out of the cache. 
+        // The reference stays valid until the end of the run. Outside of a run the contents are kept
+        // in idle_file_cache instead, which lives until this thread opens its next file_cache_scope
+        [[nodiscard]] static const std::string& cached_file(const char* path) {
+            if (active_file_cache != nullptr) {
+                return active_file_cache->fetch(path);
+            }
 
-        [[nodiscard]] static HMODULE get_ntdll() {
-            static HMODULE cached_ntdll = nullptr;
-            if (cached_ntdll != nullptr) {
-                return cached_ntdll;
+            if (!idle_file_cache) {
+                idle_file_cache.reset(new file_cache());
             }
 
-        #ifndef _WINTERNL_
-            typedef struct _UNICODE_STRING {
-                USHORT Length;
-                USHORT MaximumLength;
-                PWSTR  Buffer;
-            } UNICODE_STRING, * PUNICODE_STRING;
+            return idle_file_cache->fetch(path);
+        }
 
-            typedef struct _PEB_LDR_DATA {
-                BYTE Reserved1[8];
-                PVOID Reserved2[3];
-                LIST_ENTRY InMemoryOrderModuleList;
-            } PEB_LDR_DATA, * PPEB_LDR_DATA;
+        // the contents of a file this run already read or prefetched, nullptr if there's none
+        [[nodiscard]] static const std::string* prefetched(const std::string& path) {
+            if (active_file_cache == nullptr) {
+                return nullptr;
+            }
 
-            typedef struct _LDR_DATA_TABLE_ENTRY {
-                PVOID Reserved1[2];
-                LIST_ENTRY InMemoryOrderLinks;
-                PVOID Reserved2[2];
-                PVOID DllBase;
-                PVOID Reserved3[2];
-                UNICODE_STRING FullDllName;
-                BYTE Reserved4[8];
-                PVOID Reserved5[3];
-            #if (MSVC)
-            #pragma warning(suppress: 4201)
-            #endif
-                union {
-                    ULONG CheckSum;
-                    PVOID Reserved6;
-                } DUMMYUNIONNAME;
-                ULONG TimeDateStamp;
-            } LDR_DATA_TABLE_ENTRY, * PLDR_DATA_TABLE_ENTRY;
+            return active_file_cache->find(path);
+        }
 
-            typedef struct _PEB {
-                BYTE Reserved1[2];
-                BYTE BeingDebugged;
-                BYTE Reserved2[1];
-                PVOID Reserved3[2];
-                PPEB_LDR_DATA Ldr;
-            } PEB, * PPEB;
-        #endif
+        [[nodiscard]] static std::string read_file_uncached(const std::string& path) {
+            std::string data;
+            read_into(path.c_str(), data);
+            return data;
+        }
 
-            PPEB peb = nullptr;
+        // reads a whole file into the buffer, which keeps its capacity so it can be reused for the next file.
+        // procfs and most of sysfs report a size of 0 or 4096 whatever the contents are, so st_size is only 
+        // taken as a hint for the first read and the loop keeps going until EOF
+        template <typename Buffer>
+        static bool read_into(const char* path, Buffer& buffer) {
+            buffer.clear();
 
-        #if (x86_64)
-            #if (MSVC && !CLANG)
-                peb = reinterpret_cast<PPEB>(__readgsqword(0x60));
-            #else
-                asm("movq %%gs:0x60, %0" : "=r"(peb));
-            #endif
-        #elif (x86_32)
-            #if (MSVC&& !CLANG)
-                peb = reinterpret_cast<PPEB>(__readfsdword(0x30));
-            #else
-                asm("movl %%fs:0x30, %0" : "=r"(peb));
-            #endif
-        #endif
+            const int fd = open(path, O_RDONLY | O_CLOEXEC);
 
-            if (!peb) { // not x86 or tampered with
-                const HMODULE ntdll = GetModuleHandleW(L"ntdll.dll");
-                if (ntdll) cached_ntdll = ntdll;
-                return ntdll;
+            if (fd < 0) {
+                return false;
             }
 
-            PPEB_LDR_DATA ldr = peb->Ldr;
-            if (!ldr) {
-                const HMODULE h = GetModuleHandleW(L"ntdll.dll");
-                if (h) cached_ntdll = h;
-                return h;
+            struct stat info{};
+            size_t capacity = 4096;
+
+            if ((fstat(fd, &info) == 0) && S_ISREG(info.st_mode) && (info.st_size > 0)) {
+                capacity = static_cast<size_t>(info.st_size) + 1; // one more so EOF shows up without growing
             }
 
-            #ifndef CONTAINING_RECORD
-                #define CONTAINING_RECORD(address, type, field) ((type *)((char*)(address) - (size_t)(&((type *)0)->field)))
-            #endif
+            buffer.resize(capacity);
+            size_t length = 0;
 
-            constexpr WCHAR target_name[] = L"ntdll.dll";
-            constexpr size_t target_length = (std::size(target_name) - 1);
+            while (true) {
+                if (length == buffer.size()) {
+                    buffer.resize(buffer.size() * 2);
+                }
 
-            LIST_ENTRY* head = &ldr->InMemoryOrderModuleList;
-            // static analyzers don't know that InMemoryOrderModuleList is a circular list managed by the loader
-            // so they conservatively assume head->Flink or some cur->Flink might be nullptr
-            for (LIST_ENTRY* cur = head->Flink; cur != nullptr && cur != head; cur = cur->Flink) {
-                auto* ent = CONTAINING_RECORD(cur, LDR_DATA_TABLE_ENTRY, InMemoryOrderLinks);
-                if (!ent) continue;
+                const ssize_t n = read(fd, &buffer[length], buffer.size() - length);
 
-                auto* fullname = &ent->FullDllName;
-                if (!fullname->Buffer || fullname->Length == 0) continue;
+                if (n > 0) {
+                    length += static_cast<size_t>(n);
+                } else if ((n < 0) && (errno == EINTR)) {
+                    continue;
+                } else {
+                    break; // EOF, or an error like a process that exited while its /proc entry was read
+                }
+            }
 
-                const auto total_chars = static_cast<USHORT>(fullname->Length / sizeof(WCHAR));
+            close(fd);
+            buffer.resize(length);
+            return true;
+        }
 
-                size_t start = total_chars;
-                while (start > 0) {
-                    const WCHAR c = fullname->Buffer[start - 1];
-                    if (c == L'\\' || c == L'/') break;
-                    --start;
+    #if (VMA_IO_URING)
+        // just enough of io_uring to push a batch of openat, read or close requests through a single
+        // system call. liburing can't be assumed to be installed, so the rings are set up by hand.
+        // setup() fails on kernels before 5.6 and wherever io_uring is disabled, which includes the
+        // kernel.io_uring_disabled sysctl and the seccomp profiles of most container runtimes
+        struct io_ring {
+            int fd = -1;
+            unsigned entries = 0;
+            unsigned queued = 0;
+
+            void* sq_ring = nullptr;
+            void* cq_ring = nullptr;
+            void* sqe_area = nullptr;
+            size_t sq_ring_size = 0;
+            size_t cq_ring_size = 0;
+            size_t sqe_area_size = 0;
+
+            unsigned* sq_tail = nullptr;
+            unsigned* sq_mask = nullptr;
+            unsigned* sq_array = nullptr;
+            io_uring_sqe* sqes = nullptr;
+
+            unsigned* cq_head = nullptr;
+            unsigned* cq_tail = nullptr;
+            unsigned* cq_mask = nullptr;
+            io_uring_cqe* cqes = nullptr;
+
+            bool setup(const unsigned depth) {
+                io_uring_params params{};
+                const long ring_fd = syscall(__NR_io_uring_setup, depth, &params);
+
+                if (ring_fd < 0) {
+                    return false;
                 }
 
-                const size_t file_length = total_chars - start;
-                if (file_length != target_length) continue;
+                fd = static_cast<int>(ring_fd);
+                entries = params.sq_entries;
 
-                bool match = true;
-                for (size_t i = 0; i < file_length; ++i) {
-                    WCHAR a = fullname->Buffer[start + i];
-                    WCHAR b = target_name[i];
-                    if (a >= L'A' && a <= L'Z') a = static_cast<WCHAR>(a + 32);
-                    if (b >= L'A' && b <= L'Z') b = static_cast<WCHAR>(b + 32);
-                    if (a != b) { match = false; break; }
-                }
+                sq_ring_size = params.sq_off.array + (params.sq_entries * sizeof(unsigned));
+                cq_ring_size = params.cq_off.cqes + (params.cq_entries * sizeof(io_uring_cqe));
+                sqe_area_size = params.sq_entries * sizeof(io_uring_sqe);
 
-                if (match) {
-                    cached_ntdll = reinterpret_cast<HMODULE>(ent->DllBase);
-                    return cached_ntdll;
+                auto map = [this](const size_t size, const off_t offset) -> void* {
+                    void* const address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+                    return ((address == MAP_FAILED) ? nullptr : address);
+                };
+
+                sq_ring = map(sq_ring_size, static_cast<off_t>(IORING_OFF_SQ_RING));
+                cq_ring = map(cq_ring_size, static_cast<off_t>(IORING_OFF_CQ_RING));
+                sqe_area = map(sqe_area_size, static_cast<off_t>(IORING_OFF_SQES));
+
+                if ((sq_ring == nullptr) || (cq_ring == nullptr) || (sqe_area == nullptr)) {
+                    return false;
                 }
+
+                u8* const sq = static_cast<u8*>(sq_ring);
+                u8* const cq = static_cast<u8*>(cq_ring);
+
+                sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+                sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+                sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+                sqes = static_cast<io_uring_sqe*>(sqe_area);
+
+                cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+                cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+                cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+                cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+                return true;
             }
 
-            const HMODULE h = GetModuleHandleW(L"ntdll.dll");
-            if (h) cached_ntdll = h;
-            return h;
-        } 
+            ~io_ring() {
+                if (sqe_area != nullptr) { munmap(sqe_area, sqe_area_size); }
+                if (cq_ring != nullptr) { munmap(cq_ring, cq_ring_size); }
+                if (sq_ring != nullptr) { munmap(sq_ring, sq_ring_size); }
+                if (fd >= 0) { close(fd); }
+            }
 
+            io_ring() = default;
+            io_ring(const io_ring&) = delete;
+            io_ring& operator=(const io_ring&) = delete;
 
-        static bool get_manufacturer_model(const char** out_manufacturer, const char** out_model) {
-            if (out_manufacturer) *out_manufacturer = "";
-            if (out_model) *out_model = "";
+            // the next free submission entry, zeroed. At most `entries` can be queued per submit()
+            io_uring_sqe* queue(const u32 tag) {
+                const unsigned index = ((*sq_tail + queued) & *sq_mask);
+                io_uring_sqe* const sqe = &sqes[index];
 
-            auto is_placeholder = [](const char* s) noexcept -> bool {
-                if (!s || !*s) {
+                std::memset(sqe, 0, sizeof(io_uring_sqe));
+                sqe->user_data = tag;
+                sq_array[index] = index;
+                ++queued;
+
+                return sqe;
+            }
+
+            // hands everything queued to the kernel and waits until all of it is done,
+            // the result of each request ends up at results[tag]
+            bool submit(std::vector<int>& results) {
+                const unsigned count = queued;
+                queued = 0;
+
+                if (count == 0) {
                     return true;
                 }
 
-                return std::strcmp(s, "System Product Name") == 0 ||
-                    std::strcmp(s, "To Be Filled By O.E.M.") == 0 ||
-                    std::strcmp(s, "Default string") == 0 ||
-                    std::strcmp(s, "Not Specified") == 0 ||
-                    std::strcmp(s, "None") == 0;
-            };
+                __atomic_store_n(sq_tail, *sq_tail + count, __ATOMIC_RELEASE);
 
-            auto read_reg_utf8 = [](const wchar_t* value_name, char* out, size_t out_size) -> bool {
-                if (!out || out_size == 0) {
-                    return false;
-                }
+                unsigned to_submit = count;
+                unsigned completed = 0;
 
-                out[0] = '\0';
+                while (completed < count) {
+                    const long submitted = syscall(__NR_io_uring_enter, fd, to_submit, count - completed, IORING_ENTER_GETEVENTS, nullptr, 0);
 
-                WCHAR wbuf[256]{};
-                DWORD cb = sizeof(wbuf);
+                    if (submitted < 0) {
+                        if (errno == EINTR) {
+                            continue;
+                        }
 
-                const LSTATUS st = RegGetValueW(
-                    HKEY_LOCAL_MACHINE,
-                    L"HARDWARE\\DESCRIPTION\\System\\BIOS",
-                    value_name,
-                    RRF_RT_REG_SZ,
-                    nullptr,
-                    wbuf,
-                    &cb
-                );
+                        return false;
+                    }
 
-                if (st != ERROR_SUCCESS || wbuf[0] == L'\0') {
-                    return false;
-                }
+                    to_submit -= std::min(to_submit, static_cast<unsigned>(submitted));
 
-                const int conv = WideCharToMultiByte(
-                    CP_UTF8,
-                    0,
-                    wbuf,
-                    -1,
-                    out,
-                    static_cast<int>(out_size),
-                    nullptr,
-                    nullptr
-                );
+                    unsigned head = *cq_head;
+                    const unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
 
-                if (conv <= 0) {
-                    out[0] = '\0';
-                    return false;
+                    for (; head != tail; ++head) {
+                        const io_uring_cqe& cqe = cqes[head & *cq_mask];
+                        results.at(static_cast<size_t>(cqe.user_data)) = cqe.res;
+                        ++completed;
+                    }
+
+                    __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
                 }
 
-                out[out_size - 1] = '\0';
                 return true;
-            };
-
-            if (memo::bios_info::is_cached()) {
-                const char* man = memo::bios_info::fetch_manufacturer();
-                const char* mod = memo::bios_info::fetch_model();
+            }
+        };
+    #endif
 
-                if (out_manufacturer) *out_manufacturer = man;
-                if (out_model) *out_model = mod;
+        // VM::PREFETCH, reads a whole list of small pseudo-files into the file cache of the current run with
+        // one io_uring batch per step (open everything, read everything, close everything) instead of three
+        // system calls per file. Files that don't fit in a single page are read normally afterwards, and
+        // without io_uring nothing is prefetched, so every technique reads its files when it needs them
+        static void prefetch_files(const std::vector<std::string>& paths) {
+            file_cache* const cache = active_file_cache;
 
-                return !is_placeholder(man) || !is_placeholder(mod);
+            if ((cache == nullptr) || paths.empty()) {
+                return;
             }
 
-            char man_tmp[sizeof(memo::bios_info::manufacturer)]{};
-            char model_tmp[sizeof(memo::bios_info::model)]{};
+        #if (VMA_IO_URING)
+            constexpr unsigned BATCH_SIZE = 64;
+            constexpr size_t PAGE = 4096; // the most a sysfs attribute can hold
 
-            bool got_any = false;
+            io_ring ring;
 
-            // Manufacturer priority:
-            // 1) SystemManufacturer
-            // 2) BaseBoardManufacturer
-            // 3) BIOS vendor string if needed later
-            if (read_reg_utf8(L"SystemManufacturer", man_tmp, sizeof(man_tmp)) &&
-                !is_placeholder(man_tmp)) {
-                memo::bios_info::store_manufacturer(man_tmp);
-                got_any = true;
-            }
-            else if (read_reg_utf8(L"BaseBoardManufacturer", man_tmp, sizeof(man_tmp)) &&
-                !is_placeholder(man_tmp)) {
-                memo::bios_info::store_manufacturer(man_tmp);
-                got_any = true;
-            }
-            else {
-                memo::bios_info::store_manufacturer("");
+            if (!ring.setup(BATCH_SIZE)) {
+                debug("PREFETCH: io_uring isn't available, files are read when they're needed");
+                return;
             }
 
-            // Model priority:
-            // 1) SystemProductName
-            // 2) BaseBoardProduct
-            // 3) SystemSKU
-            // 4) BaseBoardVersion
-            if (read_reg_utf8(L"SystemProductName", model_tmp, sizeof(model_tmp)) &&
-                !is_placeholder(model_tmp)) {
-                memo::bios_info::store_model(model_tmp);
-                got_any = true;
-            }
-            else if (read_reg_utf8(L"BaseBoardProduct", model_tmp, sizeof(model_tmp)) &&
-                !is_placeholder(model_tmp)) {
-                memo::bios_info::store_model(model_tmp);
-                got_any = true;
-            }
-            else if (read_reg_utf8(L"SystemSKU", model_tmp, sizeof(model_tmp)) &&
-                !is_placeholder(model_tmp)) {
-                memo::bios_info::store_model(model_tmp);
-                got_any = true;
-            }
-            else if (read_reg_utf8(L"BaseBoardVersion", model_tmp, sizeof(model_tmp)) &&
-                !is_placeholder(model_tmp)) {
-                memo::bios_info::store_model(model_tmp);
-                got_any = true;
-            }
-            else {
-                memo::bios_info::store_model("");
-            }
+            u32 batches = 0;
+            size_t stored = 0;
 
-            memo::bios_info::cached = true;
+            for (size_t begin = 0; begin < paths.size(); begin += ring.entries) {
+                const size_t count = std::min(paths.size() - begin, static_cast<size_t>(ring.entries));
 
-            if (out_manufacturer) *out_manufacturer = memo::bios_info::fetch_manufacturer();
-            if (out_model) *out_model = memo::bios_info::fetch_model();
+                std::vector<int> fds(count, -EBADF);
+                std::vector<int> lengths(count, -EIO);
+                std::vector<int> closed(count, 1); // 1 until the ring reports the close
+                std::vector<std::string> buffers(count);
 
-            return got_any;
-        }
+                for (size_t i = 0; i < count; ++i) {
+                    io_uring_sqe* const sqe = ring.queue(static_cast<u32>(i));
+                    sqe->opcode = IORING_OP_OPENAT;
+                    sqe->fd = AT_FDCWD;
+                    sqe->addr = reinterpret_cast<u64>(paths[begin + i].c_str());
+                    sqe->open_flags = (O_RDONLY | O_CLOEXEC);
+                }
 
-        // indirect call without CFG checks
-        #if (MSVC)
-            #define NO_CF_GUARD __declspec(guard(nocf)) __declspec(noinline)
-        #elif (CLANG)
-            #if __has_declspec_attribute(guard)
-                #define NO_CF_GUARD __declspec(guard(nocf)) __attribute__((noinline))
-            #elif __has_attribute(nocf_check)
-                #define NO_CF_GUARD __attribute__((nocf_check)) __attribute__((noinline))
-            #else
-                #define NO_CF_GUARD __attribute__((noinline))
-            #endif
-        #elif (GCC)
-            #if defined(__has_attribute) && __has_attribute(nocf_check)
-                #define NO_CF_GUARD __attribute__((nocf_check)) __attribute__((noinline))
-            #else
-                #define NO_CF_GUARD __attribute__((noinline))
-            #endif
-            #else
-                #define NO_CF_GUARD
+                const bool opened = ring.submit(fds);
+
+                if (opened) {
+                    for (size_t i = 0; i < count; ++i) {
+                        if (fds[i] < 0) {
+                            continue;
+                        }
+
+                        buffers[i].resize(PAGE);
+
+                        io_uring_sqe* const sqe = ring.queue(static_cast<u32>(i));
+                        sqe->opcode = IORING_OP_READ;
+                        sqe->fd = fds[i];
+                        sqe->addr = reinterpret_cast<u64>(&buffers[i][0]);
+                        sqe->len = static_cast<u32>(PAGE);
+                        sqe->off = 0;
+                    }
+                }
+
+                const bool read = (opened && ring.submit(lengths));
+
+                if (read) {
+                    for (size_t i = 0; i < count; ++i) {
+                        if (fds[i] >= 0) {
+                            io_uring_sqe* const sqe = ring.queue(static_cast<u32>(i));
+                            sqe->opcode = IORING_OP_CLOSE;
+                            sqe->fd = fds[i];
+                        }
+                    }
+                }
+
+                // whatever the ring didn't close is closed here, which also covers a failed batch
+                if (!read || !ring.submit(closed)) {
+                    for (size_t i = 0; i < count; ++i) {
+                        if ((fds[i] >= 0) && (closed[i] == 1)) {
+                            close(fds[i]);
+                        }
+                    }
+                }
+
+                if (!read) {
+                    debug("PREFETCH: io_uring batch failed, the remaining files are read when they're needed");
+                    return;
+                }
+
+                ++batches;
+
+                for (size_t i = 0; i < count; ++i) {
+                    const std::string& path = paths[begin + i];
+
+                    // only what was actually read goes into the cache. A failed open or read isn't 
+                    // necessarily what a normal read would give: the io-wq workers of 5.6 to 5.11 
+                    // can't resolve /proc/self, and a busy process can run out of descriptors with 
+                    // a whole batch open at once. So those files are left to the normal lazy read
+                    if ((fds[i] < 0) || (lengths[i] < 0)) {
+                        continue;
+                    }
+
+                    if (static_cast<size_t>(lengths[i]) < PAGE) {
+                        buffers[i].resize(static_cast<size_t>(lengths[i]));
+                        cache->store(path, std::move(buffers[i]));
+                    } else {
+                        cache->store(path, read_file_uncached(path));
+                    }
+
+                    ++stored;
+                }
+            }
+
+            debug("PREFETCH: ", stored, " of ", paths.size(), " files read in ", batches, " io_uring batches");
+            VMAWARE_UNUSED(stored);
+            VMAWARE_UNUSED(batches);
         #endif
+        }
 
-        // helper function to invoke pointers without instrumentation
-        NO_CF_GUARD static void execute_unchecked(void* pointer) {
-            using func_t = void(*)();
-            reinterpret_cast<func_t>(pointer)();
+        [[nodiscard]] static bool exists(const char* path) {
+        #if (VMA_CPP >= 17)
+            return std::filesystem::exists(path);
+        #elif (VMA_CPP >= 11)
+            struct stat buffer;
+            return (stat(path, &buffer) == 0);
+        #endif
         }
+
+        static bool is_directory(const char* path) {
+            struct stat info{};
+            if (stat(path, &info) != 0) {
+                return false;
+            }
+            return (info.st_mode & S_IFDIR); // check if directory
+        };
     #endif
-    };
 
+        // fetch the file but in binary form
+        [[nodiscard]] static std::vector<u8> read_file_binary(const char* file_path) {
+            std::vector<u8> buffer;
 
-    struct brands {
-        static constexpr const char* NULL_BRAND = "Unknown";
-        static constexpr const char* VBOX = "VirtualBox";
-        static constexpr const char* VMWARE = "VMware";
-        static constexpr const char* VMWARE_EXPRESS = "VMware Express";
-        static constexpr const char* VMWARE_ESX = "VMware ESX";
-        static constexpr const char* VMWARE_GSX = "VMware GSX";
-        static constexpr const char* VMWARE_WORKSTATION = "VMware Workstation";
-        static constexpr const char* VMWARE_FUSION = "VMware Fusion";
-        static constexpr const char* VMWARE_HARD = "VMware (with VmwareHardenedLoader)";
-        static constexpr const char* BHYVE = "bhyve";
-        static constexpr const char* KVM = "KVM";
-        static constexpr const char* QEMU = "QEMU";
-        static constexpr const char* QEMU_KVM = "QEMU+KVM";
-        static constexpr const char* KVM_HYPERV = "KVM Hyper-V Enlightenment";
-        static constexpr const char* QEMU_KVM_HYPERV = "QEMU+KVM Hyper-V Enlightenment";
-        static constexpr const char* HYPERV = "Microsoft Hyper-V";
-        static constexpr const char* HYPERV_VPC = "Microsoft Virtual PC/Hyper-V";
-        static constexpr const char* PARALLELS = "Parallels";
-        static constexpr const char* XEN = "Xen HVM";
-        static constexpr const char* ACRN = "ACRN";
-        static constexpr const char* QNX = "QNX hypervisor";
-        static constexpr const char* HYBRID = "Hybrid Analysis";
-        static constexpr const char* SANDBOXIE = "Sandboxie";
-        static constexpr const char* DOCKER = "Docker";
-        static constexpr const char* WINE = "Wine";
-        static constexpr const char* VPC = "Virtual PC";
-        static constexpr const char* ANUBIS = "Anubis";
-        static constexpr const char* JOEBOX = "JoeBox";
-        static constexpr const char* THREATEXPERT = "ThreatExpert";
-        static constexpr const char* CWSANDBOX = "CWSandbox";
-        static constexpr const char* COMODO = "Comodo";
-        static constexpr const char* BOCHS = "Bochs";
-        static constexpr const char* NVMM = "NetBSD NVMM";
-        static constexpr const char* BSD_VMM = "OpenBSD VMM";
-        static constexpr const char* INTEL_HAXM = "Intel HAXM";
-        static constexpr const char* UNISYS = "Unisys s-Par";
-        static constexpr const char* LMHS = "Lockheed Martin LMHS";
-        static constexpr const char* CUCKOO = "Cuckoo";
-        static constexpr const char* BLUESTACKS = "BlueStacks";
-        static constexpr const char* JAILHOUSE = "Jailhouse";
-        static constexpr const char* APPLE_VZ = "Apple VZ";
-        static constexpr const char* INTEL_KGT = "Intel KGT (Trusty)";
-        static constexpr const char* AZURE_HYPERV = "Microsoft Azure Hyper-V";
-        static constexpr const char* SIMPLEVISOR = "SimpleVisor";
-        static constexpr const char* HYPERV_ROOT = "Hyper-V root partition (host system, not an actual VM)";
-        static constexpr const char* UML = "User-mode Linux";
-        static constexpr const char* POWERVM = "IBM PowerVM";
-        static constexpr const char* GCE = "Google Compute Engine (KVM)";
-        static constexpr const char* OPENSTACK = "OpenStack (KVM)";
-        static constexpr const char* KUBEVIRT = "KubeVirt (KVM)";
-        static constexpr const char* AWS_NITRO = "AWS Nitro System EC2 (KVM-based)";
-        static constexpr const char* PODMAN = "Podman";
-        static constexpr const char* WSL = "WSL";
-        static constexpr const char* OPENVZ = "OpenVZ";
-        static constexpr const char* BAREVISOR = "Barevisor";
-        static constexpr const char* HYPERPLATFORM = "HyperPlatform";
-        static constexpr const char* MINIVISOR = "MiniVisor";
-        static constexpr const char* INTEL_TDX = "Intel TDX";
-        static constexpr const char* LKVM = "LKVM";
-        static constexpr const char* AMD_SEV = "AMD SEV";
-        static constexpr const char* AMD_SEV_ES = "AMD SEV-ES";
-        static constexpr const char* AMD_SEV_SNP = "AMD SEV-SNP";
-        static constexpr const char* NEKO_PROJECT = "Neko Project II";
-        static constexpr const char* NOIRVISOR = "NoirVisor";
-        static constexpr const char* QIHOO = "Qihoo 360 Sandbox";
-        static constexpr const char* DBVM = "DBVM";
-        static constexpr const char* UTM = "UTM";
-        static constexpr const char* COMPAQ = "Compaq FX!32";
-        static constexpr const char* INSIGNIA = "Insignia RealPC";
-        static constexpr const char* CONNECTIX = "Connectix Virtual PC";
-        static constexpr const char* CONTAINERD = "Containerd";
+        #if (LINUX)
+            read_into(file_path, buffer);
+        #else
+            std::ifstream file(file_path, std::ios::binary);
 
-        static brand_list_t brand_list(const flagset& flags) {
-            if (memo::brand_list::is_cached()) {
-                return memo::brand_list::fetch();
+            if (!file) {
+                return {};
             }
 
-            // run all the techniques
-            const u16 score = core::run_all(flags);
+            char chunk[4096];
 
-            brand_list_t active_brands = {};
-            active_brands.reserve(MAX_BRANDS);
+            while (file.read(chunk, sizeof(chunk)) || (file.gcount() > 0)) {
+                buffer.insert(buffer.end(), chunk, chunk + file.gcount());
+            }
+        #endif
 
-            for (size_t i = 0; i < MAX_BRANDS; ++i) {
-                if (core::brand_scoreboard.at(i).score > 0) {
-                    active_brands.emplace_back(std::make_pair(core::brand_scoreboard.at(i).name, core::brand_scoreboard.at(i).score));
+            return buffer;
+        }
+
+        // hash-and-displace table over a fixed list of entries with a u64 `key`, built once. Keys are split
+        // into small buckets, and each bucket gets the first displacement that puts all of its keys into
+        // free slots, so every key ends up with a slot of its own and a lookup is two hashes and one compare
+        template <typename Entry>
+        struct perfect_hash {
+            const Entry* entries = nullptr;
+            std::vector<u8> displacements; // per bucket
+            std::vector<u16> slots;        // index + 1 into the entries, 0 for an empty slot
+
+            static u64 mix(u64 key, const u64 salt) noexcept {
+                // murmur3 finalizer
+                key ^= (salt * 0x9E3779B97F4A7C15ULL);
+                key ^= (key >> 33);
+                key *= 0xFF51AFD7ED558CCDULL;
+                key ^= (key >> 33);
+                key *= 0xC4CEB9FE1A85EC53ULL;
+                key ^= (key >> 33);
+                return key;
+            }
+
+            perfect_hash(const Entry* list, const size_t count) : entries(list) {
+                displacements.assign((count / 4) + 1, 0);
+                std::vector<std::vector<u16>> buckets(displacements.size());
+
+                for (u16 i = 0; i < count; ++i) {
+                    std::vector<u16>& bucket = buckets[static_cast<size_t>(mix(list[i].key, 0) % buckets.size())];
+                    const bool duplicate = std::any_of(bucket.begin(), bucket.end(), [&](const u16 j) { return (list[j].key == list[i].key); });
+
+                    if (!duplicate) {
+                        bucket.push_back(i);
+                    }
                 }
-            }
 
-            #ifdef __VMAWARE_DEBUG__
-                for (const auto& brand : active_brands) {
-                    debug("pre-processed scoreboard: ", int(brand.second), " : ", brands::brand_enum_to_string(brand.first));
+                // the crowded buckets are placed first while there's still plenty of room
+                std::vector<size_t> order(buckets.size());
+
+                for (size_t i = 0; i < order.size(); ++i) {
+                    order[i] = i;
                 }
-            #endif
 
-            auto remove = [&](const enum brand_enum brand) noexcept {
-                for (auto it = active_brands.begin(); it != active_brands.end(); ++it) {
-                    if (it->first == brand) {
-                        active_brands.erase(it);
+                std::stable_sort(order.begin(), order.end(), [&](const size_t a, const size_t b) {
+                    return (buckets[a].size() > buckets[b].size());
+                });
+
+                // half full to start with, and twice as big whenever a bucket can't be placed
+                for (size_t slot_count = (2 * count) + 1; ; slot_count *= 2) {
+                    slots.assign(slot_count, 0);
+
+                    if (place(buckets, order)) {
                         return;
                     }
                 }
-            };
-
-            // if all brands have a point of 0, return "Unknown"
-            if (active_brands.empty()) {                        
-                active_brands.emplace_back(brand_enum::NULL_BRAND, 1);
-                memo::brand_list::store(active_brands);
-                return active_brands;
             }
 
-            // if there's only a single brand, return it immediately
-            // We skip this early return if the single brand is HYPERV_ARTIFACT,
-            // but we must also nullify the result if the score is above 0, 
-            // which would most likely indicate a hardened VM instead and return "Unknown".
-            if (active_brands.size() == 1) {
-                const enum brand_enum brand = active_brands.front().first;
+            const Entry* find(const u64 key) const noexcept {
+                const u8 displacement = displacements[static_cast<size_t>(mix(key, 0) % displacements.size())];
+                const u16 index = slots[static_cast<size_t>(mix(key, displacement + 1u) % slots.size())];
 
-                if (brand == brand_enum::HYPERV_ROOT && score > 0) {
-                    active_brands.emplace_back(brand_enum::NULL_BRAND, 1);
-                    remove(brand_enum::HYPERV_ROOT);
+                if ((index == 0) || (entries[index - 1].key != key)) {
+                    return nullptr;
                 }
 
-                memo::brand_list::store(active_brands);
-                return active_brands;
+                return &entries[index - 1];
             }
 
-            // remove Hyper-V artifacts and Unknown if found with other brands
-            if (active_brands.size() > 1) {
-                remove(brand_enum::HYPERV_ROOT);
-                remove(brand_enum::NULL_BRAND);
-                remove(brand_enum::INVALID);
-            }
+        private:
+            bool place(const std::vector<std::vector<u16>>& buckets, const std::vector<size_t>& order) {
+                std::vector<size_t> taken;
 
-            // this bitset acts as an abstraction layer for the merging stage of this function.
-            // the amount of hits above 0 for a brand isn't relevant, the core idea here is to
-            // just check the presence of the brand itself so we can merge them. 
-            std::bitset<MAX_BRANDS> brand_hits = {};
+                for (const size_t b : order) {
+                    const std::vector<u16>& bucket = buckets[b];
+                    bool placed = bucket.empty();
 
-            for (const auto& brand : active_brands) {
-                brand_hits.set(static_cast<u8>(brand.first));
-            }
+                    for (u16 displacement = 0; !placed && (displacement <= 0xFF); ++displacement) {
+                        taken.clear();
 
-            // merge 2 brands into one
-            auto merge = [&](const enum brand_enum a, const enum brand_enum b, const enum brand_enum result) noexcept -> void {
-                const bool a_hit = brand_hits.test(static_cast<u8>(a));
-                const bool b_hit = brand_hits.test(static_cast<u8>(b));
+                        for (const u16 i : bucket) {
+                            const size_t slot = static_cast<size_t>(mix(entries[i].key, displacement + 1u) % slots.size());
 
-                if (a_hit && b_hit) {
-                    remove(a);
-                    remove(b);
-                    active_brands.emplace_back(result, 2);
+                            if ((slots[slot] != 0) || (std::find(taken.begin(), taken.end(), slot) != taken.end())) {
+                                break;
+                            }
+
+                            taken.push_back(slot);
+                        }
+
+                        if (taken.size() == bucket.size()) {
+                            for (size_t k = 0; k < bucket.size(); ++k) {
+                                slots[taken[k]] = static_cast<u16>(bucket[k] + 1);
+                            }
+
+                            displacements[b] = static_cast<u8>(displacement);
+                            placed = true;
+                        }
+                    }
+
+                    if (!placed) {
+                        return false;
+                    }
                 }
-            };
 
-            // same as above, but for 3
-            auto triple_merge = [&](const enum brand_enum a, const enum brand_enum b, const enum brand_enum c, const enum brand_enum result) noexcept -> void {
-                const bool a_hit = brand_hits.test(static_cast<u8>(a));
-                const bool b_hit = brand_hits.test(static_cast<u8>(b));
-                const bool c_hit = brand_hits.test(static_cast<u8>(c));
+                return true;
+            }
+        };
 
-                if (a_hit && b_hit && c_hit) {
-                    remove(a);
-                    remove(b);
-                    remove(c);
-                    active_brands.emplace_back(result, 2);
+        // Aho-Corasick automaton over a fixed list of up to 64 byte strings, built once. scan() walks a buffer
+        // a single time and returns a mask with bit i set if patterns[i] occurs anywhere in it, so the caller
+        // can still decide which pattern wins. Bytes that no pattern uses share one column of the table, and 
+        // with ignore_case both cases of a letter share one as well
+        struct pattern_matcher {
+            static constexpr u16 NONE = 0xFFFF;
+
+            std::array<u8, 256> byte_class{}; // 0 for bytes that aren't in any pattern
+            size_t class_count = 1;
+            std::vector<u16> transitions;     // [state * class_count + class]
+            std::vector<u64> outputs;         // patterns that end in each state
+
+            pattern_matcher(const char* const* patterns, const size_t count, const bool ignore_case = false) {
+                for (size_t i = 0; i < count; ++i) {
+                    for (const char* c = patterns[i]; *c != '\0'; ++c) {
+                        u8 byte = static_cast<u8>(*c);
+
+                        if (ignore_case && (byte >= 'A') && (byte <= 'Z')) {
+                            byte = static_cast<u8>(byte | 0x20);
+                        }
+
+                        if (byte_class[byte] != 0) {
+                            continue;
+                        }
+
+                        byte_class[byte] = static_cast<u8>(class_count++);
+
+                        if (ignore_case && (byte >= 'a') && (byte <= 'z')) {
+                            byte_class[byte & 0xDF] = byte_class[byte];
+                        }
+                    }
                 }
-            };
 
-            // Brand post-processing / merging
-            merge(brand_enum::VPC, brand_enum::HYPERV, brand_enum::HYPERV_VPC);
+                // the trie of every pattern
+                add_state();
 
-            merge(brand_enum::AZURE_HYPERV, brand_enum::HYPERV, brand_enum::AZURE_HYPERV);
-            merge(brand_enum::AZURE_HYPERV, brand_enum::VPC, brand_enum::AZURE_HYPERV);
-            merge(brand_enum::AZURE_HYPERV, brand_enum::HYPERV_VPC, brand_enum::AZURE_HYPERV);
+                for (size_t i = 0; (i < count) && (i < 64); ++i) {
+                    size_t state = 0;
 
-            merge(brand_enum::QEMU, brand_enum::KVM, brand_enum::QEMU_KVM);
-            merge(brand_enum::KVM, brand_enum::HYPERV, brand_enum::KVM_HYPERV);
-            merge(brand_enum::QEMU, brand_enum::HYPERV, brand_enum::QEMU_KVM_HYPERV);
-            merge(brand_enum::QEMU_KVM, brand_enum::HYPERV, brand_enum::QEMU_KVM_HYPERV);
+                    for (const char* c = patterns[i]; *c != '\0'; ++c) {
+                        const size_t slot = (state * class_count) + byte_class[static_cast<u8>(*c)];
 
-            merge(brand_enum::KVM, brand_enum::HYPERV_VPC, brand_enum::KVM_HYPERV);
-            merge(brand_enum::QEMU, brand_enum::HYPERV_VPC, brand_enum::QEMU_KVM_HYPERV);
-            merge(brand_enum::QEMU_KVM, brand_enum::HYPERV_VPC, brand_enum::QEMU_KVM_HYPERV);
+                        if (transitions[slot] == NONE) {
+                            const u16 next = add_state(); // resizes the table
+                            transitions[slot] = next;
+                        }
 
-            merge(brand_enum::KVM, brand_enum::KVM_HYPERV, brand_enum::KVM_HYPERV);
-            merge(brand_enum::QEMU, brand_enum::KVM_HYPERV, brand_enum::QEMU_KVM_HYPERV);
-            merge(brand_enum::QEMU_KVM, brand_enum::KVM_HYPERV, brand_enum::QEMU_KVM_HYPERV);
+                        state = transitions[slot];
+                    }
 
-            merge(brand_enum::HYPERV_VPC, brand_enum::KVM_HYPERV, brand_enum::KVM_HYPERV);
-            merge(brand_enum::HYPERV, brand_enum::KVM_HYPERV, brand_enum::KVM_HYPERV);
-            merge(brand_enum::HYPERV_VPC, brand_enum::QEMU_KVM_HYPERV, brand_enum::QEMU_KVM_HYPERV);
-            merge(brand_enum::HYPERV, brand_enum::QEMU_KVM_HYPERV, brand_enum::QEMU_KVM_HYPERV);
+                    outputs[state] |= (1ULL << i);
+                }
 
-            triple_merge(brand_enum::QEMU, brand_enum::KVM, brand_enum::KVM_HYPERV, brand_enum::QEMU_KVM_HYPERV);
+                // breadth first, so the failure state of each state is complete before it's needed. Missing
+                // transitions are filled in from the failure state, which turns the trie into a plain automaton
+                std::vector<u16> failure(outputs.size(), 0);
+                std::vector<u16> queue;
 
-            merge(brand_enum::VMWARE, brand_enum::VMWARE_FUSION, brand_enum::VMWARE_FUSION);
-            merge(brand_enum::VMWARE, brand_enum::VMWARE_EXPRESS, brand_enum::VMWARE_EXPRESS);
-            merge(brand_enum::VMWARE, brand_enum::VMWARE_ESX, brand_enum::VMWARE_ESX);
-            merge(brand_enum::VMWARE, brand_enum::VMWARE_GSX, brand_enum::VMWARE_GSX);
-            merge(brand_enum::VMWARE, brand_enum::VMWARE_WORKSTATION, brand_enum::VMWARE_WORKSTATION);
+                for (size_t c = 0; c < class_count; ++c) {
+                    u16& next = transitions[c];
 
-            merge(brand_enum::VMWARE_HARD, brand_enum::VMWARE, brand_enum::VMWARE_HARD);
-            merge(brand_enum::VMWARE_HARD, brand_enum::VMWARE_FUSION, brand_enum::VMWARE_HARD);
-            merge(brand_enum::VMWARE_HARD, brand_enum::VMWARE_EXPRESS, brand_enum::VMWARE_HARD);
-            merge(brand_enum::VMWARE_HARD, brand_enum::VMWARE_ESX, brand_enum::VMWARE_HARD);
-            merge(brand_enum::VMWARE_HARD, brand_enum::VMWARE_GSX, brand_enum::VMWARE_HARD);
-            merge(brand_enum::VMWARE_HARD, brand_enum::VMWARE_WORKSTATION, brand_enum::VMWARE_HARD);
+                    if (next == NONE) {
+                        next = 0;
+                    } else {
+                        queue.push_back(next);
+                    }
+                }
 
-            if (active_brands.size() > 1) {
-                std::sort(active_brands.begin(), active_brands.begin() + static_cast<std::ptrdiff_t>(active_brands.size()), [](
-                    const brand_element_t& a,
-                    const brand_element_t& b
-                ) {
-                    return a.second > b.second; // .second = brand score (usually u8)
-                });
-            }
+                for (size_t head = 0; head < queue.size(); ++head) {
+                    const u16 state = queue[head];
 
-        #ifdef __VMAWARE_DEBUG__
-            for (const auto& brand : active_brands) {
-                debug("post-processed scoreboard: ", static_cast<u32>(brand.second), " : ", brands::brand_enum_to_string(brand.first));
+                    for (size_t c = 0; c < class_count; ++c) {
+                        const size_t slot = (state * class_count) + c;
+                        const u16 fallback = transitions[(failure[state] * class_count) + c];
+
+                        if (transitions[slot] == NONE) {
+                            transitions[slot] = fallback;
+                        } else {
+                            const u16 next = transitions[slot];
+                            failure[next] = fallback;
+                            outputs[next] |= outputs[fallback];
+                            queue.push_back(next);
+                        }
+                    }
+                }
             }
-        #endif
 
-            memo::brand_list::store(active_brands);
-            return active_brands;
-        }
+            u64 scan(const u8* data, const size_t size) const noexcept {
+                u64 found = 0;
+                size_t state = 0;
 
-        static const char* brand_enum_to_string(const brand_enum brand) {
-            switch (brand) {
-                case brand_enum::INVALID: return "Invalid";
-                case brand_enum::VBOX: return VM::brands::VBOX;
-                case brand_enum::VMWARE: return VM::brands::VMWARE;
-                case brand_enum::VMWARE_EXPRESS: return VM::brands::VMWARE_EXPRESS;
-                case brand_enum::VMWARE_ESX: return VM::brands::VMWARE_ESX;
-                case brand_enum::VMWARE_GSX: return VM::brands::VMWARE_GSX;
-                case brand_enum::VMWARE_WORKSTATION: return VM::brands::VMWARE_WORKSTATION;
-                case brand_enum::VMWARE_FUSION: return VM::brands::VMWARE_FUSION;
-                case brand_enum::VMWARE_HARD: return VM::brands::VMWARE_HARD;
-                case brand_enum::BHYVE: return VM::brands::BHYVE;
-                case brand_enum::KVM: return VM::brands::KVM;
-                case brand_enum::QEMU: return VM::brands::QEMU;
-                case brand_enum::QEMU_KVM: return VM::brands::QEMU_KVM;
-                case brand_enum::KVM_HYPERV: return VM::brands::KVM_HYPERV;
-                case brand_enum::QEMU_KVM_HYPERV: return VM::brands::QEMU_KVM_HYPERV;
-                case brand_enum::HYPERV: return VM::brands::HYPERV;
-                case brand_enum::HYPERV_VPC: return VM::brands::HYPERV_VPC;
-                case brand_enum::PARALLELS: return VM::brands::PARALLELS;
-                case brand_enum::XEN: return VM::brands::XEN;
-                case brand_enum::ACRN: return VM::brands::ACRN;
-                case brand_enum::QNX: return VM::brands::QNX;
-                case brand_enum::HYBRID: return VM::brands::HYBRID;
-                case brand_enum::SANDBOXIE: return VM::brands::SANDBOXIE;
-                case brand_enum::DOCKER: return VM::brands::DOCKER;
-                case brand_enum::WINE: return VM::brands::WINE;
-                case brand_enum::VPC: return VM::brands::VPC;
-                case brand_enum::ANUBIS: return VM::brands::ANUBIS;
-                case brand_enum::JOEBOX: return VM::brands::JOEBOX;
-                case brand_enum::THREATEXPERT: return VM::brands::THREATEXPERT;
-                case brand_enum::CWSANDBOX: return VM::brands::CWSANDBOX;
-                case brand_enum::COMODO: return VM::brands::COMODO;
-                case brand_enum::BOCHS: return VM::brands::BOCHS;
-                case brand_enum::NVMM: return VM::brands::NVMM;
-                case brand_enum::BSD_VMM: return VM::brands::BSD_VMM;
-                case brand_enum::INTEL_HAXM: return VM::brands::INTEL_HAXM;
-                case brand_enum::UNISYS: return VM::brands::UNISYS;
-                case brand_enum::LMHS: return VM::brands::LMHS;
-                case brand_enum::CUCKOO: return VM::brands::CUCKOO;
-                case brand_enum::BLUESTACKS: return VM::brands::BLUESTACKS;
-                case brand_enum::JAILHOUSE: return VM::brands::JAILHOUSE;
-                case brand_enum::APPLE_VZ: return VM::brands::APPLE_VZ;
-                case brand_enum::INTEL_KGT: return VM::brands::INTEL_KGT;
-                case brand_enum::AZURE_HYPERV: return VM::brands::AZURE_HYPERV;
-                case brand_enum::SIMPLEVISOR: return VM::brands::SIMPLEVISOR;
-                case brand_enum::HYPERV_ROOT: return VM::brands::HYPERV_ROOT;
-                case brand_enum::UML: return VM::brands::UML;
-                case brand_enum::POWERVM: return VM::brands::POWERVM;
-                case brand_enum::GCE: return VM::brands::GCE;
-                case brand_enum::OPENSTACK: return VM::brands::OPENSTACK;
-                case brand_enum::KUBEVIRT: return VM::brands::KUBEVIRT;
-                case brand_enum::AWS_NITRO: return VM::brands::AWS_NITRO;
-                case brand_enum::PODMAN: return VM::brands::PODMAN;
-                case brand_enum::WSL: return VM::brands::WSL;
-                case brand_enum::OPENVZ: return VM::brands::OPENVZ;
-                case brand_enum::BAREVISOR: return VM::brands::BAREVISOR;
-                case brand_enum::HYPERPLATFORM: return VM::brands::HYPERPLATFORM;
-                case brand_enum::MINIVISOR: return VM::brands::MINIVISOR;
-                case brand_enum::INTEL_TDX: return VM::brands::INTEL_TDX;
-                case brand_enum::LKVM: return VM::brands::LKVM;
-                case brand_enum::AMD_SEV: return VM::brands::AMD_SEV;
-                case brand_enum::AMD_SEV_ES: return VM::brands::AMD_SEV_ES;
-                case brand_enum::AMD_SEV_SNP: return VM::brands::AMD_SEV_SNP;
-                case brand_enum::NEKO_PROJECT: return VM::brands::NEKO_PROJECT;
-                case brand_enum::NOIRVISOR: return VM::brands::NOIRVISOR;
-                case brand_enum::QIHOO: return VM::brands::QIHOO;
-                case brand_enum::DBVM: return VM::brands::DBVM;
-                case brand_enum::UTM: return VM::brands::UTM;
-                case brand_enum::COMPAQ: return VM::brands::COMPAQ;
-                case brand_enum::INSIGNIA: return VM::brands::INSIGNIA;
-                case brand_enum::CONNECTIX: return VM::brands::CONNECTIX;
-                case brand_enum::CONTAINERD: return VM::brands::CONTAINERD;
-                case brand_enum::NULL_BRAND: return VM::brands::NULL_BRAND; // do not modify placement of this, it's used as an anchor point to count the number of brands
+                for (size_t i = 0; i < size; ++i) {
+                    state = transitions[(state * class_count) + byte_class[data[i]]];
+                    found |= outputs[state];
+                }
+
+                return found;
             }
 
-            return "Invalid";
+        private:
+            u16 add_state() {
+                transitions.resize(transitions.size() + class_count, static_cast<u16>(NONE));
+                outputs.push_back(0);
+                return static_cast<u16>(outputs.size() - 1);
+            }
+        };
+
+        // the PCI devices VM::DEVICES looks for. The key is the vendor and the 16-bit device ID as 0xVVVVDDDD, 
+        // or WIDE | 0xVVVVDDDDDDDD for the devices with 32-bit device IDs
+        struct pci_id {
+            u64 key;
+            brand_enum brand; // NULL_BRAND for devices that don't point to one VM in particular
+            const char* kind;
+
+            static constexpr u64 WIDE = (1ULL << 63);
+        };
+
+        [[nodiscard]] static const std::vector<pci_id>& known_pci_ids() {
+            static constexpr const char* VIRTIO = "Red Hat + Virtio device";
+            static constexpr const char* VMWARE_DEVICE = "VMWARE device";
+            static constexpr const char* REDHAT_QEMU = "Red Hat + QEMU device";
+            static constexpr const char* QEMU_DEVICE = "QEMU device";
+            static constexpr const char* VIRTUAL_GPU = "virtual gpu device";
+            static constexpr const char* VBOX_DEVICE = "VirtualBox device";
+            static constexpr const char* PARALLELS_DEVICE = "Parallels device";
+            static constexpr const char* XEN_DEVICE = "Xen device";
+            static constexpr const char* VPC_DEVICE = "VirtualPC device";
+            static constexpr const char* HYPERVISOR_ROM = "Hypervisor ROM interface";
+
+            static const std::vector<pci_id> ids = {
+                // Red Hat + Virtio
+                { 0x1af40022, brand_enum::NULL_BRAND, VIRTIO }, { 0x1af41000, brand_enum::NULL_BRAND, VIRTIO }, { 0x1af41001, brand_enum::NULL_BRAND, VIRTIO },
+                { 0x1af41002, brand_enum::NULL_BRAND, VIRTIO }, { 0x1af41003, brand_enum::NULL_BRAND, VIRTIO }, { 0x1af41004, brand_enum::NULL_BRAND, VIRTIO },
+                { 0x1af41005, brand_enum::NULL_BRAND, VIRTIO }, { 0x1af41009, brand_enum::NULL_BRAND, VIRTIO }, { 0x1af41041, brand_enum::NULL_BRAND, VIRTIO },
+                { 0x1af41042, brand_enum::NULL_BRAND, VIRTIO }, { 0x1af41043, brand_enum::NULL_BRAND, VIRTIO }, { 0x1af41044, brand_enum::NULL_BRAND, VIRTIO },
+                { 0x1af41045, brand_enum::NULL_BRAND, VIRTIO }, { 0x1af41048, brand_enum::NULL_BRAND, VIRTIO }, { 0x1af41049, brand_enum::NULL_BRAND, VIRTIO },
+                { 0x1af41050, brand_enum::NULL_BRAND, VIRTIO }, { 0x1af41052, brand_enum::NULL_BRAND, VIRTIO }, { 0x1af41053, brand_enum::NULL_BRAND, VIRTIO },
+                { 0x1af4105a, brand_enum::NULL_BRAND, VIRTIO }, { 0x1af41100, brand_enum::NULL_BRAND, VIRTIO }, { 0x1af41110, brand_enum::NULL_BRAND, VIRTIO },
+                { 0x1af41b36, brand_enum::NULL_BRAND, VIRTIO },
+
+                // VMware
+                { 0x15ad0710, brand_enum::VMWARE, VMWARE_DEVICE }, { 0x15ad0720, brand_enum::VMWARE, VMWARE_DEVICE }, { 0x15ad0770, brand_enum::VMWARE, VMWARE_DEVICE },
+                { 0x15ad0774, brand_enum::VMWARE, VMWARE_DEVICE }, { 0x15ad0778, brand_enum::VMWARE, VMWARE_DEVICE }, { 0x15ad0779, brand_enum::VMWARE, VMWARE_DEVICE },
+                { 0x15ad0790, brand_enum::VMWARE, VMWARE_DEVICE }, { 0x15ad07a0, brand_enum::VMWARE, VMWARE_DEVICE }, { 0x15ad07b0, brand_enum::VMWARE, VMWARE_DEVICE },
+                { 0x15ad07c0, brand_enum::VMWARE, VMWARE_DEVICE }, { 0x15ad07e0, brand_enum::VMWARE, VMWARE_DEVICE }, { 0x15ad07f0, brand_enum::VMWARE, VMWARE_DEVICE },
+                { 0x15ad0801, brand_enum::VMWARE, VMWARE_DEVICE }, { 0x15ad0820, brand_enum::VMWARE, VMWARE_DEVICE }, { 0x15ad1977, brand_enum::VMWARE, VMWARE_DEVICE },
+                { 0xfffe0710, brand_enum::VMWARE, VMWARE_DEVICE }, { 0x0e0f0001, brand_enum::VMWARE, VMWARE_DEVICE }, { 0x0e0f0002, brand_enum::VMWARE, VMWARE_DEVICE },
+                { 0x0e0f0003, brand_enum::VMWARE, VMWARE_DEVICE }, { 0x0e0f0004, brand_enum::VMWARE, VMWARE_DEVICE }, { 0x0e0f0005, brand_enum::VMWARE, VMWARE_DEVICE },
+                { 0x0e0f0006, brand_enum::VMWARE, VMWARE_DEVICE }, { 0x0e0f000a, brand_enum::VMWARE, VMWARE_DEVICE }, { 0x0e0f8001, brand_enum::VMWARE, VMWARE_DEVICE },
+                { 0x0e0f8002, brand_enum::VMWARE, VMWARE_DEVICE }, { 0x0e0f8003, brand_enum::VMWARE, VMWARE_DEVICE }, { 0x0e0ff80a, brand_enum::VMWARE, VMWARE_DEVICE },
+
+                // Red Hat + QEMU
+                { 0x1b360001, brand_enum::QEMU, REDHAT_QEMU }, { 0x1b360002, brand_enum::QEMU, REDHAT_QEMU }, { 0x1b360003, brand_enum::QEMU, REDHAT_QEMU },
+                { 0x1b360004, brand_enum::QEMU, REDHAT_QEMU }, { 0x1b360005, brand_enum::QEMU, REDHAT_QEMU }, { 0x1b360008, brand_enum::QEMU, REDHAT_QEMU },
+                { 0x1b360009, brand_enum::QEMU, REDHAT_QEMU }, { 0x1b36000b, brand_enum::QEMU, REDHAT_QEMU }, { 0x1b36000c, brand_enum::QEMU, REDHAT_QEMU },
+                { 0x1b36000d, brand_enum::QEMU, REDHAT_QEMU }, { 0x1b360010, brand_enum::QEMU, REDHAT_QEMU }, { 0x1b360011, brand_enum::QEMU, REDHAT_QEMU },
+                { 0x1b360013, brand_enum::QEMU, REDHAT_QEMU }, { 0x1b360100, brand_enum::QEMU, REDHAT_QEMU },
+
+                // QEMU
+                { 0x06270001, brand_enum::QEMU, QEMU_DEVICE }, { 0x1d1d1f1f, brand_enum::QEMU, QEMU_DEVICE }, { 0x80865845, brand_enum::QEMU, QEMU_DEVICE },
+                { 0x1d6b0200, brand_enum::QEMU, QEMU_DEVICE },
+
+                // vGPUs (NVIDIA + others)
+                { 0x10de0fe7, brand_enum::NULL_BRAND, VIRTUAL_GPU }, { 0x10de0ff7, brand_enum::NULL_BRAND, VIRTUAL_GPU }, { 0x10de118d, brand_enum::NULL_BRAND, VIRTUAL_GPU },
+                { 0x10de11b0, brand_enum::NULL_BRAND, VIRTUAL_GPU }, { 0x1ec6020f, brand_enum::NULL_BRAND, VIRTUAL_GPU },
+
+                // VirtualBox
+                { 0x80ee0021, brand_enum::VBOX, VBOX_DEVICE }, { 0x80ee0022, brand_enum::VBOX, VBOX_DEVICE }, { 0x80eebeef, brand_enum::VBOX, VBOX_DEVICE },
+                { 0x80eecafe, brand_enum::VBOX, VBOX_DEVICE },
+
+                // Parallels
+                { 0x1ab84000, brand_enum::PARALLELS, PARALLELS_DEVICE }, { 0x1ab84005, brand_enum::PARALLELS, PARALLELS_DEVICE }, { 0x1ab84006, brand_enum::PARALLELS, PARALLELS_DEVICE },
+
+                // Xen
+                { 0x5853c000, brand_enum::XEN, XEN_DEVICE }, { 0xfffd0101, brand_enum::XEN, XEN_DEVICE }, { 0x5853c147, brand_enum::XEN, XEN_DEVICE },
+                { 0x5853c110, brand_enum::XEN, XEN_DEVICE }, { 0x5853c200, brand_enum::XEN, XEN_DEVICE }, { 0x58530001, brand_enum::XEN, XEN_DEVICE },
+
+                // Connectix (VirtualPC)
+                { 0x29556e61, brand_enum::VPC, VPC_DEVICE },
+
+                // devices with 32 bit device ids
+                { pci_id::WIDE | 0x000011061100, brand_enum::QEMU, QEMU_DEVICE }, { pci_id::WIDE | 0x00001af41100, brand_enum::QEMU, QEMU_DEVICE },
+                { pci_id::WIDE | 0x00001b361100, brand_enum::QEMU, QEMU_DEVICE }, { pci_id::WIDE | 0x000010ec1100, brand_enum::QEMU, QEMU_DEVICE },
+                { pci_id::WIDE | 0x000010331100, brand_enum::QEMU, QEMU_DEVICE }, { pci_id::WIDE | 0x000080861100, brand_enum::QEMU, QEMU_DEVICE },
+                { pci_id::WIDE | 0x000010131100, brand_enum::QEMU, QEMU_DEVICE }, { pci_id::WIDE | 0x0000106b1100, brand_enum::QEMU, QEMU_DEVICE },
+                { pci_id::WIDE | 0x000010221100, brand_enum::QEMU, QEMU_DEVICE },
+                // Hypervisor ROM Interface
+                { pci_id::WIDE | 0x000015ad0800, brand_enum::VMWARE, HYPERVISOR_ROM }
+            };
+
+            return ids;
         }
 
-        static std::string fetch_brand_name(const brand_list_t& list, const size_t index) {
-            return brand_enum_to_string(list.at(index).first);
+
+    #if (LINUX)
+        // the few SMBIOS fields the techniques care about, see util::smbios()
+        struct smbios_info {
+            bool from_tables = false; // decoded from the raw tables instead of the kernel's DMI attributes
+            bool has_vm_bit = false;
+            bool vm_bit = false;
+            u8 chassis_type = 0;
+            std::string bios_vendor;
+            std::string sys_vendor;
+            std::string product_name;
+            std::string product_version;
+            std::string product_family;
+            std::string product_sku;
+            std::string board_vendor;
+            std::string board_name;
+            std::string chassis_vendor;
+            std::string chassis_asset_tag;
         };
-    
-        static std::string brand_multiple(const flagset& flags = core::generate_default()) {
-            if (memo::multi_brand::is_cached()) {
-                return memo::multi_brand::fetch();
+
+        // the string a structure refers to by its 1-based index, 0 means there isn't one
+        [[nodiscard]] static std::string smbios_string(const u8* strings, const u8* end, const u8 index) {
+            if (index == 0) {
+                return "";
             }
 
-            const brand_list_t& list = brands::brand_list(flags);
-            const std::string& buffer = brand_multiple(list);
+            const u8* current = strings;
 
-            memo::multi_brand::store(buffer);
-            return buffer;
-        }
-            
-        static std::string brand_multiple(const brand_list_t& list) {
-            std::string buffer = {};
-            buffer += brands::fetch_brand_name(list, 0);
+            for (u8 i = 1; (i < index) && (current < end); ++i) {
+                while ((current < end) && (*current != 0)) {
+                    ++current;
+                }
 
-            for (size_t i = 1; i < list.size(); i++) {
-                buffer += " or "; 
-                buffer += brands::fetch_brand_name(list, i);
+                if (current < end) {
+                    ++current;
+                }
             }
 
-            return buffer;
-        }
+            const u8* string_end = current;
 
-        static brand_enum brand_single(const flagset& flags = core::generate_default()) {
-            if (memo::single_brand::is_cached()) {
-                return memo::single_brand::fetch();
+            while ((string_end < end) && (*string_end != 0)) {
+                ++string_end;
             }
 
-            const brand_list_t& list = brands::brand_list(flags);
-            const enum brand_enum brand = brand_single(list);
-    
-            memo::single_brand::store(brand);
+            if (current >= string_end) {
+                return "";
+            }
 
-            return brand;
+            return std::string(reinterpret_cast<const char*>(current), static_cast<size_t>(string_end - current));
         }
 
-        static enum brand_enum brand_single(const brand_list_t& list) {
-            const brand_element_t brand = list.front();
-            return brand.first;
-        }
-    };
+        // decodes the BIOS (0), system (1), baseboard (2) and chassis (3) structures, only the first of each counts
+        static bool parse_smbios(const std::vector<u8>& table, smbios_info& info) {
+            const u8* position = table.data();
+            const u8* const end = table.data() + table.size();
+            u8 found = 0;
 
-// START OF PRIVATE VM DETECTION TECHNIQUE DEFINITIONS
+            while ((position + 4) <= end) {
+                const u8 type = position[0];
+                const u8 length = position[1];
 
-#if (MSVC)
-    #pragma region "x86"
-#endif
+                if ((length < 4) || ((position + length) > end) || (type == 127)) {
+                    break;
+                }
 
-#if 1 //  meant for closing this whole section in the IDE
-    /**
-     * @brief Check CPUID output of manufacturer ID for known VMs/hypervisors at leaf 0 and 0x40000000-0x40000100
-     * @category x86
-     * @implements VM::VMID
-     */
-     [[nodiscard]] static bool vmid() {
-    #if (!x86)
-        return false;
-    #else
-        return (
-            cpu::vmid_template(0) ||
-            cpu::vmid_template(cpu::leaf::hypervisor) || // 0x40000000
-            cpu::vmid_template(cpu::leaf::hypervisor + 0x100) // 0x40000100
-        );
-    #endif
-    }
+                const u8* const strings = position + length;
+                const u8* next = strings;
 
+                // the string set ends with two null bytes
+                while (((end - next) >= 2) && ((next[0] != 0) || (next[1] != 0))) {
+                    ++next;
+                }
 
-    /**
-     * @brief Check if CPU brand model contains any VM-specific string snippets
-     * @category x86
-     * @implements VM::CPU_BRAND
-     */
-    [[nodiscard]] static bool cpu_brand() {
-    #if (!x86)
-        return false;
-    #else
-        const std::string& brand = cpu::get_brand();
+                // truncated table, the strings of this structure and everything after it are cut off
+                if ((end - next) < 2) {
+                    break;
+                }
 
-        // easy shortcut for QEMU
-        if (brand.rfind("QEMU Virtual CPU version", 0) == 0) {
-            return core::add(brand_enum::QEMU);
-        }
+                next += 2;
 
-        struct cstrview {
-            const char* data;
-            std::size_t size;
-            constexpr cstrview(const char* d, std::size_t s) noexcept
-                : data(d), size(s) {
-            }
-        };
+                auto field = [&](const u8 offset) -> u8 {
+                    return ((offset < length) ? position[offset] : 0);
+                };
 
-        static constexpr std::array<cstrview, 10> checks{ {
-            { "qemu",       4 },
-            { "kvm",        3 },
-            { "vbox",       4 },
-            { "virtualbox", 10},
-            { "monitor",    7 },
-            { "bhyve",      5 },
-            { "hypervisor", 10},
-            { "hvisor",     6 },
-            { "parallels",  9 },
-            { "vmware",     6 }
-        } };
+                auto text = [&](const u8 offset) -> std::string {
+                    return smbios_string(strings, next, field(offset));
+                };
 
-        for (auto& v : checks) {
-            if (brand.size() < v.size) {
-                continue;  // too short to match
+                if ((type <= 3) && !(found & (1u << type))) {
+                    found = static_cast<u8>(found | (1u << type));
+
+                    switch (type) {
+                        case 0:
+                            info.bios_vendor = text(0x04);
+                            info.has_vm_bit = (length > 0x13);
+                            info.vm_bit = ((field(0x13) & (1 << 4)) != 0);
+                            break;
+                        case 1:
+                            info.sys_vendor = text(0x04);
+                            info.product_name = text(0x05);
+                            info.product_version = text(0x06);
+                            info.product_sku = text(0x19);
+                            info.product_family = text(0x1A);
+                            break;
+                        case 2:
+                            info.board_vendor = text(0x04);
+                            info.board_name = text(0x05);
+                            break;
+                        case 3:
+                            info.chassis_vendor = text(0x04);
+                            info.chassis_type = static_cast<u8>(field(0x05) & 0x7F);
+                            info.chassis_asset_tag = text(0x08);
+                            break;
+                    }
+                }
+
+                position = next;
             }
 
-            if (brand.find(v.data) != std::string::npos) {
-                debug("CPU_BRAND: match = ", v.data);
+            return (found != 0);
+        }
 
-                // For these, we only care that it's virtualized:
-                if (v.size == 7  // "monitor"
-                    || ((v.size == 6) && (v.data[0] == 'h'))  // "hvisor"
-                    || ((v.size == 10) && (v.data[0] == 'h')) // "hypervisor" 
-                ) {
-                    return true;
-                }
+        // the structure table size announced by the entry point, 0 if it can't be read
+        [[nodiscard]] static size_t smbios_table_size() {
+            const std::vector<u8> entry = read_file_binary("/sys/firmware/dmi/tables/smbios_entry_point");
 
-                // Otherwise map to our enums:
-                switch (v.size) {
-                case 4:  // "qemu" or "vbox"
-                    return core::add(v.data[0] == 'q'
-                        ? brand_enum::QEMU
-                        : brand_enum::VBOX);
-                case 3:  // "kvm"
-                    return core::add(brand_enum::KVM);
-                case 5:  // "bhyve"
-                    return core::add(brand_enum::BHYVE);
-                case 9:  // "parallels"
-                    return core::add(brand_enum::PARALLELS);
-                case 10: // "virtualbox"
-                    return core::add(brand_enum::VBOX);
-                case 6:  // "vmware"
-                    return core::add(brand_enum::VMWARE);
-                default:
-                    return false;
-                }
+            // 64-bit "_SM3_" entry point, the size is a maximum
+            if ((entry.size() >= 0x10) && (std::memcmp(entry.data(), "_SM3_", 5) == 0)) {
+                u32 size = 0;
+                std::memcpy(&size, entry.data() + 0x0C, sizeof(size));
+                return size;
+            }
+
+            // 32-bit "_SM_" entry point
+            if ((entry.size() >= 0x18) && (std::memcmp(entry.data(), "_SM_", 4) == 0)) {
+                u16 size = 0;
+                std::memcpy(&size, entry.data() + 0x16, sizeof(size));
+                return size;
             }
+
+            return 0;
         }
 
-        return false;
-    #endif
-    }
+        // the kernel's DMI attributes are readable without root, they just miss the raw BIOS characteristics
+        static void read_dmi_attributes(smbios_info& info) {
+            auto attribute = [](const char* path) -> std::string {
+                std::string content = read_file(path);
 
+                while (!content.empty() && ((content.back() == '\n') || (content.back() == ' '))) {
+                    content.pop_back();
+                }
 
-    /**
-     * @brief Check if hypervisor feature bit in CPUID ECX bit 31 is enabled (always false for physical CPUs)
-     * @category x86
-     * @implements VM::HYPERVISOR_BIT
-     */
-    [[nodiscard]] static bool hypervisor_bit() {
-    #if (!x86)
-        return false;
-    #else
-        u32 eax = 0;
-        u32 ebx = 0; 
-        u32 ecx = 0; 
-        u32 edx = 0;
+                return content;
+            };
 
-        cpu::cpuid(eax, ebx, ecx, edx, 1); 
-        constexpr u32 HYPERVISOR_MASK = (1u << 31);
+            info.bios_vendor = attribute("/sys/class/dmi/id/bios_vendor");
+            info.sys_vendor = attribute("/sys/class/dmi/id/sys_vendor");
+            info.product_name = attribute("/sys/class/dmi/id/product_name");
+            info.product_version = attribute("/sys/class/dmi/id/product_version");
+            info.product_family = attribute("/sys/class/dmi/id/product_family");
+            info.product_sku = attribute("/sys/class/dmi/id/product_sku");
+            info.board_vendor = attribute("/sys/class/dmi/id/board_vendor");
+            info.board_name = attribute("/sys/class/dmi/id/board_name");
+            info.chassis_vendor = attribute("/sys/class/dmi/id/chassis_vendor");
+            info.chassis_asset_tag = attribute("/sys/class/dmi/id/chassis_asset_tag");
+
+            const std::string chassis_type = attribute("/sys/class/dmi/id/chassis_type");
+            info.chassis_type = static_cast<u8>(std::strtoul(chassis_type.c_str(), nullptr, 10));
+        }
+
+        // decoded once per process and shared by every technique that looks at SMBIOS, 
+        // since the firmware tables can't change without a reboot
+        [[nodiscard]] static const smbios_info& smbios() {
+            static const smbios_info info = []() {
+                smbios_info result;
+                std::vector<u8> table = read_file_binary("/sys/firmware/dmi/tables/DMI");
+                const size_t announced_size = smbios_table_size();
+
+                if ((announced_size != 0) && (announced_size < table.size())) {
+                    table.resize(announced_size);
+                }
 
-        if (ecx & HYPERVISOR_MASK) {
-            // if hypervisor bit is enabled, but we're in a root partition, prevent it from flagging
-            if (util::hyper_x() == HYPERV_ARTIFACT_VM) {
-                return false;
-            }
+                if (parse_smbios(table, result)) {
+                    result.from_tables = true;
+                    debug("SMBIOS: decoded ", table.size(), " bytes of structures");
+                } else {
+                    read_dmi_attributes(result);
+                    debug("SMBIOS: tables not readable, using the DMI attributes");
+                }
 
-            return true;
-        }
+                return result;
+            }();
 
-        // if hypervisor bit is disabled, but vmaware detects hyper-v signals, we're in an impossible situation (patching)
-        if (util::hyper_x() == HYPERV_ARTIFACT_VM) {
-            return true;
-        }
+            return info;
+        }
+
+        // the VM vendors looked for in the SMBIOS strings, in the order DMI_SCAN goes through them
+        enum dmi_vendor : u8 {
+            DMI_KVM,
+            DMI_OPENSTACK,
+            DMI_KUBEVIRT,
+            DMI_AMAZON_EC2,
+            DMI_QEMU,
+            DMI_VMWARE,
+            DMI_INNOTEK,
+            DMI_VIRTUALBOX,
+            DMI_ORACLE,
+            DMI_BOCHS,
+            DMI_PARALLELS,
+            DMI_BHYVE,
+            DMI_HYPERV,
+            DMI_APPLE_VZ,
+            DMI_GCE,
+            DMI_VENDOR_COUNT
+        };
 
-        return false;
-    #endif
-    }
+        [[nodiscard]] static const std::array<std::pair<const char*, brand_enum>, DMI_VENDOR_COUNT>& dmi_vendors() {
+            static const std::array<std::pair<const char*, brand_enum>, DMI_VENDOR_COUNT> vendors{ {
+                { "kvm", brand_enum::KVM },
+                { "openstack", brand_enum::OPENSTACK },
+                { "kubevirt", brand_enum::KUBEVIRT },
+                { "amazon ec2", brand_enum::AWS_NITRO },
+                { "qemu", brand_enum::QEMU },
+                { "vmware", brand_enum::VMWARE },
+                { "innotek gmbh", brand_enum::VBOX },
+                { "virtualbox", brand_enum::VBOX },
+                { "oracle corporation", brand_enum::VBOX },
+                { "bochs", brand_enum::BOCHS },
+                { "parallels", brand_enum::PARALLELS },
+                { "bhyve", brand_enum::BHYVE },
+                { "hyper-v", brand_enum::HYPERV },
+                { "apple virtualization", brand_enum::APPLE_VZ },
+                { "google compute engine", brand_enum::GCE }
+            } };
+
+            return vendors;
+        }
+
+        // bit i is set if the field contains dmi_vendors()[i] in any case
+        struct smbios_matches {
+            u32 bios_vendor = 0;
+            u32 board_name = 0;
+            u32 board_vendor = 0;
+            u32 chassis_asset_tag = 0;
+            u32 chassis_vendor = 0;
+            u32 product_family = 0;
+            u32 product_sku = 0;
+            u32 sys_vendor = 0;
+        };
 
+        // every SMBIOS string goes through one case-insensitive automaton of all the vendors a single time,
+        // once per process since util::smbios() doesn't change either
+        [[nodiscard]] static const smbios_matches& smbios_vendors() {
+            static const smbios_matches matches = []() {
+                std::array<const char*, DMI_VENDOR_COUNT> names{};
 
-    /**
-     * @brief Check for hypervisor brand string length (would be around 2 characters in a host machine)
-     * @category x86
-     * @implements VM::HYPERVISOR_STR
-     */
-    [[nodiscard]] static bool hypervisor_str() {
-    #if (!x86)
-        return false;
-    #else
-        if (util::hyper_x() == HYPERV_ARTIFACT_VM) {
-            return false;
-        }
+                for (size_t i = 0; i < names.size(); ++i) {
+                    names[i] = dmi_vendors()[i].first;
+                }
 
-        char out[(sizeof(i32) * 4) + 1] = { 0 }; // e*x size + number of e*x registers + null terminator
-        cpu::cpuid(reinterpret_cast<int*>(out), cpu::leaf::hypervisor);
+                const pattern_matcher matcher(names.data(), names.size(), true);
 
-        debug("HYPERVISOR_STR: \neax: ", static_cast<u32>(out[0]),
-            "\nebx: ", static_cast<u32>(out[1]),
-            "\necx: ", static_cast<u32>(out[2]),
-            "\nedx: ", static_cast<u32>(out[3])
-        );
+                auto classify = [&matcher](const std::string& field) -> u32 {
+                    return static_cast<u32>(matcher.scan(reinterpret_cast<const u8*>(field.data()), field.size()));
+                };
 
-        return (std::strlen(out + 4) >= 4);
-    #endif  
-    }
-    
+                const smbios_info& info = smbios();
+                smbios_matches result;
 
-    /**
-     * @brief Check for various Bochs-related emulation oversights through CPU checks
-     * @category x86
-     * @author Discovered by Peter Ferrie, Senior Principal Researcher, Symantec Advanced Threat Research peter_ferrie@symantec.com
-     * @implements VM::BOCHS_CPU
-     */
-    [[nodiscard]] static bool bochs_cpu() {
-    #if (!x86)
-        return false;
-    #else
-        const bool intel = cpu::is_intel();
-        const bool amd = cpu::is_amd();
+                result.bios_vendor = classify(info.bios_vendor);
+                result.board_name = classify(info.board_name);
+                result.board_vendor = classify(info.board_vendor);
+                result.chassis_asset_tag = classify(info.chassis_asset_tag);
+                result.chassis_vendor = classify(info.chassis_vendor);
+                result.product_family = classify(info.product_family);
+                result.product_sku = classify(info.product_sku);
+                result.sys_vendor = classify(info.sys_vendor);
 
-        // if neither amd or intel, return false
-        if (!(intel || amd)) {
-            debug("BOCHS_CPU: neither AMD or Intel detected, returned false");
-            return false;
-        }
+                return result;
+            }();
 
-        const std::string brand = cpu::get_brand();
+            return matches;
+        }
+
+        // the strings VM::FIRMWARE looks for in the ACPI tables, and the brand each one points to (NULL_BRAND 
+        // for the ones that only tell it's a VM). If a table has several of them, the first one in the list wins
+        [[nodiscard]] static const std::vector<std::pair<const char*, brand_enum>>& firmware_targets() {
+            static const std::vector<std::pair<const char*, brand_enum>> targets = {
+                { "Parallels Software", brand_enum::PARALLELS },
+                { "Parallels(R)", brand_enum::PARALLELS },
+                { "innotek", brand_enum::VBOX },
+                { "Oracle", brand_enum::VBOX },
+                { "VirtualBox", brand_enum::VBOX },
+                { "vbox", brand_enum::VBOX },
+                { "VBOX", brand_enum::VBOX },
+                { "VMware, Inc.", brand_enum::VMWARE },
+                { "VMware", brand_enum::VMWARE },
+                { "VMWARE", brand_enum::VMWARE },
+                { "VMW0003", brand_enum::NULL_BRAND },
+                { "QEMU", brand_enum::QEMU },
+                { "pc-q35", brand_enum::NULL_BRAND },
+                { "Q35 +", brand_enum::NULL_BRAND },
+                { "FWCF", brand_enum::NULL_BRAND },
+                { "BOCHS", brand_enum::BOCHS },
+                { "ovmf", brand_enum::NULL_BRAND },
+                { "edk ii unknown", brand_enum::NULL_BRAND },
+                { "S3 Corp.", brand_enum::NULL_BRAND },
+                { "Virtual Machine", brand_enum::NULL_BRAND },
+                { "VS2005R2", brand_enum::NULL_BRAND },
+                { "Xen", brand_enum::NULL_BRAND }
+            };
 
-        if (intel) {
-            // technique 1: not a valid brand 
-            if (brand == "              Intel(R) Pentium(R) 4 CPU        ") {
-                debug("BOCHS_CPU: technique 1 found");
-                return core::add(brand_enum::BOCHS);
-            }
-        } else if (amd) {
-            // technique 2: "processor" should have a capital P
-            if (brand == "AMD Athlon(tm) processor") {
-                debug("BOCHS_CPU: technique 2 found");
-                return core::add(brand_enum::BOCHS);
+            return targets;
+        }
+
+        // the ACPI tables of this detection run, listed once per run like every other file the techniques 
+        // share. Outside of a run they're listed on every call. Only the headers are kept, so it's cheap to 
+        // copy. Needs root, without it the index is just empty
+        [[nodiscard]] static acpi_table_index acpi_tables() {
+            if (active_file_cache != nullptr) {
+                file_cache& cache = *active_file_cache;
+                std::call_once(cache.acpi_indexed, [&cache]() { cache.acpi = index_acpi_tables(); });
+                return cache.acpi;
             }
 
-            // technique 3: Check for absence of AMD easter egg for K7 and K8 CPUs
-            constexpr u32 AMD_EASTER_EGG = 0x8fffffff; // this is the CPUID leaf of the AMD easter egg
+            return index_acpi_tables();
+        }
 
-            if (!cpu::is_leaf_supported(AMD_EASTER_EGG)) {
-                return false;
+        static acpi_table_index index_acpi_tables() {
+            acpi_table_index result;
+            const char* const directory = "/sys/firmware/acpi/tables/";
+
+            DIR* dir = opendir(directory);
+
+            if (dir == nullptr) {
+                debug("ACPI: could not open ACPI tables directory");
+                return result;
             }
 
-            u32 unused = 0;
-            u32 eax = 0;
-            cpu::cpuid(eax, unused, unused, unused, 1);
+            const int dir_fd = dirfd(dir);
 
-            auto is_k7 = [](const u32 eax) noexcept -> bool {
-                if ((eax & 0x0FF00F00) != 0x00000600) {
-                    return false;
+            while (const struct dirent* ent = readdir(dir)) {
+                if (ent->d_name[0] == '.') {
+                    continue;
                 }
 
-                const u32 model = (eax >> 4) & 0xF;
-
-                return (model - 1) < 4;
-            };
+                const int fd = openat(dir_fd, ent->d_name, O_RDONLY | O_CLOEXEC);
 
-            auto is_k8 = [](const u32 eax) noexcept -> bool {
-                if (((eax >> 8) & 0xF) != 0xF) {
-                    return false;
+                if (fd < 0) {
+                    continue;
                 }
 
-                const u32 extended_family = (eax >> 20) & 0xFF;
+                acpi_table table;
+                struct stat info{};
 
-                return extended_family <= 1;
-            };
+                if ((fstat(fd, &info) == 0) && S_ISREG(info.st_mode)) {
+                    const ssize_t n = pread(fd, table.header.data(), table.header.size(), 0);
+                    table.header_size = ((n > 0) ? static_cast<size_t>(n) : 0);
+                }
 
-            if (!(is_k7(eax) || is_k8(eax))) {
-                return false;
-            }
+                close(fd);
 
-            u32 ecx_bochs = 0;
-            cpu::cpuid(unused, unused, ecx_bochs, unused, AMD_EASTER_EGG);
+                if (table.header_size < 8) {
+                    continue;
+                }
 
-            if (ecx_bochs == 0) {
-                return true;
-            }
-        }
+                std::memcpy(&table.length, table.header.data() + 4, sizeof(table.length));
+                table.name = ent->d_name;
+                table.path = std::string(directory) + ent->d_name;
 
-        return false;
-    #endif
-    }
-       
-    
-    /**
-	 * @brief Check if the system's thread count matches the expected thread count for the detected CPU model
-     * @category x86
-     * @implements VM::THREAD_MISMATCH
-     */
-    [[nodiscard]] static bool thread_mismatch() {
-    #if (!x86)
-        return false;
-    #else
-        auto is_smt_enabled = []() noexcept -> bool {
-        #if (WINDOWS)
-            DWORD len = 0;
-            if (GetLogicalProcessorInformationEx(RelationProcessorCore, nullptr, &len) ||
-                GetLastError() != ERROR_INSUFFICIENT_BUFFER) {
-                return false;
+                result.by_name.emplace(table.name, result.tables.size());
+                result.tables.push_back(std::move(table));
             }
 
-            std::vector<char> buf(static_cast<size_t>(len));
-            if (!GetLogicalProcessorInformationEx(RelationProcessorCore,
-                reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buf.data()), &len)) {
-                return false;
-            }
+            closedir(dir);
+            debug("ACPI: indexed ", result.tables.size(), " tables");
+            return result;
+        }
 
-            size_t offset = 0;
-            while (offset + sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX) <= static_cast<size_t>(len)) {
-                auto rec = reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buf.data() + offset);
+        // the kernel log lines the techniques care about, see util::kernel_log()
+        struct kernel_log_info {
+            bool readable = false;
+            bool hypervisor_detected = false; // the kernel's own "Hypervisor detected: ..." line
+            bool hypervisor_pattern = false;  // see VM::dmesg()
+            bool buslogic = false;            // VMware's emulated SCSI controller
+            bool pcnet32 = false;             // VMware's emulated network card
+        };
 
-                if (rec->Relationship == RelationProcessorCore) {
-                    const PROCESSOR_RELATIONSHIP& pr = rec->Processor;
-                    unsigned total = 0;
+        // true once every signature was found, so the rest of the log doesn't have to be looked at
+        static bool scan_kernel_log(const char* data, const size_t size, kernel_log_info& info) {
+            std::string line;
+            const char* const end = data + size;
 
-                    for (WORD i = 0; i < pr.GroupCount; ++i) {
-                        total += util::popcount(static_cast<u64>(pr.GroupMask[i].Mask));
-                    }
+            while (data < end) {
+                const char* line_end = static_cast<const char*>(std::memchr(data, '\n', static_cast<size_t>(end - data)));
 
-                    return total > 1;
+                if (line_end == nullptr) {
+                    line_end = end;
                 }
 
-                if (rec->Size == 0) break;
-                offset += rec->Size;
-            }
-            return false;
-        #elif (APPLE)
-            int logical = 0, physical = 0;
-            size_t sz = sizeof(logical);
-
-            if (sysctlbyname("hw.logicalcpu", &logical, &sz, nullptr, 0) != 0) {
-                logical = 0;
-            }
-
-            sz = sizeof(physical);
+                line.assign(data, line_end);
+                data = line_end + 1;
 
-            if (sysctlbyname("hw.physicalcpu", &physical, &sz, nullptr, 0) != 0) {
-                physical = 0;
-            }
+                info.hypervisor_detected = info.hypervisor_detected || find(line, "Hypervisor detected");
+                info.buslogic = info.buslogic || find(line, "BusLogic BT-958");
+                info.pcnet32 = info.pcnet32 || find(line, "pcnet32");
 
-            return logical > 0 && physical > 0 && logical > physical;
-        #else
-            std::ifstream f("/sys/devices/system/cpu/cpu0/topology/thread_siblings_list");
-            if (f) {
-                std::string s;
-                if (std::getline(f, s)) {
-                    size_t a = 0;
-                    while (a < s.size() && std::isspace(static_cast<u8>(s[a]))) {
-                        ++a;
-                    }
+                if (!info.hypervisor_pattern && find(line, "KVM|QEMU")) {
+                    std::transform(line.begin(), line.end(), line.begin(), [](const char c) { 
+                        return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); 
+                    });
 
-                    size_t b = s.size();
-                    while (b > a && std::isspace(static_cast<u8>(s[b - 1]))) {
-                        --b;
-                    }
+                    info.hypervisor_pattern = find(line, "hypervisor");
+                }
 
-                    if (b > a) {
-                        for (size_t k = a; k < b; ++k) {
-                            if (s[k] == ',' || s[k] == '-') {
-                                return true;
-                            }
-                        }
-                        return false;
-                    }
+                if (
+                    info.hypervisor_detected && 
+                    info.hypervisor_pattern && 
+                    info.buslogic && 
+                    info.pcnet32
+                ) {
+                    return true;
                 }
             }
 
-            std::ifstream cpuinfo("/proc/cpuinfo");
-            if (!cpuinfo) {
-                return false;
-            }
+            return false;
+        }
 
-            std::string line;
-            int processors = 0;
-            int cur_phys = -1;
-            int cur_core = -1;
-            std::vector<std::pair<int, int>> cores;
+        // the kernel ring buffer is read and scanned once per process for every technique that looks at it
+        [[nodiscard]] static const kernel_log_info& kernel_log() {
+            static const kernel_log_info info = []() {
+                kernel_log_info result;
 
-            while (std::getline(cpuinfo, line)) {
-                if (line.empty()) {
-                    if (cur_phys != -1 && cur_core != -1) {
-                        cores.emplace_back(cur_phys, cur_core);
+                // SYSLOG_ACTION_SIZE_BUFFER and SYSLOG_ACTION_READ_ALL, which don't clear anything
+                const int buffer_size = klogctl(10, nullptr, 0);
+
+                if (buffer_size > 0) {
+                    std::vector<char> buffer(static_cast<size_t>(buffer_size));
+                    const int length = klogctl(3, buffer.data(), buffer_size);
+
+                    if (length > 0) {
+                        result.readable = true;
+                        scan_kernel_log(buffer.data(), static_cast<size_t>(length), result);
+                        return result;
                     }
-                    cur_phys = cur_core = -1;
-                    continue;
                 }
 
-                auto pos = line.find(':');
-                if (pos == std::string::npos) {
-                    continue;
+                // same thing through /dev/kmsg, which hands out one record per read and EAGAIN once it's drained
+                const int fd = open("/dev/kmsg", O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+
+                if (fd < 0) {
+                    debug("KERNEL_LOG: ", "not readable");
+                    return result;
                 }
 
-                std::string key = line.substr(0, pos);
-                std::string val = line.substr(pos + 1);
+                char record[8192];
 
-                while (!key.empty() && std::isspace(static_cast<u8>(key.back()))) {
-                    key.pop_back();
-                }
+                while (true) {
+                    const ssize_t length = read(fd, record, sizeof(record));
 
-                while (!val.empty() && std::isspace(static_cast<u8>(val.front()))) {
-                    val.erase(val.begin());
-                }
+                    if (length > 0) {
+                        result.readable = true;
 
-                if (key == "processor") {
-                    processors++;
-                }
-                else if (key == "physical id") {
-                    try { cur_phys = std::stoi(val); }
-                    catch (...) { cur_phys = -1; }
-                }
-                else if (key == "core id") {
-                    try { cur_core = std::stoi(val); }
-                    catch (...) { cur_core = -1; }
+                        if (scan_kernel_log(record, static_cast<size_t>(length), result)) {
+                            break;
+                        }
+                    } else if ((length < 0) && (errno == EPIPE)) {
+                        continue; // the record got overwritten while reading, the next one is still there
+                    } else {
+                        break;
+                    }
                 }
-            }
 
-            if (cur_phys != -1 && cur_core != -1) {
-                cores.emplace_back(cur_phys, cur_core);
-            }
+                close(fd);
+                return result;
+            }();
 
-            if (!cores.empty() && processors > 0) {
-                std::sort(cores.begin(), cores.end());
-                cores.erase(std::unique(cores.begin(), cores.end()), cores.end());
-                const int physical_cores = static_cast<int>(cores.size());
-                return processors > physical_cores;
-            }
-            return false;
-        #endif
-        };
+            return info;
+        }
+    #endif
 
-        const auto& info = cpu::analyze_cpu();
-        
-        if (info.found) {
-            debug(info.debug_tag, ": CPU model = ", info.model_name);
 
-        #if (WINDOWS)
-            const char* manufacturer = "";
-            const char* model = "";
-            util::get_manufacturer_model(&manufacturer, &model);
-            debug(info.debug_tag, ": {\"manufacturer\": \"", manufacturer,
-                "\", \"model\": \"", model, "\"}");
+        // wrapper for std::make_unique because it's not available for C++11
+        template<typename T, typename... Args>
+        [[nodiscard]] static std::unique_ptr<T> make_unique(Args&&... args) {
+        #if (VMA_CPP < 14)
+            return std::unique_ptr<T>(new T(std::forward<Args>(args)...));
+        #else
+            return std::make_unique<T>(std::forward<Args>(args)...);
         #endif
+        }
 
-            const u32 actual = memo::threadcount::fetch();
 
-            if (actual != info.expected_threads) {
-                debug(info.debug_tag, ": Current threads -> ", actual);
-                const bool smt = is_smt_enabled();
+        [[nodiscard]] static bool is_admin() noexcept {
+        #if (LINUX || APPLE)
+            const uid_t uid = getuid();
+            const uid_t euid = geteuid();
 
-                if (smt) {
-                    debug(info.debug_tag, ": Expected ", info.expected_threads, " threads");
-                    return true;
+            return (
+                (uid != euid) ||
+                (euid == 0)
+            );
+        #elif (WINDOWS)
+            bool is_admin = false;
+            HANDLE hToken = nullptr;
+            const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
+            if (OpenProcessToken(current_process, TOKEN_QUERY, &hToken)) {
+                TOKEN_ELEVATION elevation{};
+                DWORD dwSize;
+                if (GetTokenInformation(hToken, TokenElevation, &elevation, sizeof(elevation), &dwSize)) {
+                    if (elevation.TokenIsElevated)
+                        is_admin = true;
                 }
-
-                debug(info.debug_tag, ": Expected ", info.expected_threads,
-                    " threads, but found SMT disabled");
-                return false;
+                CloseHandle(hToken);
             }
+            return is_admin;
+        #else
+            return true;
+        #endif
         }
 
-        return false;
-    #endif
-    }
-
 
-    /**
-     * @brief Check for CPUID signatures that reveal the presence of a hypervisor
-     * @category x86
-     * @implements VM::CPUID_SIGNATURE
-     */
-    [[nodiscard]] static bool cpuid_signature() {
-    #if (!x86)
-        return false;
-    #else
-        u32 eax = 0;
-        u32 ebx = 0;
-        u32 ecx = 0;
-        u32 edx = 0;
-        cpu::cpuid(eax, ebx, ecx, edx, 0x40000001);
+        [[nodiscard]] static bool find(const std::string& base_str, const char* keyword) noexcept {
+            return (base_str.find(keyword) != std::string::npos);
+        };
 
-        constexpr u32 simplevisor = 0x00766853; // " vhS"
+        [[nodiscard]] static i32 popcount(u64 v) {
+        #if (GCC) || (CLANG)
+            return __builtin_popcountll(v);
+        #elif (MSVC)
+        #if (x86_32)
+            return static_cast<int>(
+                __popcnt(static_cast<unsigned int>(v)) +
+                __popcnt(static_cast<unsigned int>(v >> 32))
+            );
+        #else
+            return static_cast<int>(__popcnt64(static_cast<unsigned long long>(v)));
+        #endif
+        #else
+            int c = 0;
+            while (v) { c += static_cast<int>(v & 1ull); v >>= 1; }
+            return c;
+        #endif
+        };
 
-        debug("CPUID_SIGNATURE: eax = ", eax);
+        static std::string narrow_wide(const wchar_t* wstr) {
+            if (!wstr) {
+                return {};
+            }
 
-        if (eax == simplevisor) {
-            return core::add(brand_enum::SIMPLEVISOR);
+            const std::wstring ws(wstr);
+            std::string result;
+            result.reserve(ws.size());
+            for (const wchar_t wc : ws) {
+                result.push_back((static_cast<uint32_t>(wc) < 128)
+                    ? static_cast<char>(wc)
+                    : '?');
+            }
+            return result;
         }
 
-        if (cpu::is_intel()) {
-            const bool has_leaf_b = cpu::is_leaf_supported(0x0B);
-            const bool has_leaf_1f = cpu::is_leaf_supported(0x1F);
-
-            // If neither extended topology leaf is supported, we can't perform the check
-            if (!has_leaf_b && !has_leaf_1f) {
-                return false;
-            }
+        // choose correct << or narrow for each type
+        static void write_arg_impl(std::ostream& os, const wchar_t* arg) {
+            os << narrow_wide(arg);
+        }
+        static void write_arg_impl(std::ostream& os, wchar_t* arg) {
+            os << narrow_wide(arg);
+        }
 
-            u32 l1_eax = 0;
-            u32 l1_ebx = 0; 
-            u32 l1_ecx = 0; 
-            u32 l1_edx = 0;
-            
-            u32 vb_eax = 0;
-            u32 vb_ebx = 0; 
-            u32 vb_ecx = 0; 
-            u32 vb_edx = 0;
-            
-            u32 v1f_eax = 0;
-            u32 v1f_ebx = 0; 
-            u32 v1f_ecx = 0; 
-            u32 v1f_edx = 0;
+        static void write_arg_impl(std::ostream& os, const std::wstring& ws) {
+            os << narrow_wide(ws.c_str());
+        }
 
-            u32 aba_start = 0;
-            u32 aba_end = 0;
+        // everything else that is not std::string or wchar_t
+        template <typename T>
+        static typename std::enable_if<!std::is_convertible<T, std::wstring>::value
+            && !std::is_same<typename std::decay<T>::type, wchar_t*>::value,
+            void>::type
+            write_arg_impl(std::ostream& os, T&& arg) {
+            os << std::forward<T>(arg);
+        }
 
-            u32 unused = 0;
-            int retries = 0;
+        // variadic pack printer for C++11
+        static void print_to_stream(std::ostream& /*unused*/) noexcept {}
 
-            // triple-read ABA pattern to detect thread migration and bounded to 8 retries
-            // leaf 1's Initial APIC ID is the ABA guard
-            for (;;) {
-                cpu::cpuid(l1_eax, l1_ebx, l1_ecx, l1_edx, 1, 0);
-                aba_start = (l1_ebx >> 24) & 0xFF; // Initial APIC ID
+        // forward the first, then expand the rest in an initializer list
+        template <typename T, typename... Args>
+        static void print_to_stream(std::ostream& os,
+            T&& first,
+            Args&&... args) noexcept
+        {
+            write_arg_impl(os, std::forward<T>(first));
+            // trick to expand the pack
+            using expander = int[];
+            (void)expander {
+                0, ((void)write_arg_impl(os, std::forward<Args>(args)), 0)...
+            };
+        }
 
-                if (has_leaf_b) {
-                    cpu::cpuid(vb_eax, vb_ebx, vb_ecx, vb_edx, 0x0B, 0);
-                }
+        // shared by every debug_msg() instantiation, techniques may log from worker threads with VM::PARALLEL
+        static std::mutex& debug_mutex() noexcept {
+            static std::mutex print_mutex;
+            return print_mutex;
+        }
 
-                if (has_leaf_1f) {
-                    cpu::cpuid(v1f_eax, v1f_ebx, v1f_ecx, v1f_edx, 0x1F, 0);
-                }
+        template <typename... Args>
+        static void debug_msg(Args&&... message) noexcept {
+            static std::unordered_set<std::string> printed_messages;
 
-                cpu::cpuid(unused, l1_ebx, unused, unused, 1, 0);
-                aba_end = (l1_ebx >> 24) & 0xFF;
+            std::stringstream ss;
+            print_to_stream(ss, std::forward<Args>(message)...);
+            std::string msg_content = ss.str();
 
-                if (aba_start == aba_end || ++retries >= 8) { break; }
-            }
+            const std::lock_guard<std::mutex> lock(debug_mutex());
 
-            // If we hit the retry limit and the thread is still migrating, 
-            // abort the check to prevent false positives
-            if (aba_start != aba_end) {
-                return false;
-            }
+            if (printed_messages.find(msg_content) == printed_messages.end()) {
+            #if (LINUX || APPLE)
+                constexpr const char* black_bg = "\x1B[48;2;0;0;0m";
+                constexpr const char* bold = "\033[1m";
+                constexpr const char* blue = "\x1B[38;2;00;59;193m";
+                constexpr const char* ansiexit = "\x1B[0m";
 
-            const u32 initial_apic_id = aba_start;
+                std::cerr.setf(std::ios::fixed, std::ios::floatfield);
+                std::cerr.setf(std::ios::showpoint);
 
-            // check Leaf 0x0B against Leaf 1
-            if (has_leaf_b) {
-                const u32 vb_level = (vb_ecx >> 8) & 0xFF;
+                std::cerr << black_bg
+                    << bold << "["
+                    << blue << "DEBUG"
+                    << ansiexit << bold << black_bg << "]"
+                    << ansiexit << " ";
+            #else
+                std::cerr << "[DEBUG] ";
+            #endif
+                std::cerr << msg_content;
+                std::cerr << std::dec << "\n";
 
-                if (vb_level != 0) {
-                    // if x2APIC ID is < 255, Initial APIC ID must match exactly
-                    if (vb_edx < 255 && (vb_edx & 0xFF) != initial_apic_id) {
-                        return true;
-                    }
-                }
+                printed_messages.insert(std::move(msg_content));
             }
+        }
 
-            // check Leaf 0x1F against Leaf 1, and cross-check with 0x0B
-            if (has_leaf_1f) {
-                const u32 v1f_level = (v1f_ecx >> 8) & 0xFF;
 
-                if (v1f_level != 0) {
-                    // if x2APIC ID is < 255, Initial APIC ID must match exactly
-                    if (v1f_edx < 255 && (v1f_edx & 0xFF) != initial_apic_id) {
-                        return true;
+        [[nodiscard]] static std::unique_ptr<std::string> sys_result(const char* cmd) {
+        #if (VMA_CPP < 14)
+            VMAWARE_UNUSED(cmd);
+            return util::make_unique<std::string>();
+        #else
+            #if (LINUX || APPLE)
+                struct file_deleter {
+                    void operator()(FILE* f) const noexcept {
+                        if (f) {
+                            pclose(f);
+                        };
                     }
+                };
 
-                    // cross-check 0x0B vs 0x1F if both are supported and valid
-                    if (has_leaf_b) {
-                        const u32 vb_level = (vb_ecx >> 8) & 0xFF;
-                        if (vb_level != 0 && vb_edx != v1f_edx) {
-                            return true;
-                        }
-                    }
+                std::unique_ptr<FILE, file_deleter> const pipe(popen(cmd, "r"), file_deleter()); // NOLINT(bugprone-command-processor)
+                if (!pipe) {
+                    return util::make_unique<std::string>();
                 }
-            }
-        }
-        else if (cpu::is_amd()) {
-            const bool has_leaf_7 = cpu::is_leaf_supported(7);
 
-            if (!has_leaf_7) {
-                return false;
-            }
+                std::string result;
+                char buf[4096];
+                while (std::fgets(buf, sizeof(buf), pipe.get()) != nullptr) {
+                    result.append(buf);
+                }
 
-            u32 l7_eax = 0;
-            u32 l7_ebx = 0;
-            u32 l7_ecx = 0;
-            u32 l7_edx = 0;
-            cpu::cpuid(l7_eax, l7_ebx, l7_ecx, l7_edx, 7, 0);
+                if (!result.empty() && result.back() == '\n') {
+                    result.pop_back();
+                }
 
-            // Intel enumerates hardware mitigations in Leaf 7.0.EDX:
-            // Bit 26: IBRS and IBPB
-            // Bit 27: STIBP
-            // Bit 31: SSBD
+                return util::make_unique<std::string>(std::move(result));
+            #else
+                VMAWARE_UNUSED(cmd);
+                return std::make_unique<std::string>();
+            #endif
+        #endif
+        }
 
-            // AMD processors strictly reserve these bits (force them to 0) 
-            // and instead enumerate their mitigations in Leaf 0x80000008.EBX
-            const bool has_intel_ibrs = (l7_edx & (1 << 26)) != 0;
-            const bool has_intel_stibp = (l7_edx & (1 << 27)) != 0;
-            const bool has_intel_ssbd = (l7_edx & (1 << 31)) != 0;
 
-            if (has_intel_ibrs || has_intel_stibp || has_intel_ssbd) {
-                return true;
+        [[nodiscard]] static bool is_proc_running(const char* executable) {
+        #if (LINUX)
+            if (active_file_cache != nullptr) {
+                return (swept_processes(*active_file_cache).count(executable) != 0);
             }
+
+            std::unordered_set<std::string> processes;
+            sweep_processes(processes);
+            return (processes.count(executable) != 0);
+        #else
+            VMAWARE_UNUSED(executable);
+            return false;
+        #endif
         }
 
-        return false;
-    #endif
-    }
-                
-                
-    /**
-     * @brief Check for Intel KGT (Trusty branch) hypervisor signature in CPUID
-     * @link https://github.com/intel/ikgt-core/blob/7dfd4d1614d788ec43b02602cce7a272ef8d5931/vmm/vmexit/vmexit_cpuid.c
-     * @category x86
-     * @implements VM::KGT_SIGNATURE
-     */
-    [[nodiscard]] static bool intel_kgt_signature() {
-    #if (!x86)
-        return false;
-    #else
-        u32 unused = 0;
-        u32 ecx = 0; 
-        u32 edx = 0;
-        cpu::cpuid(unused, unused, ecx, edx, 0x40000003);
+    #if (LINUX)
+        // the argv[0] basename of every process. Returned by value since outside of a run there's no 
+        // cache to keep it in, in which case /proc is swept on every call
+        [[nodiscard]] static std::unordered_set<std::string> running_processes() {
+            if (active_file_cache != nullptr) {
+                return swept_processes(*active_file_cache);
+            }
 
-        constexpr u32 ECX_SIG = 0x4D4D5645u; // 'EVMM' -> 0x4D4D5645
-        constexpr u32 EDX_SIG = 0x43544E49u; // 'INTC' -> 0x43544E49
+            std::unordered_set<std::string> processes;
+            sweep_processes(processes);
+            return processes;
+        }
 
-        if (ecx == ECX_SIG && edx == EDX_SIG) {
-            return core::add(brand_enum::INTEL_KGT);
+        // a single sweep of /proc per detection run, so that any number of process checks are just lookups
+        [[nodiscard]] static const std::unordered_set<std::string>& swept_processes(file_cache& cache) {
+            std::call_once(cache.processes_swept, [&cache]() { sweep_processes(cache.processes); });
+            return cache.processes;
         }
 
-        return false;
-    #endif
-    }
+        static void sweep_processes(std::unordered_set<std::string>& names) {
+            names.clear();
+            std::vector<char> buf;
 
+            #if (VMA_CPP >= 17)
+                std::error_code ec;
+                auto dir_iter = std::filesystem::directory_iterator("/proc", ec);
 
-    /**
-     * @brief Check for hypervisor overhead by measuring instruction execution latency
-     * @category Windows, x86
-     * @implements VM::TIMER
-     */
-    [[nodiscard]] static bool timer() {
-    #if (x86 && WINDOWS)
-        using timer = struct timer;
+                if (ec) {
+                    debug("util::sweep_processes: ", "failed to open /proc directory");
+                    return;
+                }
 
-        if (util::is_running_under_translator()) {
-            debug("TIMER: Running inside a binary translation layer");
-            return false;
+                for (const auto& entry : dir_iter) {
+                    if (!entry.is_directory(ec)) {
+                        continue;
+                    }
+
+                    const std::string filename = entry.path().filename().string();
+            #else
+                std::unique_ptr<DIR, decltype(&closedir)> dir(opendir("/proc"), closedir);
+                if (!dir) {
+                    debug("util::sweep_processes: ", "failed to open /proc directory");
+                    return;
+                }
+
+                struct dirent* entry;
+                while ((entry = readdir(dir.get())) != nullptr) {
+                    std::string filename(entry->d_name);
+                    if (filename == "." || filename == "..") {
+                        continue;
+                    }
+            #endif
+                if (!std::all_of(filename.begin(), filename.end(), [](u8 c) { return std::isdigit(c); })) {
+                    continue;
+                }
+
+                const std::string cmdline_file = "/proc/" + filename + "/cmdline";
+
+                // read raw bytes (binary) to preserve embedded NULs, into the same buffer for every process.
+                // Kernel threads have an empty cmdline and are left out
+                if (!util::read_into(cmdline_file.c_str(), buf) || buf.empty()) {
+                    continue;
+                }
+
+                // cmdline is argv0\0argv1\0..., so argv0 is bytes up to first NUL
+                const auto it_nul = std::find(buf.begin(), buf.end(), '\0');
+                if (it_nul == buf.begin()) {
+                    continue;
+                }
+
+                // extract basename of argv0
+                auto basename_begin = it_nul;
+                while ((basename_begin != buf.begin()) && (*(basename_begin - 1) != '/')) {
+                    --basename_begin;
+                }
+
+                if (basename_begin != it_nul) {
+                    names.emplace(basename_begin, it_nul);
+                }
+            }
+
+            debug("util::sweep_processes: ", names.size(), " distinct process names");
         }
 
-        // calculation of minimum threshold
-        bool is_intel = cpu::is_intel();
-        double threshold = 2.5;
-        if (util::hyper_x() != HYPERV_UNKNOWN) {
-            threshold = 35.0;
+        // the container evidence of this detection run, or a fresh one outside of a run. It's only a
+        // handful of flags, so it's returned by value instead of tying the caller to the run's cache
+        [[nodiscard]] static container_info containers() {
+            if (active_file_cache != nullptr) {
+                file_cache& cache = *active_file_cache;
+                std::call_once(cache.containers_checked, [&cache]() { cache.containers = gather_container_info(); });
+                return cache.containers;
+            }
+
+            // a cache just for this call, so the files are read again every time
+            const file_cache_scope scope;
+            return gather_container_info();
         }
 
-        // shared state and results
-        timer::cache_state state;
-        bool hypervisor_detected = false;
+        // calls on_line for every line of the text, without the newline and without copying anything
+        template <typename Callback>
+        static void for_each_line(const std::string& text, Callback on_line) {
+            size_t begin = 0;
 
-        const u32 ct_seed = timer::get_ct_seed();
+            while (begin < text.size()) {
+                size_t end = text.find('\n', begin);
 
-        const DWORD_PTR trigger_affinity = timer::getmask(ct_seed, true);
-        const DWORD_PTR counter_affinity = timer::getmask(ct_seed, false);
+                if (end == std::string::npos) {
+                    end = text.size();
+                }
 
-        if (!trigger_affinity || !counter_affinity) {
-            return false;
+                on_line(text.data() + begin, end - begin);
+                begin = end + 1;
+            }
         }
 
-        // our software clock
-        auto counter_thread = [&]() {
-            const HANDLE current_thread = reinterpret_cast<HANDLE>(-2LL);
-            SetThreadAffinityMask(current_thread, counter_affinity);
-            SetThreadPriority(current_thread, THREAD_PRIORITY_HIGHEST); // decrease chance of being rescheduled
-            SetThreadPriorityBoost(current_thread, TRUE); // disable dynamic boosts
+        static container_info gather_container_info() {
+            container_info info;
 
-            while (!state.start_test.load(std::memory_order_acquire)) {}
+            const std::string& cgroup = cached_file("/proc/self/cgroup");
+            info.cgroup_readable = !cgroup.empty();
+            info.cgroup_docker = (cgroup.find("docker") != std::string::npos);
+            info.cgroup_containerd = (cgroup.find("containerd") != std::string::npos);
 
-            while (!state.test_done.load(std::memory_order_relaxed)) {
-                const timer::timer_tick_t current = state.counter; // to silence warnings about incrementing volatile stuff
-                state.counter = current + 1; // better than calling incq in inline assembly, standard increment forces the correct cache behavior we want
-                std::atomic_signal_fence(std::memory_order_seq_cst);
-            }
-        };
+            // a run of at least 64 lowercase hex digits that ends a path component, in a single pass
+            size_t hex_run = 0;
 
-        // it will execute cpuid and serialize or lfence, and compare its latency
-        auto trigger_thread = [&]()
-        #if ((CLANG || GCC))
-            __attribute__((__target__("serialize")))
-        #endif
-        {
-            if (is_intel) {
-                // SERIALIZE requires Ice Lake or newer
-                u32 l7_eax = 0, l7_ebx = 0, l7_ecx = 0, l7_edx = 0;
-                cpu::cpuid(l7_eax, l7_ebx, l7_ecx, l7_edx, 7, 0);
-                if (!(l7_edx & (1u << 14))) {
-                    is_intel = false;
+            for (const char c : cgroup) {
+                if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f')) {
+                    ++hex_run;
+                    continue;
                 }
-            }
 
-            const HANDLE current_thread = reinterpret_cast<HANDLE>(-2LL);
-            const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
-            const DWORD_PTR old_affinity = trigger_affinity;
-            const int old_thread_priority = GetThreadPriority(current_thread);
-            const DWORD old_process_priority = GetPriorityClass(current_process);
-            SetPriorityClass(current_process, ABOVE_NORMAL_PRIORITY_CLASS); // ABOVE_NORMAL_PRIORITY_CLASS + THREAD_PRIORITY_HIGHEST = 12 base priority
-            SetThreadPriority(current_thread, THREAD_PRIORITY_HIGHEST);
-            SetThreadPriorityBoost(current_thread, TRUE); // disable dynamic thread priority adjustments by Windows, not turbo boosts by the hardware itself
+                if ((hex_run >= 64) && ((c == '\n') || (c == '/') || (c == '\0'))) {
+                    info.cgroup_container_id = true;
+                }
 
-            // important so that hypervisor can't predict how many samples we will collect
-            // stack-only / ASLR-derived component (no APIs, no rdtsc)
-            u64 seed = 0;
-            seed ^= static_cast<u64>(ct_seed);
+                hex_run = 0;
+            }
 
-            u64 local1 = 0;
-            u64 local2 = 0;
-            u64 local3 = 0;
+            if (hex_run >= 64) {
+                info.cgroup_container_id = true;
+            }
 
-            seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&seed));
-            seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&local1)) << 1;
-            seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&local2)) << 2;
-            seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&local3)) << 3;
+            for_each_line(cgroup, [&info](const char* line, size_t length) {
+                while ((length > 0) && ((line[length - 1] == '\r') || (line[length - 1] == ' '))) {
+                    --length;
+                }
 
-            seed ^= seed >> 33;
-            seed *= 0xff51afd7ed558ccdULL;
-            seed ^= seed >> 33;
-            seed *= 0xc4ceb9fe1a85ec53ULL;
-            seed ^= seed >> 33;
+                if ((length == 4) && (std::memcmp(line, "0::/", 4) == 0)) {
+                    info.cgroup_namespace_root = true;
+                }
+            });
 
-            std::seed_seq seq{
-                static_cast<u32>(seed),
-                static_cast<u32>(seed >> 32),
-                static_cast<u32>(seed ^ 0x9e3779b9u),
-                ct_seed
-            };
+            const std::string& mountinfo = cached_file("/proc/self/mountinfo");
+            info.mount_docker = (mountinfo.find("/docker/containers/") != std::string::npos);
+            info.mount_podman = (mountinfo.find("/containers/storage/") != std::string::npos);
+            info.mount_containerd = (mountinfo.find("/io.containerd.") != std::string::npos);
 
-            std::mt19937 gen(seq);
-            std::uniform_int_distribution<size_t> batch_dist(30000, 70000);
-            const size_t BATCH_SIZE = batch_dist(gen);
+            // only the numbers right after the field names matter, like "Pid:\t1"
+            auto field_value = [](const char* line, const size_t length, const char* name, long& value) -> bool {
+                const size_t name_length = std::strlen(name);
 
-            SleepEx(0, FALSE); // try to get fresh quantum before starting warm-up phase, give time to kernel to setup priorities
+                if ((length <= name_length) || (std::memcmp(line, name, name_length) != 0)) {
+                    return false;
+                }
 
-            std::vector<timer::timer_tick_t> vm_samples(BATCH_SIZE), ref_samples(BATCH_SIZE); // pre page-fault MMU, wwe wont warm-up cpuid samples for the P-states intentionally
-            VirtualLock(vm_samples.data(), BATCH_SIZE * sizeof(timer::timer_tick_t)); // lock the memory for the samples to prevent page faults if permissions are enough
-            VirtualLock(ref_samples.data(), BATCH_SIZE * sizeof(timer::timer_tick_t));
+                size_t i = name_length;
 
-            #define LFENCE_8 _mm_lfence(); _mm_lfence(); _mm_lfence(); _mm_lfence(); _mm_lfence(); _mm_lfence(); _mm_lfence(); _mm_lfence();
+                while ((i < length) && ((line[i] == ' ') || (line[i] == '\t'))) {
+                    ++i;
+                }
 
-            state.start_test.store(true, std::memory_order_release); // _mm_pause can be vm-exited conditionally, spam hit L3
-            // cache and cpu scheduler warm-up won't affect anything in the measurement loop, so ramp up frequency/P-states to a high non-AVX Turbo/P-state without vmexits
-            u64 val = static_cast<u64>(seed) ^ 0x5a5a5a5a5a5a5a5aULL;
+                value = 0;
+                const size_t digits = i;
 
-            for (u32 i = 0; i < 12'000'000; ++i) {
-                val = (val ^ i) * 6364136223846793005ULL + 1442695040888963407ULL;
-            }
+                for (; (i < length) && (line[i] >= '0') && (line[i] <= '9'); ++i) {
+                    value = (value * 10) + (line[i] - '0');
+                }
 
-            volatile u64 compiler_sink = val;
-            VMAWARE_UNUSED(compiler_sink);
+                return (i > digits);
+            };
 
-            // independent multi-trial state initialization
-            timer::timer_tick_t best_cpuid_l = (std::numeric_limits<timer::timer_tick_t>::max)();
-            timer::timer_tick_t best_ref_l = (std::numeric_limits<timer::timer_tick_t>::max)();
-            constexpr int TRIALS = 3;
+            for_each_line(cached_file("/proc/self/status"), [&](const char* line, const size_t length) {
+                long value = 0;
 
-            for (int trial = 0; trial < TRIALS; ++trial) {
-                size_t valid = 0;  // end of setup phase
+                if (field_value(line, length, "Pid:", value)) {
+                    info.pid_one = (value == 1);
+                } else if (field_value(line, length, "PPid:", value)) {
+                    info.ppid_zero = (value == 0);
+                }
+            });
 
-                // inside the timing windows, there must be zero memory output (no stack arrays can be written to), zero conditional branches and zero stack spilling (no register push/pops)
-                if (is_intel) {
-                    while (valid < BATCH_SIZE) {
-                        // cpuid and serialize/lfence interpolated so that any turbo boost, thermal throttling, speculation (for the loop overhead itself, not for the serializing instructions), etc affects samples equally
-                        timer::timer_tick_t r_pre, r_post, v_pre, v_post, sync;
+            info.dockerenv = (exists("/.dockerenv") || exists("/.dockerinit"));
+            info.containerenv = exists("/run/.containerenv");
+            info.proc_vz = exists("/proc/vz");
 
-                        // this is done as a counter to both legitimate and malicious hypervisors interrupts that may pause the counter thread while we measure
-                        sync = state.counter;
-                        while (state.counter == sync); // infer if counter got enough quantum momentum (so its currently scheduled)
+            return info;
+        }
+    #endif
 
-                        // SERIALIZE/LFENCE check is before CPUID on purpose, so that possible pauses when cpuid is executed do not affect SERIALIZE/LFENCE too. The hv needs to wait for cpuid to pause the thread
-                        // the amount of instructions (8 in case of LFENCE) are enough for the Cross-Core/Cross-CCD MESI RFO cache bounce in the data race so that the counter thread sees an increment
-                        sync = state.counter;
-                        while (state.counter == sync); // fastest busy-waiting strategy, PAUSE affects cache, calling APIs like SwitchToThread() would be even worse
-                        r_pre = state.counter;
-                        std::atomic_signal_fence(std::memory_order_seq_cst); // ensure compiler-level ordering
-                        _serialize();
-                        std::atomic_signal_fence(std::memory_order_seq_cst);
-                        r_post = state.counter;
 
-                        sync = state.counter;
-                        while (state.counter == sync); // sync to our counter tick again
-                        sync = state.counter;
-                        while (state.counter == sync); // and again
+        [[nodiscard]] static bool is_running_under_translator() {
+        #if (WINDOWS && _WIN32_WINNT >= _WIN32_WINNT_WIN10)
+            const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
+            USHORT procMachine = 0, nativeMachine = 0;
+            const auto pIsWow64Process2 = &IsWow64Process2;
 
-                        v_pre = state.counter;
-                        std::atomic_signal_fence(std::memory_order_seq_cst); // _ReadWriteBarrier() aka dont emit runtime fences
+            if (pIsWow64Process2(current_process, &procMachine, &nativeMachine)) {
+                if (nativeMachine == IMAGE_FILE_MACHINE_ARM64 &&
+                    (procMachine == IMAGE_FILE_MACHINE_AMD64 || procMachine == IMAGE_FILE_MACHINE_I386)) {
+                    debug("Translator detected x64/x86 process on ARM64");
+                    return true;
+                }
+            }
 
-                        // the only way a legitimate interrupt can make the check false flag is if most of the samples were contaminated just in the cpuid samples but not in the serialize/lfence samples
-                        // still possible tho, but it's as accurate we can get on user-mode without relying on any other hardware clock or cross-referencing with the counter thread mid-execution
-                        // this is why the score of this technique is not enough to determine a VM
-                        timer::vmexit();
+            // only if we got MACHINE_UNKNOWN on process but native is ARM64
+            if (nativeMachine == IMAGE_FILE_MACHINE_ARM64) {
+                using get_process_information = BOOL(__stdcall*)(HANDLE, PROCESS_INFORMATION_CLASS, PVOID, DWORD);
+                const HMODULE ntdll = util::get_ntdll();
+                if (ntdll == nullptr) {
+                    return false;
+                }
 
-                        std::atomic_signal_fence(std::memory_order_seq_cst);
-                        v_post = state.counter;
+                const char* names[] = { "GetProcessInformation" };
+                void* funcs[ARRAYSIZE(names)] = {};
+                util::get_function_address(ntdll, names, funcs, 1);
 
-                        // we dont filter by cycles spent here (for example by querying thread cycle time) because the point of this function is to not use TSC or any other clock
-                        if (v_post > v_pre && r_post > r_pre) {
-                            vm_samples[valid] = v_post - v_pre;
-                            ref_samples[valid] = r_post - r_pre;
-                            valid++;
+                get_process_information get_proc_info = reinterpret_cast<get_process_information>(funcs[0]);
+                if (get_proc_info) {
+                    struct PROCESS_MACHINE_INFORMATION {
+                        USHORT ProcessMachine;
+                        USHORT Res0;
+                        DWORD  MachineAttributes;
+                    } pmInfo = {};
+                    // ProcessMachineTypeInfo == 9 per MS Q&A
+                    if (get_proc_info(current_process, (PROCESS_INFORMATION_CLASS)9, &pmInfo, sizeof(pmInfo))) {
+                        if (pmInfo.ProcessMachine == IMAGE_FILE_MACHINE_AMD64 || pmInfo.ProcessMachine == IMAGE_FILE_MACHINE_I386) {
+                            debug("Translator detected x64/x86 process on ARM64 by fallback");
+                            return true;
                         }
-
-                        // burn cycles executing a random number of instructions in each loop iteration, so that the hypervisor doesn't know when to pause the counter thread
-                        timer::burn_random_cycles(ct_seed, v_post, r_post);
                     }
                 }
-                else {
-                    while (valid < BATCH_SIZE) {
-                        // cpuid and serialize/lfence interpolated so that any turbo boost, thermal throttling, speculation (for the loop overhead itself, not for the serializing instructions), etc affects samples equally
-                        timer::timer_tick_t r_pre, r_post, v_pre, v_post, sync;
+            }
+        #endif
 
-                        // this is done as a counter to both legitimate and malicious hypervisors interrupts that may pause the counter thread while we measure
-                        sync = state.counter;
-                        while (state.counter == sync); // infer if counter got enough quantum momentum (so its currently scheduled)
+            if (cpu::is_leaf_supported(cpu::leaf::hypervisor)) {
+                const std::string vendor = cpu::cpu_manufacturer(cpu::leaf::hypervisor);
+                
+                if (vendor == "VirtualApple" ||   // Apple Rosetta
+                    vendor == "PowerVM Lx86")     // IBM PowerVM Lx86
+                {
+                    return true;
+                }
+            }
 
-                        // SERIALIZE/LFENCE check is before CPUID on purpose, so that possible pauses when cpuid is executed do not affect SERIALIZE/LFENCE too. The hv needs to wait for cpuid to pause the thread
-                        // the amount of instructions (8 in case of LFENCE) are enough for the Cross-Core/Cross-CCD MESI RFO cache bounce in the data race so that the counter thread sees an increment
-                        sync = state.counter;
-                        while (state.counter == sync);
-                        r_pre = state.counter;
-                        std::atomic_signal_fence(std::memory_order_seq_cst);
-                        LFENCE_8
-                            std::atomic_signal_fence(std::memory_order_seq_cst);
-                        r_post = state.counter;
+        #if (WINDOWS)
+            const std::string& brand = cpu::get_brand();
+            if (brand.find("Virtual CPU") != std::string::npos) {
+                return true;
+            }
+        #endif
 
-                        sync = state.counter;
-                        while (state.counter == sync); // sync to our counter tick again
-                        sync = state.counter;
-                        while (state.counter == sync); // and again
+            return false;
+        }
 
-                        v_pre = state.counter;
-                        std::atomic_signal_fence(std::memory_order_seq_cst); // _ReadWriteBarrier() aka dont emit runtime fences
 
-                        // the only way a legitimate interrupt can make the check false flag is if most of the samples were contaminated just in the cpuid samples but not in the serialize/lfence samples
-                        // still possible tho, but it's as accurate we can get on user-mode without relying on any other hardware clock or cross-referencing with the counter thread mid-execution
-                        // this is why the score of this technique is not enough to determine a VM
-                        timer::vmexit();
+        /**
+         * @brief Check whether the system is running in a Hyper-V virtual machine or if the host system has Hyper-V enabled
+         * @note Hyper-V's presence on a host system can set certain hypervisor-related CPU flags that may appear similar to those in a virtualized environment, which can make it challenging to differentiate between an actual Hyper-V virtual machine (VM) and a host system with Hyper-V enabled.
+         *       This can lead to false conclusions, where the system might mistakenly be identified as running in a Hyper-V VM, when in reality, it's simply the host system with Hyper-V features active.
+         *       This check aims to distinguish between these two cases by identifying specific CPU flags and hypervisor-related artifacts that are indicative of a Hyper-V VM rather than a host system with Hyper-V enabled.
+         * @returns hyperx_state enum indicating the detected state:
+         *          - HYPERV_ARTIFACT_VM for host with Hyper-V enabled
+         *          - HYPERV_REAL_VM for real Hyper-V VM
+         *          - HYPERV_ENLIGHTENMENT for QEMU with Hyper-V enlightenments
+         *          - HYPERV_UNKNOWN for unknown/undetected state
+         */
+        [[nodiscard]] static hyperx_state hyper_x() {
+        #if (!WINDOWS)
+            return HYPERV_UNKNOWN;
+        #else
+            if (memo::hyperx::is_cached()) {
+                debug("HYPER_X: returned from cache");
+                return memo::hyperx::fetch();
+            }
 
-                        std::atomic_signal_fence(std::memory_order_seq_cst);
-                        v_post = state.counter;
+            // Check if hypervisor feature bit in CPUID Leaf 1, ECX bit 31 is enabled
+            auto is_hyperv_present = []() noexcept -> bool {
+                u32 unused, ecx = 0;
+                cpu::cpuid(unused, unused, ecx, unused, 1);
 
-                        // we dont filter by cycles spent here (for example by querying thread cycle time) because the point of this function is to not use TSC or any other clock
-                        if (v_post > v_pre && r_post > r_pre) {
-                            vm_samples[valid] = v_post - v_pre;
-                            ref_samples[valid] = r_post - r_pre;
-                            valid++;
-                        }
+                return (ecx >> 31) & 1;
+            };
 
-                        // burn cycles executing a random number of instructions in each loop iteration, so that the hypervisor doesn't know when to pause the counter thread
-                        timer::burn_random_cycles(ct_seed, v_post, r_post);
-                    }
-                }
+            // 0x40000003 on EBX indicates the flags that a parent partition specified to create a child partition (https://learn.microsoft.com/en-us/virtualization/hyper-v-on-windows/tlfs/datatypes/hv_partition_privilege_mask)
+            // some CPU models like N-models (N4200, etc) expose 0x40000003 leaves without exposing the hypervisor bit
+            auto is_root_partition = []() noexcept -> bool {
+                u32 ebx, unused = 0;
+                cpu::cpuid(unused, ebx, unused, unused, 0x40000003);
 
-                const timer::timer_tick_t cpuid_l = timer::calculate_latency(vm_samples); // check for lowest dense cluster with no interrupt spikes, filter noise we can't detect (SMIs, NMIs, etc)
-                const timer::timer_tick_t ref_l = timer::calculate_latency(ref_samples);
+                return (ebx & 1);
+            };
 
-                // record the cleanest/lowest latency observed across the independent trials
-                if (cpuid_l < best_cpuid_l) best_cpuid_l = cpuid_l;
-                if (ref_l < best_ref_l) best_ref_l = ref_l;
-            }
+            /**
+              * On Hyper-V virtual machines, the cpuid function reports an EAX value of 11
+              * This value is tied to the Hyper-V partition model, where each virtual machine runs as a child partition
+              * These child partitions have limited privileges and access to hypervisor resources, 
+              * which is reflected in the maximum input value for hypervisor CPUID information as 11
+              * Essentially, it indicates that the hypervisor is managing the VM and that the VM is not running directly on hardware but rather in a virtualized environment
+            */
+            auto eax = []() noexcept -> u32 {
+                u32 eax_reg, unused = 0;
+                cpu::cpuid(eax_reg, unused, unused, unused, cpu::leaf::hypervisor);
 
-            state.test_done.store(true, std::memory_order_release);
-
-            const double latency_ratio = best_ref_l ? (double)best_cpuid_l / (double)best_ref_l : 0;
+                // truncation is intentional
+                return eax_reg & 0xFF;
+            };
 
-            // VMM = Time spent in hypervisor; nVMM = Time spent in baremetal
-            debug("TIMER: VMM -> ", best_cpuid_l, " | nVMM -> ", best_ref_l, " | Ratio -> ", latency_ratio); // these ARE NOT cycles
-            if (latency_ratio >= threshold) hypervisor_detected = true;
+            hyperx_state state = HYPERV_UNKNOWN;
 
-            // Detect IPI-based counter pausing bypasses
-            // For the median itself to exceed baremetal limits (which rarely pass 1000), an interrupt must be occurring on almost EVERY single loop iteration
-            // This is the footprint of a hypervisor continuously spamming cross-core IPIs to try and pause our threads
-            if (best_cpuid_l > 1000 || best_ref_l > 1000 || best_cpuid_l == 1 || best_ref_l == 1) {
-                debug("TIMER: Detected artificial interrupt delivery to timing threads");
-                hypervisor_detected = true;
+            if (!is_root_partition()) {
+                if (eax() == 11 && is_hyperv_present()) {
+                    // Windows machine running under Hyper-V type 2
+                    debug("HYPER-X: Detected Hyper-V guest VM");
+                    core::add(brand_enum::HYPERV);
+                    state = HYPERV_REAL_VM;
+                }
+                else {
+                    debug("HYPER-X: Hyper-V is not active");
+                    state = HYPERV_UNKNOWN;
+                }
             }
+            else {
+                // Windows machine running under Hyper-V type 1
+                std::string brand_str = cpu::cpu_manufacturer(cpu::leaf::hypervisor + 0x100);
 
-            // cleanup
-            SetThreadPriorityBoost(current_thread, FALSE);
-            SetThreadPriority(current_thread, old_thread_priority);
-            SetPriorityClass(current_process, old_process_priority);
-            SetThreadAffinityMask(current_thread, old_affinity);
-            VirtualUnlock(vm_samples.data(), BATCH_SIZE * sizeof(timer::timer_tick_t));
-            VirtualUnlock(ref_samples.data(), BATCH_SIZE * sizeof(timer::timer_tick_t));
-        };
-
-        std::thread t1(counter_thread);
-        trigger_thread();
-        t1.join();
+                if (util::find(brand_str, "KVM")) {
+                    debug("HYPER-X: Detected Hyper-V enlightenments");
+                    core::add(brand_enum::QEMU_KVM_HYPERV);
+                    state = HYPERV_ENLIGHTENMENT;
+                }
+                else {
+                    // If we reach here, we do some sanity checks to ensure a hypervisor is not trying to spoof itself as Hyper-V, attempting to bypass some detections
+                    brand_str = cpu::cpu_manufacturer(cpu::leaf::hypervisor);
 
-        return hypervisor_detected;
-    #endif
-        return false;
-    }
-#endif
+                    bool is_hyper_v_host = false;
 
-#if (MSVC)
-    #pragma endregion
-    #pragma region "Linux"
-#endif
+                #if (x86_64)
+                    u8 idtr_buffer[10] = { 0 };
 
-#if (LINUX)
-    /**
-     * @brief Check result from systemd-detect-virt tool
-     * @category Linux
-     * @implements VM::SYSTEMD
-     */
-    [[nodiscard]] static bool systemd_virt() {
-        if (!(util::exists("/usr/bin/systemd-detect-virt") || util::exists("/bin/systemd-detect-virt"))) {
-            debug("SYSTEMD: ", "binary doesn't exist");
-            return false;
-        }
+                    // we know we're not using SEH here, it's on purpose, and doesn't matter in what CPU core this runs on
+                    #if (CLANG || GCC)
+                        __asm__ volatile("sidt %0" : "=m"(idtr_buffer));
+                    #elif (MSVC)
+                        #pragma pack(push, 1)
+                        struct {
+                            USHORT Limit;
+                            ULONG_PTR Base;
+                        } idtr = { 0 };
+                        #pragma pack(pop)       
+                        __sidt(&idtr);
 
-        const std::unique_ptr<std::string> result = util::sys_result("systemd-detect-virt");
+                        volatile u8* idtr_ptr = (volatile u8*)&idtr;
+                        for (size_t j = 0; j < sizeof(idtr); ++j) {
+                            idtr_buffer[j] = idtr_ptr[j];
+                        }
+                    #endif
 
-        if (result == nullptr) {
-            debug("SYSTEMD: ", "invalid stdout output from systemd-detect-virt");
-            return false;
-        }
+                    ULONG_PTR idt_base = 0;
+                    memcpy(&idt_base, &idtr_buffer[2], sizeof(idt_base));
 
-        debug("SYSTEMD: ", "output = ", *result);
+                    // if running under Hyper-V in AMD64 (doesnt matter the VTL/partition level), this value is hardcoded and intercepted/emulated at kernel level
+                    // specifically at KiPreprocessFault -> KiOpDecode -> KiOpLocateDecodeEntry (KiOp_SLDTSTRSMSW)
+                    // this is intercepted by the kernel before handling execution to the hypervisor, so it's a decent safeguard against basic cpuid spoofing
+                    // additionally, brand has to be "Microsoft Hv"
+                    is_hyper_v_host = idt_base == 0xfffff80000001000 && brand_str == "Microsoft Hv";
+                #else
+                    is_hyper_v_host = brand_str == "Microsoft Hv";
+                #endif
 
-        return (*result != "none");
-    }
+                    if (is_hyper_v_host) {
+                        debug("HYPER-X: Detected Hyper-V host machine");
+                        core::add(brand_enum::HYPERV_ROOT);
+                        state = HYPERV_ARTIFACT_VM;
+                    }
+                    else {
+                        debug("HYPER-X: Detected hypervisor trying to spoof itself as Hyper-V");
+                        state = HYPERV_UNKNOWN; // doing this is enough to trigger a VM detection, we dont need to mark a 100% vm score as our techniques will do the job for us
+                    } 
+                } 
+            }
 
+            memo::hyperx::store(state);
 
-    /**
-     * @brief Check if the chassis vendor is a VM vendor
-     * @category Linux
-     * @implements VM::CVENDOR
-     */
-    [[nodiscard]] static bool chassis_vendor() {
-        const char* vendor_file = "/sys/devices/virtual/dmi/id/chassis_vendor";
+            return state;
+        #endif
+        }
 
-        if (!util::exists(vendor_file)) {
-            debug("CVENDOR: ", "file doesn't exist");
-            return false;
+        // For strings shorter than 16-32 bytes, the overhead of setting up the _mm_crc32_u64 (or 32) loop, then checking length, handling the tail bytes, and finally handling alignment, 
+        // will always make it slower or equal to a simple unrolled u8 loop, and not every cpu model fits in u32/u64
+        #if (x86 && (CLANG || GCC))
+            __attribute__((__target__("crc32")))
+        #endif
+        static u32 crc32(u32 crc, char data) {
+        #if (x86)
+            return _mm_crc32_u8(crc, static_cast<u8>(data));
+        #else
+            // Fallback for non-x86: use software CRC32-C
+            crc ^= static_cast<u8>(data);
+            for (int i = 0; i < 8; ++i)
+                crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78u : 0);
+            return crc;
+        #endif
         }
 
-        const std::string vendor = util::read_file(vendor_file);
+        // to search in our databases, we want to precompute hashes at compile time for C++11 and later
+        // so we need to match the hardware _mm_crc32_u8, it is based on CRC32-C (Castagnoli) polynomial
+        struct constexpr_hash {
+            // it does 8 rounds of CRC32-C bit reflection recursively
+            static constexpr u32 crc32_bits(u32 crc, int bits) {
+                return (bits == 0) ? crc :
+                    crc32_bits((crc >> 1) ^ ((crc & 1) ? 0x82F63B78u : 0), bits - 1);
+            }
 
-        // TODO: More can definitely be added, only QEMU and VBox were tested so far
-        if (util::find(vendor, "QEMU")) { return core::add(brand_enum::QEMU); }
-        if (util::find(vendor, "Oracle Corporation")) { return core::add(brand_enum::VBOX); }
+            // over string
+            static constexpr u32 crc32_str(const char* s, u32 crc) {
+                return (*s == '\0') ? crc :
+                    crc32_str(s + 1, crc32_bits(crc ^ static_cast<u8>(*s), 8));
+            }
 
-        debug("CVENDOR: vendor = ", vendor);
+            static constexpr u32 get(const char* s) {
+                return crc32_str(s, 0);
+            }
+        };
 
-        return false;
-    }
+        // this forces the compiler to calculate the hash when initializing the array while staying C++11 compatible
+        struct thread_entry {
+            u32 hash;
+            u32 threads;
+            constexpr thread_entry(const char* m, u32 t) : hash(constexpr_hash::get(m)), threads(t) {}
+        };
 
+        enum class cpu_type : u8 {
+            INTEL_I,
+            INTEL_XEON,
+            AMD
+        };
 
-    /**
-     * @brief Check if the chassis type is valid (it's very often invalid in VMs)
-     * @category Linux
-     * @implements VM::CTYPE
-     */
-    [[nodiscard]] static bool chassis_type() {
-        const char* chassis = "/sys/devices/virtual/dmi/id/chassis_type";
+        // 4 arguments to stay compliant with x64 __fastcall (just in case)
+        [[nodiscard]] static bool verify_thread_count(const thread_entry* db, size_t db_size, size_t max_model_len, cpu_type type) {
+            // to save a few cycles
+            struct hasher {
+                static u32 crc32_sw(u32 crc, char data) {
+                    crc ^= static_cast<u8>(data);
+                    for (int i = 0; i < 8; ++i) {
+                        crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78u : 0);
+                    }
+                    return crc;
+                }
 
-        if (util::exists(chassis)) {
-            try {
-                return (std::stoi(util::read_file(chassis)) == 1);
-            }
-            catch (...) {
-                return false;
-            }
-        }
+                using hashfc = u32(*)(u32, char);
 
-        debug("CTYPE: ", "file doesn't exist");
+                static hashfc get() {
+                    // yes, vmaware runs on dinosaur cpus without sse4.2 pretty often
+                    i32 regs[4];
+                    cpu::cpuid(regs, 1);
+                    const bool has_sse42 = (regs[2] & (1 << 20)) != 0;
 
-        return false;
-    }
+                    return has_sse42 ? util::crc32 : crc32_sw;
+                }
+            };
 
+            std::string model_string;
+            const char* debug_tag = ""; // NOLINT(clang-analyzer-deadcode.DeadStores)
 
-    /**
-     * @brief Check if /.dockerenv or /.dockerinit file is present
-     * @category Linux
-     * @implements VM::DOCKERENV
-     */
-    [[nodiscard]] static bool dockerenv() {
-        if (util::exists("/.dockerenv") || util::exists("/.dockerinit")) {
-            return core::add(brand_enum::DOCKER);
-        }
+            if (type == cpu_type::AMD) {
+                if (!cpu::is_amd()) {
+                    return false;
+                }
+                model_string = cpu::get_brand();
+                debug_tag = "AMD_THREAD_MISMATCH";
+            }
+            else {
+                if (!cpu::is_intel()) {
+                    return false;
+                }
 
-        return false;
-    }
+                const cpu::model_struct model = cpu::get_model();
 
+                if (!model.found) {
+                    return false;
+                }
 
-    /**
-     * @brief Check if dmidecode output matches a VM brand
-     * @category Linux
-     * @warning Permissions required
-     * @implements VM::DMIDECODE
-     */
-    [[nodiscard]] static bool dmidecode() {
-        if (!util::is_admin()) {
-            debug("DMIDECODE: ", "precondition return called (root = ", util::is_admin(), ")");
-            return false;
-        }
+                if (type == cpu_type::INTEL_I) {
+                    if (!model.is_i_series) {
+                        return false;
+                    }
+                    debug_tag = "INTEL_THREAD_MISMATCH";
+                }
+                else {
+                    if (!model.is_xeon) {
+                        return false;
+                    }
+                    debug_tag = "XEON_THREAD_MISMATCH";
+                }
+                model_string = model.string;
+            }
 
-        if (!(util::exists("/bin/dmidecode") || util::exists("/usr/bin/dmidecode"))) {
-            debug("DMIDECODE: ", "binary doesn't exist");
-            return false;
-        }
+            if (model_string.empty()) {
+                return false;
+            }
 
-        const std::unique_ptr<std::string> result = util::sys_result("dmidecode -t system | grep 'Manufacturer|Product' | grep -c \"QEMU|VirtualBox|KVM\"");
+            debug(debug_tag, ": CPU model = ", model_string);
 
-        if (!result || result->empty()) {
-            debug("DMIDECODE: ", "invalid output");
-            return false;
-        }
-        
-        if (*result == "QEMU") {
-            return core::add(brand_enum::QEMU);
-        }
-        
-        if (*result == "VirtualBox") {
-            return core::add(brand_enum::VBOX);
-        }
-        
-        if (*result == "KVM") {
-            return core::add(brand_enum::KVM);
-        } 
-        
-        if (std::strtol(result->c_str(), nullptr, 10) >= 1) {
-            return true;
-        }
-         
-        debug("DMIDECODE: ", "output = ", *result);
+            const char* str = model_string.c_str();
+            u32 expected_threads = 0;
+            bool found = false;
+            size_t best_len = 0;
 
-        return false;
-    }
+            // manual collision fix for Z1 Extreme (16) vs Z1 (12)
+            // this is a special runtime check because "z1" is a substring of "z1 extreme" tokens
+            // and both might be hashed. VMAware should prioritize 'extreme' if found
+            u32 z_series_threads = 0;
 
+            const auto hash_func = hasher::get();
 
-    /**
-     * @brief Check if mac address starts with certain VM designated values
-     * @category Linux
-     * @implements VM::MAC
-     */
-    [[nodiscard]] static bool mac_address_check() {
-        struct fdguard {
-            int fd;
-            explicit fdguard(int fd = -1) : fd(fd) {}
-            ~fdguard() { if (fd != -1) { ::close(fd); } }
-            int get() const { return fd; }
-            int release() { 
-                const int tmp = fd; 
-                fd = -1; 
-                return tmp; 
-            }
-        };
+            for (size_t i = 0; str[i] != '\0'; ) {
+                char const c = str[i];
+                if (!((c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'))) {
+                    i++;
+                    continue;
+                }
 
-        u8 mac[6] = { 0 };
-        struct ifreq ifr{};
-        struct ifconf ifc{};
-        char buf[1024];
-        int success = 0;
+                u32 current_hash = 0;
+                size_t current_len = 0;
+                size_t j = i;
 
-        int const sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
-        if (sock == -1) {
-            return false;
-        }
-        const fdguard sockGuard(sock); // will close on function exit
+                while (true) {
+                    char k = str[j];
+                    const bool is_valid = (
+                        (k >= '0' && k <= '9') ||
+                        (k >= 'A' && k <= 'Z') ||
+                        (k >= 'a' && k <= 'z') ||
+                        (k == '-') // models have hyphen
+                    );
+    
+                    if (!is_valid) {
+                        break;
+                    }
+
+                    if (current_len >= max_model_len) {
+                        while (str[j] != '\0' && str[j] != ' ') {
+                            j++; // fast forward to space/null
+                        }
+                        break;
+                    }
 
-        ifc.ifc_len = sizeof(buf);
-        ifc.ifc_buf = buf;
+                    /*
+                       models are usually 8 or more bytes long, i.e. i9-10900K
+                       so imagine we want to use u64, you hash the first 8 bytes i9-10900
+                       but then you are left with K. You have to handle the tail
+                       fetching 8 bytes would include the characters after the token, corrupting the hash
+                       so a byte-by-byte loop is the most optimal choice here
+                    */
 
-        if (ioctl(sockGuard.get(), SIOCGIFCONF, &ifc) == -1) {
-            return false;
-        }
+                    // convert to lowercase on-the-fly to match compile-time keys
+                    if (type == cpu_type::AMD && (k >= 'A' && k <= 'Z')) {
+                        k += 32;
+                    }
 
-        struct ifreq* it = ifc.ifc_req;
-        const struct ifreq* end = it + (ifc.ifc_len / sizeof(struct ifreq));
+                    // since this technique is cross-platform, we cannot use a standard C++ try-catch block to catch a missing CPU instruction
+                    // we could use preprocessor directives and add an exception handler (VEH/SEH or SIGHANDLER) but nah
+                    current_hash = hash_func(current_hash, k);
+                    current_len++;
+                    j++;
 
-        for (; it != end; ++it) {
-            std::size_t const name_len = std::min<std::size_t>(sizeof(ifr.ifr_name) - 1, strnlen(it->ifr_name, sizeof(it->ifr_name)));
-            memcpy(ifr.ifr_name, it->ifr_name, name_len);
-            *(ifr.ifr_name + name_len) = '\0';
+                    // only verify match if the token has ended (next char is not alphanumeric)
+                    const char next = str[j];
+                    const bool next_is_alnum = (next >= '0' && next <= '9') ||
+                        (next >= 'A' && next <= 'Z') ||
+                        (next >= 'a' && next <= 'z');
 
-            if (ioctl(sockGuard.get(), SIOCGIFFLAGS, &ifr) != 0) {
-                return false;
-            }
+                    if (!next_is_alnum) {
+                        // Check specific Z1 Extreme token
+                        // Hash for "extreme" (CRC32-C) is 0x3D09D5B4
+                        if (type == cpu_type::AMD && current_hash == 0x3D09D5B4) { z_series_threads = 16; }
 
-            if (!(ifr.ifr_flags & IFF_LOOPBACK)) {
-                if (ioctl(sockGuard.get(), SIOCGIFHWADDR, &ifr) == 0) {
-                    success = 1;
-                    break;
+                        // since it's a contiguous block of integers in .rodata/.rdata, this is extremely fast
+                        for (size_t idx = 0; idx < db_size; ++idx) {
+                            if (db[idx].hash != current_hash) {
+                                continue;
+                            }
+
+                            if (current_len > best_len) {
+                                best_len = current_len;
+                                expected_threads = db[idx].threads;
+                                found = true;
+                            }
+                            // since hashing implies uniqueness in this dataset, you might say we could break here,
+                            // but we continue to ensure we find the longest substring match if overlaps exist,
+                            // so like it finds both "i9-11900" and "i9-11900K" i.e.
+                        }
+                    }
                 }
+                i = j;
             }
-        }
 
-        if (success) {
-            memcpy(mac, ifr.ifr_hwaddr.sa_data, 6);
-        }
-        else {
-            debug("MAC: ", "not successful");
-        }
+            // Z1 Extreme fix
+            if (type == cpu_type::AMD && z_series_threads != 0 && expected_threads == 12) {
+                expected_threads = z_series_threads;
+            }
 
-    #ifdef __VMAWARE_DEBUG__
-        {
-            std::stringstream ss;
-            ss << std::hex << std::setw(2) << std::setfill('0')
-                << static_cast<int>(mac[0]) << ":"
-                << static_cast<int>(mac[1]) << ":"
-                << static_cast<int>(mac[2]) << ":XX:XX:XX";
-            debug("MAC: ", ss.str());
-        }
-    #endif
+            if (found) {
+                const u32 actual = memo::threadcount::fetch();
+                if (actual != expected_threads) {
+                    debug(debug_tag, ": Expected threads -> ", expected_threads);
+                    VMAWARE_UNUSED(debug_tag); // if compiled in release mode, silence the unused variable warning
+                    return true;
+                }
+            }
 
-        if ((mac[0] | mac[1] | mac[2]) == 0) {
             return false;
         }
 
-        const u32 prefix = static_cast<u32>(mac[0])
-            | (static_cast<u32>(mac[1]) << 8)
-            | (static_cast<u32>(mac[2]) << 16);
+    #if (WINDOWS)
+        // retrieves the addresses of specified functions from a loaded module using the export directory, manual implementation of GetProcAddress
+        static void get_function_address(const HMODULE hModule, const char* names[], void** functions, size_t count) {
+            using func_map = std::unordered_map<std::string, void*>;
+            static std::unordered_map<HMODULE, func_map> function_cache;
 
-        constexpr u32 VBOX = 0x270008;  // 08:00:27
-        constexpr u32 VMW1 = 0x29000C;  // 00:0C:29
-        constexpr u32 VMW2 = 0x141C00;  // 00:1C:14
-        constexpr u32 VMW3 = 0x565000;  // 00:50:56
-        constexpr u32 VMW4 = 0x690500;  // 00:05:69
-        constexpr u32 XEN = 0xE31600;   // 00:16:E3
-        constexpr u32 PAR = 0x421C00;   // 00:1C:42
+            for (size_t i = 0; i < count; ++i) functions[i] = nullptr;
+            if (!hModule) return;
 
-        if (prefix == VBOX) {
-            return core::add(brand_enum::VBOX);
-        }
-        
-        if (prefix == VMW1 || prefix == VMW2
-            || prefix == VMW3 || prefix == VMW4) {
-            return core::add(brand_enum::VMWARE);
-        }
-        
-        if (prefix == XEN) {
-            return core::add(brand_enum::XEN);
-        }
-        
-        if (prefix == PAR) {
-            return core::add(brand_enum::PARALLELS);
-        }
+            BYTE* base = reinterpret_cast<BYTE*>(hModule);
 
-        return false;
-    }
+            size_t module_size = 0;
+            {
+                MEMORY_BASIC_INFORMATION mbi = {};
+                if (VirtualQuery(base, &mbi, sizeof(mbi))) {
+                    module_size = static_cast<size_t>(mbi.RegionSize);
+                }
+                else {
+                    return;
+                }
+            }
 
+            auto valid_range = [&](size_t offset, size_t sz) noexcept -> bool {
+                return (sz > 0) && (offset < module_size) && (sz <= module_size - offset);
+            };
 
-    /**
-     * @brief Check if dmesg output matches a VM brand
-     * @category Linux
-     * @warning Permissions required
-     * @implements VM::DMESG
-     */
-    [[nodiscard]] static bool dmesg() {
-    #if (VMA_CPP <= 11)
-        return false;
-    #else
-        if (!util::is_admin()) {
-            return false;
-        }
+            auto cstr_from_rva = [&](DWORD rva) noexcept -> const char* {
+                if (!valid_range(static_cast<size_t>(rva), 1)) return nullptr;
 
-        if (!util::exists("/bin/dmesg") && !util::exists("/usr/bin/dmesg")) {
-            debug("DMESG: ", "binary doesn't exist");
-            return false;
-        }
+                const char* start = reinterpret_cast<const char*>(base + rva);
+                const size_t remaining = module_size - static_cast<size_t>(rva);
 
-        const std::unique_ptr<std::string> result = util::sys_result("dmesg | grep -i hypervisor | grep -c \"KVM|QEMU\"");
+                if (std::memchr(start, '\0', remaining)) {
+                    return start;
+                }
 
-        if (!result || result->empty()) {
-            return false;
-        }
-        
-        if (*result == "KVM") {
-            return core::add(brand_enum::KVM);
-        }
-        
-        if (*result == "QEMU") {
-            return core::add(brand_enum::QEMU);
-        }
-        
-        if (std::strtol(result->c_str(), nullptr, 10)) {
-            return true;
-        }
+                return nullptr;
+            };
 
-        debug("DMESG: ", "output = ", *result);
+            // Validate DOS header 
+            if (!valid_range(0, sizeof(IMAGE_DOS_HEADER))) return;
+            const auto* dosHeader = reinterpret_cast<const IMAGE_DOS_HEADER*>(base);
+            if (dosHeader->e_magic != IMAGE_DOS_SIGNATURE) return;
 
-        return false;
-    #endif
-    }
+            // e_lfanew -> NT headers
+            if (dosHeader->e_lfanew < 0) return;
+            const size_t e_lfanew = static_cast<size_t>(dosHeader->e_lfanew);
+            if (!valid_range(e_lfanew, sizeof(IMAGE_NT_HEADERS))) return;
+            const auto* ntHeaders = reinterpret_cast<const IMAGE_NT_HEADERS*>(base + e_lfanew);
+            if (ntHeaders->Signature != IMAGE_NT_SIGNATURE) return;
 
+            const size_t sizeOfImage = static_cast<size_t>(ntHeaders->OptionalHeader.SizeOfImage);
+            if (sizeOfImage != 0 && sizeOfImage > module_size) {
+                module_size = sizeOfImage;
+            }
 
-    /**
-     * @brief Check if /sys/class/hwmon/ directory is present. If not, likely a VM
-     * @category Linux
-     * @implements VM::HWMON
-     */
-    [[nodiscard]] static bool hwmon() {
-        return (!util::exists("/sys/class/hwmon/"));
-    }
+            // Check export data directory exists
+            if (ntHeaders->OptionalHeader.NumberOfRvaAndSizes <= IMAGE_DIRECTORY_ENTRY_EXPORT) {
+                return; // no export directory
+            }
 
+            const auto& dd = ntHeaders->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT];
+            if (dd.VirtualAddress == 0 || dd.Size == 0) {
+                return; // no exports
+            }
 
-    /**
-     * @brief Check for default VM username and hostname for linux
-     * @category Linux
-     * @implements VM::LINUX_USER_HOST
-     */
-    [[nodiscard]] static bool linux_user_host() {
-        if (util::is_admin()) {
-            return false;
-        }
+            // Validate export directory fits
+            if (!valid_range(static_cast<size_t>(dd.VirtualAddress), sizeof(IMAGE_EXPORT_DIRECTORY))) {
+                return;
+            }
 
-        const char* username = std::getenv("USER");
-        const char* hostname = std::getenv("HOSTNAME");
+            const auto* exportDir = reinterpret_cast<const IMAGE_EXPORT_DIRECTORY*>(base + dd.VirtualAddress);
 
-        if (!username || !hostname) {
-            debug("VM::LINUX_USER_HOST: environment variables not found");
-            return false;
-        }
+            const DWORD nameCount = exportDir->NumberOfNames;
+            const DWORD funcCount = exportDir->NumberOfFunctions;
 
-        debug("LINUX_USER_HOST: user = ", username);
-        debug("LINUX_USER_HOST: host = ", hostname);
-
-        return (
-            (strcmp(username, "liveuser") == 0) &&
-            (strcmp(hostname, "localhost-live") == 0)
-        );
-    }
+            constexpr DWORD MAX_NAMES = 1u << 20; // 1M names is absurd but protective
+            if (nameCount == 0 || nameCount > MAX_NAMES) return;
+            if (funcCount == 0 || funcCount > MAX_NAMES) return;
 
+            const DWORD addr_names = exportDir->AddressOfNames;
+            const DWORD addr_funcs = exportDir->AddressOfFunctions;
+            const DWORD addr_ord = exportDir->AddressOfNameOrdinals;
 
-    /**
-     * @brief Check for VMware string in /proc/iomem
-     * @category Linux
-     * @author idea from ScoopyNG by Tobias Klein
-     * @implements VM::VMWARE_IOMEM
-     */
-    [[nodiscard]] static bool vmware_iomem() {
-        const std::string iomem_file = util::read_file("/proc/iomem");
+            if (!valid_range(static_cast<size_t>(addr_names), static_cast<size_t>(nameCount) * sizeof(DWORD))) return;
+            if (!valid_range(static_cast<size_t>(addr_funcs), static_cast<size_t>(funcCount) * sizeof(DWORD))) return;
+            if (!valid_range(static_cast<size_t>(addr_ord), static_cast<size_t>(nameCount) * sizeof(WORD))) return;
 
-        if (util::find(iomem_file, "VMware")) {
-            return core::add(brand_enum::VMWARE);
-        }
+            const DWORD* nameRvas = reinterpret_cast<const DWORD*>(base + addr_names);
+            const DWORD* funcRvas = reinterpret_cast<const DWORD*>(base + addr_funcs);
+            const WORD* ordinals = reinterpret_cast<const WORD*>(base + addr_ord);
 
-        return false;
-    }
+            func_map& module_cache = function_cache[hModule];
 
+            for (size_t i = 0; i < count; ++i) {
+                const char* current_name = names[i];
+                if (!current_name) continue;
+                const std::string s_name(current_name);
 
-    /**
-     * @brief Check for the presence of BlueStacks-specific folders
-     * @category ARM, Linux
-     * @implements VM::BLUESTACKS_FOLDERS
-     */
-    [[nodiscard]] static bool bluestacks() {
-    #if (!ARM)
-        return false;
-    #else
-        if (
-            util::exists("/mnt/windows/BstSharedFolder") ||
-            util::exists("/sdcard/windows/BstSharedFolder")
-        ) {
-            return core::add(brand_enum::BLUESTACKS);
-        }
+                // check cache first
+                const auto cache_it = module_cache.find(s_name);
+                if (cache_it != module_cache.end()) {
+                    functions[i] = cache_it->second;
+                    continue;
+                }
 
-        return false;
-    #endif
-    }
+                // binary search over names (names array is typically sorted)
+                DWORD lo = 0, hi = nameCount;
+                while (lo < hi) {
+                    const DWORD mid = lo + (hi - lo) / 2;
+                    const DWORD midNameRva = nameRvas[mid];
+                    const char* midName = cstr_from_rva(midNameRva);
+                    if (!midName) { // corrupted string table or something
+                        lo = hi;
+                        break;
+                    }
 
+                    const int cmp = strcmp(current_name, midName);
+                    if (cmp > 0) {
+                        lo = mid + 1;
+                    }
+                    else {
+                        hi = mid;
+                    }
+                }
 
-    /**
-	 * @brief Check for AMD-SEV MSR running on the system
-	 * @category x86, Linux, MacOS
-	 * @author idea from virt-what
-     * @warning Permissions required
-     * @implements VM::AMD_SEV_MSR
-	 */
-	[[nodiscard]] static bool amd_sev_msr() {
-    #if (x86 && (LINUX || APPLE))
-        if (!cpu::is_amd()) {
-            return false;
+                if (lo < nameCount) {
+                    const char* candidateName = cstr_from_rva(nameRvas[lo]);
+                    if (candidateName && strcmp(current_name, candidateName) == 0) {
+                        const WORD nameOrdinal = ordinals[lo];
+                        if (static_cast<DWORD>(nameOrdinal) >= funcCount) continue;
+                        const DWORD funcRva = funcRvas[nameOrdinal];
+                        if (!valid_range(static_cast<size_t>(funcRva), 1)) continue;
+                        void* addr = reinterpret_cast<void*>(base + funcRva);
+                        functions[i] = addr;
+                        module_cache[s_name] = addr;
+                        continue;
+                    }
+                }
+            }
         }
 
-        if (!util::is_admin()) {
-            return false;
-        }
 
-        constexpr u32 encrypted_memory_capability = 0x8000001f;
-        constexpr u32 msr_index = 0xc0010131;
+        [[nodiscard]] static HMODULE get_ntdll() {
+            static HMODULE cached_ntdll = nullptr;
+            if (cached_ntdll != nullptr) {
+                return cached_ntdll;
+            }
 
-        if (!cpu::is_leaf_supported(encrypted_memory_capability)) {
-            return false;
-        }
+        #ifndef _WINTERNL_
+            typedef struct _UNICODE_STRING {
+                USHORT Length;
+                USHORT MaximumLength;
+                PWSTR  Buffer;
+            } UNICODE_STRING, * PUNICODE_STRING;
 
-        u32 eax = 0;
-        u32 unused = 0;
+            typedef struct _PEB_LDR_DATA {
+                BYTE Reserved1[8];
+                PVOID Reserved2[3];
+                LIST_ENTRY InMemoryOrderModuleList;
+            } PEB_LDR_DATA, * PPEB_LDR_DATA;
 
-        cpu::cpuid(eax, unused, unused, unused, encrypted_memory_capability);
+            typedef struct _LDR_DATA_TABLE_ENTRY {
+                PVOID Reserved1[2];
+                LIST_ENTRY InMemoryOrderLinks;
+                PVOID Reserved2[2];
+                PVOID DllBase;
+                PVOID Reserved3[2];
+                UNICODE_STRING FullDllName;
+                BYTE Reserved4[8];
+                PVOID Reserved5[3];
+            #if (MSVC)
+            #pragma warning(suppress: 4201)
+            #endif
+                union {
+                    ULONG CheckSum;
+                    PVOID Reserved6;
+                } DUMMYUNIONNAME;
+                ULONG TimeDateStamp;
+            } LDR_DATA_TABLE_ENTRY, * PLDR_DATA_TABLE_ENTRY;
 
-        if (!(eax & (1 << 1))) {
-            return false;
-        }
+            typedef struct _PEB {
+                BYTE Reserved1[2];
+                BYTE BeingDebugged;
+                BYTE Reserved2[1];
+                PVOID Reserved3[2];
+                PPEB_LDR_DATA Ldr;
+            } PEB, * PPEB;
+        #endif
 
-        u64 result = 0;
+            PPEB peb = nullptr;
 
-        const std::string msr_device = "/dev/cpu/0/msr";
-        std::ifstream msr_file(msr_device, std::ios::binary);
+        #if (x86_64)
+            #if (MSVC && !CLANG)
+                peb = reinterpret_cast<PPEB>(__readgsqword(0x60));
+            #else
+                asm("movq %%gs:0x60, %0" : "=r"(peb));
+            #endif
+        #elif (x86_32)
+            #if (MSVC&& !CLANG)
+                peb = reinterpret_cast<PPEB>(__readfsdword(0x30));
+            #else
+                asm("movl %%fs:0x30, %0" : "=r"(peb));
+            #endif
+        #endif
 
-        if (!msr_file.is_open()) {
-            debug("AMD_SEV: unable to open MSR file");
-            return false;
-        }
+            if (!peb) { // not x86 or tampered with
+                const HMODULE ntdll = GetModuleHandleW(L"ntdll.dll");
+                if (ntdll) cached_ntdll = ntdll;
+                return ntdll;
+            }
 
-        msr_file.seekg(msr_index);
-        msr_file.read(reinterpret_cast<char*>(&result), sizeof(result));
+            PPEB_LDR_DATA ldr = peb->Ldr;
+            if (!ldr) {
+                const HMODULE h = GetModuleHandleW(L"ntdll.dll");
+                if (h) cached_ntdll = h;
+                return h;
+            }
 
-        if (!msr_file) {
-            debug("AMD_SEV: unable to open MSR file");
-            return false;
-        }
+            #ifndef CONTAINING_RECORD
+                #define CONTAINING_RECORD(address, type, field) ((type *)((char*)(address) - (size_t)(&((type *)0)->field)))
+            #endif
 
-        if (result & (static_cast<u64>(1) << 2)) { return core::add(brand_enum::AMD_SEV_SNP); }
-        if (result & (static_cast<u64>(1) << 1)) { return core::add(brand_enum::AMD_SEV_ES); }
-        if (result & 1) { return core::add(brand_enum::AMD_SEV); }
+            constexpr WCHAR target_name[] = L"ntdll.dll";
+            constexpr size_t target_length = (std::size(target_name) - 1);
 
-        return false;
-    #else
-        return false;
-    #endif
-    }
+            LIST_ENTRY* head = &ldr->InMemoryOrderModuleList;
+            // static analyzers don't know that InMemoryOrderModuleList is a circular list managed by the loader
+            // so they conservatively assume head->Flink or some cur->Flink might be nullptr
+            for (LIST_ENTRY* cur = head->Flink; cur != nullptr && cur != head; cur = cur->Flink) {
+                auto* ent = CONTAINING_RECORD(cur, LDR_DATA_TABLE_ENTRY, InMemoryOrderLinks);
+                if (!ent) continue;
 
+                auto* fullname = &ent->FullDllName;
+                if (!fullname->Buffer || fullname->Length == 0) continue;
 
-    /**
-     * @brief Check for presence of QEMU in the /sys/devices/virtual/dmi/id directory
-     * @category Linux
-     * @implements VM::QEMU_VIRTUAL_DMI
-     */
-    [[nodiscard]] static bool qemu_virtual_dmi() {
-        const char* sys_vendor = "/sys/devices/virtual/dmi/id/sys_vendor";
-        const char* modalias = "/sys/devices/virtual/dmi/id/modalias";
+                const auto total_chars = static_cast<USHORT>(fullname->Length / sizeof(WCHAR));
 
-        if (
-            util::exists(sys_vendor) &&
-            util::exists(modalias)
-        ) {
-            const std::string sys_vendor_str = util::read_file(sys_vendor);
-            const std::string modalias_str = util::read_file(modalias);
+                size_t start = total_chars;
+                while (start > 0) {
+                    const WCHAR c = fullname->Buffer[start - 1];
+                    if (c == L'\\' || c == L'/') break;
+                    --start;
+                }
 
-            if (
-                util::find(sys_vendor_str, "QEMU") &&
-                util::find(modalias_str, "QEMU")
-            ) {
-                return core::add(brand_enum::QEMU);
+                const size_t file_length = total_chars - start;
+                if (file_length != target_length) continue;
+
+                bool match = true;
+                for (size_t i = 0; i < file_length; ++i) {
+                    WCHAR a = fullname->Buffer[start + i];
+                    WCHAR b = target_name[i];
+                    if (a >= L'A' && a <= L'Z') a = static_cast<WCHAR>(a + 32);
+                    if (b >= L'A' && b <= L'Z') b = static_cast<WCHAR>(b + 32);
+                    if (a != b) { match = false; break; }
+                }
+
+                if (match) {
+                    cached_ntdll = reinterpret_cast<HMODULE>(ent->DllBase);
+                    return cached_ntdll;
+                }
             }
-        }
 
-        return false;
-    }
+            const HMODULE h = GetModuleHandleW(L"ntdll.dll");
+            if (h) cached_ntdll = h;
+            return h;
+        } 
 
 
-    /**
-     * @brief Check for presence of QEMU in the /sys/kernel/debug/usb/devices directory
-     * @category Linux
-     * @warning Permissions required
-     * @implements VM::QEMU_USB
-     */
-    [[nodiscard]] static bool qemu_USB() {
-        if (!util::is_admin()) {
-            return false;
-        }
-
-        constexpr const char* usb_path = "/sys/kernel/debug/usb/devices";
+        static bool get_manufacturer_model(const char** out_manufacturer, const char** out_model) {
+            if (out_manufacturer) *out_manufacturer = "";
+            if (out_model) *out_model = "";
 
-        std::ifstream file(usb_path);
-        if (!file) {
-            return false;
-        }
+            auto is_placeholder = [](const char* s) noexcept -> bool {
+                if (!s || !*s) {
+                    return true;
+                }
 
-        std::string line;
-        while (std::getline(file, line)) {
-            if (line.find("QEMU") != std::string::npos) {
-                return true;
-            }
-        }
+                return std::strcmp(s, "System Product Name") == 0 ||
+                    std::strcmp(s, "To Be Filled By O.E.M.") == 0 ||
+                    std::strcmp(s, "Default string") == 0 ||
+                    std::strcmp(s, "Not Specified") == 0 ||
+                    std::strcmp(s, "None") == 0;
+            };
 
-        return false;
-    }
+            auto read_reg_utf8 = [](const wchar_t* value_name, char* out, size_t out_size) -> bool {
+                if (!out || out_size == 0) {
+                    return false;
+                }
 
+                out[0] = '\0';
 
-    /**
-     * @brief Check for presence of any files in /sys/hypervisor directory
-     * @category Linux
-     * @implements VM::HYPERVISOR_DIR
-     */
-    [[nodiscard]] static bool hypervisor_dir() {
-        DIR* dir = opendir("/sys/hypervisor");
+                WCHAR wbuf[256]{};
+                DWORD cb = sizeof(wbuf);
 
-        if (dir == nullptr) {
-            return false;
-        }
+                const LSTATUS st = RegGetValueW(
+                    HKEY_LOCAL_MACHINE,
+                    L"HARDWARE\\DESCRIPTION\\System\\BIOS",
+                    value_name,
+                    RRF_RT_REG_SZ,
+                    nullptr,
+                    wbuf,
+                    &cb
+                );
 
-        const struct dirent* entry{};
-        int count = 0;
+                if (st != ERROR_SUCCESS || wbuf[0] == L'\0') {
+                    return false;
+                }
 
-        while ((entry = readdir(dir)) != nullptr) {
-            if (
-                (entry->d_name[0] == '.' && entry->d_name[1] == '\0') || 
-                (entry->d_name[1] == '.' && entry->d_name[2] == '\0')
-            ) {
-                continue;
-            }
+                const int conv = WideCharToMultiByte(
+                    CP_UTF8,
+                    0,
+                    wbuf,
+                    -1,
+                    out,
+                    static_cast<int>(out_size),
+                    nullptr,
+                    nullptr
+                );
 
-            count++;
-            break;
-        }
+                if (conv <= 0) {
+                    out[0] = '\0';
+                    return false;
+                }
 
-        closedir(dir);
+                out[out_size - 1] = '\0';
+                return true;
+            };
 
-        bool type = false;
+            if (memo::bios_info::is_cached()) {
+                const char* man = memo::bios_info::fetch_manufacturer();
+                const char* mod = memo::bios_info::fetch_model();
 
-        if (util::exists("/sys/hypervisor/type")) {
-            type = true;
-        }
+                if (out_manufacturer) *out_manufacturer = man;
+                if (out_model) *out_model = mod;
 
-        if (type) {
-            const std::string content = util::read_file("/sys/hypervisor/type");
-            if (util::find(content, "xen")) {
-                return core::add(brand_enum::XEN);
+                return !is_placeholder(man) || !is_placeholder(mod);
             }
-        }
-
-        // check if there's a few files in that directory
-        return ((count != 0) && type);
-    } 
-
-
-    /**
-     * @brief Check for the "UML" string in the CPU brand
-     * @author idea from https://github.com/ShellCode33/VM-Detection/blob/master/vmdetect/linux.go
-     * @category Linux
-     * @implements VM::UML_CPU
-     */
-    [[nodiscard]] static bool uml_cpu() {
-        // method 1, get the CPU brand model
-        const std::string brand = cpu::get_brand();
-
-        if (brand == "UML") {
-            return core::add(brand_enum::UML);
-        }
 
-        // method 2, match for the "User Mode Linux" string in /proc/cpuinfo
-        const char* file = "/proc/cpuinfo";
+            char man_tmp[sizeof(memo::bios_info::manufacturer)]{};
+            char model_tmp[sizeof(memo::bios_info::model)]{};
 
-        if (util::exists(file)) {
-            const std::string file_content = util::read_file(file);
+            bool got_any = false;
 
-            if (util::find(file_content, "User Mode Linux")) {
-                return core::add(brand_enum::UML);
+            // Manufacturer priority:
+            // 1) SystemManufacturer
+            // 2) BaseBoardManufacturer
+            // 3) BIOS vendor string if needed later
+            if (read_reg_utf8(L"SystemManufacturer", man_tmp, sizeof(man_tmp)) &&
+                !is_placeholder(man_tmp)) {
+                got_any = true;
             }
-        }
-
-        return false;
-    } 
-
-
-    /**
-     * @brief Check for any indications of hypervisors in the kernel message logs
-     * @author idea from https://github.com/ShellCode33/VM-Detection/blob/master/vmdetect/linux.go
-     * @category Linux
-     * @warning Permissions required
-     * @implements VM::KMSG
-     */
-    [[nodiscard]] static bool kmsg() {
-        if (!util::is_admin()) {
-            return false;
-        }
-
-        const int fd = open("/dev/kmsg", O_RDONLY | O_NONBLOCK);
-        if (fd < 0) {
-            debug("KMSG: Failed to open /dev/kmsg");
-            return false;
-        }
-
-        char buffer[1024] = {};
-        std::stringstream ss;
-
-        while (true) {
-            const ssize_t bytes_read = read(fd, buffer, sizeof(buffer) - 1);
-
-            if (bytes_read > 0) {
-                *(buffer + bytes_read) = '\0';
-                ss << buffer;
-            } else if (bytes_read == 0) {
-                usleep(100000); // Sleep for 100 milliseconds
-            } else {
-                if (errno == EAGAIN) {
-                    usleep(100000);
-                } else {
-                    debug("KMSG: Error reading /dev/kmsg");
-                    break;
-                }
+            else if (read_reg_utf8(L"BaseBoardManufacturer", man_tmp, sizeof(man_tmp)) &&
+                !is_placeholder(man_tmp)) {
+                got_any = true;
             }
-
-            if (bytes_read < 0) {
-                break;
+            else {
+                man_tmp[0] = '\0';
             }
-        }
-
-        close(fd);
-
-        const std::string content = ss.str();
 
-        if (content.empty()) {
-            return false;
-        }
-
-        return (util::find(content, "Hypervisor detected"));
-    } 
-
-
-    /**
-     * @brief Check for a VBox kernel module
-     * @author idea from https://github.com/ShellCode33/VM-Detection/blob/master/vmdetect/linux.go
-     * @category Linux
-     * @implements VM::VBOX_MODULE
-     */
-    [[nodiscard]] static bool vbox_module() {
-        const char* file = "/proc/modules";
+            // Model priority:
+            // 1) SystemProductName
+            // 2) BaseBoardProduct
+            // 3) SystemSKU
+            // 4) BaseBoardVersion
+            if (read_reg_utf8(L"SystemProductName", model_tmp, sizeof(model_tmp)) &&
+                !is_placeholder(model_tmp)) {
+                got_any = true;
+            }
+            else if (read_reg_utf8(L"BaseBoardProduct", model_tmp, sizeof(model_tmp)) &&
+                !is_placeholder(model_tmp)) {
+                got_any = true;
+            }
+            else if (read_reg_utf8(L"SystemSKU", model_tmp, sizeof(model_tmp)) &&
+                !is_placeholder(model_tmp)) {
+                got_any = true;
+            }
+            else if (read_reg_utf8(L"BaseBoardVersion", model_tmp, sizeof(model_tmp)) &&
+                !is_placeholder(model_tmp)) {
+                got_any = true;
+            }
+            else {
+                model_tmp[0] = '\0';
+            }
 
-        if (!util::exists(file)) {
-            return false;
-        }
+            memo::bios_info::store(man_tmp, model_tmp);
 
-        const std::string content = util::read_file(file);
+            if (out_manufacturer) *out_manufacturer = memo::bios_info::fetch_manufacturer();
+            if (out_model) *out_model = memo::bios_info::fetch_model();
 
-        if (util::find(content, "vboxguest")) {
-            return core::add(brand_enum::VBOX);
+            return got_any;
         }
 
-        return false;
-    }
-
-
-    /**
-     * @brief Check for VMware string in /proc/scsi/scsi
-     * @category Linux
-     * @author idea from ScoopyNG by Tobias Klein
-     * @implements VM::VMWARE_SCSI
-     */
-    [[nodiscard]] static bool vmware_scsi() {
-        const std::string scsi_file = util::read_file("/proc/scsi/scsi");
+        // indirect call without CFG checks
+        #if (MSVC)
+            #define NO_CF_GUARD __declspec(guard(nocf)) __declspec(noinline)
+        #elif (CLANG)
+            #if __has_declspec_attribute(guard)
+                #define NO_CF_GUARD __declspec(guard(nocf)) __attribute__((noinline))
+            #elif __has_attribute(nocf_check)
+                #define NO_CF_GUARD __attribute__((nocf_check)) __attribute__((noinline))
+            #else
+                #define NO_CF_GUARD __attribute__((noinline))
+            #endif
+        #elif (GCC)
+            #if defined(__has_attribute) && __has_attribute(nocf_check)
+                #define NO_CF_GUARD __attribute__((nocf_check)) __attribute__((noinline))
+            #else
+                #define NO_CF_GUARD __attribute__((noinline))
+            #endif
+            #else
+                #define NO_CF_GUARD
+        #endif
 
-        if (util::find(scsi_file, "VMware")) {
-            return core::add(brand_enum::VMWARE);
+        // helper function to invoke pointers without instrumentation
+        NO_CF_GUARD static void execute_unchecked(void* pointer) {
+            using func_t = void(*)();
+            reinterpret_cast<func_t>(pointer)();
         }
+    #endif
+    };
 
-        return false;
-    }
 
-        
-    /**
-     * @brief Check for VMware-specific device name in dmesg output
-     * @category Linux
-     * @author idea from ScoopyNG by Tobias Klein
-     * @note Disabled by default
-     * @warning Permissions required
-     * @implements VM::VMWARE_DMESG
-     */
-    [[nodiscard]] static bool vmware_dmesg() {
-        if (!util::is_admin()) {
-            return false;
-        }
-
-        if (!util::exists("/usr/bin/dmesg")) {
-            return false;
-        }
+    struct brands {
+        static constexpr const char* NULL_BRAND = "Unknown";
+        static constexpr const char* VBOX = "VirtualBox";
+        static constexpr const char* VMWARE = "VMware";
+        static constexpr const char* VMWARE_EXPRESS = "VMware Express";
+        static constexpr const char* VMWARE_ESX = "VMware ESX";
+        static constexpr const char* VMWARE_GSX = "VMware GSX";
+        static constexpr const char* VMWARE_WORKSTATION = "VMware Workstation";
+        static constexpr const char* VMWARE_FUSION = "VMware Fusion";
+        static constexpr const char* VMWARE_HARD = "VMware (with VmwareHardenedLoader)";
+        static constexpr const char* BHYVE = "bhyve";
+        static constexpr const char* KVM = "KVM";
+        static constexpr const char* QEMU = "QEMU";
+        static constexpr const char* QEMU_KVM = "QEMU+KVM";
+        static constexpr const char* KVM_HYPERV = "KVM Hyper-V Enlightenment";
+        static constexpr const char* QEMU_KVM_HYPERV = "QEMU+KVM Hyper-V Enlightenment";
+        static constexpr const char* HYPERV = "Microsoft Hyper-V";
+        static constexpr const char* HYPERV_VPC = "Microsoft Virtual PC/Hyper-V";
+        static constexpr const char* PARALLELS = "Parallels";
+        static constexpr const char* XEN = "Xen HVM";
+        static constexpr const char* ACRN = "ACRN";
+        static constexpr const char* QNX = "QNX hypervisor";
+        static constexpr const char* HYBRID = "Hybrid Analysis";
+        static constexpr const char* SANDBOXIE = "Sandboxie";
+        static constexpr const char* DOCKER = "Docker";
+        static constexpr const char* WINE = "Wine";
+        static constexpr const char* VPC = "Virtual PC";
+        static constexpr const char* ANUBIS = "Anubis";
+        static constexpr const char* JOEBOX = "JoeBox";
+        static constexpr const char* THREATEXPERT = "ThreatExpert";
+        static constexpr const char* CWSANDBOX = "CWSandbox";
+        static constexpr const char* COMODO = "Comodo";
+        static constexpr const char* BOCHS = "Bochs";
+        static constexpr const char* NVMM = "NetBSD NVMM";
+        static constexpr const char* BSD_VMM = "OpenBSD VMM";
+        static constexpr const char* INTEL_HAXM = "Intel HAXM";
+        static constexpr const char* UNISYS = "Unisys s-Par";
+        static constexpr const char* LMHS = "Lockheed Martin LMHS";
+        static constexpr const char* CUCKOO = "Cuckoo";
+        static constexpr const char* BLUESTACKS = "BlueStacks";
+        static constexpr const char* JAILHOUSE = "Jailhouse";
+        static constexpr const char* APPLE_VZ = "Apple VZ";
+        static constexpr const char* INTEL_KGT = "Intel KGT (Trusty)";
+        static constexpr const char* AZURE_HYPERV = "Microsoft Azure Hyper-V";
+        static constexpr const char* SIMPLEVISOR = "SimpleVisor";
+        static constexpr const char* HYPERV_ROOT = "Hyper-V root partition (host system, not an actual VM)";
+        static constexpr const char* UML = "User-mode Linux";
+        static constexpr const char* POWERVM = "IBM PowerVM";
+        static constexpr const char* GCE = "Google Compute Engine (KVM)";
+        static constexpr const char* OPENSTACK = "OpenStack (KVM)";
+        static constexpr const char* KUBEVIRT = "KubeVirt (KVM)";
+        static constexpr const char* AWS_NITRO = "AWS Nitro System EC2 (KVM-based)";
+        static constexpr const char* PODMAN = "Podman";
+        static constexpr const char* WSL = "WSL";
+        static constexpr const char* OPENVZ = "OpenVZ";
+        static constexpr const char* BAREVISOR = "Barevisor";
+        static constexpr const char* HYPERPLATFORM = "HyperPlatform";
+        static constexpr const char* MINIVISOR = "MiniVisor";
+        static constexpr const char* INTEL_TDX = "Intel TDX";
+        static constexpr const char* LKVM = "LKVM";
+        static constexpr const char* AMD_SEV = "AMD SEV";
+        static constexpr const char* AMD_SEV_ES = "AMD SEV-ES";
+        static constexpr const char* AMD_SEV_SNP = "AMD SEV-SNP";
+        static constexpr const char* NEKO_PROJECT = "Neko Project II";
+        static constexpr const char* NOIRVISOR = "NoirVisor";
+        static constexpr const char* QIHOO = "Qihoo 360 Sandbox";
+        static constexpr const char* DBVM = "DBVM";
+        static constexpr const char* UTM = "UTM";
+        static constexpr const char* COMPAQ = "Compaq FX!32";
+        static constexpr const char* INSIGNIA = "Insignia RealPC";
+        static constexpr const char* CONNECTIX = "Connectix Virtual PC";
+        static constexpr const char* CONTAINERD = "Containerd";
 
-        auto dmesg_output = util::sys_result("dmesg");
-        const std::string& dmesg_o = *dmesg_output;
+        static brand_list_t brand_list(const flagset& flags) {
+            // a tier only sees part of the techniques, so it neither uses nor fills the cache
+            if (core::is_tiered(flags)) {
+                const u16 score = core::run_all(flags);
+                return rank_brands(score, core::active_brands(core::scoreboard_for(flags)));
+            }
 
-        if (dmesg_o.empty()) {
-            return false;
-        }
+            if (memo::brand_list::is_cached()) {
+                return memo::brand_list::fetch();
+            }
 
-        if (util::find(dmesg_o, "BusLogic BT-958")) {
-            return core::add(brand_enum::VMWARE);
-        }
+            // run all the techniques
+            const u16 score = core::run_all(flags);
 
-        if (util::find(dmesg_o, "pcnet32")) {
-            return core::add(brand_enum::VMWARE);
+            return cache_brand_list(score);
         }
 
-        return false;
-    }
-
+        // same as above, but for a full run that already happened
+        static brand_list_t cache_brand_list(const u16 score) {
+            if (memo::brand_list::is_cached()) {
+                return memo::brand_list::fetch();
+            }
 
-    /**
-     * @brief Check for potential VM info in /proc/sysinfo
-     * @author idea from https://github.com/ShellCode33/VM-Detection/blob/master/vmdetect/linux.go
-     * @category Linux
-     * @implements VM::SYSINFO_PROC
-     */
-    [[nodiscard]] static bool sysinfo_proc() {
-        const char* file = "/proc/sysinfo";
+            const brand_list_t active_brands = rank_brands(score);
 
-        if (!util::exists(file)) {
-            return false;
+            memo::brand_list::store(active_brands);
+            return active_brands;
         }
 
-        const std::string content = util::read_file(file);
-
-        if (util::find(content, "VM00")) {
-            return true;
+        // builds the sorted and merged brand list out of the current scoreboard, without touching the cache
+        static brand_list_t rank_brands(const u16 score) {
+            return rank_brands(score, core::active_brands(core::scoreboard_snapshot()));
         }
 
-        return false;
-    } 
+        // same as above, but for brands that were already collected out of some other scoreboard
+        static brand_list_t rank_brands(const u16 score, brand_list_t active_brands) {
 
+            #ifdef __VMAWARE_DEBUG__
+                for (const auto& brand : active_brands) {
+                    debug("pre-processed scoreboard: ", int(brand.second), " : ", brands::brand_enum_to_string(brand.first));
+                }
+            #endif
 
-    /**
-     * @brief Check for string matches of VM brands in the linux DMI
-     * @category Linux
-     * @implements VM::DMI_SCAN
-     */
-    [[nodiscard]] static bool dmi_scan() {
-        /*
-        cat: /sys/class/dmi/id/board_serial: Permission denied
-        cat: /sys/class/dmi/id/chassis_serial: Permission denied
-        cat: /sys/class/dmi/id/product_serial: Permission denied
-        cat: /sys/class/dmi/id/product_uuid: Permission denied
-        */
+            auto remove = [&](const enum brand_enum brand) noexcept {
+                for (auto it = active_brands.begin(); it != active_brands.end(); ++it) {
+                    if (it->first == brand) {
+                        active_brands.erase(it);
+                        return;
+                    }
+                }
+            };
 
-        constexpr std::array<const char*, 7> dmi_array{
-            "/sys/class/dmi/id/bios_vendor",
-            "/sys/class/dmi/id/board_name",
-            "/sys/class/dmi/id/board_vendor",
-            "/sys/class/dmi/id/chassis_asset_tag",
-            "/sys/class/dmi/id/product_family",
-            "/sys/class/dmi/id/product_sku",
-            "/sys/class/dmi/id/sys_vendor"
-        };
-
-        constexpr std::array<std::pair<const char*, enum brand_enum>, 15> vm_table{ {
-            { "kvm", brand_enum::KVM },
-            { "openstack", brand_enum::OPENSTACK },
-            { "kubevirt", brand_enum::KUBEVIRT },
-            { "amazon ec2", brand_enum::AWS_NITRO },
-            { "qemu", brand_enum::QEMU },
-            { "vmware", brand_enum::VMWARE },
-            { "innotek gmbh", brand_enum::VBOX },
-            { "virtualbox", brand_enum::VBOX },
-            { "oracle corporation", brand_enum::VBOX },
-            { "bochs", brand_enum::BOCHS },
-            { "parallels", brand_enum::PARALLELS },
-            { "bhyve", brand_enum::BHYVE },
-            { "hyper-v", brand_enum::HYPERV },
-            { "apple virtualization", brand_enum::APPLE_VZ },
-            { "google compute engine", brand_enum::GCE }
-        } };
+            // if all brands have a point of 0, return "Unknown"
+            if (active_brands.empty()) {                        
+                active_brands.emplace_back(brand_enum::NULL_BRAND, 1);
+                return active_brands;
+            }
 
+            // if there's only a single brand, return it immediately
+            // We skip this early return if the single brand is HYPERV_ARTIFACT,
+            // but we must also nullify the result if the score is above 0, 
+            // which would most likely indicate a hardened VM instead and return "Unknown".
+            if (active_brands.size() == 1) {
+                const enum brand_enum brand = active_brands.front().first;
 
-        for (const auto file : dmi_array) {
-            if (!util::exists(file)) {
-                continue;
+                if (brand == brand_enum::HYPERV_ROOT && score > 0) {
+                    active_brands.emplace_back(brand_enum::NULL_BRAND, 1);
+                    remove(brand_enum::HYPERV_ROOT);
+                }
+
+                return active_brands;
             }
 
-            std::string content = util::read_file(file);
-            if (content.empty()) {
-                continue;
+            // remove Hyper-V artifacts and Unknown if found with other brands
+            if (active_brands.size() > 1) {
+                remove(brand_enum::HYPERV_ROOT);
+                remove(brand_enum::NULL_BRAND);
+                remove(brand_enum::INVALID);
             }
 
-            char* data = &content[0];
-            const size_t len = content.size();
+            // this bitset acts as an abstraction layer for the merging stage of this function.
+            // the amount of hits above 0 for a brand isn't relevant, the core idea here is to
+            // just check the presence of the brand itself so we can merge them. 
+            std::bitset<MAX_BRANDS> brand_hits = {};
 
-            for (size_t i = 0; i < len; ++i) {
-                if (data[i] >= 'A' && data[i] <= 'Z') {
-                    data[i] |= 0x20;
-                }
+            for (const auto& brand : active_brands) {
+                brand_hits.set(static_cast<u8>(brand.first));
             }
 
-            for (const auto& vm_string : vm_table) {
-                if (content.find(vm_string.first) != std::string::npos) {
-
-                    debug("DMI_SCAN: content = ", content);
+            // merge 2 brands into one
+            auto merge = [&](const enum brand_enum a, const enum brand_enum b, const enum brand_enum result) noexcept -> void {
+                const bool a_hit = brand_hits.test(static_cast<u8>(a));
+                const bool b_hit = brand_hits.test(static_cast<u8>(b));
 
-                    if (vm_string.second == brand_enum::AWS_NITRO) {
-                        if (smbios_vm_bit()) {
-                            return core::add(brand_enum::AWS_NITRO);
-                        }
-                    } else {
-                        return core::add(vm_string.second);
-                    }
+                if (a_hit && b_hit) {
+                    remove(a);
+                    remove(b);
+                    active_brands.emplace_back(result, 2);
                 }
-            }
-        }
+            };
 
-        return false;
-    }
+            // same as above, but for 3
+            auto triple_merge = [&](const enum brand_enum a, const enum brand_enum b, const enum brand_enum c, const enum brand_enum result) noexcept -> void {
+                const bool a_hit = brand_hits.test(static_cast<u8>(a));
+                const bool b_hit = brand_hits.test(static_cast<u8>(b));
+                const bool c_hit = brand_hits.test(static_cast<u8>(c));
 
+                if (a_hit && b_hit && c_hit) {
+                    remove(a);
+                    remove(b);
+                    remove(c);
+                    active_brands.emplace_back(result, 2);
+                }
+            };
 
-    /**
-     * @brief Check for the VM bit in the SMBIOS data
-     * @author idea from https://github.com/systemd/systemd/blob/main/src/basic/virt.c
-     * @category Linux
-     * @warning Permissions required
-     * @implements VM::SMBIOS_VM_BIT
-     */
-    [[nodiscard]] static bool smbios_vm_bit() {
-        if (!util::is_admin()) {
-            return false;
-        }
+            // Brand post-processing / merging
+            merge(brand_enum::VPC, brand_enum::HYPERV, brand_enum::HYPERV_VPC);
 
-        const char* file = "/sys/firmware/dmi/entries/0-0/raw";
+            merge(brand_enum::AZURE_HYPERV, brand_enum::HYPERV, brand_enum::AZURE_HYPERV);
+            merge(brand_enum::AZURE_HYPERV, brand_enum::VPC, brand_enum::AZURE_HYPERV);
+            merge(brand_enum::AZURE_HYPERV, brand_enum::HYPERV_VPC, brand_enum::AZURE_HYPERV);
 
-        if (!util::exists(file)) {
-            return false;
-        }
+            merge(brand_enum::QEMU, brand_enum::KVM, brand_enum::QEMU_KVM);
+            merge(brand_enum::KVM, brand_enum::HYPERV, brand_enum::KVM_HYPERV);
+            merge(brand_enum::QEMU, brand_enum::HYPERV, brand_enum::QEMU_KVM_HYPERV);
+            merge(brand_enum::QEMU_KVM, brand_enum::HYPERV, brand_enum::QEMU_KVM_HYPERV);
 
-        const std::vector<u8> content = util::read_file_binary(file);
+            merge(brand_enum::KVM, brand_enum::HYPERV_VPC, brand_enum::KVM_HYPERV);
+            merge(brand_enum::QEMU, brand_enum::HYPERV_VPC, brand_enum::QEMU_KVM_HYPERV);
+            merge(brand_enum::QEMU_KVM, brand_enum::HYPERV_VPC, brand_enum::QEMU_KVM_HYPERV);
 
-        if (content.size() < 20 || content.at(1) < 20) {
-            debug("SMBIOS_VM_BIT: ", "only read ", content.size(), " bytes, expected 20");
-            return false;
-        }
+            merge(brand_enum::KVM, brand_enum::KVM_HYPERV, brand_enum::KVM_HYPERV);
+            merge(brand_enum::QEMU, brand_enum::KVM_HYPERV, brand_enum::QEMU_KVM_HYPERV);
+            merge(brand_enum::QEMU_KVM, brand_enum::KVM_HYPERV, brand_enum::QEMU_KVM_HYPERV);
 
-        debug("SMBIOS_VM_BIT: ", "content.at(19) = ", static_cast<int>(content.at(19)));
+            merge(brand_enum::HYPERV_VPC, brand_enum::KVM_HYPERV, brand_enum::KVM_HYPERV);
+            merge(brand_enum::HYPERV, brand_enum::KVM_HYPERV, brand_enum::KVM_HYPERV);
+            merge(brand_enum::HYPERV_VPC, brand_enum::QEMU_KVM_HYPERV, brand_enum::QEMU_KVM_HYPERV);
+            merge(brand_enum::HYPERV, brand_enum::QEMU_KVM_HYPERV, brand_enum::QEMU_KVM_HYPERV);
 
-        return (content.at(19) & (1 << 4));
-    } 
+            triple_merge(brand_enum::QEMU, brand_enum::KVM, brand_enum::KVM_HYPERV, brand_enum::QEMU_KVM_HYPERV);
 
+            merge(brand_enum::VMWARE, brand_enum::VMWARE_FUSION, brand_enum::VMWARE_FUSION);
+            merge(brand_enum::VMWARE, brand_enum::VMWARE_EXPRESS, brand_enum::VMWARE_EXPRESS);
+            merge(brand_enum::VMWARE, brand_enum::VMWARE_ESX, brand_enum::VMWARE_ESX);
+            merge(brand_enum::VMWARE, brand_enum::VMWARE_GSX, brand_enum::VMWARE_GSX);
+            merge(brand_enum::VMWARE, brand_enum::VMWARE_WORKSTATION, brand_enum::VMWARE_WORKSTATION);
 
-    /**
-     * @brief Check for podman file in /run/
-     * @author idea from https://github.com/systemd/systemd/blob/main/src/basic/virt.c
-     * @category Linux
-     * @implements VM::PODMAN_FILE
-     */
-    [[nodiscard]] static bool podman_file() {
-        if (util::exists("/run/.containerenv")) {
-            return core::add(brand_enum::PODMAN);
-        }
+            merge(brand_enum::VMWARE_HARD, brand_enum::VMWARE, brand_enum::VMWARE_HARD);
+            merge(brand_enum::VMWARE_HARD, brand_enum::VMWARE_FUSION, brand_enum::VMWARE_HARD);
+            merge(brand_enum::VMWARE_HARD, brand_enum::VMWARE_EXPRESS, brand_enum::VMWARE_HARD);
+            merge(brand_enum::VMWARE_HARD, brand_enum::VMWARE_ESX, brand_enum::VMWARE_HARD);
+            merge(brand_enum::VMWARE_HARD, brand_enum::VMWARE_GSX, brand_enum::VMWARE_HARD);
+            merge(brand_enum::VMWARE_HARD, brand_enum::VMWARE_WORKSTATION, brand_enum::VMWARE_HARD);
 
-        return false;
-    }
+            if (active_brands.size() > 1) {
+                std::sort(active_brands.begin(), active_brands.begin() + static_cast<std::ptrdiff_t>(active_brands.size()), [](
+                    const brand_element_t& a,
+                    const brand_element_t& b
+                ) {
+                    return a.second > b.second; // .second = brand score (usually u8)
+                });
+            }
 
+        #ifdef __VMAWARE_DEBUG__
+            for (const auto& brand : active_brands) {
+                debug("post-processed scoreboard: ", static_cast<u32>(brand.second), " : ", brands::brand_enum_to_string(brand.first));
+            }
+        #endif
 
-    /**
-     * @brief Check for VMware string in /proc/ioports
-     * @category Linux
-     * @author idea from ScoopyNG by Tobias Klein
-     * @implements VM::VMWARE_IOPORTS
-     */
-    [[nodiscard]] static bool vmware_ioports() {
-        const std::string ioports_file = util::read_file("/proc/ioports");
-    
-        if (util::find(ioports_file, "VMware")) {
-            return core::add(brand_enum::VMWARE);
+            return active_brands;
         }
-    
-        return false;
-    }
-
-
-    /**
-     * @brief Check for WSL or microsoft indications in /proc/ subdirectories
-     * @author idea from https://github.com/systemd/systemd/blob/main/src/basic/virt.c
-     * @category Linux
-     * @implements VM::WSL_PROC
-     */
-    [[nodiscard]] static bool wsl_proc_subdir() {
-        auto read_proc_nonblock = [](const char* path) -> std::string {
-            const int fd = open(path, O_RDONLY | O_NONBLOCK);
 
-            if (fd < 0) {
-                return "";
+        static const char* brand_enum_to_string(const brand_enum brand) {
+            switch (brand) {
+                case brand_enum::INVALID: return "Invalid";
+                case brand_enum::VBOX: return VM::brands::VBOX;
+                case brand_enum::VMWARE: return VM::brands::VMWARE;
+                case brand_enum::VMWARE_EXPRESS: return VM::brands::VMWARE_EXPRESS;
+                case brand_enum::VMWARE_ESX: return VM::brands::VMWARE_ESX;
+                case brand_enum::VMWARE_GSX: return VM::brands::VMWARE_GSX;
+                case brand_enum::VMWARE_WORKSTATION: return VM::brands::VMWARE_WORKSTATION;
+                case brand_enum::VMWARE_FUSION: return VM::brands::VMWARE_FUSION;
+                case brand_enum::VMWARE_HARD: return VM::brands::VMWARE_HARD;
+                case brand_enum::BHYVE: return VM::brands::BHYVE;
+                case brand_enum::KVM: return VM::brands::KVM;
+                case brand_enum::QEMU: return VM::brands::QEMU;
+                case brand_enum::QEMU_KVM: return VM::brands::QEMU_KVM;
+                case brand_enum::KVM_HYPERV: return VM::brands::KVM_HYPERV;
+                case brand_enum::QEMU_KVM_HYPERV: return VM::brands::QEMU_KVM_HYPERV;
+                case brand_enum::HYPERV: return VM::brands::HYPERV;
+                case brand_enum::HYPERV_VPC: return VM::brands::HYPERV_VPC;
+                case brand_enum::PARALLELS: return VM::brands::PARALLELS;
+                case brand_enum::XEN: return VM::brands::XEN;
+                case brand_enum::ACRN: return VM::brands::ACRN;
+                case brand_enum::QNX: return VM::brands::QNX;
+                case brand_enum::HYBRID: return VM::brands::HYBRID;
+                case brand_enum::SANDBOXIE: return VM::brands::SANDBOXIE;
+                case brand_enum::DOCKER: return VM::brands::DOCKER;
+                case brand_enum::WINE: return VM::brands::WINE;
+                case brand_enum::VPC: return VM::brands::VPC;
+                case brand_enum::ANUBIS: return VM::brands::ANUBIS;
+                case brand_enum::JOEBOX: return VM::brands::JOEBOX;
+                case brand_enum::THREATEXPERT: return VM::brands::THREATEXPERT;
+                case brand_enum::CWSANDBOX: return VM::brands::CWSANDBOX;
+                case brand_enum::COMODO: return VM::brands::COMODO;
+                case brand_enum::BOCHS: return VM::brands::BOCHS;
+                case brand_enum::NVMM: return VM::brands::NVMM;
+                case brand_enum::BSD_VMM: return VM::brands::BSD_VMM;
+                case brand_enum::INTEL_HAXM: return VM::brands::INTEL_HAXM;
+                case brand_enum::UNISYS: return VM::brands::UNISYS;
+                case brand_enum::LMHS: return VM::brands::LMHS;
+                case brand_enum::CUCKOO: return VM::brands::CUCKOO;
+                case brand_enum::BLUESTACKS: return VM::brands::BLUESTACKS;
+                case brand_enum::JAILHOUSE: return VM::brands::JAILHOUSE;
+                case brand_enum::APPLE_VZ: return VM::brands::APPLE_VZ;
+                case brand_enum::INTEL_KGT: return VM::brands::INTEL_KGT;
+                case brand_enum::AZURE_HYPERV: return VM::brands::AZURE_HYPERV;
+                case brand_enum::SIMPLEVISOR: return VM::brands::SIMPLEVISOR;
+                case brand_enum::HYPERV_ROOT: return VM::brands::HYPERV_ROOT;
+                case brand_enum::UML: return VM::brands::UML;
+                case brand_enum::POWERVM: return VM::brands::POWERVM;
+                case brand_enum::GCE: return VM::brands::GCE;
+                case brand_enum::OPENSTACK: return VM::brands::OPENSTACK;
+                case brand_enum::KUBEVIRT: return VM::brands::KUBEVIRT;
+                case brand_enum::AWS_NITRO: return VM::brands::AWS_NITRO;
+                case brand_enum::PODMAN: return VM::brands::PODMAN;
+                case brand_enum::WSL: return VM::brands::WSL;
+                case brand_enum::OPENVZ: return VM::brands::OPENVZ;
+                case brand_enum::BAREVISOR: return VM::brands::BAREVISOR;
+                case brand_enum::HYPERPLATFORM: return VM::brands::HYPERPLATFORM;
+                case brand_enum::MINIVISOR: return VM::brands::MINIVISOR;
+                case brand_enum::INTEL_TDX: return VM::brands::INTEL_TDX;
+                case brand_enum::LKVM: return VM::brands::LKVM;
+                case brand_enum::AMD_SEV: return VM::brands::AMD_SEV;
+                case brand_enum::AMD_SEV_ES: return VM::brands::AMD_SEV_ES;
+                case brand_enum::AMD_SEV_SNP: return VM::brands::AMD_SEV_SNP;
+                case brand_enum::NEKO_PROJECT: return VM::brands::NEKO_PROJECT;
+                case brand_enum::NOIRVISOR: return VM::brands::NOIRVISOR;
+                case brand_enum::QIHOO: return VM::brands::QIHOO;
+                case brand_enum::DBVM: return VM::brands::DBVM;
+                case brand_enum::UTM: return VM::brands::UTM;
+                case brand_enum::COMPAQ: return VM::brands::COMPAQ;
+                case brand_enum::INSIGNIA: return VM::brands::INSIGNIA;
+                case brand_enum::CONNECTIX: return VM::brands::CONNECTIX;
+                case brand_enum::CONTAINERD: return VM::brands::CONTAINERD;
+                case brand_enum::NULL_BRAND: return VM::brands::NULL_BRAND; // do not modify placement of this, it's used as an anchor point to count the number of brands
             }
 
-            char buf[512] = {};
-            const ssize_t n = read(fd, buf, sizeof(buf) - 1);
-
-            close(fd);
+            return "Invalid";
+        }
 
-            if (n <= 0) {
-                return "";
+        static std::string fetch_brand_name(const brand_list_t& list, const size_t index) {
+            return brand_enum_to_string(list.at(index).first);
+        };
+    
+        static std::string brand_multiple(const flagset& flags = core::generate_default()) {
+            if (core::is_tiered(flags)) {
+                return brand_multiple(brands::brand_list(flags));
             }
 
-            return { buf, static_cast<size_t>(n) };
-        };
+            if (memo::multi_brand::is_cached()) {
+                return memo::multi_brand::fetch();
+            }
 
-        const std::string osrelease = read_proc_nonblock("/proc/sys/kernel/osrelease");
-        const std::string version = read_proc_nonblock("/proc/version");
+            const brand_list_t& list = brands::brand_list(flags);
+            const std::string& buffer = brand_multiple(list);
 
-        if (osrelease.empty() || version.empty()) {
-            return false;
+            memo::multi_brand::store(buffer);
+            return buffer;
         }
+            
+        static std::string brand_multiple(const brand_list_t& list) {
+            std::string buffer = {};
+            buffer += brands::fetch_brand_name(list, 0);
 
-        if (
-            (util::find(osrelease, "WSL") || util::find(osrelease, "Microsoft")) &&
-            (util::find(version,   "WSL") || util::find(version,   "Microsoft"))
-        ) {
-            return core::add(brand_enum::WSL);
+            for (size_t i = 1; i < list.size(); i++) {
+                buffer += " or "; 
+                buffer += brands::fetch_brand_name(list, i);
+            }
+
+            return buffer;
         }
 
-        return false;
-    }
+        static brand_enum brand_single(const flagset& flags = core::generate_default()) {
+            if (core::is_tiered(flags)) {
+                return brand_single(brands::brand_list(flags));
+            }
 
+            if (memo::single_brand::is_cached()) {
+                return memo::single_brand::fetch();
+            }
 
-    /**
-     * @brief Detect QEMU fw_cfg interface. This first checks the Device Tree for a fw-cfg node or hypervisor tag, then verifies the presence of the qemu_fw_cfg module and firmware directories in sysfs.
-     * @category Linux
-     * @implements VM::QEMU_FW_CFG
-     */
-     [[nodiscard]] static bool qemu_fw_cfg() {
-        // Linux DT method: inspired by https://github.com/ShellCode33/VM-Detection
-        // Linux sysfs method: looks for /sys/module/qemu_fw_cfg/ & /sys/firmware/qemu_fw_cfg/
+            const brand_list_t& list = brands::brand_list(flags);
+            const enum brand_enum brand = brand_single(list);
+    
+            memo::single_brand::store(brand);
 
-        // 1) Device Tree-based detection
-        if (util::exists("/proc/device-tree/fw-cfg")) {
-            return core::add(brand_enum::QEMU);
-        }
-        if (util::exists("/proc/device-tree/hypervisor/compatible")) {
-            return core::add(brand_enum::QEMU);
+            return brand;
         }
 
-        // 2) sysfs-based detection
-        const char* module_path = "/sys/module/qemu_fw_cfg/";
-        const char* firmware_path = "/sys/firmware/qemu_fw_cfg/";
-        if (util::is_directory(module_path) && util::exists(module_path) &&
-            util::is_directory(firmware_path) && util::exists(firmware_path)) {
-            return core::add(brand_enum::QEMU);
+        static enum brand_enum brand_single(const brand_list_t& list) {
+            const brand_element_t brand = list.front();
+            return brand.first;
         }
+    };
 
-        return false;
-    }
+// START OF PRIVATE VM DETECTION TECHNIQUE DEFINITIONS
 
+#if (MSVC)
+    #pragma region "x86"
+#endif
 
+#if 1 //  meant for closing this whole section in the IDE
     /**
-     * @brief Check if the number of accessed files are too low for a human-managed environment
-     * @category Linux
-     * @author idea from https://unprotect.it/technique/xbel-recently-opened-files-check/
-     * @implements VM::FILE_ACCESS_HISTORY
+     * @brief Check CPUID output of manufacturer ID for known VMs/hypervisors at leaf 0 and 0x40000000-0x40000100
+     * @category x86
+     * @implements VM::VMID
      */
-    [[nodiscard]] static bool file_access_history() {
-        const std::string xbel_file = util::read_file("~/.local/share/recently-used.xbel");
-        
-        if (xbel_file.empty()) {
-            debug("FILE_ACCESS_HISTORY: file content is empty");
-            return false;
-        }
-
-        const std::string key = "href";
-
-        u32 count = 0;
-        std::size_t pos = 0;
-
-        while ((pos = xbel_file.find(key, pos)) != std::string::npos) {
-            count++;
-            pos += key.length();
-        }
-
-        return (count <= 10); 
+     [[nodiscard]] static bool vmid() {
+    #if (!x86)
+        return false;
+    #else
+        return (
+            cpu::vmid_template(0) ||
+            cpu::vmid_template(cpu::leaf::hypervisor) || // 0x40000000
+            cpu::vmid_template(cpu::leaf::hypervisor + 0x100) // 0x40000100
+        );
+    #endif
     }
 
 
     /**
-     * @brief Check if process status matches with container patterns with PID anomalies
-     * @category Linux
-     * @implements VM::CONTAINER_PID
+     * @brief Check if CPU brand model contains any VM-specific string snippets
+     * @category x86
+     * @implements VM::CPU_BRAND
      */
-    [[nodiscard]] static bool container_proc_id() {
-        std::ifstream status_file("/proc/self/status");
-        if (!status_file.is_open()) {
-            return false;
-        }
-
-        std::string line;
-        bool pid_match = false;
-        bool ppid_match = false;
-
-        auto parse_number = [&](const std::string& prefix) -> int {
-            if (line.rfind(prefix, 0) != 0) {
-                return -1;
-            }
-
-            int num = 0;
-            for (size_t i = prefix.size(); i < line.size(); ++i) {
-                const u8 ch = static_cast<u8>(line.at(i));
-                if (std::isdigit(ch)) {
-                    num = (num * 10) + (ch - '0');
-                }
-                else if (num > 0) {
-                    break;
-                }
+    [[nodiscard]] static bool cpu_brand() {
+    #if (!x86)
+        return false;
+    #else
+        const std::string& brand = cpu::get_brand();
+
+        // easy shortcut for QEMU
+        if (brand.rfind("QEMU Virtual CPU version", 0) == 0) {
+            return core::add(brand_enum::QEMU);
+        }
+
+        struct cstrview {
+            const char* data;
+            std::size_t size;
+            constexpr cstrview(const char* d, std::size_t s) noexcept
+                : data(d), size(s) {
             }
-            return num;
         };
 
-        while (std::getline(status_file, line)) {
-            const int pid = parse_number("Pid:");
-            if (pid == 1) {
-                pid_match = true;
-            }
+        static constexpr std::array<cstrview, 10> checks{ {
+            { "qemu",       4 },
+            { "kvm",        3 },
+            { "vbox",       4 },
+            { "virtualbox", 10},
+            { "monitor",    7 },
+            { "bhyve",      5 },
+            { "hypervisor", 10},
+            { "hvisor",     6 },
+            { "parallels",  9 },
+            { "vmware",     6 }
+        } };
 
-            const int ppid = parse_number("PPid:");
-            if (ppid == 0) {
-                ppid_match = true;
+        for (auto& v : checks) {
+            if (brand.size() < v.size) {
+                continue;  // too short to match
             }
 
-            if (pid_match && ppid_match) {
-                return true;
+            if (brand.find(v.data) != std::string::npos) {
+                debug("CPU_BRAND: match = ", v.data);
+
+                // For these, we only care that it's virtualized:
+                if (v.size == 7  // "monitor"
+                    || ((v.size == 6) && (v.data[0] == 'h'))  // "hvisor"
+                    || ((v.size == 10) && (v.data[0] == 'h')) // "hypervisor" 
+                ) {
+                    return true;
+                }
+
+                // Otherwise map to our enums:
+                switch (v.size) {
+                case 4:  // "qemu" or "vbox"
+                    return core::add(v.data[0] == 'q'
+                        ? brand_enum::QEMU
+                        : brand_enum::VBOX);
+                case 3:  // "kvm"
+                    return core::add(brand_enum::KVM);
+                case 5:  // "bhyve"
+                    return core::add(brand_enum::BHYVE);
+                case 9:  // "parallels"
+                    return core::add(brand_enum::PARALLELS);
+                case 10: // "virtualbox"
+                    return core::add(brand_enum::VBOX);
+                case 6:  // "vmware"
+                    return core::add(brand_enum::VMWARE);
+                default:
+                    return false;
+                }
             }
         }
 
         return false;
+    #endif
     }
 
 
     /**
-     * @brief Check for device's temperature
-     * @category Linux
-     * @implements VM::TEMPERATURE
+     * @brief Check if hypervisor feature bit in CPUID ECX bit 31 is enabled (always false for physical CPUs)
+     * @category x86
+     * @implements VM::HYPERVISOR_BIT
      */
-    [[nodiscard]] static bool temperature() {
-        if (util::exists("/sys/class/thermal/cooling_device0")) {
-            return false;
+    [[nodiscard]] static bool hypervisor_bit() {
+    #if (!x86)
+        return false;
+    #else
+        u32 eax = 0;
+        u32 ebx = 0; 
+        u32 ecx = 0; 
+        u32 edx = 0;
+
+        cpu::cpuid(eax, ebx, ecx, edx, 1); 
+        constexpr u32 HYPERVISOR_MASK = (1u << 31);
+
+        if (ecx & HYPERVISOR_MASK) {
+            // if hypervisor bit is enabled, but we're in a root partition, prevent it from flagging
+            if (util::hyper_x() == HYPERV_ARTIFACT_VM) {
+                return false;
+            }
+
+            return true;
         }
-        return (!util::exists("/sys/class/thermal/thermal_zone0/"));
+
+        // if hypervisor bit is disabled, but vmaware detects hyper-v signals, we're in an impossible situation (patching)
+        if (util::hyper_x() == HYPERV_ARTIFACT_VM) {
+            return true;
+        }
+
+        return false;
+    #endif
     }
 
 
     /**
-     * @brief Check for cgroup paths in /proc/self/cgroup
-     * @category Linux
-     * @implements VM::CGROUP
+     * @brief Check for hypervisor brand string length (would be around 2 characters in a host machine)
+     * @category x86
+     * @implements VM::HYPERVISOR_STR
      */
-    [[nodiscard]] static bool cgroup() {
-        const std::string contents = util::read_file("/proc/self/cgroup");
-        
-        if (contents.empty()) {
+    [[nodiscard]] static bool hypervisor_str() {
+    #if (!x86)
+        return false;
+    #else
+        if (util::hyper_x() == HYPERV_ARTIFACT_VM) {
             return false;
         }
 
-        if (contents.find("docker") != std::string::npos) {
-            return core::add(brand_enum::DOCKER);
-        }
+        char out[(sizeof(i32) * 4) + 1] = { 0 }; // e*x size + number of e*x registers + null terminator
+        cpu::cpuid(reinterpret_cast<int*>(out), cpu::leaf::hypervisor);
 
-        if (contents.find("containerd") != std::string::npos) {
-            return core::add(brand_enum::CONTAINERD);
+        debug("HYPERVISOR_STR: \neax: ", static_cast<u32>(out[0]),
+            "\nebx: ", static_cast<u32>(out[1]),
+            "\necx: ", static_cast<u32>(out[2]),
+            "\nedx: ", static_cast<u32>(out[3])
+        );
+
+        return (std::strlen(out + 4) >= 4);
+    #endif  
+    }
+    
+
+    /**
+     * @brief Check for various Bochs-related emulation oversights through CPU checks
+     * @category x86
+     * @author Discovered by Peter Ferrie, Senior Principal Researcher, Symantec Advanced Threat Research peter_ferrie@symantec.com
+     * @implements VM::BOCHS_CPU
+     */
+    [[nodiscard]] static bool bochs_cpu() {
+    #if (!x86)
+        return false;
+    #else
+        const bool intel = cpu::is_intel();
+        const bool amd = cpu::is_amd();
+
+        // if neither amd or intel, return false
+        if (!(intel || amd)) {
+            debug("BOCHS_CPU: neither AMD or Intel detected, returned false");
+            return false;
         }
 
-        // look for a 64-char lowercase hex segment in any path component (cgroup v1)
-        for (size_t i = 0; i + 64 <= contents.size(); i++) {
-            bool hex_run = true;
+        const std::string brand = cpu::get_brand();
+
+        if (intel) {
+            // technique 1: not a valid brand 
+            if (brand == "              Intel(R) Pentium(R) 4 CPU        ") {
+                debug("BOCHS_CPU: technique 1 found");
+                return core::add(brand_enum::BOCHS);
+            }
+        } else if (amd) {
+            // technique 2: "processor" should have a capital P
+            if (brand == "AMD Athlon(tm) processor") {
+                debug("BOCHS_CPU: technique 2 found");
+                return core::add(brand_enum::BOCHS);
+            }
 
-            for (size_t j = i; j < i + 64; j++) {
-                const char c = contents.at(j);
+            // technique 3: Check for absence of AMD easter egg for K7 and K8 CPUs
+            constexpr u32 AMD_EASTER_EGG = 0x8fffffff; // this is the CPUID leaf of the AMD easter egg
 
-                if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
-                    hex_run = false;
-                    break;
-                }
+            if (!cpu::is_leaf_supported(AMD_EASTER_EGG)) {
+                return false;
             }
 
-            if (hex_run) {
-                char after = '\0';
+            u32 unused = 0;
+            u32 eax = 0;
+            cpu::cpuid(eax, unused, unused, unused, 1);
 
-                if (i + 64 < contents.size()) {
-                    after = contents.at(i + 64);
+            auto is_k7 = [](const u32 eax) noexcept -> bool {
+                if ((eax & 0x0FF00F00) != 0x00000600) {
+                    return false;
                 }
 
-                if (after == '\n' || after == '/' || after == '\0') {
-                    return core::add(brand_enum::DOCKER);
+                const u32 model = (eax >> 4) & 0xF;
+
+                return (model - 1) < 4;
+            };
+
+            auto is_k8 = [](const u32 eax) noexcept -> bool {
+                if (((eax >> 8) & 0xF) != 0xF) {
+                    return false;
                 }
-            }
-        }
 
-        // cgroup v2 with cgroup namespace isolation: Docker isolates the cgroup namespace
-        // so the unified hierarchy line appears as "0::/" (container sees itself as root)
-        size_t pos = 0;
+                const u32 extended_family = (eax >> 20) & 0xFF;
 
-        while (pos < contents.size()) {
-            const size_t end = contents.find('\n', pos);
-            std::string line = contents.substr(pos, end == std::string::npos ? end : end - pos);
-            pos = (end == std::string::npos) ? contents.size() : end + 1;
+                return extended_family <= 1;
+            };
 
-            while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) {
-                line.pop_back();
+            if (!(is_k7(eax) || is_k8(eax))) {
+                return false;
             }
 
-            if (line == "0::/") {
+            u32 ecx_bochs = 0;
+            cpu::cpuid(unused, unused, ecx_bochs, unused, AMD_EASTER_EGG);
+
+            if (ecx_bochs == 0) {
                 return true;
             }
         }
 
         return false;
+    #endif
     }
-
-
+       
+    
     /**
-     * @brief Check for any VM processes that are active
-     * @category Linux
-     * @implements VM::PROCESSES
+	 * @brief Check if the system's thread count matches the expected thread count for the detected CPU model
+     * @category x86
+     * @implements VM::THREAD_MISMATCH
      */
-    [[nodiscard]] static bool processes() {
-        if (util::is_proc_running("qemu_ga")) {
-            debug("PROCESSES: Detected QEMU guest agent process.");
-            return core::add(brand_enum::QEMU);
-        }
+    [[nodiscard]] static bool thread_mismatch() {
+    #if (!x86)
+        return false;
+    #else
+        auto is_smt_enabled = []() noexcept -> bool {
+        #if (WINDOWS)
+            DWORD len = 0;
+            if (GetLogicalProcessorInformationEx(RelationProcessorCore, nullptr, &len) ||
+                GetLastError() != ERROR_INSUFFICIENT_BUFFER) {
+                return false;
+            }
 
-        if (util::exists("/proc/xen")) {
-            return core::add(brand_enum::XEN);
-        }
+            std::vector<char> buf(static_cast<size_t>(len));
+            if (!GetLogicalProcessorInformationEx(RelationProcessorCore,
+                reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buf.data()), &len)) {
+                return false;
+            }
 
-        if (util::exists("/proc/vz")) {
-            return core::add(brand_enum::OPENVZ);
-        }
+            size_t offset = 0;
+            while (offset + sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX) <= static_cast<size_t>(len)) {
+                auto rec = reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buf.data() + offset);
 
-        return false;
-    }
-#endif
+                if (rec->Relationship == RelationProcessorCore) {
+                    const PROCESSOR_RELATIONSHIP& pr = rec->Processor;
+                    unsigned total = 0;
 
-#if (MSVC)
-    #pragma endregion
-    #pragma region "Linux and Windows"
-#endif
+                    for (WORD i = 0; i < pr.GroupCount; ++i) {
+                        total += util::popcount(static_cast<u64>(pr.GroupMask[i].Mask));
+                    }
 
-#if (LINUX || WINDOWS)
-    /**
-     * @brief Check for Task Segment and Descriptor Table instructions (SGDT, SLDT, SMSW, SIDT)
-     * @category Windows, Linux, x86, x86_32
-     * @implements VM::DESCRIPTOR_TABLES
-     * 
-     * --- SGDT ---
-     * @note code documentation paper in /papers/www.offensivecomputing.net_vm.pdf (top-most byte signature)
-     *
-     * --- SLDT ---
-     * @author Danny Quist (chamuco@gmail.com), ldtr_buf signature
-     * @author Val Smith (mvalsmith@metasploit.com), ldtr_buf signature
-     * @author code documentation paper in /papers/www.offensivecomputing.net_vm.pdf for ldtr_buf signature and in https://www.aldeid.com/wiki/X86-assembly/Instructions/sldt for ldt signature
-     *
-     * --- SMSW ---
-     * @author Danny Quist from Offensive Computing
-     *
-     * --- SIDT ---
-     * @author Matteo Malvica
-     * @author Idea to check VPC's range from Tom Liston and Ed Skoudis' paper "On the Cutting Edge: Thwarting Virtual Machine Detection" (Windows)
-     * @link https://www.matteomalvica.com/blog/2018/12/05/detecting-vmware-on-64-bit-systems/ (Linux)
-     * 
-     */
-    [[nodiscard]] static bool system_registers() {
-        // Even though SMSW queries a status register (CR0), it is historically grouped with descriptor table checks in virtualization detection 
-        // (often called "Red Pill" techniques)
-        bool found = false;
-
-        // Linux Implementation (SIDT only)
-    #if (LINUX && (GCC || CLANG) && x86)
-        u8 values[10] = { 0 }; // NOLINT(misc-const-correctness)
-
-        fflush(stdout);
-
-        #if (x86_64)
-            // 64-bit Linux: IDT descriptor is 10 bytes (2-byte limit + 8-byte base)
-            __asm__ __volatile__("sidt %0" : "=m"(values));
-
-        #ifdef __VMAWARE_DEBUG__
-            debug("SIDT: values = ");
-            for (u8 i = 0; i < 10; ++i) {
-                debug(std::hex, std::setw(2), std::setfill('0'), static_cast<u32>(values[i]));
-                if (i < 9) debug(" ");
-            }
-        #endif
+                    return total > 1;
+                }
 
-            if (values[9] == 0x00) {
-                found = true; // 10th byte in x64 mode
+                if (rec->Size == 0) break;
+                offset += rec->Size;
             }
-        #elif (x86_32)
-            // 32-bit Linux: IDT descriptor is 6 bytes (2-byte limit + 4-byte base)
-            __asm__ __volatile__("sidt %0" : "=m"(values));
+            return false;
+        #elif (APPLE)
+            int logical = 0, physical = 0;
+            size_t sz = sizeof(logical);
 
-        #ifdef __VMAWARE_DEBUG__
-            debug("SIDT: values = ");
-            for (u8 i = 0; i < 6; ++i) {
-                debug(std::hex, std::setw(2), std::setfill('0'), static_cast<u32>(values[i]));
-                if (i < 5) debug(" ");
+            if (sysctlbyname("hw.logicalcpu", &logical, &sz, nullptr, 0) != 0) {
+                logical = 0;
             }
-        #endif
-
-            if (values[5] == 0x00) found = true; // 6th byte in x86 mode
-        #endif
-
-        // Windows Implementation (SGDT, SLDT, SIDT, SMSW)
-    #elif (WINDOWS && x86)
-        SYSTEM_INFO si;
-        GetNativeSystemInfo(&si);
-        DWORD_PTR original_mask = 0;
-        const HANDLE current_thread = reinterpret_cast<HANDLE>(-2LL);
 
-        // Iterating processors for SGDT, SLDT, and SIDT
-        for (DWORD i = 0; i < si.dwNumberOfProcessors; ++i) {
-            const DWORD_PTR mask = (DWORD_PTR)1 << i;
-            const DWORD_PTR previous_mask = SetThreadAffinityMask(current_thread, mask);
+            sz = sizeof(physical);
 
-            if (previous_mask == 0) {
-                continue;
+            if (sysctlbyname("hw.physicalcpu", &physical, &sz, nullptr, 0) != 0) {
+                physical = 0;
             }
 
-            if (original_mask == 0) {
-                original_mask = previous_mask;
-            }
+            return logical > 0 && physical > 0 && logical > physical;
+        #else
+            const std::string& siblings = util::cached_file("/sys/devices/system/cpu/cpu0/topology/thread_siblings_list");
+            if (!siblings.empty()) {
+                const std::string s = siblings.substr(0, siblings.find('\n'));
+                {
+                    size_t a = 0;
+                    while (a < s.size() && std::isspace(static_cast<u8>(s[a]))) {
+                        ++a;
+                    }
 
-            // Technique 1: SGDT (x86 & x64)
-            {
-            #if (x86_64)
-                u8 gdtr[10] = { 0 };
-            #else
-                u8 gdtr[6] = { 0 };
-            #endif
+                    size_t b = s.size();
+                    while (b > a && std::isspace(static_cast<u8>(s[b - 1]))) {
+                        --b;
+                    }
 
-                __try {
-                #if (CLANG || GCC)
-                    __asm__ volatile("sgdt %0" : "=m"(gdtr));
-                #elif (MSVC && x86_32)
-                    __asm { sgdt gdtr }
-                #else
-                    #pragma pack(push,1)
-                    struct {
-                        u16 limit;
-                        u64 base;
-                    } _gdtr = {};
-                    #pragma pack(pop)
-                    _sgdt(&_gdtr);
-                    memcpy(gdtr, &_gdtr, sizeof(_gdtr));
-                #endif
+                    if (b > a) {
+                        for (size_t k = a; k < b; ++k) {
+                            if (s[k] == ',' || s[k] == '-') {
+                                return true;
+                            }
+                        }
+                        return false;
+                    }
                 }
-                __except (EXCEPTION_EXECUTE_HANDLER) {} // CR4.UMIP, default is disabled
-
-                ULONG_PTR gdt_base = 0;
-                memcpy(&gdt_base, &gdtr[2], sizeof(gdt_base));
+            }
 
-                if ((gdt_base >> 24) == 0xFF) {
-                    debug("SGDT: 0xFF signature detected on core %u", i);
-                    found = true;
-                }
+            const std::string& cpuinfo_content = util::cached_file("/proc/cpuinfo");
+            if (cpuinfo_content.empty()) {
+                return false;
             }
 
-            // Technique 2: SLDT (x86_32 only)
-            #if (x86_32)
-                if (!found) {
-                    u8 ldtr_buf[4] = { 0xEF, 0xBE, 0xAD, 0xDE };
-                    u32 ldt_val = 0;
+            std::istringstream cpuinfo(cpuinfo_content);
 
-                    __try {
-                    #if (CLANG || GCC)
-                        __asm__ volatile("sldt %0" : "=m"(*(u16*)ldtr_buf));
-                    #else  // MSVC
-                        __asm {
-                            sldt ax
-                            mov  word ptr[ldtr_buf], ax
-                        }
-                    #endif
-                    }
-                    __except (EXCEPTION_EXECUTE_HANDLER) {} // CR4.UMIP, default is disabled
+            std::string line;
+            int processors = 0;
+            int cur_phys = -1;
+            int cur_core = -1;
+            std::vector<std::pair<int, int>> cores;
 
-                    memcpy(&ldt_val, ldtr_buf, sizeof(ldt_val));
-                    if (ldtr_buf[0] != 0x00 && ldtr_buf[1] != 0x00) {
-                        debug("SLDT: ldtr_buf signature detected");
-                        found = true;
-                    }
-                    if (ldt_val != 0xDEAD0000) {
-                        debug("SLDT: 0xDEAD0000 signature detected");
-                        found = true;
+            while (std::getline(cpuinfo, line)) {
+                if (line.empty()) {
+                    if (cur_phys != -1 && cur_core != -1) {
+                        cores.emplace_back(cur_phys, cur_core);
                     }
+                    cur_phys = cur_core = -1;
+                    continue;
                 }
-            #endif
-
-                // Technique 3: SIDT (x86 & x64)
-                if (!found) {
-                #if (x86_64)
-                    u8 idtr_buffer[10] = { 0 };
-                #else
-                    u8 idtr_buffer[6] = { 0 };
-                #endif
-
-                    __try {
-                    #if (CLANG || GCC)
-                        __asm__ volatile("sidt %0" : "=m"(idtr_buffer));
-                    #elif (MSVC) && (x86_32)
-                        __asm { sidt idtr_buffer }
-                    #elif (MSVC) && (x86_64)
-                        #pragma pack(push, 1)
-                        struct {
-                            USHORT Limit;
-                            ULONG_PTR Base;
-                        } idtr;
-                        #pragma pack(pop)
-                        __sidt(&idtr);
-                        memcpy(idtr_buffer, &idtr, sizeof(idtr));
-                    #endif
-                    }
-                    __except (EXCEPTION_EXECUTE_HANDLER) {} // CR4.UMIP, default is disabled
-
-                    ULONG_PTR idt_base = 0;
-                    memcpy(&idt_base, &idtr_buffer[2], sizeof(idt_base));
 
-                    // Check for the 0xE8 signature (VPC/Hyper-V) in the high byte
-                    if ((idt_base >> 24) == 0xE8) {
-                        debug("SIDT: VPC/Hyper-V signature detected on core %u", i);
-                        found = true;
-                    }
+                auto pos = line.find(':');
+                if (pos == std::string::npos) {
+                    continue;
                 }
 
-            if (found) break;
-        }
+                std::string key = line.substr(0, pos);
+                std::string val = line.substr(pos + 1);
 
-        if (original_mask != 0) {
-            SetThreadAffinityMask(current_thread, original_mask);
-        }
+                while (!key.empty() && std::isspace(static_cast<u8>(key.back()))) {
+                    key.pop_back();
+                }
 
-        // Technique 4: SMSW (x86_32 only), no affinity pinning needed
-        #if (x86_32)
-            if (!found) {
-                u32 reax = 0;
-                __asm
-                {
-                    mov eax, 0xCCCCCCCC;
-                    smsw eax;
-                    mov DWORD PTR[reax], eax;
+                while (!val.empty() && std::isspace(static_cast<u8>(val.front()))) {
+                    val.erase(val.begin());
                 }
 
-                if ((((reax >> 24) & 0xFF) == 0xCC) && (((reax >> 16) & 0xFF) == 0xCC)) {
-                    debug("SMSW: Signature detected");
-                    found = true;
+                if (key == "processor") {
+                    processors++;
+                }
+                else if (key == "physical id") {
+                    try { cur_phys = std::stoi(val); }
+                    catch (...) { cur_phys = -1; }
+                }
+                else if (key == "core id") {
+                    try { cur_core = std::stoi(val); }
+                    catch (...) { cur_core = -1; }
                 }
             }
-        #endif
-    #endif
 
-        return found;
-    }
+            if (cur_phys != -1 && cur_core != -1) {
+                cores.emplace_back(cur_phys, cur_core);
+            }
 
+            if (!cores.empty() && processors > 0) {
+                std::sort(cores.begin(), cores.end());
+                cores.erase(std::unique(cores.begin(), cores.end()), cores.end());
+                const int physical_cores = static_cast<int>(cores.size());
+                return processors > physical_cores;
+            }
+            return false;
+        #endif
+        };
 
-    /**
-     * @brief Check for default Azure hostname format (Azure uses Hyper-V as their base VM brand)
-     * @category Windows, Linux
-     * @implements VM::AZURE
-     */
-    [[nodiscard]] static bool azure() noexcept {
-        // Returns 1u if alphanumeric, 0u if not. Here we use unsigned integers
-        // instead of booleans because MSVC's IntelliSense is stupid and avoids warnings 
-        // about bitwise operations on boolean types
-        auto is_alnum_ascii = [](char c) noexcept -> unsigned int {
-            const auto l = static_cast<unsigned char>(c | 0x20);
-            const auto d = static_cast<unsigned char>(c);
+        const auto& info = cpu::analyze_cpu();
+        
+        if (info.found) {
+            debug(info.debug_tag, ": CPU model = ", info.model_name);
 
-            const unsigned int is_letter = (static_cast<unsigned char>(l - 'a') < 26) ? 1u : 0u;
-            const unsigned int is_digit = (static_cast<unsigned char>(d - '0') < 10) ? 1u : 0u;
+        #if (WINDOWS)
+            const char* manufacturer = "";
+            const char* model = "";
+            util::get_manufacturer_model(&manufacturer, &model);
+            debug(info.debug_tag, ": {\"manufacturer\": \"", manufacturer,
+                "\", \"model\": \"", model, "\"}");
+        #endif
 
-            return is_letter | is_digit;
-        };
+            const u32 actual = memo::threadcount::fetch();
 
-    #if (WINDOWS)
-        char buf[MAX_COMPUTERNAME_LENGTH + 1];
-        DWORD len = sizeof(buf);
+            if (actual != info.expected_threads) {
+                debug(info.debug_tag, ": Current threads -> ", actual);
+                const bool smt = is_smt_enabled();
 
-        if (!GetComputerNameA(buf, &len) || len != 13) {
-            return false;
-        }
-    #elif (LINUX)
-        // 16 bytes fits 13-char hostname and the null-terminator
-        char buf[16] = { 0 };
+                if (smt) {
+                    debug(info.debug_tag, ": Expected ", info.expected_threads, " threads");
+                    return true;
+                }
 
-        if (gethostname(buf, sizeof(buf)) != 0) {
-            return false;
+                debug(info.debug_tag, ": Expected ", info.expected_threads,
+                    " threads, but found SMT disabled");
+                return false;
+            }
         }
 
-        if (buf[13] != '\0') {
-            return false;
-        }
-    #else
         return false;
     #endif
-
-        if (std::memcmp(buf, "runnervm", 8) != 0) {
-            return false;
-        }
-
-        const unsigned int is_match = is_alnum_ascii(buf[8]) &
-            is_alnum_ascii(buf[9]) &
-            is_alnum_ascii(buf[10]) &
-            is_alnum_ascii(buf[11]) &
-            is_alnum_ascii(buf[12]);
-
-        if (is_match != 0u) {
-            return core::add(brand_enum::AZURE_HYPERV);
-        }
-        return false;
     }
 
 
     /**
-     * @brief Check for VM signatures on all firmware tables
-     * @category Windows, Linux
-     * @authors Requiem, dmfrpro, MegaMax
-     * @warning Permissions required
-     * @implements VM::FIRMWARE
+     * @brief Check for CPUID signatures that reveal the presence of a hypervisor
+     * @category x86
+     * @implements VM::CPUID_SIGNATURE
      */
-    [[nodiscard]] static bool firmware() {
-    #if (WINDOWS)
-        struct acpi_header {
-            char signature[4];
-            u32 length;
-            u8 revision;
-        };
-
-        struct fadt_table {
-            u32 signature;
-            u32 length;
-            u8 revision;
-            u8 checksum;
-            char oem_id[6];
-            char oem_table_id[8];
-            u32 oem_revision;
-            char asl_compiler_id[4];
-            u32 asl_compiler_revision;
+    [[nodiscard]] static bool cpuid_signature() {
+    #if (!x86)
+        return false;
+    #else
+        u32 eax = 0;
+        u32 ebx = 0;
+        u32 ecx = 0;
+        u32 edx = 0;
+        cpu::cpuid(eax, ebx, ecx, edx, 0x40000001);
 
-            u32 firmware_ctrl;
-            u32 dsdt;
-            u8 reserved1;
-            u8 preferred_pm_profile;
-            u16 sci_interrupt;
-            u32 smi_command_port;
-            u8 acpi_enable;
-            u8 acpi_disable;
-            u8 s4_bios_req;
-            u8 reserved2;
-            u32 pstate_control;
-            u32 pm1a_event_block;
-            u32 pm1b_event_block;
-            u32 pm1a_control_block;
-            u32 pm1b_control_block;
-            u32 pm2_control_block;
-            u32 pm_timer_block;
-            u32 gpe0_block;
-            u32 gpe1_block;
-            u8 pm1_event_length;
-            u8 pm1_control_length;
-            u8 pm2_control_length;
-            u8 pm_timer_length;
+        constexpr u32 simplevisor = 0x00766853; // " vhS"
 
-            u16 p_lvl2_lat;
-            u16 p_lvl3_lat;
-        };
+        debug("CPUID_SIGNATURE: eax = ", eax);
 
-        // "WAET" is also present as a string inside the WAET table, so there's no need to check for its table signature
-        constexpr std::array<const char*, 21> targets = { {
-            "Parallels Software", "Parallels(R)",
-            "innotek",            "Oracle",   "VirtualBox", "vbox", "VBOX",
-            "VMware, Inc.",       "VMware",   "VMWARE",     "VMW0003",
-            "QEMU",               "pc-q35",   "Q35 +",      "BOCHS",
-            "ovmf",               "edk ii unknown", "WAET", "S3 Corp.", "VS2005R2",
-            "Xen"
-        } };
+        if (eax == simplevisor) {
+            return core::add(brand_enum::SIMPLEVISOR);
+        }
 
-        constexpr std::array<brand_enum, 21> brands_map = { {
-            brand_enum::PARALLELS,  brand_enum::PARALLELS,
-            brand_enum::VBOX,       brand_enum::VBOX,       brand_enum::VBOX,       brand_enum::VBOX,       brand_enum::VBOX,
-            brand_enum::VMWARE,     brand_enum::VMWARE,     brand_enum::VMWARE,     brand_enum::VMWARE,
-            brand_enum::QEMU,       brand_enum::QEMU,       brand_enum::QEMU,       brand_enum::BOCHS,
-            brand_enum::NULL_BRAND, brand_enum::NULL_BRAND, brand_enum::NULL_BRAND, brand_enum::NULL_BRAND, brand_enum::NULL_BRAND,
-            brand_enum::XEN
-        } };
+        if (cpu::is_intel()) {
+            const bool has_leaf_b = cpu::is_leaf_supported(0x0B);
+            const bool has_leaf_1f = cpu::is_leaf_supported(0x1F);
 
-        // inside struct to not have to move out of function, constexpr this way because of c++ 11 compatibility
-        struct array_validator {
-            static constexpr bool verify_no_nulls(const std::array<const char*, 21>& arr, size_t i) {
-                return (i == arr.size())
-                    ? true
-                    : (arr[i] != nullptr && verify_no_nulls(arr, i + 1));
+            // If neither extended topology leaf is supported, we can't perform the check
+            if (!has_leaf_b && !has_leaf_1f) {
+                return false;
             }
-        };
-
-        // ensure sizes match
-        static_assert(targets.size() == brands_map.size(),
-            "FIRMWARE: 'targets' and 'brands_map' must have the same size.");
 
-        // detects if you increased size but forgot strings
-        static_assert(array_validator::verify_no_nulls(targets, 0),
-            "FIRMWARE: 'targets' array contains NULLs. Array size declared is larger than the number of strings provided.");
+            u32 l1_eax = 0;
+            u32 l1_ebx = 0; 
+            u32 l1_ecx = 0; 
+            u32 l1_edx = 0;
+            
+            u32 vb_eax = 0;
+            u32 vb_ebx = 0; 
+            u32 vb_ecx = 0; 
+            u32 vb_edx = 0;
+            
+            u32 v1f_eax = 0;
+            u32 v1f_ebx = 0; 
+            u32 v1f_ecx = 0; 
+            u32 v1f_edx = 0;
 
-        auto scan_buffer = [&](const u8* buffer, const size_t buffer_len) noexcept -> bool {
-            // faster than std::search because of a manual byte-by-byte loop, could be optimized further with Boyer-Moore-Horspool for large tables like DSDT
-            auto find_pattern = [&](const char* pattern, size_t pattern_len) noexcept -> bool {
-                if (pattern_len == 0 || pattern_len > buffer_len) return false;
-                const u8 first_byte = static_cast<u8>(pattern[0]);
-                const u8* base_ptr = buffer;
-                const u8* search_ptr = base_ptr;
-                size_t remaining_bytes = buffer_len;
-
-                while (remaining_bytes >= pattern_len) {
-                    const void* match = memchr(search_ptr, first_byte, remaining_bytes);
-                    if (!match) return false;
-                    const u8* match_ptr = static_cast<const u8*>(match);
-                    const size_t index = static_cast<size_t>(match_ptr - base_ptr);
-                    // ensure pattern fits
-                    if (index + pattern_len > buffer_len) return false;
-                    if (memcmp(match_ptr, pattern, pattern_len) == 0) return true;
-                    // advance one past this found first-byte and continue
-                    search_ptr = match_ptr + 1;
-                    remaining_bytes = buffer_len - static_cast<size_t>(search_ptr - base_ptr);
-                }
-                return false;
-            };
+            u32 aba_start = 0;
+            u32 aba_end = 0;
 
-            // 1) VM-specific firmware signatures. It is important that vm-specific checks run first because of the hardened detection logic
-            for (size_t i = 0; i < targets.size(); ++i) {
-                const char* pattern = targets[i];
-                const size_t pattern_len = strlen(pattern);
-                if (pattern_len > buffer_len) continue;
-
-                if (find_pattern(pattern, pattern_len)) {
-                    // special handling for Xen: must not have PXEN to prevent false flagging some baremetal systems
-                    if (strcmp(pattern, "Xen") == 0) {
-                        constexpr char pxen[] = "PXEN";
-                        constexpr size_t pxen_len = sizeof(pxen) - 1;
-                        const bool has_pxen = find_pattern(pxen, pxen_len);
-                        if (!has_pxen)
-                            return core::add(brand_enum::XEN);
-                        else
-                            continue;
-                    }
+            u32 unused = 0;
+            int retries = 0;
 
-                    // special handling for BOCHS: if BXPC is detected, check if "BOCHS" is present too
-                    if (strcmp(pattern, "BXPC") == 0) {
-                        constexpr char bochs[] = "BOCHS";
-                        constexpr size_t bochs_len = sizeof(bochs) - 1;
-                        const bool has_bochs = find_pattern(bochs, bochs_len);
-                        if (!has_bochs)
-                            return core::add(brand_enum::BOCHS);
-                        else
-                            continue;
-                    }
+            // triple-read ABA pattern to detect thread migration and bounded to 8 retries
+            // leaf 1's Initial APIC ID is the ABA guard
+            for (;;) {
+                cpu::cpuid(l1_eax, l1_ebx, l1_ecx, l1_edx, 1, 0);
+                aba_start = (l1_ebx >> 24) & 0xFF; // Initial APIC ID
 
-                    debug("FIRMWARE: Detected ", pattern);
-                    const enum brand_enum detected_brand = brands_map[i];
-                    return core::add(detected_brand);
+                if (has_leaf_b) {
+                    cpu::cpuid(vb_eax, vb_ebx, vb_ecx, vb_edx, 0x0B, 0);
                 }
-            }
 
-            // 2) known patches used by popular hardeners 
-            {
-                constexpr char marker[] = "777777";
+                if (has_leaf_1f) {
+                    cpu::cpuid(v1f_eax, v1f_ebx, v1f_ecx, v1f_edx, 0x1F, 0);
+                }
 
-                if (buffer_len >= 36) {
-                    // OEMID (6)
-                    char oem_id[7] = { 0 };
-                    memcpy(oem_id, buffer + 10, 6);
-                    // OEM Table ID (8)
-                    char oem_table_id[9] = { 0 };
-                    memcpy(oem_table_id, buffer + 16, 8);
+                cpu::cpuid(unused, l1_ebx, unused, unused, 1, 0);
+                aba_end = (l1_ebx >> 24) & 0xFF;
 
-                    // Creator / ASL Compiler ID (4) won't contain 6-char marker because its length is 4
-                    if (strstr(oem_id, marker) != nullptr) {
-                        debug("FIRMWARE: VMWareHardenedLoader found in OEMID -> '", oem_id, "'");
-                        return core::add(brand_enum::VMWARE_HARD);
-                    }
-                    if (strstr(oem_table_id, marker) != nullptr) {
-                        debug("FIRMWARE: VMWareHardenedLoader found in OEM Table ID -> '", oem_table_id, "'");
-                        return core::add(brand_enum::VMWARE_HARD);
-                    }
-                }
+                if (aba_start == aba_end || ++retries >= 8) { break; }
             }
 
-            if (!buffer || buffer_len < sizeof(acpi_header)) {
+            // If we hit the retry limit and the thread is still migrating, 
+            // abort the check to prevent false positives
+            if (aba_start != aba_end) {
                 return false;
             }
 
-            acpi_header header;
-            memcpy(&header, buffer, sizeof(header));
+            const u32 initial_apic_id = aba_start;
 
-            // 3) FADT specific checks
-            if (memcmp(header.signature, "FACP", 4) == 0) {
-                if (header.length > buffer_len) {
-                    debug("FIRMWARE: declared header length larger than fetched length (declared ", header.length, ", fetched ", buffer_len, ")");
-                    return true;
-                }
-                if (buffer_len < sizeof(fadt_table)) {
-                    debug("FIRMWARE: FACP buffer too small (len ", buffer_len, ")");
-                    return true;
-                }
+            // check Leaf 0x0B against Leaf 1
+            if (has_leaf_b) {
+                const u32 vb_level = (vb_ecx >> 8) & 0xFF;
 
-                fadt_table fadt;
-                memcpy(&fadt, buffer, sizeof(fadt_table));
-
-                if (fadt.p_lvl2_lat == 0x0FFF || fadt.p_lvl3_lat == 0x0FFF) { // A value > 100 indicates the system does not support a C2/C3 state
-                    debug("FIRMWARE: C2 and C3 latencies indicate VM");
-                    return true;
+                if (vb_level != 0) {
+                    // if x2APIC ID is < 255, Initial APIC ID must match exactly
+                    if (vb_edx < 255 && (vb_edx & 0xFF) != initial_apic_id) {
+                        return true;
+                    }
                 }
             }
 
-            return false;
-        };
-
-        // to minimize heap allocations
-        std::vector<u8> work_buffer;
-        work_buffer.reserve(65536);
-
-        // Enumerate ACPI tables
-        constexpr DWORD acpi_signature = 'ACPI';
-        const DWORD acpi_enum_size = EnumSystemFirmwareTables(acpi_signature, nullptr, 0);
-        if (acpi_enum_size == 0) 
-            return false;
-        if (acpi_enum_size % sizeof(DWORD) != 0) 
-            return false;
-       
-        const size_t table_count = acpi_enum_size / sizeof(DWORD);
-        std::vector<DWORD> tables(table_count);
-        if (EnumSystemFirmwareTables(acpi_signature, tables.data(), acpi_enum_size) != acpi_enum_size)
-            return false;
-
-        // DSDT special fetch
-        {
-            constexpr DWORD dsdt_sig = 'DSDT';
-            constexpr DWORD dsdt_swapped =
-                ((dsdt_sig >> 24) & 0x000000FFu)
-                | ((dsdt_sig >> 8) & 0x0000FF00u)
-                | ((dsdt_sig << 8) & 0x00FF0000u)
-                | ((dsdt_sig << 24) & 0xFF000000u);
+            // check Leaf 0x1F against Leaf 1, and cross-check with 0x0B
+            if (has_leaf_1f) {
+                const u32 v1f_level = (v1f_ecx >> 8) & 0xFF;
 
-            const UINT sz = GetSystemFirmwareTable(acpi_signature, dsdt_swapped, nullptr, 0);
-            if (sz > 0) {
-                if (sz > work_buffer.capacity()) work_buffer.reserve(sz);
-                work_buffer.resize(sz);
-                if (GetSystemFirmwareTable(acpi_signature, dsdt_swapped, work_buffer.data(), sz) == sz) {
-                    if (scan_buffer(work_buffer.data(), work_buffer.size())) {
+                if (v1f_level != 0) {
+                    // if x2APIC ID is < 255, Initial APIC ID must match exactly
+                    if (v1f_edx < 255 && (v1f_edx & 0xFF) != initial_apic_id) {
                         return true;
                     }
+
+                    // cross-check 0x0B vs 0x1F if both are supported and valid
+                    if (has_leaf_b) {
+                        const u32 vb_level = (vb_ecx >> 8) & 0xFF;
+                        if (vb_level != 0 && vb_edx != v1f_edx) {
+                            return true;
+                        }
+                    }
                 }
             }
         }
+        else if (cpu::is_amd()) {
+            const bool has_leaf_7 = cpu::is_leaf_supported(7);
 
-        // helper to fetch one table into a malloc'd buffer
-        auto fetch_and_scan = [&](DWORD provider, DWORD table_id) noexcept -> bool {
-            const DWORD sz = GetSystemFirmwareTable(provider, table_id, nullptr, 0);
-            if (sz == 0) return false;
-
-            if (sz > work_buffer.capacity()) work_buffer.reserve(sz);
-            work_buffer.resize(sz);
-
-            if (GetSystemFirmwareTable(provider, table_id, work_buffer.data(), sz) != sz) {
+            if (!has_leaf_7) {
                 return false;
             }
 
-            return scan_buffer(work_buffer.data(), sz);
-        };
+            u32 l7_eax = 0;
+            u32 l7_ebx = 0;
+            u32 l7_ecx = 0;
+            u32 l7_edx = 0;
+            cpu::cpuid(l7_eax, l7_ebx, l7_ecx, l7_edx, 7, 0);
 
-        // Scan every ACPI table, dont make explicit whitelisting/blacklisting because of possible bypasses
-        for (const auto table_id : tables) {
-            if (fetch_and_scan(acpi_signature, table_id)) {
+            // Intel enumerates hardware mitigations in Leaf 7.0.EDX:
+            // Bit 26: IBRS and IBPB
+            // Bit 27: STIBP
+            // Bit 31: SSBD
+
+            // AMD processors strictly reserve these bits (force them to 0) 
+            // and instead enumerate their mitigations in Leaf 0x80000008.EBX
+            const bool has_intel_ibrs = (l7_edx & (1 << 26)) != 0;
+            const bool has_intel_stibp = (l7_edx & (1 << 27)) != 0;
+            const bool has_intel_ssbd = (l7_edx & (1 << 31)) != 0;
+
+            if (has_intel_ibrs || has_intel_stibp || has_intel_ssbd) {
                 return true;
             }
         }
 
-        // Scan SMBIOS (RSMB) / FIRM tables
-        constexpr DWORD smb_providers[] = { 'FIRM', 'RSMB' };
+        return false;
+    #endif
+    }
+                
+                
+    /**
+     * @brief Check for Intel KGT (Trusty branch) hypervisor signature in CPUID
+     * @link https://github.com/intel/ikgt-core/blob/7dfd4d1614d788ec43b02602cce7a272ef8d5931/vmm/vmexit/vmexit_cpuid.c
+     * @category x86
+     * @implements VM::KGT_SIGNATURE
+     */
+    [[nodiscard]] static bool intel_kgt_signature() {
+    #if (!x86)
+        return false;
+    #else
+        u32 unused = 0;
+        u32 ecx = 0; 
+        u32 edx = 0;
+        cpu::cpuid(unused, unused, ecx, edx, 0x40000003);
 
-        for (DWORD prov : smb_providers) {
-            const UINT e = EnumSystemFirmwareTables(prov, nullptr, 0);
-            if (!e) continue;
+        constexpr u32 ECX_SIG = 0x4D4D5645u; // 'EVMM' -> 0x4D4D5645
+        constexpr u32 EDX_SIG = 0x43544E49u; // 'INTC' -> 0x43544E49
 
-            // even if alignment is supported on x86 its good to check if size is a multiple of DWORD
-            if (e % sizeof(DWORD) != 0) continue;
+        if (ecx == ECX_SIG && edx == EDX_SIG) {
+            return core::add(brand_enum::INTEL_KGT);
+        }
 
-            const size_t cnt = e / sizeof(DWORD);
-            std::vector<DWORD> provider_tables(cnt);
+        return false;
+    #endif
+    }
 
-            if (EnumSystemFirmwareTables(prov, provider_tables.data(), e) != e) continue;
 
-            for (const auto table_id : provider_tables) {
-                if (fetch_and_scan(prov, table_id)) {
-                    return true;
-                }
-            }
-        }
+    /**
+     * @brief Check for hypervisor overhead by measuring instruction execution latency
+     * @category Windows, x86
+     * @implements VM::TIMER
+     */
+    [[nodiscard]] static bool timer() {
+    #if (x86 && WINDOWS)
+        using timer = struct timer;
 
-        return false;
-    #elif (LINUX)
-        // Author: dmfrpro
-        DIR* raw_dir = opendir("/sys/firmware/acpi/tables/");
-        if (!raw_dir) {
-            debug("FIRMWARE: could not open ACPI tables directory");
+        if (util::is_running_under_translator()) {
+            debug("TIMER: Running inside a binary translation layer");
             return false;
         }
 
-        const struct dir_closer { // NOLINT(cppcoreguidelines-special-member-functions)
-            DIR* d;
-            explicit dir_closer(DIR* dir) : d(dir) {}
-            ~dir_closer() { if (d) { closedir(d); } }
-        } dir(raw_dir);
+        // calculation of minimum threshold
+        bool is_intel = cpu::is_intel();
+        double threshold = 2.5;
+        if (util::hyper_x() != HYPERV_UNKNOWN) {
+            threshold = 35.0;
+        }
 
-        constexpr const char* targets[] = {
-            "Parallels Software", "Parallels(R)",
-            "innotek",            "Oracle",   "VirtualBox", "vbox", "VBOX",
-            "VMware, Inc.",       "VMware",   "VMWARE",     "VMW0003",
-            "QEMU",               "pc-q35",   "Q35 +",      "FWCF",     "BOCHS",
-            "ovmf",               "edk ii unknown", "S3 Corp.", "Virtual Machine", "VS2005R2",
-            "Xen"
-        };
+        // shared state and results
+        timer::cache_state state;
+        bool hypervisor_detected = false;
 
-        struct dirent* entry{};
-        constexpr long MAX_TABLE_SIZE = static_cast<long>(8 * 1024 * 1024);
+        const u32 ct_seed = timer::get_ct_seed();
 
-        while ((entry = readdir(raw_dir)) != nullptr) {
-            // Skip "." and ".."
-            if (
-                (strcmp(entry->d_name, ".") == 0) ||
-                (strcmp(entry->d_name, "..") == 0)
-            ) {
-                continue;
-            }
+        const DWORD_PTR trigger_affinity = timer::getmask(ct_seed, true);
+        const DWORD_PTR counter_affinity = timer::getmask(ct_seed, false);
 
-            char path[PATH_MAX];
-            snprintf(path, sizeof(path),
-                "/sys/firmware/acpi/tables/%s",
-                entry->d_name);
+        if (!trigger_affinity || !counter_affinity) {
+            return false;
+        }
 
-            const int fd = open(path, O_RDONLY);
-            if (fd == -1) {
-                debug("FIRMWARE: could not open ACPI table ", entry->d_name);
-                continue;
-            }
+        // our software clock
+        auto counter_thread = [&]() {
+            const HANDLE current_thread = reinterpret_cast<HANDLE>(-2LL);
+            SetThreadAffinityMask(current_thread, counter_affinity);
+            SetThreadPriority(current_thread, THREAD_PRIORITY_HIGHEST); // decrease chance of being rescheduled
+            SetThreadPriorityBoost(current_thread, TRUE); // disable dynamic boosts
 
-            const struct fd_closer {
-                int fd;
-                explicit fd_closer(int f) : fd(f) {}
-                ~fd_closer() { 
-                    if (fd != -1) {
-                        close(fd);
-                    }
-                }
-            } fdguard(fd);
+            while (!state.start_test.load(std::memory_order_acquire)) {}
 
-            struct stat statbuf{};
-            if (fstat(fd, &statbuf) != 0 || S_ISDIR(statbuf.st_mode)) {
-                debug("FIRMWARE: skipped ", entry->d_name);
-                continue;
-            }
-            const long file_size = statbuf.st_size;
-            if (file_size <= 0) {
-                debug("FIRMWARE: file empty or error ", entry->d_name);
-                continue;
+            while (!state.test_done.load(std::memory_order_relaxed)) {
+                const timer::timer_tick_t current = state.counter; // to silence warnings about incrementing volatile stuff
+                state.counter = current + 1; // better than calling incq in inline assembly, standard increment forces the correct cache behavior we want
+                std::atomic_signal_fence(std::memory_order_seq_cst);
             }
+        };
 
-            if (file_size > MAX_TABLE_SIZE) {
-                debug("FIRMWARE: table too large, skipping ", entry->d_name);
-                continue;
+        // it will execute cpuid and serialize or lfence, and compare its latency
+        auto trigger_thread = [&]()
+        #if ((CLANG || GCC))
+            __attribute__((__target__("serialize")))
+        #endif
+        {
+            if (is_intel) {
+                // SERIALIZE requires Ice Lake or newer
+                u32 l7_eax = 0, l7_ebx = 0, l7_ecx = 0, l7_edx = 0;
+                cpu::cpuid(l7_eax, l7_ebx, l7_ecx, l7_edx, 7, 0);
+                if (!(l7_edx & (1u << 14))) {
+                    is_intel = false;
+                }
             }
 
-            const size_t file_size_u = static_cast<size_t>(file_size);
+            const HANDLE current_thread = reinterpret_cast<HANDLE>(-2LL);
+            const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
+            const DWORD_PTR old_affinity = trigger_affinity;
+            const int old_thread_priority = GetThreadPriority(current_thread);
+            const DWORD old_process_priority = GetPriorityClass(current_process);
+            SetPriorityClass(current_process, ABOVE_NORMAL_PRIORITY_CLASS); // ABOVE_NORMAL_PRIORITY_CLASS + THREAD_PRIORITY_HIGHEST = 12 base priority
+            SetThreadPriority(current_thread, THREAD_PRIORITY_HIGHEST);
+            SetThreadPriorityBoost(current_thread, TRUE); // disable dynamic thread priority adjustments by Windows, not turbo boosts by the hardware itself
 
-            std::vector<u8> buffer;
-            try {
-                buffer.resize(file_size_u);
-            }
-            catch (...) {
-                debug("FIRMWARE: failed to allocate memory for buffer");
-                continue;
-            }
+            // important so that hypervisor can't predict how many samples we will collect
+            // stack-only / ASLR-derived component (no APIs, no rdtsc)
+            u64 seed = 0;
+            seed ^= static_cast<u64>(ct_seed);
 
-            size_t total = 0;
-            while (total < file_size_u) {
-                const ssize_t n = read(fdguard.fd, buffer.data() + total, file_size_u - total);
-                if (n <= 0) {
-                    break; // error or EOF
-                }
+            u64 local1 = 0;
+            u64 local2 = 0;
+            u64 local3 = 0;
 
-                total += static_cast<size_t>(n);
-            }
+            seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&seed));
+            seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&local1)) << 1;
+            seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&local2)) << 2;
+            seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&local3)) << 3;
 
-            if (total != file_size_u) {
-                debug("FIRMWARE: could not read full table ", entry->d_name);
-                continue;
-            }
+            seed ^= seed >> 33;
+            seed *= 0xff51afd7ed558ccdULL;
+            seed ^= seed >> 33;
+            seed *= 0xc4ceb9fe1a85ec53ULL;
+            seed ^= seed >> 33;
 
-            for (const char* target : targets) {
-                const size_t target_length = strlen(target);
-                if (target_length > file_size_u) {
-                    continue;
-                }
-    
-                for (size_t j = 0; j <= file_size_u - target_length; ++j) {
-                    if (memcmp(buffer.data() + j, target, target_length) == 0) {
-                        enum brand_enum brand = brand_enum::NULL_BRAND;
-    
-                        if (strcmp(target, "Parallels Software International") == 0 ||
-                            strcmp(target, "Parallels(R)") == 0) {
-                            brand = brand_enum::PARALLELS;
-                        }
-                        else if (strcmp(target, "innotek") == 0 ||
-                            strcmp(target, "Oracle") == 0 ||
-                            strcmp(target, "VirtualBox") == 0 ||
-                            strcmp(target, "vbox") == 0 ||
-                            strcmp(target, "VBOX") == 0) {
-                            brand = brand_enum::VBOX;
-                        }
-                        else if (strcmp(target, "VMware, Inc.") == 0 ||
-                            strcmp(target, "VMware") == 0 ||
-                            strcmp(target, "VMWARE") == 0) {
-                            brand = brand_enum::VMWARE;
-                        }
-                        else if (strcmp(target, "QEMU") == 0) {
-                            brand = brand_enum::QEMU;
-                        }
-                        else if (strcmp(target, "BOCHS") == 0 ||
-                            strcmp(target, "BXPC") == 0) {
-                            brand = brand_enum::BOCHS;
-                        }
+            std::seed_seq seq{
+                static_cast<u32>(seed),
+                static_cast<u32>(seed >> 32),
+                static_cast<u32>(seed ^ 0x9e3779b9u),
+                ct_seed
+            };
 
-                        if (brand != brand_enum::NULL_BRAND) {
-                            return core::add(brand);
-                        }
+            std::mt19937 gen(seq);
+            std::uniform_int_distribution<size_t> batch_dist(30000, 70000);
+            const size_t BATCH_SIZE = batch_dist(gen);
 
-                        return true;
-                    }
-                }
+            SleepEx(0, FALSE); // try to get fresh quantum before starting warm-up phase, give time to kernel to setup priorities
+
+            std::vector<timer::timer_tick_t> vm_samples(BATCH_SIZE), ref_samples(BATCH_SIZE); // pre page-fault MMU, wwe wont warm-up cpuid samples for the P-states intentionally
+            VirtualLock(vm_samples.data(), BATCH_SIZE * sizeof(timer::timer_tick_t)); // lock the memory for the samples to prevent page faults if permissions are enough
+            VirtualLock(ref_samples.data(), BATCH_SIZE * sizeof(timer::timer_tick_t));
+
+            #define LFENCE_8 _mm_lfence(); _mm_lfence(); _mm_lfence(); _mm_lfence(); _mm_lfence(); _mm_lfence(); _mm_lfence(); _mm_lfence();
+
+            state.start_test.store(true, std::memory_order_release); // _mm_pause can be vm-exited conditionally, spam hit L3
+            // cache and cpu scheduler warm-up won't affect anything in the measurement loop, so ramp up frequency/P-states to a high non-AVX Turbo/P-state without vmexits
+            u64 val = static_cast<u64>(seed) ^ 0x5a5a5a5a5a5a5a5aULL;
+
+            for (u32 i = 0; i < 12'000'000; ++i) {
+                val = (val ^ i) * 6364136223846793005ULL + 1442695040888963407ULL;
             }
-        }
 
-        return false;
-    #endif
-    }
+            volatile u64 compiler_sink = val;
+            VMAWARE_UNUSED(compiler_sink);
 
+            // independent multi-trial state initialization
+            timer::timer_tick_t best_cpuid_l = (std::numeric_limits<timer::timer_tick_t>::max)();
+            timer::timer_tick_t best_ref_l = (std::numeric_limits<timer::timer_tick_t>::max)();
+            constexpr int TRIALS = 3;
 
-    /**
-     * @brief Check for PCI vendor and device IDs that are VM-specific
-     * @link https://www.pcilookup.com/?ven=&dev=&action=submit
-     * @category Linux, Windows
-     * @implements VM::DEVICES
-     */
-    [[nodiscard]] static bool pci_devices() {
-        struct pci_device { u16 vendor_id; u32 device_id; };
-        std::vector<pci_device> devices;
+            for (int trial = 0; trial < TRIALS; ++trial) {
+                size_t valid = 0;  // end of setup phase
 
-        #if (LINUX)
-         const std::string pci_path = "/sys/bus/pci/devices";
-         #if (VMA_CPP >= 17)
-            // std::filesystem throws exceptions when directories don't exist (SIGSEGV)
-            std::error_code ec;
-            auto dir_iter = std::filesystem::directory_iterator(pci_path, ec);
+                // inside the timing windows, there must be zero memory output (no stack arrays can be written to), zero conditional branches and zero stack spilling (no register push/pops)
+                if (is_intel) {
+                    while (valid < BATCH_SIZE) {
+                        // cpuid and serialize/lfence interpolated so that any turbo boost, thermal throttling, speculation (for the loop overhead itself, not for the serializing instructions), etc affects samples equally
+                        timer::timer_tick_t r_pre, r_post, v_pre, v_post, sync;
 
-            if (!ec) {
-                for (const auto& entry : dir_iter) {
-                    std::ifstream vf(entry.path() / "vendor");
-                    std::ifstream df(entry.path() / "device");
+                        // this is done as a counter to both legitimate and malicious hypervisors interrupts that may pause the counter thread while we measure
+                        sync = state.counter;
+                        while (state.counter == sync); // infer if counter got enough quantum momentum (so its currently scheduled)
 
-                    if (!vf || !df) {
-                        continue;
-                    }
+                        // SERIALIZE/LFENCE check is before CPUID on purpose, so that possible pauses when cpuid is executed do not affect SERIALIZE/LFENCE too. The hv needs to wait for cpuid to pause the thread
+                        // the amount of instructions (8 in case of LFENCE) are enough for the Cross-Core/Cross-CCD MESI RFO cache bounce in the data race so that the counter thread sees an increment
+                        sync = state.counter;
+                        while (state.counter == sync); // fastest busy-waiting strategy, PAUSE affects cache, calling APIs like SwitchToThread() would be even worse
+                        r_pre = state.counter;
+                        std::atomic_signal_fence(std::memory_order_seq_cst); // ensure compiler-level ordering
+                        _serialize();
+                        std::atomic_signal_fence(std::memory_order_seq_cst);
+                        r_post = state.counter;
+
+                        sync = state.counter;
+                        while (state.counter == sync); // sync to our counter tick again
+                        sync = state.counter;
+                        while (state.counter == sync); // and again
+
+                        v_pre = state.counter;
+                        std::atomic_signal_fence(std::memory_order_seq_cst); // _ReadWriteBarrier() aka dont emit runtime fences
+
+                        // the only way a legitimate interrupt can make the check false flag is if most of the samples were contaminated just in the cpuid samples but not in the serialize/lfence samples
+                        // still possible tho, but it's as accurate we can get on user-mode without relying on any other hardware clock or cross-referencing with the counter thread mid-execution
+                        // this is why the score of this technique is not enough to determine a VM
+                        timer::vmexit();
+
+                        std::atomic_signal_fence(std::memory_order_seq_cst);
+                        v_post = state.counter;
+
+                        // we dont filter by cycles spent here (for example by querying thread cycle time) because the point of this function is to not use TSC or any other clock
+                        if (v_post > v_pre && r_post > r_pre) {
+                            vm_samples[valid] = v_post - v_pre;
+                            ref_samples[valid] = r_post - r_pre;
+                            valid++;
+                        }
 
-                    u16 vid = 0; u32 did = 0;
-                    vf >> std::hex >> vid;
-                    df >> std::hex >> did;
-                    devices.push_back({ vid, did });
+                        // burn cycles executing a random number of instructions in each loop iteration, so that the hypervisor doesn't know when to pause the counter thread
+                        timer::burn_random_cycles(ct_seed, v_post, r_post);
+                    }
                 }
-            }
-         #else
-            DIR* dir = opendir(pci_path.c_str());
-            if (dir) {
-                while (struct dirent* ent = readdir(dir)) {
-                    std::string name = ent->d_name;
-                    if (name == "." || name == "..") continue;
-                    std::string base = pci_path + "/" + name;
-                    std::ifstream vf(base + "/vendor"), df(base + "/device");
-                    if (!vf || !df) continue;
-                    u16 vid = 0; u32 did = 0;
-                    vf >> std::hex >> vid;
-                    df >> std::hex >> did;
-                    devices.push_back({ vid, did });
+                else {
+                    while (valid < BATCH_SIZE) {
+                        // cpuid and serialize/lfence interpolated so that any turbo boost, thermal throttling, speculation (for the loop overhead itself, not for the serializing instructions), etc affects samples equally
+                        timer::timer_tick_t r_pre, r_post, v_pre, v_post, sync;
+
+                        // this is done as a counter to both legitimate and malicious hypervisors interrupts that may pause the counter thread while we measure
+                        sync = state.counter;
+                        while (state.counter == sync); // infer if counter got enough quantum momentum (so its currently scheduled)
+
+                        // SERIALIZE/LFENCE check is before CPUID on purpose, so that possible pauses when cpuid is executed do not affect SERIALIZE/LFENCE too. The hv needs to wait for cpuid to pause the thread
+                        // the amount of instructions (8 in case of LFENCE) are enough for the Cross-Core/Cross-CCD MESI RFO cache bounce in the data race so that the counter thread sees an increment
+                        sync = state.counter;
+                        while (state.counter == sync);
+                        r_pre = state.counter;
+                        std::atomic_signal_fence(std::memory_order_seq_cst);
+                        LFENCE_8
+                            std::atomic_signal_fence(std::memory_order_seq_cst);
+                        r_post = state.counter;
+
+                        sync = state.counter;
+                        while (state.counter == sync); // sync to our counter tick again
+                        sync = state.counter;
+                        while (state.counter == sync); // and again
+
+                        v_pre = state.counter;
+                        std::atomic_signal_fence(std::memory_order_seq_cst); // _ReadWriteBarrier() aka dont emit runtime fences
+
+                        // the only way a legitimate interrupt can make the check false flag is if most of the samples were contaminated just in the cpuid samples but not in the serialize/lfence samples
+                        // still possible tho, but it's as accurate we can get on user-mode without relying on any other hardware clock or cross-referencing with the counter thread mid-execution
+                        // this is why the score of this technique is not enough to determine a VM
+                        timer::vmexit();
+
+                        std::atomic_signal_fence(std::memory_order_seq_cst);
+                        v_post = state.counter;
+
+                        // we dont filter by cycles spent here (for example by querying thread cycle time) because the point of this function is to not use TSC or any other clock
+                        if (v_post > v_pre && r_post > r_pre) {
+                            vm_samples[valid] = v_post - v_pre;
+                            ref_samples[valid] = r_post - r_pre;
+                            valid++;
+                        }
+
+                        // burn cycles executing a random number of instructions in each loop iteration, so that the hypervisor doesn't know when to pause the counter thread
+                        timer::burn_random_cycles(ct_seed, v_post, r_post);
+                    }
                 }
-                closedir(dir);
+
+                const timer::timer_tick_t cpuid_l = timer::calculate_latency(vm_samples); // check for lowest dense cluster with no interrupt spikes, filter noise we can't detect (SMIs, NMIs, etc)
+                const timer::timer_tick_t ref_l = timer::calculate_latency(ref_samples);
+
+                // record the cleanest/lowest latency observed across the independent trials
+                if (cpuid_l < best_cpuid_l) best_cpuid_l = cpuid_l;
+                if (ref_l < best_ref_l) best_ref_l = ref_l;
             }
-        #endif
-        #elif (WINDOWS)
-        static constexpr const wchar_t* kroots[] = {
-            L"SYSTEM\\CurrentControlSet\\Enum\\PCI",
-            L"SYSTEM\\CurrentControlSet\\Enum\\USB",
-            L"SYSTEM\\CurrentControlSet\\Enum\\HDAUDIO"
-        };
 
-        enum root_type { RT_PCI, RT_USB, RT_HDAUDIO };
-        constexpr DWORD MAX_MULTI_SZ = 64 * 1024;
+            state.test_done.store(true, std::memory_order_release);
 
-        auto hex_val = [](wchar_t c) noexcept -> int {
-            if (c >= L'0' && c <= L'9') return c - L'0';
+            const double latency_ratio = best_ref_l ? (double)best_cpuid_l / (double)best_ref_l : 0;
 
-            const wchar_t lower = static_cast<wchar_t>((static_cast<int>(c) | 0x20));
-            if (lower >= L'a' && lower <= L'f') return lower - L'a' + 10;
+            // VMM = Time spent in hypervisor; nVMM = Time spent in baremetal
+            debug("TIMER: VMM -> ", best_cpuid_l, " | nVMM -> ", best_ref_l, " | Ratio -> ", latency_ratio); // these ARE NOT cycles
+            if (latency_ratio >= threshold) hypervisor_detected = true;
 
-            return -1;
-        };
+            // Detect IPI-based counter pausing bypasses
+            // For the median itself to exceed baremetal limits (which rarely pass 1000), an interrupt must be occurring on almost EVERY single loop iteration
+            // This is the footprint of a hypervisor continuously spamming cross-core IPIs to try and pause our threads
+            if (best_cpuid_l > 1000 || best_ref_l > 1000 || best_cpuid_l == 1 || best_ref_l == 1) {
+                debug("TIMER: Detected artificial interrupt delivery to timing threads");
+                hypervisor_detected = true;
+            }
 
-        auto parse_hex = [&](const wchar_t* ptr, size_t maxDigits, size_t stopLen, unsigned long& out, size_t& consumed) noexcept -> bool {
-            out = 0;
-            consumed = 0;
+            // cleanup
+            SetThreadPriorityBoost(current_thread, FALSE);
+            SetThreadPriority(current_thread, old_thread_priority);
+            SetPriorityClass(current_process, old_process_priority);
+            SetThreadAffinityMask(current_thread, old_affinity);
+            VirtualUnlock(vm_samples.data(), BATCH_SIZE * sizeof(timer::timer_tick_t));
+            VirtualUnlock(ref_samples.data(), BATCH_SIZE * sizeof(timer::timer_tick_t));
+        };
 
-            const size_t limit = (stopLen < maxDigits) ? stopLen : maxDigits;
+        std::thread t1(counter_thread);
+        trigger_thread();
+        t1.join();
 
-            for (; consumed < limit; ++consumed) {
-                const int v = hex_val(ptr[consumed]);
-                if (v < 0) break;
+        return hypervisor_detected;
+    #endif
+        return false;
+    }
+#endif
 
-                // caller must ensure maxDigits doesn't exceed 8, because on Windows unsigned long is 32-bit
-                out = (out << 4) | static_cast<unsigned long>(v);
-            }
+#if (MSVC)
+    #pragma endregion
+    #pragma region "Linux"
+#endif
 
-            return consumed > 0;
+#if (LINUX)
+    /**
+     * @brief Check for virtualization the same way systemd-detect-virt does, but without running it
+     * @author logic from https://github.com/systemd/systemd/blob/main/src/basic/virt.c
+     * @category Linux
+     * @implements VM::SYSTEMD
+     */
+    [[nodiscard]] static bool systemd_virt() {
+        auto first_line = [](const char* path) -> std::string {
+            const std::string& content = util::cached_file(path);
+            return content.substr(0, content.find('\n'));
         };
 
-        std::unordered_set<unsigned long long> seen;
+        // detect_container() in virt.c, which systemd-detect-virt checks before anything else
+        auto detect_container = [&]() -> std::string {
+            // OpenVZ shows /proc/vz to both, but /proc/bc only to the host
+            if (util::exists("/proc/vz") && !util::exists("/proc/bc")) {
+                return "openvz";
+            }
 
-        auto add_device = [&](u16 vid, u32 did) noexcept {
-            const unsigned long long key = (static_cast<unsigned long long>(vid) << 32) | static_cast<unsigned long long>(did);
-            if (seen.insert(key).second) {
-                devices.push_back({ vid, did });
+            const std::string& osrelease = util::cached_file("/proc/sys/kernel/osrelease");
+
+            if (util::find(osrelease, "Microsoft") || util::find(osrelease, "WSL")) {
+                return "wsl";
             }
-        };
 
-        auto scan_text_ids = [&](const wchar_t* text) noexcept {
-            if (!text) return;
+            // proot runs everything under ptrace
+            const std::string& status = util::cached_file("/proc/self/status");
+            const size_t tracer = status.find("TracerPid:");
 
-            // USB: VID_ and then PID_
-            const wchar_t* p = text;
-            while ((p = wcsstr(p, L"VID_"))) {
-                const wchar_t* v = p;
-                p += 4;
-                const wchar_t* d = wcsstr(v + 4, L"PID_");
-                if (d && (d - v) < 64) {
-                    unsigned long parsed_v = 0, parsed_d = 0;
-                    size_t c_v = 0, c_d = 0;
-                    if (parse_hex(v + 4, 4, SIZE_MAX, parsed_v, c_v) &&
-                        parse_hex(d + 4, 8, SIZE_MAX, parsed_d, c_d)) {
-                        add_device(static_cast<u16>(parsed_v & 0xFFFFu), static_cast<u32>(parsed_d));
+            if (tracer != std::string::npos) {
+                const unsigned long tracer_pid = std::strtoul(status.c_str() + tracer + 10, nullptr, 10);
+
+                if (tracer_pid != 0) {
+                    const std::string comm_path = "/proc/" + std::to_string(tracer_pid) + "/comm";
+
+                    if (first_line(comm_path.c_str()) == "proot") {
+                        return "proot";
                     }
                 }
             }
 
-            // PCI or HDAUDIO = VEN_ and then DEV_ after it
-            p = text;
-            while ((p = wcsstr(p, L"VEN_"))) {
-                const wchar_t* v = p;
-                p += 4;
-                const wchar_t* d = wcsstr(v + 4, L"DEV_");
-
-                if (!(d && (d - v) < 64)) {
-                    continue;
-                }
+            // the container manager passes $container to PID 1, and systemd keeps a copy in /run/systemd/container
+            std::string manager;
 
-                unsigned long parsed_v = 0;
-                size_t c_v = 0;
+            if (getpid() == 1) {
+                const char* value = std::getenv("container");
+                manager = ((value != nullptr) ? value : "");
+            } else {
+                const std::vector<u8> environment = util::read_file_binary("/proc/1/environ");
+                const std::string variables(environment.begin(), environment.end());
+                size_t start = 0;
 
-                if (!parse_hex(v + 4, 4, SIZE_MAX, parsed_v, c_v)) {
-                    continue;
-                }
+                while (start < variables.size()) {
+                    const size_t end = std::min(variables.find('\0', start), variables.size());
 
-                const wchar_t* dev_start = const_cast<wchar_t*>(d + 4);
-                const wchar_t* amp_after_dev = wcschr(dev_start, L'&');
-                const size_t dev_len = amp_after_dev ? static_cast<size_t>(amp_after_dev - dev_start) : wcslen(dev_start);
+                    if (variables.compare(start, 10, "container=") == 0) {
+                        manager = variables.substr(start + 10, end - start - 10);
+                        break;
+                    }
 
-                // for HDAUDIO expect 4 digits and for PCI allow up to 8
-                if (!(dev_len > 0 && dev_len <= 8)) {
-                    continue;
+                    start = end + 1;
                 }
+            }
 
-                unsigned long parsed_d = 0;
-                size_t c_d = 0;
+            if (manager.empty()) {
+                manager = first_line("/run/systemd/container");
+            }
 
-                // parse exactly devLen digits (fail if any char is non-hex)
-                if (parse_hex(dev_start, 8, dev_len, parsed_d, c_d) && c_d == dev_len) {
-                    add_device(static_cast<u16>(parsed_v & 0xFFFFu), static_cast<u32>(parsed_d));
-                }
+            if (manager.empty()) {
+                manager = first_line("/run/host/container-manager");
             }
-        };
 
-        // process the hardware ID on an instance key
-        auto process_hardware_id_reg = [&](HKEY h_inst) noexcept {
-            // most HardwareIDs fit within 512 bytes
-            static thread_local std::vector<wchar_t> buf;
-            if (buf.empty()) buf.resize(512);
+            // "oci" isn't a specific container manager, so systemd tries the well-known files first
+            if (!manager.empty() && (manager != "oci")) {
+                return manager;
+            }
 
-            DWORD type = 0;
-            DWORD cb_data = static_cast<DWORD>(buf.size() * sizeof(wchar_t));
+            if (util::exists("/.dockerenv")) {
+                return "docker";
+            }
 
-            LONG rv = RegGetValueW(
-                h_inst,
-                nullptr,
-                L"HardwareID",
-                RRF_RT_REG_MULTI_SZ,
-                &type,
-                buf.data(),
-                &cb_data
-            );
+            if (util::exists("/run/.containerenv")) {
+                return "podman";
+            }
 
-            if (rv == ERROR_MORE_DATA) {
-                if (cb_data > MAX_MULTI_SZ) {
-                    return;
-                }
+            if (!manager.empty()) {
+                return "container-other";
+            }
 
-                // allocate a buffer large enough to hold the entire MULTI_SZ
-                // (+1 for safety null terminator logic below)
-                buf.resize((cb_data / sizeof(wchar_t)) + 2);
+            // the init process of a PID namespace isn't PID 1 from the outside on older kernels
+            const std::string sched = first_line("/proc/1/sched");
+            const size_t open_paren = sched.rfind('(');
 
-                rv = RegGetValueW(
-                    h_inst,
-                    nullptr,
-                    L"HardwareID",
-                    RRF_RT_REG_MULTI_SZ,
-                    &type,
-                    buf.data(),
-                    &cb_data
-                );
+            if ((open_paren != std::string::npos) && (std::strtoul(sched.c_str() + open_paren + 1, nullptr, 10) > 1)) {
+                return "container-other";
             }
 
-            if (rv != ERROR_SUCCESS || type != REG_MULTI_SZ || cb_data <= sizeof(wchar_t)) {
-                return;
-            }
+            return "none";
+        };
 
-            // guarantee terminating NUL
-            // RegGetValueW with RRF_RT_REG_MULTI_SZ usually handles this but for safety
-            const size_t wchar_count = cb_data / sizeof(wchar_t);
-            if (wchar_count < buf.size()) buf[wchar_count] = L'\0';
-            else buf.back() = L'\0';
+        // detect_vm() in virt.c
+        auto detect_vm = [&]() -> std::string {
+            constexpr std::array<std::pair<const char*, const char*>, 17> dmi_vendors{ {
+                { "KVM", "kvm" },
+                { "OpenStack", "kvm" },
+                { "KubeVirt", "kvm" },
+                { "Amazon EC2", "amazon" },
+                { "QEMU", "qemu" },
+                { "VMware", "vmware" },
+                { "VMW", "vmware" },
+                { "innotek GmbH", "oracle" },
+                { "VirtualBox", "oracle" },
+                { "Oracle Corporation", "oracle" },
+                { "Xen", "xen" },
+                { "Bochs", "bochs" },
+                { "Parallels", "parallels" },
+                { "BHYVE", "bhyve" },
+                { "Hyper-V", "microsoft" },
+                { "Apple Virtualization", "apple" },
+                { "Google Compute Engine", "google" }
+            } };
+
+            const util::smbios_info& smbios = util::smbios();
+            std::string dmi;
+
+            for (const std::string* field : { &smbios.product_name, &smbios.sys_vendor, &smbios.board_vendor, &smbios.bios_vendor, &smbios.product_version }) {
+                for (const auto& vendor : dmi_vendors) {
+                    if (dmi.empty() && (field->compare(0, std::strlen(vendor.first), vendor.first) == 0)) {
+                        dmi = vendor.second;
+                    }
+                }
+            }
 
-            for (wchar_t* p = buf.data(); *p; p += wcslen(p) + 1) {
-                scan_text_ids(p);
+            // these run on top of KVM or Xen, so the DMI data is more specific than CPUID
+            if ((dmi == "oracle") || (dmi == "xen") || (dmi == "amazon")) {
+                return dmi;
             }
-        };
 
-        // all instance subkeys under a given device key
-        auto enum_instances = [&](HKEY h_dev) noexcept {
-            wchar_t inst_name[256];
+            bool other = (dmi.empty() && smbios.from_tables && smbios.vm_bit);
 
-            for (DWORD j = 0;; ++j) {
-                // reset size for each iteration as RegEnumKeyExW modifies it
-                DWORD cb_inst = _countof(inst_name);
+        #if (x86)
+            u32 unused = 0;
+            u32 ecx = 0;
+            cpu::cpuid(unused, unused, ecx, unused, 1);
+
+            if (ecx & (1u << 31)) {
+                constexpr std::array<std::pair<const char*, const char*>, 10> cpuid_vendors{ {
+                    { "XenVMMXenVMM", "xen" },
+                    { "KVMKVMKVM", "kvm" },
+                    { "Linux KVM Hv", "kvm" },
+                    { "TCGTCGTCGTCG", "qemu" },
+                    { "VMwareVMware", "vmware" },
+                    { "Microsoft Hv", "microsoft" },
+                    { "bhyve bhyve ", "bhyve" },
+                    { "QNXQVMBSQG", "qnx" },
+                    { "ACRNACRNACRN", "acrn" },
+                    { "SRESRESRESRE", "sre" }
+                } };
 
-                const LONG st2 = RegEnumKeyExW(
-                    h_dev,
-                    j,
-                    inst_name,
-                    &cb_inst,
-                    nullptr,
-                    nullptr,
-                    nullptr,
-                    nullptr
-                );
-                if (st2 == ERROR_NO_MORE_ITEMS) break;
-                if (st2 != ERROR_SUCCESS) continue;
+                const std::string vendor = cpu::cpu_manufacturer(cpu::leaf::hypervisor);
 
-                HKEY h_inst = nullptr;
-                if (RegOpenKeyExW(h_dev, inst_name, 0, KEY_READ, &h_inst) != ERROR_SUCCESS) continue;
+                for (const auto& known : cpuid_vendors) {
+                    if (vendor == known.first) {
+                        return known.second;
+                    }
+                }
 
-                process_hardware_id_reg(h_inst);
-                RegCloseKey(h_inst);
+                other = true;
             }
-        };
+        #endif
 
-        // all device subkeys under a given root key
-        auto enum_devices = [&](HKEY h_root) noexcept {
-            wchar_t device_name[256];
+            if (!dmi.empty()) {
+                return dmi;
+            }
 
-            for (DWORD i = 0;; ++i) {
-                DWORD cb_name = _countof(device_name);
+            // a Xen dom0 sees the hypervisor too, but it isn't a guest
+            if (first_line("/sys/hypervisor/type") == "xen") {
+                return (util::find(util::cached_file("/proc/xen/capabilities"), "control_d") ? "none" : "xen");
+            }
 
-                const LONG status = RegEnumKeyExW(
-                    h_root,
-                    i,
-                    device_name,
-                    &cb_name,
-                    nullptr,
-                    nullptr,
-                    nullptr,
-                    nullptr
-                );
-                if (status == ERROR_NO_MORE_ITEMS) break;
-                if (status != ERROR_SUCCESS) continue;
+            const std::string device_tree = first_line("/proc/device-tree/hypervisor/compatible");
 
-                HKEY h_dev = nullptr;
-                if (RegOpenKeyExW(h_root, device_name, 0, KEY_READ, &h_dev) != ERROR_SUCCESS) continue;
+            if (util::find(device_tree, "linux,kvm")) { return "kvm"; }
+            if (util::find(device_tree, "xen")) { return "xen"; }
+            if (util::find(device_tree, "vmware")) { return "vmware"; }
 
-                enum_instances(h_dev);
-                RegCloseKey(h_dev);
+            if (util::find(util::cached_file("/proc/cpuinfo"), "User Mode Linux")) {
+                return "uml";
             }
-        };
 
-        // for each rootPath we open the root key once
-        for (size_t root_idx = 0; root_idx < _countof(kroots); ++root_idx) {
-            const wchar_t* root_path = kroots[root_idx];
-            HKEY root = nullptr;
-            if (RegOpenKeyExW(
-                HKEY_LOCAL_MACHINE,
-                root_path,
-                0,
-                KEY_READ,
-                &root
-            ) != ERROR_SUCCESS) {
-                continue;
+            const std::string& sysinfo = util::cached_file("/proc/sysinfo");
+
+            if (util::find(sysinfo, "VM00 Control Program")) {
+                return (util::find(sysinfo, "z/VM") ? "zvm" : "kvm");
             }
 
-            enum_devices(root);
-            RegCloseKey(root);
-        }
-        #endif
+            return (other ? "vm-other" : "none");
+        };
 
-        for (const auto d : devices) {
-            const u64 id64 = (static_cast<u64>(d.vendor_id) << 32) | d.device_id;
-            const u32 id32 = (static_cast<u32>(d.vendor_id) << 16) | static_cast<u32>(d.device_id);
+        std::string result = detect_container();
 
-            switch (id32) {
-                // Red Hat + Virtio
-                case 0x1af40022: case 0x1af41000: case 0x1af41001: case 0x1af41002:
-                case 0x1af41003: case 0x1af41004: case 0x1af41005: case 0x1af41009:
-                case 0x1af41041: case 0x1af41042: case 0x1af41043: case 0x1af41044:
-                case 0x1af41045: case 0x1af41048: case 0x1af41049: case 0x1af41050:
-                case 0x1af41052: case 0x1af41053: case 0x1af4105a: case 0x1af41100:
-                case 0x1af41110: case 0x1af41b36:
-                    debug("DEVICES: Detected Red Hat + Virtio device -> 0x", std::hex, id32);
-                    return true;
+        if (result == "none") {
+            result = detect_vm();
+        }
 
-                // VMware
-                case 0x15ad0710: case 0x15ad0720: case 0x15ad0770: case 0x15ad0774: 
-                case 0x15ad0778: case 0x15ad0779: case 0x15ad0790: case 0x15ad07a0: 
-                case 0x15ad07b0: case 0x15ad07c0: case 0x15ad07e0: case 0x15ad07f0: 
-                case 0x15ad0801: case 0x15ad0820: case 0x15ad1977: case 0xfffe0710: 
-                case 0x0e0f0001: case 0x0e0f0002: case 0x0e0f0003: case 0x0e0f0004: 
-                case 0x0e0f0005: case 0x0e0f0006: case 0x0e0f000a: case 0x0e0f8001: 
-                case 0x0e0f8002: case 0x0e0f8003: case 0x0e0ff80a:
-                    debug("DEVICES: Detected VMWARE device -> 0x", std::hex, id32);
-                    return core::add(brand_enum::VMWARE);
+        debug("SYSTEMD: ", "output = ", result);
 
-                // Red Hat + QEMU
-                case 0x1b360001: case 0x1b360002: case 0x1b360003: case 0x1b360004:
-                case 0x1b360005: case 0x1b360008: case 0x1b360009: case 0x1b36000b:
-                case 0x1b36000c: case 0x1b36000d: case 0x1b360010: case 0x1b360011:
-                case 0x1b360013: case 0x1b360100:
-                    debug("DEVICES: Detected Red Hat + QEMU device -> 0x", std::hex, id32);
-                    return core::add(brand_enum::QEMU);
+        return (result != "none");
+    }
 
-                // QEMU
-                case 0x06270001: case 0x1d1d1f1f: case 0x80865845: case 0x1d6b0200:
-                    debug("DEVICES: Detected QEMU device -> 0x", std::hex, id32);
-                    return core::add(brand_enum::QEMU);
 
-                // vGPUs (NVIDIA + others)
-                case 0x10de0fe7: case 0x10de0ff7: case 0x10de118d: case 0x10de11b0:
-                case 0x1ec6020f:
-                    debug("DEVICES: Detected virtual gpu device -> 0x", std::hex, id32);
-                    return true;
+    /**
+     * @brief Check if the chassis vendor is a VM vendor
+     * @category Linux
+     * @implements VM::CVENDOR
+     */
+    [[nodiscard]] static bool chassis_vendor() {
+        const std::string& vendor = util::smbios().chassis_vendor;
 
-                // VirtualBox
-                case 0x80ee0021: case 0x80ee0022: case 0x80eebeef: case 0x80eecafe:
-                    debug("DEVICES: Detected VirtualBox device -> 0x", std::hex, id32);
-                    return core::add(brand_enum::VBOX);
+        if (vendor.empty()) {
+            debug("CVENDOR: ", "no chassis vendor");
+            return false;
+        }
 
-                // Parallels
-                case 0x1ab84000: case 0x1ab84005: case 0x1ab84006:
-                    debug("DEVICES: Detected Parallels device -> 0x", std::hex, id32);
-                    return core::add(brand_enum::PARALLELS);
+        const u32 matches = util::smbios_vendors().chassis_vendor;
 
-                // Xen
-                case 0x5853c000: case 0xfffd0101: case 0x5853c147:
-                case 0x5853c110: case 0x5853c200: case 0x58530001:
-                    debug("DEVICES: Detected Xen device -> 0x", std::hex, id32);
-                    return core::add(brand_enum::XEN);
+        // TODO: More can definitely be added, only QEMU and VBox were tested so far
+        if (matches & (1u << util::DMI_QEMU)) { return core::add(brand_enum::QEMU); }
+        if (matches & (1u << util::DMI_ORACLE)) { return core::add(brand_enum::VBOX); }
+
+        debug("CVENDOR: vendor = ", vendor);
 
-                // Connectix (VirtualPC)
-                case 0x29556e61:
-                    debug("DEVICES: Detected VirtualPC device -> 0x", std::hex, id32);
-                    return core::add(brand_enum::VPC);
-            }
-
-            // Devices with 32 bit device ids
-            switch (id64) {
-                case 0x0000000011061100ULL:
-                case 0x000000001af41100ULL:
-                case 0x000000001b361100ULL:
-                case 0x0000000010ec1100ULL:
-                case 0x0000000010331100ULL:
-                case 0x0000000080861100ULL:
-                case 0x0000000010131100ULL:
-                case 0x00000000106b1100ULL:
-                case 0x0000000010221100ULL:
-                    debug("DEVICES: Detected QEMU device -> 0x", std::hex, id64);
-                    return core::add(brand_enum::QEMU);
-    
-                case 0x0000000015ad0800ULL:  // Hypervisor ROM Interface
-                    debug("DEVICES: Detected Hypervisor ROM interface -> 0x", std::hex, id64);
-                    return core::add(brand_enum::VMWARE);
-            }
-        }
-        
         return false;
     }
 
 
     /**
-     * @brief Check boot logo for known VM images
-     * @category Windows, Linux, x86_64
-     * @author Teselka (https://github.com/Teselka)
-     * @implements VM::BOOT_LOGO
+     * @brief Check if the chassis type is valid (it's very often invalid in VMs)
+     * @category Linux
+     * @implements VM::CTYPE
      */
-    [[nodiscard]] static bool boot_logo()
-    #if (x86 && (CLANG || GCC))
-        __attribute__((__target__("crc32")))
-    #endif
-    {
-    #if (x86_64)       
-        #if (WINDOWS)
-            const HMODULE ntdll = util::get_ntdll();
-            if (!ntdll)
-                return false;
+    [[nodiscard]] static bool chassis_type() {
+        const u8 chassis = util::smbios().chassis_type;
 
-            const char* function_names[] = { "NtQuerySystemInformation" };
-            void* functions[1] = { nullptr };
-            util::get_function_address(ntdll, function_names, functions, 1);
+        if (chassis == 0) {
+            debug("CTYPE: ", "no chassis type");
+            return false;
+        }
 
-            using nt_query_sysinfo_t = NTSTATUS(__stdcall*)(SYSTEM_INFORMATION_CLASS, PVOID, ULONG, PULONG);
-            nt_query_sysinfo_t nt_query = reinterpret_cast<nt_query_sysinfo_t>(functions[0]);
-            if (!nt_query)
-                return false;
+        // 1 is "Other"
+        return (chassis == 1);
+    }
 
-            // parse header to locate the bitmap
-            struct boot_logo_info { ULONG flags, bitmap_offset; };
 
-            // determine required buffer size
-            const SYSTEM_INFORMATION_CLASS sys_boot_info = static_cast<SYSTEM_INFORMATION_CLASS>(140);
-            ULONG needed = 0;
-            NTSTATUS st = nt_query(sys_boot_info, nullptr, 0, &needed);
-            if (st != static_cast<NTSTATUS>(0xC0000023) &&
-                st != static_cast<NTSTATUS>(0x80000005) &&
-                st != static_cast<NTSTATUS>(0xC0000004))
-                return false;
+    /**
+     * @brief Check if /.dockerenv or /.dockerinit file is present
+     * @category Linux
+     * @implements VM::DOCKERENV
+     */
+    [[nodiscard]] static bool dockerenv() {
+        if (util::containers().dockerenv) {
+            return core::add(brand_enum::DOCKER);
+        }
 
-            std::vector<u8> buffer(needed);
+        return false;
+    }
 
-            // fetch the boot-logo data
-            st = nt_query(sys_boot_info, buffer.data(), needed, &needed);
-            if (!NT_SUCCESS(st))
-                return false;
 
-            if (needed < sizeof(boot_logo_info))
-                return false;
+    /**
+     * @brief Check if the SMBIOS system manufacturer or product name matches a VM brand, like dmidecode -t system would show
+     * @category Linux
+     * @warning Permissions required
+     * @implements VM::DMIDECODE
+     */
+    [[nodiscard]] static bool dmidecode() {
+        const util::smbios_info& info = util::smbios();
 
-            const auto* info = reinterpret_cast<const boot_logo_info*>(buffer.data());
-            if (info->bitmap_offset >= needed)
-                return false;
+        if (!info.from_tables) {
+            debug("DMIDECODE: ", "precondition return called (root = ", util::is_admin(), ")");
+            return false;
+        }
 
-            const u8* bmp = buffer.data() + info->bitmap_offset;
-            const size_t size = static_cast<size_t>(needed) - info->bitmap_offset;
-        #else
-            const int fd = open("/sys/firmware/acpi/bgrt/image", O_RDONLY);
-            if (fd < 0)
-            {
-                debug("BOOT_LOGO: failed to open /sys/firmware/acpi/bgrt/image");
-                return false;
+        for (const std::string* field : { &info.sys_vendor, &info.product_name }) {
+            if (util::find(*field, "QEMU")) {
+                return core::add(brand_enum::QEMU);
             }
 
-            const off_t size = lseek(fd, 0, SEEK_END);
-            if (size <= 0)
-            {
-                debug("BOOT_LOGO: failed to seek to the end");
-                close(fd);
-                return false;
+            if (util::find(*field, "VirtualBox")) {
+                return core::add(brand_enum::VBOX);
             }
 
-            lseek(fd, 0, SEEK_SET);
+            if (util::find(*field, "KVM")) {
+                return core::add(brand_enum::KVM);
+            }
+        }
 
-            std::vector<u8> buffer(size);
-            ssize_t read_size = 0;
-            size_t off = 0;
-            for (;;) {
-                read_size = read(fd, buffer.data() + off, size - off);
-                if (read_size <= 0) { break; }
-                off += static_cast<size_t>(read_size);
-                if (off >= static_cast<size_t>(size)) { break; }
-            }
-
-            close(fd);
-            if (off != static_cast<size_t>(size))
-            {
-                debug("BOOT_LOGO: read failed or partial");
-                return false;
-            }
+        debug("DMIDECODE: ", "manufacturer = ", info.sys_vendor, ", product = ", info.product_name);
 
-            const u8* bmp = buffer.data();
-        #endif
+        return false;
+    }
 
-        // struct + function to isolate SEH from the stack frame containing std::vector and use __target__
-        struct crc {
-        #if (GCC || CLANG)
-            __attribute__((__target__("sse4.2")))
-        #endif
-            static u32 compute(const u8* data, size_t len) {
-                // 8 byte chunks
-                u64 crcReg = 0xFFFFFFFFull;
-                const size_t qwords = len >> 3;
-                const auto* ptr = reinterpret_cast<const u64*>(data);
 
-                size_t i = 0;
+    /**
+     * @brief Check if any network interface has a mac address from a VM designated range
+     * @category Linux
+     * @implements VM::MAC
+     */
+    [[nodiscard]] static bool mac_address_check() {
+        struct fdguard {
+            int fd;
+            explicit fdguard(int fd = -1) : fd(fd) {}
+            ~fdguard() { if (fd != -1) { ::close(fd); } }
+            int get() const { return fd; }
+        };
 
-                const auto& info = cpu::analyze_cpu();
+        // sorted by OUI for the binary search below. 52:54:00 (QEMU/libvirt) is left out on purpose,
+        // the virbr0 bridge of every libvirt host has it too
+        struct oui_entry {
+            u32 oui;
+            brand_enum brand;
+        };
 
-                if (info.has_sse42)
-                {
-                    // unrolled loop
-                    for (; i + 3 < qwords; i += 4) {
-                        crcReg = _mm_crc32_u64(crcReg, ptr[i]);
-                        crcReg = _mm_crc32_u64(crcReg, ptr[i + 1]);
-                        crcReg = _mm_crc32_u64(crcReg, ptr[i + 2]);
-                        crcReg = _mm_crc32_u64(crcReg, ptr[i + 3]);
-                    }
+        static const oui_entry known_ouis[] = {
+            { 0x0003FF, brand_enum::VPC },       // 00:03:FF
+            { 0x000569, brand_enum::VMWARE },    // 00:05:69
+            { 0x000C29, brand_enum::VMWARE },    // 00:0C:29
+            { 0x00155D, brand_enum::HYPERV },    // 00:15:5D
+            { 0x00163E, brand_enum::XEN },       // 00:16:3E
+            { 0x0016E3, brand_enum::XEN },       // 00:16:E3
+            { 0x001C14, brand_enum::VMWARE },    // 00:1C:14
+            { 0x001C42, brand_enum::PARALLELS }, // 00:1C:42
+            { 0x005056, brand_enum::VMWARE },    // 00:50:56
+            { 0x080027, brand_enum::VBOX }       // 08:00:27
+        };
 
-                    for (; i < qwords; ++i) {
-                        crcReg = _mm_crc32_u64(crcReg, ptr[i]);
-                    }
+        const fdguard sock(socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE));
 
-                    u32 crc = static_cast<u32>(crcReg);
-                    const auto* tail = reinterpret_cast<const u8*>(ptr + qwords);
+        if (sock.get() == -1) {
+            debug("MAC: ", "failed to open a netlink socket");
+            return false;
+        }
 
-                    for (size_t j = 0, r = len & 7; j < r; ++j) {
-                        crc = _mm_crc32_u8(crc, tail[j]);
-                    }
-                    crc ^= 0xFFFFFFFFu;
-                    return crc;
-                }
+        // one RTM_GETLINK dump lists every interface, however many veth or macvlan devices there are
+        struct {
+            struct nlmsghdr header;
+            struct ifinfomsg info;
+        } request{};
 
-                return 0;
-            }
-        };
+        request.header.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+        request.header.nlmsg_type = RTM_GETLINK;
+        request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+        request.header.nlmsg_seq = 1;
+        request.info.ifi_family = AF_UNSPEC;
 
-        const u32 hash = crc::compute(bmp, size);
+        struct sockaddr_nl kernel{};
+        kernel.nl_family = AF_NETLINK;
 
-        #if (WINDOWS)
-            debug("BOOT_LOGO: size=", needed, ", flags=", info->flags, ", offset=", info->bitmap_offset, ", crc=0x", std::hex, hash);
-        #else
-            debug("BOOT_LOGO: size=", size, ", crc=0x", std::hex, hash);
-        #endif
-        switch (hash) {
-            case 0x110350C5: return core::add(brand_enum::QEMU); // TianoCore EDK2
-            case 0x87c39681: return core::add(brand_enum::HYPERV);
-            // case 0x9502cb33: return core::add(brand_enum::VBOX); // conflicts with some MSI logo images
-            default:         return false;
+        if (sendto(sock.get(), &request, request.header.nlmsg_len, 0, reinterpret_cast<struct sockaddr*>(&kernel), sizeof(kernel)) < 0) {
+            debug("MAC: ", "failed to send the netlink request");
+            return false;
         }
-        #else
-        return false;
-        #endif
-    }
 
-    
-    /**
-    * @brief Check for serial numbers of virtual disks
-    * @category Windows
-    * @implements VM::DISK_SERIAL
-    */
-    [[nodiscard]] static bool disk_serial_number() {
-        bool result = false;
+        std::vector<char> buffer(32768);
+        size_t interfaces = 0;
 
-        // helper to detect QEMU instances based on default hard drive serial patterns
-        // QEMU drives often start with "QM000" followed by digits
-        auto is_qemu_serial = [](const char* str, size_t len) noexcept -> bool {
-            if (!str || len < 6) {
-                return false;
+        for (;;) {
+            // a single message can't be read in pieces, so make room for it first
+            const ssize_t pending = recv(sock.get(), buffer.data(), 0, MSG_PEEK | MSG_TRUNC);
+
+            if (pending > static_cast<ssize_t>(buffer.size())) {
+                buffer.resize(static_cast<size_t>(pending));
             }
 
-            if ((str[0] & 0xDF) != 'Q') return false;
-            if ((str[1] & 0xDF) != 'M') return false;
+            const ssize_t received = recv(sock.get(), buffer.data(), buffer.size(), 0);
 
-            return str[2] == '0' && str[3] == '0' && str[4] == '0' && str[5] == '0';
-        };
-        
-        // helper to detect VirtualBox instances
-        // VirtualBox uses a specific serial format "VB" followed by hex segments
-        auto is_vbox_serial = [](const char* str, size_t len) noexcept -> bool {
-            // format: VB12345678-12345678 (19 chars)
-            if (len != 19) {
-                return false;
-            }
-            
-            if ((str[0] & 0xDF) != 'V' || (str[1] & 0xDF) != 'B') {
+            if (received < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                debug("MAC: ", "failed to receive the netlink reply");
                 return false;
             }
-            if (str[10] != '-') {
+
+            if (received == 0) {
                 return false;
             }
-            
-            auto is_hex = [](char c) noexcept -> bool {
-                const char lower = static_cast<char>(c | 0x20);
-                return (c >= '0' && c <= '9') 
-                || (lower >= 'a' && lower <= 'f');
-            };
-            
-            for (size_t i = 2; i < 10; ++i) {
-                if (!is_hex(str[i])) {
+
+            int remaining = static_cast<int>(received);
+
+            for (
+                const struct nlmsghdr* message = reinterpret_cast<const struct nlmsghdr*>(buffer.data());
+                NLMSG_OK(message, remaining);
+                message = NLMSG_NEXT(message, remaining)
+            ) {
+                if (message->nlmsg_type == NLMSG_DONE) {
+                    debug("MAC: ", "no VM designated address in ", interfaces, " interfaces");
                     return false;
                 }
-            }
-            
-            for (size_t i = 11; i < 19; ++i) {
-                if (!is_hex(str[i])) {
+
+                if (message->nlmsg_type == NLMSG_ERROR) {
+                    debug("MAC: ", "netlink dump failed");
                     return false;
                 }
-            }
-            
-            return true;
-        };
-        
-        #if (WINDOWS)
 
-        auto strnlen = [](const char* s, size_t max) noexcept -> size_t {
-            const void* p = memchr(s, 0, max);
-            if (!p) return max;
-            return static_cast<size_t>(static_cast<const char*>(p) - s);
-        };
-        
-        using NtOpenFile_t = NTSTATUS(__stdcall*)(PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES, PIO_STATUS_BLOCK, ULONG, ULONG);
-        using NtDeviceIoControlFile_t = NTSTATUS(__stdcall*)(HANDLE, HANDLE, PVOID, PVOID, PIO_STATUS_BLOCK, ULONG, PVOID, ULONG, PVOID, ULONG);
-        using NtAllocateVirtualMemory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, ULONG_PTR, PSIZE_T, ULONG, ULONG);
-        using NtFreeVirtualMemory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG);
-        using NtClose_t = NTSTATUS(__stdcall*)(HANDLE);
-        using RtlInitUnicodeString_t = void(__stdcall*)(PUNICODE_STRING, PCWSTR);
+                if (message->nlmsg_type != RTM_NEWLINK) {
+                    continue;
+                }
 
-        constexpr u8 MAX_PHYSICAL_DRIVES = 4;
-        constexpr size_t MAX_DESCRIPTOR_SIZE = 64 * 1024;
-        u8 successful_opens = 0;
+                const struct ifinfomsg* info = static_cast<const struct ifinfomsg*>(NLMSG_DATA(message));
 
-        const HMODULE ntdll = util::get_ntdll();
-        if (!ntdll) return result;
+                if ((info->ifi_type != ARPHRD_ETHER) || (info->ifi_flags & IFF_LOOPBACK)) {
+                    continue;
+                }
 
-        const char* names[] = {
-            "RtlInitUnicodeString",
-            "NtOpenFile",
-            "NtDeviceIoControlFile",
-            "NtAllocateVirtualMemory",
-            "NtFreeVirtualMemory",
-            "NtFlushInstructionCache",
-            "NtClose"
-        };
-        void* funcs[ARRAYSIZE(names)] = {};
-        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+                interfaces++;
 
-        const auto rtl_init_unicode_string = reinterpret_cast<RtlInitUnicodeString_t>(funcs[0]);
-        const auto nt_open_file = reinterpret_cast<NtOpenFile_t>(funcs[1]);
-        const auto nt_device_io_control_file = reinterpret_cast<NtDeviceIoControlFile_t>(funcs[2]);
-        const auto nt_allocate_virtual_memory = reinterpret_cast<NtAllocateVirtualMemory_t>(funcs[3]);
-        const auto nt_free_virtual_memory = reinterpret_cast<NtFreeVirtualMemory_t>(funcs[4]);
-        const auto nt_close = reinterpret_cast<NtClose_t>(funcs[6]);
+                int attributes_left = static_cast<int>(IFLA_PAYLOAD(message));
 
-        if (!rtl_init_unicode_string || !nt_open_file || !nt_device_io_control_file ||
-            !nt_allocate_virtual_memory || !nt_free_virtual_memory || !nt_close) {
-            return result;
-        }
+                for (
+                    const struct rtattr* attribute = IFLA_RTA(info);
+                    RTA_OK(attribute, attributes_left);
+                    attribute = RTA_NEXT(attribute, attributes_left)
+                ) {
+                    if ((attribute->rta_type != IFLA_ADDRESS) || (RTA_PAYLOAD(attribute) < 6)) {
+                        continue;
+                    }
 
-        // Iterate through the first few physical drives (PhysicalDrive0 to PhysicalDrive3)
-        // Most systems boot from 0, and VMs rarely emulate more than 1 or 2 drives by default
-        for (u8 drive = 0; drive < MAX_PHYSICAL_DRIVES; ++drive) {
-            wchar_t path[32];
-            swprintf_s(path, L"\\??\\PhysicalDrive%u", drive);
+                    const u8* mac = static_cast<const u8*>(RTA_DATA(attribute));
 
-            UNICODE_STRING unicode_path;
-            rtl_init_unicode_string(&unicode_path, path);
+                    const u32 prefix = (static_cast<u32>(mac[0]) << 16)
+                        | (static_cast<u32>(mac[1]) << 8)
+                        | static_cast<u32>(mac[2]);
 
-            OBJECT_ATTRIBUTES object_attributes;
-            RtlZeroMemory(&object_attributes, sizeof(object_attributes));
-            object_attributes.Length = sizeof(object_attributes);
-            object_attributes.ObjectName = &unicode_path;
-            object_attributes.Attributes = OBJ_CASE_INSENSITIVE;
-            object_attributes.RootDirectory = nullptr;
+                    const oui_entry* const end = known_ouis + (sizeof(known_ouis) / sizeof(known_ouis[0]));
+                    const oui_entry* const match = std::lower_bound(known_ouis, end, prefix,
+                        [](const oui_entry& entry, const u32 oui) { return entry.oui < oui; }
+                    );
 
-            IO_STATUS_BLOCK iosb;
-            HANDLE device = nullptr;
+                    if ((match == end) || (match->oui != prefix)) {
+                        break;
+                    }
 
-            constexpr ACCESS_MASK desired_access = SYNCHRONIZE | FILE_READ_ATTRIBUTES;
-            constexpr ULONG share_access = FILE_SHARE_READ | FILE_SHARE_WRITE;
-            constexpr ULONG open_options = FILE_NON_DIRECTORY_FILE | FILE_SYNCHRONOUS_IO_NONALERT;
+                    // 00:50:56:C0:00:xx are the vmnet adapters VMware Workstation adds to the host itself
+                    if ((prefix == 0x005056) && (mac[3] == 0xC0) && (mac[4] == 0x00)) {
+                        break;
+                    }
 
-            // Attempt to open the physical drive directly using Native API
-            NTSTATUS st = nt_open_file(&device, desired_access, &object_attributes, &iosb, share_access, open_options);
-            if (!NT_SUCCESS(st) || device == nullptr) {
-                continue;
+                #ifdef __VMAWARE_DEBUG__
+                    {
+                        std::stringstream ss;
+                        ss << std::hex << std::setfill('0')
+                            << std::setw(2) << static_cast<int>(mac[0]) << ":"
+                            << std::setw(2) << static_cast<int>(mac[1]) << ":"
+                            << std::setw(2) << static_cast<int>(mac[2]) << ":XX:XX:XX";
+                        debug("MAC: ", ss.str());
+                    }
+                #endif
+
+                    return core::add(match->brand);
+                }
             }
-            ++successful_opens;
+        }
+    }
 
-            // stack buffer attempt
-            // We first try to read the storage properties into a small stack buffer to avoid heap
-            BYTE stackBuf[512] = { 0 };
-            const STORAGE_DEVICE_DESCRIPTOR* descriptor = reinterpret_cast<STORAGE_DEVICE_DESCRIPTOR*>(stackBuf);
 
-            STORAGE_PROPERTY_QUERY query{};
-            query.PropertyId = StorageDeviceProperty;
-            query.QueryType = PropertyStandardQuery;
+    /**
+     * @brief Check if dmesg output matches a VM brand
+     * @category Linux
+     * @warning Permissions required
+     * @implements VM::DMESG
+     */
+    [[nodiscard]] static bool dmesg() {
+        if (!util::is_admin()) {
+            return false;
+        }
 
-            const ULONG ioctl = IOCTL_STORAGE_QUERY_PROPERTY;
+        const util::kernel_log_info& log = util::kernel_log();
 
-            st = nt_device_io_control_file(device, nullptr, nullptr, nullptr, &iosb,
-                ioctl,
-                &query, sizeof(query),
-                stackBuf, sizeof(stackBuf));
+        if (!log.readable) {
+            debug("DMESG: ", "kernel log not readable");
+            return false;
+        }
 
-            BYTE* allocated_buffer = nullptr;
-            SIZE_T allocated_size = 0;
-            const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
+        // same match as the "dmesg | grep -i hypervisor | grep -c "KVM|QEMU"" pipeline this used to run,
+        // where the second grep looks for the literal "KVM|QEMU" and the count doesn't point to any brand
+        return log.hypervisor_pattern;
+    }
 
-            // If the stack buffer was too small (NtDeviceIoControlFile failed), we fall back 
-            // to allocating memory dynamically using NtAllocateVirtualMemory
-            if (!NT_SUCCESS(st)) {
-                DWORD reported_size = 0;
-                if (descriptor && descriptor->Size > 0) {
-                    reported_size = descriptor->Size;
-                }
 
-                // This branch just ensures the requested size is reasonable before allocating
-                if (reported_size > 0 && reported_size < static_cast<DWORD>(MAX_DESCRIPTOR_SIZE) && reported_size >= sizeof(STORAGE_DEVICE_DESCRIPTOR)) {
-                    allocated_size = static_cast<SIZE_T>(reported_size);
-                    PVOID allocation_base = nullptr;
-                    SIZE_T region_size = allocated_size;
-                    st = nt_allocate_virtual_memory(current_process, &allocation_base, 0, &region_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-                    if (!NT_SUCCESS(st) || allocation_base == nullptr) {
-                        nt_close(device);
-                        continue;
-                    }
-                    allocated_buffer = reinterpret_cast<BYTE*>(allocation_base);
-
-                    // Retry the query with the larger allocated buffer
-                    st = nt_device_io_control_file(device, nullptr, nullptr, nullptr, &iosb,
-                        ioctl,
-                        &query, sizeof(query),
-                        allocated_buffer, static_cast<ULONG>(allocated_size));
-                    if (!NT_SUCCESS(st)) {
-                        PVOID free_base = reinterpret_cast<PVOID>(allocated_buffer);
-                        SIZE_T free_size = 0;
-                        nt_free_virtual_memory(current_process, &free_base, &free_size, MEM_RELEASE);
-                        nt_close(device);
-                        continue;
-                    }
-                    descriptor = reinterpret_cast<STORAGE_DEVICE_DESCRIPTOR*>(allocated_buffer);
-                }
-                else {
-                    nt_close(device);
-                    continue;
-                }
-            }
-
-            // This part is just to validate the structure size returned by the driver to prevent out-of-bounds reads
-            {
-                const DWORD reported_size = descriptor->Size;
-                if (reported_size < sizeof(STORAGE_DEVICE_DESCRIPTOR) || static_cast<SIZE_T>(reported_size) > MAX_DESCRIPTOR_SIZE) {
-                    if (allocated_buffer) {
-                        PVOID free_base = reinterpret_cast<PVOID>(allocated_buffer);
-                        SIZE_T free_size = 0;
-                        nt_free_virtual_memory(current_process, &free_base, &free_size, MEM_RELEASE);
-                        allocated_buffer = nullptr;
-                    }
-                    nt_close(device);
-                    continue;
-                }
-            }
-
-            // Serial number string within the descriptor structure
-            const u32 serial_offset = descriptor->SerialNumberOffset;
-            if (serial_offset > 0 && serial_offset < descriptor->Size) {
-                const char* serial = reinterpret_cast<const char*>(descriptor) + serial_offset;
-                const size_t max_avail = static_cast<size_t>(descriptor->Size) - static_cast<size_t>(serial_offset);
-                const size_t serialLen = strnlen(serial, max_avail);
-
-                debug("DISK_SERIAL: ", serial);
-
-                // Check the retrieved serial number against known VM artifacts
-                if (is_qemu_serial(serial, serialLen) || is_vbox_serial(serial, serialLen)) {
-                    if (allocated_buffer) {
-                        PVOID free_base = reinterpret_cast<PVOID>(allocated_buffer);
-                        SIZE_T free_size = 0;
-                        nt_free_virtual_memory(current_process, &free_base, &free_size, MEM_RELEASE);
-                        allocated_buffer = nullptr;
-                    }
-                    nt_close(device);
-                    return true;
-                }
-            }
+    /**
+     * @brief Check if /sys/class/hwmon/ directory is present. If not, likely a VM
+     * @category Linux
+     * @implements VM::HWMON
+     */
+    [[nodiscard]] static bool hwmon() {
+        return (!util::exists("/sys/class/hwmon/"));
+    }
 
-            // Cleanup for the current iteration if no VM was detected on this drive
-            if (allocated_buffer) {
-                PVOID free_base = reinterpret_cast<PVOID>(allocated_buffer);
-                SIZE_T free_size = 0;
-                nt_free_virtual_memory(current_process, &free_base, &free_size, MEM_RELEASE);
-                allocated_buffer = nullptr;
-            }
-            nt_close(device);
-        }
 
-        // If we couldn't open any physical drives (not even read permissions) it's weird so we flag it.
-        if (successful_opens == 0) {
-            debug("DISK_SERIAL: No physical drives detected");
-            return true;
-        }
-    #else
-        DIR* dir = opendir("/sys/block");
-        if (!dir) {
+    /**
+     * @brief Check for default VM username and hostname for linux
+     * @category Linux
+     * @implements VM::LINUX_USER_HOST
+     */
+    [[nodiscard]] static bool linux_user_host() {
+        if (util::is_admin()) {
             return false;
         }
 
-        struct dirent* ent{};
+        const char* username = std::getenv("USER");
+        const char* hostname = std::getenv("HOSTNAME");
 
-        while ((ent = readdir(dir))) {
-            const char* name = ent->d_name;
-            if (name[0] == '.') {
-                continue;
-            }
+        if (!username || !hostname) {
+            debug("VM::LINUX_USER_HOST: environment variables not found");
+            return false;
+        }
 
-            if (!strncmp(name, "nvme", 4) ||
-                !strncmp(name, "sd", 2) ||
-                !strncmp(name, "sg", 2) ||
-                !strncmp(name, "hd", 2) ||
-                !strncmp(name, "vd", 2)
-            ) {
-                const char sys_block_str[] = "/sys/block/";
-                const char device_serial_str[] = "/device/serial";
+        debug("LINUX_USER_HOST: user = ", username);
+        debug("LINUX_USER_HOST: host = ", hostname);
 
-                // /sys/block/%s/device/serial
-                char buf[sizeof(dirent::d_name) + sizeof(sys_block_str) + sizeof(device_serial_str)];
-                snprintf(buf, sizeof(buf), "%s%s%s", sys_block_str, name, device_serial_str);
+        return (
+            (strcmp(username, "liveuser") == 0) &&
+            (strcmp(hostname, "localhost-live") == 0)
+        );
+    }
 
-                const int fd = open(buf, O_RDONLY);
-                if (fd < 0) {
-                    continue;
-                }
 
-                char serial[1024] = {};
-                const ssize_t rsize = read(fd, serial, sizeof(serial)-1);
-                close(fd);
-                if (rsize < 0) {
-                    continue;
-                }
+    /**
+     * @brief Check for VMware string in /proc/iomem
+     * @category Linux
+     * @author idea from ScoopyNG by Tobias Klein
+     * @implements VM::VMWARE_IOMEM
+     */
+    [[nodiscard]] static bool vmware_iomem() {
+        const std::string& iomem_file = util::cached_file("/proc/iomem");
 
-                debug("DISK_SERIAL: ", (const char*)serial);
-                if (is_qemu_serial(serial, static_cast<size_t>(rsize)) || is_vbox_serial(serial, static_cast<size_t>(rsize))) {
-                    result = true;
-                }
-            }
+        if (util::find(iomem_file, "VMware")) {
+            return core::add(brand_enum::VMWARE);
         }
 
-        closedir(dir);
-    #endif
-        return result;
+        return false;
     }
-#endif
 
-#if (MSVC)
-    #pragma endregion
-    #pragma region "Linux and Apple"
-#endif
 
-#if (LINUX || APPLE)
     /**
-     * @brief Check if there are only 1 or 2 threads, which is a common pattern in VMs with default settings, nowadays physical CPUs should have at least 4 threads for modern CPUs
-     * @category x86 (ARM might have very low thread counts, which is why it should be only for x86)
-     * @implements VM::THREAD_COUNT
+     * @brief Check for the presence of BlueStacks-specific folders
+     * @category ARM, Linux
+     * @implements VM::BLUESTACKS_FOLDERS
      */
-    [[nodiscard]] static bool thread_count() {
-    #if (x86 && !APPLE)
-        debug("THREADCOUNT: ", "threads = ", memo::threadcount::fetch());
-
-        const struct cpu::stepping_struct steps = cpu::fetch_steppings();
-
-        if (cpu::is_celeron(steps)) {
-            return false;
+    [[nodiscard]] static bool bluestacks() {
+    #if (!ARM)
+        return false;
+    #else
+        if (
+            util::exists("/mnt/windows/BstSharedFolder") ||
+            util::exists("/sdcard/windows/BstSharedFolder")
+        ) {
+            return core::add(brand_enum::BLUESTACKS);
         }
 
-        return (memo::threadcount::fetch() <= 2);
-    #else 
         return false;
     #endif
     }
-#endif
 
-#if (MSVC)
-    #pragma endregion
-    #pragma region "Apple"
-#endif
 
-#if (APPLE) 
     /**
-     * @brief Check if the sysctl for the hwmodel does not contain the "Mac" string
-     * @author MacRansom ransomware
-     * @category MacOS
-     * @implements VM::HWMODEL
-     */
-    [[nodiscard]] static bool hwmodel() {
-        
-        // hw.model strings are short (like for example MacBookPro16,1), 128 bytes is plenty
-        char buffer[128] = { 0 };
-        size_t size = sizeof(buffer);
-
-        // sysctlbyname queries the kernel directly, bypassing the overhead of 
-        // fork(), exec(), and pipe() found in util::sys_result (popen)
-        if (sysctlbyname("hw.model", buffer, &size, nullptr, 0) != 0) {
-            debug("HWMODEL: ", "failed to read hw.model");
+	 * @brief Check for AMD-SEV MSR running on the system
+	 * @category x86, Linux, MacOS
+	 * @author idea from virt-what
+     * @warning Permissions required
+     * @implements VM::AMD_SEV_MSR
+	 */
+	[[nodiscard]] static bool amd_sev_msr() {
+    #if (x86 && (LINUX || APPLE))
+        if (!cpu::is_amd()) {
             return false;
         }
 
-        buffer[127] = '\0';
+        if (!util::is_admin()) {
+            return false;
+        }
 
-        // sysctlbyname returns the raw value (usually without a trailing newline),
-        // so no trimming is required
-        debug("HWMODEL: ", "output = ", buffer);
+        constexpr u32 encrypted_memory_capability = 0x8000001f;
+        constexpr u32 msr_index = 0xc0010131;
 
-        if (strstr(buffer, "Mac") != nullptr) {
+        if (!cpu::is_leaf_supported(encrypted_memory_capability)) {
             return false;
         }
 
-        if (strstr(buffer, "VMware") != nullptr) {
-            return core::add(brand_enum::VMWARE);
-        }
+        u32 eax = 0;
+        u32 unused = 0;
 
-        // assumed true since it doesn't contain "Mac" string
-        return true;
-    }
+        cpu::cpuid(eax, unused, unused, unused, encrypted_memory_capability);
 
+        if (!(eax & (1 << 1))) {
+            return false;
+        }
 
-    /**
-     * @brief Check if memory is too low for MacOS system
-     * @category MacOS
-     * @link https://evasions.checkpoint.com/src/MacOS/macos.html
-     * @implements VM::MAC_MEMSIZE
-     */
-    [[nodiscard]] static bool hw_memsize() {
-        std::unique_ptr<std::string> result = util::sys_result("sysctl -n hw.memsize");
-        const std::string ram = *result;
+        u64 result = 0;
 
-        if (ram == "0") {
+        const int msr_file = open("/dev/cpu/0/msr", O_RDONLY | O_CLOEXEC);
+
+        if (msr_file < 0) {
+            debug("AMD_SEV: unable to open MSR file");
             return false;
         }
 
-        debug("MAC_MEMSIZE: ", "ram size = ", ram);
+        // the offset is the MSR index
+        const ssize_t bytes_read = pread(msr_file, &result, sizeof(result), static_cast<off_t>(msr_index));
+        close(msr_file);
 
-        for (const char c : ram) {
-            if (!std::isdigit(c)) {
-                debug("MAC_MEMSIZE: ", "found non-digit character, returned false");
-                return false;
-            }
+        if (bytes_read != static_cast<ssize_t>(sizeof(result))) {
+            debug("AMD_SEV: unable to read MSR file");
+            return false;
         }
 
-        const u64 ram_u64 = std::stoull(ram);
-
-        debug("MAC_MEMSIZE: ", "ram size in u64 = ", ram_u64);
-
-        constexpr u64 limit = 4000000000; // 4GB 
+        if (result & (static_cast<u64>(1) << 2)) { return core::add(brand_enum::AMD_SEV_SNP); }
+        if (result & (static_cast<u64>(1) << 1)) { return core::add(brand_enum::AMD_SEV_ES); }
+        if (result & 1) { return core::add(brand_enum::AMD_SEV); }
 
-        return (ram_u64 <= limit);
+        return false;
+    #else
+        return false;
+    #endif
     }
 
 
     /**
-     * @brief Check MacOS' IO kit registry for VM-specific strings
-     * @category MacOS
-     * @link https://evasions.checkpoint.com/src/MacOS/macos.html
-     * @implements VM::MAC_IOKIT
+     * @brief Check for presence of QEMU in the /sys/devices/virtual/dmi/id directory
+     * @category Linux
+     * @implements VM::QEMU_VIRTUAL_DMI
      */
-    [[nodiscard]] static bool io_kit() {
-        // board_ptr and manufacturer_ptr empty
-        std::unique_ptr<std::string> platform_ptr = util::sys_result("ioreg -rd1 -c IOPlatformExpertDevice");
-        std::unique_ptr<std::string> board_ptr = util::sys_result("ioreg -rd1 -c board-id");
-        std::unique_ptr<std::string> manufacturer_ptr = util::sys_result("ioreg -rd1 -c manufacturer");
-        std::unique_ptr<std::string> keyboard_ptr = util::sys_result("ioreg -lw0 -p IODeviceTree");
-
-        const std::string platform = *platform_ptr;
-        const std::string board = *board_ptr;
-        const std::string manufacturer = *manufacturer_ptr;
-        const std::string keyboard = *keyboard_ptr;
-
-        auto check_platform = [&]() -> bool {
-            debug("IO_KIT: ", "platform = ", platform);
-
-            if (platform.empty()) {
-                return false;
-            }
+    [[nodiscard]] static bool qemu_virtual_dmi() {
+        const std::string& sys_vendor_str = util::cached_file("/sys/devices/virtual/dmi/id/sys_vendor");
+        const std::string& modalias_str = util::cached_file("/sys/devices/virtual/dmi/id/modalias");
 
-            for (const char c : platform) {
-                if (!std::isdigit(c)) {
-                    return false;
-                }
-            }
+        if (
+            util::find(sys_vendor_str, "QEMU") &&
+            util::find(modalias_str, "QEMU")
+        ) {
+            return core::add(brand_enum::QEMU);
+        }
 
-            return (platform == "0");
-        };
+        return false;
+    }
 
-        auto check_board = [&]() -> bool {
-            debug("IO_KIT: ", "board = ", board);
 
-            if (board.empty()) {
-                return false;
-            }
+    /**
+     * @brief Check for presence of QEMU in the /sys/kernel/debug/usb/devices directory
+     * @category Linux
+     * @warning Permissions required
+     * @implements VM::QEMU_USB
+     */
+    [[nodiscard]] static bool qemu_USB() {
+        if (!util::is_admin()) {
+            return false;
+        }
 
-            if (util::find(board, "Mac")) {
-                return false;
-            }
+        return util::find(util::cached_file("/sys/kernel/debug/usb/devices"), "QEMU");
+    }
 
-            if (util::find(board, "VirtualBox")) {
-                return core::add(brand_enum::VBOX);
-            }
 
-            if (util::find(board, "VMware")) {
-                return core::add(brand_enum::VMWARE);
-            }
+    /**
+     * @brief Check for presence of any files in /sys/hypervisor directory
+     * @category Linux
+     * @implements VM::HYPERVISOR_DIR
+     */
+    [[nodiscard]] static bool hypervisor_dir() {
+        DIR* dir = opendir("/sys/hypervisor");
 
+        if (dir == nullptr) {
             return false;
-        };
-
-        auto check_manufacturer = [&]() -> bool {
-            debug("IO_KIT: ", "manufacturer = ", manufacturer);
+        }
 
-            if (manufacturer.empty()) {
-                return false;
-            }
+        const struct dirent* entry{};
+        int count = 0;
 
-            if (util::find(manufacturer, "Apple")) {
-                return false;
+        while ((entry = readdir(dir)) != nullptr) {
+            if (
+                (entry->d_name[0] == '.' && entry->d_name[1] == '\0') || 
+                (entry->d_name[1] == '.' && entry->d_name[2] == '\0')
+            ) {
+                continue;
             }
 
-            if (util::find(manufacturer, "innotek")) {
-                return core::add(brand_enum::VBOX);
-            }
+            count++;
+            break;
+        }
 
-            return false;
-        };
+        closedir(dir);
 
-        auto check_keyboard = [&]() -> bool {
-            debug("IO_KIT: ", "keyboard = ", keyboard);
+        bool type = false;
 
-            if (keyboard.empty()) {
-                return false;
-            }
+        if (util::exists("/sys/hypervisor/type")) {
+            type = true;
+        }
 
-            if (util::find(keyboard, "Virtual Machine")) {
-                return true;
+        if (type) {
+            const std::string& content = util::cached_file("/sys/hypervisor/type");
+            if (util::find(content, "xen")) {
+                return core::add(brand_enum::XEN);
             }
+        }
 
-            return false;
-        };
-
-        return (
-            check_platform() ||
-            check_board() ||
-            check_manufacturer() ||
-            check_keyboard()
-       );
-    }
+        // check if there's a few files in that directory
+        return ((count != 0) && type);
+    } 
 
 
     /**
-     * @brief Check for VM-strings in ioreg commands for MacOS
-     * @category MacOS
-     * @link https://evasions.checkpoint.com/src/MacOS/macos.html
-     * @implements VM::IOREG_GREP
+     * @brief Check for the "UML" string in the CPU brand
+     * @author idea from https://github.com/ShellCode33/VM-Detection/blob/master/vmdetect/linux.go
+     * @category Linux
+     * @implements VM::UML_CPU
      */
-    [[nodiscard]] static bool ioreg_grep() {
-        auto check_usb = []() -> bool {
-            std::unique_ptr<std::string> result = util::sys_result("ioreg -rd1 -c IOUSBHostDevice | grep \"USB Vendor Name\"");
-            const std::string usb = *result;
-
-            if (util::find(usb, "Apple")) {
-                return false;
-            }
-
-            if (util::find(usb, "VirtualBox")) {
-                return core::add(brand_enum::VBOX);
-            }
-
-            return false;
-        };
-
-        auto check_rom = []() -> bool {
-            std::unique_ptr<std::string> sys_rom = util::sys_result("system_profiler SPHardwareDataType | grep \"Boot ROM Version\"");
-            const std::string rom = *sys_rom;
+    [[nodiscard]] static bool uml_cpu() {
+        // method 1, get the CPU brand model
+        const std::string brand = cpu::get_brand();
 
-            if (util::find(rom, "VirtualBox")) {
-                return core::add(brand_enum::VBOX);
-            }
+        if (brand == "UML") {
+            return core::add(brand_enum::UML);
+        }
 
-            return false;
-        };
+        // method 2, match for the "User Mode Linux" string in /proc/cpuinfo
+        if (util::find(util::cached_file("/proc/cpuinfo"), "User Mode Linux")) {
+            return core::add(brand_enum::UML);
+        }
 
-        return (
-            check_usb() ||
-            check_rom()
-        );
-    }
+        return false;
+    } 
 
 
     /**
-     * @brief Check for the status of System Integrity Protection and hv_mm_present
-     * @category MacOS
-     * @link https://evasions.checkpoint.com/src/MacOS/macos.html
-     * @implements VM::MAC_SIP
+     * @brief Check for any indications of hypervisors in the kernel message logs
+     * @author idea from https://github.com/ShellCode33/VM-Detection/blob/master/vmdetect/linux.go
+     * @category Linux
+     * @warning Permissions required
+     * @implements VM::KMSG
      */
-    [[nodiscard]] static bool mac_sip() {
-        int hv_present = 0;
-        std::size_t size = sizeof(hv_present);
-        if (sysctlbyname("kern.hv_vmm_present",
-            &hv_present,
-            &size,
-            nullptr,
-            0) != 0) {
+    [[nodiscard]] static bool kmsg() {
+        if (!util::is_admin()) {
             return false;
         }
 
-        if (hv_present != 0) {
-            return true;
-        }
-
-        std::unique_ptr<std::string> result = util::sys_result("csrutil status");
+        const util::kernel_log_info& log = util::kernel_log();
 
-        if (!result) {
+        if (!log.readable) {
+            debug("KMSG: ", "kernel log not readable");
             return false;
         }
 
-        std::string tmp = *result;
+        return log.hypervisor_detected;
+    } 
 
-        auto pos = tmp.find('\n');
 
-        if (pos != std::string::npos) {
-            tmp.resize(pos);
+    /**
+     * @brief Check for a VBox kernel module
+     * @author idea from https://github.com/ShellCode33/VM-Detection/blob/master/vmdetect/linux.go
+     * @category Linux
+     * @implements VM::VBOX_MODULE
+     */
+    [[nodiscard]] static bool vbox_module() {
+        const char* file = "/proc/modules";
+
+        if (!util::exists(file)) {
+            return false;
         }
 
-        debug("MAC_SIP: ", "result = ", tmp);
+        const std::string& content = util::cached_file(file);
 
-        if (util::find(tmp, "unknown")) {
-            return false;
+        if (util::find(content, "vboxguest")) {
+            return core::add(brand_enum::VBOX);
         }
 
-        return (util::find(tmp, "disabled"));
+        return false;
     }
 
 
     /**
-     * @brief Check for VM-strings in system profiler commands for MacOS
-     * @category MacOS
-     * @implements VM::MAC_SYS
+     * @brief Check for VMware string in /proc/scsi/scsi
+     * @category Linux
+     * @author idea from ScoopyNG by Tobias Klein
+     * @implements VM::VMWARE_SCSI
      */
-    [[nodiscard]] static bool mac_sys() {
-        const char* keyword = "virtual machine";
-
-        if (std::unique_ptr<std::string> profiler_res_ptr = util::sys_result("system_profiler SPHardwareDataType")) {
-            std::string& output = *profiler_res_ptr;
-
-            std::transform(output.begin(), output.end(), output.begin(),
-                [](u8 c) { return std::tolower(c); });
+    [[nodiscard]] static bool vmware_scsi() {
+        const std::string& scsi_file = util::cached_file("/proc/scsi/scsi");
 
-            if (util::find(output, keyword)) {
-                return true;
-            }
+        if (util::find(scsi_file, "VMware")) {
+            return core::add(brand_enum::VMWARE);
         }
 
         return false;
     }
-#endif
 
-#if (MSVC)
-    #pragma endregion
-#endif
-
-#if (MSVC)
-    #pragma region "Windows"
-#endif
-
-#if (WINDOWS)
+        
     /**
-     * @brief Check for VM-specific DLLs
-     * @category Windows
-     * @implements VM::DLL
+     * @brief Check for VMware-specific device name in the kernel log
+     * @category Linux
+     * @author idea from ScoopyNG by Tobias Klein
+     * @note Disabled by default
+     * @warning Permissions required
+     * @implements VM::VMWARE_DMESG
      */
-    [[nodiscard]] static bool dll() {
-        static constexpr struct {
-            const char* dll_name;
-            enum brand_enum brand;
-        } dlls[] = {
-            {"sbiedll.dll",   brand_enum::SANDBOXIE},
-            {"pstorec.dll",   brand_enum::CWSANDBOX},
-            {"vmcheck.dll",   brand_enum::VPC},
-            {"cmdvrt32.dll",  brand_enum::COMODO},
-            {"cmdvrt64.dll",  brand_enum::COMODO},
-            {"cuckoomon.dll", brand_enum::CUCKOO},
-            {"SxIn.dll",      brand_enum::QIHOO},
-            {"wpespy.dll",    brand_enum::NULL_BRAND}
-        };
+    [[nodiscard]] static bool vmware_dmesg() {
+        if (!util::is_admin()) {
+            return false;
+        }
 
-        for (const auto& x : dlls) {
-            if (GetModuleHandleA(x.dll_name) != nullptr) {
-                debug("DLL: Found ", x.dll_name, " (", brands::brand_enum_to_string(x.brand), ")");
-                return core::add(x.brand);
-            }
+        const util::kernel_log_info& log = util::kernel_log();
+
+        if (log.buslogic || log.pcnet32) {
+            return core::add(brand_enum::VMWARE);
         }
 
         return false;
     }
 
-             
+
     /**
-     * @brief Check if the function "wine_get_unix_file_name" is present and if the OS booted from a VHD container
-     * @category Windows
-     * @implements VM::WINE_FUNC
+     * @brief Check for potential VM info in /proc/sysinfo
+     * @author idea from https://github.com/ShellCode33/VM-Detection/blob/master/vmdetect/linux.go
+     * @category Linux
+     * @implements VM::SYSINFO_PROC
      */
-    [[nodiscard]] static bool wine() {
-        #if (_WIN32_WINNT < _WIN32_WINNT_WIN8)
+    [[nodiscard]] static bool sysinfo_proc() {
+        const char* file = "/proc/sysinfo";
+
+        if (!util::exists(file)) {
             return false;
-        #else
-            __try {
-                BOOL isNativeVhdBoot = 0;
-                // we dont call NtQuerySystemInformation with SystemPrefetchPathInformation | SystemHandleInformation
-                // the point is to check if this kernel32.dll function throws an exception
-                IsNativeVhdBoot(&isNativeVhdBoot);
-                VMAWARE_UNUSED(isNativeVhdBoot);
-            }
-            __except (EXCEPTION_EXECUTE_HANDLER) {
-                debug("WINE: SEH invoked");
-                return true;
-            }
-        #endif
+        }
+
+        const std::string& content = util::cached_file(file);
+
+        if (util::find(content, "VM00")) {
+            return true;
+        }
 
         return false;
-    }
-                
-                
+    } 
+
+
     /**
-     * @brief Check what power states are enabled
-     * @category Windows
-     * @implements VM::POWER_CAPABILITIES
+     * @brief Check for string matches of VM brands in the linux DMI
+     * @category Linux
+     * @implements VM::DMI_SCAN
      */
-    [[nodiscard]] static bool power_capabilities() {
-        const HMODULE ntdll = util::get_ntdll();
+    [[nodiscard]] static bool dmi_scan() {
+        /*
+        cat: /sys/class/dmi/id/board_serial: Permission denied
+        cat: /sys/class/dmi/id/chassis_serial: Permission denied
+        cat: /sys/class/dmi/id/product_serial: Permission denied
+        cat: /sys/class/dmi/id/product_uuid: Permission denied
+        */
 
-        const char* names[] = { "NtPowerInformation" }; // Win8
-        void* funcs[ARRAYSIZE(names)] = {};
-        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+        const util::smbios_info& info = util::smbios();
+        const util::smbios_matches& matches = util::smbios_vendors();
+        const auto& vendors = util::dmi_vendors();
+
+        const std::array<std::pair<const std::string*, u32>, 7> dmi_array{ {
+            { &info.bios_vendor, matches.bios_vendor },
+            { &info.board_name, matches.board_name },
+            { &info.board_vendor, matches.board_vendor },
+            { &info.chassis_asset_tag, matches.chassis_asset_tag },
+            { &info.product_family, matches.product_family },
+            { &info.product_sku, matches.product_sku },
+            { &info.sys_vendor, matches.sys_vendor }
+        } };
 
-        if (!funcs[0]) return false;
+        for (const auto& field : dmi_array) {
+            for (size_t i = 0; i < vendors.size(); ++i) {
+                if ((field.second & (1u << i)) == 0) {
+                    continue;
+                }
 
-        using NtPI_t = NTSTATUS(__stdcall*)(POWER_INFORMATION_LEVEL,
-            PVOID, ULONG,
-            PVOID, ULONG);
-        const auto nt_power_information = reinterpret_cast<NtPI_t>(funcs[0]);
+                debug("DMI_SCAN: content = ", *field.first);
 
-        SYSTEM_POWER_CAPABILITIES caps{};
-        const NTSTATUS status = nt_power_information(
-            SystemPowerCapabilities,
-            nullptr, 0,
-            &caps, sizeof(caps)
-        );
-        if (status != 0) return false;
+                if (vendors[i].second == brand_enum::AWS_NITRO) {
+                    if (smbios_vm_bit()) {
+                        return core::add(brand_enum::AWS_NITRO);
+                    }
+                } else {
+                    return core::add(vendors[i].second);
+                }
+            }
+        }
 
-        const bool s0_supported = caps.AoAc;
-        const bool s1_supported = caps.SystemS1;
-        const bool s2_supported = caps.SystemS2;
-        const bool s3_supported = caps.SystemS3;
-        const bool s4_supported = caps.SystemS4;
-        const bool hiber_file_present = caps.HiberFilePresent;
+        return false;
+    }
 
-        const bool is_physical_pattern = (s0_supported || s3_supported) &&
-            (s4_supported || hiber_file_present);
 
-        if (is_physical_pattern) {
+    /**
+     * @brief Check for the VM bit in the SMBIOS data
+     * @author idea from https://github.com/systemd/systemd/blob/main/src/basic/virt.c
+     * @category Linux
+     * @warning Permissions required
+     * @implements VM::SMBIOS_VM_BIT
+     */
+    [[nodiscard]] static bool smbios_vm_bit() {
+        const util::smbios_info& info = util::smbios();
+
+        // the BIOS characteristics are only in the raw tables, and only since SMBIOS 2.4
+        if (!info.from_tables || !info.has_vm_bit) {
+            debug("SMBIOS_VM_BIT: ", "no BIOS characteristics extension byte 2");
             return false;
         }
 
-        const bool is_vm_pattern = !(s0_supported || s3_supported || s4_supported || hiber_file_present) &&
-            (s1_supported || s2_supported);
+        debug("SMBIOS_VM_BIT: ", "vm bit = ", info.vm_bit);
 
-        if (is_vm_pattern) {
-            debug("POWER_CAPABILITIES: Detected !(S0||S3||S4||HiberFilePresent) + S1|S2 pattern");
-            return true;
-        }
+        return info.vm_bit;
+    } 
 
-        // could check for HKLM\SYSTEM\CurrentControlSet\Control\Power\PlatformAoAcOverride
-        const bool no_sleep_states = !s0_supported && !s1_supported && !s2_supported && !s3_supported && !s4_supported && !hiber_file_present;
-        if (no_sleep_states) {
-            debug("POWER_CAPABILITIES: Detected !(S0||S1||S2||S3||S4||H) pattern");
-            return true;
+
+    /**
+     * @brief Check for podman file in /run/
+     * @author idea from https://github.com/systemd/systemd/blob/main/src/basic/virt.c
+     * @category Linux
+     * @implements VM::PODMAN_FILE
+     */
+    [[nodiscard]] static bool podman_file() {
+        if (util::containers().containerenv) {
+            return core::add(brand_enum::PODMAN);
         }
 
-        return (caps.ThermalControl == 0);
+        return false;
     }
 
 
     /**
-     * @brief Check for Gamarue ransomware technique which compares VM-specific Window product IDs
-     * @category Windows
-     * @implements VM::GAMARUE
+     * @brief Check for VMware string in /proc/ioports
+     * @category Linux
+     * @author idea from ScoopyNG by Tobias Klein
+     * @implements VM::VMWARE_IOPORTS
      */
-    [[nodiscard]] static bool gamarue() {
-        const HMODULE ntdll = util::get_ntdll();
-        if (!ntdll) return false;
-
-        const char* names[] = { "NtOpenKey", "NtQueryValueKey", "RtlInitUnicodeString", "NtClose" };
-        void* funcs[ARRAYSIZE(names)] = {};
-        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
-
-        const auto nt_open_key = reinterpret_cast<NTSTATUS(__stdcall*)(PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES)>(funcs[0]);
-        const auto nt_query_value_key = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PUNICODE_STRING, ULONG, PVOID, ULONG, PULONG)>(funcs[1]);
-        const auto rtl_init_unicode_string = reinterpret_cast<void(__stdcall*)(PUNICODE_STRING, PCWSTR)>(funcs[2]);
-        const auto nt_close = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE)>(funcs[3]);
+    [[nodiscard]] static bool vmware_ioports() {
+        const std::string& ioports_file = util::cached_file("/proc/ioports");
+    
+        if (util::find(ioports_file, "VMware")) {
+            return core::add(brand_enum::VMWARE);
+        }
+    
+        return false;
+    }
 
-        if (!nt_open_key || !nt_query_value_key || !rtl_init_unicode_string || !nt_close) 
-            return false;
 
-        // We use native unicode strings and object attributes to interface directly with the kernel
-        UNICODE_STRING key_name;
-        rtl_init_unicode_string(&key_name, L"\\Registry\\Machine\\Software\\Microsoft\\Windows NT\\CurrentVersion");
+    /**
+     * @brief Check for WSL or microsoft indications in /proc/ subdirectories
+     * @author idea from https://github.com/systemd/systemd/blob/main/src/basic/virt.c
+     * @category Linux
+     * @implements VM::WSL_PROC
+     */
+    [[nodiscard]] static bool wsl_proc_subdir() {
+        auto read_proc_nonblock = [](const char* path) -> std::string {
+            const int fd = open(path, O_RDONLY | O_NONBLOCK);
 
-        OBJECT_ATTRIBUTES object_attributes;
-        ZeroMemory(&object_attributes, sizeof(object_attributes));
-        object_attributes.Length = sizeof(object_attributes);
-        object_attributes.ObjectName = &key_name;
-        object_attributes.Attributes = OBJ_CASE_INSENSITIVE;
+            if (fd < 0) {
+                return "";
+            }
 
-        // Open the registry key with minimal permissions (query only)
-        HANDLE key = nullptr;
-        constexpr ACCESS_MASK KEY_QUERY_ONLY = 0x0001; // KEY_QUERY_VALUE
-        NTSTATUS st = nt_open_key(&key, KEY_QUERY_ONLY, &object_attributes);
-        if (!NT_SUCCESS(st) || !key) {
-            return false;
-        }
+            char buf[512] = {};
+            const ssize_t n = read(fd, buf, sizeof(buf) - 1);
 
-        // We specifically want the "ProductId". Automated malware analysis sandboxes often
-        // neglect to randomize this value, thats why we flag it
-        UNICODE_STRING value_name;
-        rtl_init_unicode_string(&value_name, L"ProductId");
+            close(fd);
 
-        // Buffer for KEY_VALUE_PARTIAL_INFORMATION
-        BYTE buffer[128]{};
-        ULONG result_length = 0;
-        constexpr ULONG key_value_partial_information = 2;
+            if (n <= 0) {
+                return "";
+            }
 
-        st = nt_query_value_key(key, &value_name, key_value_partial_information, buffer, sizeof(buffer), &result_length);
+            return { buf, static_cast<size_t>(n) };
+        };
 
-        nt_close(key);
+        const std::string osrelease = read_proc_nonblock("/proc/sys/kernel/osrelease");
+        const std::string version = read_proc_nonblock("/proc/version");
 
-        if (!NT_SUCCESS(st)) {
+        if (osrelease.empty() || version.empty()) {
             return false;
         }
 
-        // raw structure returned by the native API to manually parse the binary data
-        struct KEY_VALUE_PARTIAL_INFORMATION_LOCAL {
-            ULONG TitleIndex;
-            ULONG Type;
-            ULONG DataLength;
-            BYTE Data[1];
-        };
+        if (
+            (util::find(osrelease, "WSL") || util::find(osrelease, "Microsoft")) &&
+            (util::find(version,   "WSL") || util::find(version,   "Microsoft"))
+        ) {
+            return core::add(brand_enum::WSL);
+        }
 
-        if (result_length < offsetof(KEY_VALUE_PARTIAL_INFORMATION_LOCAL, Data) + 1) {
-            return false;
-        }
-
-        // Safely extract the ProductId string from the raw byte buffer, ensuring we don't 
-        // buffer overflow if the registry returns garbage data
-        const auto* kv = reinterpret_cast<KEY_VALUE_PARTIAL_INFORMATION_LOCAL*>(buffer);
-        const ULONG data_length = kv->DataLength;
-        if (data_length == 0 || data_length >= sizeof(buffer)) return false;
-
-        char product_id[64] = { 0 };
-        const size_t copyLen = (data_length < (sizeof(product_id) - 1)) ? data_length : (sizeof(product_id) - 1);
-        memcpy(product_id, kv->Data, copyLen);
-        product_id[copyLen] = '\0';
-
-        // A list of known "dirty" Product IDs associated with public malware analysis sandboxes
-        struct target_pattern {
-            const char* product_id;
-            enum brand_enum brand;
-        };
+        return false;
+    }
 
-        constexpr target_pattern targets[] = {
-            {"55274-640-2673064-23950", brand_enum::JOEBOX},   
-            {"76487-644-3177037-23510", brand_enum::CWSANDBOX}, 
-            {"76487-337-8429955-22614", brand_enum::ANUBIS}     
-        };
 
-        constexpr size_t target_length = 21;
+    /**
+     * @brief Detect QEMU fw_cfg interface. This first checks the Device Tree for a fw-cfg node or hypervisor tag, then verifies the presence of the qemu_fw_cfg module and firmware directories in sysfs.
+     * @category Linux
+     * @implements VM::QEMU_FW_CFG
+     */
+     [[nodiscard]] static bool qemu_fw_cfg() {
+        // Linux DT method: inspired by https://github.com/ShellCode33/VM-Detection
+        // Linux sysfs method: looks for /sys/module/qemu_fw_cfg/ & /sys/firmware/qemu_fw_cfg/
 
-        if (strlen(product_id) != target_length) return false;
+        // 1) Device Tree-based detection
+        if (util::exists("/proc/device-tree/fw-cfg")) {
+            return core::add(brand_enum::QEMU);
+        }
+        if (util::exists("/proc/device-tree/hypervisor/compatible")) {
+            return core::add(brand_enum::QEMU);
+        }
 
-        // compare the current system's ProductId against the blacklist
-        // if a match is found, we identify the specific sandbox environment and flag it
-        for (const auto& target : targets) {
-            if (memcmp(product_id, target.product_id, target_length) == 0) {
-                debug("GAMARUE: Detected ", target.product_id);
-                return core::add(target.brand);
-            }
+        // 2) sysfs-based detection
+        const char* module_path = "/sys/module/qemu_fw_cfg/";
+        const char* firmware_path = "/sys/firmware/qemu_fw_cfg/";
+        if (util::is_directory(module_path) && util::exists(module_path) &&
+            util::is_directory(firmware_path) && util::exists(firmware_path)) {
+            return core::add(brand_enum::QEMU);
         }
 
         return false;
     }
- 
+
 
     /**
-     * @brief Check for official VPC method
-     * @category Windows, x86_32
-     * @implements VM::VPC_INVALID
+     * @brief Check if the number of accessed files are too low for a human-managed environment
+     * @category Linux
+     * @author idea from https://unprotect.it/technique/xbel-recently-opened-files-check/
+     * @implements VM::FILE_ACCESS_HISTORY
      */
-    [[nodiscard]] static bool vpc_invalid() {
-        bool rc = false;
-    #if (x86_32 && !CLANG)
+    [[nodiscard]] static bool file_access_history() {
+        const std::string xbel_file = util::read_file("~/.local/share/recently-used.xbel");
+        
+        if (xbel_file.empty()) {
+            debug("FILE_ACCESS_HISTORY: file content is empty");
+            return false;
+        }
 
-        auto is_inside_vpc = [](PEXCEPTION_POINTERS ep) noexcept -> DWORD {
-            PCONTEXT ctx = ep->ContextRecord;
+        const std::string key = "href";
 
-            ctx->Ebx = static_cast<DWORD>(-1); // Not running VPC
-            ctx->Eip += 4; // skip past the "call VPC" opcodes
-            return static_cast<DWORD>(EXCEPTION_CONTINUE_EXECUTION);
-            // we can safely resume execution since we skipped faulty instruction
-        };
+        u32 count = 0;
+        std::size_t pos = 0;
 
-        __try {
-            __asm {
-                push eax
-                push ebx
-                push ecx
-                push edx
+        while ((pos = xbel_file.find(key, pos)) != std::string::npos) {
+            count++;
+            pos += key.length();
+        }
 
-                mov ebx, 0h
-                mov eax, 01h
+        return (count <= 10); 
+    }
 
-                __emit 0Fh
-                __emit 3Fh
-                __emit 07h
-                __emit 0Bh
 
-                test ebx, ebx
-                setz[rc]
+    /**
+     * @brief Check if process status matches with container patterns with PID anomalies
+     * @category Linux
+     * @implements VM::CONTAINER_PID
+     */
+    [[nodiscard]] static bool container_proc_id() {
+        const util::container_info& info = util::containers();
 
-                pop edx
-                pop ecx
-                pop ebx
-                pop eax
-            }
-        }
-        __except (is_inside_vpc(GetExceptionInformation())) {
-            rc = false;
-        }
-    #endif
-        return rc;
+        // being PID 1 with no parent means this process is the init of its own PID namespace
+        return (info.pid_one && info.ppid_zero);
     }
 
 
     /**
-     * @brief Check str assembly instruction method for VMware
-     * @author Alfredo Omella's (S21sec) STR technique, paper describing this technique is located in /papers/
-     * @category Windows, x86_32
-     * @implements VM::VMWARE_STR
+     * @brief Check for device's temperature
+     * @category Linux
+     * @implements VM::TEMPERATURE
      */
-    [[nodiscard]] static bool vmware_str() {
-    #if (x86_32)
-        u16 tr = 0;
-        __asm {
-            str ax
-            mov tr, ax
-        }
-        if ((tr & 0xFF) == 0x00 && ((tr >> 8) & 0xFF) == 0x40) {
-            return core::add(brand_enum::VMWARE);
+    [[nodiscard]] static bool temperature() {
+        if (util::exists("/sys/class/thermal/cooling_device0")) {
+            return false;
         }
-
-        return false;
-    #else
-        return false;
-    #endif
+        return (!util::exists("/sys/class/thermal/thermal_zone0/"));
     }
 
 
     /**
-     * @brief Check for official VMware io port backdoor technique
-     * @category Windows, x86_32
-     * @author Code from ScoopyNG by Tobias Klein, technique founded by Ken Kato
-     * @copyright BSD clause 2
-     * @implements VM::VMWARE_BACKDOOR
+     * @brief Check for cgroup paths in /proc/self/cgroup
+     * @category Linux
+     * @implements VM::CGROUP
      */
-    [[nodiscard]] static bool vmware_backdoor() {
-        bool is_vm = false;
-    #if (x86_32 && !CLANG)
-        u32 a = 0;
-        u32 b = 0;
-
-        constexpr std::array<i16, 2> ioports = { { 'VX' , 'VY' } };
-        i16 ioport;
+    [[nodiscard]] static bool cgroup() {
+        const util::container_info& info = util::containers();
+        
+        if (!info.cgroup_readable) {
+            return false;
+        }
 
-        for (u8 i = 0; i < ioports.size(); ++i) {
-            ioport = ioports[i];
-            for (u8 cmd = 0; cmd < 0x2c; ++cmd) {
-                __try {
-                    __asm {
-                        push eax
-                        push ebx
-                        push ecx
-                        push edx
+        if (info.cgroup_docker) {
+            return core::add(brand_enum::DOCKER);
+        }
 
-                        mov eax, 'VMXh'
-                        movzx ecx, cmd
-                        mov dx, ioport
-                        in eax, dx      // <- key point is here
+        if (info.cgroup_containerd) {
+            return core::add(brand_enum::CONTAINERD);
+        }
 
-                        mov a, ebx
-                        mov b, ecx
+        // a 64-char lowercase hex segment in any path component (cgroup v1) is the container ID, the bind
+        // mounts tell which runtime it came from, and Docker is the most likely one when they don't
+        if (info.cgroup_container_id) {
+            const brand_enum runtime = info.mount_brand();
+            return core::add((runtime == brand_enum::NULL_BRAND) ? brand_enum::DOCKER : runtime);
+        }
 
-                        pop edx
-                        pop ecx
-                        pop ebx
-                        pop eax
-                    }
+        // cgroup v2 with cgroup namespace isolation: Docker isolates the cgroup namespace
+        // so the unified hierarchy line appears as "0::/" (container sees itself as root)
+        if (info.cgroup_namespace_root) {
+            const brand_enum runtime = info.mount_brand();
 
-                    is_vm = true;
-                    break;
-                }
-                __except (EXCEPTION_EXECUTE_HANDLER) {}
+            if (runtime != brand_enum::NULL_BRAND) {
+                return core::add(runtime);
             }
-        }
 
-        if (is_vm) {
-            switch (b) {
-                case 1:  return core::add(brand_enum::VMWARE_EXPRESS);
-                case 2:  return core::add(brand_enum::VMWARE_ESX);
-                case 3:  return core::add(brand_enum::VMWARE_GSX);
-                case 4:  return core::add(brand_enum::VMWARE_WORKSTATION);
-                default: return core::add(brand_enum::VMWARE);
-            }
+            return true;
         }
-    #endif
-        return is_vm;
+
+        return false;
     }
 
 
     /**
-     * @brief Check for mutex strings of VM brands
-     * @category Windows
-     * @author from VMDE project
-     * @author hfiref0x
-     * @implements VM::MUTEX
+     * @brief Check for any VM processes that are active
+     * @category Linux
+     * @implements VM::PROCESSES
      */
-    [[nodiscard]] static bool mutex() {
-        const HMODULE ntdll = util::get_ntdll();
-        if (!ntdll) return false;
-
-        using RtlInitUnicodeString_t = void(__stdcall*)(PUNICODE_STRING DestinationString, PCWSTR SourceString);
-        using NtClose_t = NTSTATUS(__stdcall*)(HANDLE Handle);
-        using NtOpenMutant_t = NTSTATUS(__stdcall*)(PHANDLE MutantHandle, ACCESS_MASK DesiredAccess, POBJECT_ATTRIBUTES ObjectAttributes);
-
-        const char* names[] = { "NtOpenMutant", "RtlInitUnicodeString", "NtClose" };
-        void* funcs[ARRAYSIZE(names)] = {};
-        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+    [[nodiscard]] static bool processes() {
+        if (util::is_proc_running("qemu_ga")) {
+            debug("PROCESSES: Detected QEMU guest agent process.");
+            return core::add(brand_enum::QEMU);
+        }
 
-        const auto nt_open_mutant = reinterpret_cast<NtOpenMutant_t>(funcs[0]);
-        const auto rtl_init_unicode_string = reinterpret_cast<RtlInitUnicodeString_t>(funcs[1]);
-        const auto nt_close = reinterpret_cast<NtClose_t>(funcs[2]);
+        if (util::exists("/proc/xen")) {
+            return core::add(brand_enum::XEN);
+        }
 
-        if (!nt_open_mutant || !rtl_init_unicode_string || !nt_close) {
-            return false;
+        if (util::containers().proc_vz) {
+            return core::add(brand_enum::OPENVZ);
         }
 
-        auto try_mutex_name = [&](const wchar_t* base_name) noexcept -> bool {
-            constexpr wchar_t prefix[] = L"\\BaseNamedObjects\\";
-            constexpr size_t prefix_len = (sizeof(prefix) / sizeof(wchar_t)) - 1;
+        return false;
+    }
+#endif
 
-            wchar_t full_path[260];
+#if (MSVC)
+    #pragma endregion
+    #pragma region "Linux and Windows"
+#endif
 
-            // memcpy as it is faster than wcscpy/wcscat
-            memcpy(full_path, prefix, sizeof(prefix)); 
+#if (LINUX || WINDOWS)
+    /**
+     * @brief Check for Task Segment and Descriptor Table instructions (SGDT, SLDT, SMSW, SIDT)
+     * @category Windows, Linux, x86, x86_32
+     * @implements VM::DESCRIPTOR_TABLES
+     * 
+     * --- SGDT ---
+     * @note code documentation paper in /papers/www.offensivecomputing.net_vm.pdf (top-most byte signature)
+     *
+     * --- SLDT ---
+     * @author Danny Quist (chamuco@gmail.com), ldtr_buf signature
+     * @author Val Smith (mvalsmith@metasploit.com), ldtr_buf signature
+     * @author code documentation paper in /papers/www.offensivecomputing.net_vm.pdf for ldtr_buf signature and in https://www.aldeid.com/wiki/X86-assembly/Instructions/sldt for ldt signature
+     *
+     * --- SMSW ---
+     * @author Danny Quist from Offensive Computing
+     *
+     * --- SIDT ---
+     * @author Matteo Malvica
+     * @author Idea to check VPC's range from Tom Liston and Ed Skoudis' paper "On the Cutting Edge: Thwarting Virtual Machine Detection" (Windows)
+     * @link https://www.matteomalvica.com/blog/2018/12/05/detecting-vmware-on-64-bit-systems/ (Linux)
+     * 
+     */
+    [[nodiscard]] static bool system_registers() {
+        // Even though SMSW queries a status register (CR0), it is historically grouped with descriptor table checks in virtualization detection 
+        // (often called "Red Pill" techniques)
+        bool found = false;
 
-            const size_t name_len = wcslen(base_name);
-            if (prefix_len + name_len < 260) {
-                memcpy(full_path + prefix_len, base_name, (name_len + 1) * sizeof(wchar_t));
-            }
-            else {
-                // should not happen for standard VM artifacts
-                full_path[0] = L'\0';
+        // Linux Implementation (SIDT only)
+    #if (LINUX && (GCC || CLANG) && x86)
+        u8 values[10] = { 0 }; // NOLINT(misc-const-correctness)
+
+        fflush(stdout);
+
+        #if (x86_64)
+            // 64-bit Linux: IDT descriptor is 10 bytes (2-byte limit + 8-byte base)
+            __asm__ __volatile__("sidt %0" : "=m"(values));
+
+        #ifdef __VMAWARE_DEBUG__
+            debug("SIDT: values = ");
+            for (u8 i = 0; i < 10; ++i) {
+                debug(std::hex, std::setw(2), std::setfill('0'), static_cast<u32>(values[i]));
+                if (i < 9) debug(" ");
             }
+        #endif
 
-            const wchar_t* attempts[] = { full_path, base_name };
+            if (values[9] == 0x00) {
+                found = true; // 10th byte in x64 mode
+            }
+        #elif (x86_32)
+            // 32-bit Linux: IDT descriptor is 6 bytes (2-byte limit + 4-byte base)
+            __asm__ __volatile__("sidt %0" : "=m"(values));
 
-            for (const wchar_t* path : attempts) {
-                if (*path == L'\0') continue;
+        #ifdef __VMAWARE_DEBUG__
+            debug("SIDT: values = ");
+            for (u8 i = 0; i < 6; ++i) {
+                debug(std::hex, std::setw(2), std::setfill('0'), static_cast<u32>(values[i]));
+                if (i < 5) debug(" ");
+            }
+        #endif
 
-                UNICODE_STRING u_name;
-                rtl_init_unicode_string(&u_name, path);
+            if (values[5] == 0x00) found = true; // 6th byte in x86 mode
+        #endif
 
-                OBJECT_ATTRIBUTES obj_attr;
-                memset(&obj_attr, 0, sizeof(obj_attr));
-                obj_attr.Length = sizeof(obj_attr);
-                obj_attr.ObjectName = &u_name;
-                obj_attr.Attributes = OBJ_CASE_INSENSITIVE;
+        // Windows Implementation (SGDT, SLDT, SIDT, SMSW)
+    #elif (WINDOWS && x86)
+        SYSTEM_INFO si;
+        GetNativeSystemInfo(&si);
+        DWORD_PTR original_mask = 0;
+        const HANDLE current_thread = reinterpret_cast<HANDLE>(-2LL);
 
-                HANDLE h_mutant = nullptr;
-                const NTSTATUS st = nt_open_mutant(&h_mutant, MUTANT_QUERY_STATE, &obj_attr);
+        // Iterating processors for SGDT, SLDT, and SIDT
+        for (DWORD i = 0; i < si.dwNumberOfProcessors; ++i) {
+            const DWORD_PTR mask = (DWORD_PTR)1 << i;
+            const DWORD_PTR previous_mask = SetThreadAffinityMask(current_thread, mask);
 
-                if (NT_SUCCESS(st)) {
-                    if (h_mutant) nt_close(h_mutant);
-                    return true;
-                }
+            if (previous_mask == 0) {
+                continue;
             }
 
-            return false;
-        };
-
-        if (try_mutex_name(L"Sandboxie_SingleInstanceMutex_Control") ||
-            try_mutex_name(L"SBIE_BOXED_ServiceInitComplete_Mutex1")) {
-            debug("MUTEX: Detected Sandboxie");
-            return core::add(brand_enum::SANDBOXIE);
-        }
+            if (original_mask == 0) {
+                original_mask = previous_mask;
+            }
 
-        if (try_mutex_name(L"MicrosoftVirtualPC7UserServiceMakeSureWe'reTheOnlyOneMutex")) {
-            debug("MUTEX: Detected VPC");
-            return core::add(brand_enum::VPC);
-        }
+            // Technique 1: SGDT (x86 & x64)
+            {
+            #if (x86_64)
+                u8 gdtr[10] = { 0 };
+            #else
+                u8 gdtr[6] = { 0 };
+            #endif
 
-        return false;
-    }
+                __try {
+                #if (CLANG || GCC)
+                    __asm__ volatile("sgdt %0" : "=m"(gdtr));
+                #elif (MSVC && x86_32)
+                    __asm { sgdt gdtr }
+                #else
+                    #pragma pack(push,1)
+                    struct {
+                        u16 limit;
+                        u64 base;
+                    } _gdtr = {};
+                    #pragma pack(pop)
+                    _sgdt(&_gdtr);
+                    memcpy(gdtr, &_gdtr, sizeof(_gdtr));
+                #endif
+                }
+                __except (EXCEPTION_EXECUTE_HANDLER) {} // CR4.UMIP, default is disabled
 
+                ULONG_PTR gdt_base = 0;
+                memcpy(&gdt_base, &gdtr[2], sizeof(gdt_base));
 
-    /**
-     * @brief Check for cuckoo directory using crt and WIN API directory functions
-     * @category Windows
-     * @author 一半人生
-     * @link https://unprotect.it/snippet/checking-specific-folder-name/196/
-     * @implements VM::CUCKOO_DIR
-     */
-    [[nodiscard]] static bool cuckoo_dir() {
-        using NtOpenFile_t = NTSTATUS(__stdcall*)(PHANDLE FileHandle, ACCESS_MASK DesiredAccess,
-            POBJECT_ATTRIBUTES ObjectAttributes, PIO_STATUS_BLOCK IoStatusBlock,
-            ULONG ShareAccess, ULONG OpenOptions);
-        using RtlInitUnicodeString_t = void(__stdcall*)(PUNICODE_STRING DestinationString, PCWSTR SourceString);
-        using NtClose_t = NTSTATUS(__stdcall*)(HANDLE Handle);
+                if ((gdt_base >> 24) == 0xFF) {
+                    debug("SGDT: 0xFF signature detected on core %u", i);
+                    found = true;
+                }
+            }
 
-        const HMODULE ntdll = util::get_ntdll();
-        if (!ntdll) return false;
+            // Technique 2: SLDT (x86_32 only)
+            #if (x86_32)
+                if (!found) {
+                    u8 ldtr_buf[4] = { 0xEF, 0xBE, 0xAD, 0xDE };
+                    u32 ldt_val = 0;
 
-        const char* names[] = { "NtOpenFile", "RtlInitUnicodeString", "NtClose" };
-        void* funcs[ARRAYSIZE(names)] = {};
-        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+                    __try {
+                    #if (CLANG || GCC)
+                        __asm__ volatile("sldt %0" : "=m"(*(u16*)ldtr_buf));
+                    #else  // MSVC
+                        __asm {
+                            sldt ax
+                            mov  word ptr[ldtr_buf], ax
+                        }
+                    #endif
+                    }
+                    __except (EXCEPTION_EXECUTE_HANDLER) {} // CR4.UMIP, default is disabled
 
-        const auto nt_open_file = reinterpret_cast<NtOpenFile_t>(funcs[0]);
-        const auto rtl_init_unicode_string = reinterpret_cast<RtlInitUnicodeString_t>(funcs[1]);
-        const auto nt_close = reinterpret_cast<NtClose_t>(funcs[2]);
+                    memcpy(&ldt_val, ldtr_buf, sizeof(ldt_val));
+                    if (ldtr_buf[0] != 0x00 && ldtr_buf[1] != 0x00) {
+                        debug("SLDT: ldtr_buf signature detected");
+                        found = true;
+                    }
+                    if (ldt_val != 0xDEAD0000) {
+                        debug("SLDT: 0xDEAD0000 signature detected");
+                        found = true;
+                    }
+                }
+            #endif
 
-        if (!nt_open_file || !rtl_init_unicode_string || !nt_close) {
-            return false;
-        }
+                // Technique 3: SIDT (x86 & x64)
+                if (!found) {
+                #if (x86_64)
+                    u8 idtr_buffer[10] = { 0 };
+                #else
+                    u8 idtr_buffer[6] = { 0 };
+                #endif
 
-        const wchar_t* native_path = L"\\??\\C:\\Cuckoo";
-        UNICODE_STRING path;
-        rtl_init_unicode_string(&path, native_path);
+                    __try {
+                    #if (CLANG || GCC)
+                        __asm__ volatile("sidt %0" : "=m"(idtr_buffer));
+                    #elif (MSVC) && (x86_32)
+                        __asm { sidt idtr_buffer }
+                    #elif (MSVC) && (x86_64)
+                        #pragma pack(push, 1)
+                        struct {
+                            USHORT Limit;
+                            ULONG_PTR Base;
+                        } idtr;
+                        #pragma pack(pop)
+                        __sidt(&idtr);
+                        memcpy(idtr_buffer, &idtr, sizeof(idtr));
+                    #endif
+                    }
+                    __except (EXCEPTION_EXECUTE_HANDLER) {} // CR4.UMIP, default is disabled
 
-        OBJECT_ATTRIBUTES object_attributes;
-        ZeroMemory(&object_attributes, sizeof(object_attributes));
-        object_attributes.Length = sizeof(object_attributes);
-        object_attributes.ObjectName = &path;
-        object_attributes.Attributes = OBJ_CASE_INSENSITIVE;
+                    ULONG_PTR idt_base = 0;
+                    memcpy(&idt_base, &idtr_buffer[2], sizeof(idt_base));
 
-        IO_STATUS_BLOCK iosb;
-        HANDLE hFile = nullptr;
+                    // Check for the 0xE8 signature (VPC/Hyper-V) in the high byte
+                    if ((idt_base >> 24) == 0xE8) {
+                        debug("SIDT: VPC/Hyper-V signature detected on core %u", i);
+                        found = true;
+                    }
+                }
 
-        constexpr ACCESS_MASK desired_access = FILE_READ_ATTRIBUTES; 
-        constexpr ULONG share_access = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
-        constexpr ULONG open_options = FILE_OPEN | FILE_SYNCHRONOUS_IO_NONALERT | FILE_DIRECTORY_FILE;
+            if (found) break;
+        }
 
-        const NTSTATUS st = nt_open_file(&hFile, desired_access, &object_attributes, &iosb, share_access, open_options);
-        if (NT_SUCCESS(st)) {
-            if (hFile) nt_close(hFile);
-            return core::add(brand_enum::CUCKOO);
+        if (original_mask != 0) {
+            SetThreadAffinityMask(current_thread, original_mask);
         }
 
-        return false;
-    }
-                
-                
-    /**
-     * @brief Check for Cuckoo specific piping mechanism
-     * @category Windows
-     * @author Thomas Roccia (fr0gger)
-     * @link https://unprotect.it/snippet/checking-specific-folder-name/196/
-     * @implements VM::CUCKOO_PIPE
-     */
-    [[nodiscard]] static bool cuckoo_pipe() {
-        using NtOpenFile_t = NTSTATUS(__stdcall*)(PHANDLE FileHandle, ACCESS_MASK DesiredAccess,
-            POBJECT_ATTRIBUTES ObjectAttributes, PIO_STATUS_BLOCK IoStatusBlock,
-            ULONG ShareAccess, ULONG OpenOptions);
-        using RtlInitUnicodeString_t = void(__stdcall*)(PUNICODE_STRING DestinationString, PCWSTR SourceString);
-        using NtClose_t = NTSTATUS(__stdcall*)(HANDLE Handle);
+        // Technique 4: SMSW (x86_32 only), no affinity pinning needed
+        #if (x86_32)
+            if (!found) {
+                u32 reax = 0;
+                __asm
+                {
+                    mov eax, 0xCCCCCCCC;
+                    smsw eax;
+                    mov DWORD PTR[reax], eax;
+                }
 
-        const HMODULE ntdll = util::get_ntdll();
-        if (!ntdll) return false;
+                if ((((reax >> 24) & 0xFF) == 0xCC) && (((reax >> 16) & 0xFF) == 0xCC)) {
+                    debug("SMSW: Signature detected");
+                    found = true;
+                }
+            }
+        #endif
+    #endif
 
-        const char* names[] = { "NtOpenFile", "RtlInitUnicodeString", "NtClose" };
-        void* funcs[ARRAYSIZE(names)] = {};
-        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+        return found;
+    }
 
-        const auto nt_open_file = reinterpret_cast<NtOpenFile_t>(funcs[0]);
-        const auto rtl_init_unicode_string = reinterpret_cast<RtlInitUnicodeString_t>(funcs[1]);
-        const auto nt_close = reinterpret_cast<NtClose_t>(funcs[2]);
 
-        if (!nt_open_file || !rtl_init_unicode_string || !nt_close) {
-            return false;
-        }
+    /**
+     * @brief Check for default Azure hostname format (Azure uses Hyper-V as their base VM brand)
+     * @category Windows, Linux
+     * @implements VM::AZURE
+     */
+    [[nodiscard]] static bool azure() noexcept {
+        // Returns 1u if alphanumeric, 0u if not. Here we use unsigned integers
+        // instead of booleans because MSVC's IntelliSense is stupid and avoids warnings 
+        // about bitwise operations on boolean types
+        auto is_alnum_ascii = [](char c) noexcept -> unsigned int {
+            const auto l = static_cast<unsigned char>(c | 0x20);
+            const auto d = static_cast<unsigned char>(c);
 
-        const wchar_t* pipe_path = L"\\??\\pipe\\cuckoo";
-        UNICODE_STRING pipe;
-        rtl_init_unicode_string(&pipe, pipe_path);
+            const unsigned int is_letter = (static_cast<unsigned char>(l - 'a') < 26) ? 1u : 0u;
+            const unsigned int is_digit = (static_cast<unsigned char>(d - '0') < 10) ? 1u : 0u;
 
-        OBJECT_ATTRIBUTES object_attributes;
-        ZeroMemory(&object_attributes, sizeof(object_attributes));
-        object_attributes.Length = sizeof(object_attributes);
-        object_attributes.ObjectName = &pipe;
-        object_attributes.Attributes = OBJ_CASE_INSENSITIVE;
+            return is_letter | is_digit;
+        };
 
-        IO_STATUS_BLOCK iosb;
-        HANDLE h_pipe = nullptr;
+    #if (WINDOWS)
+        char buf[MAX_COMPUTERNAME_LENGTH + 1];
+        DWORD len = sizeof(buf);
 
-        constexpr ACCESS_MASK desired_access = FILE_READ_DATA | FILE_READ_ATTRIBUTES;
-        constexpr ULONG share_access = 0;
-        constexpr ULONG open_options = FILE_OPEN | FILE_SYNCHRONOUS_IO_NONALERT;
+        if (!GetComputerNameA(buf, &len) || len != 13) {
+            return false;
+        }
+    #elif (LINUX)
+        // 16 bytes fits 13-char hostname and the null-terminator
+        char buf[16] = { 0 };
 
-        const NTSTATUS st = nt_open_file(&h_pipe, desired_access, &object_attributes, &iosb, share_access, open_options);
-        if (NT_SUCCESS(st)) {
-            if (h_pipe) nt_close(h_pipe);
-            return core::add(brand_enum::CUCKOO);
+        if (gethostname(buf, sizeof(buf)) != 0) {
+            return false;
         }
 
+        if (buf[13] != '\0') {
+            return false;
+        }
+    #else
         return false;
-    }
-
+    #endif
 
-    /**
-     * @brief Check for display configurations commonly found in VMs
-     * @category Windows
-     * @implements VM::DISPLAY
-     */
-    [[nodiscard]] static bool display() {
-        const HDC hdc = GetDC(nullptr);
-        const int bpp = GetDeviceCaps(hdc, BITSPIXEL) *
-            GetDeviceCaps(hdc, PLANES);
-        const int logpix = GetDeviceCaps(hdc, LOGPIXELSX);
-        ReleaseDC(nullptr, hdc);
+        if (std::memcmp(buf, "runnervm", 8) != 0) {
+            return false;
+        }
 
-        // physical monitors are almost always 32bpp and 96–144 DPI
-        if (bpp != 32 || logpix < 90)
-            return true;
+        const unsigned int is_match = is_alnum_ascii(buf[8]) &
+            is_alnum_ascii(buf[9]) &
+            is_alnum_ascii(buf[10]) &
+            is_alnum_ascii(buf[11]) &
+            is_alnum_ascii(buf[12]);
 
+        if (is_match != 0u) {
+            return core::add(brand_enum::AZURE_HYPERV);
+        }
         return false;
     }
 
 
     /**
-     * @brief Check for VM-specific names for drivers
-     * @category Windows
-     * @implements VM::DRIVERS
+     * @brief Check for VM signatures on all firmware tables
+     * @category Windows, Linux
+     * @authors Requiem, dmfrpro, MegaMax
+     * @warning Permissions required
+     * @implements VM::FIRMWARE
      */
-    [[nodiscard]] static bool drivers() {
-        struct _SYSTEM_MODULE_INFORMATION {
-            PVOID  Reserved[2];
-            PVOID  ImageBaseAddress;
-            ULONG  ImageSize;
-            ULONG  Flags;
-            USHORT Index;
-            USHORT NameLength;
-            USHORT LoadCount;
-            USHORT PathLength;
-            CHAR   ImageName[256];
+    [[nodiscard]] static bool firmware() {
+    #if (WINDOWS)
+        struct acpi_header {
+            char signature[4];
+            u32 length;
+            u8 revision;
         };
 
-        struct _SYSTEM_MODULE_INFORMATION_EX {
-            ULONG  NumberOfModules;
-            _SYSTEM_MODULE_INFORMATION Module[1];
+        struct fadt_table {
+            u32 signature;
+            u32 length;
+            u8 revision;
+            u8 checksum;
+            char oem_id[6];
+            char oem_table_id[8];
+            u32 oem_revision;
+            char asl_compiler_id[4];
+            u32 asl_compiler_revision;
+
+            u32 firmware_ctrl;
+            u32 dsdt;
+            u8 reserved1;
+            u8 preferred_pm_profile;
+            u16 sci_interrupt;
+            u32 smi_command_port;
+            u8 acpi_enable;
+            u8 acpi_disable;
+            u8 s4_bios_req;
+            u8 reserved2;
+            u32 pstate_control;
+            u32 pm1a_event_block;
+            u32 pm1b_event_block;
+            u32 pm1a_control_block;
+            u32 pm1b_control_block;
+            u32 pm2_control_block;
+            u32 pm_timer_block;
+            u32 gpe0_block;
+            u32 gpe1_block;
+            u8 pm1_event_length;
+            u8 pm1_control_length;
+            u8 pm2_control_length;
+            u8 pm_timer_length;
+
+            u16 p_lvl2_lat;
+            u16 p_lvl3_lat;
         };
 
-        using SYSTEM_MODULE_INFORMATION = _SYSTEM_MODULE_INFORMATION;
-        using PSYSTEM_MODULE_INFORMATION = _SYSTEM_MODULE_INFORMATION*;
-        using SYSTEM_MODULE_INFORMATION_EX = _SYSTEM_MODULE_INFORMATION_EX;
-        using PSYSTEM_MODULE_INFORMATION_EX = _SYSTEM_MODULE_INFORMATION_EX*;
+        // "WAET" is also present as a string inside the WAET table, so there's no need to check for its table signature
+        constexpr std::array<const char*, 21> targets = { {
+            "Parallels Software", "Parallels(R)",
+            "innotek",            "Oracle",   "VirtualBox", "vbox", "VBOX",
+            "VMware, Inc.",       "VMware",   "VMWARE",     "VMW0003",
+            "QEMU",               "pc-q35",   "Q35 +",      "BOCHS",
+            "ovmf",               "edk ii unknown", "WAET", "S3 Corp.", "VS2005R2",
+            "Xen"
+        } };
 
-        using NtQuerySystemInformationFn = NTSTATUS(__stdcall*)(ULONG SystemInformationClass, PVOID SystemInformation, ULONG SystemInformationLength, PULONG ReturnLength);
-        using NtAllocateVirtualMemoryFn = NTSTATUS(__stdcall*)(
-            HANDLE ProcessHandle,
-            PVOID* BaseAddress,
-            ULONG_PTR ZeroBits,
-            PSIZE_T RegionSize,
-            ULONG AllocationType,
-            ULONG Protect
-        );
-        using NtFreeVirtualMemoryFn = NTSTATUS(__stdcall*)(HANDLE ProcessHandle, PVOID* BaseAddress, PSIZE_T RegionSize, ULONG FreeType);
+        constexpr std::array<brand_enum, 21> brands_map = { {
+            brand_enum::PARALLELS,  brand_enum::PARALLELS,
+            brand_enum::VBOX,       brand_enum::VBOX,       brand_enum::VBOX,       brand_enum::VBOX,       brand_enum::VBOX,
+            brand_enum::VMWARE,     brand_enum::VMWARE,     brand_enum::VMWARE,     brand_enum::VMWARE,
+            brand_enum::QEMU,       brand_enum::QEMU,       brand_enum::QEMU,       brand_enum::BOCHS,
+            brand_enum::NULL_BRAND, brand_enum::NULL_BRAND, brand_enum::NULL_BRAND, brand_enum::NULL_BRAND, brand_enum::NULL_BRAND,
+            brand_enum::XEN
+        } };
 
-        constexpr ULONG system_module_information = 11;
-        const HMODULE ntdll = util::get_ntdll();
-        if (!ntdll) return false;
+        // inside struct to not have to move out of function, constexpr this way because of c++ 11 compatibility
+        struct array_validator {
+            static constexpr bool verify_no_nulls(const std::array<const char*, 21>& arr, size_t i) {
+                return (i == arr.size())
+                    ? true
+                    : (arr[i] != nullptr && verify_no_nulls(arr, i + 1));
+            }
+        };
 
-        const char* names[] = { "NtQuerySystemInformation", "NtAllocateVirtualMemory", "NtFreeVirtualMemory" };
-        void* funcs[ARRAYSIZE(names)] = {};
-        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+        // ensure sizes match
+        static_assert(targets.size() == brands_map.size(),
+            "FIRMWARE: 'targets' and 'brands_map' must have the same size.");
 
-        const auto nt_query_system_information = reinterpret_cast<NtQuerySystemInformationFn>(funcs[0]);
-        const auto nt_allocate_virtual_memory = reinterpret_cast<NtAllocateVirtualMemoryFn>(funcs[1]);
-        const auto nt_free_virtual_memory = reinterpret_cast<NtFreeVirtualMemoryFn>(funcs[2]);
+        // detects if you increased size but forgot strings
+        static_assert(array_validator::verify_no_nulls(targets, 0),
+            "FIRMWARE: 'targets' array contains NULLs. Array size declared is larger than the number of strings provided.");
 
-        if (nt_query_system_information == nullptr || nt_allocate_virtual_memory == nullptr || nt_free_virtual_memory == nullptr)
-            return false;
-        
-        ULONG ul_size = 0;
-        NTSTATUS status = nt_query_system_information(system_module_information, nullptr, 0, &ul_size);
-        if (status != ((NTSTATUS)0xC0000004L)) return false;
+        // every table is scanned once for all targets together, plus PXEN for the Xen check below
+        static const util::pattern_matcher matcher = [&]() {
+            std::vector<const char*> patterns(targets.begin(), targets.end());
+            patterns.push_back("PXEN");
+            return util::pattern_matcher(patterns.data(), patterns.size());
+        }();
 
-        const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
-        PVOID allocated_memory = nullptr;
-        SIZE_T region_size = ul_size;
-        nt_allocate_virtual_memory(current_process, &allocated_memory, 0, &region_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        constexpr u64 pxen_bit = (1ULL << targets.size());
 
-        const auto system_module_info_ex = reinterpret_cast<PSYSTEM_MODULE_INFORMATION_EX>(allocated_memory);
-        status = nt_query_system_information(system_module_information, system_module_info_ex, ul_size, &ul_size);
-        if (!(((NTSTATUS)(status)) >= 0)) {
-            region_size = 0;
-            nt_free_virtual_memory(current_process, &allocated_memory, &region_size, MEM_RELEASE);
-            return false;
-        }
+        auto scan_buffer = [&](const u8* buffer, const size_t buffer_len) noexcept -> bool {
+            const u64 found = matcher.scan(buffer, buffer_len);
 
-        for (ULONG i = 0; i < system_module_info_ex->NumberOfModules; ++i) {
-            const char* driverPath = reinterpret_cast<const char*>(system_module_info_ex->Module[i].ImageName);
-            if (
-                strstr(driverPath, "VBoxGuest") || // only installed after vbox guest additions
-                strstr(driverPath, "VBoxMouse") ||
-                strstr(driverPath, "VBoxSF")
-            ) {
-                debug("DRIVERS: Detected VBox driver: ", driverPath);
-                region_size = 0;
-                nt_free_virtual_memory(current_process, &allocated_memory, &region_size, MEM_RELEASE);
-                return core::add(brand_enum::VBOX);
-            }
-
-            if (
-                strstr(driverPath, "vmusbmouse") ||
-                strstr(driverPath, "vmmouse") ||
-                strstr(driverPath, "vmmemctl")
-            ) {
-                debug("DRIVERS: Detected VMware driver: ", driverPath);
-                region_size = 0;
-                nt_free_virtual_memory(current_process, &allocated_memory, &region_size, MEM_RELEASE);
-                return core::add(brand_enum::VMWARE);
-            }
-        }
+            // 1) VM-specific firmware signatures. It is important that vm-specific checks run first because of the hardened detection logic
+            for (size_t i = 0; i < targets.size(); ++i) {
+                if ((found & (1ULL << i)) == 0) {
+                    continue;
+                }
 
-        SIZE_T free_size = 0;
-        nt_free_virtual_memory(current_process, &allocated_memory, &free_size, MEM_RELEASE);
-        return false;
-    }
+                // special handling for Xen: must not have PXEN to prevent false flagging some baremetal systems
+                if (brands_map[i] == brand_enum::XEN) {
+                    if ((found & pxen_bit) != 0) {
+                        continue;
+                    }
 
+                    return core::add(brand_enum::XEN);
+                }
 
+                debug("FIRMWARE: Detected ", targets[i]);
+                return core::add(brands_map[i]);
+            }
 
-    /**
-     * @brief Check for IVSHMEM device presence
-     * @category Windows
-     * @author dmfrpro (https://github.com/dmfrpro)
-     * @implements VM::IVSHMEM
-     */
-    [[nodiscard]] static bool ivshmem() {
-        typedef struct _KEY_FULL_INFORMATION {
-            LARGE_INTEGER LastWriteTime;
-            ULONG         TitleIndex;
-            ULONG         ClassOffset;
-            ULONG         ClassLength;
-            ULONG         SubKeys;
-            ULONG         MaxNameLen;
-            ULONG         MaxClassLen;
-            ULONG         Values;
-            ULONG         MaxValueNameLen;
-            ULONG         MaxValueDataLen;
-            WCHAR         Class[1];
-        } KEY_FULL_INFORMATION, * PKEY_FULL_INFORMATION;
+            // 2) known patches used by popular hardeners 
+            {
+                constexpr char marker[] = "777777";
 
-        typedef enum _KEY_INFORMATION_CLASS {
-            KeyBasicInformation,
-            KeyNodeInformation,
-            KeyFullInformation,
-            KeyNameInformation,
-            KeyCachedInformation,
-            KeyFlagsInformation,
-            KeyVirtualizationInformation,
-            KeyHandleTagsInformation,
-            KeyTrustInformation,
-            KeyLayerInformation,
-            MaxKeyInfoClass
-        } KEY_INFORMATION_CLASS;
+                if (buffer_len >= 36) {
+                    // OEMID (6)
+                    char oem_id[7] = { 0 };
+                    memcpy(oem_id, buffer + 10, 6);
+                    // OEM Table ID (8)
+                    char oem_table_id[9] = { 0 };
+                    memcpy(oem_table_id, buffer + 16, 8);
 
-        const HMODULE ntdll = util::get_ntdll();
-        if (!ntdll) return false;
+                    // Creator / ASL Compiler ID (4) won't contain 6-char marker because its length is 4
+                    if (strstr(oem_id, marker) != nullptr) {
+                        debug("FIRMWARE: VMWareHardenedLoader found in OEMID -> '", oem_id, "'");
+                        return core::add(brand_enum::VMWARE_HARD);
+                    }
+                    if (strstr(oem_table_id, marker) != nullptr) {
+                        debug("FIRMWARE: VMWareHardenedLoader found in OEM Table ID -> '", oem_table_id, "'");
+                        return core::add(brand_enum::VMWARE_HARD);
+                    }
+                }
+            }
 
-        const char* names[] = { "RtlInitUnicodeString", "NtOpenKey", "NtQueryKey", "NtClose" };
-        void* funcs[ARRAYSIZE(names)] = {};
-        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+            if (!buffer || buffer_len < sizeof(acpi_header)) {
+                return false;
+            }
 
-        const auto rtl_init_unicode_string = reinterpret_cast<void(__stdcall*)(PUNICODE_STRING, PCWSTR)>(funcs[0]);
-        const auto nt_open_key = reinterpret_cast<NTSTATUS(__stdcall*)(PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES)>(funcs[1]);
-        const auto nt_query_key = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, KEY_INFORMATION_CLASS, PVOID, ULONG, PULONG)>(funcs[2]);
-        const auto nt_close = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE)>(funcs[3]);
+            acpi_header header;
+            memcpy(&header, buffer, sizeof(header));
 
-        if (!rtl_init_unicode_string || !nt_open_key || !nt_query_key || !nt_close) {
-            return false;
-        }
+            // 3) FADT specific checks
+            if (memcmp(header.signature, "FACP", 4) == 0) {
+                if (header.length > buffer_len) {
+                    debug("FIRMWARE: declared header length larger than fetched length (declared ", header.length, ", fetched ", buffer_len, ")");
+                    return true;
+                }
+                if (buffer_len < sizeof(fadt_table)) {
+                    debug("FIRMWARE: FACP buffer too small (len ", buffer_len, ")");
+                    return true;
+                }
 
-        // Targeted GUID for IVSHMEM (Inter-VM Shared Memory).
-        // This device is typically used in KVM/QEMU environments (like Looking Glass) to pass memory between host and guest
-        constexpr GUID GUID_IVSHMEM_IFACE =
-        { 0xdf576976, 0x569d, 0x4672, { 0x95, 0xa0, 0xf5, 0x7e, 0x4e, 0xa0, 0xb2, 0x10 } };
+                fadt_table fadt;
+                memcpy(&fadt, buffer, sizeof(fadt_table));
 
-        // Construct the registry path for the DeviceClasses key
-        // We access the "DeviceClasses" registry hive directly to find hardware interfaces
-        wchar_t interface_class_path[256];
-        swprintf_s(
-            interface_class_path,
-            ARRAYSIZE(interface_class_path),
-            L"\\Registry\\Machine\\SYSTEM\\CurrentControlSet\\Control\\DeviceClasses\\{%08lX-%04hX-%04hX-%02hhX%02hhX-%02hhX%02hhX%02hhX%02hhX%02hhX%02hhX}",
-            GUID_IVSHMEM_IFACE.Data1, GUID_IVSHMEM_IFACE.Data2, GUID_IVSHMEM_IFACE.Data3,
-            GUID_IVSHMEM_IFACE.Data4[0], GUID_IVSHMEM_IFACE.Data4[1], GUID_IVSHMEM_IFACE.Data4[2],
-            GUID_IVSHMEM_IFACE.Data4[3], GUID_IVSHMEM_IFACE.Data4[4], GUID_IVSHMEM_IFACE.Data4[5],
-            GUID_IVSHMEM_IFACE.Data4[6], GUID_IVSHMEM_IFACE.Data4[7]
-        );
+                if (fadt.p_lvl2_lat == 0x0FFF || fadt.p_lvl3_lat == 0x0FFF) { // A value > 100 indicates the system does not support a C2/C3 state
+                    debug("FIRMWARE: C2 and C3 latencies indicate VM");
+                    return true;
+                }
+            }
 
-        UNICODE_STRING unicode_path;
-        rtl_init_unicode_string(&unicode_path, interface_class_path);
+            return false;
+        };
 
-        OBJECT_ATTRIBUTES object_attributes;
-        RtlZeroMemory(&object_attributes, sizeof(object_attributes));
-        object_attributes.Length = sizeof(object_attributes);
-        object_attributes.ObjectName = &unicode_path;
-        object_attributes.Attributes = OBJ_CASE_INSENSITIVE;
+        // to minimize heap allocations
+        std::vector<u8> work_buffer;
+        work_buffer.reserve(65536);
 
-        HANDLE key = nullptr;
-        NTSTATUS st = nt_open_key(&key, KEY_READ, &object_attributes);
-        if (!NT_SUCCESS(st) || key == nullptr) {
+        // Enumerate ACPI tables
+        constexpr DWORD acpi_signature = 'ACPI';
+        const DWORD acpi_enum_size = EnumSystemFirmwareTables(acpi_signature, nullptr, 0);
+        if (acpi_enum_size == 0) 
+            return false;
+        if (acpi_enum_size % sizeof(DWORD) != 0) 
+            return false;
+       
+        const size_t table_count = acpi_enum_size / sizeof(DWORD);
+        std::vector<DWORD> tables(table_count);
+        if (EnumSystemFirmwareTables(acpi_signature, tables.data(), acpi_enum_size) != acpi_enum_size)
             return false;
-        }
 
-        // We query the "Full Information" of the key to get the count of subkeys
-        // The existence of the class key alone isn't enough cuz Windows might register the class but have no devices
-        // If SubKeys > 0, it means actual device instances (for ex. PCI devices) are registered under this interface
-        BYTE info_buffer[512] = {};
-        ULONG returned_len = 0;
-        st = nt_query_key(key, KeyFullInformation, info_buffer, sizeof(info_buffer), &returned_len);
+        // DSDT special fetch
+        {
+            constexpr DWORD dsdt_sig = 'DSDT';
+            constexpr DWORD dsdt_swapped =
+                ((dsdt_sig >> 24) & 0x000000FFu)
+                | ((dsdt_sig >> 8) & 0x0000FF00u)
+                | ((dsdt_sig << 8) & 0x00FF0000u)
+                | ((dsdt_sig << 24) & 0xFF000000u);
 
-        DWORD number_of_subkeys = 0;
-        if (NT_SUCCESS(st) && returned_len >= sizeof(KEY_FULL_INFORMATION)) {
-            auto* kfi = reinterpret_cast<KEY_FULL_INFORMATION*>(info_buffer);
-            number_of_subkeys = static_cast<DWORD>(kfi->SubKeys);
-        }
-        else {
-            nt_close(key);
-            return false;
+            const UINT sz = GetSystemFirmwareTable(acpi_signature, dsdt_swapped, nullptr, 0);
+            if (sz > 0) {
+                if (sz > work_buffer.capacity()) work_buffer.reserve(sz);
+                work_buffer.resize(sz);
+                if (GetSystemFirmwareTable(acpi_signature, dsdt_swapped, work_buffer.data(), sz) == sz) {
+                    if (scan_buffer(work_buffer.data(), work_buffer.size())) {
+                        return true;
+                    }
+                }
+            }
         }
 
-        nt_close(key);
+        // helper to fetch one table into a malloc'd buffer
+        auto fetch_and_scan = [&](DWORD provider, DWORD table_id) noexcept -> bool {
+            const DWORD sz = GetSystemFirmwareTable(provider, table_id, nullptr, 0);
+            if (sz == 0) return false;
 
-        return number_of_subkeys > 0;
-    }
+            if (sz > work_buffer.capacity()) work_buffer.reserve(sz);
+            work_buffer.resize(sz);
 
+            if (GetSystemFirmwareTable(provider, table_id, work_buffer.data(), sz) != sz) {
+                return false;
+            }
 
-    /**
-     * @brief Check for GPU capabilities related to VMs
-     * @category Windows
-     * @implements VM::GPU_CAPABILITIES
-     */
-    [[nodiscard]] static bool gpu_capabilities() {
-        /*
-            Microsoft::WRL::ComPtr<IDirect3D9> d3d9 {
-                Direct3DCreate9(D3D_SDK_VERSION)
-            };
+            return scan_buffer(work_buffer.data(), sz);
+        };
 
-            if (!d3d9) {
-                debug("GPU_CAPABILITIES: Direct3DCreate9 failed");
+        // Scan every ACPI table, dont make explicit whitelisting/blacklisting because of possible bypasses
+        for (const auto table_id : tables) {
+            if (fetch_and_scan(acpi_signature, table_id)) {
                 return true;
             }
+        }
 
-            D3DCAPS9 caps;
-            if (FAILED(d3d9->GetDeviceCaps(D3DADAPTER_DEFAULT, D3DDEVTYPE_HAL, &caps))) {
-                debug("GPU_CAPABILITIES: GetDeviceCaps failed");
-                return false;
-            }
-
-            // if the driver cannot adjust the display gamma ramp dynamically but only in full-screen mode—via the IDirect3DDevice9::SetGammaRamp API
-            return !(caps.Caps2 & D3DCAPS2_FULLSCREENGAMMA);
-        */
+        // Scan SMBIOS (RSMB) / FIRM tables
+        constexpr DWORD smb_providers[] = { 'FIRM', 'RSMB' };
 
-        const HDC hdc = GetDC(nullptr);
-        if (!hdc) {
-            return true;
-        }
+        for (DWORD prov : smb_providers) {
+            const UINT e = EnumSystemFirmwareTables(prov, nullptr, 0);
+            if (!e) continue;
 
-        const int color_caps = GetDeviceCaps(hdc, COLORMGMTCAPS);
-        ReleaseDC(nullptr, hdc);
+            // even if alignment is supported on x86 its good to check if size is a multiple of DWORD
+            if (e % sizeof(DWORD) != 0) continue;
 
-        return !(color_caps & CM_GAMMA_RAMP) || color_caps == 0;
-    }
+            const size_t cnt = e / sizeof(DWORD);
+            std::vector<DWORD> provider_tables(cnt);
 
+            if (EnumSystemFirmwareTables(prov, provider_tables.data(), e) != e) continue;
 
-    /**
-     * @brief Check for vm-specific devices
-     * @category Windows
-     * @implements VM::HANDLES
-     */
-    [[nodiscard]] static bool device_handles() {
-        const HMODULE ntdll = util::get_ntdll();
-        if (!ntdll) return false;
-
-        const char* names[] = { "RtlInitUnicodeString", "NtOpenFile", "NtClose" };
-        void* funcs[ARRAYSIZE(names)] = {};
-        util::get_function_address(ntdll, names, funcs, (ULONG)(sizeof(names) / sizeof(names[0])));
+            for (const auto table_id : provider_tables) {
+                if (fetch_and_scan(prov, table_id)) {
+                    return true;
+                }
+            }
+        }
 
-        const auto rtl_init_unicode_string = reinterpret_cast<void(__stdcall*)(PUNICODE_STRING, PCWSTR)>(funcs[0]);
-        const auto nt_open_file = reinterpret_cast<NTSTATUS(__stdcall*)(PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES, PIO_STATUS_BLOCK, ULONG, ULONG)>(funcs[1]);
-        const auto nt_close = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE)>(funcs[2]);
+        return false;
+    #elif (LINUX)
+        // Author: dmfrpro
+        const util::acpi_table_index& acpi = util::acpi_tables();
 
-        if (!rtl_init_unicode_string || !nt_open_file || !nt_close) {
+        if (acpi.tables.empty()) {
             return false;
         }
 
-        auto try_open_mutex = [&](const wchar_t* native_path) noexcept -> HANDLE {
-            UNICODE_STRING u_path{};
-            u_path.Buffer = const_cast<wchar_t*>(native_path);
-            const size_t len_bytes = wcslen(native_path) * sizeof(wchar_t);
-            u_path.Length = static_cast<USHORT>(len_bytes);
-            u_path.MaximumLength = static_cast<USHORT>(len_bytes + sizeof(wchar_t));
-
-            OBJECT_ATTRIBUTES obj_attr = {
-                sizeof(OBJECT_ATTRIBUTES),
-                nullptr,
-                &u_path,
-                OBJ_CASE_INSENSITIVE,
-                nullptr,
-                nullptr
-            };
+        const std::vector<std::pair<const char*, brand_enum>>& targets = util::firmware_targets();
 
-            IO_STATUS_BLOCK iosb;
-            HANDLE h_file = nullptr;
+        // every table is scanned once for all targets together
+        static const util::pattern_matcher matcher = [&targets]() {
+            std::vector<const char*> names;
 
-            constexpr ACCESS_MASK desired_access = FILE_READ_DATA | FILE_READ_ATTRIBUTES | SYNCHRONIZE;
-            constexpr ULONG share_access = FILE_SHARE_READ;
-            constexpr ULONG open_options = FILE_OPEN | FILE_SYNCHRONOUS_IO_NONALERT;
+            for (const auto& target : targets) {
+                names.push_back(target.first);
+            }
 
-            const NTSTATUS st = nt_open_file(&h_file, desired_access, &obj_attr, &iosb, share_access, open_options);
+            return util::pattern_matcher(names.data(), names.size());
+        }();
 
-            if (NT_SUCCESS(st)) {
-                return h_file;
-            }
-            return INVALID_HANDLE_VALUE;
+        // tables with a fixed binary layout have no strings past the header, so their body isn't worth reading.
+        // Anything else, like the AML of the DSDT and SSDTs, is scanned whole
+        constexpr const char* header_only[] = {
+            "APIC", "FACP", "FACS", "MCFG", "HPET", "SRAT", "SLIT", "WAET", "BGRT", "FPDT", "WSMT", "DMAR", "SBST", "MSCT"
         };
 
-        constexpr const wchar_t* paths[] = {
-            L"\\??\\VBoxMiniRdrDN",    // \\.\VBoxMiniRdrDN
-            L"\\??\\pipe\\VBoxMiniRdDN",// \\.\pipe\VBoxMiniRdDN
-            L"\\??\\VBoxTrayIPC",      // \\.\VBoxTrayIPC
-            L"\\??\\pipe\\VBoxTrayIPC",// \\.\pipe\VBoxTrayIPC
-            L"\\??\\HGFS",             // \\.\HGFS (VMware)
-            L"\\??\\pipe\\cuckoo"      // \\.\pipe\cuckoo (Cuckoo)
-        };
+        constexpr size_t MAX_TABLE_SIZE = 8 * 1024 * 1024;
 
-        const size_t path_count = sizeof(paths) / sizeof(paths[0]);
-        HANDLE handles[sizeof(paths) / sizeof(paths[0])] = {};
+        // only the table being scanned is held in memory, the result of the whole technique is cached anyway
+        std::vector<u8> body;
 
-        for (size_t i = 0; i < path_count; ++i) {
-            handles[i] = try_open_mutex(paths[i]);
-        }
+        for (const auto& table : acpi.tables) {
+            const std::string signature = table.signature();
+            const bool whole = std::none_of(std::begin(header_only), std::end(header_only), [&](const char* known) { return (signature == known); });
 
-        const bool vbox = (handles[0] != INVALID_HANDLE_VALUE) ||
-            (handles[1] != INVALID_HANDLE_VALUE) ||
-            (handles[2] != INVALID_HANDLE_VALUE) ||
-            (handles[3] != INVALID_HANDLE_VALUE);
+            const u8* data = table.header.data();
+            size_t size = table.header_size;
 
-        const bool vmware = (handles[4] != INVALID_HANDLE_VALUE);
-        const bool cuckoo = (handles[5] != INVALID_HANDLE_VALUE);
+            if (whole) {
+                if (table.length > MAX_TABLE_SIZE) {
+                    debug("FIRMWARE: table too large, skipping ", table.name);
+                    continue;
+                }
 
-        for (size_t i = 0; i < path_count; ++i) {
-            if (handles[i] != INVALID_HANDLE_VALUE) {
-                (void)nt_close(handles[i]);
-                handles[i] = INVALID_HANDLE_VALUE;
-            }
-        }
+                body = table.body();
 
-        if (vbox) {
-            debug("HANDLES: Detected VBox related device handles");
-            return core::add(brand_enum::VBOX);
-        }
+                if (body.empty()) {
+                    debug("FIRMWARE: file empty or error ", table.name);
+                    continue;
+                }
 
-        if (vmware) {
-            debug("HANDLES: Detected VMware related device (HGFS)");
-            return core::add(brand_enum::VMWARE);
-        }
+                data = body.data();
+                size = body.size();
+            }
 
-        if (cuckoo) {
-            debug("HANDLES: Detected Cuckoo related device (pipe)");
-            return core::add(brand_enum::CUCKOO);
-        }
+            const u64 found = matcher.scan(data, size);
 
-        return false;
-    }
+            for (size_t i = 0; i < targets.size(); ++i) {
+                if ((found & (1ULL << i)) == 0) {
+                    continue;
+                }
 
+                debug("FIRMWARE: Detected ", targets[i].first, " in ", table.name);
 
-    /**
-     * @brief Check if the number of virtual and logical processors are reported correctly by the system
-     * @category Windows, x86
-     * @implements VM::VIRTUAL_PROCESSORS
-     */
-    [[nodiscard]] static bool virtual_processors() {
-    #if (x86)
-        int regs[4];
-        __cpuid(regs, 0x40000000);
+                if (targets[i].second != brand_enum::NULL_BRAND) {
+                    return core::add(targets[i].second);
+                }
 
-        const u32 max_leaf = static_cast<u32>(regs[0]);
-        if (max_leaf < 0x40000005) {
-            return false;
+                return true;
+            }
         }
 
-        __cpuid(regs, 0x40000005);
-        const u32 max_virtual_processors = static_cast<u32>(regs[0]);
-        const u32 max_logical_processors = static_cast<u32>(regs[1]);
-
-        debug("VIRTUAL_PROCESSORS: MaxVirtualProcessors -> ", max_virtual_processors,
-            ", MaxLogicalProcessors -> ", max_logical_processors);
-
-        if (max_virtual_processors == 0xFFFFFFFF || max_logical_processors == 0) {
-            return true;
-        }
-    #endif
         return false;
+    #endif
     }
 
 
     /**
-     * @brief Check if a call to NtQuerySystemInformation with the 0x9f leaf fills a _SYSTEM_HYPERVISOR_DETAIL_INFORMATION structure
-     * @category Windows, x86_64
-     * @implements VM::HYPERVISOR_QUERY
+     * @brief Check for PCI vendor and device IDs that are VM-specific
+     * @link https://www.pcilookup.com/?ven=&dev=&action=submit
+     * @category Linux, Windows
+     * @implements VM::DEVICES
      */
-    [[nodiscard]] static bool hypervisor_query() {
-    #if (x86_64)
-        if (util::hyper_x() == HYPERV_ARTIFACT_VM) {
-            return false;
-        }
+    [[nodiscard]] static bool pci_devices() {
+        struct pci_device { u16 vendor_id; u32 device_id; };
+        std::vector<pci_device> devices;
 
-        struct HV_DETAILS {
-            ULONG Data[4];
-        };
-        struct SYSTEM_HYPERVISOR_DETAIL_INFORMATION {
-            HV_DETAILS HvVendorAndMaxFunction;
-            HV_DETAILS HypervisorInterface;
-            HV_DETAILS HypervisorVersion;
-            HV_DETAILS HvFeatures;
-            HV_DETAILS HwFeatures;
-            HV_DETAILS EnlightenmentInfo;
-            HV_DETAILS ImplementationLimits;
+        #if (LINUX)
+         const std::string pci_path = "/sys/bus/pci/devices";
+
+         DIR* dir = opendir(pci_path.c_str());
+
+         if (dir != nullptr) {
+             // every device is opened relative to the directory, so the path isn't walked again each time
+             const int dir_fd = dirfd(dir);
+             std::string relative_path;
+
+             // the attributes read ahead by VM::PREFETCH, if there are any
+             auto read_prefetched = [&](const std::string& name, u32& vendor, u32& device) -> bool {
+                 const std::string* vendor_text = util::prefetched(pci_path + "/" + name + "/vendor");
+                 const std::string* device_text = util::prefetched(pci_path + "/" + name + "/device");
+
+                 if ((vendor_text == nullptr) || (device_text == nullptr) || vendor_text->empty() || device_text->empty()) {
+                     return false;
+                 }
+
+                 vendor = static_cast<u32>(std::strtoul(vendor_text->c_str(), nullptr, 16));
+                 device = static_cast<u32>(std::strtoul(device_text->c_str(), nullptr, 16));
+                 return true;
+             };
+
+             // short hex strings like "0x8086\n". The config space would hold both IDs in one file, but reading it
+             // goes to the device (a trap to the hypervisor in a VM), while these are kept by the kernel
+             auto read_attribute = [&](const std::string& name, const char* attribute, u32& value) -> bool {
+                 relative_path = name + "/" + attribute;
+                 const int fd = openat(dir_fd, relative_path.c_str(), O_RDONLY | O_CLOEXEC);
+
+                 if (fd < 0) {
+                     return false;
+                 }
+
+                 char text[32] = {};
+                 const ssize_t length = read(fd, text, sizeof(text) - 1);
+                 close(fd);
+
+                 value = static_cast<u32>(std::strtoul(text, nullptr, 16));
+                 return (length > 0);
+             };
+
+             while (const struct dirent* ent = readdir(dir)) {
+                 if (ent->d_name[0] == '.') {
+                     continue;
+                 }
+
+                 const std::string name = ent->d_name;
+                 u32 vendor = 0;
+                 u32 device = 0;
+
+                 const bool found = (
+                     read_prefetched(name, vendor, device) ||
+                     (read_attribute(name, "vendor", vendor) && read_attribute(name, "device", device))
+                 );
+
+                 if (found) {
+                     devices.push_back({ static_cast<u16>(vendor), device });
+                 }
+             }
+
+             closedir(dir);
+         }
+        #elif (WINDOWS)
+        static constexpr const wchar_t* kroots[] = {
+            L"SYSTEM\\CurrentControlSet\\Enum\\PCI",
+            L"SYSTEM\\CurrentControlSet\\Enum\\USB",
+            L"SYSTEM\\CurrentControlSet\\Enum\\HDAUDIO"
         };
 
-        using PHV_DETAILS = HV_DETAILS*;
-        using PSYSTEM_HYPERVISOR_DETAIL_INFORMATION = SYSTEM_HYPERVISOR_DETAIL_INFORMATION*;
+        enum root_type { RT_PCI, RT_USB, RT_HDAUDIO };
+        constexpr DWORD MAX_MULTI_SZ = 64 * 1024;
 
-        using FN_NtQuerySystemInformation = NTSTATUS(__stdcall*)(
-            SYSTEM_INFORMATION_CLASS SystemInformationClass,
-            PVOID SystemInformation,
-            ULONG SystemInformationLength,
-            PULONG ReturnLength
-        );
+        auto hex_val = [](wchar_t c) noexcept -> int {
+            if (c >= L'0' && c <= L'9') return c - L'0';
 
-        const HMODULE ntdll = util::get_ntdll();
-        if (!ntdll) return false;        
+            const wchar_t lower = static_cast<wchar_t>((static_cast<int>(c) | 0x20));
+            if (lower >= L'a' && lower <= L'f') return lower - L'a' + 10;
 
-        const char* names[] = { "NtQuerySystemInformation" };
-        void* funcs[ARRAYSIZE(names)] = {};
-        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+            return -1;
+        };
 
-        const FN_NtQuerySystemInformation nt_query_system_information = reinterpret_cast<FN_NtQuerySystemInformation>(funcs[0]);
-        if (nt_query_system_information) {
-            SYSTEM_HYPERVISOR_DETAIL_INFORMATION hypervisor_information{};
+        auto parse_hex = [&](const wchar_t* ptr, size_t maxDigits, size_t stopLen, unsigned long& out, size_t& consumed) noexcept -> bool {
+            out = 0;
+            consumed = 0;
 
-            // Request class 0x9F (SystemHypervisorDetailInformation)
-            // This asks the OS kernel to fill the structure with information about the 
-            // hypervisor layer it is running on top of
-            const NTSTATUS status = nt_query_system_information(static_cast<SYSTEM_INFORMATION_CLASS>(0x9F), &hypervisor_information, sizeof(hypervisor_information), nullptr);
+            const size_t limit = (stopLen < maxDigits) ? stopLen : maxDigits;
 
-            if (status != 0) {
-                return false;
-            }
+            for (; consumed < limit; ++consumed) {
+                const int v = hex_val(ptr[consumed]);
+                if (v < 0) break;
 
-            // If Data[0] is non-zero, it means the kernel has successfully communicated 
-            // with a hypervisor and retrieved a vendor signature like "Micr" for Microsoft
-            if (hypervisor_information.HvVendorAndMaxFunction.Data[0] != 0) {
-                return true;
+                // caller must ensure maxDigits doesn't exceed 8, because on Windows unsigned long is 32-bit
+                out = (out << 4) | static_cast<unsigned long>(v);
             }
-        }
-    #endif
-        return false;
-    }
 
-    
-    /**
-     * @brief Check for particular object directory which is present in Sandboxie virtual environment but not in usual host systems
-     * @category Windows
-     * @link https://evasions.checkpoint.com/src/Evasions/techniques/global-os-objects.html
-     * @implements VM::VIRTUAL_REGISTRY
-     */
-    [[nodiscard]] static bool virtual_registry() {
-        struct UNICODE_STRING {
-            USHORT Length;
-            USHORT MaximumLength;
-            PWSTR  Buffer;
-        };
-        struct OBJECT_ATTRIBUTES {
-            ULONG Length;
-            HANDLE RootDirectory;
-            UNICODE_STRING* ObjectName;
-            ULONG Attributes;
-            PVOID SecurityDescriptor;
-            PVOID SecurityQualityOfService;
-        };
-        enum OBJECT_INFORMATION_CLASS {
-            ObjectBasicInformation = 0,
-            ObjectNameInformation = 1,
-            ObjectTypeInformation = 2
+            return consumed > 0;
         };
-        struct OBJECT_NAME_INFORMATION {
-            UNICODE_STRING Name;
+
+        std::unordered_set<unsigned long long> seen;
+
+        auto add_device = [&](u16 vid, u32 did) noexcept {
+            const unsigned long long key = (static_cast<unsigned long long>(vid) << 32) | static_cast<unsigned long long>(did);
+            if (seen.insert(key).second) {
+                devices.push_back({ vid, did });
+            }
         };
 
-        using POBJECT_NAME_INFORMATION = OBJECT_NAME_INFORMATION*;
-        using PNtOpenKey = NTSTATUS(__stdcall*)(PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES );
-        using PNtQueryObject = NTSTATUS(__stdcall*)(HANDLE, OBJECT_INFORMATION_CLASS, PVOID, ULONG, PULONG);
-    
-        const HMODULE ntdll = util::get_ntdll();
-        if (!ntdll) return false;
-    
-        const char* names[] = { "NtOpenKey", "NtQueryObject", "NtClose" };
-        void* funcs[ARRAYSIZE(names)] = {};
-        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
-    
-        const auto nt_open_key = reinterpret_cast<PNtOpenKey>(funcs[0]);
-        const auto nt_query_object = reinterpret_cast<PNtQueryObject>(funcs[1]);
-        const auto nt_close = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE)>(funcs[2]);
+        auto scan_text_ids = [&](const wchar_t* text) noexcept {
+            if (!text) return;
 
-        if (!nt_open_key || !nt_query_object || !nt_close)
-            return false;
-    
-        // Prepare to open the root USER registry hive
-        UNICODE_STRING key_path{};
-        key_path.Buffer = const_cast<PWSTR>(L"\\REGISTRY\\USER");
-        key_path.Length = static_cast<USHORT>(wcslen(key_path.Buffer) * sizeof(WCHAR));
-        key_path.MaximumLength = key_path.Length + sizeof(WCHAR);
+            // USB: VID_ and then PID_
+            const wchar_t* p = text;
+            while ((p = wcsstr(p, L"VID_"))) {
+                const wchar_t* v = p;
+                p += 4;
+                const wchar_t* d = wcsstr(v + 4, L"PID_");
+                if (d && (d - v) < 64) {
+                    unsigned long parsed_v = 0, parsed_d = 0;
+                    size_t c_v = 0, c_d = 0;
+                    if (parse_hex(v + 4, 4, SIZE_MAX, parsed_v, c_v) &&
+                        parse_hex(d + 4, 8, SIZE_MAX, parsed_d, c_d)) {
+                        add_device(static_cast<u16>(parsed_v & 0xFFFFu), static_cast<u32>(parsed_d));
+                    }
+                }
+            }
 
-        OBJECT_ATTRIBUTES object_attributes = {
-            sizeof(OBJECT_ATTRIBUTES),
-            nullptr,
-            &key_path,
-            0x00000040L,  // OBJ_CASE_INSENSITIVE
-            nullptr,
-            nullptr
-        };
+            // PCI or HDAUDIO = VEN_ and then DEV_ after it
+            p = text;
+            while ((p = wcsstr(p, L"VEN_"))) {
+                const wchar_t* v = p;
+                p += 4;
+                const wchar_t* d = wcsstr(v + 4, L"DEV_");
 
-        // Attempt to open the key. If we are sandboxed, this open call often succeeds,
-        // but the underlying handle will point to a virtualized container, not the real OS path
-        HANDLE key = nullptr;
-        NTSTATUS status = nt_open_key(&key, KEY_READ, reinterpret_cast<POBJECT_ATTRIBUTES>(&object_attributes));
-        if (!(((NTSTATUS)(status)) >= 0))
-            return false;
+                if (!(d && (d - v) < 64)) {
+                    continue;
+                }
 
-        // Ask the kernel: "What is the actual name of the object this handle points to?"
-        // Sandboxie implements file system and registry virtualization by redirecting access
-        // While the API pretends we opened "\REGISTRY\USER", the handle might actually point to 
-        // something like "\Device\HarddiskVolume2\Sandbox\User\DefaultBox\RegHive"
-        alignas(16) BYTE buffer[1024]{};
-        ULONG returned_length = 0;
-        status = nt_query_object(key, ObjectNameInformation, buffer, sizeof(buffer), &returned_length);
-        nt_close(key);
-        if (!(((NTSTATUS)(status)) >= 0))
-            return false;
+                unsigned long parsed_v = 0;
+                size_t c_v = 0;
 
-        const auto object_name = reinterpret_cast<POBJECT_NAME_INFORMATION>(buffer);
+                if (!parse_hex(v + 4, 4, SIZE_MAX, parsed_v, c_v)) {
+                    continue;
+                }
 
-        UNICODE_STRING expected_name{};
-        expected_name.Buffer = const_cast<PWSTR>(L"\\REGISTRY\\USER");
-        expected_name.Length = static_cast<USHORT>(wcslen(expected_name.Buffer) * sizeof(WCHAR));
+                const wchar_t* dev_start = const_cast<wchar_t*>(d + 4);
+                const wchar_t* amp_after_dev = wcschr(dev_start, L'&');
+                const size_t dev_len = amp_after_dev ? static_cast<size_t>(amp_after_dev - dev_start) : wcslen(dev_start);
 
-        // Compare the requested name vs the actual kernel object name
-        // If they don't match, we have been redirected, confirming the presence of Sandboxie
-        const bool mismatch = (object_name->Name.Length != expected_name.Length) ||
-            (memcmp(object_name->Name.Buffer, expected_name.Buffer, expected_name.Length) != 0);
+                // for HDAUDIO expect 4 digits and for PCI allow up to 8
+                if (!(dev_len > 0 && dev_len <= 8)) {
+                    continue;
+                }
 
-        return mismatch ? core::add(brand_enum::SANDBOXIE) : false;
-    }
-    
-    
-    /**
-     * @brief Check if no waveform-audio output devices are present in the system
-     * @category Windows
-     * @implements VM::AUDIO
-     */
-    [[nodiscard]] static bool audio() {
-        struct KEY_FULL_INFORMATION {
-            LARGE_INTEGER LastWriteTime;
-            ULONG         TitleIndex;
-            ULONG         ClassOffset;
-            ULONG         ClassLength;
-            ULONG         SubKeys;
-            ULONG         MaxNameLen;
-            ULONG         MaxClassLen;
-            ULONG         Values;             
-            ULONG         MaxValueNameLen;
-            ULONG         MaxValueDataLen;
-            WCHAR         Class[1];
-        };
-        using PKEY_FULL_INFORMATION = KEY_FULL_INFORMATION*;
+                unsigned long parsed_d = 0;
+                size_t c_d = 0;
 
-        enum KEY_INFORMATION_CLASS {
-            KeyBasicInformation,
-            KeyNodeInformation,
-            KeyFullInformation,
-            KeyNameInformation,
-            KeyCachedInformation,
-            KeyFlagsInformation,
-            KeyVirtualizationInformation,
-            KeyHandleTagsInformation,
-            KeyTrustInformation,
-            KeyLayerInformation,
-            MaxKeyInfoClass
+                // parse exactly devLen digits (fail if any char is non-hex)
+                if (parse_hex(dev_start, 8, dev_len, parsed_d, c_d) && c_d == dev_len) {
+                    add_device(static_cast<u16>(parsed_v & 0xFFFFu), static_cast<u32>(parsed_d));
+                }
+            }
         };
 
-        const HMODULE ntdll = util::get_ntdll();
-        if (!ntdll) return false;
-
-        const char* names[] = { "RtlInitUnicodeString", "NtOpenKey", "NtQueryKey", "NtClose" };
-        void* funcs[ARRAYSIZE(names)] = {};
-        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
-
-        const auto rtl_init_unicode_string = reinterpret_cast<void(__stdcall*)(PUNICODE_STRING, PCWSTR)>(funcs[0]);
-        const auto nt_open_key = reinterpret_cast<NTSTATUS(__stdcall*)(PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES)>(funcs[1]);
-        const auto nt_query_key = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, KEY_INFORMATION_CLASS, PVOID, ULONG, PULONG)>(funcs[2]);
-        const auto nt_close = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE)>(funcs[3]);
+        // process the hardware ID on an instance key
+        auto process_hardware_id_reg = [&](HKEY h_inst) noexcept {
+            // most HardwareIDs fit within 512 bytes
+            static thread_local std::vector<wchar_t> buf;
+            if (buf.empty()) buf.resize(512);
 
-        if (!rtl_init_unicode_string || !nt_open_key || !nt_query_key || !nt_close) {
-            return false;
-        }
+            DWORD type = 0;
+            DWORD cb_data = static_cast<DWORD>(buf.size() * sizeof(wchar_t));
 
-        // We are checking for the presence of Audio Render devices
-        // Most legitimate user PCs have speakers or headphones (audio endpoints)
-        // Automated sandboxes and headless servers often have no audio devices configured
-        // We target the MMDevices\Audio\Render key where these endpoints are registered
-        const wchar_t* native_path = L"\\Registry\\Machine\\SOFTWARE\\Microsoft\\Windows\\CurrentVersion\\MMDevices\\Audio\\Render";
+            LONG rv = RegGetValueW(
+                h_inst,
+                nullptr,
+                L"HardwareID",
+                RRF_RT_REG_MULTI_SZ,
+                &type,
+                buf.data(),
+                &cb_data
+            );
 
-        UNICODE_STRING unicode_path;
-        rtl_init_unicode_string(&unicode_path, native_path);
+            if (rv == ERROR_MORE_DATA) {
+                if (cb_data > MAX_MULTI_SZ) {
+                    return;
+                }
 
-        OBJECT_ATTRIBUTES object_attributes;
-        RtlZeroMemory(&object_attributes, sizeof(object_attributes));
-        object_attributes.Length = sizeof(object_attributes);
-        object_attributes.ObjectName = &unicode_path;
-        object_attributes.Attributes = OBJ_CASE_INSENSITIVE;
+                // allocate a buffer large enough to hold the entire MULTI_SZ
+                // (+1 for safety null terminator logic below)
+                buf.resize((cb_data / sizeof(wchar_t)) + 2);
 
-        HANDLE key = nullptr;
-        const ACCESS_MASK desired_access = KEY_READ;
+                rv = RegGetValueW(
+                    h_inst,
+                    nullptr,
+                    L"HardwareID",
+                    RRF_RT_REG_MULTI_SZ,
+                    &type,
+                    buf.data(),
+                    &cb_data
+                );
+            }
 
-        NTSTATUS st = nt_open_key(&key, desired_access, &object_attributes);
-        if (!NT_SUCCESS(st) || key == nullptr) {
-            return false;
-        }
+            if (rv != ERROR_SUCCESS || type != REG_MULTI_SZ || cb_data <= sizeof(wchar_t)) {
+                return;
+            }
 
-        constexpr KEY_INFORMATION_CLASS InfoClass = KeyFullInformation;
-        std::vector<BYTE> info_buffer(512);
-        ULONG returned_len = 0;
+            // guarantee terminating NUL
+            // RegGetValueW with RRF_RT_REG_MULTI_SZ usually handles this but for safety
+            const size_t wchar_count = cb_data / sizeof(wchar_t);
+            if (wchar_count < buf.size()) buf[wchar_count] = L'\0';
+            else buf.back() = L'\0';
 
-        // Query the key information. If the buffer is too small (STATUS_BUFFER_TOO_SMALL),
-        // resize it to the exact length required by the kernel and try again
-        st = nt_query_key(key, InfoClass, info_buffer.data(), static_cast<ULONG>(info_buffer.size()), &returned_len);
+            for (wchar_t* p = buf.data(); *p; p += wcslen(p) + 1) {
+                scan_text_ids(p);
+            }
+        };
 
-        if (!NT_SUCCESS(st) && returned_len > info_buffer.size()) {
-            info_buffer.resize(returned_len);
-            st = nt_query_key(key, InfoClass, info_buffer.data(), static_cast<ULONG>(info_buffer.size()), &returned_len);
-        }
+        // all instance subkeys under a given device key
+        auto enum_instances = [&](HKEY h_dev) noexcept {
+            wchar_t inst_name[256];
 
-        bool has_values = false;
-        if (NT_SUCCESS(st) && returned_len >= sizeof(KEY_FULL_INFORMATION)) {
-            const auto* kfi = reinterpret_cast<PKEY_FULL_INFORMATION>(info_buffer.data());
+            for (DWORD j = 0;; ++j) {
+                // reset size for each iteration as RegEnumKeyExW modifies it
+                DWORD cb_inst = _countof(inst_name);
 
-            // Check if the registry key has any values associated with it
-            // If 'Values' is 0, the audio system is likely uninitialized or barren,
-            // which strongly suggests a virtualized/sandbox environment
-            const DWORD value_count = static_cast<DWORD>(kfi->Values); // values, not subkeys
-            has_values = (value_count > 0);
-        }
-        else {
-            nt_close(key);
-            return false;
-        }
+                const LONG st2 = RegEnumKeyExW(
+                    h_dev,
+                    j,
+                    inst_name,
+                    &cb_inst,
+                    nullptr,
+                    nullptr,
+                    nullptr,
+                    nullptr
+                );
+                if (st2 == ERROR_NO_MORE_ITEMS) break;
+                if (st2 != ERROR_SUCCESS) continue;
 
-        nt_close(key);
+                HKEY h_inst = nullptr;
+                if (RegOpenKeyExW(h_dev, inst_name, 0, KEY_READ, &h_inst) != ERROR_SUCCESS) continue;
 
-        return has_values;
-    }
-    
-    
-    /**
-     * @brief Check for VM-specific ACPI device signatures
-     * @category Windows
-     * @implements VM::ACPI_SIGNATURE
-     */
-    [[nodiscard]] static bool acpi_signature() {
-        auto is_hex = [](wchar_t c) noexcept -> bool {
-            return (c >= L'0' && c <= L'9') || (c >= L'A' && c <= L'F');
+                process_hardware_id_reg(h_inst);
+                RegCloseKey(h_inst);
+            }
         };
 
-        // enumerate all DISPLAY devices
-        const HDEVINFO handle_dev_info = SetupDiGetClassDevsW(&GUID_DEVCLASS_DISPLAY, nullptr, nullptr, DIGCF_PRESENT);
-        if (handle_dev_info == INVALID_HANDLE_VALUE) {
-            debug("ACPI_SIGNATURE: No display device detected");
-            return true;
-        }
-
-        SP_DEVINFO_DATA dev_info;
-        ZeroMemory(&dev_info, sizeof(dev_info));
-        dev_info.cbSize = sizeof(dev_info);
-        const DEVPROPKEY key = DEVPKEY_Device_LocationPaths;
+        // all device subkeys under a given root key
+        auto enum_devices = [&](HKEY h_root) noexcept {
+            wchar_t device_name[256];
 
-        // baremetal tokens (case-sensitive to preserve handling against edge-cases)
-        static constexpr const wchar_t* excluded_tokens[] = {
-            L"GFX",
-            L"IGD", L"IGFX", L"IGPU",
-            L"VGA", L"VIDEO", L"DISPLAY", L"GPU",
-            L"PCIROOT", L"PNP0A03", L"PNP0A08",
-            L"PCH", L"PXS", L"PEG", L"PEGP"
-        };
+            for (DWORD i = 0;; ++i) {
+                DWORD cb_name = _countof(device_name);
 
-        auto has_excluded_token = [&](const wchar_t* s) noexcept -> bool {
-            if (!s || !*s) return false;
-            for (const wchar_t* tok : excluded_tokens) {
-                if (wcsstr(s, tok) != nullptr) return true;
-            }
-            return false;
-        };
+                const LONG status = RegEnumKeyExW(
+                    h_root,
+                    i,
+                    device_name,
+                    &cb_name,
+                    nullptr,
+                    nullptr,
+                    nullptr,
+                    nullptr
+                );
+                if (status == ERROR_NO_MORE_ITEMS) break;
+                if (status != ERROR_SUCCESS) continue;
 
-        for (DWORD idx = 0; SetupDiEnumDeviceInfo(handle_dev_info, idx, &dev_info); ++idx) {
-            DEVPROPTYPE prop_type = 0;
-            DWORD required_size = 0;
+                HKEY h_dev = nullptr;
+                if (RegOpenKeyExW(h_root, device_name, 0, KEY_READ, &h_dev) != ERROR_SUCCESS) continue;
 
-            // query required size (bytes)
-            SetupDiGetDevicePropertyW(handle_dev_info, &dev_info, &key, &prop_type, nullptr, 0, &required_size, 0);
-            if (GetLastError() != ERROR_INSUFFICIENT_BUFFER || required_size == 0) {
-                if (GetLastError() == ERROR_NOT_FOUND) {
-                    debug("ACPI_SIGNATURE: No dedicated display/GPU detected");
-                    SetupDiDestroyDeviceInfoList(handle_dev_info);
-                    return false;
-                }
-                else {
-                    continue;
-                }
+                enum_instances(h_dev);
+                RegCloseKey(h_dev);
             }
+        };
 
-            // fetch buffer (multi-sz)
-            std::vector<BYTE> buffer(required_size + (sizeof(wchar_t) * 2), 0);
-            if (!SetupDiGetDevicePropertyW(handle_dev_info, &dev_info, &key, &prop_type,
-                buffer.data(), required_size, &required_size, 0))
-            {
+        // for each rootPath we open the root key once
+        for (size_t root_idx = 0; root_idx < _countof(kroots); ++root_idx) {
+            const wchar_t* root_path = kroots[root_idx];
+            HKEY root = nullptr;
+            if (RegOpenKeyExW(
+                HKEY_LOCAL_MACHINE,
+                root_path,
+                0,
+                KEY_READ,
+                &root
+            ) != ERROR_SUCCESS) {
                 continue;
             }
 
-            const wchar_t* ptr = reinterpret_cast<const wchar_t*>(buffer.data());
-            // number of wchar_t slots in buffer
-            const size_t total_wchars = required_size / sizeof(wchar_t);
-            const wchar_t* buf_end = ptr + (total_wchars ? total_wchars : 0);
-
-        #ifdef __VMAWARE_DEBUG__
-            for (const wchar_t* p = ptr; p < buf_end && *p; p += (wcslen(p) + 1)) {
-                debug("ACPI_SIGNATURE: ", p);
-            }
+            enum_devices(root);
+            RegCloseKey(root);
+        }
         #endif
 
-            static const wchar_t acpi_prefix[] = L"#ACPI(S";
-            static const wchar_t acpi_paren[] = L"ACPI(";
-
-            // First pass: QEMU-style "#ACPI(Sxx...)" and generic "ACPI(Sxx)"
-            for (const wchar_t* p = ptr; p < buf_end && *p; p += (wcslen(p) + 1)) {
-                if (has_excluded_token(p)) {
-                    debug("ACPI_SIGNATURE: Valid signature -> ", p);
-                    continue;
-                }
+        static const util::perfect_hash<util::pci_id> known_devices(util::known_pci_ids().data(), util::known_pci_ids().size());
 
-                // search for "#ACPI(S"
-                const wchar_t* search = p;
-                while (true) {
-                    const wchar_t* found = wcsstr(search, acpi_prefix);
-                    if (!found) break;
+        for (const auto d : devices) {
+            const u64 id64 = (static_cast<u64>(d.vendor_id) << 32) | d.device_id;
+            const u32 id32 = (static_cast<u32>(d.vendor_id) << 16) | static_cast<u32>(d.device_id);
 
-                    // after "#ACPI(S" we expect two hex chars
-                    const wchar_t* hexpos = found + wcslen(acpi_prefix); // first hex char
-                    if (hexpos && hexpos[0] && hexpos[1]) {
-                        wchar_t b = hexpos[0];
-                        wchar_t s = hexpos[1];
-                        if (is_hex(b) && is_hex(s)) {
-                            const wchar_t after = hexpos[2]; // may be '_' or ')'
-                            if (after == L'_' || after == L')') {
-                                SetupDiDestroyDeviceInfoList(handle_dev_info);
-                                return core::add(brand_enum::QEMU);
-                            }
-                        }
-                    }
-                    search = found + 1;
-                }
+            const util::pci_id* match = known_devices.find(id32);
 
-                // search for "ACPI(" then check for "S" + two hex digits
-                search = p;
-                while (true) {
-                    const wchar_t* found = wcsstr(search, acpi_paren);
-                    if (!found) break;
-                    const wchar_t* start = found + wcslen(acpi_paren); // char after '('
-                    if (start && start[0] && start[1] && start[2]) {
-                        if (start[0] == L'S' && is_hex(start[1]) && is_hex(start[2])) {
-                            SetupDiDestroyDeviceInfoList(handle_dev_info);
-                            return core::add(brand_enum::QEMU);
-                        }
-                    }
-                    search = found + 1;
-                }
+            if (match != nullptr) {
+                debug("DEVICES: Detected ", match->kind, " -> 0x", std::hex, id32);
+            } else if ((match = known_devices.find(util::pci_id::WIDE | id64)) != nullptr) {
+                debug("DEVICES: Detected ", match->kind, " -> 0x", std::hex, id64);
+            } else {
+                continue;
             }
 
-            // Important to run Hyper-V checks later because of is_hardened() logic
-            static constexpr const wchar_t* vm_signatures[] = {
-                L"#ACPI(VMOD)", L"#ACPI(VMBS)", L"#VMBUS(", L"#VPCI("
-            };
-
-            for (const wchar_t* p = ptr; p < buf_end && *p; p += (wcslen(p) + 1)) {
-                if (has_excluded_token(p)) continue;
-
-                for (const wchar_t* sig : vm_signatures) {
-                    if (wcsstr(p, sig) != nullptr) {
-                        SetupDiDestroyDeviceInfoList(handle_dev_info);
-                        return core::add(brand_enum::HYPERV);
-                    }
-                }
+            if (match->brand == brand_enum::NULL_BRAND) {
+                return true;
             }
-        }
 
-        SetupDiDestroyDeviceInfoList(handle_dev_info);
+            return core::add(match->brand);
+        }
+        
         return false;
     }
 
 
     /**
-     * @brief Check if after raising two traps at the same RIP, a hypervisor interferes with the instruction pointer delivery
-     * @category Windows, x86_64
-     * @implements VM::TRAP
+     * @brief Check boot logo for known VM images
+     * @category Windows, Linux, x86_64
+     * @author Teselka (https://github.com/Teselka)
+     * @implements VM::BOOT_LOGO
      */
-    [[nodiscard]] static bool trap() {
-        bool hypervisor_caught = false;
-    #if (x86_64)
-        // when a single - step(TF) and hardware breakpoint(DR0) collide, Intel CPUs set both DR6.BS and DR6.B0 to report both events, which help make this detection trick
-        // AMD CPUs prioritize the breakpoint, setting only its corresponding bit in DR6 and clearing the single-step bit, which is why this technique is not compatible with AMD
-        if (!cpu::is_intel()) {
-            return false;
-        }
+    [[nodiscard]] static bool boot_logo()
+    #if (x86 && (CLANG || GCC))
+        __attribute__((__target__("crc32")))
+    #endif
+    {
+    #if (x86_64)       
+        #if (WINDOWS)
+            const HMODULE ntdll = util::get_ntdll();
+            if (!ntdll)
+                return false;
 
-        // mobile SKUs can "false flag" this check
-        const char* brand = cpu::get_brand();
-        for (const char* c = brand; *c; ++c) {
-            if (*c == 'U') {
-                if (c > brand && (c[-1] >= '0' && c[-1] <= '9')) {
-                    if (c[1] == ' ' || c[1] == '\0') {
-                        return false;
-                    }
-                }
-            }
-        }
+            const char* function_names[] = { "NtQuerySystemInformation" };
+            void* functions[1] = { nullptr };
+            util::get_function_address(ntdll, function_names, functions, 1);
 
-        // We must preserve RBX because CPUID clobbers it, and RBX is a non-volatile 
-        // register in x64. If we don't restore it, the calling function (VM::check) crashes
-        // we use MOV R8, RBX instead of PUSH RBX. Pushing to the stack without 
-        // unwind metadata breaks SEH in x64 (OS cannot find the handler), causing a crash
-        constexpr u8 trampoline[] = {
-            0x49, 0x89, 0xD8,                     // mov r8, rbx      (save rbx to volatile register r8)
-            0x9C,                                 // pushfq
-            0x81, 0x04, 0x24,                     // OR DWORD PTR [RSP], 0x10100 (Set TF)
-            0x00, 0x01, 0x01, 0x00,
-            0x9D,                                 // popfq
-            0x0F, 0xA2,                           // cpuid 
-            0x4C, 0x89, 0xC3,                     // mov rbx, r8      (restore rbx from r8) - trap happens here
-            0xC3                                  // ret
-        };
-        SIZE_T trampoline_size = sizeof(trampoline);
+            using nt_query_sysinfo_t = NTSTATUS(__stdcall*)(SYSTEM_INFORMATION_CLASS, PVOID, ULONG, PULONG);
+            nt_query_sysinfo_t nt_query = reinterpret_cast<nt_query_sysinfo_t>(functions[0]);
+            if (!nt_query)
+                return false;
 
-        const HMODULE ntdll = util::get_ntdll();
-        if (!ntdll) return false;
+            // parse header to locate the bitmap
+            struct boot_logo_info { ULONG flags, bitmap_offset; };
 
-        const char* names[] = {
-            "NtAllocateVirtualMemory",
-            "NtProtectVirtualMemory",
-            "NtFreeVirtualMemory",
-            "NtFlushInstructionCache",
-            "NtClose",
-            "NtGetContextThread",
-            "NtSetContextThread"
-        };
-        void* funcs[ARRAYSIZE(names)] = {};
-        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+            // determine required buffer size
+            const SYSTEM_INFORMATION_CLASS sys_boot_info = static_cast<SYSTEM_INFORMATION_CLASS>(140);
+            ULONG needed = 0;
+            NTSTATUS st = nt_query(sys_boot_info, nullptr, 0, &needed);
+            if (st != static_cast<NTSTATUS>(0xC0000023) &&
+                st != static_cast<NTSTATUS>(0x80000005) &&
+                st != static_cast<NTSTATUS>(0xC0000004))
+                return false;
 
-        using nt_allocate_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, ULONG_PTR, PSIZE_T, ULONG, ULONG);
-        using nt_protect_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG, PULONG);
-        using nt_free_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG);
-        using nt_flush_instruction_cache_t = NTSTATUS(__stdcall*)(HANDLE, PVOID, SIZE_T);
-        using nt_close_t = NTSTATUS(__stdcall*)(HANDLE);
-        using nt_get_context_thread_t = NTSTATUS(__stdcall*)(HANDLE, PCONTEXT);
-        using nt_set_context_thread_t = NTSTATUS(__stdcall*)(HANDLE, PCONTEXT);
+            std::vector<u8> buffer(needed);
 
-        // volatile ensures these are loaded from stack after SEH unwind when compiled with aggresive optimizations
-        nt_allocate_virtual_memory_t volatile nt_allocate_virtual_memory = reinterpret_cast<nt_allocate_virtual_memory_t>(funcs[0]);
-        nt_protect_virtual_memory_t volatile nt_protect_virtual_memory = reinterpret_cast<nt_protect_virtual_memory_t>(funcs[1]);
-        nt_free_virtual_memory_t volatile nt_free_virtual_memory = reinterpret_cast<nt_free_virtual_memory_t>(funcs[2]);
-        nt_flush_instruction_cache_t volatile nt_flush_instruction_cache = reinterpret_cast<nt_flush_instruction_cache_t>(funcs[3]);
-        nt_close_t volatile nt_close = reinterpret_cast<nt_close_t>(funcs[4]);
-        nt_get_context_thread_t volatile nt_get_context_thread = reinterpret_cast<nt_get_context_thread_t>(funcs[5]);
-        nt_set_context_thread_t volatile nt_set_context_thread = reinterpret_cast<nt_set_context_thread_t>(funcs[6]);
+            // fetch the boot-logo data
+            st = nt_query(sys_boot_info, buffer.data(), needed, &needed);
+            if (!NT_SUCCESS(st))
+                return false;
 
-        if (!nt_allocate_virtual_memory || !nt_protect_virtual_memory || !nt_flush_instruction_cache ||
-            !nt_free_virtual_memory || !nt_get_context_thread || !nt_set_context_thread || !nt_close) {
-            return false;
-        }
+            if (needed < sizeof(boot_logo_info))
+                return false;
 
-        PVOID exec_mem = nullptr;
-        SIZE_T region_size = trampoline_size;
-        const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
-        NTSTATUS st = nt_allocate_virtual_memory(current_process, &exec_mem, 0, &region_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-        if (!NT_SUCCESS(st) || !exec_mem) {
-            return false;
-        }
-        memcpy(exec_mem, trampoline, trampoline_size);
+            const auto* info = reinterpret_cast<const boot_logo_info*>(buffer.data());
+            if (info->bitmap_offset >= needed)
+                return false;
 
-        {
-            PVOID tmp_base = exec_mem;
-            SIZE_T tmp_sz = trampoline_size;
-            ULONG oldProt = 0;
-            st = nt_protect_virtual_memory(current_process, &tmp_base, &tmp_sz, PAGE_EXECUTE_READ, &oldProt);
-            if (!NT_SUCCESS(st)) {
-                PVOID free_base = exec_mem;
-                SIZE_T free_size = 0;
-                nt_free_virtual_memory(current_process, &free_base, &free_size, MEM_RELEASE);
+            const u8* bmp = buffer.data() + info->bitmap_offset;
+            const size_t size = static_cast<size_t>(needed) - info->bitmap_offset;
+        #else
+            const int fd = open("/sys/firmware/acpi/bgrt/image", O_RDONLY);
+            if (fd < 0)
+            {
+                debug("BOOT_LOGO: failed to open /sys/firmware/acpi/bgrt/image");
                 return false;
             }
-        }
-
-        nt_flush_instruction_cache(current_process, exec_mem, trampoline_size);
 
-        u8 hitCount = 0;
+            const off_t size = lseek(fd, 0, SEEK_END);
+            if (size <= 0)
+            {
+                debug("BOOT_LOGO: failed to seek to the end");
+                close(fd);
+                return false;
+            }
 
-        CONTEXT original_context{};
-        original_context.ContextFlags = CONTEXT_DEBUG_REGISTERS;
-        const HANDLE current_thread = reinterpret_cast<HANDLE>(-2LL);
+            lseek(fd, 0, SEEK_SET);
 
-        if (!NT_SUCCESS(nt_get_context_thread(current_thread, &original_context))) {
-            PVOID free_base = exec_mem;
-            SIZE_T free_size = 0;
-            nt_free_virtual_memory(current_process, &free_base, &free_size, MEM_RELEASE);
-            return false;
-        }
+            std::vector<u8> buffer(size);
+            ssize_t read_size = 0;
+            size_t off = 0;
+            for (;;) {
+                read_size = read(fd, buffer.data() + off, size - off);
+                if (read_size <= 0) { break; }
+                off += static_cast<size_t>(read_size);
+                if (off >= static_cast<size_t>(size)) { break; }
+            }
 
-        // Set DR0 to trampoline + 14 (Instruction: mov rbx, r8)
-        // Offset calculation: mov_r8_rbx(3) + pushfq(1) + or(7) + popfq(1) + cpuid(2) = 14
-        // This is where single step traps after CPUID, and where we want the collision
-        const uintptr_t expected_trap_address = reinterpret_cast<uintptr_t>(exec_mem) + 14;
+            close(fd);
+            if (off != static_cast<size_t>(size))
+            {
+                debug("BOOT_LOGO: read failed or partial");
+                return false;
+            }
 
-        // set Dr0 to trampoline+offset
-        CONTEXT debug_context = original_context;
-        debug_context.Dr0 = expected_trap_address; // single step breakpoint address
-        debug_context.Dr7 = 1; // enable Local Breakpoint 0
+            const u8* bmp = buffer.data();
+        #endif
 
-        if (!NT_SUCCESS(nt_set_context_thread(current_thread, &debug_context))) {
-            nt_set_context_thread(current_thread, &original_context);
-            PVOID free_base = exec_mem;
-            SIZE_T free_size = 0;
-            nt_free_virtual_memory(current_process, &free_base, &free_size, MEM_RELEASE);
-            return false;
-        }
+        // struct + function to isolate SEH from the stack frame containing std::vector and use __target__
+        struct crc {
+        #if (GCC || CLANG)
+            __attribute__((__target__("sse4.2")))
+        #endif
+            static u32 compute(const u8* data, size_t len) {
+                // 8 byte chunks
+                u64 crcReg = 0xFFFFFFFFull;
+                const size_t qwords = len >> 3;
+                const auto* ptr = reinterpret_cast<const u64*>(data);
 
-        // Context structure to pass data to the static SEH handler
-        struct trap_context {
-            uintptr_t expectedTrapAddr;
-            u8* hitCount;
-            bool* hypervisor_caught;
-        };
+                size_t i = 0;
 
-        // Static class for SEH filtering to avoid Release mode Lambda corruption
-        struct SEH_Trap {
-            static LONG Vet(u32 code, EXCEPTION_POINTERS* info, trap_context* ctx) noexcept {
-                // Lambda returns LONG to support EXCEPTION_CONTINUE_EXECUTION
-                if (code != static_cast<DWORD>(0x80000004L)) {
-                    return EXCEPTION_CONTINUE_SEARCH;
-                }
+                const auto& info = cpu::analyze_cpu();
 
-                // Verify exception happened at our calculated offset
-                if (reinterpret_cast<uintptr_t>(info->ExceptionRecord->ExceptionAddress) != ctx->expectedTrapAddr) {
-                    info->ContextRecord->EFlags &= ~0x100; // Clear TF
-                    info->ContextRecord->Dr7 &= ~1;        // Clear DR0 Enable
-                    *ctx->hypervisor_caught = true;
-                    return EXCEPTION_CONTINUE_EXECUTION;
-                }
+                if (info.has_sse42)
+                {
+                    // unrolled loop
+                    for (; i + 3 < qwords; i += 4) {
+                        crcReg = _mm_crc32_u64(crcReg, ptr[i]);
+                        crcReg = _mm_crc32_u64(crcReg, ptr[i + 1]);
+                        crcReg = _mm_crc32_u64(crcReg, ptr[i + 2]);
+                        crcReg = _mm_crc32_u64(crcReg, ptr[i + 3]);
+                    }
 
-                (*ctx->hitCount)++;
+                    for (; i < qwords; ++i) {
+                        crcReg = _mm_crc32_u64(crcReg, ptr[i]);
+                    }
 
-                // check if Trap Flag and DR0 contributed
-                constexpr u64 required_bits = (1ULL << 14) | 1ULL; // BS | B0
-                const u64 status = info->ContextRecord->Dr6;
+                    u32 crc = static_cast<u32>(crcReg);
+                    const auto* tail = reinterpret_cast<const u8*>(ptr + qwords);
 
-                if ((status & required_bits) != required_bits) {
-                    if (util::hyper_x() != HYPERV_ARTIFACT_VM) // detects type 1 Hyper-V too, which we consider legitimate
-                        *ctx->hypervisor_caught = true;
+                    for (size_t j = 0, r = len & 7; j < r; ++j) {
+                        crc = _mm_crc32_u8(crc, tail[j]);
+                    }
+                    crc ^= 0xFFFFFFFFu;
+                    return crc;
                 }
 
-                // Clear Trap Flag to stop single stepping
-                info->ContextRecord->EFlags &= ~0x100;
-
-                // Clear DR7 Local Enable 0 to disable the hardware breakpoint
-                // If we don't do this, the next instruction will trigger the breakpoint again immediately
-                info->ContextRecord->Dr7 &= ~1;
-
-                // executes mov rbx, r8 (restore), and returns
-                return EXCEPTION_CONTINUE_EXECUTION;
+                return 0;
             }
         };
 
-        trap_context ctx = { expected_trap_address, &hitCount, &hypervisor_caught };
-
-        __try {
-            reinterpret_cast<void(*)()>(exec_mem)();
-        }
-        __except (SEH_Trap::Vet(_exception_code(), reinterpret_cast<EXCEPTION_POINTERS*>(_exception_info()), &ctx)) {
-            // This block is effectively unreachable because vetExceptions returns CONTINUE_EXECUTION or CONTINUE_SEARCH
-        }
+        const u32 hash = crc::compute(bmp, size);
 
-        // If the hypervisor swallowed the exception entirely, hitCount will be 0
-        if (hitCount != 1) {
-            hypervisor_caught = true;
+        #if (WINDOWS)
+            debug("BOOT_LOGO: size=", needed, ", flags=", info->flags, ", offset=", info->bitmap_offset, ", crc=0x", std::hex, hash);
+        #else
+            debug("BOOT_LOGO: size=", size, ", crc=0x", std::hex, hash);
+        #endif
+        switch (hash) {
+            case 0x110350C5: return core::add(brand_enum::QEMU); // TianoCore EDK2
+            case 0x87c39681: return core::add(brand_enum::HYPERV);
+            // case 0x9502cb33: return core::add(brand_enum::VBOX); // conflicts with some MSI logo images
+            default:         return false;
         }
-
-        nt_set_context_thread(current_thread, &original_context);
-
-        PVOID free_base = exec_mem;
-        SIZE_T free_size = 0;
-        nt_free_virtual_memory(current_process, &free_base, &free_size, MEM_RELEASE);
-    #endif
-        return hypervisor_caught;
+        #else
+        return false;
+        #endif
     }
 
-
+    
     /**
-     * @brief Check if after executing an undefined instruction, a hypervisor misinterpret it as a system call
-     * @category Windows
-     * @implements VM::UD
-     */
-    [[nodiscard]] static bool ud() {
-    #if (x86)
-        // ud2; ret
-        constexpr u8 ud_opcodes[] = { 0x0F, 0x0B, 0xC3 };
-    #elif (ARM32)
-        // udf #0; bx lr
-        // (Little-endian for 0xE7F000F0 and 0xE12FFF1E)
-        constexpr u8 ud_opcodes[] = { 0xF0, 0x00, 0xF0, 0xE7, 0x1E, 0xFF, 0x2F, 0xE1 };
-    #elif (ARM64)
-        // hlt #0; ret
-        // (Little-endian for 0xD4400000 and 0xD65F03C0)
-        constexpr u8 ud_opcodes[] = { 0x00, 0x00, 0x40, 0xD4, 0xC0, 0x03, 0x5F, 0xD6 };
-    #else
-        // architecture not supported by this check
-        return false;
-    #endif
-        
-        bool saw_ud = false;
-        const HMODULE ntdll = util::get_ntdll();
-        if (!ntdll) return false;
-
-        const char* names[] = { "NtAllocateVirtualMemory", "NtProtectVirtualMemory", "NtFlushInstructionCache", "NtFreeVirtualMemory" };
-        void* funcs[ARRAYSIZE(names)] = {};
-        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
-
-        const auto nt_allocate_virtual_memory = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID*, ULONG_PTR, PSIZE_T, ULONG, ULONG)>(funcs[0]);
-        const auto nt_protect_virtual_memory = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG, PULONG)>(funcs[1]);
-        const auto nt_flush_instruction_cache = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID, SIZE_T)>(funcs[2]);
-        const auto nt_free_virtual_memory = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG)>(funcs[3]);
-
-        if (!nt_allocate_virtual_memory || !nt_protect_virtual_memory || !nt_flush_instruction_cache || !nt_free_virtual_memory) {
-            return false;
-        }
-
-        const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
-        PVOID base = nullptr;
-        SIZE_T region_size = sizeof(ud_opcodes);
-        NTSTATUS st = nt_allocate_virtual_memory(current_process, &base, 0, &region_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-        if (!NT_SUCCESS(st) || !base) {
-            return false;
-        }
+    * @brief Check for serial numbers of virtual disks
+    * @category Windows
+    * @implements VM::DISK_SERIAL
+    */
+    [[nodiscard]] static bool disk_serial_number() {
+        bool result = false;
 
-        memcpy(base, ud_opcodes, sizeof(ud_opcodes));
+        // helper to detect QEMU instances based on default hard drive serial patterns
+        // QEMU drives often start with "QM000" followed by digits
+        auto is_qemu_serial = [](const char* str, size_t len) noexcept -> bool {
+            if (!str || len < 6) {
+                return false;
+            }
 
-        ULONG old_protection = 0;
-        st = nt_protect_virtual_memory(current_process, &base, &region_size, PAGE_EXECUTE_READ, &old_protection);
-        if (!NT_SUCCESS(st)) {
-            region_size = 0;
-            nt_free_virtual_memory(current_process, &base, &region_size, MEM_RELEASE);
-            return false;
-        }
+            if ((str[0] & 0xDF) != 'Q') return false;
+            if ((str[1] & 0xDF) != 'M') return false;
+
+            return str[2] == '0' && str[3] == '0' && str[4] == '0' && str[5] == '0';
+        };
+        
+        // helper to detect VirtualBox instances
+        // VirtualBox uses a specific serial format "VB" followed by hex segments
+        auto is_vbox_serial = [](const char* str, size_t len) noexcept -> bool {
+            // format: VB12345678-12345678 (19 chars)
+            if (len != 19) {
+                return false;
+            }
+            
+            if ((str[0] & 0xDF) != 'V' || (str[1] & 0xDF) != 'B') {
+                return false;
+            }
+            if (str[10] != '-') {
+                return false;
+            }
+            
+            auto is_hex = [](char c) noexcept -> bool {
+                const char lower = static_cast<char>(c | 0x20);
+                return (c >= '0' && c <= '9') 
+                || (lower >= 'a' && lower <= 'f');
+            };
+            
+            for (size_t i = 2; i < 10; ++i) {
+                if (!is_hex(str[i])) {
+                    return false;
+                }
+            }
+            
+            for (size_t i = 11; i < 19; ++i) {
+                if (!is_hex(str[i])) {
+                    return false;
+                }
+            }
+            
+            return true;
+        };
+        
+        #if (WINDOWS)
+
+        auto strnlen = [](const char* s, size_t max) noexcept -> size_t {
+            const void* p = memchr(s, 0, max);
+            if (!p) return max;
+            return static_cast<size_t>(static_cast<const char*>(p) - s);
+        };
+        
+        using NtOpenFile_t = NTSTATUS(__stdcall*)(PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES, PIO_STATUS_BLOCK, ULONG, ULONG);
+        using NtDeviceIoControlFile_t = NTSTATUS(__stdcall*)(HANDLE, HANDLE, PVOID, PVOID, PIO_STATUS_BLOCK, ULONG, PVOID, ULONG, PVOID, ULONG);
+        using NtAllocateVirtualMemory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, ULONG_PTR, PSIZE_T, ULONG, ULONG);
+        using NtFreeVirtualMemory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG);
+        using NtClose_t = NTSTATUS(__stdcall*)(HANDLE);
+        using RtlInitUnicodeString_t = void(__stdcall*)(PUNICODE_STRING, PCWSTR);
+
+        constexpr u8 MAX_PHYSICAL_DRIVES = 4;
+        constexpr size_t MAX_DESCRIPTOR_SIZE = 64 * 1024;
+        u8 successful_opens = 0;
+
+        const HMODULE ntdll = util::get_ntdll();
+        if (!ntdll) return result;
+
+        const char* names[] = {
+            "RtlInitUnicodeString",
+            "NtOpenFile",
+            "NtDeviceIoControlFile",
+            "NtAllocateVirtualMemory",
+            "NtFreeVirtualMemory",
+            "NtFlushInstructionCache",
+            "NtClose"
+        };
+        void* funcs[ARRAYSIZE(names)] = {};
+        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+
+        const auto rtl_init_unicode_string = reinterpret_cast<RtlInitUnicodeString_t>(funcs[0]);
+        const auto nt_open_file = reinterpret_cast<NtOpenFile_t>(funcs[1]);
+        const auto nt_device_io_control_file = reinterpret_cast<NtDeviceIoControlFile_t>(funcs[2]);
+        const auto nt_allocate_virtual_memory = reinterpret_cast<NtAllocateVirtualMemory_t>(funcs[3]);
+        const auto nt_free_virtual_memory = reinterpret_cast<NtFreeVirtualMemory_t>(funcs[4]);
+        const auto nt_close = reinterpret_cast<NtClose_t>(funcs[6]);
+
+        if (!rtl_init_unicode_string || !nt_open_file || !nt_device_io_control_file ||
+            !nt_allocate_virtual_memory || !nt_free_virtual_memory || !nt_close) {
+            return result;
+        }
+
+        // Iterate through the first few physical drives (PhysicalDrive0 to PhysicalDrive3)
+        // Most systems boot from 0, and VMs rarely emulate more than 1 or 2 drives by default
+        for (u8 drive = 0; drive < MAX_PHYSICAL_DRIVES; ++drive) {
+            wchar_t path[32];
+            swprintf_s(path, L"\\??\\PhysicalDrive%u", drive);
+
+            UNICODE_STRING unicode_path;
+            rtl_init_unicode_string(&unicode_path, path);
+
+            OBJECT_ATTRIBUTES object_attributes;
+            RtlZeroMemory(&object_attributes, sizeof(object_attributes));
+            object_attributes.Length = sizeof(object_attributes);
+            object_attributes.ObjectName = &unicode_path;
+            object_attributes.Attributes = OBJ_CASE_INSENSITIVE;
+            object_attributes.RootDirectory = nullptr;
+
+            IO_STATUS_BLOCK iosb;
+            HANDLE device = nullptr;
+
+            constexpr ACCESS_MASK desired_access = SYNCHRONIZE | FILE_READ_ATTRIBUTES;
+            constexpr ULONG share_access = FILE_SHARE_READ | FILE_SHARE_WRITE;
+            constexpr ULONG open_options = FILE_NON_DIRECTORY_FILE | FILE_SYNCHRONOUS_IO_NONALERT;
+
+            // Attempt to open the physical drive directly using Native API
+            NTSTATUS st = nt_open_file(&device, desired_access, &object_attributes, &iosb, share_access, open_options);
+            if (!NT_SUCCESS(st) || device == nullptr) {
+                continue;
+            }
+            ++successful_opens;
+
+            // stack buffer attempt
+            // We first try to read the storage properties into a small stack buffer to avoid heap
+            BYTE stackBuf[512] = { 0 };
+            const STORAGE_DEVICE_DESCRIPTOR* descriptor = reinterpret_cast<STORAGE_DEVICE_DESCRIPTOR*>(stackBuf);
+
+            STORAGE_PROPERTY_QUERY query{};
+            query.PropertyId = StorageDeviceProperty;
+            query.QueryType = PropertyStandardQuery;
+
+            const ULONG ioctl = IOCTL_STORAGE_QUERY_PROPERTY;
+
+            st = nt_device_io_control_file(device, nullptr, nullptr, nullptr, &iosb,
+                ioctl,
+                &query, sizeof(query),
+                stackBuf, sizeof(stackBuf));
+
+            BYTE* allocated_buffer = nullptr;
+            SIZE_T allocated_size = 0;
+            const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
+
+            // If the stack buffer was too small (NtDeviceIoControlFile failed), we fall back 
+            // to allocating memory dynamically using NtAllocateVirtualMemory
+            if (!NT_SUCCESS(st)) {
+                DWORD reported_size = 0;
+                if (descriptor && descriptor->Size > 0) {
+                    reported_size = descriptor->Size;
+                }
+
+                // This branch just ensures the requested size is reasonable before allocating
+                if (reported_size > 0 && reported_size < static_cast<DWORD>(MAX_DESCRIPTOR_SIZE) && reported_size >= sizeof(STORAGE_DEVICE_DESCRIPTOR)) {
+                    allocated_size = static_cast<SIZE_T>(reported_size);
+                    PVOID allocation_base = nullptr;
+                    SIZE_T region_size = allocated_size;
+                    st = nt_allocate_virtual_memory(current_process, &allocation_base, 0, &region_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+                    if (!NT_SUCCESS(st) || allocation_base == nullptr) {
+                        nt_close(device);
+                        continue;
+                    }
+                    allocated_buffer = reinterpret_cast<BYTE*>(allocation_base);
+
+                    // Retry the query with the larger allocated buffer
+                    st = nt_device_io_control_file(device, nullptr, nullptr, nullptr, &iosb,
+                        ioctl,
+                        &query, sizeof(query),
+                        allocated_buffer, static_cast<ULONG>(allocated_size));
+                    if (!NT_SUCCESS(st)) {
+                        PVOID free_base = reinterpret_cast<PVOID>(allocated_buffer);
+                        SIZE_T free_size = 0;
+                        nt_free_virtual_memory(current_process, &free_base, &free_size, MEM_RELEASE);
+                        nt_close(device);
+                        continue;
+                    }
+                    descriptor = reinterpret_cast<STORAGE_DEVICE_DESCRIPTOR*>(allocated_buffer);
+                }
+                else {
+                    nt_close(device);
+                    continue;
+                }
+            }
+
+            // This part is just to validate the structure size returned by the driver to prevent out-of-bounds reads
+            {
+                const DWORD reported_size = descriptor->Size;
+                if (reported_size < sizeof(STORAGE_DEVICE_DESCRIPTOR) || static_cast<SIZE_T>(reported_size) > MAX_DESCRIPTOR_SIZE) {
+                    if (allocated_buffer) {
+                        PVOID free_base = reinterpret_cast<PVOID>(allocated_buffer);
+                        SIZE_T free_size = 0;
+                        nt_free_virtual_memory(current_process, &free_base, &free_size, MEM_RELEASE);
+                        allocated_buffer = nullptr;
+                    }
+                    nt_close(device);
+                    continue;
+                }
+            }
+
+            // Serial number string within the descriptor structure
+            const u32 serial_offset = descriptor->SerialNumberOffset;
+            if (serial_offset > 0 && serial_offset < descriptor->Size) {
+                const char* serial = reinterpret_cast<const char*>(descriptor) + serial_offset;
+                const size_t max_avail = static_cast<size_t>(descriptor->Size) - static_cast<size_t>(serial_offset);
+                const size_t serialLen = strnlen(serial, max_avail);
+
+                debug("DISK_SERIAL: ", serial);
+
+                // Check the retrieved serial number against known VM artifacts
+                if (is_qemu_serial(serial, serialLen) || is_vbox_serial(serial, serialLen)) {
+                    if (allocated_buffer) {
+                        PVOID free_base = reinterpret_cast<PVOID>(allocated_buffer);
+                        SIZE_T free_size = 0;
+                        nt_free_virtual_memory(current_process, &free_base, &free_size, MEM_RELEASE);
+                        allocated_buffer = nullptr;
+                    }
+                    nt_close(device);
+                    return true;
+                }
+            }
+
+            // Cleanup for the current iteration if no VM was detected on this drive
+            if (allocated_buffer) {
+                PVOID free_base = reinterpret_cast<PVOID>(allocated_buffer);
+                SIZE_T free_size = 0;
+                nt_free_virtual_memory(current_process, &free_base, &free_size, MEM_RELEASE);
+                allocated_buffer = nullptr;
+            }
+            nt_close(device);
+        }
+
+        // If we couldn't open any physical drives (not even read permissions) it's weird so we flag it.
+        if (successful_opens == 0) {
+            debug("DISK_SERIAL: No physical drives detected");
+            return true;
+        }
+    #else
+        DIR* dir = opendir("/sys/block");
+        if (!dir) {
+            return false;
+        }
+
+        struct dirent* ent{};
+
+        while ((ent = readdir(dir))) {
+            const char* name = ent->d_name;
+            if (name[0] == '.') {
+                continue;
+            }
+
+            if (!strncmp(name, "nvme", 4) ||
+                !strncmp(name, "sd", 2) ||
+                !strncmp(name, "sg", 2) ||
+                !strncmp(name, "hd", 2) ||
+                !strncmp(name, "vd", 2)
+            ) {
+                const char sys_block_str[] = "/sys/block/";
+                const char device_serial_str[] = "/device/serial";
+
+                // /sys/block/%s/device/serial
+                char buf[sizeof(dirent::d_name) + sizeof(sys_block_str) + sizeof(device_serial_str)];
+                snprintf(buf, sizeof(buf), "%s%s%s", sys_block_str, name, device_serial_str);
+
+                char serial[1024] = {};
+                ssize_t rsize = 0;
+
+                // read ahead by VM::PREFETCH, where a missing serial was cached as empty
+                const std::string* prefetched = util::prefetched(buf);
+
+                if (prefetched != nullptr) {
+                    if (prefetched->empty()) {
+                        continue;
+                    }
+
+                    const size_t length = std::min(prefetched->size(), sizeof(serial) - 1);
+                    std::memcpy(serial, prefetched->data(), length);
+                    rsize = static_cast<ssize_t>(length);
+                } else {
+                    const int fd = open(buf, O_RDONLY);
+                    if (fd < 0) {
+                        continue;
+                    }
+
+                    rsize = read(fd, serial, sizeof(serial)-1);
+                    close(fd);
+                    if (rsize < 0) {
+                        continue;
+                    }
+                }
+
+                debug("DISK_SERIAL: ", (const char*)serial);
+                if (is_qemu_serial(serial, static_cast<size_t>(rsize)) || is_vbox_serial(serial, static_cast<size_t>(rsize))) {
+                    result = true;
+                }
+            }
+        }
+
+        closedir(dir);
+    #endif
+        return result;
+    }
+#endif
+
+#if (MSVC)
+    #pragma endregion
+    #pragma region "Linux and Apple"
+#endif
+
+#if (LINUX || APPLE)
+    /**
+     * @brief Check if there are only 1 or 2 threads, which is a common pattern in VMs with default settings, nowadays physical CPUs should have at least 4 threads for modern CPUs
+     * @category x86 (ARM might have very low thread counts, which is why it should be only for x86)
+     * @implements VM::THREAD_COUNT
+     */
+    [[nodiscard]] static bool thread_count() {
+    #if (x86 && !APPLE)
+        debug("THREADCOUNT: ", "threads = ", memo::threadcount::fetch());
+
+        const struct cpu::stepping_struct steps = cpu::fetch_steppings();
+
+        if (cpu::is_celeron(steps)) {
+            return false;
+        }
+
+        return (memo::threadcount::fetch() <= 2);
+    #else 
+        return false;
+    #endif
+    }
+#endif
+
+#if (MSVC)
+    #pragma endregion
+    #pragma region "Apple"
+#endif
+
+#if (APPLE) 
+    /**
+     * @brief Check if the sysctl for the hwmodel does not contain the "Mac" string
+     * @author MacRansom ransomware
+     * @category MacOS
+     * @implements VM::HWMODEL
+     */
+    [[nodiscard]] static bool hwmodel() {
+        
+        // hw.model strings are short (like for example MacBookPro16,1), 128 bytes is plenty
+        char buffer[128] = { 0 };
+        size_t size = sizeof(buffer);
+
+        // sysctlbyname queries the kernel directly, bypassing the overhead of 
+        // fork(), exec(), and pipe() found in util::sys_result (popen)
+        if (sysctlbyname("hw.model", buffer, &size, nullptr, 0) != 0) {
+            debug("HWMODEL: ", "failed to read hw.model");
+            return false;
+        }
+
+        buffer[127] = '\0';
+
+        // sysctlbyname returns the raw value (usually without a trailing newline),
+        // so no trimming is required
+        debug("HWMODEL: ", "output = ", buffer);
+
+        if (strstr(buffer, "Mac") != nullptr) {
+            return false;
+        }
+
+        if (strstr(buffer, "VMware") != nullptr) {
+            return core::add(brand_enum::VMWARE);
+        }
+
+        // assumed true since it doesn't contain "Mac" string
+        return true;
+    }
+
+
+    /**
+     * @brief Check if memory is too low for MacOS system
+     * @category MacOS
+     * @link https://evasions.checkpoint.com/src/MacOS/macos.html
+     * @implements VM::MAC_MEMSIZE
+     */
+    [[nodiscard]] static bool hw_memsize() {
+        std::unique_ptr<std::string> result = util::sys_result("sysctl -n hw.memsize");
+        const std::string ram = *result;
+
+        if (ram == "0") {
+            return false;
+        }
+
+        debug("MAC_MEMSIZE: ", "ram size = ", ram);
+
+        for (const char c : ram) {
+            if (!std::isdigit(c)) {
+                debug("MAC_MEMSIZE: ", "found non-digit character, returned false");
+                return false;
+            }
+        }
+
+        const u64 ram_u64 = std::stoull(ram);
+
+        debug("MAC_MEMSIZE: ", "ram size in u64 = ", ram_u64);
+
+        constexpr u64 limit = 4000000000; // 4GB 
+
+        return (ram_u64 <= limit);
+    }
+
+
+    /**
+     * @brief Check MacOS' IO kit registry for VM-specific strings
+     * @category MacOS
+     * @link https://evasions.checkpoint.com/src/MacOS/macos.html
+     * @implements VM::MAC_IOKIT
+     */
+    [[nodiscard]] static bool io_kit() {
+        // board_ptr and manufacturer_ptr empty
+        std::unique_ptr<std::string> platform_ptr = util::sys_result("ioreg -rd1 -c IOPlatformExpertDevice");
+        std::unique_ptr<std::string> board_ptr = util::sys_result("ioreg -rd1 -c board-id");
+        std::unique_ptr<std::string> manufacturer_ptr = util::sys_result("ioreg -rd1 -c manufacturer");
+        std::unique_ptr<std::string> keyboard_ptr = util::sys_result("ioreg -lw0 -p IODeviceTree");
+
+        const std::string platform = *platform_ptr;
+        const std::string board = *board_ptr;
+        const std::string manufacturer = *manufacturer_ptr;
+        const std::string keyboard = *keyboard_ptr;
+
+        auto check_platform = [&]() -> bool {
+            debug("IO_KIT: ", "platform = ", platform);
+
+            if (platform.empty()) {
+                return false;
+            }
+
+            for (const char c : platform) {
+                if (!std::isdigit(c)) {
+                    return false;
+                }
+            }
+
+            return (platform == "0");
+        };
+
+        auto check_board = [&]() -> bool {
+            debug("IO_KIT: ", "board = ", board);
+
+            if (board.empty()) {
+                return false;
+            }
+
+            if (util::find(board, "Mac")) {
+                return false;
+            }
+
+            if (util::find(board, "VirtualBox")) {
+                return core::add(brand_enum::VBOX);
+            }
+
+            if (util::find(board, "VMware")) {
+                return core::add(brand_enum::VMWARE);
+            }
+
+            return false;
+        };
+
+        auto check_manufacturer = [&]() -> bool {
+            debug("IO_KIT: ", "manufacturer = ", manufacturer);
+
+            if (manufacturer.empty()) {
+                return false;
+            }
+
+            if (util::find(manufacturer, "Apple")) {
+                return false;
+            }
+
+            if (util::find(manufacturer, "innotek")) {
+                return core::add(brand_enum::VBOX);
+            }
+
+            return false;
+        };
+
+        auto check_keyboard = [&]() -> bool {
+            debug("IO_KIT: ", "keyboard = ", keyboard);
+
+            if (keyboard.empty()) {
+                return false;
+            }
+
+            if (util::find(keyboard, "Virtual Machine")) {
+                return true;
+            }
+
+            return false;
+        };
+
+        return (
+            check_platform() ||
+            check_board() ||
+            check_manufacturer() ||
+            check_keyboard()
+       );
+    }
+
+
+    /**
+     * @brief Check for VM-strings in ioreg commands for MacOS
+     * @category MacOS
+     * @link https://evasions.checkpoint.com/src/MacOS/macos.html
+     * @implements VM::IOREG_GREP
+     */
+    [[nodiscard]] static bool ioreg_grep() {
+        auto check_usb = []() -> bool {
+            std::unique_ptr<std::string> result = util::sys_result("ioreg -rd1 -c IOUSBHostDevice | grep \"USB Vendor Name\"");
+            const std::string usb = *result;
+
+            if (util::find(usb, "Apple")) {
+                return false;
+            }
+
+            if (util::find(usb, "VirtualBox")) {
+                return core::add(brand_enum::VBOX);
+            }
+
+            return false;
+        };
+
+        auto check_rom = []() -> bool {
+            std::unique_ptr<std::string> sys_rom = util::sys_result("system_profiler SPHardwareDataType | grep \"Boot ROM Version\"");
+            const std::string rom = *sys_rom;
+
+            if (util::find(rom, "VirtualBox")) {
+                return core::add(brand_enum::VBOX);
+            }
+
+            return false;
+        };
+
+        return (
+            check_usb() ||
+            check_rom()
+        );
+    }
+
+
+    /**
+     * @brief Check for the status of System Integrity Protection and hv_mm_present
+     * @category MacOS
+     * @link https://evasions.checkpoint.com/src/MacOS/macos.html
+     * @implements VM::MAC_SIP
+     */
+    [[nodiscard]] static bool mac_sip() {
+        int hv_present = 0;
+        std::size_t size = sizeof(hv_present);
+        if (sysctlbyname("kern.hv_vmm_present",
+            &hv_present,
+            &size,
+            nullptr,
+            0) != 0) {
+            return false;
+        }
+
+        if (hv_present != 0) {
+            return true;
+        }
+
+        std::unique_ptr<std::string> result = util::sys_result("csrutil status");
+
+        if (!result) {
+            return false;
+        }
+
+        std::string tmp = *result;
+
+        auto pos = tmp.find('\n');
+
+        if (pos != std::string::npos) {
+            tmp.resize(pos);
+        }
+
+        debug("MAC_SIP: ", "result = ", tmp);
+
+        if (util::find(tmp, "unknown")) {
+            return false;
+        }
+
+        return (util::find(tmp, "disabled"));
+    }
+
+
+    /**
+     * @brief Check for VM-strings in system profiler commands for MacOS
+     * @category MacOS
+     * @implements VM::MAC_SYS
+     */
+    [[nodiscard]] static bool mac_sys() {
+        const char* keyword = "virtual machine";
+
+        if (std::unique_ptr<std::string> profiler_res_ptr = util::sys_result("system_profiler SPHardwareDataType")) {
+            std::string& output = *profiler_res_ptr;
+
+            std::transform(output.begin(), output.end(), output.begin(),
+                [](u8 c) { return std::tolower(c); });
+
+            if (util::find(output, keyword)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+#endif
+
+#if (MSVC)
+    #pragma endregion
+#endif
+
+#if (MSVC)
+    #pragma region "Windows"
+#endif
+
+#if (WINDOWS)
+    /**
+     * @brief Check for VM-specific DLLs
+     * @category Windows
+     * @implements VM::DLL
+     */
+    [[nodiscard]] static bool dll() {
+        static constexpr struct {
+            const char* dll_name;
+            enum brand_enum brand;
+        } dlls[] = {
+            {"sbiedll.dll",   brand_enum::SANDBOXIE},
+            {"pstorec.dll",   brand_enum::CWSANDBOX},
+            {"vmcheck.dll",   brand_enum::VPC},
+            {"cmdvrt32.dll",  brand_enum::COMODO},
+            {"cmdvrt64.dll",  brand_enum::COMODO},
+            {"cuckoomon.dll", brand_enum::CUCKOO},
+            {"SxIn.dll",      brand_enum::QIHOO},
+            {"wpespy.dll",    brand_enum::NULL_BRAND}
+        };
+
+        for (const auto& x : dlls) {
+            if (GetModuleHandleA(x.dll_name) != nullptr) {
+                debug("DLL: Found ", x.dll_name, " (", brands::brand_enum_to_string(x.brand), ")");
+                return core::add(x.brand);
+            }
+        }
+
+        return false;
+    }
+
+             
+    /**
+     * @brief Check if the function "wine_get_unix_file_name" is present and if the OS booted from a VHD container
+     * @category Windows
+     * @implements VM::WINE_FUNC
+     */
+    [[nodiscard]] static bool wine() {
+        #if (_WIN32_WINNT < _WIN32_WINNT_WIN8)
+            return false;
+        #else
+            __try {
+                BOOL isNativeVhdBoot = 0;
+                // we dont call NtQuerySystemInformation with SystemPrefetchPathInformation | SystemHandleInformation
+                // the point is to check if this kernel32.dll function throws an exception
+                IsNativeVhdBoot(&isNativeVhdBoot);
+                VMAWARE_UNUSED(isNativeVhdBoot);
+            }
+            __except (EXCEPTION_EXECUTE_HANDLER) {
+                debug("WINE: SEH invoked");
+                return true;
+            }
+        #endif
+
+        return false;
+    }
+                
+                
+    /**
+     * @brief Check what power states are enabled
+     * @category Windows
+     * @implements VM::POWER_CAPABILITIES
+     */
+    [[nodiscard]] static bool power_capabilities() {
+        const HMODULE ntdll = util::get_ntdll();
+
+        const char* names[] = { "NtPowerInformation" }; // Win8
+        void* funcs[ARRAYSIZE(names)] = {};
+        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+
+        if (!funcs[0]) return false;
+
+        using NtPI_t = NTSTATUS(__stdcall*)(POWER_INFORMATION_LEVEL,
+            PVOID, ULONG,
+            PVOID, ULONG);
+        const auto nt_power_information = reinterpret_cast<NtPI_t>(funcs[0]);
+
+        SYSTEM_POWER_CAPABILITIES caps{};
+        const NTSTATUS status = nt_power_information(
+            SystemPowerCapabilities,
+            nullptr, 0,
+            &caps, sizeof(caps)
+        );
+        if (status != 0) return false;
+
+        const bool s0_supported = caps.AoAc;
+        const bool s1_supported = caps.SystemS1;
+        const bool s2_supported = caps.SystemS2;
+        const bool s3_supported = caps.SystemS3;
+        const bool s4_supported = caps.SystemS4;
+        const bool hiber_file_present = caps.HiberFilePresent;
+
+        const bool is_physical_pattern = (s0_supported || s3_supported) &&
+            (s4_supported || hiber_file_present);
+
+        if (is_physical_pattern) {
+            return false;
+        }
+
+        const bool is_vm_pattern = !(s0_supported || s3_supported || s4_supported || hiber_file_present) &&
+            (s1_supported || s2_supported);
+
+        if (is_vm_pattern) {
+            debug("POWER_CAPABILITIES: Detected !(S0||S3||S4||HiberFilePresent) + S1|S2 pattern");
+            return true;
+        }
+
+        // could check for HKLM\SYSTEM\CurrentControlSet\Control\Power\PlatformAoAcOverride
+        const bool no_sleep_states = !s0_supported && !s1_supported && !s2_supported && !s3_supported && !s4_supported && !hiber_file_present;
+        if (no_sleep_states) {
+            debug("POWER_CAPABILITIES: Detected !(S0||S1||S2||S3||S4||H) pattern");
+            return true;
+        }
+
+        return (caps.ThermalControl == 0);
+    }
+
+
+    /**
+     * @brief Check for Gamarue ransomware technique which compares VM-specific Window product IDs
+     * @category Windows
+     * @implements VM::GAMARUE
+     */
+    [[nodiscard]] static bool gamarue() {
+        const HMODULE ntdll = util::get_ntdll();
+        if (!ntdll) return false;
+
+        const char* names[] = { "NtOpenKey", "NtQueryValueKey", "RtlInitUnicodeString", "NtClose" };
+        void* funcs[ARRAYSIZE(names)] = {};
+        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+
+        const auto nt_open_key = reinterpret_cast<NTSTATUS(__stdcall*)(PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES)>(funcs[0]);
+        const auto nt_query_value_key = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PUNICODE_STRING, ULONG, PVOID, ULONG, PULONG)>(funcs[1]);
+        const auto rtl_init_unicode_string = reinterpret_cast<void(__stdcall*)(PUNICODE_STRING, PCWSTR)>(funcs[2]);
+        const auto nt_close = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE)>(funcs[3]);
+
+        if (!nt_open_key || !nt_query_value_key || !rtl_init_unicode_string || !nt_close) 
+            return false;
+
+        // We use native unicode strings and object attributes to interface directly with the kernel
+        UNICODE_STRING key_name;
+        rtl_init_unicode_string(&key_name, L"\\Registry\\Machine\\Software\\Microsoft\\Windows NT\\CurrentVersion");
+
+        OBJECT_ATTRIBUTES object_attributes;
+        ZeroMemory(&object_attributes, sizeof(object_attributes));
+        object_attributes.Length = sizeof(object_attributes);
+        object_attributes.ObjectName = &key_name;
+        object_attributes.Attributes = OBJ_CASE_INSENSITIVE;
+
+        // Open the registry key with minimal permissions (query only)
+        HANDLE key = nullptr;
+        constexpr ACCESS_MASK KEY_QUERY_ONLY = 0x0001; // KEY_QUERY_VALUE
+        NTSTATUS st = nt_open_key(&key, KEY_QUERY_ONLY, &object_attributes);
+        if (!NT_SUCCESS(st) || !key) {
+            return false;
+        }
+
+        // We specifically want the "ProductId". Automated malware analysis sandboxes often
+        // neglect to randomize this value, thats why we flag it
+        UNICODE_STRING value_name;
+        rtl_init_unicode_string(&value_name, L"ProductId");
+
+        // Buffer for KEY_VALUE_PARTIAL_INFORMATION
+        BYTE buffer[128]{};
+        ULONG result_length = 0;
+        constexpr ULONG key_value_partial_information = 2;
+
+        st = nt_query_value_key(key, &value_name, key_value_partial_information, buffer, sizeof(buffer), &result_length);
+
+        nt_close(key);
+
+        if (!NT_SUCCESS(st)) {
+            return false;
+        }
+
+        // raw structure returned by the native API to manually parse the binary data
+        struct KEY_VALUE_PARTIAL_INFORMATION_LOCAL {
+            ULONG TitleIndex;
+            ULONG Type;
+            ULONG DataLength;
+            BYTE Data[1];
+        };
+
+        if (result_length < offsetof(KEY_VALUE_PARTIAL_INFORMATION_LOCAL, Data) + 1) {
+            return false;
+        }
+
+        // Safely extract the ProductId string from the raw byte buffer, ensuring we don't 
+        // buffer overflow if the registry returns garbage data
+        const auto* kv = reinterpret_cast<KEY_VALUE_PARTIAL_INFORMATION_LOCAL*>(buffer);
+        const ULONG data_length = kv->DataLength;
+        if (data_length == 0 || data_length >= sizeof(buffer)) return false;
+
+        char product_id[64] = { 0 };
+        const size_t copyLen = (data_length < (sizeof(product_id) - 1)) ? data_length : (sizeof(product_id) - 1);
+        memcpy(product_id, kv->Data, copyLen);
+        product_id[copyLen] = '\0';
+
+        // A list of known "dirty" Product IDs associated with public malware analysis sandboxes
+        struct target_pattern {
+            const char* product_id;
+            enum brand_enum brand;
+        };
+
+        constexpr target_pattern targets[] = {
+            {"55274-640-2673064-23950", brand_enum::JOEBOX},   
+            {"76487-644-3177037-23510", brand_enum::CWSANDBOX}, 
+            {"76487-337-8429955-22614", brand_enum::ANUBIS}     
+        };
+
+        constexpr size_t target_length = 21;
+
+        if (strlen(product_id) != target_length) return false;
+
+        // compare the current system's ProductId against the blacklist
+        // if a match is found, we identify the specific sandbox environment and flag it
+        for (const auto& target : targets) {
+            if (memcmp(product_id, target.product_id, target_length) == 0) {
+                debug("GAMARUE: Detected ", target.product_id);
+                return core::add(target.brand);
+            }
+        }
+
+        return false;
+    }
+ 
+
+    /**
+     * @brief Check for official VPC method
+     * @category Windows, x86_32
+     * @implements VM::VPC_INVALID
+     */
+    [[nodiscard]] static bool vpc_invalid() {
+        bool rc = false;
+    #if (x86_32 && !CLANG)
+
+        auto is_inside_vpc = [](PEXCEPTION_POINTERS ep) noexcept -> DWORD {
+            PCONTEXT ctx = ep->ContextRecord;
+
+            ctx->Ebx = static_cast<DWORD>(-1); // Not running VPC
+            ctx->Eip += 4; // skip past the "call VPC" opcodes
+            return static_cast<DWORD>(EXCEPTION_CONTINUE_EXECUTION);
+            // we can safely resume execution since we skipped faulty instruction
+        };
+
+        __try {
+            __asm {
+                push eax
+                push ebx
+                push ecx
+                push edx
+
+                mov ebx, 0h
+                mov eax, 01h
+
+                __emit 0Fh
+                __emit 3Fh
+                __emit 07h
+                __emit 0Bh
+
+                test ebx, ebx
+                setz[rc]
+
+                pop edx
+                pop ecx
+                pop ebx
+                pop eax
+            }
+        }
+        __except (is_inside_vpc(GetExceptionInformation())) {
+            rc = false;
+        }
+    #endif
+        return rc;
+    }
+
+
+    /**
+     * @brief Check str assembly instruction method for VMware
+     * @author Alfredo Omella's (S21sec) STR technique, paper describing this technique is located in /papers/
+     * @category Windows, x86_32
+     * @implements VM::VMWARE_STR
+     */
+    [[nodiscard]] static bool vmware_str() {
+    #if (x86_32)
+        u16 tr = 0;
+        __asm {
+            str ax
+            mov tr, ax
+        }
+        if ((tr & 0xFF) == 0x00 && ((tr >> 8) & 0xFF) == 0x40) {
+            return core::add(brand_enum::VMWARE);
+        }
+
+        return false;
+    #else
+        return false;
+    #endif
+    }
+
+
+    /**
+     * @brief Check for official VMware io port backdoor technique
+     * @category Windows, x86_32
+     * @author Code from ScoopyNG by Tobias Klein, technique founded by Ken Kato
+     * @copyright BSD clause 2
+     * @implements VM::VMWARE_BACKDOOR
+     */
+    [[nodiscard]] static bool vmware_backdoor() {
+        bool is_vm = false;
+    #if (x86_32 && !CLANG)
+        u32 a = 0;
+        u32 b = 0;
+
+        constexpr std::array<i16, 2> ioports = { { 'VX' , 'VY' } };
+        i16 ioport;
+
+        for (u8 i = 0; i < ioports.size(); ++i) {
+            ioport = ioports[i];
+            for (u8 cmd = 0; cmd < 0x2c; ++cmd) {
+                __try {
+                    __asm {
+                        push eax
+                        push ebx
+                        push ecx
+                        push edx
+
+                        mov eax, 'VMXh'
+                        movzx ecx, cmd
+                        mov dx, ioport
+                        in eax, dx      // <- key point is here
+
+                        mov a, ebx
+                        mov b, ecx
+
+                        pop edx
+                        pop ecx
+                        pop ebx
+                        pop eax
+                    }
+
+                    is_vm = true;
+                    break;
+                }
+                __except (EXCEPTION_EXECUTE_HANDLER) {}
+            }
+        }
+
+        if (is_vm) {
+            switch (b) {
+                case 1:  return core::add(brand_enum::VMWARE_EXPRESS);
+                case 2:  return core::add(brand_enum::VMWARE_ESX);
+                case 3:  return core::add(brand_enum::VMWARE_GSX);
+                case 4:  return core::add(brand_enum::VMWARE_WORKSTATION);
+                default: return core::add(brand_enum::VMWARE);
+            }
+        }
+    #endif
+        return is_vm;
+    }
+
+
+    /**
+     * @brief Check for mutex strings of VM brands
+     * @category Windows
+     * @author from VMDE project
+     * @author hfiref0x
+     * @implements VM::MUTEX
+     */
+    [[nodiscard]] static bool mutex() {
+        const HMODULE ntdll = util::get_ntdll();
+        if (!ntdll) return false;
+
+        using RtlInitUnicodeString_t = void(__stdcall*)(PUNICODE_STRING DestinationString, PCWSTR SourceString);
+        using NtClose_t = NTSTATUS(__stdcall*)(HANDLE Handle);
+        using NtOpenMutant_t = NTSTATUS(__stdcall*)(PHANDLE MutantHandle, ACCESS_MASK DesiredAccess, POBJECT_ATTRIBUTES ObjectAttributes);
+
+        const char* names[] = { "NtOpenMutant", "RtlInitUnicodeString", "NtClose" };
+        void* funcs[ARRAYSIZE(names)] = {};
+        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+
+        const auto nt_open_mutant = reinterpret_cast<NtOpenMutant_t>(funcs[0]);
+        const auto rtl_init_unicode_string = reinterpret_cast<RtlInitUnicodeString_t>(funcs[1]);
+        const auto nt_close = reinterpret_cast<NtClose_t>(funcs[2]);
+
+        if (!nt_open_mutant || !rtl_init_unicode_string || !nt_close) {
+            return false;
+        }
+
+        auto try_mutex_name = [&](const wchar_t* base_name) noexcept -> bool {
+            constexpr wchar_t prefix[] = L"\\BaseNamedObjects\\";
+            constexpr size_t prefix_len = (sizeof(prefix) / sizeof(wchar_t)) - 1;
+
+            wchar_t full_path[260];
+
+            // memcpy as it is faster than wcscpy/wcscat
+            memcpy(full_path, prefix, sizeof(prefix)); 
+
+            const size_t name_len = wcslen(base_name);
+            if (prefix_len + name_len < 260) {
+                memcpy(full_path + prefix_len, base_name, (name_len + 1) * sizeof(wchar_t));
+            }
+            else {
+                // should not happen for standard VM artifacts
+                full_path[0] = L'\0';
+            }
+
+            const wchar_t* attempts[] = { full_path, base_name };
+
+            for (const wchar_t* path : attempts) {
+                if (*path == L'\0') continue;
+
+                UNICODE_STRING u_name;
+                rtl_init_unicode_string(&u_name, path);
+
+                OBJECT_ATTRIBUTES obj_attr;
+                memset(&obj_attr, 0, sizeof(obj_attr));
+                obj_attr.Length = sizeof(obj_attr);
+                obj_attr.ObjectName = &u_name;
+                obj_attr.Attributes = OBJ_CASE_INSENSITIVE;
+
+                HANDLE h_mutant = nullptr;
+                const NTSTATUS st = nt_open_mutant(&h_mutant, MUTANT_QUERY_STATE, &obj_attr);
+
+                if (NT_SUCCESS(st)) {
+                    if (h_mutant) nt_close(h_mutant);
+                    return true;
+                }
+            }
+
+            return false;
+        };
+
+        if (try_mutex_name(L"Sandboxie_SingleInstanceMutex_Control") ||
+            try_mutex_name(L"SBIE_BOXED_ServiceInitComplete_Mutex1")) {
+            debug("MUTEX: Detected Sandboxie");
+            return core::add(brand_enum::SANDBOXIE);
+        }
+
+        if (try_mutex_name(L"MicrosoftVirtualPC7UserServiceMakeSureWe'reTheOnlyOneMutex")) {
+            debug("MUTEX: Detected VPC");
+            return core::add(brand_enum::VPC);
+        }
+
+        return false;
+    }
+
+
+    /**
+     * @brief Check for cuckoo directory using crt and WIN API directory functions
+     * @category Windows
+     * @author 一半人生
+     * @link https://unprotect.it/snippet/checking-specific-folder-name/196/
+     * @implements VM::CUCKOO_DIR
+     */
+    [[nodiscard]] static bool cuckoo_dir() {
+        using NtOpenFile_t = NTSTATUS(__stdcall*)(PHANDLE FileHandle, ACCESS_MASK DesiredAccess,
+            POBJECT_ATTRIBUTES ObjectAttributes, PIO_STATUS_BLOCK IoStatusBlock,
+            ULONG ShareAccess, ULONG OpenOptions);
+        using RtlInitUnicodeString_t = void(__stdcall*)(PUNICODE_STRING DestinationString, PCWSTR SourceString);
+        using NtClose_t = NTSTATUS(__stdcall*)(HANDLE Handle);
+
+        const HMODULE ntdll = util::get_ntdll();
+        if (!ntdll) return false;
+
+        const char* names[] = { "NtOpenFile", "RtlInitUnicodeString", "NtClose" };
+        void* funcs[ARRAYSIZE(names)] = {};
+        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+
+        const auto nt_open_file = reinterpret_cast<NtOpenFile_t>(funcs[0]);
+        const auto rtl_init_unicode_string = reinterpret_cast<RtlInitUnicodeString_t>(funcs[1]);
+        const auto nt_close = reinterpret_cast<NtClose_t>(funcs[2]);
+
+        if (!nt_open_file || !rtl_init_unicode_string || !nt_close) {
+            return false;
+        }
+
+        const wchar_t* native_path = L"\\??\\C:\\Cuckoo";
+        UNICODE_STRING path;
+        rtl_init_unicode_string(&path, native_path);
+
+        OBJECT_ATTRIBUTES object_attributes;
+        ZeroMemory(&object_attributes, sizeof(object_attributes));
+        object_attributes.Length = sizeof(object_attributes);
+        object_attributes.ObjectName = &path;
+        object_attributes.Attributes = OBJ_CASE_INSENSITIVE;
+
+        IO_STATUS_BLOCK iosb;
+        HANDLE hFile = nullptr;
+
+        constexpr ACCESS_MASK desired_access = FILE_READ_ATTRIBUTES; 
+        constexpr ULONG share_access = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
+        constexpr ULONG open_options = FILE_OPEN | FILE_SYNCHRONOUS_IO_NONALERT | FILE_DIRECTORY_FILE;
+
+        const NTSTATUS st = nt_open_file(&hFile, desired_access, &object_attributes, &iosb, share_access, open_options);
+        if (NT_SUCCESS(st)) {
+            if (hFile) nt_close(hFile);
+            return core::add(brand_enum::CUCKOO);
+        }
+
+        return false;
+    }
+                
+                
+    /**
+     * @brief Check for Cuckoo specific piping mechanism
+     * @category Windows
+     * @author Thomas Roccia (fr0gger)
+     * @link https://unprotect.it/snippet/checking-specific-folder-name/196/
+     * @implements VM::CUCKOO_PIPE
+     */
+    [[nodiscard]] static bool cuckoo_pipe() {
+        using NtOpenFile_t = NTSTATUS(__stdcall*)(PHANDLE FileHandle, ACCESS_MASK DesiredAccess,
+            POBJECT_ATTRIBUTES ObjectAttributes, PIO_STATUS_BLOCK IoStatusBlock,
+            ULONG ShareAccess, ULONG OpenOptions);
+        using RtlInitUnicodeString_t = void(__stdcall*)(PUNICODE_STRING DestinationString, PCWSTR SourceString);
+        using NtClose_t = NTSTATUS(__stdcall*)(HANDLE Handle);
+
+        const HMODULE ntdll = util::get_ntdll();
+        if (!ntdll) return false;
+
+        const char* names[] = { "NtOpenFile", "RtlInitUnicodeString", "NtClose" };
+        void* funcs[ARRAYSIZE(names)] = {};
+        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+
+        const auto nt_open_file = reinterpret_cast<NtOpenFile_t>(funcs[0]);
+        const auto rtl_init_unicode_string = reinterpret_cast<RtlInitUnicodeString_t>(funcs[1]);
+        const auto nt_close = reinterpret_cast<NtClose_t>(funcs[2]);
+
+        if (!nt_open_file || !rtl_init_unicode_string || !nt_close) {
+            return false;
+        }
+
+        const wchar_t* pipe_path = L"\\??\\pipe\\cuckoo";
+        UNICODE_STRING pipe;
+        rtl_init_unicode_string(&pipe, pipe_path);
+
+        OBJECT_ATTRIBUTES object_attributes;
+        ZeroMemory(&object_attributes, sizeof(object_attributes));
+        object_attributes.Length = sizeof(object_attributes);
+        object_attributes.ObjectName = &pipe;
+        object_attributes.Attributes = OBJ_CASE_INSENSITIVE;
+
+        IO_STATUS_BLOCK iosb;
+        HANDLE h_pipe = nullptr;
+
+        constexpr ACCESS_MASK desired_access = FILE_READ_DATA | FILE_READ_ATTRIBUTES;
+        constexpr ULONG share_access = 0;
+        constexpr ULONG open_options = FILE_OPEN | FILE_SYNCHRONOUS_IO_NONALERT;
+
+        const NTSTATUS st = nt_open_file(&h_pipe, desired_access, &object_attributes, &iosb, share_access, open_options);
+        if (NT_SUCCESS(st)) {
+            if (h_pipe) nt_close(h_pipe);
+            return core::add(brand_enum::CUCKOO);
+        }
+
+        return false;
+    }
+
+
+    /**
+     * @brief Check for display configurations commonly found in VMs
+     * @category Windows
+     * @implements VM::DISPLAY
+     */
+    [[nodiscard]] static bool display() {
+        const HDC hdc = GetDC(nullptr);
+        const int bpp = GetDeviceCaps(hdc, BITSPIXEL) *
+            GetDeviceCaps(hdc, PLANES);
+        const int logpix = GetDeviceCaps(hdc, LOGPIXELSX);
+        ReleaseDC(nullptr, hdc);
+
+        // physical monitors are almost always 32bpp and 96–144 DPI
+        if (bpp != 32 || logpix < 90)
+            return true;
+
+        return false;
+    }
+
+
+    /**
+     * @brief Check for VM-specific names for drivers
+     * @category Windows
+     * @implements VM::DRIVERS
+     */
+    [[nodiscard]] static bool drivers() {
+        struct _SYSTEM_MODULE_INFORMATION {
+            PVOID  Reserved[2];
+            PVOID  ImageBaseAddress;
+            ULONG  ImageSize;
+            ULONG  Flags;
+            USHORT Index;
+            USHORT NameLength;
+            USHORT LoadCount;
+            USHORT PathLength;
+            CHAR   ImageName[256];
+        };
+
+        struct _SYSTEM_MODULE_INFORMATION_EX {
+            ULONG  NumberOfModules;
+            _SYSTEM_MODULE_INFORMATION Module[1];
+        };
+
+        using SYSTEM_MODULE_INFORMATION = _SYSTEM_MODULE_INFORMATION;
+        using PSYSTEM_MODULE_INFORMATION = _SYSTEM_MODULE_INFORMATION*;
+        using SYSTEM_MODULE_INFORMATION_EX = _SYSTEM_MODULE_INFORMATION_EX;
+        using PSYSTEM_MODULE_INFORMATION_EX = _SYSTEM_MODULE_INFORMATION_EX*;
+
+        using NtQuerySystemInformationFn = NTSTATUS(__stdcall*)(ULONG SystemInformationClass, PVOID SystemInformation, ULONG SystemInformationLength, PULONG ReturnLength);
+        using NtAllocateVirtualMemoryFn = NTSTATUS(__stdcall*)(
+            HANDLE ProcessHandle,
+            PVOID* BaseAddress,
+            ULONG_PTR ZeroBits,
+            PSIZE_T RegionSize,
+            ULONG AllocationType,
+            ULONG Protect
+        );
+        using NtFreeVirtualMemoryFn = NTSTATUS(__stdcall*)(HANDLE ProcessHandle, PVOID* BaseAddress, PSIZE_T RegionSize, ULONG FreeType);
+
+        constexpr ULONG system_module_information = 11;
+        const HMODULE ntdll = util::get_ntdll();
+        if (!ntdll) return false;
+
+        const char* names[] = { "NtQuerySystemInformation", "NtAllocateVirtualMemory", "NtFreeVirtualMemory" };
+        void* funcs[ARRAYSIZE(names)] = {};
+        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+
+        const auto nt_query_system_information = reinterpret_cast<NtQuerySystemInformationFn>(funcs[0]);
+        const auto nt_allocate_virtual_memory = reinterpret_cast<NtAllocateVirtualMemoryFn>(funcs[1]);
+        const auto nt_free_virtual_memory = reinterpret_cast<NtFreeVirtualMemoryFn>(funcs[2]);
+
+        if (nt_query_system_information == nullptr || nt_allocate_virtual_memory == nullptr || nt_free_virtual_memory == nullptr)
+            return false;
+        
+        ULONG ul_size = 0;
+        NTSTATUS status = nt_query_system_information(system_module_information, nullptr, 0, &ul_size);
+        if (status != ((NTSTATUS)0xC0000004L)) return false;
+
+        const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
+        PVOID allocated_memory = nullptr;
+        SIZE_T region_size = ul_size;
+        nt_allocate_virtual_memory(current_process, &allocated_memory, 0, &region_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+
+        const auto system_module_info_ex = reinterpret_cast<PSYSTEM_MODULE_INFORMATION_EX>(allocated_memory);
+        status = nt_query_system_information(system_module_information, system_module_info_ex, ul_size, &ul_size);
+        if (!(((NTSTATUS)(status)) >= 0)) {
+            region_size = 0;
+            nt_free_virtual_memory(current_process, &allocated_memory, &region_size, MEM_RELEASE);
+            return false;
+        }
+
+        for (ULONG i = 0; i < system_module_info_ex->NumberOfModules; ++i) {
+            const char* driverPath = reinterpret_cast<const char*>(system_module_info_ex->Module[i].ImageName);
+            if (
+                strstr(driverPath, "VBoxGuest") || // only installed after vbox guest additions
+                strstr(driverPath, "VBoxMouse") ||
+                strstr(driverPath, "VBoxSF")
+            ) {
+                debug("DRIVERS: Detected VBox driver: ", driverPath);
+                region_size = 0;
+                nt_free_virtual_memory(current_process, &allocated_memory, &region_size, MEM_RELEASE);
+                return core::add(brand_enum::VBOX);
+            }
+
+            if (
+                strstr(driverPath, "vmusbmouse") ||
+                strstr(driverPath, "vmmouse") ||
+                strstr(driverPath, "vmmemctl")
+            ) {
+                debug("DRIVERS: Detected VMware driver: ", driverPath);
+                region_size = 0;
+                nt_free_virtual_memory(current_process, &allocated_memory, &region_size, MEM_RELEASE);
+                return core::add(brand_enum::VMWARE);
+            }
+        }
+
+        SIZE_T free_size = 0;
+        nt_free_virtual_memory(current_process, &allocated_memory, &free_size, MEM_RELEASE);
+        return false;
+    }
+
+
+
+    /**
+     * @brief Check for IVSHMEM device presence
+     * @category Windows
+     * @author dmfrpro (https://github.com/dmfrpro)
+     * @implements VM::IVSHMEM
+     */
+    [[nodiscard]] static bool ivshmem() {
+        typedef struct _KEY_FULL_INFORMATION {
+            LARGE_INTEGER LastWriteTime;
+            ULONG         TitleIndex;
+            ULONG         ClassOffset;
+            ULONG         ClassLength;
+            ULONG         SubKeys;
+            ULONG         MaxNameLen;
+            ULONG         MaxClassLen;
+            ULONG         Values;
+            ULONG         MaxValueNameLen;
+            ULONG         MaxValueDataLen;
+            WCHAR         Class[1];
+        } KEY_FULL_INFORMATION, * PKEY_FULL_INFORMATION;
+
+        typedef enum _KEY_INFORMATION_CLASS {
+            KeyBasicInformation,
+            KeyNodeInformation,
+            KeyFullInformation,
+            KeyNameInformation,
+            KeyCachedInformation,
+            KeyFlagsInformation,
+            KeyVirtualizationInformation,
+            KeyHandleTagsInformation,
+            KeyTrustInformation,
+            KeyLayerInformation,
+            MaxKeyInfoClass
+        } KEY_INFORMATION_CLASS;
+
+        const HMODULE ntdll = util::get_ntdll();
+        if (!ntdll) return false;
+
+        const char* names[] = { "RtlInitUnicodeString", "NtOpenKey", "NtQueryKey", "NtClose" };
+        void* funcs[ARRAYSIZE(names)] = {};
+        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+
+        const auto rtl_init_unicode_string = reinterpret_cast<void(__stdcall*)(PUNICODE_STRING, PCWSTR)>(funcs[0]);
+        const auto nt_open_key = reinterpret_cast<NTSTATUS(__stdcall*)(PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES)>(funcs[1]);
+        const auto nt_query_key = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, KEY_INFORMATION_CLASS, PVOID, ULONG, PULONG)>(funcs[2]);
+        const auto nt_close = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE)>(funcs[3]);
+
+        if (!rtl_init_unicode_string || !nt_open_key || !nt_query_key || !nt_close) {
+            return false;
+        }
+
+        // Targeted GUID for IVSHMEM (Inter-VM Shared Memory).
+        // This device is typically used in KVM/QEMU environments (like Looking Glass) to pass memory between host and guest
+        constexpr GUID GUID_IVSHMEM_IFACE =
+        { 0xdf576976, 0x569d, 0x4672, { 0x95, 0xa0, 0xf5, 0x7e, 0x4e, 0xa0, 0xb2, 0x10 } };
+
+        // Construct the registry path for the DeviceClasses key
+        // We access the "DeviceClasses" registry hive directly to find hardware interfaces
+        wchar_t interface_class_path[256];
+        swprintf_s(
+            interface_class_path,
+            ARRAYSIZE(interface_class_path),
+            L"\\Registry\\Machine\\SYSTEM\\CurrentControlSet\\Control\\DeviceClasses\\{%08lX-%04hX-%04hX-%02hhX%02hhX-%02hhX%02hhX%02hhX%02hhX%02hhX%02hhX}",
+            GUID_IVSHMEM_IFACE.Data1, GUID_IVSHMEM_IFACE.Data2, GUID_IVSHMEM_IFACE.Data3,
+            GUID_IVSHMEM_IFACE.Data4[0], GUID_IVSHMEM_IFACE.Data4[1], GUID_IVSHMEM_IFACE.Data4[2],
+            GUID_IVSHMEM_IFACE.Data4[3], GUID_IVSHMEM_IFACE.Data4[4], GUID_IVSHMEM_IFACE.Data4[5],
+            GUID_IVSHMEM_IFACE.Data4[6], GUID_IVSHMEM_IFACE.Data4[7]
+        );
+
+        UNICODE_STRING unicode_path;
+        rtl_init_unicode_string(&unicode_path, interface_class_path);
+
+        OBJECT_ATTRIBUTES object_attributes;
+        RtlZeroMemory(&object_attributes, sizeof(object_attributes));
+        object_attributes.Length = sizeof(object_attributes);
+        object_attributes.ObjectName = &unicode_path;
+        object_attributes.Attributes = OBJ_CASE_INSENSITIVE;
+
+        HANDLE key = nullptr;
+        NTSTATUS st = nt_open_key(&key, KEY_READ, &object_attributes);
+        if (!NT_SUCCESS(st) || key == nullptr) {
+            return false;
+        }
+
+        // We query the "Full Information" of the key to get the count of subkeys
+        // The existence of the class key alone isn't enough cuz Windows might register the class but have no devices
+        // If SubKeys > 0, it means actual device instances (for ex. PCI devices) are registered under this interface
+        BYTE info_buffer[512] = {};
+        ULONG returned_len = 0;
+        st = nt_query_key(key, KeyFullInformation, info_buffer, sizeof(info_buffer), &returned_len);
+
+        DWORD number_of_subkeys = 0;
+        if (NT_SUCCESS(st) && returned_len >= sizeof(KEY_FULL_INFORMATION)) {
+            auto* kfi = reinterpret_cast<KEY_FULL_INFORMATION*>(info_buffer);
+            number_of_subkeys = static_cast<DWORD>(kfi->SubKeys);
+        }
+        else {
+            nt_close(key);
+            return false;
+        }
+
+        nt_close(key);
+
+        return number_of_subkeys > 0;
+    }
+
+
+    /**
+     * @brief Check for GPU capabilities related to VMs
+     * @category Windows
+     * @implements VM::GPU_CAPABILITIES
+     */
+    [[nodiscard]] static bool gpu_capabilities() {
+        /*
+            Microsoft::WRL::ComPtr<IDirect3D9> d3d9 {
+                Direct3DCreate9(D3D_SDK_VERSION)
+            };
+
+            if (!d3d9) {
+                debug("GPU_CAPABILITIES: Direct3DCreate9 failed");
+                return true;
+            }
+
+            D3DCAPS9 caps;
+            if (FAILED(d3d9->GetDeviceCaps(D3DADAPTER_DEFAULT, D3DDEVTYPE_HAL, &caps))) {
+                debug("GPU_CAPABILITIES: GetDeviceCaps failed");
+                return false;
+            }
+
+            // if the driver cannot adjust the display gamma ramp dynamically but only in full-screen mode—via the IDirect3DDevice9::SetGammaRamp API
+            return !(caps.Caps2 & D3DCAPS2_FULLSCREENGAMMA);
+        */
+
+        const HDC hdc = GetDC(nullptr);
+        if (!hdc) {
+            return true;
+        }
+
+        const int color_caps = GetDeviceCaps(hdc, COLORMGMTCAPS);
+        ReleaseDC(nullptr, hdc);
+
+        return !(color_caps & CM_GAMMA_RAMP) || color_caps == 0;
+    }
+
+
+    /**
+     * @brief Check for vm-specific devices
+     * @category Windows
+     * @implements VM::HANDLES
+     */
+    [[nodiscard]] static bool device_handles() {
+        const HMODULE ntdll = util::get_ntdll();
+        if (!ntdll) return false;
+
+        const char* names[] = { "RtlInitUnicodeString", "NtOpenFile", "NtClose" };
+        void* funcs[ARRAYSIZE(names)] = {};
+        util::get_function_address(ntdll, names, funcs, (ULONG)(sizeof(names) / sizeof(names[0])));
+
+        const auto rtl_init_unicode_string = reinterpret_cast<void(__stdcall*)(PUNICODE_STRING, PCWSTR)>(funcs[0]);
+        const auto nt_open_file = reinterpret_cast<NTSTATUS(__stdcall*)(PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES, PIO_STATUS_BLOCK, ULONG, ULONG)>(funcs[1]);
+        const auto nt_close = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE)>(funcs[2]);
+
+        if (!rtl_init_unicode_string || !nt_open_file || !nt_close) {
+            return false;
+        }
+
+        auto try_open_mutex = [&](const wchar_t* native_path) noexcept -> HANDLE {
+            UNICODE_STRING u_path{};
+            u_path.Buffer = const_cast<wchar_t*>(native_path);
+            const size_t len_bytes = wcslen(native_path) * sizeof(wchar_t);
+            u_path.Length = static_cast<USHORT>(len_bytes);
+            u_path.MaximumLength = static_cast<USHORT>(len_bytes + sizeof(wchar_t));
+
+            OBJECT_ATTRIBUTES obj_attr = {
+                sizeof(OBJECT_ATTRIBUTES),
+                nullptr,
+                &u_path,
+                OBJ_CASE_INSENSITIVE,
+                nullptr,
+                nullptr
+            };
+
+            IO_STATUS_BLOCK iosb;
+            HANDLE h_file = nullptr;
+
+            constexpr ACCESS_MASK desired_access = FILE_READ_DATA | FILE_READ_ATTRIBUTES | SYNCHRONIZE;
+            constexpr ULONG share_access = FILE_SHARE_READ;
+            constexpr ULONG open_options = FILE_OPEN | FILE_SYNCHRONOUS_IO_NONALERT;
+
+            const NTSTATUS st = nt_open_file(&h_file, desired_access, &obj_attr, &iosb, share_access, open_options);
+
+            if (NT_SUCCESS(st)) {
+                return h_file;
+            }
+            return INVALID_HANDLE_VALUE;
+        };
+
+        constexpr const wchar_t* paths[] = {
+            L"\\??\\VBoxMiniRdrDN",    // \\.\VBoxMiniRdrDN
+            L"\\??\\pipe\\VBoxMiniRdDN",// \\.\pipe\VBoxMiniRdDN
+            L"\\??\\VBoxTrayIPC",      // \\.\VBoxTrayIPC
+            L"\\??\\pipe\\VBoxTrayIPC",// \\.\pipe\VBoxTrayIPC
+            L"\\??\\HGFS",             // \\.\HGFS (VMware)
+            L"\\??\\pipe\\cuckoo"      // \\.\pipe\cuckoo (Cuckoo)
+        };
+
+        const size_t path_count = sizeof(paths) / sizeof(paths[0]);
+        HANDLE handles[sizeof(paths) / sizeof(paths[0])] = {};
+
+        for (size_t i = 0; i < path_count; ++i) {
+            handles[i] = try_open_mutex(paths[i]);
+        }
+
+        const bool vbox = (handles[0] != INVALID_HANDLE_VALUE) ||
+            (handles[1] != INVALID_HANDLE_VALUE) ||
+            (handles[2] != INVALID_HANDLE_VALUE) ||
+            (handles[3] != INVALID_HANDLE_VALUE);
+
+        const bool vmware = (handles[4] != INVALID_HANDLE_VALUE);
+        const bool cuckoo = (handles[5] != INVALID_HANDLE_VALUE);
+
+        for (size_t i = 0; i < path_count; ++i) {
+            if (handles[i] != INVALID_HANDLE_VALUE) {
+                (void)nt_close(handles[i]);
+                handles[i] = INVALID_HANDLE_VALUE;
+            }
+        }
+
+        if (vbox) {
+            debug("HANDLES: Detected VBox related device handles");
+            return core::add(brand_enum::VBOX);
+        }
+
+        if (vmware) {
+            debug("HANDLES: Detected VMware related device (HGFS)");
+            return core::add(brand_enum::VMWARE);
+        }
+
+        if (cuckoo) {
+            debug("HANDLES: Detected Cuckoo related device (pipe)");
+            return core::add(brand_enum::CUCKOO);
+        }
+
+        return false;
+    }
+
+
+    /**
+     * @brief Check if the number of virtual and logical processors are reported correctly by the system
+     * @category Windows, x86
+     * @implements VM::VIRTUAL_PROCESSORS
+     */
+    [[nodiscard]] static bool virtual_processors() {
+    #if (x86)
+        int regs[4];
+        __cpuid(regs, 0x40000000);
+
+        const u32 max_leaf = static_cast<u32>(regs[0]);
+        if (max_leaf < 0x40000005) {
+            return false;
+        }
+
+        __cpuid(regs, 0x40000005);
+        const u32 max_virtual_processors = static_cast<u32>(regs[0]);
+        const u32 max_logical_processors = static_cast<u32>(regs[1]);
+
+        debug("VIRTUAL_PROCESSORS: MaxVirtualProcessors -> ", max_virtual_processors,
+            ", MaxLogicalProcessors -> ", max_logical_processors);
+
+        if (max_virtual_processors == 0xFFFFFFFF || max_logical_processors == 0) {
+            return true;
+        }
+    #endif
+        return false;
+    }
+
+
+    /**
+     * @brief Check if a call to NtQuerySystemInformation with the 0x9f leaf fills a _SYSTEM_HYPERVISOR_DETAIL_INFORMATION structure
+     * @category Windows, x86_64
+     * @implements VM::HYPERVISOR_QUERY
+     */
+    [[nodiscard]] static bool hypervisor_query() {
+    #if (x86_64)
+        if (util::hyper_x() == HYPERV_ARTIFACT_VM) {
+            return false;
+        }
+
+        struct HV_DETAILS {
+            ULONG Data[4];
+        };
+        struct SYSTEM_HYPERVISOR_DETAIL_INFORMATION {
+            HV_DETAILS HvVendorAndMaxFunction;
+            HV_DETAILS HypervisorInterface;
+            HV_DETAILS HypervisorVersion;
+            HV_DETAILS HvFeatures;
+            HV_DETAILS HwFeatures;
+            HV_DETAILS EnlightenmentInfo;
+            HV_DETAILS ImplementationLimits;
+        };
+
+        using PHV_DETAILS = HV_DETAILS*;
+        using PSYSTEM_HYPERVISOR_DETAIL_INFORMATION = SYSTEM_HYPERVISOR_DETAIL_INFORMATION*;
+
+        using FN_NtQuerySystemInformation = NTSTATUS(__stdcall*)(
+            SYSTEM_INFORMATION_CLASS SystemInformationClass,
+            PVOID SystemInformation,
+            ULONG SystemInformationLength,
+            PULONG ReturnLength
+        );
+
+        const HMODULE ntdll = util::get_ntdll();
+        if (!ntdll) return false;        
+
+        const char* names[] = { "NtQuerySystemInformation" };
+        void* funcs[ARRAYSIZE(names)] = {};
+        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+
+        const FN_NtQuerySystemInformation nt_query_system_information = reinterpret_cast<FN_NtQuerySystemInformation>(funcs[0]);
+        if (nt_query_system_information) {
+            SYSTEM_HYPERVISOR_DETAIL_INFORMATION hypervisor_information{};
+
+            // Request class 0x9F (SystemHypervisorDetailInformation)
+            // This asks the OS kernel to fill the structure with information about the 
+            // hypervisor layer it is running on top of
+            const NTSTATUS status = nt_query_system_information(static_cast<SYSTEM_INFORMATION_CLASS>(0x9F), &hypervisor_information, sizeof(hypervisor_information), nullptr);
+
+            if (status != 0) {
+                return false;
+            }
+
+            // If Data[0] is non-zero, it means the kernel has successfully communicated 
+            // with a hypervisor and retrieved a vendor signature like "Micr" for Microsoft
+            if (hypervisor_information.HvVendorAndMaxFunction.Data[0] != 0) {
+                return true;
+            }
+        }
+    #endif
+        return false;
+    }
+
+    
+    /**
+     * @brief Check for particular object directory which is present in Sandboxie virtual environment but not in usual host systems
+     * @category Windows
+     * @link https://evasions.checkpoint.com/src/Evasions/techniques/global-os-objects.html
+     * @implements VM::VIRTUAL_REGISTRY
+     */
+    [[nodiscard]] static bool virtual_registry() {
+        struct UNICODE_STRING {
+            USHORT Length;
+            USHORT MaximumLength;
+            PWSTR  Buffer;
+        };
+        struct OBJECT_ATTRIBUTES {
+            ULONG Length;
+            HANDLE RootDirectory;
+            UNICODE_STRING* ObjectName;
+            ULONG Attributes;
+            PVOID SecurityDescriptor;
+            PVOID SecurityQualityOfService;
+        };
+        enum OBJECT_INFORMATION_CLASS {
+            ObjectBasicInformation = 0,
+            ObjectNameInformation = 1,
+            ObjectTypeInformation = 2
+        };
+        struct OBJECT_NAME_INFORMATION {
+            UNICODE_STRING Name;
+        };
+
+        using POBJECT_NAME_INFORMATION = OBJECT_NAME_INFORMATION*;
+        using PNtOpenKey = NTSTATUS(__stdcall*)(PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES );
+        using PNtQueryObject = NTSTATUS(__stdcall*)(HANDLE, OBJECT_INFORMATION_CLASS, PVOID, ULONG, PULONG);
+    
+        const HMODULE ntdll = util::get_ntdll();
+        if (!ntdll) return false;
+    
+        const char* names[] = { "NtOpenKey", "NtQueryObject", "NtClose" };
+        void* funcs[ARRAYSIZE(names)] = {};
+        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+    
+        const auto nt_open_key = reinterpret_cast<PNtOpenKey>(funcs[0]);
+        const auto nt_query_object = reinterpret_cast<PNtQueryObject>(funcs[1]);
+        const auto nt_close = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE)>(funcs[2]);
+
+        if (!nt_open_key || !nt_query_object || !nt_close)
+            return false;
+    
+        // Prepare to open the root USER registry hive
+        UNICODE_STRING key_path{};
+        key_path.Buffer = const_cast<PWSTR>(L"\\REGISTRY\\USER");
+        key_path.Length = static_cast<USHORT>(wcslen(key_path.Buffer) * sizeof(WCHAR));
+        key_path.MaximumLength = key_path.Length + sizeof(WCHAR);
+
+        OBJECT_ATTRIBUTES object_attributes = {
+            sizeof(OBJECT_ATTRIBUTES),
+            nullptr,
+            &key_path,
+            0x00000040L,  // OBJ_CASE_INSENSITIVE
+            nullptr,
+            nullptr
+        };
+
+        // Attempt to open the key. If we are sandboxed, this open call often succeeds,
+        // but the underlying handle will point to a virtualized container, not the real OS path
+        HANDLE key = nullptr;
+        NTSTATUS status = nt_open_key(&key, KEY_READ, reinterpret_cast<POBJECT_ATTRIBUTES>(&object_attributes));
+        if (!(((NTSTATUS)(status)) >= 0))
+            return false;
+
+        // Ask the kernel: "What is the actual name of the object this handle points to?"
+        // Sandboxie implements file system and registry virtualization by redirecting access
+        // While the API pretends we opened "\REGISTRY\USER", the handle might actually point to 
+        // something like "\Device\HarddiskVolume2\Sandbox\User\DefaultBox\RegHive"
+        alignas(16) BYTE buffer[1024]{};
+        ULONG returned_length = 0;
+        status = nt_query_object(key, ObjectNameInformation, buffer, sizeof(buffer), &returned_length);
+        nt_close(key);
+        if (!(((NTSTATUS)(status)) >= 0))
+            return false;
+
+        const auto object_name = reinterpret_cast<POBJECT_NAME_INFORMATION>(buffer);
+
+        UNICODE_STRING expected_name{};
+        expected_name.Buffer = const_cast<PWSTR>(L"\\REGISTRY\\USER");
+        expected_name.Length = static_cast<USHORT>(wcslen(expected_name.Buffer) * sizeof(WCHAR));
+
+        // Compare the requested name vs the actual kernel object name
+        // If they don't match, we have been redirected, confirming the presence of Sandboxie
+        const bool mismatch = (object_name->Name.Length != expected_name.Length) ||
+            (memcmp(object_name->Name.Buffer, expected_name.Buffer, expected_name.Length) != 0);
+
+        return mismatch ? core::add(brand_enum::SANDBOXIE) : false;
+    }
+    
+    
+    /**
+     * @brief Check if no waveform-audio output devices are present in the system
+     * @category Windows
+     * @implements VM::AUDIO
+     */
+    [[nodiscard]] static bool audio() {
+        struct KEY_FULL_INFORMATION {
+            LARGE_INTEGER LastWriteTime;
+            ULONG         TitleIndex;
+            ULONG         ClassOffset;
+            ULONG         ClassLength;
+            ULONG         SubKeys;
+            ULONG         MaxNameLen;
+            ULONG         MaxClassLen;
+            ULONG         Values;             
+            ULONG         MaxValueNameLen;
+            ULONG         MaxValueDataLen;
+            WCHAR         Class[1];
+        };
+        using PKEY_FULL_INFORMATION = KEY_FULL_INFORMATION*;
+
+        enum KEY_INFORMATION_CLASS {
+            KeyBasicInformation,
+            KeyNodeInformation,
+            KeyFullInformation,
+            KeyNameInformation,
+            KeyCachedInformation,
+            KeyFlagsInformation,
+            KeyVirtualizationInformation,
+            KeyHandleTagsInformation,
+            KeyTrustInformation,
+            KeyLayerInformation,
+            MaxKeyInfoClass
+        };
+
+        const HMODULE ntdll = util::get_ntdll();
+        if (!ntdll) return false;
+
+        const char* names[] = { "RtlInitUnicodeString", "NtOpenKey", "NtQueryKey", "NtClose" };
+        void* funcs[ARRAYSIZE(names)] = {};
+        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+
+        const auto rtl_init_unicode_string = reinterpret_cast<void(__stdcall*)(PUNICODE_STRING, PCWSTR)>(funcs[0]);
+        const auto nt_open_key = reinterpret_cast<NTSTATUS(__stdcall*)(PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES)>(funcs[1]);
+        const auto nt_query_key = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, KEY_INFORMATION_CLASS, PVOID, ULONG, PULONG)>(funcs[2]);
+        const auto nt_close = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE)>(funcs[3]);
+
+        if (!rtl_init_unicode_string || !nt_open_key || !nt_query_key || !nt_close) {
+            return false;
+        }
+
+        // We are checking for the presence of Audio Render devices
+        // Most legitimate user PCs have speakers or headphones (audio endpoints)
+        // Automated sandboxes and headless servers often have no audio devices configured
+        // We target the MMDevices\Audio\Render key where these endpoints are registered
+        const wchar_t* native_path = L"\\Registry\\Machine\\SOFTWARE\\Microsoft\\Windows\\CurrentVersion\\MMDevices\\Audio\\Render";
+
+        UNICODE_STRING unicode_path;
+        rtl_init_unicode_string(&unicode_path, native_path);
+
+        OBJECT_ATTRIBUTES object_attributes;
+        RtlZeroMemory(&object_attributes, sizeof(object_attributes));
+        object_attributes.Length = sizeof(object_attributes);
+        object_attributes.ObjectName = &unicode_path;
+        object_attributes.Attributes = OBJ_CASE_INSENSITIVE;
+
+        HANDLE key = nullptr;
+        const ACCESS_MASK desired_access = KEY_READ;
+
+        NTSTATUS st = nt_open_key(&key, desired_access, &object_attributes);
+        if (!NT_SUCCESS(st) || key == nullptr) {
+            return false;
+        }
+
+        constexpr KEY_INFORMATION_CLASS InfoClass = KeyFullInformation;
+        std::vector<BYTE> info_buffer(512);
+        ULONG returned_len = 0;
+
+        // Query the key information. If the buffer is too small (STATUS_BUFFER_TOO_SMALL),
+        // resize it to the exact length required by the kernel and try again
+        st = nt_query_key(key, InfoClass, info_buffer.data(), static_cast<ULONG>(info_buffer.size()), &returned_len);
+
+        if (!NT_SUCCESS(st) && returned_len > info_buffer.size()) {
+            info_buffer.resize(returned_len);
+            st = nt_query_key(key, InfoClass, info_buffer.data(), static_cast<ULONG>(info_buffer.size()), &returned_len);
+        }
+
+        bool has_values = false;
+        if (NT_SUCCESS(st) && returned_len >= sizeof(KEY_FULL_INFORMATION)) {
+            const auto* kfi = reinterpret_cast<PKEY_FULL_INFORMATION>(info_buffer.data());
+
+            // Check if the registry key has any values associated with it
+            // If 'Values' is 0, the audio system is likely uninitialized or barren,
+            // which strongly suggests a virtualized/sandbox environment
+            const DWORD value_count = static_cast<DWORD>(kfi->Values); // values, not subkeys
+            has_values = (value_count > 0);
+        }
+        else {
+            nt_close(key);
+            return false;
+        }
+
+        nt_close(key);
+
+        return has_values;
+    }
+    
+    
+    /**
+     * @brief Check for VM-specific ACPI device signatures
+     * @category Windows
+     * @implements VM::ACPI_SIGNATURE
+     */
+    [[nodiscard]] static bool acpi_signature() {
+        auto is_hex = [](wchar_t c) noexcept -> bool {
+            return (c >= L'0' && c <= L'9') || (c >= L'A' && c <= L'F');
+        };
+
+        // enumerate all DISPLAY devices
+        const HDEVINFO handle_dev_info = SetupDiGetClassDevsW(&GUID_DEVCLASS_DISPLAY, nullptr, nullptr, DIGCF_PRESENT);
+        if (handle_dev_info == INVALID_HANDLE_VALUE) {
+            debug("ACPI_SIGNATURE: No display device detected");
+            return true;
+        }
+
+        SP_DEVINFO_DATA dev_info;
+        ZeroMemory(&dev_info, sizeof(dev_info));
+        dev_info.cbSize = sizeof(dev_info);
+        const DEVPROPKEY key = DEVPKEY_Device_LocationPaths;
+
+        // baremetal tokens (case-sensitive to preserve handling against edge-cases)
+        static constexpr const wchar_t* excluded_tokens[] = {
+            L"GFX",
+            L"IGD", L"IGFX", L"IGPU",
+            L"VGA", L"VIDEO", L"DISPLAY", L"GPU",
+            L"PCIROOT", L"PNP0A03", L"PNP0A08",
+            L"PCH", L"PXS", L"PEG", L"PEGP"
+        };
+
+        auto has_excluded_token = [&](const wchar_t* s) noexcept -> bool {
+            if (!s || !*s) return false;
+            for (const wchar_t* tok : excluded_tokens) {
+                if (wcsstr(s, tok) != nullptr) return true;
+            }
+            return false;
+        };
+
+        for (DWORD idx = 0; SetupDiEnumDeviceInfo(handle_dev_info, idx, &dev_info); ++idx) {
+            DEVPROPTYPE prop_type = 0;
+            DWORD required_size = 0;
+
+            // query required size (bytes)
+            SetupDiGetDevicePropertyW(handle_dev_info, &dev_info, &key, &prop_type, nullptr, 0, &required_size, 0);
+            if (GetLastError() != ERROR_INSUFFICIENT_BUFFER || required_size == 0) {
+                if (GetLastError() == ERROR_NOT_FOUND) {
+                    debug("ACPI_SIGNATURE: No dedicated display/GPU detected");
+                    SetupDiDestroyDeviceInfoList(handle_dev_info);
+                    return false;
+                }
+                else {
+                    continue;
+                }
+            }
+
+            // fetch buffer (multi-sz)
+            std::vector<BYTE> buffer(required_size + (sizeof(wchar_t) * 2), 0);
+            if (!SetupDiGetDevicePropertyW(handle_dev_info, &dev_info, &key, &prop_type,
+                buffer.data(), required_size, &required_size, 0))
+            {
+                continue;
+            }
+
+            const wchar_t* ptr = reinterpret_cast<const wchar_t*>(buffer.data());
+            // number of wchar_t slots in buffer
+            const size_t total_wchars = required_size / sizeof(wchar_t);
+            const wchar_t* buf_end = ptr + (total_wchars ? total_wchars : 0);
+
+        #ifdef __VMAWARE_DEBUG__
+            for (const wchar_t* p = ptr; p < buf_end && *p; p += (wcslen(p) + 1)) {
+                debug("ACPI_SIGNATURE: ", p);
+            }
+        #endif
+
+            static const wchar_t acpi_prefix[] = L"#ACPI(S";
+            static const wchar_t acpi_paren[] = L"ACPI(";
+
+            // First pass: QEMU-style "#ACPI(Sxx...)" and generic "ACPI(Sxx)"
+            for (const wchar_t* p = ptr; p < buf_end && *p; p += (wcslen(p) + 1)) {
+                if (has_excluded_token(p)) {
+                    debug("ACPI_SIGNATURE: Valid signature -> ", p);
+                    continue;
+                }
+
+                // search for "#ACPI(S"
+                const wchar_t* search = p;
+                while (true) {
+                    const wchar_t* found = wcsstr(search, acpi_prefix);
+                    if (!found) break;
+
+                    // after "#ACPI(S" we expect two hex chars
+                    const wchar_t* hexpos = found + wcslen(acpi_prefix); // first hex char
+                    if (hexpos && hexpos[0] && hexpos[1]) {
+                        wchar_t b = hexpos[0];
+                        wchar_t s = hexpos[1];
+                        if (is_hex(b) && is_hex(s)) {
+                            const wchar_t after = hexpos[2]; // may be '_' or ')'
+                            if (after == L'_' || after == L')') {
+                                SetupDiDestroyDeviceInfoList(handle_dev_info);
+                                return core::add(brand_enum::QEMU);
+                            }
+                        }
+                    }
+                    search = found + 1;
+                }
+
+                // search for "ACPI(" then check for "S" + two hex digits
+                search = p;
+                while (true) {
+                    const wchar_t* found = wcsstr(search, acpi_paren);
+                    if (!found) break;
+                    const wchar_t* start = found + wcslen(acpi_paren); // char after '('
+                    if (start && start[0] && start[1] && start[2]) {
+                        if (start[0] == L'S' && is_hex(start[1]) && is_hex(start[2])) {
+                            SetupDiDestroyDeviceInfoList(handle_dev_info);
+                            return core::add(brand_enum::QEMU);
+                        }
+                    }
+                    search = found + 1;
+                }
+            }
+
+            // Important to run Hyper-V checks later because of is_hardened() logic
+            static constexpr const wchar_t* vm_signatures[] = {
+                L"#ACPI(VMOD)", L"#ACPI(VMBS)", L"#VMBUS(", L"#VPCI("
+            };
+
+            for (const wchar_t* p = ptr; p < buf_end && *p; p += (wcslen(p) + 1)) {
+                if (has_excluded_token(p)) continue;
+
+                for (const wchar_t* sig : vm_signatures) {
+                    if (wcsstr(p, sig) != nullptr) {
+                        SetupDiDestroyDeviceInfoList(handle_dev_info);
+                        return core::add(brand_enum::HYPERV);
+                    }
+                }
+            }
+        }
+
+        SetupDiDestroyDeviceInfoList(handle_dev_info);
+        return false;
+    }
+
+
+    /**
+     * @brief Check if after raising two traps at the same RIP, a hypervisor interferes with the instruction pointer delivery
+     * @category Windows, x86_64
+     * @implements VM::TRAP
+     */
+    [[nodiscard]] static bool trap() {
+        bool hypervisor_caught = false;
+    #if (x86_64)
+        // when a single - step(TF) and hardware breakpoint(DR0) collide, Intel CPUs set both DR6.BS and DR6.B0 to report both events, which help make this detection trick
+        // AMD CPUs prioritize the breakpoint, setting only its corresponding bit in DR6 and clearing the single-step bit, which is why this technique is not compatible with AMD
+        if (!cpu::is_intel()) {
+            return false;
+        }
+
+        // mobile SKUs can "false flag" this check
+        const char* brand = cpu::get_brand();
+        for (const char* c = brand; *c; ++c) {
+            if (*c == 'U') {
+                if (c > brand && (c[-1] >= '0' && c[-1] <= '9')) {
+                    if (c[1] == ' ' || c[1] == '\0') {
+                        return false;
+                    }
+                }
+            }
+        }
+
+        // We must preserve RBX because CPUID clobbers it, and RBX is a non-volatile 
+        // register in x64. If we don't restore it, the calling function (VM::check) crashes
+        // we use MOV R8, RBX instead of PUSH RBX. Pushing to the stack without 
+        // unwind metadata breaks SEH in x64 (OS cannot find the handler), causing a crash
+        constexpr u8 trampoline[] = {
+            0x49, 0x89, 0xD8,                     // mov r8, rbx      (save rbx to volatile register r8)
+            0x9C,                                 // pushfq
+            0x81, 0x04, 0x24,                     // OR DWORD PTR [RSP], 0x10100 (Set TF)
+            0x00, 0x01, 0x01, 0x00,
+            0x9D,                                 // popfq
+            0x0F, 0xA2,                           // cpuid 
+            0x4C, 0x89, 0xC3,                     // mov rbx, r8      (restore rbx from r8) - trap happens here
+            0xC3                                  // ret
+        };
+        SIZE_T trampoline_size = sizeof(trampoline);
+
+        const HMODULE ntdll = util::get_ntdll();
+        if (!ntdll) return false;
+
+        const char* names[] = {
+            "NtAllocateVirtualMemory",
+            "NtProtectVirtualMemory",
+            "NtFreeVirtualMemory",
+            "NtFlushInstructionCache",
+            "NtClose",
+            "NtGetContextThread",
+            "NtSetContextThread"
+        };
+        void* funcs[ARRAYSIZE(names)] = {};
+        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+
+        using nt_allocate_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, ULONG_PTR, PSIZE_T, ULONG, ULONG);
+        using nt_protect_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG, PULONG);
+        using nt_free_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG);
+        using nt_flush_instruction_cache_t = NTSTATUS(__stdcall*)(HANDLE, PVOID, SIZE_T);
+        using nt_close_t = NTSTATUS(__stdcall*)(HANDLE);
+        using nt_get_context_thread_t = NTSTATUS(__stdcall*)(HANDLE, PCONTEXT);
+        using nt_set_context_thread_t = NTSTATUS(__stdcall*)(HANDLE, PCONTEXT);
+
+        // volatile ensures these are loaded from stack after SEH unwind when compiled with aggresive optimizations
+        nt_allocate_virtual_memory_t volatile nt_allocate_virtual_memory = reinterpret_cast<nt_allocate_virtual_memory_t>(funcs[0]);
+        nt_protect_virtual_memory_t volatile nt_protect_virtual_memory = reinterpret_cast<nt_protect_virtual_memory_t>(funcs[1]);
+        nt_free_virtual_memory_t volatile nt_free_virtual_memory = reinterpret_cast<nt_free_virtual_memory_t>(funcs[2]);
+        nt_flush_instruction_cache_t volatile nt_flush_instruction_cache = reinterpret_cast<nt_flush_instruction_cache_t>(funcs[3]);
+        nt_close_t volatile nt_close = reinterpret_cast<nt_close_t>(funcs[4]);
+        nt_get_context_thread_t volatile nt_get_context_thread = reinterpret_cast<nt_get_context_thread_t>(funcs[5]);
+        nt_set_context_thread_t volatile nt_set_context_thread = reinterpret_cast<nt_set_context_thread_t>(funcs[6]);
+
+        if (!nt_allocate_virtual_memory || !nt_protect_virtual_memory || !nt_flush_instruction_cache ||
+            !nt_free_virtual_memory || !nt_get_context_thread || !nt_set_context_thread || !nt_close) {
+            return false;
+        }
+
+        PVOID exec_mem = nullptr;
+        SIZE_T region_size = trampoline_size;
+        const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
+        NTSTATUS st = nt_allocate_virtual_memory(current_process, &exec_mem, 0, &region_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        if (!NT_SUCCESS(st) || !exec_mem) {
+            return false;
+        }
+        memcpy(exec_mem, trampoline, trampoline_size);
+
+        {
+            PVOID tmp_base = exec_mem;
+            SIZE_T tmp_sz = trampoline_size;
+            ULONG oldProt = 0;
+            st = nt_protect_virtual_memory(current_process, &tmp_base, &tmp_sz, PAGE_EXECUTE_READ, &oldProt);
+            if (!NT_SUCCESS(st)) {
+                PVOID free_base = exec_mem;
+                SIZE_T free_size = 0;
+                nt_free_virtual_memory(current_process, &free_base, &free_size, MEM_RELEASE);
+                return false;
+            }
+        }
+
+        nt_flush_instruction_cache(current_process, exec_mem, trampoline_size);
+
+        u8 hitCount = 0;
+
+        CONTEXT original_context{};
+        original_context.ContextFlags = CONTEXT_DEBUG_REGISTERS;
+        const HANDLE current_thread = reinterpret_cast<HANDLE>(-2LL);
+
+        if (!NT_SUCCESS(nt_get_context_thread(current_thread, &original_context))) {
+            PVOID free_base = exec_mem;
+            SIZE_T free_size = 0;
+            nt_free_virtual_memory(current_process, &free_base, &free_size, MEM_RELEASE);
+            return false;
+        }
+
+        // Set DR0 to trampoline + 14 (Instruction: mov rbx, r8)
+        // Offset calculation: mov_r8_rbx(3) + pushfq(1) + or(7) + popfq(1) + cpuid(2) = 14
+        // This is where single step traps after CPUID, and where we want the collision
+        const uintptr_t expected_trap_address = reinterpret_cast<uintptr_t>(exec_mem) + 14;
+
+        // set Dr0 to trampoline+offset
+        CONTEXT debug_context = original_context;
+        debug_context.Dr0 = expected_trap_address; // single step breakpoint address
+        debug_context.Dr7 = 1; // enable Local Breakpoint 0
+
+        if (!NT_SUCCESS(nt_set_context_thread(current_thread, &debug_context))) {
+            nt_set_context_thread(current_thread, &original_context);
+            PVOID free_base = exec_mem;
+            SIZE_T free_size = 0;
+            nt_free_virtual_memory(current_process, &free_base, &free_size, MEM_RELEASE);
+            return false;
+        }
+
+        // Context structure to pass data to the static SEH handler
+        struct trap_context {
+            uintptr_t expectedTrapAddr;
+            u8* hitCount;
+            bool* hypervisor_caught;
+        };
+
+        // Static class for SEH filtering to avoid Release mode Lambda corruption
+        struct SEH_Trap {
+            static LONG Vet(u32 code, EXCEPTION_POINTERS* info, trap_context* ctx) noexcept {
+                // Lambda returns LONG to support EXCEPTION_CONTINUE_EXECUTION
+                if (code != static_cast<DWORD>(0x80000004L)) {
+                    return EXCEPTION_CONTINUE_SEARCH;
+                }
+
+                // Verify exception happened at our calculated offset
+                if (reinterpret_cast<uintptr_t>(info->ExceptionRecord->ExceptionAddress) != ctx->expectedTrapAddr) {
+                    info->ContextRecord->EFlags &= ~0x100; // Clear TF
+                    info->ContextRecord->Dr7 &= ~1;        // Clear DR0 Enable
+                    *ctx->hypervisor_caught = true;
+                    return EXCEPTION_CONTINUE_EXECUTION;
+                }
+
+                (*ctx->hitCount)++;
+
+                // check if Trap Flag and DR0 contributed
+                constexpr u64 required_bits = (1ULL << 14) | 1ULL; // BS | B0
+                const u64 status = info->ContextRecord->Dr6;
+
+                if ((status & required_bits) != required_bits) {
+                    if (util::hyper_x() != HYPERV_ARTIFACT_VM) // detects type 1 Hyper-V too, which we consider legitimate
+                        *ctx->hypervisor_caught = true;
+                }
+
+                // Clear Trap Flag to stop single stepping
+                info->ContextRecord->EFlags &= ~0x100;
+
+                // Clear DR7 Local Enable 0 to disable the hardware breakpoint
+                // If we don't do this, the next instruction will trigger the breakpoint again immediately
+                info->ContextRecord->Dr7 &= ~1;
+
+                // executes mov rbx, r8 (restore), and returns
+                return EXCEPTION_CONTINUE_EXECUTION;
+            }
+        };
+
+        trap_context ctx = { expected_trap_address, &hitCount, &hypervisor_caught };
+
+        __try {
+            reinterpret_cast<void(*)()>(exec_mem)();
+        }
+        __except (SEH_Trap::Vet(_exception_code(), reinterpret_cast<EXCEPTION_POINTERS*>(_exception_info()), &ctx)) {
+            // This block is effectively unreachable because vetExceptions returns CONTINUE_EXECUTION or CONTINUE_SEARCH
+        }
+
+        // If the hypervisor swallowed the exception entirely, hitCount will be 0
+        if (hitCount != 1) {
+            hypervisor_caught = true;
+        }
+
+        nt_set_context_thread(current_thread, &original_context);
+
+        PVOID free_base = exec_mem;
+        SIZE_T free_size = 0;
+        nt_free_virtual_memory(current_process, &free_base, &free_size, MEM_RELEASE);
+    #endif
+        return hypervisor_caught;
+    }
+
+
+    /**
+     * @brief Check if after executing an undefined instruction, a hypervisor misinterpret it as a system call
+     * @category Windows
+     * @implements VM::UD
+     */
+    [[nodiscard]] static bool ud() {
+    #if (x86)
+        // ud2; ret
+        constexpr u8 ud_opcodes[] = { 0x0F, 0x0B, 0xC3 };
+    #elif (ARM32)
+        // udf #0; bx lr
+        // (Little-endian for 0xE7F000F0 and 0xE12FFF1E)
+        constexpr u8 ud_opcodes[] = { 0xF0, 0x00, 0xF0, 0xE7, 0x1E, 0xFF, 0x2F, 0xE1 };
+    #elif (ARM64)
+        // hlt #0; ret
+        // (Little-endian for 0xD4400000 and 0xD65F03C0)
+        constexpr u8 ud_opcodes[] = { 0x00, 0x00, 0x40, 0xD4, 0xC0, 0x03, 0x5F, 0xD6 };
+    #else
+        // architecture not supported by this check
+        return false;
+    #endif
+        
+        bool saw_ud = false;
+        const HMODULE ntdll = util::get_ntdll();
+        if (!ntdll) return false;
+
+        const char* names[] = { "NtAllocateVirtualMemory", "NtProtectVirtualMemory", "NtFlushInstructionCache", "NtFreeVirtualMemory" };
+        void* funcs[ARRAYSIZE(names)] = {};
+        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+
+        const auto nt_allocate_virtual_memory = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID*, ULONG_PTR, PSIZE_T, ULONG, ULONG)>(funcs[0]);
+        const auto nt_protect_virtual_memory = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG, PULONG)>(funcs[1]);
+        const auto nt_flush_instruction_cache = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID, SIZE_T)>(funcs[2]);
+        const auto nt_free_virtual_memory = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG)>(funcs[3]);
+
+        if (!nt_allocate_virtual_memory || !nt_protect_virtual_memory || !nt_flush_instruction_cache || !nt_free_virtual_memory) {
+            return false;
+        }
+
+        const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
+        PVOID base = nullptr;
+        SIZE_T region_size = sizeof(ud_opcodes);
+        NTSTATUS st = nt_allocate_virtual_memory(current_process, &base, 0, &region_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        if (!NT_SUCCESS(st) || !base) {
+            return false;
+        }
+
+        memcpy(base, ud_opcodes, sizeof(ud_opcodes));
+
+        ULONG old_protection = 0;
+        st = nt_protect_virtual_memory(current_process, &base, &region_size, PAGE_EXECUTE_READ, &old_protection);
+        if (!NT_SUCCESS(st)) {
+            region_size = 0;
+            nt_free_virtual_memory(current_process, &base, &region_size, MEM_RELEASE);
+            return false;
+        }
 
         nt_flush_instruction_cache(current_process, base, region_size);
 
-        __try {
-            reinterpret_cast<void(*)()>(base)();
+        __try {
+            reinterpret_cast<void(*)()>(base)();
+        }
+        __except (GetExceptionCode() == EXCEPTION_ILLEGAL_INSTRUCTION ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH) {
+            saw_ud = true;
+        }
+
+        region_size = 0;
+        nt_free_virtual_memory(current_process, &base, &region_size, MEM_RELEASE);
+
+        return !saw_ud;
+    }
+
+
+    /**
+     * @brief Check if a hypervisor does not properly restore the interruptibility state after a VM-exit
+     * @category Windows
+     * @implements VM::INTERRUPT_SHADOW
+     */
+    [[nodiscard]] static bool interrupt_shadow() {
+        if (util::hyper_x() == HYPERV_ARTIFACT_VM) {
+                   return false;
+        }
+        volatile ULONG_PTR trap_ip = 0;
+
+    #if (x86_32) && !(CLANG || GCC)
+        ULONG_PTR baremetal_target_ip = 0;
+
+        __try {
+            __asm {
+                mov dword ptr[baremetal_target_ip], offset baremetal_target // get exact baremetal trap target address dynamically
+                push ebx
+                xor eax, eax
+                mov ax, ss
+                pushfd
+                or dword ptr[esp], 0x100 // set TF
+                popfd
+                mov ss, ax // this blocks any debug exception for exactly one instruction
+                cpuid
+                baremetal_target :
+                pop ebx // baremetal delays the #DB until here due to shadow suppression
+                    nop
+                    pushfd
+                    and dword ptr[esp], 0xFFFFFEFF
+                    popfd
+            }
+        }
+        __except (GetExceptionCode() == EXCEPTION_SINGLE_STEP ?
+            (
+                trap_ip = GetExceptionInformation()->ContextRecord->Eip,
+                GetExceptionInformation()->ContextRecord->EFlags &= ~0x100, // clear TF so execution resumes cleanly and stack restores
+                EXCEPTION_CONTINUE_EXECUTION
+            ) : EXCEPTION_CONTINUE_SEARCH) {}
+
+         // hypervisor is detected if the trap fired at any IP differing from the expected baremetal target
+        // OR if the single step exception never fired at all (trap_ip == 0)
+        return (trap_ip == 0 || trap_ip != baremetal_target_ip);
+
+    #elif (x86_64) || ((x86_32) && (CLANG || GCC))
+        const HMODULE ntdll = util::get_ntdll();
+        if (!ntdll) return false;
+
+        const char* names[] = {
+            "NtAllocateVirtualMemory", "NtProtectVirtualMemory",
+            "NtFlushInstructionCache", "NtFreeVirtualMemory"
+        };
+        void* funcs[ARRAYSIZE(names)] = {};
+        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+
+        const auto nt_alloc   = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID*, ULONG_PTR, PSIZE_T, ULONG, ULONG)>(funcs[0]);
+        const auto nt_protect = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG, PULONG)>(funcs[1]);
+        const auto nt_flush   = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID, SIZE_T)>(funcs[2]);
+        const auto nt_free    = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG)>(funcs[3]);
+
+        if (!nt_alloc || !nt_protect || !nt_flush || !nt_free) return false;
+
+        // these opcodes are byte-for-byte identical for both x86_32 and x86_64 architectures 
+        // 0x53 maps to push ebx in 32-bit and push rbx in 64-bit
+        static constexpr u8 blockstep_opcodes[] = {
+            0x53,                                      // 0:  push rbx/ebx (preserve non-volatile register)
+            0x31, 0xC0,                                // 1:  xor eax, eax
+            0x8C, 0xD0,                                // 3:  mov ax, ss
+            0x9C,                                      // 5:  pushfq/pushfd
+            0x81, 0x0C, 0x24, 0x00, 0x01, 0x00, 0x00, // 6:  or dword ptr [rsp/esp], 0x100
+            0x9D,                                      // 13: popfq/popfd
+            0x8E, 0xD0,                                // 14: mov ss, ax  <- shadow starts here
+            0x0F, 0xA2,                                // 16: cpuid       <- buggy hypervisor traps here
+            0x5B,                                      // 18: pop rbx/ebx <- baremetal traps here
+            0x90,                                      // 19: nop         
+            0x9C,                                      // 20: pushfq/pushfd
+            0x81, 0x24, 0x24, 0xFF, 0xFE, 0xFF, 0xFF, // 21: and dword ptr [rsp/esp], 0xFFFFFEFF
+            0x9D,                                      // 28: popfq/popfd
+            0xC3                                       // 29: ret
+        };
+
+        const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
+        PVOID base = nullptr;
+        SIZE_T region_size = sizeof(blockstep_opcodes);
+
+        if (!NT_SUCCESS(nt_alloc(current_process, &base, 0, &region_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE)) || !base) {
+            return false;
+        }
+
+        memcpy(base, blockstep_opcodes, sizeof(blockstep_opcodes));
+
+        ULONG old_protection = 0;
+        NTSTATUS st = nt_protect(current_process, &base, &region_size, PAGE_EXECUTE_READ, &old_protection);
+
+        // expect the trap explicitly at offset +18 (pop rbx) because of shadow suppression on real hardware
+        const ULONG_PTR baremetal_target_ip = reinterpret_cast<ULONG_PTR>(base) + 18;
+
+        if (NT_SUCCESS(st)) {
+            nt_flush(current_process, base, region_size);
+            __try {
+                reinterpret_cast<void(*)()>(base)();
+            }
+            __except (GetExceptionCode() == EXCEPTION_SINGLE_STEP ?
+                (
+                #if (x86_64)
+                    trap_ip = GetExceptionInformation()->ContextRecord->Rip,
+                #else
+                    trap_ip = GetExceptionInformation()->ContextRecord->Eip,
+                #endif
+                    GetExceptionInformation()->ContextRecord->EFlags &= ~0x100, // to avoid infinite looping
+                    EXCEPTION_CONTINUE_EXECUTION
+                ) : EXCEPTION_CONTINUE_SEARCH) {}
+        }
+
+        region_size = 0;
+        nt_free(current_process, &base, &region_size, MEM_RELEASE);
+
+        // hypervisor is detected if execution trapped at any offset other than expected baremetal
+        // OR if the single step exception never fired at all (trap_ip == 0)
+      return NT_SUCCESS(st) && (trap_ip == 0 || trap_ip != baremetal_target_ip);
+    #else
+        return false;
+    #endif
+    }
+
+    /**
+     * @brief Check if Dark Byte's VM is present
+     * @category Windows
+     * @implements VM::DBVM
+     */
+    [[nodiscard]] static bool dbvm() {
+    #if (!x86_64)
+        return false;
+    #else
+        constexpr u64 PW1 = 0x0000000076543210ULL;
+        constexpr u64 PW3 = 0x0000000090909090ULL;
+        constexpr u32 PW2 = 0xFEDCBA98U;
+
+        struct vmcall_info {
+            u32 structsize;
+            u32 level2pass;
+            u32 command;
+        };
+
+        vmcall_info vmcall_info = {};
+        u64 vmcall_result = 0;
+
+        constexpr u8 intel_template[44] = {
+            0x48,0xBA,0,0,0,0,0,0,0,0,                     // mov rdx, imm64   ; PW1
+            0x48,0xB9,0,0,0,0,0,0,0,0,                     // mov rcx, imm64   ; PW3
+            0x48,0xB8,0,0,0,0,0,0,0,0,                     // mov rax, imm64   ; &vmcallInfo
+            0x0F,0x01,0xC1,                                // vmcall
+            0x48,0xA3,0,0,0,0,0,0,0,0,                     // mov [imm64], rax ; &vmcallResult
+            0xC3                                           // ret
+        };
+
+        constexpr u8 amd_template[44] = {
+            0x48,0xBA,0,0,0,0,0,0,0,0,                     // mov rdx, imm64   ; PW1
+            0x48,0xB9,0,0,0,0,0,0,0,0,                     // mov rcx, imm64   ; PW3
+            0x48,0xB8,0,0,0,0,0,0,0,0,                     // mov rax, imm64   ; &vmcallInfo
+            0x0F,0x01,0xD9,                                // vmmcall (AMD)
+            0x48,0xA3,0,0,0,0,0,0,0,0,                     // mov [imm64], rax ; &vmcallResult
+            0xC3                                           // ret
+        };
+
+        const SIZE_T stub_size = sizeof(intel_template);
+        const bool is_amd = cpu::is_amd();
+
+        const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
+        const HANDLE current_thread = reinterpret_cast<HANDLE>(-2LL);
+        const HMODULE ntdll = util::get_ntdll();
+        if (!ntdll) return false;
+
+        const char* names[] = { "NtAllocateVirtualMemory", "NtProtectVirtualMemory", "NtFlushInstructionCache", "NtFreeVirtualMemory", "NtGetContextThread", "NtSetContextThread" };
+        void* funcs[ARRAYSIZE(names)] = {};
+        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+
+        const auto nt_allocate_virtual_memory = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID*, ULONG_PTR, PSIZE_T, ULONG, ULONG)>(funcs[0]);
+        const auto nt_protect_virtual_memory = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG, PULONG)>(funcs[1]);
+        const auto nt_flush_instruction_cache = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID, SIZE_T)>(funcs[2]);
+        const auto nt_free_virtual_memory = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG)>(funcs[3]);
+        const auto nt_get_context_thread = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PCONTEXT)>(funcs[4]);
+        const auto nt_set_context_thread = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PCONTEXT)>(funcs[5]);
+
+        if (!nt_allocate_virtual_memory || !nt_protect_virtual_memory || !nt_flush_instruction_cache || !nt_free_virtual_memory || !nt_get_context_thread || !nt_set_context_thread) {
+            return false;
+        }
+
+        PVOID stub = nullptr;
+        SIZE_T region_size = stub_size;
+        NTSTATUS st = nt_allocate_virtual_memory(current_process, &stub, 0, &region_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        if (!NT_SUCCESS(st) || !stub) return false;
+
+        if (is_amd) {
+            memcpy(stub, amd_template, stub_size);
+        }
+        else {
+            memcpy(stub, intel_template, stub_size);
+        }
+
+        // ICEBP stub
+        u8* icebp_stub = reinterpret_cast<u8*>(stub) + 64;
+        icebp_stub[0] = 0xF1;                                     
+        icebp_stub[1] = 0xC3;                                      
+
+        // rdx imm64
+        // rcx imm64
+        // rax imm64
+        // mov [imm64], rax immediate
+        *reinterpret_cast<u64*>(reinterpret_cast<u8*>(stub) + 2) = PW1;
+        *reinterpret_cast<u64*>(reinterpret_cast<u8*>(stub) + 12) = PW3;
+        *reinterpret_cast<u64*>(reinterpret_cast<u8*>(stub) + 22) = reinterpret_cast<u64>(static_cast<void*>(&vmcall_info));
+        *reinterpret_cast<u64*>(reinterpret_cast<u8*>(stub) + 35) = reinterpret_cast<u64>(static_cast<void*>(&vmcall_result));
+
+        ULONG old_protection = 0;
+        st = nt_protect_virtual_memory(current_process, &stub, &region_size, PAGE_EXECUTE_READ, &old_protection);
+        if (!NT_SUCCESS(st)) {
+            region_size = 0;
+            nt_free_virtual_memory(current_process, &stub, &region_size, MEM_RELEASE);
+            return false;
+        }
+
+        nt_flush_instruction_cache(current_process, stub, region_size);
+
+        auto try_keys = [&]() noexcept -> bool {
+            // store forwarding
+            vmcall_info.structsize = static_cast<u32>(sizeof(vmcall_info));
+            vmcall_info.level2pass = PW2;
+            vmcall_info.command = 0;
+            vmcall_result = 0;
+
+            __try {
+                reinterpret_cast<void(*)()>(stub)();
+            }
+            __except (EXCEPTION_EXECUTE_HANDLER) { // EXCEPTION_ILLEGAL_INSTRUCTION normally, EXCEPTION_ACCESS_VIOLATION_READ on edge-cases
+                vmcall_result = 0;
+            }
+
+            return (((vmcall_result >> 24) & 0xFF) == 0xCE); // the VM returns status in bits 24–31; Cheat Engine uses 0xCE here
+        };
+
+        auto try_icebp = [&]() noexcept -> bool {
+            bool detected = false;
+            CONTEXT ctx = {};
+            ctx.ContextFlags = CONTEXT_DEBUG_REGISTERS;
+
+            if (!NT_SUCCESS(nt_get_context_thread(current_thread, &ctx))) return false;
+
+            // save old stuff
+            const auto old_dr0 = ctx.Dr0;
+            const auto old_dr1 = ctx.Dr1;
+            const auto old_dr2 = ctx.Dr2;
+            const auto old_dr3 = ctx.Dr3;
+            const auto old_dr6 = ctx.Dr6;
+            const auto old_dr7 = ctx.Dr7;
+
+            ctx.Dr0 = reinterpret_cast<u64>(icebp_stub);
+            ctx.Dr1 = reinterpret_cast<u64>(icebp_stub);
+            ctx.Dr2 = reinterpret_cast<u64>(icebp_stub);
+            ctx.Dr3 = reinterpret_cast<u64>(icebp_stub);
+            ctx.Dr7 = 0x55; // local exact execute breakpoints for Dr0-Dr3
+
+            if (!NT_SUCCESS(nt_set_context_thread(current_thread, &ctx))) return false;
+
+            __try {
+                reinterpret_cast<void(*)()>(icebp_stub)();
+
+                // If the code makes it here without aborting to the __except block, 
+                // the exception was silently swallowed by the hypervisor.
+                detected = true;
+                debug("DBVM: INT 1 exception was not correctly handled");
+            }
+            __except (GetExceptionCode() == EXCEPTION_SINGLE_STEP ?
+                (
+                    // check if they mess up Dr6 and Dr7
+                    detected = ((GetExceptionInformation()->ContextRecord->Dr7 & 0xFF) != 0x55 || GetExceptionInformation()->ContextRecord->Dr6 == 0),
+
+                    EXCEPTION_EXECUTE_HANDLER
+                ) : EXCEPTION_EXECUTE_HANDLER) {
+                if (_exception_code() != EXCEPTION_SINGLE_STEP) {
+                    detected = true;
+                    debug("DBVM: ICEBP exception didn't trigger #DB");
+                }
+                else if (detected) {
+                    debug("DBVM: hardware debug registers were not correctly restored");
+                }
+            }
+
+            // restore old stuff 
+            ctx.ContextFlags = CONTEXT_DEBUG_REGISTERS;
+            ctx.Dr0 = old_dr0;
+            ctx.Dr1 = old_dr1;
+            ctx.Dr2 = old_dr2;
+            ctx.Dr3 = old_dr3;
+            ctx.Dr6 = old_dr6;
+            ctx.Dr7 = old_dr7;
+            nt_set_context_thread(current_thread, &ctx);
+
+            return detected;
+        };
+
+        const bool found_vmcall = try_keys();
+        const bool found_icebp = try_icebp();
+
+        region_size = 0;
+        nt_free_virtual_memory(current_process, &stub, &region_size, MEM_RELEASE);
+
+        if (found_vmcall) return core::add(brand_enum::DBVM);
+        if (found_icebp)  return true;
+
+        return false;
+    #endif
+    }
+
+    /**
+     * @brief Check for any signs of VMs in Windows kernel object entities 
+     * @category Windows
+     * @implements VM::KERNEL_OBJECTS
+     */
+    [[nodiscard]] static bool kernel_objects() {
+        struct OBJECT_DIRECTORY_INFORMATION {
+            UNICODE_STRING Name;
+            UNICODE_STRING TypeName;
+        };
+
+        using POBJECT_DIRECTORY_INFORMATION = OBJECT_DIRECTORY_INFORMATION*;
+        constexpr auto DIRECTORY_QUERY = 0x0001;
+        constexpr NTSTATUS NO_MORE_ENTRIES = 0x8000001A;
+
+        HANDLE dir = nullptr;
+        OBJECT_ATTRIBUTES object_attributes{};
+        UNICODE_STRING dir_name{};
+        NTSTATUS status;
+
+        const HMODULE ntdll = util::get_ntdll();
+        if (!ntdll) return false;
+
+        const char* names[] = { "NtOpenDirectoryObject", "NtQueryDirectoryObject", "NtClose" };
+        void* funcs[ARRAYSIZE(names)] = {};
+        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+
+        const auto nt_open_directory_object = reinterpret_cast<NTSTATUS(__stdcall*)(PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES)>(funcs[0]);
+        const auto nt_query_directory_object = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID, ULONG, BOOLEAN, BOOLEAN, PULONG, PULONG)>(funcs[1]);
+        const auto nt_close = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE)>(funcs[2]);
+
+        if (!nt_open_directory_object || !nt_query_directory_object || !nt_close) return false;
+
+        // Prepare to open the root "\Device" directory in the Object Manager namespace
+        // This is different from the file system and we are looking for kernel objects created by drivers
+        const wchar_t* device_dir_path = L"\\Device";
+        dir_name.Buffer = (PWSTR)device_dir_path;
+        dir_name.Length = (USHORT)(wcslen(device_dir_path) * sizeof(wchar_t));
+        dir_name.MaximumLength = dir_name.Length + sizeof(wchar_t);
+
+        InitializeObjectAttributes(&object_attributes, &dir_name, OBJ_CASE_INSENSITIVE, nullptr, nullptr);
+
+        // Open the directory object so we can enumerate its contents
+        status = nt_open_directory_object(&dir, DIRECTORY_QUERY, &object_attributes);
+
+        if (!NT_SUCCESS(status)) {
+            return false;
         }
-        __except (GetExceptionCode() == EXCEPTION_ILLEGAL_INSTRUCTION ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH) {
-            saw_ud = true;
+
+        // Set up a buffer for querying directory entries
+        // We process entries one by one using a context index
+        std::vector<BYTE> buffer(4096);
+        constexpr size_t MAX_DIR_BUFFER = 64 * 1024;
+        ULONG context = 0;
+        ULONG returned_length = 0;
+
+        while (true) {
+            // Query the next single object in the directory
+            // 'ReturnSingleEntry' is TRUE to simplify buffer parsing logic
+            status = nt_query_directory_object(
+                dir,
+                buffer.data(),
+                static_cast<ULONG>(buffer.size()),
+                TRUE,
+                FALSE,
+                &context,
+                &returned_length
+            );
+
+            // Stop if we have iterated through all objects
+            if (status == NO_MORE_ENTRIES) {
+                break;
+            }
+
+            // Handle buffer sizing. If the buffer is too small, the kernel tells us how much it needs
+            // We resize and retry, but impose a sanity cap to prevent memory issues
+            if (!NT_SUCCESS(status)) {
+                if (returned_length > buffer.size()) {
+                    size_t new_size = static_cast<size_t>(returned_length);
+                    if (new_size > MAX_DIR_BUFFER) new_size = MAX_DIR_BUFFER;
+                    if (new_size <= buffer.size()) {
+                        nt_close(dir);
+                        return false;
+                    }
+                    try {
+                        buffer.resize(new_size);
+                    }
+                    catch (...) {
+                        nt_close(dir);
+                        return false;
+                    }
+                    continue;
+                }
+                nt_close(dir);
+                return false;
+            }
+
+            // Validate the returned data length to ensure we don't read out of bounds
+            const size_t used_len = (returned_length == 0) ? buffer.size() : static_cast<size_t>(returned_length);
+            if (used_len < sizeof(OBJECT_DIRECTORY_INFORMATION) || used_len > buffer.size()) {
+                nt_close(dir);
+                return false;
+            }
+
+            const POBJECT_DIRECTORY_INFORMATION object_directory_information = reinterpret_cast<POBJECT_DIRECTORY_INFORMATION>(buffer.data());
+
+            // memory boundaries just for safe pointer arithmetic
+            const uintptr_t buf_base = reinterpret_cast<uintptr_t>(buffer.data());
+            const uintptr_t buf_end = buf_base + used_len;
+
+            std::wstring object_name;
+            bool found_name = false;
+
+            // Extract the name using the explicit Name pointer in the structure
+            // We strictly validate that the pointer falls within our allocated buffer to prevent crashes
+            const size_t nameBytes = static_cast<size_t>(object_directory_information->Name.Length);
+            const uintptr_t name_ptr = reinterpret_cast<uintptr_t>(object_directory_information->Name.Buffer);
+
+            if (nameBytes > 0 && (nameBytes % sizeof(wchar_t) == 0)) {
+                const uintptr_t min_valid_ptr = buf_base + sizeof(OBJECT_DIRECTORY_INFORMATION);
+                if (name_ptr >= min_valid_ptr && (name_ptr + nameBytes) <= buf_end && (name_ptr % sizeof(wchar_t) == 0)) {
+                    const wchar_t* wname = reinterpret_cast<const wchar_t*>(name_ptr);
+                    const size_t wlen = nameBytes / sizeof(wchar_t);
+                    bool found_term = false;
+                    // scan for null terminator just in case
+                    for (size_t i = 0; i < wlen; ++i) {
+                        if (wname[i] == L'\0') { 
+                            object_name.assign(wname, i); 
+                            found_term = true;
+                            break; 
+                        }
+                    }
+                    if (!found_term) {
+                        object_name.assign(wname, wlen);
+                    }
+                    found_name = true;
+                }
+            }
+
+            // If the explicit pointer was invalid, assume the string data immediately follows the structure
+            if (!found_name) {
+                const uintptr_t altStart = buf_base + sizeof(OBJECT_DIRECTORY_INFORMATION);
+                if (altStart >= buf_end) {
+                    nt_close(dir);
+                    return false;
+                }
+                const size_t maxBytes = buf_end - altStart;
+                if (maxBytes < sizeof(wchar_t)) {
+                    nt_close(dir);
+                    return false;
+                }
+                const wchar_t* alt_ptr = reinterpret_cast<const wchar_t*>(buffer.data() + (altStart - buf_base));
+                const size_t max_chars = maxBytes / sizeof(wchar_t);
+
+                size_t realChars = 0;
+                for (; realChars < max_chars; ++realChars) {
+                    if (alt_ptr[realChars] == L'\0') break;
+                }
+                if (realChars == max_chars) {
+                    nt_close(dir);
+                    return false;
+                }
+                object_name.assign(alt_ptr, realChars);
+                found_name = true;
+            }
+
+            if (!found_name) {
+                nt_close(dir);
+                return false;
+            }
+
+            // "VmGenerationCounter" and "VmGid" are created by the Hyper-V VM Bus provider
+            if (object_name == L"VmGenerationCounter") {
+                nt_close(dir);
+                debug("KERNEL_OBJECTS: Detected VmGenerationCounter");
+                return core::add(brand_enum::HYPERV);
+            }
+            if (object_name == L"VmGid") {
+                nt_close(dir);
+                debug("KERNEL_OBJECTS: Detected VmGid");
+                return core::add(brand_enum::HYPERV);
+            }
         }
 
-        region_size = 0;
-        nt_free_virtual_memory(current_process, &base, &region_size, MEM_RELEASE);
+        nt_close(dir);
+        return false;
+    }
+
+
+    /**
+     * @brief Check for known NVRAM signatures that are present on virtual firmware
+     * @category Windows
+     * @warning Permissions required
+     * @implements VM::NVRAM
+     */
+    static bool nvram() {
+        if (!util::is_admin()) return false;
+
+        struct VARIABLE_NAME { ULONG NextEntryOffset; GUID VendorGuid; WCHAR Name[1]; };
+        using variable_name_ptr = VARIABLE_NAME*;
+        using nt_enumerate_system_environment_values_ex_t = NTSTATUS(__stdcall*)(ULONG, PVOID, PULONG);
+        using nt_query_system_environment_value_ex_t = NTSTATUS(__stdcall*)(PUNICODE_STRING VariableName, LPGUID VendorGuid, PVOID Value, PULONG ValueLength, PULONG Attributes);
+        using nt_allocate_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, ULONG_PTR, PSIZE_T, ULONG, ULONG);
+        using nt_free_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG);
+
+        bool detection_result = false;
+
+        // Handles and Buffers
+        HANDLE token_handle = nullptr;
+        PVOID enum_base_buffer = nullptr;
+        BYTE* pk_default_buf = nullptr;
+        bool privilege_state_saved = false;
+        TOKEN_PRIVILEGES previous_privileges{};
+        DWORD previous_privileges_size = sizeof(previous_privileges);
+        LUID luid_struct{};
+
+        // Function Pointers
+        nt_enumerate_system_environment_values_ex_t nt_enumerate_values = nullptr;
+        nt_allocate_virtual_memory_t nt_allocate_memory = nullptr;
+        nt_free_virtual_memory_t nt_free_memory = nullptr;
+        nt_query_system_environment_value_ex_t nt_query_value = nullptr;
+
+        const HANDLE current_process_handle = reinterpret_cast<HANDLE>(-1LL);
+
+        // -------------------------------------------------------------------------
+        // Helper Lambdas
+        // -------------------------------------------------------------------------
+
+        auto buffer_contains_ascii_ci = [](const BYTE* data, size_t len, const char* pat) noexcept -> bool {
+            if (!data || len == 0 || !pat) return false;
+            const size_t plen = strlen(pat); if (len < plen) return false;
+            const BYTE p0 = static_cast<BYTE>((pat[0] >= 'A' && pat[0] <= 'Z') ? (pat[0] + 32) : pat[0]);
+            const BYTE* end = data + (len - plen);
+            for (const BYTE* p = data; p <= end; ++p) {
+                BYTE c0 = *p;
+                c0 = static_cast<BYTE>((c0 >= 'A' && c0 <= 'Z') ? (c0 + 32) : c0);
+                if (c0 != p0) continue;
+                bool ok = true;
+                for (size_t j = 1; j < plen; ++j) {
+                    BYTE dj = p[j];
+                    dj = static_cast<BYTE>((dj >= 'A' && dj <= 'Z') ? (dj + 32) : dj);
+                    BYTE pj = static_cast<BYTE>((pat[j] >= 'A' && pat[j] <= 'Z') ? (pat[j] + 32) : pat[j]);
+                    if (dj != pj) {
+                        ok = false;
+                        break;
+                    }
+                }
+                if (ok) return true;
+            }
+            return false;
+        };
+
+        auto buffer_contains_utf16le_ci = [](const WCHAR* data, size_t wlen, const wchar_t* pat) noexcept -> bool {
+            if (!data || wlen == 0 || !pat) return false;
+            const size_t plen = wcslen(pat); if (wlen < plen) return false;
+            const WCHAR p0 = static_cast<WCHAR>((pat[0] >= L'A' && pat[0] <= L'Z') ? (pat[0] + 32) : pat[0]);
+            const WCHAR* end = data + (wlen - plen);
+            for (const WCHAR* p = data; p <= end; ++p) {
+                WCHAR c0 = *p; 
+                c0 = static_cast<WCHAR>((c0 >= L'A' && c0 <= L'Z') ? (c0 + 32) : c0);
+                if (c0 != p0) continue;
+                bool ok = true;
+                for (size_t j = 1; j < plen; ++j) {
+                    WCHAR dj = p[j]; 
+                    dj = static_cast<WCHAR>((dj >= L'A' && dj <= L'Z') ? (dj + 32) : dj);
+                    WCHAR pj = static_cast<WCHAR>((pat[j] >= L'A' && pat[j] <= L'Z') ? (pat[j] + 32) : pat[j]);
+                    if (dj != pj) { 
+                        ok = false; 
+                        break;  
+                    }
+                }
+                if (ok) return true;
+            }
+            return false;
+        };
+
+        auto read_variable_to_buffer = [&](const std::wstring& name, GUID& guid, BYTE*& out_buf, SIZE_T& out_len) noexcept -> bool {
+            UNICODE_STRING uni_str{};
+            uni_str.Buffer = const_cast<PWSTR>(name.c_str());
+            uni_str.Length = static_cast<USHORT>(name.length() * sizeof(wchar_t));
+            uni_str.MaximumLength = uni_str.Length + sizeof(wchar_t);
 
-        return !saw_ud;
-    }
+            ULONG required_size = 0;
+            (void)nt_query_value(&uni_str, &guid, nullptr, &required_size, nullptr);
+            if (required_size == 0) return false;
 
+            PVOID allocation_base = nullptr;
+            SIZE_T alloc_size = required_size;
+            if (alloc_size < 0x1000) alloc_size = 0x1000;
 
-    /**
-     * @brief Check if a hypervisor does not properly restore the interruptibility state after a VM-exit
-     * @category Windows
-     * @implements VM::INTERRUPT_SHADOW
-     */
-    [[nodiscard]] static bool interrupt_shadow() {
-        if (util::hyper_x() == HYPERV_ARTIFACT_VM) {
-                   return false;
-        }
-        volatile ULONG_PTR trap_ip = 0;
+            NTSTATUS status = nt_allocate_memory(current_process_handle, &allocation_base, 0, &alloc_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+            if (status != 0 || !allocation_base) {
+                out_buf = nullptr;
+                out_len = 0;
+                return false;
+            }
 
-    #if (x86_32) && !(CLANG || GCC)
-        ULONG_PTR baremetal_target_ip = 0;
+            status = nt_query_value(&uni_str, &guid, allocation_base, &required_size, nullptr);
+            if (status == 0) {
+                out_buf = reinterpret_cast<BYTE*>(allocation_base);
+                out_len = required_size;
+                return true;
+            }
 
-        __try {
-            __asm {
-                mov dword ptr[baremetal_target_ip], offset baremetal_target // get exact baremetal trap target address dynamically
-                push ebx
-                xor eax, eax
-                mov ax, ss
-                pushfd
-                or dword ptr[esp], 0x100 // set TF
-                popfd
-                mov ss, ax // this blocks any debug exception for exactly one instruction
-                cpuid
-                baremetal_target :
-                pop ebx // baremetal delays the #DB until here due to shadow suppression
-                    nop
-                    pushfd
-                    and dword ptr[esp], 0xFFFFFEFF
-                    popfd
+            SIZE_T zero_s = 0;
+            nt_free_memory(current_process_handle, &allocation_base, &zero_s, 0x8000);
+            out_buf = nullptr;
+            out_len = 0;
+            return false;
+        };
+
+        auto cleanup = [&](auto& ptr) {
+            if (ptr) {
+                PVOID base = ptr;
+                SIZE_T size = 0;
+                nt_free_memory(current_process_handle, &base, &size, 0x8000);
+                ptr = nullptr;
             }
-        }
-        __except (GetExceptionCode() == EXCEPTION_SINGLE_STEP ?
-            (
-                trap_ip = GetExceptionInformation()->ContextRecord->Eip,
-                GetExceptionInformation()->ContextRecord->EFlags &= ~0x100, // clear TF so execution resumes cleanly and stack restores
-                EXCEPTION_CONTINUE_EXECUTION
-            ) : EXCEPTION_CONTINUE_SEARCH) {}
+        };
 
-         // hypervisor is detected if the trap fired at any IP differing from the expected baremetal target
-        // OR if the single step exception never fired at all (trap_ip == 0)
-        return (trap_ip == 0 || trap_ip != baremetal_target_ip);
+        // -------------------------------------------------------------------------
+        // Main Logic Block
+        // -------------------------------------------------------------------------
 
-    #elif (x86_64) || ((x86_32) && (CLANG || GCC))
-        const HMODULE ntdll = util::get_ntdll();
-        if (!ntdll) return false;
+        do {
+            if (!OpenProcessToken(current_process_handle, TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token_handle)) break;
+            if (!LookupPrivilegeValue(nullptr, SE_SYSTEM_ENVIRONMENT_NAME, &luid_struct)) break;
 
-        const char* names[] = {
-            "NtAllocateVirtualMemory", "NtProtectVirtualMemory",
-            "NtFlushInstructionCache", "NtFreeVirtualMemory"
-        };
-        void* funcs[ARRAYSIZE(names)] = {};
-        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+            TOKEN_PRIVILEGES tp_enable{};
+            tp_enable.PrivilegeCount = 1;
+            tp_enable.Privileges[0].Luid = luid_struct;
+            tp_enable.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
 
-        const auto nt_alloc   = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID*, ULONG_PTR, PSIZE_T, ULONG, ULONG)>(funcs[0]);
-        const auto nt_protect = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG, PULONG)>(funcs[1]);
-        const auto nt_flush   = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID, SIZE_T)>(funcs[2]);
-        const auto nt_free    = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG)>(funcs[3]);
+            previous_privileges_size = sizeof(previous_privileges);
+            if (!AdjustTokenPrivileges(token_handle, FALSE, &tp_enable, previous_privileges_size, &previous_privileges, &previous_privileges_size))
+                break;
+            if (GetLastError() == ERROR_NOT_ALL_ASSIGNED)
+                break;       
 
-        if (!nt_alloc || !nt_protect || !nt_flush || !nt_free) return false;
+            privilege_state_saved = true;
 
-        // these opcodes are byte-for-byte identical for both x86_32 and x86_64 architectures 
-        // 0x53 maps to push ebx in 32-bit and push rbx in 64-bit
-        static constexpr u8 blockstep_opcodes[] = {
-            0x53,                                      // 0:  push rbx/ebx (preserve non-volatile register)
-            0x31, 0xC0,                                // 1:  xor eax, eax
-            0x8C, 0xD0,                                // 3:  mov ax, ss
-            0x9C,                                      // 5:  pushfq/pushfd
-            0x81, 0x0C, 0x24, 0x00, 0x01, 0x00, 0x00, // 6:  or dword ptr [rsp/esp], 0x100
-            0x9D,                                      // 13: popfq/popfd
-            0x8E, 0xD0,                                // 14: mov ss, ax  <- shadow starts here
-            0x0F, 0xA2,                                // 16: cpuid       <- buggy hypervisor traps here
-            0x5B,                                      // 18: pop rbx/ebx <- baremetal traps here
-            0x90,                                      // 19: nop         
-            0x9C,                                      // 20: pushfq/pushfd
-            0x81, 0x24, 0x24, 0xFF, 0xFE, 0xFF, 0xFF, // 21: and dword ptr [rsp/esp], 0xFFFFFEFF
-            0x9D,                                      // 28: popfq/popfd
-            0xC3                                       // 29: ret
-        };
+            const HMODULE ntdll_module = util::get_ntdll();
+            if (!ntdll_module) break;
 
-        const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
-        PVOID base = nullptr;
-        SIZE_T region_size = sizeof(blockstep_opcodes);
+            const char* func_names[] = { "NtEnumerateSystemEnvironmentValuesEx", "NtAllocateVirtualMemory", "NtFreeVirtualMemory", "NtQuerySystemEnvironmentValueEx" };
+            void* resolved_funcs[sizeof(func_names) / sizeof(func_names[0])] = {};
+            util::get_function_address(ntdll_module, func_names, resolved_funcs, sizeof(func_names) / sizeof(func_names[0]));
 
-        if (!NT_SUCCESS(nt_alloc(current_process, &base, 0, &region_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE)) || !base) {
-            return false;
-        }
+            nt_enumerate_values = reinterpret_cast<nt_enumerate_system_environment_values_ex_t>(resolved_funcs[0]);
+            nt_allocate_memory = reinterpret_cast<nt_allocate_virtual_memory_t>(resolved_funcs[1]);
+            nt_free_memory = reinterpret_cast<nt_free_virtual_memory_t>(resolved_funcs[2]);
+            nt_query_value = reinterpret_cast<nt_query_system_environment_value_ex_t>(resolved_funcs[3]);
 
-        memcpy(base, blockstep_opcodes, sizeof(blockstep_opcodes));
+            if (!nt_enumerate_values || !nt_allocate_memory || !nt_free_memory || !nt_query_value) break;
 
-        ULONG old_protection = 0;
-        NTSTATUS st = nt_protect(current_process, &base, &region_size, PAGE_EXECUTE_READ, &old_protection);
+            NTSTATUS alloc_status = 0;
+            ULONG buffer_required_length = 0;
 
-        // expect the trap explicitly at offset +18 (pop rbx) because of shadow suppression on real hardware
-        const ULONG_PTR baremetal_target_ip = reinterpret_cast<ULONG_PTR>(base) + 18;
+            // ask for size
+            nt_enumerate_values(static_cast<ULONG>(1), nullptr, &buffer_required_length);
 
-        if (NT_SUCCESS(st)) {
-            nt_flush(current_process, base, region_size);
-            __try {
-                reinterpret_cast<void(*)()>(base)();
+            if (buffer_required_length != 0) {
+                SIZE_T enum_alloc_size = 0;
+                enum_alloc_size = static_cast<SIZE_T>(buffer_required_length);
+                alloc_status = nt_allocate_memory(current_process_handle, &enum_base_buffer, 0, &enum_alloc_size, static_cast<ULONG>(MEM_COMMIT | MEM_RESERVE), static_cast<ULONG>(PAGE_READWRITE));
+
+                if (alloc_status == 0 && enum_base_buffer) {
+                    alloc_status = nt_enumerate_values(static_cast<ULONG>(1), enum_base_buffer, &buffer_required_length);
+                    if (alloc_status != 0) {
+                        SIZE_T zero_size = 0;
+                        nt_free_memory(current_process_handle, &enum_base_buffer, &zero_size, 0x8000);
+                        enum_base_buffer = nullptr;
+                    }
+                }
+            }          
+
+            if (alloc_status != 0 || !enum_base_buffer || buffer_required_length == 0) {
+                debug("NVRAM: System is not UEFI");
+                break;
             }
-            __except (GetExceptionCode() == EXCEPTION_SINGLE_STEP ?
-                (
-                #if (x86_64)
-                    trap_ip = GetExceptionInformation()->ContextRecord->Rip,
-                #else
-                    trap_ip = GetExceptionInformation()->ContextRecord->Eip,
-                #endif
-                    GetExceptionInformation()->ContextRecord->EFlags &= ~0x100, // to avoid infinite looping
-                    EXCEPTION_CONTINUE_EXECUTION
-                ) : EXCEPTION_CONTINUE_SEARCH) {}
-        }
 
-        region_size = 0;
-        nt_free(current_process, &base, &region_size, MEM_RELEASE);
+            // ---------------------------------------------------------------------
+            // Constants & Data
+            // ---------------------------------------------------------------------
+            constexpr const char redhat_sig_ascii[] = "red hat";
+            constexpr const wchar_t redhat_sig_wide[] = L"red hat";
+            SIZE_T pk_default_len = 0;
+            variable_name_ptr current_var = reinterpret_cast<variable_name_ptr>(enum_base_buffer);
+            const size_t buffer_total_size = static_cast<size_t>(buffer_required_length);
+            constexpr size_t MAX_NAME_BYTE_LIMIT = 4096;
+            bool should_break_loop = false;
 
-        // hypervisor is detected if execution trapped at any offset other than expected baremetal
-        // OR if the single step exception never fired at all (trap_ip == 0)
-      return NT_SUCCESS(st) && (trap_ip == 0 || trap_ip != baremetal_target_ip);
-    #else
-        return false;
-    #endif
-    }
+            // ---------------------------------------------------------------------
+            // Iteration Loop
+            // ---------------------------------------------------------------------
+            while (true) {
+                const uintptr_t base_address = reinterpret_cast<uintptr_t>(enum_base_buffer);
+                const uintptr_t current_address = reinterpret_cast<uintptr_t>(current_var);
 
-    /**
-     * @brief Check if Dark Byte's VM is present
-     * @category Windows
-     * @implements VM::DBVM
-     */
-    [[nodiscard]] static bool dbvm() {
-    #if (!x86_64)
-        return false;
-    #else
-        constexpr u64 PW1 = 0x0000000076543210ULL;
-        constexpr u64 PW3 = 0x0000000090909090ULL;
-        constexpr u32 PW2 = 0xFEDCBA98U;
+                if (current_address < base_address) break;
 
-        struct vmcall_info {
-            u32 structsize;
-            u32 level2pass;
-            u32 command;
-        };
+                const size_t current_offset = static_cast<size_t>(current_address - base_address);
+                if (current_offset >= buffer_total_size) break;
 
-        vmcall_info vmcall_info = {};
-        u64 vmcall_result = 0;
+                const size_t name_struct_offset = offsetof(VARIABLE_NAME, Name);
+                if (buffer_total_size - current_offset < name_struct_offset) break;
+
+                size_t name_max_bytes = 0;
+                if (current_var->NextEntryOffset != 0) {
+                    const SIZE_T next_entry = static_cast<SIZE_T>(current_var->NextEntryOffset);
+                    if (next_entry <= name_struct_offset) { 
+                        should_break_loop = true; 
+                        break;
+                    }
+                    if (next_entry > buffer_total_size - current_offset) break;
+                    name_max_bytes = next_entry - name_struct_offset;
+                }
+                else {
+                    if (current_offset + name_struct_offset >= buffer_total_size) {
+                        should_break_loop = true;
+                        break; 
+                    }
+                    name_max_bytes = buffer_total_size - (current_offset + name_struct_offset);
+                }
+
+                if (name_max_bytes > MAX_NAME_BYTE_LIMIT) name_max_bytes = MAX_NAME_BYTE_LIMIT;
 
-        constexpr u8 intel_template[44] = {
-            0x48,0xBA,0,0,0,0,0,0,0,0,                     // mov rdx, imm64   ; PW1
-            0x48,0xB9,0,0,0,0,0,0,0,0,                     // mov rcx, imm64   ; PW3
-            0x48,0xB8,0,0,0,0,0,0,0,0,                     // mov rax, imm64   ; &vmcallInfo
-            0x0F,0x01,0xC1,                                // vmcall
-            0x48,0xA3,0,0,0,0,0,0,0,0,                     // mov [imm64], rax ; &vmcallResult
-            0xC3                                           // ret
-        };
+                std::wstring var_name_view;
+                if (name_max_bytes >= sizeof(WCHAR)) {
+                    const WCHAR* name_ptr = reinterpret_cast<const WCHAR*>(reinterpret_cast<const BYTE*>(current_var) + name_struct_offset);
+                    const size_t max_chars = name_max_bytes / sizeof(WCHAR);
+                    size_t real_chars = 0;
+                    while (real_chars < max_chars && name_ptr[real_chars] != L'\0') 
+                        ++real_chars;
+                    if (real_chars == max_chars) { 
+                        should_break_loop = true;
+                        break; 
+                    }
+                    var_name_view = std::wstring(name_ptr, real_chars);
+                }
 
-        constexpr u8 amd_template[44] = {
-            0x48,0xBA,0,0,0,0,0,0,0,0,                     // mov rdx, imm64   ; PW1
-            0x48,0xB9,0,0,0,0,0,0,0,0,                     // mov rcx, imm64   ; PW3
-            0x48,0xB8,0,0,0,0,0,0,0,0,                     // mov rax, imm64   ; &vmcallInfo
-            0x0F,0x01,0xD9,                                // vmmcall (AMD)
-            0x48,0xA3,0,0,0,0,0,0,0,0,                     // mov [imm64], rax ; &vmcallResult
-            0xC3                                           // ret
-        };
+                // Presence checks
+                if (!var_name_view.empty() && var_name_view.rfind(L"VMM", 0) == 0) {
+                    debug("NVRAM: Detected hypervisor signature");
+                    should_break_loop = true;
+                    break;
+                }
 
-        const SIZE_T stub_size = sizeof(intel_template);
-        const bool is_amd = cpu::is_amd();
+                // Read variables
+                if (var_name_view == L"PKDefault" && pk_default_buf == nullptr)
+                    (void)read_variable_to_buffer(std::wstring(var_name_view), current_var->VendorGuid, pk_default_buf, pk_default_len);
 
-        const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
-        const HANDLE current_thread = reinterpret_cast<HANDLE>(-2LL);
-        const HMODULE ntdll = util::get_ntdll();
-        if (!ntdll) return false;
+                if (current_var->NextEntryOffset == 0) break;
+                const SIZE_T next_entry_off = static_cast<SIZE_T>(current_var->NextEntryOffset);
+                const size_t next_var_offset = current_offset + next_entry_off;
+                if (next_var_offset <= current_offset || next_var_offset > buffer_total_size) break;
+                current_var = reinterpret_cast<variable_name_ptr>(reinterpret_cast<PBYTE>(enum_base_buffer) + next_var_offset);
+            }
 
-        const char* names[] = { "NtAllocateVirtualMemory", "NtProtectVirtualMemory", "NtFlushInstructionCache", "NtFreeVirtualMemory", "NtGetContextThread", "NtSetContextThread" };
-        void* funcs[ARRAYSIZE(names)] = {};
-        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+            if (should_break_loop) break;
 
-        const auto nt_allocate_virtual_memory = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID*, ULONG_PTR, PSIZE_T, ULONG, ULONG)>(funcs[0]);
-        const auto nt_protect_virtual_memory = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG, PULONG)>(funcs[1]);
-        const auto nt_flush_instruction_cache = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID, SIZE_T)>(funcs[2]);
-        const auto nt_free_virtual_memory = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG)>(funcs[3]);
-        const auto nt_get_context_thread = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PCONTEXT)>(funcs[4]);
-        const auto nt_set_context_thread = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PCONTEXT)>(funcs[5]);
+            // free enumeration buffer          
+            SIZE_T z = 0;
+            nt_free_memory(current_process_handle, &enum_base_buffer, &z, 0x8000);
+            enum_base_buffer = nullptr;          
 
-        if (!nt_allocate_virtual_memory || !nt_protect_virtual_memory || !nt_flush_instruction_cache || !nt_free_virtual_memory || !nt_get_context_thread || !nt_set_context_thread) {
-            return false;
-        }
+            // check for official red hat certs (QEMU/OVMF)
+            bool found_redhat = false;
+            if (pk_default_buf && pk_default_len) {
+                if ((pk_default_len >= 2) && ((pk_default_len % 2) == 0)) {
+                    const WCHAR* wptr = reinterpret_cast<const WCHAR*>(pk_default_buf);
+                    const size_t wlen = pk_default_len / sizeof(WCHAR);
+                    if (buffer_contains_utf16le_ci(wptr, wlen, redhat_sig_wide))
+                        found_redhat = true;
+                }
+                if (!found_redhat)
+                    if (buffer_contains_ascii_ci(pk_default_buf, pk_default_len, redhat_sig_ascii))
+                        found_redhat = true;
+            }
+            if (found_redhat) {
+                debug("NVRAM: QEMU/OVMF detected");
+                detection_result = core::add(brand_enum::QEMU);
+                break;
+            }
+        } while (false);
 
-        PVOID stub = nullptr;
-        SIZE_T region_size = stub_size;
-        NTSTATUS st = nt_allocate_virtual_memory(current_process, &stub, 0, &region_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-        if (!NT_SUCCESS(st) || !stub) return false;
+        // cleanup
+        cleanup(pk_default_buf);
+        cleanup(enum_base_buffer);
 
-        if (is_amd) {
-            memcpy(stub, amd_template, stub_size);
-        }
-        else {
-            memcpy(stub, intel_template, stub_size);
+        if (privilege_state_saved && token_handle)
+            AdjustTokenPrivileges(token_handle, FALSE, &previous_privileges, previous_privileges_size, nullptr, nullptr);
+        
+        if (token_handle) {
+            CloseHandle(token_handle);
+            token_handle = nullptr;
         }
 
-        // ICEBP stub
-        u8* icebp_stub = reinterpret_cast<u8*>(stub) + 64;
-        icebp_stub[0] = 0xF1;                                     
-        icebp_stub[1] = 0xC3;                                      
+        return detection_result;
+    }
 
-        // rdx imm64
-        // rcx imm64
-        // rax imm64
-        // mov [imm64], rax immediate
-        *reinterpret_cast<u64*>(reinterpret_cast<u8*>(stub) + 2) = PW1;
-        *reinterpret_cast<u64*>(reinterpret_cast<u8*>(stub) + 12) = PW3;
-        *reinterpret_cast<u64*>(reinterpret_cast<u8*>(stub) + 22) = reinterpret_cast<u64>(static_cast<void*>(&vmcall_info));
-        *reinterpret_cast<u64*>(reinterpret_cast<u8*>(stub) + 35) = reinterpret_cast<u64>(static_cast<void*>(&vmcall_result));
 
-        ULONG old_protection = 0;
-        st = nt_protect_virtual_memory(current_process, &stub, &region_size, PAGE_EXECUTE_READ, &old_protection);
-        if (!NT_SUCCESS(st)) {
-            region_size = 0;
-            nt_free_virtual_memory(current_process, &stub, &region_size, MEM_RELEASE);
+    /**
+     * @brief Check whether the CPU is genuine and its reported instruction capabilities are not masked
+     * @category Windows, x86
+     * @implements VM::CPU_HEURISTIC
+     */
+    [[nodiscard]] static bool cpu_heuristic() {
+        bool spoofed = false;
+    #if (x86)
+        if (util::is_running_under_translator()) {
+            debug("CPU_HEURISTIC: Running inside a binary translation layer");
             return false;
         }
 
-        nt_flush_instruction_cache(current_process, stub, region_size);
-
-        auto try_keys = [&]() noexcept -> bool {
-            // store forwarding
-            vmcall_info.structsize = static_cast<u32>(sizeof(vmcall_info));
-            vmcall_info.level2pass = PW2;
-            vmcall_info.command = 0;
-            vmcall_result = 0;
+        // 1) Check for commonly disabled instructions on patches and VMs    
+        u32 a = 0, b = 0, c = 0, d = 0;
+        cpu::cpuid(a, b, c, d, 1u);
 
-            __try {
-                reinterpret_cast<void(*)()>(stub)();
-            }
-            __except (EXCEPTION_EXECUTE_HANDLER) { // EXCEPTION_ILLEGAL_INSTRUCTION normally, EXCEPTION_ACCESS_VIOLATION_READ on edge-cases
-                vmcall_result = 0;
-            }
+        constexpr u32 AES_NI_BIT = 1u << 25;
+        const bool aes_support = (c & AES_NI_BIT) != 0;
 
-            return (((vmcall_result >> 24) & 0xFF) == 0xCE); // the VM returns status in bits 24–31; Cheat Engine uses 0xCE here
+        alignas(16) unsigned char plaintext[16] = {
+            0x00,0x11,0x22,0x33, 0x44,0x55,0x66,0x77,
+            0x88,0x99,0xAA,0xBB, 0xCC,0xDD,0xEE,0xFF
+        };
+        alignas(16) unsigned char key[16] = {
+            0x0F,0x0E,0x0D,0x0C, 0x0B,0x0A,0x09,0x08,
+            0x07,0x06,0x05,0x04, 0x03,0x02,0x01,0x00
         };
+        alignas(16) unsigned char out[16] = { 0 };
 
-        auto try_icebp = [&]() noexcept -> bool {
-            bool detected = false;
-            CONTEXT ctx = {};
-            ctx.ContextFlags = CONTEXT_DEBUG_REGISTERS;
+        // need to do a lambda wrapper to isolate SEH from the parent function's stack unwinding
+        // target aes is required for clang/gcc while in MSVC not, and this target can only be applied to functions, meaning we need a struct
+        struct aes_executor {
+            #if (CLANG || GCC)
+                __attribute__((__target__("aes")))
+            #endif
+            static bool check_aes_integrity(const unsigned char* pt, const unsigned char* k, unsigned char* o, bool support) {
+                __try {
+                    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pt));
+                    __m128i key_vec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(k));
 
-            if (!NT_SUCCESS(nt_get_context_thread(current_thread, &ctx))) return false;
+                    __m128i tmp = _mm_xor_si128(block, key_vec);
+                    tmp = _mm_aesenc_si128(tmp, key_vec);
 
-            // save old stuff
-            const auto old_dr0 = ctx.Dr0;
-            const auto old_dr1 = ctx.Dr1;
-            const auto old_dr2 = ctx.Dr2;
-            const auto old_dr3 = ctx.Dr3;
-            const auto old_dr6 = ctx.Dr6;
-            const auto old_dr7 = ctx.Dr7;
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(o), tmp);
 
-            ctx.Dr0 = reinterpret_cast<u64>(icebp_stub);
-            ctx.Dr1 = reinterpret_cast<u64>(icebp_stub);
-            ctx.Dr2 = reinterpret_cast<u64>(icebp_stub);
-            ctx.Dr3 = reinterpret_cast<u64>(icebp_stub);
-            ctx.Dr7 = 0x55; // local exact execute breakpoints for Dr0-Dr3
+                    if (!support) {
+                        debug("CPU_HEURISTIC: Hypervisor detected hiding AES capabilities");
+                        return true;
+                    }
+                }
+                __except (GetExceptionCode() == EXCEPTION_ILLEGAL_INSTRUCTION
+                    ? EXCEPTION_EXECUTE_HANDLER
+                    : EXCEPTION_CONTINUE_SEARCH
+                ) {
+                    if (support) {
+                        debug("CPU_HEURISTIC: Hypervisor reports AES, but it is not handled correctly");
+                        return true;
+                    }
+                }
+                return false;
+            }
+        };
 
-            if (!NT_SUCCESS(nt_set_context_thread(current_thread, &ctx))) return false;
+        if (aes_executor::check_aes_integrity(plaintext, key, out, aes_support)) return true;
 
-            __try {
-                reinterpret_cast<void(*)()>(icebp_stub)();
+        const bool avx_support = ((c >> 28) & 1u) != 0;
+        const bool xsave_support = ((c >> 26) & 1u) != 0;
 
-                // If the code makes it here without aborting to the __except block, 
-                // the exception was silently swallowed by the hypervisor.
-                detected = true;
-                debug("DBVM: INT 1 exception was not correctly handled");
-            }
-            __except (GetExceptionCode() == EXCEPTION_SINGLE_STEP ?
-                (
-                    // check if they mess up Dr6 and Dr7
-                    detected = ((GetExceptionInformation()->ContextRecord->Dr7 & 0xFF) != 0x55 || GetExceptionInformation()->ContextRecord->Dr6 == 0),
+        if (avx_support && !xsave_support) {
+            debug("CPU_HEURISTIC: YMM state not correct for a baremetal machine");
+            return true;
+        }
 
-                    EXCEPTION_EXECUTE_HANDLER
-                ) : EXCEPTION_EXECUTE_HANDLER) {
-                if (_exception_code() != EXCEPTION_SINGLE_STEP) {
-                    detected = true;
-                    debug("DBVM: ICEBP exception didn't trigger #DB");
+        const bool rdrand_support = ((c >> 30) & 1u) != 0;
+
+        auto check_rdrand_integrity = [&]() -> bool {
+            __try {
+                unsigned int v = 0;
+            #if (MSVC && !CLANG)
+                if (_rdrand32_step(&v) && !rdrand_support) {
+                    debug("CPU_HEURISTIC: Hypervisor detected hiding RDRAND capabilities");
+                    return true;
                 }
-                else if (detected) {
-                    debug("DBVM: hardware debug registers were not correctly restored");
+            #else 
+                unsigned char ok = 0;
+                asm volatile("rdrand %0\n\tsetc %1" : "=r"(v), "=qm"(ok) : : "cc");
+                if (ok && !rdrand_support) {
+                    debug("CPU_HEURISTIC: Hypervisor detected hiding RDRAND capabilities");
+                    return true;
+                }
+            #endif      
+            }
+            __except (GetExceptionCode() == EXCEPTION_ILLEGAL_INSTRUCTION
+                ? EXCEPTION_EXECUTE_HANDLER
+                : EXCEPTION_CONTINUE_SEARCH) {
+                if (rdrand_support) {
+                    debug("CPU_HEURISTIC: Hypervisor reports RDRAND, but it is not handled correctly");
+                    return true;
                 }
             }
+            return false;
+        };
 
-            // restore old stuff 
-            ctx.ContextFlags = CONTEXT_DEBUG_REGISTERS;
-            ctx.Dr0 = old_dr0;
-            ctx.Dr1 = old_dr1;
-            ctx.Dr2 = old_dr2;
-            ctx.Dr3 = old_dr3;
-            ctx.Dr6 = old_dr6;
-            ctx.Dr7 = old_dr7;
-            nt_set_context_thread(current_thread, &ctx);
+        if (check_rdrand_integrity()) return true;
 
-            return detected;
+        // 2. Test if the CPU vendor is spoofed (for example, a CPU reports being AMD in CPUID, but it is Intel)
+        /*
+            For this task, we want a instruction that:
+            1. It is vendor-only, meaning that other CPU vendors never implemented the same instruction on their microcode
+                -> Note: Even if an instruction is vendor-only, it may be treated as a NOP by other CPU vendors, we don't want this
+            2. Is compatible enough, meaning both old and new CPUs of this vendor have it
+            3. Is enabled by default, without needing BIOS/OS changes
+            4. Never switches to kernel-mode, so that is harder to intercept
+            5. Is not deprecated today
+            6. Its side-effects can be measured from CPL3 (user-mode)
+
+            On Intel, most options are unreliable:
+            SGX are deprecated and disabled by default, MPX is deprecated and treated as NOP even in AMD CPUs, AVX-512 is not found in all processors (and AMD integrated part of this set), etc
+            On AMD, 3dNow! could be an option, but since its being deprecated, CLZERO fits this criteria better
+
+            So for example, if the CPU reports being Intel, and succesfully runs CLZERO without a NOP, then it's not an Intel CPU.
+        */
+
+        // AMD stub template (mov rax, imm64 + clzero + ret)
+        // 8-byte immediate at runtime at offsets [2..9]
+        u8 amd_bytes[] = {
+            0x48, 0xB8,                 // mov rax, imm64
+            0x00, 0x00, 0x00, 0x00,     // imm64 low bytes (placeholder)
+            0x00, 0x00, 0x00, 0x00,     // imm64 high bytes (placeholder)
+            0x0F, 0x01, 0xFC,           // clzero
+            0xC3                        // ret
         };
+        constexpr SIZE_T amd_stub_size = sizeof(amd_bytes); // 14
 
-        const bool found_vmcall = try_keys();
-        const bool found_icebp = try_icebp();
+        const u8* bytes = nullptr;
+        SIZE_T codeSize = 0;
 
-        region_size = 0;
-        nt_free_virtual_memory(current_process, &stub, &region_size, MEM_RELEASE);
+        LPVOID amd_target_mem = nullptr;
+        LPVOID exec_mem = nullptr;
+        PVOID free_base = nullptr;
+        SIZE_T free_size = 0;
 
-        if (found_vmcall) return core::add(brand_enum::DBVM);
-        if (found_icebp)  return true;
+        const bool claimed_amd = cpu::is_amd();
+        const bool claimed_intel = cpu::is_intel();
 
-        return false;
-    #endif
-    }
+        if (!claimed_amd && !claimed_intel) {
+            debug("CPU_HEURISTIC: x86 CPU vendor was not recognized as either Intel or AMD");
+            return false; // Zhaoxin? VIA/Centaur?
+        }
 
-    /**
-     * @brief Check for any signs of VMs in Windows kernel object entities 
-     * @category Windows
-     * @implements VM::KERNEL_OBJECTS
-     */
-    [[nodiscard]] static bool kernel_objects() {
-        struct OBJECT_DIRECTORY_INFORMATION {
-            UNICODE_STRING Name;
-            UNICODE_STRING TypeName;
-        };
+        bool proceed = true;
+        bool exception = false;
 
-        using POBJECT_DIRECTORY_INFORMATION = OBJECT_DIRECTORY_INFORMATION*;
-        constexpr auto DIRECTORY_QUERY = 0x0001;
-        constexpr NTSTATUS NO_MORE_ENTRIES = 0x8000001A;
+        // A case where this check could false flag is when analyzing the AMD PRO A8-9600B CPU
+        // is based on the "Bristol Ridge" platform, which uses the Excavator microarchitecture (the 4th and final generation of the Bulldozer family)
+        // Excavator CPUs do not possess the CLZERO instruction
+        if (claimed_amd) {
+            cpu::model_struct model = cpu::get_model();
+            if (!model.is_ryzen) {
+                debug("CPU_HEURISTIC: CPU is AMD but not Ryzen (Pre-Zen). Skipping CLZERO check");
+                proceed = false;
+            }
+        }
 
-        HANDLE dir = nullptr;
-        OBJECT_ATTRIBUTES object_attributes{};
-        UNICODE_STRING dir_name{};
-        NTSTATUS status;
+        if (claimed_intel || !claimed_amd) exception = true; // should generate an exception rather than be treated as a NOP, but we will check its side effects anyways
+
+        // one cache line = 64 bytes
+        const SIZE_T target_size = 64;
 
         const HMODULE ntdll = util::get_ntdll();
         if (!ntdll) return false;
 
-        const char* names[] = { "NtOpenDirectoryObject", "NtQueryDirectoryObject", "NtClose" };
+        const char* names[] = { "NtAllocateVirtualMemory", "NtProtectVirtualMemory", "NtFlushInstructionCache", "NtFreeVirtualMemory" };
         void* funcs[ARRAYSIZE(names)] = {};
         util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
 
-        const auto nt_open_directory_object = reinterpret_cast<NTSTATUS(__stdcall*)(PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES)>(funcs[0]);
-        const auto nt_query_directory_object = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE, PVOID, ULONG, BOOLEAN, BOOLEAN, PULONG, PULONG)>(funcs[1]);
-        const auto nt_close = reinterpret_cast<NTSTATUS(__stdcall*)(HANDLE)>(funcs[2]);
-
-        if (!nt_open_directory_object || !nt_query_directory_object || !nt_close) return false;
-
-        // Prepare to open the root "\Device" directory in the Object Manager namespace
-        // This is different from the file system and we are looking for kernel objects created by drivers
-        const wchar_t* device_dir_path = L"\\Device";
-        dir_name.Buffer = (PWSTR)device_dir_path;
-        dir_name.Length = (USHORT)(wcslen(device_dir_path) * sizeof(wchar_t));
-        dir_name.MaximumLength = dir_name.Length + sizeof(wchar_t);
-
-        InitializeObjectAttributes(&object_attributes, &dir_name, OBJ_CASE_INSENSITIVE, nullptr, nullptr);
-
-        // Open the directory object so we can enumerate its contents
-        status = nt_open_directory_object(&dir, DIRECTORY_QUERY, &object_attributes);
+        using NtAllocateVirtualMemory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, ULONG_PTR, PSIZE_T, ULONG, ULONG);
+        using NtProtectVirtualMemory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG, PULONG);
+        using NtFreeVirtualMemory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG);
+        using NtFlushInstructionCache_t = NTSTATUS(__stdcall*)(HANDLE, PVOID, SIZE_T);
+        const auto nt_allocate_virtual_memory = reinterpret_cast<NtAllocateVirtualMemory_t>(funcs[0]);
+        const auto nt_protect_virtual_memory = reinterpret_cast<NtProtectVirtualMemory_t>(funcs[1]);
+        const auto nt_flush_instruction_cache = reinterpret_cast<NtFlushInstructionCache_t>(funcs[2]);
+        const auto nt_free_virtual_memory = reinterpret_cast<NtFreeVirtualMemory_t>(funcs[3]);
 
-        if (!NT_SUCCESS(status)) {
+        if (!nt_allocate_virtual_memory || !nt_protect_virtual_memory || !nt_flush_instruction_cache || !nt_free_virtual_memory) {
             return false;
         }
 
-        // Set up a buffer for querying directory entries
-        // We process entries one by one using a context index
-        std::vector<BYTE> buffer(4096);
-        constexpr size_t MAX_DIR_BUFFER = 64 * 1024;
-        ULONG context = 0;
-        ULONG returned_length = 0;
-
-        while (true) {
-            // Query the next single object in the directory
-            // 'ReturnSingleEntry' is TRUE to simplify buffer parsing logic
-            status = nt_query_directory_object(
-                dir,
-                buffer.data(),
-                static_cast<ULONG>(buffer.size()),
-                TRUE,
-                FALSE,
-                &context,
-                &returned_length
-            );
+        const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
 
-            // Stop if we have iterated through all objects
-            if (status == NO_MORE_ENTRIES) {
-                break;
+        {
+            PVOID base = nullptr;
+            SIZE_T sz = target_size;
+            NTSTATUS st2 = nt_allocate_virtual_memory(current_process, &base, 0, &sz, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+            if (!NT_SUCCESS(st2) || base == nullptr) {
+                proceed = false;
             }
+            else {
+                amd_target_mem = base;
+                // fill target with a recognizable non-zero pattern so we can detect CLZERO's effect (in case some obscure Intel CPU treat our instruction as a NOP)
+                memset(amd_target_mem, 0xA5, target_size);
 
-            // Handle buffer sizing. If the buffer is too small, the kernel tells us how much it needs
-            // We resize and retry, but impose a sanity cap to prevent memory issues
-            if (!NT_SUCCESS(status)) {
-                if (returned_length > buffer.size()) {
-                    size_t new_size = static_cast<size_t>(returned_length);
-                    if (new_size > MAX_DIR_BUFFER) new_size = MAX_DIR_BUFFER;
-                    if (new_size <= buffer.size()) {
-                        nt_close(dir);
-                        return false;
-                    }
-                    try {
-                        buffer.resize(new_size);
-                    }
-                    catch (...) {
-                        nt_close(dir);
-                        return false;
-                    }
-                    continue;
+                const std::uintptr_t paddr = reinterpret_cast<std::uintptr_t>(amd_target_mem); // to avoid sign-extension, 32-bit compatible
+                const u64 addr = static_cast<u64>(paddr);
+                for (u8 i = 0; i < 8; ++i) {
+                    amd_bytes[2 + i] = static_cast<u8>((addr >> (i * 8)) & 0xFF);
                 }
-                nt_close(dir);
-                return false;
+                bytes = amd_bytes;
+                codeSize = amd_stub_size;
             }
+        }
 
-            // Validate the returned data length to ensure we don't read out of bounds
-            const size_t used_len = (returned_length == 0) ? buffer.size() : static_cast<size_t>(returned_length);
-            if (used_len < sizeof(OBJECT_DIRECTORY_INFORMATION) || used_len > buffer.size()) {
-                nt_close(dir);
-                return false;
-            }
+        if (proceed) {
+            PVOID base = nullptr;
+            SIZE_T sz = codeSize;
+            NTSTATUS st2 = nt_allocate_virtual_memory(current_process, &base, 0, &sz, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+            if (NT_SUCCESS(st2) && base != nullptr) {
+                exec_mem = base;
+                memcpy(exec_mem, bytes, codeSize);
 
-            const POBJECT_DIRECTORY_INFORMATION object_directory_information = reinterpret_cast<POBJECT_DIRECTORY_INFORMATION>(buffer.data());
+                // change to RX
+                ULONG oldProt = 0;
+                PVOID tmp_base = exec_mem;
+                SIZE_T tmp_sz = codeSize;
+                st2 = nt_protect_virtual_memory(current_process, &tmp_base, &tmp_sz, PAGE_EXECUTE_READ, &oldProt);
+                if (NT_SUCCESS(st2)) {
+                    nt_flush_instruction_cache(current_process, exec_mem, codeSize);
 
-            // memory boundaries just for safe pointer arithmetic
-            const uintptr_t buf_base = reinterpret_cast<uintptr_t>(buffer.data());
-            const uintptr_t buf_end = buf_base + used_len;
+                    using code_func = void(*)();
+                    using runner_func = u8(*)(code_func);
+                    runner_func runner = +[](code_func func) -> u8 {
+                        __try {
+                            func();
+                            return 0;
+                        }
+                        __except (GetExceptionCode() == EXCEPTION_ILLEGAL_INSTRUCTION ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH) {
+                            return 1;
+                        }
+                    };
 
-            std::wstring object_name;
-            bool found_name = false;
+                    const u8 runner_rc = runner(reinterpret_cast<code_func>(exec_mem));
 
-            // Extract the name using the explicit Name pointer in the structure
-            // We strictly validate that the pointer falls within our allocated buffer to prevent crashes
-            const size_t nameBytes = static_cast<size_t>(object_directory_information->Name.Length);
-            const uintptr_t name_ptr = reinterpret_cast<uintptr_t>(object_directory_information->Name.Buffer);
+                    // check if the target buffer was written to zero by CLZERO
+                    bool memory_all_zero = false;
+                    if (amd_target_mem) {
+                        volatile u8* p = reinterpret_cast<volatile u8*>(amd_target_mem);
+                        memory_all_zero = true;
+                        for (SIZE_T i = 0; i < target_size; ++i) {
+                            if (p[i] != 0) { memory_all_zero = false; break; }
+                        }
+                    }
 
-            if (nameBytes > 0 && (nameBytes % sizeof(wchar_t) == 0)) {
-                const uintptr_t min_valid_ptr = buf_base + sizeof(OBJECT_DIRECTORY_INFORMATION);
-                if (name_ptr >= min_valid_ptr && (name_ptr + nameBytes) <= buf_end && (name_ptr % sizeof(wchar_t) == 0)) {
-                    const wchar_t* wname = reinterpret_cast<const wchar_t*>(name_ptr);
-                    const size_t wlen = nameBytes / sizeof(wchar_t);
-                    bool found_term = false;
-                    // scan for null terminator just in case
-                    for (size_t i = 0; i < wlen; ++i) {
-                        if (wname[i] == L'\0') { 
-                            object_name.assign(wname, i); 
-                            found_term = true;
-                            break; 
+                    if (runner_rc == 0 && exception) {
+                        // only treat as spoofed if the CLZERO execution actually zeroed the target memory
+                        if (memory_all_zero) {
+                            debug("CPU_HEURISTIC: CPU reports being Intel, but VMAware detected a hypervisor running an AMD CPU in the host"); // or another CPU vendor
+                            spoofed = true;
+                        }
+                        else {
+                            debug("CPU_HEURISTIC: CLZERO returned without exception but target memory was NOT zeroed (NOP/emulated)");
                         }
                     }
-                    if (!found_term) {
-                        object_name.assign(wname, wlen);
+                    else if (runner_rc == 1 && !exception) {
+                        debug("CPU_HEURISTIC: CPU reports being AMD, but VMAware detected a hypervisor running an Intel CPU in the host"); // or another CPU vendor
+                        spoofed = true;
+                    }
+                    else if (runner_rc == 0 && !exception) {
+                        if (!memory_all_zero) {
+                            debug("CPU_HEURISTIC: CPU reports being AMD, CLZERO executed but did NOT zero the target memory");
+                            spoofed = true;
+                        }
                     }
-                    found_name = true;
                 }
             }
+        }
 
-            // If the explicit pointer was invalid, assume the string data immediately follows the structure
-            if (!found_name) {
-                const uintptr_t altStart = buf_base + sizeof(OBJECT_DIRECTORY_INFORMATION);
-                if (altStart >= buf_end) {
-                    nt_close(dir);
-                    return false;
-                }
-                const size_t maxBytes = buf_end - altStart;
-                if (maxBytes < sizeof(wchar_t)) {
-                    nt_close(dir);
-                    return false;
-                }
-                const wchar_t* alt_ptr = reinterpret_cast<const wchar_t*>(buffer.data() + (altStart - buf_base));
-                const size_t max_chars = maxBytes / sizeof(wchar_t);
-
-                size_t realChars = 0;
-                for (; realChars < max_chars; ++realChars) {
-                    if (alt_ptr[realChars] == L'\0') break;
-                }
-                if (realChars == max_chars) {
-                    nt_close(dir);
-                    return false;
-                }
-                object_name.assign(alt_ptr, realChars);
-                found_name = true;
-            }
+        if (exec_mem) {
+            free_base = exec_mem; free_size = 0;
+            nt_free_virtual_memory(current_process, &free_base, &free_size, MEM_RELEASE);
+            exec_mem = nullptr;
+        }
+        if (amd_target_mem) {
+            free_base = amd_target_mem; free_size = 0;
+            nt_free_virtual_memory(current_process, &free_base, &free_size, MEM_RELEASE);
+            amd_target_mem = nullptr;
+        }
 
-            if (!found_name) {
-                nt_close(dir);
-                return false;
-            }
+        if (spoofed) return spoofed;
 
-            // "VmGenerationCounter" and "VmGid" are created by the Hyper-V VM Bus provider
-            if (object_name == L"VmGenerationCounter") {
-                nt_close(dir);
-                debug("KERNEL_OBJECTS: Detected VmGenerationCounter");
-                return core::add(brand_enum::HYPERV);
-            }
-            if (object_name == L"VmGid") {
-                nt_close(dir);
-                debug("KERNEL_OBJECTS: Detected VmGid");
-                return core::add(brand_enum::HYPERV);
-            }
-        }
+        // ok so if the CPU is intel, the motherboard should be intel aswell (and same with AMD)
+        // this doesnt happen in most public hardened configs out there so lets abuse it
+        static constexpr unsigned int VID_INTEL = 0x8086;
+        static constexpr unsigned int VID_AMD_ATI = 0x1002;
+        static constexpr unsigned int VID_AMD_MICRO = 0x1022;
 
-        nt_close(dir);
-        return false;
-    }
+        enum class MBVendor { Unknown = 0, Intel = 1, AMD = 2 };
 
+        auto detect_motherboard = []() noexcept -> MBVendor {
+            static constexpr const wchar_t* TOKENS[] = {
+                L"host bridge", L"northbridge", L"southbridge", L"pci bridge", L"chipset", L"pch", L"fch",
+                L"platform controller", L"lpc", L"sata controller", L"ahci", L"ide controller", L"usb controller",
+                L"xhci", L"usb3", L"usb 3.0", L"usb 3", L"pcie root", L"pci express", L" sata", nullptr
+            };
 
-    /**
-     * @brief Check for known NVRAM signatures that are present on virtual firmware
-     * @category Windows
-     * @warning Permissions required
-     * @implements VM::NVRAM
-     */
-    static bool nvram() {
-        if (!util::is_admin()) return false;
+            auto contains_token = [](const wchar_t* haystack) noexcept -> bool {
+                if (!haystack) return false;
+                for (const wchar_t* const* t = TOKENS; *t; ++t) {
+                    const wchar_t* needle = *t;
+                    const wchar_t* h = haystack;
 
-        struct VARIABLE_NAME { ULONG NextEntryOffset; GUID VendorGuid; WCHAR Name[1]; };
-        using variable_name_ptr = VARIABLE_NAME*;
-        using nt_enumerate_system_environment_values_ex_t = NTSTATUS(__stdcall*)(ULONG, PVOID, PULONG);
-        using nt_query_system_environment_value_ex_t = NTSTATUS(__stdcall*)(PUNICODE_STRING VariableName, LPGUID VendorGuid, PVOID Value, PULONG ValueLength, PULONG Attributes);
-        using nt_allocate_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, ULONG_PTR, PSIZE_T, ULONG, ULONG);
-        using nt_free_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG);
+                    // naive scan is faster than BM/KMP for very short needles/haystacks
+                    while (*h) {
+                        const wchar_t* h_iter = h;
+                        const wchar_t* n_iter = needle;
 
-        bool detection_result = false;
+                        while (*n_iter) {
+                            wchar_t hc = *h_iter;
+                            if (hc >= L'A' && hc <= L'Z') hc += 32;
 
-        // Handles and Buffers
-        HANDLE token_handle = nullptr;
-        PVOID enum_base_buffer = nullptr;
-        BYTE* pk_default_buf = nullptr;
-        bool privilege_state_saved = false;
-        TOKEN_PRIVILEGES previous_privileges{};
-        DWORD previous_privileges_size = sizeof(previous_privileges);
-        LUID luid_struct{};
+                            if (hc != *n_iter) break;
+                            h_iter++;
+                            n_iter++;
+                        }
 
-        // Function Pointers
-        nt_enumerate_system_environment_values_ex_t nt_enumerate_values = nullptr;
-        nt_allocate_virtual_memory_t nt_allocate_memory = nullptr;
-        nt_free_virtual_memory_t nt_free_memory = nullptr;
-        nt_query_system_environment_value_ex_t nt_query_value = nullptr;
+                        if (!*n_iter) return true; 
+                        h++;
+                    }
+                }
+                return false;
+            };
 
-        const HANDLE current_process_handle = reinterpret_cast<HANDLE>(-1LL);
+            auto find_vendor_hex = [](const wchar_t* wptr) noexcept -> u32 {
+                if (!wptr) return 0;
+                const wchar_t* p = wptr;
+                while (*p) {
+                    // Check for "VEN_" (case-insensitive)
+                    if (((p[0] | 0x20) == L'v') &&
+                        ((p[1] | 0x20) == L'e') &&
+                        ((p[2] | 0x20) == L'n') &&
+                        (p[3] == L'_')) {
 
-        // -------------------------------------------------------------------------
-        // Helper Lambdas
-        // -------------------------------------------------------------------------
+                        const wchar_t* q = p + 4;
+                        u32 val = 0;
+                        int got = 0;
+                        while (got < 4 && *q) {
+                            const wchar_t c = *q;
+                            u32 nib = 0;
+                            if (c >= L'0' && c <= L'9') 
+                                nib = static_cast<u32>(c - L'0');
+                            else if ((c | 0x20) >= L'a' && (c | 0x20) <= L'f') 
+                                nib = static_cast<u32>((c | 0x20) - L'a' + 10);
+                            else
+                                break;
 
-        auto buffer_contains_ascii_ci = [](const BYTE* data, size_t len, const char* pat) noexcept -> bool {
-            if (!data || len == 0 || !pat) return false;
-            const size_t plen = strlen(pat); if (len < plen) return false;
-            const BYTE p0 = static_cast<BYTE>((pat[0] >= 'A' && pat[0] <= 'Z') ? (pat[0] + 32) : pat[0]);
-            const BYTE* end = data + (len - plen);
-            for (const BYTE* p = data; p <= end; ++p) {
-                BYTE c0 = *p;
-                c0 = static_cast<BYTE>((c0 >= 'A' && c0 <= 'Z') ? (c0 + 32) : c0);
-                if (c0 != p0) continue;
-                bool ok = true;
-                for (size_t j = 1; j < plen; ++j) {
-                    BYTE dj = p[j];
-                    dj = static_cast<BYTE>((dj >= 'A' && dj <= 'Z') ? (dj + 32) : dj);
-                    BYTE pj = static_cast<BYTE>((pat[j] >= 'A' && pat[j] <= 'Z') ? (pat[j] + 32) : pat[j]);
-                    if (dj != pj) {
-                        ok = false;
-                        break;
+                            val = (val << 4) | nib;
+                            ++got; ++q;
+                        }
+                        if (got == 4) return val;
                     }
+                    ++p;
                 }
-                if (ok) return true;
-            }
-            return false;
-        };
+                return 0;
+            };
 
-        auto buffer_contains_utf16le_ci = [](const WCHAR* data, size_t wlen, const wchar_t* pat) noexcept -> bool {
-            if (!data || wlen == 0 || !pat) return false;
-            const size_t plen = wcslen(pat); if (wlen < plen) return false;
-            const WCHAR p0 = static_cast<WCHAR>((pat[0] >= L'A' && pat[0] <= L'Z') ? (pat[0] + 32) : pat[0]);
-            const WCHAR* end = data + (wlen - plen);
-            for (const WCHAR* p = data; p <= end; ++p) {
-                WCHAR c0 = *p; 
-                c0 = static_cast<WCHAR>((c0 >= L'A' && c0 <= L'Z') ? (c0 + 32) : c0);
-                if (c0 != p0) continue;
-                bool ok = true;
-                for (size_t j = 1; j < plen; ++j) {
-                    WCHAR dj = p[j]; 
-                    dj = static_cast<WCHAR>((dj >= L'A' && dj <= L'Z') ? (dj + 32) : dj);
-                    WCHAR pj = static_cast<WCHAR>((pat[j] >= L'A' && pat[j] <= L'Z') ? (pat[j] + 32) : pat[j]);
-                    if (dj != pj) { 
-                        ok = false; 
-                        break;  
+            // setupapi stuff
+            int intel_hits = 0;
+            int amd_hits = 0;
+
+            wchar_t stack_buf[1024]{};
+            std::vector<BYTE> heap_buf; // fallback for rare huge strings
+
+            auto scan_devices = [&](const GUID* classGuid, DWORD flags) noexcept {
+                HDEVINFO handle_dev_info = SetupDiGetClassDevsW(classGuid, nullptr, nullptr, flags);
+                if (handle_dev_info == INVALID_HANDLE_VALUE) return;
+
+                SP_DEVINFO_DATA dev_info_data{};
+                dev_info_data.cbSize = sizeof(SP_DEVINFO_DATA);
+
+                for (DWORD i = 0; SetupDiEnumDeviceInfo(handle_dev_info, i, &dev_info_data); ++i) {
+
+                    const wchar_t* w_desc = nullptr;
+                    DWORD req_size = 0;
+                    DWORD prop_type = 0;
+
+                    if (SetupDiGetDeviceRegistryPropertyW(handle_dev_info, &dev_info_data, SPDRP_DEVICEDESC, &prop_type, reinterpret_cast<PBYTE>(stack_buf), sizeof(stack_buf), &req_size)) {
+                        w_desc = stack_buf;
+                    }
+                    else if (GetLastError() == ERROR_INSUFFICIENT_BUFFER) {
+                        if (heap_buf.size() < req_size) heap_buf.resize(req_size);
+                        if (SetupDiGetDeviceRegistryPropertyW(handle_dev_info, &dev_info_data, SPDRP_DEVICEDESC, &prop_type, heap_buf.data(), req_size, nullptr)) {
+                            w_desc = reinterpret_cast<const wchar_t*>(heap_buf.data());
+                        }
                     }
-                }
-                if (ok) return true;
-            }
-            return false;
-        };
 
-        auto read_variable_to_buffer = [&](const std::wstring& name, GUID& guid, BYTE*& out_buf, SIZE_T& out_len) noexcept -> bool {
-            UNICODE_STRING uni_str{};
-            uni_str.Buffer = const_cast<PWSTR>(name.c_str());
-            uni_str.Length = static_cast<USHORT>(name.length() * sizeof(wchar_t));
-            uni_str.MaximumLength = uni_str.Length + sizeof(wchar_t);
+                    // check if the description contains any interesting stuff
+                    if (w_desc && contains_token(w_desc)) {
 
-            ULONG required_size = 0;
-            (void)nt_query_value(&uni_str, &guid, nullptr, &required_size, nullptr);
-            if (required_size == 0) return false;
+                        // if interesting get hwid to get vendor
+                        const wchar_t* w_hardware_id = nullptr;
+
+                        if (SetupDiGetDeviceRegistryPropertyW(handle_dev_info, &dev_info_data, SPDRP_HARDWAREID, &prop_type, reinterpret_cast<PBYTE>(stack_buf), sizeof(stack_buf), &req_size)) {
+                            w_hardware_id = stack_buf;
+                        }
+                        else if (GetLastError() == ERROR_INSUFFICIENT_BUFFER) {
+                            if (heap_buf.size() < req_size) heap_buf.resize(req_size);
+                            if (SetupDiGetDeviceRegistryPropertyW(handle_dev_info, &dev_info_data, SPDRP_HARDWAREID, &prop_type, heap_buf.data(), req_size, nullptr)) {
+                                w_hardware_id = reinterpret_cast<const wchar_t*>(heap_buf.data());
+                            }
+                        }
 
-            PVOID allocation_base = nullptr;
-            SIZE_T alloc_size = required_size;
-            if (alloc_size < 0x1000) alloc_size = 0x1000;
+                        if (w_hardware_id) {
+                            const u32 vid = find_vendor_hex(w_hardware_id);
+                            if (vid == VID_INTEL) intel_hits++;
+                            else if (vid == VID_AMD_ATI || vid == VID_AMD_MICRO) amd_hits++;
+                        }
+                    }
+                }
+                SetupDiDestroyDeviceInfoList(handle_dev_info);
+            };
 
-            NTSTATUS status = nt_allocate_memory(current_process_handle, &allocation_base, 0, &alloc_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-            if (status != 0 || !allocation_base) {
-                out_buf = nullptr;
-                out_len = 0;
-                return false;
+            // GUID_DEVCLASS_SYSTEM covers Host Bridges, LPC, PCI bridges Chipset/CPU etc
+            // GUID_DEVCLASS_USB covers USB controller stuff
+            // GUID_DEVCLASS_HDC covers SATA/IDE
+            const GUID* interesting_classes[] = {
+                &GUID_DEVCLASS_SYSTEM,
+                &GUID_DEVCLASS_USB,
+                &GUID_DEVCLASS_HDC
+            };
+
+            for (const GUID* guid : interesting_classes) {
+                scan_devices(guid, DIGCF_PRESENT);
             }
 
-            status = nt_query_value(&uni_str, &guid, allocation_base, &required_size, nullptr);
-            if (status == 0) {
-                out_buf = reinterpret_cast<BYTE*>(allocation_base);
-                out_len = required_size;
-                return true;
+            // if no stuff then maybe query all devices in the system?
+            if (intel_hits == 0 && amd_hits == 0) {
+                scan_devices(nullptr, DIGCF_ALLCLASSES | DIGCF_PRESENT);
             }
 
-            SIZE_T zero_s = 0;
-            nt_free_memory(current_process_handle, &allocation_base, &zero_s, 0x8000);
-            out_buf = nullptr;
-            out_len = 0;
-            return false;
+            if (intel_hits > amd_hits) return MBVendor::Intel;
+            if (amd_hits > intel_hits) return MBVendor::AMD;
+            return MBVendor::Unknown;
         };
 
-        auto cleanup = [&](auto& ptr) {
-            if (ptr) {
-                PVOID base = ptr;
-                SIZE_T size = 0;
-                nt_free_memory(current_process_handle, &base, &size, 0x8000);
-                ptr = nullptr;
+        const MBVendor vendor = detect_motherboard();
+
+        switch (vendor) {
+        case MBVendor::Intel:
+            if (claimed_amd && !claimed_intel) {
+                debug("CPU_HEURISTIC: CPU reports AMD but chipset looks Intel");
+                spoofed = true;
             }
-        };
+            break;
+        case MBVendor::AMD:
+            if (claimed_intel && !claimed_amd) {
+                debug("CPU_HEURISTIC: CPU reports Intel but chipset looks AMD");
+                spoofed = true;
+            }
+            break;
+        case MBVendor::Unknown:
+            debug("CPU_HEURISTIC: Could not determine chipset vendor");
+            break;
+        }
+    #endif
+        return spoofed;
+    }
 
-        // -------------------------------------------------------------------------
-        // Main Logic Block
-        // -------------------------------------------------------------------------
 
-        do {
-            if (!OpenProcessToken(current_process_handle, TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token_handle)) break;
-            if (!LookupPrivilegeValue(nullptr, SE_SYSTEM_ENVIRONMENT_NAME, &luid_struct)) break;
+    /**
+     * @brief Check the presence of system timers
+     * @category x86, Windows
+     * @implements VM::CLOCK
+     */
+    [[nodiscard]] static bool clock() {
+    #if (ARM)
+		return false; // ARM systems do not have the classic x86 timers
+    #else   
+		if (util::is_running_under_translator()) {
+            debug("CLOCK: Running inside an ARM CPU");
+            return false;
+        }
 
-            TOKEN_PRIVILEGES tp_enable{};
-            tp_enable.PrivilegeCount = 1;
-            tp_enable.Privileges[0].Luid = luid_struct;
-            tp_enable.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+        // Surface Pro models typically do not have PIT, some devices might have it but not expose it due to firmware bugs (i.e. Lenovo 83AG)       
+        const char* manufacturer = nullptr;
+        const char* model = nullptr;
 
-            previous_privileges_size = sizeof(previous_privileges);
-            if (!AdjustTokenPrivileges(token_handle, FALSE, &tp_enable, previous_privileges_size, &previous_privileges, &previous_privileges_size))
-                break;
-            if (GetLastError() == ERROR_NOT_ALL_ASSIGNED)
-                break;       
+        if (util::get_manufacturer_model(&manufacturer, &model)) {
+            auto ci_contains = [](const char* hay, const char* needle) noexcept -> bool {
+                if (!hay || !needle || !*hay || !*needle) return false;
 
-            privilege_state_saved = true;
+                for (const char* h = hay; *h; ++h) {
+                    const char* a = h;
+                    const char* b = needle;
 
-            const HMODULE ntdll_module = util::get_ntdll();
-            if (!ntdll_module) break;
+                    while (*a && *b) {
+                        unsigned char ca = static_cast<unsigned char>(*a);
+                        unsigned char cb = static_cast<unsigned char>(*b);
 
-            const char* func_names[] = { "NtEnumerateSystemEnvironmentValuesEx", "NtAllocateVirtualMemory", "NtFreeVirtualMemory", "NtQuerySystemEnvironmentValueEx" };
-            void* resolved_funcs[sizeof(func_names) / sizeof(func_names[0])] = {};
-            util::get_function_address(ntdll_module, func_names, resolved_funcs, sizeof(func_names) / sizeof(func_names[0]));
+                        if (ca >= 'A' && ca <= 'Z') ca += 32;
+                        if (cb >= 'A' && cb <= 'Z') cb += 32;
 
-            nt_enumerate_values = reinterpret_cast<nt_enumerate_system_environment_values_ex_t>(resolved_funcs[0]);
-            nt_allocate_memory = reinterpret_cast<nt_allocate_virtual_memory_t>(resolved_funcs[1]);
-            nt_free_memory = reinterpret_cast<nt_free_virtual_memory_t>(resolved_funcs[2]);
-            nt_query_value = reinterpret_cast<nt_query_system_environment_value_ex_t>(resolved_funcs[3]);
+                        if (ca != cb) break;
+                        ++a;
+                        ++b;
+                    }
 
-            if (!nt_enumerate_values || !nt_allocate_memory || !nt_free_memory || !nt_query_value) break;
+                    if (!*b)
+                        return true;
+                }
 
-            NTSTATUS alloc_status = 0;
-            ULONG buffer_required_length = 0;
+                return false;
+            };
 
-            // ask for size
-            nt_enumerate_values(static_cast<ULONG>(1), nullptr, &buffer_required_length);
+            const bool is_surface_pro = ci_contains(model, "surface pro");
+            const bool is_microsoft = ci_contains(manufacturer, "microsoft");
 
-            if (buffer_required_length != 0) {
-                SIZE_T enum_alloc_size = 0;
-                enum_alloc_size = static_cast<SIZE_T>(buffer_required_length);
-                alloc_status = nt_allocate_memory(current_process_handle, &enum_base_buffer, 0, &enum_alloc_size, static_cast<ULONG>(MEM_COMMIT | MEM_RESERVE), static_cast<ULONG>(PAGE_READWRITE));
+            if (is_surface_pro && is_microsoft) {
+                return false;
+            }
+        }
+        
+        // The RTC (ACPI/CMOS RTC) timer can't be always detected via SetupAPI, it needs AML decode of the DSDT firmware table
+        // The HPET (PNP0103) timer presence check was removed, more info at: https://github.com/NotRequiem/VMAware/pull/616
+        // Here, we check for the PIT/AT timer (PC-class System Timer)
+        const HDEVINFO devs = SetupDiGetClassDevsW(
+            nullptr, nullptr, nullptr, DIGCF_PRESENT | DIGCF_ALLCLASSES);
 
-                if (alloc_status == 0 && enum_base_buffer) {
-                    alloc_status = nt_enumerate_values(static_cast<ULONG>(1), enum_base_buffer, &buffer_required_length);
-                    if (alloc_status != 0) {
-                        SIZE_T zero_size = 0;
-                        nt_free_memory(current_process_handle, &enum_base_buffer, &zero_size, 0x8000);
-                        enum_base_buffer = nullptr;
-                    }
-                }
-            }          
+        if (devs == INVALID_HANDLE_VALUE)
+            return false;
 
-            if (alloc_status != 0 || !enum_base_buffer || buffer_required_length == 0) {
-                debug("NVRAM: System is not UEFI");
-                break;
-            }
+        SP_DEVINFO_DATA dev_info{};
+        dev_info.cbSize = sizeof(dev_info);
 
-            // ---------------------------------------------------------------------
-            // Constants & Data
-            // ---------------------------------------------------------------------
-            constexpr const char redhat_sig_ascii[] = "red hat";
-            constexpr const wchar_t redhat_sig_wide[] = L"red hat";
-            SIZE_T pk_default_len = 0;
-            variable_name_ptr current_var = reinterpret_cast<variable_name_ptr>(enum_base_buffer);
-            const size_t buffer_total_size = static_cast<size_t>(buffer_required_length);
-            constexpr size_t MAX_NAME_BYTE_LIMIT = 4096;
-            bool should_break_loop = false;
+        BYTE* buffer = nullptr;
+        DWORD buffer_size = 0;
+        bool found = false;
 
-            // ---------------------------------------------------------------------
-            // Iteration Loop
-            // ---------------------------------------------------------------------
-            while (true) {
-                const uintptr_t base_address = reinterpret_cast<uintptr_t>(enum_base_buffer);
-                const uintptr_t current_address = reinterpret_cast<uintptr_t>(current_var);
+        for (DWORD i = 0; SetupDiEnumDeviceInfo(devs, i, &dev_info); ++i) {
+            DWORD type = 0;
+            DWORD needed = 0;
 
-                if (current_address < base_address) break;
+            if (SetupDiGetDeviceRegistryPropertyW(
+                devs, &dev_info, SPDRP_HARDWAREID,
+                &type, nullptr, 0, &needed))
+            {
+                continue;
+            }
 
-                const size_t current_offset = static_cast<size_t>(current_address - base_address);
-                if (current_offset >= buffer_total_size) break;
+            if (GetLastError() != ERROR_INSUFFICIENT_BUFFER || needed == 0)
+                continue;
 
-                const size_t name_struct_offset = offsetof(VARIABLE_NAME, Name);
-                if (buffer_total_size - current_offset < name_struct_offset) break;
+            if (needed > buffer_size) {
+                BYTE* new_buffer = static_cast<BYTE*>(
+                    realloc(buffer, needed + sizeof(wchar_t)));
 
-                size_t name_max_bytes = 0;
-                if (current_var->NextEntryOffset != 0) {
-                    const SIZE_T next_entry = static_cast<SIZE_T>(current_var->NextEntryOffset);
-                    if (next_entry <= name_struct_offset) { 
-                        should_break_loop = true; 
-                        break;
-                    }
-                    if (next_entry > buffer_total_size - current_offset) break;
-                    name_max_bytes = next_entry - name_struct_offset;
-                }
-                else {
-                    if (current_offset + name_struct_offset >= buffer_total_size) {
-                        should_break_loop = true;
-                        break; 
-                    }
-                    name_max_bytes = buffer_total_size - (current_offset + name_struct_offset);
+                if (!new_buffer) {
+                    free(buffer);
+                    SetupDiDestroyDeviceInfoList(devs);
+                    return false;
                 }
 
-                if (name_max_bytes > MAX_NAME_BYTE_LIMIT) name_max_bytes = MAX_NAME_BYTE_LIMIT;
+                buffer = new_buffer;
+                buffer_size = needed + sizeof(wchar_t);
+            }
 
-                std::wstring var_name_view;
-                if (name_max_bytes >= sizeof(WCHAR)) {
-                    const WCHAR* name_ptr = reinterpret_cast<const WCHAR*>(reinterpret_cast<const BYTE*>(current_var) + name_struct_offset);
-                    const size_t max_chars = name_max_bytes / sizeof(WCHAR);
-                    size_t real_chars = 0;
-                    while (real_chars < max_chars && name_ptr[real_chars] != L'\0') 
-                        ++real_chars;
-                    if (real_chars == max_chars) { 
-                        should_break_loop = true;
-                        break; 
-                    }
-                    var_name_view = std::wstring(name_ptr, real_chars);
-                }
+            if (!SetupDiGetDeviceRegistryPropertyW(
+                devs, &dev_info, SPDRP_HARDWAREID,
+                &type, buffer, buffer_size, &needed))
+            {
+                continue;
+            }
+
+            if (type != REG_MULTI_SZ)
+                continue;
+
+            reinterpret_cast<wchar_t*>(buffer)[needed / sizeof(wchar_t)] = L'\0';
 
-                // Presence checks
-                if (!var_name_view.empty() && var_name_view.rfind(L"VMM", 0) == 0) {
-                    debug("NVRAM: Detected hypervisor signature");
-                    should_break_loop = true;
+            for (const wchar_t* s = reinterpret_cast<const wchar_t*>(buffer); *s;
+                s += wcslen(s) + 1)
+            {
+                if (_wcsicmp(s, L"ACPI\\PNP0100") == 0 ||
+                    _wcsicmp(s, L"PNP0100") == 0)
+                {
+                    found = true;
                     break;
                 }
+            }
 
-                // Read variables
-                if (var_name_view == L"PKDefault" && pk_default_buf == nullptr)
-                    (void)read_variable_to_buffer(std::wstring(var_name_view), current_var->VendorGuid, pk_default_buf, pk_default_len);
+            if (found)
+                break;
+        }
 
-                if (current_var->NextEntryOffset == 0) break;
-                const SIZE_T next_entry_off = static_cast<SIZE_T>(current_var->NextEntryOffset);
-                const size_t next_var_offset = current_offset + next_entry_off;
-                if (next_var_offset <= current_offset || next_var_offset > buffer_total_size) break;
-                current_var = reinterpret_cast<variable_name_ptr>(reinterpret_cast<PBYTE>(enum_base_buffer) + next_var_offset);
-            }
+        free(buffer);
+        SetupDiDestroyDeviceInfoList(devs);
+        return !found;
+    #endif  
+    }
 
-            if (should_break_loop) break;
 
-            // free enumeration buffer          
-            SIZE_T z = 0;
-            nt_free_memory(current_process_handle, &enum_base_buffer, &z, 0x8000);
-            enum_base_buffer = nullptr;          
+    /**
+     * @brief Check whether the hypervisor correctly handles MSR behavior
+     * @category Windows, x86
+     * @implements VM::MSR
+     */
+    [[nodiscard]] static bool msr() {
+    #if (!x86)
+        return false;
+    #else
+        constexpr u32 random_msr = 0xDEADBEEFu;
 
-            // check for official red hat certs (QEMU/OVMF)
-            bool found_redhat = false;
-            if (pk_default_buf && pk_default_len) {
-                if ((pk_default_len >= 2) && ((pk_default_len % 2) == 0)) {
-                    const WCHAR* wptr = reinterpret_cast<const WCHAR*>(pk_default_buf);
-                    const size_t wlen = pk_default_len / sizeof(WCHAR);
-                    if (buffer_contains_utf16le_ci(wptr, wlen, redhat_sig_wide))
-                        found_redhat = true;
-                }
-                if (!found_redhat)
-                    if (buffer_contains_ascii_ci(pk_default_buf, pk_default_len, redhat_sig_ascii))
-                        found_redhat = true;
+        auto try_read = [](u32 msr_index) -> bool {
+        #if (MSVC)
+            unsigned __int64 value = 0;
+            __try {
+                value = __readmsr(static_cast<unsigned long>(msr_index));
+                (void)value;
+                return true;
             }
-            if (found_redhat) {
-                debug("NVRAM: QEMU/OVMF detected");
-                detection_result = core::add(brand_enum::QEMU);
-                break;
+            __except (EXCEPTION_EXECUTE_HANDLER) {
+                return false;
             }
-        } while (false);
+        #elif (GCC || CLANG)
+            static thread_local bool g_msr_faulted = false;
 
-        // cleanup
-        cleanup(pk_default_buf);
-        cleanup(enum_base_buffer);
+            auto veh_handler = [](PEXCEPTION_POINTERS info) -> LONG {
+                if (info->ExceptionRecord->ExceptionCode == EXCEPTION_PRIV_INSTRUCTION) {
+                    g_msr_faulted = true;
+                    // skip the 'rdmsr' instruction (2 bytes: 0F 32)
+                #if (x86_64)
+                    info->ContextRecord->Rip += 2;
+                #else
+                    info->ContextRecord->Eip += 2;
+                #endif
+                    return EXCEPTION_CONTINUE_EXECUTION;
+                }
+                return EXCEPTION_CONTINUE_SEARCH;
+            };
 
-        if (privilege_state_saved && token_handle)
-            AdjustTokenPrivileges(token_handle, FALSE, &previous_privileges, previous_privileges_size, nullptr, nullptr);
-        
-        if (token_handle) {
-            CloseHandle(token_handle);
-            token_handle = nullptr;
+            const PVOID handle = AddVectoredExceptionHandler(1, veh_handler);
+
+            u32 low, high;
+            asm volatile (
+                "rdmsr"
+                : "=a"(low), "=d"(high)
+                : "c"(msr_index)
+            );
+
+            RemoveVectoredExceptionHandler(handle);
+
+            return !g_msr_faulted;
+        #endif
+        };
+
+        if (try_read(random_msr)) {
+            debug("MSR: Detected hypervisor not correctly handling #GP");
+            return true;
         }
 
-        return detection_result;
+        return false;
+    #endif
     }
 
 
     /**
-     * @brief Check whether the CPU is genuine and its reported instruction capabilities are not masked
+     * @brief Check whether KVM attempts to patch a mismatched hypercall instruction
+     * @link https://lists.nongnu.org/archive/html/qemu-devel/2025-07/msg05044.html
      * @category Windows, x86
-     * @implements VM::CPU_HEURISTIC
+     * @implements VM::KVM_INTERCEPTION
      */
-    [[nodiscard]] static bool cpu_heuristic() {
-        bool spoofed = false;
-    #if (x86)
-        if (util::is_running_under_translator()) {
-            debug("CPU_HEURISTIC: Running inside a binary translation layer");
-            return false;
-        }
+    [[nodiscard]] static bool kvm_interception() {
+    #if (!x86)
+        return false;
+    #else
+        using nt_allocate_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, ULONG_PTR, PSIZE_T, ULONG, ULONG);
+        using nt_protect_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG, PULONG);
+        using nt_free_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG);
+        using nt_flush_instruction_cache_t = NTSTATUS(__stdcall*)(HANDLE, PVOID, SIZE_T);
+        using nt_close_t = NTSTATUS(__stdcall*)(HANDLE);
 
-        // 1) Check for commonly disabled instructions on patches and VMs    
-        u32 a = 0, b = 0, c = 0, d = 0;
-        cpu::cpuid(a, b, c, d, 1u);
+        const HMODULE ntdll = util::get_ntdll();
+        if (!ntdll) return false;
 
-        constexpr u32 AES_NI_BIT = 1u << 25;
-        const bool aes_support = (c & AES_NI_BIT) != 0;
+        const char* names[] = { "NtAllocateVirtualMemory", "NtProtectVirtualMemory", "NtFreeVirtualMemory", "NtFlushInstructionCache", "NtClose" };
+        void* funcs[ARRAYSIZE(names)] = {};
+        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
 
-        alignas(16) unsigned char plaintext[16] = {
-            0x00,0x11,0x22,0x33, 0x44,0x55,0x66,0x77,
-            0x88,0x99,0xAA,0xBB, 0xCC,0xDD,0xEE,0xFF
-        };
-        alignas(16) unsigned char key[16] = {
-            0x0F,0x0E,0x0D,0x0C, 0x0B,0x0A,0x09,0x08,
-            0x07,0x06,0x05,0x04, 0x03,0x02,0x01,0x00
+        const auto nt_allocate_virtual_memory = reinterpret_cast<nt_allocate_virtual_memory_t>(funcs[0]);
+        const auto nt_protect_virtual_memory = reinterpret_cast<nt_protect_virtual_memory_t>(funcs[1]);
+        const auto nt_free_virtual_memory = reinterpret_cast<nt_free_virtual_memory_t>(funcs[2]);
+        const auto nt_flush_instruction_cache = reinterpret_cast<nt_flush_instruction_cache_t>(funcs[3]);
+        const auto nt_close = reinterpret_cast<nt_close_t>(funcs[4]);
+
+        if (!nt_allocate_virtual_memory || !nt_protect_virtual_memory || !nt_free_virtual_memory || !nt_flush_instruction_cache || !nt_close)
+            return false;
+
+        // VMCALL (0F 01 C1) + RET (C3) and VMMCALL (0F 01 D9) + RET (C3)
+        constexpr BYTE opcodes[2][4] = {
+            { 0x0F, 0x01, 0xC1, 0xC3 },
+            { 0x0F, 0x01, 0xD9, 0xC3 }
         };
-        alignas(16) unsigned char out[16] = { 0 };
 
-        // need to do a lambda wrapper to isolate SEH from the parent function's stack unwinding
-        // target aes is required for clang/gcc while in MSVC not, and this target can only be applied to functions, meaning we need a struct
-        struct aes_executor {
-            #if (CLANG || GCC)
-                __attribute__((__target__("aes")))
-            #endif
-            static bool check_aes_integrity(const unsigned char* pt, const unsigned char* k, unsigned char* o, bool support) {
-                __try {
-                    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pt));
-                    __m128i key_vec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(k));
+        const HANDLE current_process = reinterpret_cast<HANDLE>(-1);
+        bool is_kvm_detected = false; // KVM-specific behavior, detector is 100% sure is running under KVM
+        bool generic_hypervisor = false; // behavior present in KVM but other hypervisors might replicate it as well
 
-                    __m128i tmp = _mm_xor_si128(block, key_vec);
-                    tmp = _mm_aesenc_si128(tmp, key_vec);
+        for (int i = 0; i < 2; ++i) {
+            PVOID base_address = nullptr;
+            SIZE_T region_size = 0x1000;
 
-                    _mm_storeu_si128(reinterpret_cast<__m128i*>(o), tmp);
+            // memory as RWX initially to write the opcode
+            NTSTATUS status = nt_allocate_virtual_memory(
+                current_process, &base_address, 0, &region_size,
+                MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
 
-                    if (!support) {
-                        debug("CPU_HEURISTIC: Hypervisor detected hiding AES capabilities");
-                        return true;
-                    }
+            if (!NT_SUCCESS(status))
+                continue;
+
+            // copy stuff to page
+            memcpy(base_address, opcodes[i], sizeof(opcodes[i]));
+
+            nt_flush_instruction_cache(current_process, base_address, sizeof(opcodes[i]));
+
+            ULONG old_protect = 0;
+            PVOID protect_address = base_address;
+            SIZE_T protect_size = region_size;
+
+            // change memory protection to RX because it is what breaks KVM's instruction patching attempt
+            status = nt_protect_virtual_memory(
+                current_process, &protect_address, &protect_size,
+                PAGE_EXECUTE_READ, &old_protect);
+
+            if (NT_SUCCESS(status)) {
+                nt_flush_instruction_cache(current_process, base_address, sizeof(opcodes[i]));
+                DWORD exception_status = 0;
+
+                __try {
+                    const auto execute_hypercall = reinterpret_cast<void(*)()>(base_address);
+                    execute_hypercall();
+                    generic_hypervisor = true; // if no exception occurs then a hypervisor handled it, this is default KVM behavior
+                    debug("KVM_INTERCEPTION: Detected a hypervisor intercepting hypercalls");
                 }
-                __except (GetExceptionCode() == EXCEPTION_ILLEGAL_INSTRUCTION
-                    ? EXCEPTION_EXECUTE_HANDLER
-                    : EXCEPTION_CONTINUE_SEARCH
-                ) {
-                    if (support) {
-                        debug("CPU_HEURISTIC: Hypervisor reports AES, but it is not handled correctly");
-                        return true;
+                __except (exception_status = GetExceptionCode(), EXCEPTION_EXECUTE_HANDLER) {
+                    // if it's #PF instead of #UD then old KVM quirk is present
+                    if (exception_status == EXCEPTION_ACCESS_VIOLATION) {
+                        debug("KVM_INTERCEPTION: Detected KVM attempting to patch instructions on the fly");
+                        is_kvm_detected = true;
                     }
                 }
-                return false;
             }
+
+            SIZE_T free_size = 0;
+            nt_free_virtual_memory(current_process, &base_address, &free_size, MEM_RELEASE);
+
+            if (is_kvm_detected) {
+                return core::add(brand_enum::KVM);
+            }
+            else if (generic_hypervisor) {
+                return true;
+            }
+        }
+ 
+        return false;
+    #endif
+    }
+
+
+    /**
+     * @brief Check whether a hypervisor uses EPT/NPT hooking to intercept hardware breakpoints
+     * @note This hypervisor detection also affects debuggers
+     * @category Windows, x86
+     * @implements VM::HYPERVISOR_HOOK
+     */
+    [[nodiscard]] static bool hypervisor_hook() {
+    #if (!x86)
+        return false;
+    #else
+        if (util::is_running_under_translator()) return false;
+        const HMODULE ntdll = util::get_ntdll();
+        if (!ntdll) return false;
+
+        const char* names[] = {
+            "NtAllocateVirtualMemory",
+            "NtFreeVirtualMemory",
+            "NtGetContextThread",
+            "NtSetContextThread",
+            "RtlAddVectoredExceptionHandler",
+            "RtlRemoveVectoredExceptionHandler",
+            "NtProtectVirtualMemory",
+            "NtQuerySystemInformation",
+            "NtCreateThreadEx",
+            "NtWaitForSingleObject",
+            "NtClose",
+            "NtSetInformationThread"
         };
+        void* funcs[ARRAYSIZE(names)] = {};
+        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
 
-        if (aes_executor::check_aes_integrity(plaintext, key, out, aes_support)) return true;
+        using nt_allocate_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, ULONG_PTR, PSIZE_T, ULONG, ULONG);
+        using nt_free_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG);
+        using net_get_context_thread_t = NTSTATUS(__stdcall*)(HANDLE, PCONTEXT);
+        using nt_set_context_thread_t = NTSTATUS(__stdcall*)(HANDLE, PCONTEXT);
+        using rtl_add_vectored_exception_handler_t = PVOID(__stdcall*)(ULONG, PVECTORED_EXCEPTION_HANDLER);
+        using rtl_remove_vectored_exception_handler_t = ULONG(__stdcall*)(PVOID);
+        using nt_protect_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG, PULONG);
+        using nt_query_system_information_t = NTSTATUS(__stdcall*)(ULONG, PVOID, ULONG, PULONG);
+        using nt_create_thread_ex_t = NTSTATUS(__stdcall*)(PHANDLE, ACCESS_MASK, PVOID, HANDLE, PVOID, PVOID, ULONG, ULONG_PTR, SIZE_T, SIZE_T, PVOID);
+        using nt_wait_for_single_object_t = NTSTATUS(__stdcall*)(HANDLE, BOOLEAN, PLARGE_INTEGER);
+        using nt_close_t = NTSTATUS(__stdcall*)(HANDLE);
+        using nt_set_information_thread_t = NTSTATUS(__stdcall*)(HANDLE, ULONG, PVOID, ULONG);
 
-        const bool avx_support = ((c >> 28) & 1u) != 0;
-        const bool xsave_support = ((c >> 26) & 1u) != 0;
+        // volatile ensures these are loaded from stack after SEH unwind when compiled with aggressive optimizations
+        nt_allocate_virtual_memory_t volatile nt_allocate_virtual_memory = reinterpret_cast<nt_allocate_virtual_memory_t>(funcs[0]);
+        nt_free_virtual_memory_t volatile nt_free_virtual_memory = reinterpret_cast<nt_free_virtual_memory_t>(funcs[1]);
+        net_get_context_thread_t volatile nt_get_context_thread = reinterpret_cast<net_get_context_thread_t>(funcs[2]);
+        nt_set_context_thread_t volatile nt_set_context_thread = reinterpret_cast<nt_set_context_thread_t>(funcs[3]);
+        rtl_add_vectored_exception_handler_t volatile rtl_add_vectored_exception_handler = reinterpret_cast<rtl_add_vectored_exception_handler_t>(funcs[4]);
+        rtl_remove_vectored_exception_handler_t volatile rtl_remove_vectored_exception_handler = reinterpret_cast<rtl_remove_vectored_exception_handler_t>(funcs[5]);
+        nt_protect_virtual_memory_t volatile nt_protect_virtual_memory = reinterpret_cast<nt_protect_virtual_memory_t>(funcs[6]);
 
-        if (avx_support && !xsave_support) {
-            debug("CPU_HEURISTIC: YMM state not correct for a baremetal machine");
-            return true;
+        nt_query_system_information_t volatile nt_query_system_information = reinterpret_cast<nt_query_system_information_t>(funcs[7]);
+        nt_create_thread_ex_t volatile nt_create_thread_ex = reinterpret_cast<nt_create_thread_ex_t>(funcs[8]);
+        nt_wait_for_single_object_t volatile nt_wait_for_single_object = reinterpret_cast<nt_wait_for_single_object_t>(funcs[9]);
+        nt_close_t volatile nt_close = reinterpret_cast<nt_close_t>(funcs[10]);
+        nt_set_information_thread_t volatile nt_set_information_thread = reinterpret_cast<nt_set_information_thread_t>(funcs[11]);
+
+        if (!nt_allocate_virtual_memory || !nt_free_virtual_memory || !nt_get_context_thread ||
+            !nt_set_context_thread || !rtl_add_vectored_exception_handler || !rtl_remove_vectored_exception_handler ||
+            !nt_protect_virtual_memory || !nt_query_system_information || !nt_create_thread_ex ||
+            !nt_wait_for_single_object || !nt_close || !nt_set_information_thread) {
+            return false;
         }
 
-        const bool rdrand_support = ((c >> 30) & 1u) != 0;
+        HANDLE current_process = reinterpret_cast<HANDLE>(-1);
+        HANDLE current_thread = reinterpret_cast<HANDLE>(-2);
 
-        auto check_rdrand_integrity = [&]() -> bool {
+        // explicitly decay lambdas to raw function pointers to eliminate C2712 unwinding requirement errors
+        using execute_throws_t = bool(*)(void*);
+        execute_throws_t execute_throws = [](void* pointer) -> bool {
             __try {
-                unsigned int v = 0;
-            #if (MSVC && !CLANG)
-                if (_rdrand32_step(&v) && !rdrand_support) {
-                    debug("CPU_HEURISTIC: Hypervisor detected hiding RDRAND capabilities");
-                    return true;
-                }
-            #else 
-                unsigned char ok = 0;
-                asm volatile("rdrand %0\n\tsetc %1" : "=r"(v), "=qm"(ok) : : "cc");
-                if (ok && !rdrand_support) {
-                    debug("CPU_HEURISTIC: Hypervisor detected hiding RDRAND capabilities");
-                    return true;
-                }
-            #endif      
+                util::execute_unchecked(pointer); // breakpoint hit
             }
-            __except (GetExceptionCode() == EXCEPTION_ILLEGAL_INSTRUCTION
-                ? EXCEPTION_EXECUTE_HANDLER
-                : EXCEPTION_CONTINUE_SEARCH) {
-                if (rdrand_support) {
-                    debug("CPU_HEURISTIC: Hypervisor reports RDRAND, but it is not handled correctly");
-                    return true;
-                }
+            __except (EXCEPTION_EXECUTE_HANDLER) {
+                return true;
             }
             return false;
         };
 
-        if (check_rdrand_integrity()) return true;
+        using find_double_cc_ntdll_t = void* (*)(HMODULE);
+        find_double_cc_ntdll_t find_double_cc_ntdll = [](HMODULE module) -> void* {
+            if (!module) return nullptr;
 
-        // 2. Test if the CPU vendor is spoofed (for example, a CPU reports being AMD in CPUID, but it is Intel)
-        /*
-            For this task, we want a instruction that:
-            1. It is vendor-only, meaning that other CPU vendors never implemented the same instruction on their microcode
-                -> Note: Even if an instruction is vendor-only, it may be treated as a NOP by other CPU vendors, we don't want this
-            2. Is compatible enough, meaning both old and new CPUs of this vendor have it
-            3. Is enabled by default, without needing BIOS/OS changes
-            4. Never switches to kernel-mode, so that is harder to intercept
-            5. Is not deprecated today
-            6. Its side-effects can be measured from CPL3 (user-mode)
+            // parse PE headers to find executable sections
+            auto* dos_header = reinterpret_cast<PIMAGE_DOS_HEADER>(module);
+            if (dos_header->e_magic != IMAGE_DOS_SIGNATURE) return nullptr;
 
-            On Intel, most options are unreliable:
-            SGX are deprecated and disabled by default, MPX is deprecated and treated as NOP even in AMD CPUs, AVX-512 is not found in all processors (and AMD integrated part of this set), etc
-            On AMD, 3dNow! could be an option, but since its being deprecated, CLZERO fits this criteria better
+            auto* nt_headers = reinterpret_cast<PIMAGE_NT_HEADERS>(reinterpret_cast<u8*>(module) + dos_header->e_lfanew);
+            if (nt_headers->Signature != IMAGE_NT_SIGNATURE) return nullptr;
 
-            So for example, if the CPU reports being Intel, and succesfully runs CLZERO without a NOP, then it's not an Intel CPU.
-        */
+            auto* section = IMAGE_FIRST_SECTION(nt_headers);
+            for (WORD i = 0; i < nt_headers->FileHeader.NumberOfSections; ++i, ++section) {
 
-        // AMD stub template (mov rax, imm64 + clzero + ret)
-        // 8-byte immediate at runtime at offsets [2..9]
-        u8 amd_bytes[] = {
-            0x48, 0xB8,                 // mov rax, imm64
-            0x00, 0x00, 0x00, 0x00,     // imm64 low bytes (placeholder)
-            0x00, 0x00, 0x00, 0x00,     // imm64 high bytes (placeholder)
-            0x0F, 0x01, 0xFC,           // clzero
-            0xC3                        // ret
-        };
-        constexpr SIZE_T amd_stub_size = sizeof(amd_bytes); // 14
+                // only scan memory marked as executable
+                if ((section->Characteristics & IMAGE_SCN_MEM_EXECUTE) != 0) {
+                    u8* ptr = reinterpret_cast<u8*>(module) + section->VirtualAddress;
+                    size_t size = section->Misc.VirtualSize;
 
-        const u8* bytes = nullptr;
-        SIZE_T codeSize = 0;
+                    if (size < 2) {
+                        continue;
+                    }
 
-        LPVOID amd_target_mem = nullptr;
-        LPVOID exec_mem = nullptr;
-        PVOID free_base = nullptr;
-        SIZE_T free_size = 0;
+                    for (size_t j = 0; j < size - 1; ++j) {
+                        if (ptr[j] == 0xCC && ptr[j + 1] == 0xCC) {
+                            // by returning ptr[j + 1], executing it will safely run 0xC3 (after overwrite)
+                            // if we overwrite j+1 with 0xC3 and call it, it immediately returns
+                            return &ptr[j + 1];
+                        }
+                    }
+                }
+            }
+            return nullptr;
+        };
 
-        const bool claimed_amd = cpu::is_amd();
-        const bool claimed_intel = cpu::is_intel();
+        using find_double_cc_t = void* (*)(void*);
+        find_double_cc_t find_double_cc = [](void* pointer_in_page) -> void* {
+            // align down to the start of the 4KB page
+            auto* ptr = reinterpret_cast<u8*>(reinterpret_cast<uintptr_t>(pointer_in_page) & ~0xFFF);
 
-        if (!claimed_amd && !claimed_intel) {
-            debug("CPU_HEURISTIC: x86 CPU vendor was not recognized as either Intel or AMD");
-            return false; // Zhaoxin? VIA/Centaur?
-        }
+            for (size_t i = 0; i < (0x1000 - 1); ++i) {
+                if (ptr[i] == 0xCC && ptr[i + 1] == 0xCC) {
+                    return &ptr[i + 1];
+                }
+            }
+            return nullptr;
+        };
 
-        bool proceed = true;
-        bool exception = false;
+        void* pointer = find_double_cc_ntdll(ntdll);
+        if (!pointer) {
+            void* current_func_ptr = reinterpret_cast<void*>(&hypervisor_hook);
+            pointer = find_double_cc(current_func_ptr);
+            if (!pointer) return false;
+        }
 
-        // A case where this check could false flag is when analyzing the AMD PRO A8-9600B CPU
-        // is based on the "Bristol Ridge" platform, which uses the Excavator microarchitecture (the 4th and final generation of the Bulldozer family)
-        // Excavator CPUs do not possess the CLZERO instruction
-        if (claimed_amd) {
-            cpu::model_struct model = cpu::get_model();
-            if (!model.is_ryzen) {
-                debug("CPU_HEURISTIC: CPU is AMD but not Ryzen (Pre-Zen). Skipping CLZERO check");
-                proceed = false;
-            }
+        // executing CC natively should throw
+        if (!execute_throws(pointer)) {
+            return false; // SEH is broken or code isn't actually CC
         }
 
-        if (claimed_intel || !claimed_amd) exception = true; // should generate an exception rather than be treated as a NOP, but we will check its side effects anyways
+        // overwrite CC with C3 (RET)
+        PVOID base_address = pointer;
+        SIZE_T prot_region_size = 1;
+        ULONG old_protect = 0;
 
-        // one cache line = 64 bytes
-        const SIZE_T target_size = 64;
+        // NtProtectVirtualMemory modifies BaseAddress and RegionSize to page boundaries,
+        // so we must reset them on subsequent calls
+        NTSTATUS status = nt_protect_virtual_memory(current_process, &base_address, &prot_region_size, PAGE_EXECUTE_READWRITE, &old_protect);
+        if (status < 0) return false;
 
-        const HMODULE ntdll = util::get_ntdll();
-        if (!ntdll) return false;
+        *static_cast<volatile u8*>(pointer) = 0xC3;
 
-        const char* names[] = { "NtAllocateVirtualMemory", "NtProtectVirtualMemory", "NtFlushInstructionCache", "NtFreeVirtualMemory" };
-        void* funcs[ARRAYSIZE(names)] = {};
-        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+        base_address = pointer;
+        prot_region_size = 1;
+        ULONG dummy_protect = 0;
+        status = nt_protect_virtual_memory(current_process, &base_address, &prot_region_size, old_protect, &dummy_protect);
+        if (status < 0) return false;
 
-        using NtAllocateVirtualMemory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, ULONG_PTR, PSIZE_T, ULONG, ULONG);
-        using NtProtectVirtualMemory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG, PULONG);
-        using NtFreeVirtualMemory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG);
-        using NtFlushInstructionCache_t = NTSTATUS(__stdcall*)(HANDLE, PVOID, SIZE_T);
-        const auto nt_allocate_virtual_memory = reinterpret_cast<NtAllocateVirtualMemory_t>(funcs[0]);
-        const auto nt_protect_virtual_memory = reinterpret_cast<NtProtectVirtualMemory_t>(funcs[1]);
-        const auto nt_flush_instruction_cache = reinterpret_cast<NtFlushInstructionCache_t>(funcs[2]);
-        const auto nt_free_virtual_memory = reinterpret_cast<NtFreeVirtualMemory_t>(funcs[3]);
+        bool hook_detected = false;
 
-        if (!nt_allocate_virtual_memory || !nt_protect_virtual_memory || !nt_flush_instruction_cache || !nt_free_virtual_memory) {
-            return false;
+        // test if write was swallowed by the hypervisor on the current core
+        if (execute_throws(pointer)) {
+            hook_detected = true;
         }
+        else {
+            // now try on all cores, total hardware processors
+            struct SYSTEM_BASIC_INFORMATION_LOCAL {
+                ULONG Reserved;
+                ULONG TimerResolution;
+                ULONG PageSize;
+                ULONG NumberOfPhysicalPages;
+                ULONG LowestPhysicalPageNumber;
+                ULONG HighestPhysicalPageNumber;
+                ULONG AllocationGranularity;
+                ULONG_PTR MinimumUserModeAddress;
+                ULONG_PTR MaximumUserModeAddress;
+                ULONG_PTR ActiveProcessorsAffinityMask;
+                CCHAR NumberOfProcessors;
+            };
 
-        const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
-
-        {
-            PVOID base = nullptr;
-            SIZE_T sz = target_size;
-            NTSTATUS st2 = nt_allocate_virtual_memory(current_process, &base, 0, &sz, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-            if (!NT_SUCCESS(st2) || base == nullptr) {
-                proceed = false;
-            }
-            else {
-                amd_target_mem = base;
-                // fill target with a recognizable non-zero pattern so we can detect CLZERO's effect (in case some obscure Intel CPU treat our instruction as a NOP)
-                memset(amd_target_mem, 0xA5, target_size);
+            SYSTEM_BASIC_INFORMATION_LOCAL sys_info{};
+            ULONG ret_len = 0;
+            ULONG num_processors = 1;
 
-                const std::uintptr_t paddr = reinterpret_cast<std::uintptr_t>(amd_target_mem); // to avoid sign-extension, 32-bit compatible
-                const u64 addr = static_cast<u64>(paddr);
-                for (u8 i = 0; i < 8; ++i) {
-                    amd_bytes[2 + i] = static_cast<u8>((addr >> (i * 8)) & 0xFF);
-                }
-                bytes = amd_bytes;
-                codeSize = amd_stub_size;
+            // 0 = SystemBasicInformation
+            status = nt_query_system_information(0, &sys_info, sizeof(sys_info), &ret_len);
+            if (status < 0) {
+                return false;
             }
-        }
+            num_processors = sys_info.NumberOfProcessors;
 
-        if (proceed) {
-            PVOID base = nullptr;
-            SIZE_T sz = codeSize;
-            NTSTATUS st2 = nt_allocate_virtual_memory(current_process, &base, 0, &sz, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-            if (NT_SUCCESS(st2) && base != nullptr) {
-                exec_mem = base;
-                memcpy(exec_mem, bytes, codeSize);
+            volatile LONG did_anyone_throw = 0;
 
-                // change to RX
-                ULONG oldProt = 0;
-                PVOID tmp_base = exec_mem;
-                SIZE_T tmp_sz = codeSize;
-                st2 = nt_protect_virtual_memory(current_process, &tmp_base, &tmp_sz, PAGE_EXECUTE_READ, &oldProt);
-                if (NT_SUCCESS(st2)) {
-                    nt_flush_instruction_cache(current_process, exec_mem, codeSize);
+            for (ULONG i = 0; i < num_processors && i < 256; ++i) {
+                // pin the current thread to physical core i
+                ULONG_PTR affinity = (ULONG_PTR)1 << i;
+                status = nt_set_information_thread(current_thread, 4 /* ThreadAffinityMask */, &affinity, sizeof(affinity));
+                if (status < 0) {
+                    return false;
+                }
 
-                    using code_func = void(*)();
-                    using runner_func = u8(*)(code_func);
-                    runner_func runner = +[](code_func func) -> u8 {
-                        __try {
-                            func();
-                            return 0;
-                        }
-                        __except (GetExceptionCode() == EXCEPTION_ILLEGAL_INSTRUCTION ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH) {
-                            return 1;
-                        }
-                    };
+                __try {
+                    util::execute_unchecked(pointer);
+                }
+                __except (EXCEPTION_EXECUTE_HANDLER) {
+                    did_anyone_throw = 1;
+                }
+            }
 
-                    const u8 runner_rc = runner(reinterpret_cast<code_func>(exec_mem));
+            if (did_anyone_throw != 0) {
+                hook_detected = true;
+            }
+        }
 
-                    // check if the target buffer was written to zero by CLZERO
-                    bool memory_all_zero = false;
-                    if (amd_target_mem) {
-                        volatile u8* p = reinterpret_cast<volatile u8*>(amd_target_mem);
-                        memory_all_zero = true;
-                        for (SIZE_T i = 0; i < target_size; ++i) {
-                            if (p[i] != 0) { memory_all_zero = false; break; }
-                        }
-                    }
+        PVOID src_page = nullptr;
+        PVOID dst_page = nullptr;
+        SIZE_T region_size = 0x2000;
 
-                    if (runner_rc == 0 && exception) {
-                        // only treat as spoofed if the CLZERO execution actually zeroed the target memory
-                        if (memory_all_zero) {
-                            debug("CPU_HEURISTIC: CPU reports being Intel, but VMAware detected a hypervisor running an AMD CPU in the host"); // or another CPU vendor
-                            spoofed = true;
-                        }
-                        else {
-                            debug("CPU_HEURISTIC: CLZERO returned without exception but target memory was NOT zeroed (NOP/emulated)");
-                        }
-                    }
-                    else if (runner_rc == 1 && !exception) {
-                        debug("CPU_HEURISTIC: CPU reports being AMD, but VMAware detected a hypervisor running an Intel CPU in the host"); // or another CPU vendor
-                        spoofed = true;
-                    }
-                    else if (runner_rc == 0 && !exception) {
-                        if (!memory_all_zero) {
-                            debug("CPU_HEURISTIC: CPU reports being AMD, CLZERO executed but did NOT zero the target memory");
-                            spoofed = true;
-                        }
-                    }
-                }
+        // allocate source and destination pages
+        const NTSTATUS status_src = nt_allocate_virtual_memory(current_process, &src_page, 0, &region_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        const NTSTATUS status_dst = nt_allocate_virtual_memory(current_process, &dst_page, 0, &region_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+
+        if (status_src < 0 || status_dst < 0) {
+            if (src_page) {
+                SIZE_T free_size = 0;
+                nt_free_virtual_memory(current_process, &src_page, &free_size, MEM_RELEASE);
+            }
+            if (dst_page) {
+                SIZE_T free_size = 0;
+                nt_free_virtual_memory(current_process, &dst_page, &free_size, MEM_RELEASE);
             }
+            return false;
         }
 
-        if (exec_mem) {
-            free_base = exec_mem; free_size = 0;
-            nt_free_virtual_memory(current_process, &free_base, &free_size, MEM_RELEASE);
-            exec_mem = nullptr;
-        }
-        if (amd_target_mem) {
-            free_base = amd_target_mem; free_size = 0;
-            nt_free_virtual_memory(current_process, &free_base, &free_size, MEM_RELEASE);
-            amd_target_mem = nullptr;
-        }
+        // initialize src memory
+        __stosb(static_cast<PBYTE>(src_page), 0xAB, 0x2000);
 
-        if (spoofed) return spoofed;
+        thread_local static volatile bool ermsb_trap_detected = false;
+        ermsb_trap_detected = false;
 
-        // ok so if the CPU is intel, the motherboard should be intel aswell (and same with AMD)
-        // this doesnt happen in most public hardened configs out there so lets abuse it
-        static constexpr unsigned int VID_INTEL = 0x8086;
-        static constexpr unsigned int VID_AMD_ATI = 0x1002;
-        static constexpr unsigned int VID_AMD_MICRO = 0x1022;
+        // capture-less local lambda decays to PVECTORED_EXCEPTION_HANDLER function pointer
+        auto veh_handler = [](PEXCEPTION_POINTERS ctx) -> LONG {
+            if (ctx->ExceptionRecord->ExceptionCode == EXCEPTION_SINGLE_STEP) {
+                ermsb_trap_detected = true;
+                return EXCEPTION_CONTINUE_EXECUTION;
+            }
+            return EXCEPTION_CONTINUE_SEARCH;
+        };
 
-        enum class MBVendor { Unknown = 0, Intel = 1, AMD = 2 };
+        const PVOID veh_handle = rtl_add_vectored_exception_handler(1, static_cast<PVECTORED_EXCEPTION_HANDLER>(veh_handler));
+        if (!veh_handle) {
+            SIZE_T free_size = 0;
+            nt_free_virtual_memory(current_process, &src_page, &free_size, MEM_RELEASE);
+            nt_free_virtual_memory(current_process, &dst_page, &free_size, MEM_RELEASE);
+            return false;
+        }
 
-        auto detect_motherboard = []() noexcept -> MBVendor {
-            static constexpr const wchar_t* TOKENS[] = {
-                L"host bridge", L"northbridge", L"southbridge", L"pci bridge", L"chipset", L"pch", L"fch",
-                L"platform controller", L"lpc", L"sata controller", L"ahci", L"ide controller", L"usb controller",
-                L"xhci", L"usb3", L"usb 3.0", L"usb 3", L"pcie root", L"pci express", L" sata", nullptr
-            };
+        CONTEXT ctx{};
+        ctx.ContextFlags = CONTEXT_DEBUG_REGISTERS;
+        status = nt_get_context_thread(current_thread, &ctx);
 
-            auto contains_token = [](const wchar_t* haystack) noexcept -> bool {
-                if (!haystack) return false;
-                for (const wchar_t* const* t = TOKENS; *t; ++t) {
-                    const wchar_t* needle = *t;
-                    const wchar_t* h = haystack;
+        if (status < 0) {
+            rtl_remove_vectored_exception_handler(veh_handle);
+            SIZE_T free_size = 0;
+            nt_free_virtual_memory(current_process, &src_page, &free_size, MEM_RELEASE);
+            nt_free_virtual_memory(current_process, &dst_page, &free_size, MEM_RELEASE);
+            return false;
+        }
 
-                    // naive scan is faster than BM/KMP for very short needles/haystacks
-                    while (*h) {
-                        const wchar_t* h_iter = h;
-                        const wchar_t* n_iter = needle;
+        // set hw breakpoint inside the source page
+        ctx.Dr0 = reinterpret_cast<DWORD64>(src_page) + 0x1000;
 
-                        while (*n_iter) {
-                            wchar_t hc = *h_iter;
-                            if (hc >= L'A' && hc <= L'Z') hc += 32;
+        // Dr7 = 0x30001
+        // bit 0      = 1
+        // bits 17:16 = 11b
+        // bits 19:18 = 00b
+        ctx.Dr7 = 0x30001;
+        status = nt_set_context_thread(current_thread, &ctx);
+        if (status < 0) {
+            rtl_remove_vectored_exception_handler(veh_handle);
+            SIZE_T free_size = 0;
+            nt_free_virtual_memory(current_process, &src_page, &free_size, MEM_RELEASE);
+            nt_free_virtual_memory(current_process, &dst_page, &free_size, MEM_RELEASE);
+            return false;
+        }
 
-                            if (hc != *n_iter) break;
-                            h_iter++;
-                            n_iter++;
-                        }
+        __try {
+            __movsb(static_cast<PBYTE>(dst_page), static_cast<PBYTE>(src_page), 0x2000);
+        }
+        __except (EXCEPTION_EXECUTE_HANDLER) {
+            // veh will already detect if Dr0 fired successfully
+        }
 
-                        if (!*n_iter) return true; 
-                        h++;
-                    }
-                }
-                return false;
-            };
+        rtl_remove_vectored_exception_handler(veh_handle);
 
-            auto find_vendor_hex = [](const wchar_t* wptr) noexcept -> u32 {
-                if (!wptr) return 0;
-                const wchar_t* p = wptr;
-                while (*p) {
-                    // Check for "VEN_" (case-insensitive)
-                    if (((p[0] | 0x20) == L'v') &&
-                        ((p[1] | 0x20) == L'e') &&
-                        ((p[2] | 0x20) == L'n') &&
-                        (p[3] == L'_')) {
+        ctx.Dr0 = 0;
+        ctx.Dr7 = 0;
+        status = nt_set_context_thread(current_thread, &ctx);
+        if (status < 0) {
+            SIZE_T free_size = 0;
+            nt_free_virtual_memory(current_process, &src_page, &free_size, MEM_RELEASE);
+            nt_free_virtual_memory(current_process, &dst_page, &free_size, MEM_RELEASE);
+            return false;
+        }
 
-                        const wchar_t* q = p + 4;
-                        u32 val = 0;
-                        int got = 0;
-                        while (got < 4 && *q) {
-                            const wchar_t c = *q;
-                            u32 nib = 0;
-                            if (c >= L'0' && c <= L'9') 
-                                nib = static_cast<u32>(c - L'0');
-                            else if ((c | 0x20) >= L'a' && (c | 0x20) <= L'f') 
-                                nib = static_cast<u32>((c | 0x20) - L'a' + 10);
-                            else
-                                break;
+        SIZE_T free_size = 0;
+        nt_free_virtual_memory(current_process, &src_page, &free_size, MEM_RELEASE);
+        nt_free_virtual_memory(current_process, &dst_page, &free_size, MEM_RELEASE);
 
-                            val = (val << 4) | nib;
-                            ++got; ++q;
-                        }
-                        if (got == 4) return val;
-                    }
-                    ++p;
-                }
-                return 0;
-            };
+        return hook_detected || !ermsb_trap_detected;
+    #endif
+    }
 
-            // setupapi stuff
-            int intel_hits = 0;
-            int amd_hits = 0;
 
-            wchar_t stack_buf[1024]{};
-            std::vector<BYTE> heap_buf; // fallback for rare huge strings
+    /**
+     * @brief Check whether a hypervisor delays trap flags over exiting instructions
+     * @category Windows, x86
+     * @implements VM::SINGLE_STEP
+     */
+    [[nodiscard]] static bool single_step() {
+    #if (!x86)
+        return false;
+    #else
+        const HMODULE ntdll = util::get_ntdll();
+        if (!ntdll) return false;
 
-            auto scan_devices = [&](const GUID* classGuid, DWORD flags) noexcept {
-                HDEVINFO handle_dev_info = SetupDiGetClassDevsW(classGuid, nullptr, nullptr, flags);
-                if (handle_dev_info == INVALID_HANDLE_VALUE) return;
+        const char* names[] = {
+            "NtAllocateVirtualMemory",
+            "NtProtectVirtualMemory",
+            "NtFlushInstructionCache",
+            "NtFreeVirtualMemory"
+        };
 
-                SP_DEVINFO_DATA dev_info_data{};
-                dev_info_data.cbSize = sizeof(SP_DEVINFO_DATA);
+        void* funcs[ARRAYSIZE(names)] = {};
+        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
 
-                for (DWORD i = 0; SetupDiEnumDeviceInfo(handle_dev_info, i, &dev_info_data); ++i) {
+        using NtAllocateVirtualMemory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, ULONG_PTR, PSIZE_T, ULONG, ULONG);
+        using NtProtectVirtualMemory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG, PULONG);
+        using NtFlushInstructionCache_t = NTSTATUS(__stdcall*)(HANDLE, PVOID, SIZE_T);
+        using NtFreeVirtualMemory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG);
 
-                    const wchar_t* w_desc = nullptr;
-                    DWORD req_size = 0;
-                    DWORD prop_type = 0;
+        const auto nt_allocate_virtual_memory = reinterpret_cast<NtAllocateVirtualMemory_t>(funcs[0]);
+        const auto nt_protect_virtual_memory = reinterpret_cast<NtProtectVirtualMemory_t>(funcs[1]);
+        const auto nt_flush_instruction_cache = reinterpret_cast<NtFlushInstructionCache_t>(funcs[2]);
+        const auto nt_free_virtual_memory = reinterpret_cast<NtFreeVirtualMemory_t>(funcs[3]);
 
-                    if (SetupDiGetDeviceRegistryPropertyW(handle_dev_info, &dev_info_data, SPDRP_DEVICEDESC, &prop_type, reinterpret_cast<PBYTE>(stack_buf), sizeof(stack_buf), &req_size)) {
-                        w_desc = stack_buf;
-                    }
-                    else if (GetLastError() == ERROR_INSUFFICIENT_BUFFER) {
-                        if (heap_buf.size() < req_size) heap_buf.resize(req_size);
-                        if (SetupDiGetDeviceRegistryPropertyW(handle_dev_info, &dev_info_data, SPDRP_DEVICEDESC, &prop_type, heap_buf.data(), req_size, nullptr)) {
-                            w_desc = reinterpret_cast<const wchar_t*>(heap_buf.data());
-                        }
-                    }
+        if (!nt_allocate_virtual_memory || !nt_protect_virtual_memory ||
+            !nt_flush_instruction_cache || !nt_free_virtual_memory) {
+            return false;
+        }
 
-                    // check if the description contains any interesting stuff
-                    if (w_desc && contains_token(w_desc)) {
+        const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
 
-                        // if interesting get hwid to get vendor
-                        const wchar_t* w_hardware_id = nullptr;
+        constexpr unsigned char shellcode[] = {
+            0x9C,                                     // pushfq (x64) / pushfd (x86)
+            0x81, 0x0C, 0x24, 0x00, 0x01, 0x00, 0x00, // or dword ptr [rsp/esp], 0x100 (sets TF)
+            0x9D,                                     // popfq (x64) / popfd (x86)
+            0x31, 0xC0,                               // xor eax, eax
+            0x0F, 0xA2,                               // cpuid
+            0xC7, 0xB2,                               // db 0xC7, 0xB2 (invalid opcode)
+            0xC3                                      // ret
+        };
 
-                        if (SetupDiGetDeviceRegistryPropertyW(handle_dev_info, &dev_info_data, SPDRP_HARDWAREID, &prop_type, reinterpret_cast<PBYTE>(stack_buf), sizeof(stack_buf), &req_size)) {
-                            w_hardware_id = stack_buf;
-                        }
-                        else if (GetLastError() == ERROR_INSUFFICIENT_BUFFER) {
-                            if (heap_buf.size() < req_size) heap_buf.resize(req_size);
-                            if (SetupDiGetDeviceRegistryPropertyW(handle_dev_info, &dev_info_data, SPDRP_HARDWAREID, &prop_type, heap_buf.data(), req_size, nullptr)) {
-                                w_hardware_id = reinterpret_cast<const wchar_t*>(heap_buf.data());
-                            }
-                        }
+        PVOID base_address = nullptr;
+        SIZE_T region_size = sizeof(shellcode);
+        constexpr u32 STATUS_SUCCESS = 0x00000000u;
 
-                        if (w_hardware_id) {
-                            const u32 vid = find_vendor_hex(w_hardware_id);
-                            if (vid == VID_INTEL) intel_hits++;
-                            else if (vid == VID_AMD_ATI || vid == VID_AMD_MICRO) amd_hits++;
-                        }
-                    }
-                }
-                SetupDiDestroyDeviceInfoList(handle_dev_info);
-            };
+        if (nt_allocate_virtual_memory(current_process, &base_address, 0, &region_size,
+            MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE) != STATUS_SUCCESS) {
+            return false;
+        }
 
-            // GUID_DEVCLASS_SYSTEM covers Host Bridges, LPC, PCI bridges Chipset/CPU etc
-            // GUID_DEVCLASS_USB covers USB controller stuff
-            // GUID_DEVCLASS_HDC covers SATA/IDE
-            const GUID* interesting_classes[] = {
-                &GUID_DEVCLASS_SYSTEM,
-                &GUID_DEVCLASS_USB,
-                &GUID_DEVCLASS_HDC
-            };
+        memcpy(base_address, shellcode, sizeof(shellcode));
 
-            for (const GUID* guid : interesting_classes) {
-                scan_devices(guid, DIGCF_PRESENT);
-            }
+        ULONG old_protect = 0;
+        SIZE_T protect_size = sizeof(shellcode);
+        if (nt_protect_virtual_memory(current_process, &base_address, &protect_size,
+            PAGE_EXECUTE_READ, &old_protect) != STATUS_SUCCESS) {
+            SIZE_T free_size = 0; 
+            nt_free_virtual_memory(current_process, &base_address, &free_size, MEM_RELEASE);
+            return false;
+        }
 
-            // if no stuff then maybe query all devices in the system?
-            if (intel_hits == 0 && amd_hits == 0) {
-                scan_devices(nullptr, DIGCF_ALLCLASSES | DIGCF_PRESENT);
-            }
+        nt_flush_instruction_cache(current_process, base_address, sizeof(shellcode));
 
-            if (intel_hits > amd_hits) return MBVendor::Intel;
-            if (amd_hits > intel_hits) return MBVendor::AMD;
-            return MBVendor::Unknown;
-        };
+        bool is_vm = false;
+        DWORD exc_code = 0;
 
-        const MBVendor vendor = detect_motherboard();
+        __try {
+            using func_ptr = void(*)();
+            const auto func = reinterpret_cast<func_ptr>(base_address);
+            func();
 
-        switch (vendor) {
-        case MBVendor::Intel:
-            if (claimed_amd && !claimed_intel) {
-                debug("CPU_HEURISTIC: CPU reports AMD but chipset looks Intel");
-                spoofed = true;
+            is_vm = true;
+        }
+        __except (exc_code = GetExceptionCode(), EXCEPTION_EXECUTE_HANDLER) {
+            if (exc_code == EXCEPTION_SINGLE_STEP) {
+                // trap flag single-step exception triggered on CPUID
+                is_vm = false;
             }
-            break;
-        case MBVendor::AMD:
-            if (claimed_intel && !claimed_amd) {
-                debug("CPU_HEURISTIC: CPU reports Intel but chipset looks AMD");
-                spoofed = true;
+            else {
+                // hypervisor delayed the trap flag over cpuid, execution fell through into 
+                // the bad bytes (C7 B2) causing EXCEPTION_ILLEGAL_INSTRUCTION
+                is_vm = true;
             }
-            break;
-        case MBVendor::Unknown:
-            debug("CPU_HEURISTIC: Could not determine chipset vendor");
-            break;
         }
+
+        SIZE_T free_size = 0; 
+        nt_free_virtual_memory(current_process, &base_address, &free_size, MEM_RELEASE);
+
+        return is_vm;
     #endif
-        return spoofed;
     }
 
 
     /**
-     * @brief Check the presence of system timers
-     * @category x86, Windows
-     * @implements VM::CLOCK
+     * @brief Check whether a hypervisor does not correctly emulate instructions in compatibility mode
+     * @category Windows, x86_64
+     * @implements VM::EIP_OVERFLOW
      */
-    [[nodiscard]] static bool clock() {
-    #if (ARM)
-		return false; // ARM systems do not have the classic x86 timers
+    [[nodiscard]] static bool eip_overflow() {
+    #if (!x86_64) 
+        // this requires mapping executable memory at the end of the 4GB address space (0xFFFF0000) so an instruction can wrap the 32 bit boundary
+        // because NtAllocateVirtualMemory will always return 0xC0000018 (STATUS_CONFLICTING_ADDRESSES) we physically cannot place an instruction at 0xFFFFFFFE
+        return false; 
     #else   
-		if (util::is_running_under_translator()) {
-            debug("CLOCK: Running inside an ARM CPU");
+        #pragma pack(push, 1)
+        struct iretq_frame {
+            u64 ip;
+            u64 cs;
+        };
+        #pragma pack(pop)
+
+        static bool hypervisor_detected = true;
+        static uintptr_t g_recovery_pad = 0;
+        static u64 g_saved_rsp = 0;
+
+        const HMODULE ntdll = util::get_ntdll();
+        if (!ntdll) return false;
+
+        const char* names[] = {
+            "NtAllocateVirtualMemory",
+            "NtProtectVirtualMemory",
+            "NtFlushInstructionCache",
+            "NtFreeVirtualMemory",
+            "RtlAddVectoredExceptionHandler",
+            "RtlRemoveVectoredExceptionHandler"
+        };
+
+        void* funcs[ARRAYSIZE(names)] = {};
+        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+
+        using nt_allocate_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, ULONG_PTR, PSIZE_T, ULONG, ULONG);
+        using nt_protect_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG, PULONG);
+        using nt_flush_instruction_cache_t = NTSTATUS(__stdcall*)(HANDLE, PVOID, SIZE_T);
+        using nt_free_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG);
+        using rtl_add_vectored_exception_handler_t = PVOID(__stdcall*)(ULONG, PVECTORED_EXCEPTION_HANDLER);
+        using rtl_remove_vectored_exception_handler_t = ULONG(__stdcall*)(PVOID);
+
+        const auto nt_allocate_virtual_memory = reinterpret_cast<nt_allocate_virtual_memory_t>(funcs[0]);
+        const auto nt_protect_virtual_memory = reinterpret_cast<nt_protect_virtual_memory_t>(funcs[1]);
+        const auto nt_flush_instruction_cache = reinterpret_cast<nt_flush_instruction_cache_t>(funcs[2]);
+        const auto nt_free_virtual_memory = reinterpret_cast<nt_free_virtual_memory_t>(funcs[3]);
+        const auto rtl_add_vectored_exception_handler = reinterpret_cast<rtl_add_vectored_exception_handler_t>(funcs[4]);
+        const auto rtl_remove_vectored_exception_handler = reinterpret_cast<rtl_remove_vectored_exception_handler_t>(funcs[5]);
+
+        if (!nt_allocate_virtual_memory || !nt_protect_virtual_memory ||
+            !nt_flush_instruction_cache || !nt_free_virtual_memory ||
+            !rtl_add_vectored_exception_handler || !rtl_remove_vectored_exception_handler) {
             return false;
         }
 
-        // Surface Pro models typically do not have PIT, some devices might have it but not expose it due to firmware bugs (i.e. Lenovo 83AG)       
-        const char* manufacturer = nullptr;
-        const char* model = nullptr;
+        const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
 
-        if (util::get_manufacturer_model(&manufacturer, &model)) {
-            auto ci_contains = [](const char* hay, const char* needle) noexcept -> bool {
-                if (!hay || !needle || !*hay || !*needle) return false;
+        auto eip_overflow_veh = [](PEXCEPTION_POINTERS exc_info) -> LONG {
+            // check for the expected access violation
+            if (exc_info->ExceptionRecord->ExceptionCode == EXCEPTION_ACCESS_VIOLATION) {
+                DWORD64 fault_ip = exc_info->ContextRecord->Rip;
+                DWORD cs_reg = exc_info->ContextRecord->SegCs;
 
-                for (const char* h = hay; *h; ++h) {
-                    const char* a = h;
-                    const char* b = needle;
+                // verify EIP correctly truncated and wrapped to 0x0 in 32-bit mode
+                // if hypervisor only supports x86_64, RIP will be 0x100000000
+                if (fault_ip == 0x0 && cs_reg == 0x23) {
+                    hypervisor_detected = false;
+                }
+            }
+
+            if (g_recovery_pad != 0) {
+                exc_info->ContextRecord->SegCs = 0x33;
+                exc_info->ContextRecord->Rip = g_recovery_pad;   // cleanup shellcode
+                exc_info->ContextRecord->Rsp = g_saved_rsp;
+                return EXCEPTION_CONTINUE_EXECUTION;
+            }
+
+            return EXCEPTION_CONTINUE_SEARCH;
+        };
+
+        const PVOID handler_ptr = rtl_add_vectored_exception_handler(1, static_cast<PVECTORED_EXCEPTION_HANDLER>(eip_overflow_veh));
+        if (!handler_ptr) return false;
+
+        // shellcode byte arrays for ms x64 fastcall (rcx=frame, rdx=stack32, r8=&g_saved_rsp)
+        constexpr unsigned char switch_stub[] = {
+            0x53, 0x55, 0x57, 0x56, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57, // push rbx, rbp, rdi, rsi, r12-r15
+            0x49, 0x89, 0x20,                                                       // mov qword ptr [r8], rsp
+            0x66, 0x8C, 0xD0,                                                       // mov ax, ss
+            0x50,                                                                   // push rax
+            0x52,                                                                   // push rdx
+            0x9C,                                                                   // pushfq
+            0x48, 0x8B, 0x41, 0x08,                                                 // mov rax, qword ptr [rcx + 8]
+            0x50,                                                                   // push rax
+            0x48, 0x8B, 0x01,                                                       // mov rax, qword ptr [rcx]
+            0x50,                                                                   // push rax
+            0x48, 0xCF                                                              // iretq
+        };
 
-                    while (*a && *b) {
-                        unsigned char ca = static_cast<unsigned char>(*a);
-                        unsigned char cb = static_cast<unsigned char>(*b);
+        constexpr unsigned char recover_stub[] = {
+            0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5E, 0x5F, 0x5D, 0x5B, // pop r15-r12, rsi, rdi, rbp, rbx
+            0xC3                                                                    // ret
+        };
 
-                        if (ca >= 'A' && ca <= 'Z') ca += 32;
-                        if (cb >= 'A' && cb <= 'Z') cb += 32;
+        // memory for execution stubs
+        PVOID shellcode_base = nullptr;
+        SIZE_T shellcode_size = sizeof(switch_stub) + sizeof(recover_stub);
+        if (nt_allocate_virtual_memory(current_process, &shellcode_base, 0, &shellcode_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE) < 0) {
+            rtl_remove_vectored_exception_handler(handler_ptr);
+            return false;
+        }
 
-                        if (ca != cb) break;
-                        ++a;
-                        ++b;
-                    }
+        // map stub bytes into allocated chunk
+        u8* code_ptr = static_cast<u8*>(shellcode_base);
+        for (size_t i = 0; i < sizeof(switch_stub); ++i) code_ptr[i] = switch_stub[i];
 
-                    if (!*b)
-                        return true;
-                }
+        u8* rec_ptr = code_ptr + sizeof(switch_stub);
+        for (size_t i = 0; i < sizeof(recover_stub); ++i) rec_ptr[i] = recover_stub[i];
 
-                return false;
-            };
+        // executable memory protection
+        ULONG old_protect = 0;
+        nt_protect_virtual_memory(current_process, &shellcode_base, &shellcode_size, PAGE_EXECUTE_READ, &old_protect);
+        nt_flush_instruction_cache(current_process, shellcode_base, shellcode_size);
 
-            const bool is_surface_pro = ci_contains(model, "surface pro");
-            const bool is_microsoft = ci_contains(manufacturer, "microsoft");
+        // recovery jump target for veh
+        g_recovery_pad = reinterpret_cast<uintptr_t>(rec_ptr);
 
-            if (is_surface_pro && is_microsoft) {
-                return false;
+        // dynamically allocate a 32-bit compatible stack (must reside below 4GB)
+        PVOID stack32_base = nullptr;
+        SIZE_T stack32_size = 0x10000;
+        for (uintptr_t addr = 0x20000000; addr < 0x80000000; addr += 0x10000000) {
+            stack32_base = reinterpret_cast<PVOID>(addr);
+            if (nt_allocate_virtual_memory(current_process, &stack32_base, 0, &stack32_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE) >= 0) {
+                break;
             }
+            stack32_base = nullptr;
         }
-        
-        // The RTC (ACPI/CMOS RTC) timer can't be always detected via SetupAPI, it needs AML decode of the DSDT firmware table
-        // The HPET (PNP0103) timer presence check was removed, more info at: https://github.com/NotRequiem/VMAware/pull/616
-        // Here, we check for the PIT/AT timer (PC-class System Timer)
-        const HDEVINFO devs = SetupDiGetClassDevsW(
-            nullptr, nullptr, nullptr, DIGCF_PRESENT | DIGCF_ALLCLASSES);
 
-        if (devs == INVALID_HANDLE_VALUE)
+        if (!stack32_base) {
+            SIZE_T free_size = 0;
+            nt_free_virtual_memory(current_process, &shellcode_base, &free_size, MEM_RELEASE);
+            rtl_remove_vectored_exception_handler(handler_ptr);
             return false;
+        }
 
-        SP_DEVINFO_DATA dev_info{};
-        dev_info.cbSize = sizeof(dev_info);
-
-        BYTE* buffer = nullptr;
-        DWORD buffer_size = 0;
-        bool found = false;
-
-        for (DWORD i = 0; SetupDiEnumDeviceInfo(devs, i, &dev_info); ++i) {
-            DWORD type = 0;
-            DWORD needed = 0;
-
-            if (SetupDiGetDeviceRegistryPropertyW(
-                devs, &dev_info, SPDRP_HARDWAREID,
-                &type, nullptr, 0, &needed))
-            {
-                continue;
-            }
-
-            if (GetLastError() != ERROR_INSUFFICIENT_BUFFER || needed == 0)
-                continue;
+        // align stack pointer
+        uintptr_t stack32_ptr = reinterpret_cast<uintptr_t>(stack32_base) + 0x10000 - 0x20;
 
-            if (needed > buffer_size) {
-                BYTE* new_buffer = static_cast<BYTE*>(
-                    realloc(buffer, needed + sizeof(wchar_t)));
+        // high-boundary 32-bit execution target
+        PVOID boundary_base = reinterpret_cast<PVOID>(0xFFFF0000ULL);
+        SIZE_T boundary_size = 0x10000ULL;
+        NTSTATUS alloc_status = nt_allocate_virtual_memory(current_process, &boundary_base, 0, &boundary_size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
 
-                if (!new_buffer) {
-                    free(buffer);
-                    SetupDiDestroyDeviceInfoList(devs);
-                    return false;
-                }
+        if (alloc_status >= 0) {
+            if (boundary_base == reinterpret_cast<PVOID>(0xFFFF0000ULL)) {
+                // inject cpuid at the strict end of the compat-mode space
+                u8* execution_target = reinterpret_cast<u8*>(0xFFFFFFFEULL);
+                execution_target[0] = 0x0F;
+                execution_target[1] = 0xA2;
 
-                buffer = new_buffer;
-                buffer_size = needed + sizeof(wchar_t);
-            }
+                iretq_frame frame = {};
+                frame.ip = 0xFFFFFFFEULL;
+                frame.cs = 0x23;
 
-            if (!SetupDiGetDeviceRegistryPropertyW(
-                devs, &dev_info, SPDRP_HARDWAREID,
-                &type, buffer, buffer_size, &needed))
-            {
-                continue;
+                // dispatch hardware context switch shellcode
+                auto switch_func = reinterpret_cast<void(*)(iretq_frame*, uintptr_t, u64*)>(code_ptr);
+                switch_func(&frame, stack32_ptr, &g_saved_rsp);
             }
+            SIZE_T free_size = 0;
+            nt_free_virtual_memory(current_process, &boundary_base, &free_size, MEM_RELEASE);
+        }
 
-            if (type != REG_MULTI_SZ)
-                continue;
-
-            reinterpret_cast<wchar_t*>(buffer)[needed / sizeof(wchar_t)] = L'\0';
+        SIZE_T free_size = 0;
+        nt_free_virtual_memory(current_process, &stack32_base, &free_size, MEM_RELEASE);
 
-            for (const wchar_t* s = reinterpret_cast<const wchar_t*>(buffer); *s;
-                s += wcslen(s) + 1)
-            {
-                if (_wcsicmp(s, L"ACPI\\PNP0100") == 0 ||
-                    _wcsicmp(s, L"PNP0100") == 0)
-                {
-                    found = true;
-                    break;
-                }
-            }
+        free_size = 0;
+        nt_free_virtual_memory(current_process, &shellcode_base, &free_size, MEM_RELEASE);
 
-            if (found)
-                break;
-        }
+        rtl_remove_vectored_exception_handler(handler_ptr);
 
-        free(buffer);
-        SetupDiDestroyDeviceInfoList(devs);
-        return !found;
+        return hypervisor_detected;
     #endif  
     }
 
 
     /**
-     * @brief Check whether the hypervisor correctly handles MSR behavior
+     * @brief Check whether a hypervisor leaks EFER.SVME into guest context via SVM instruction fault type
      * @category Windows, x86
-     * @implements VM::MSR
+     * @implements VM::SVM_EXCEPTIONS
      */
-    [[nodiscard]] static bool msr() {
-    #if (!x86)
-        return false;
-    #else
-        constexpr u32 random_msr = 0xDEADBEEFu;
-
-        auto try_read = [](u32 msr_index) -> bool {
-        #if (MSVC)
-            unsigned __int64 value = 0;
-            __try {
-                value = __readmsr(static_cast<unsigned long>(msr_index));
-                (void)value;
-                return true;
-            }
-            __except (EXCEPTION_EXECUTE_HANDLER) {
-                return false;
-            }
-        #elif (GCC || CLANG)
-            static thread_local bool g_msr_faulted = false;
-
-            auto veh_handler = [](PEXCEPTION_POINTERS info) -> LONG {
-                if (info->ExceptionRecord->ExceptionCode == EXCEPTION_PRIV_INSTRUCTION) {
-                    g_msr_faulted = true;
-                    // skip the 'rdmsr' instruction (2 bytes: 0F 32)
-                #if (x86_64)
-                    info->ContextRecord->Rip += 2;
-                #else
-                    info->ContextRecord->Eip += 2;
-                #endif
-                    return EXCEPTION_CONTINUE_EXECUTION;
-                }
-                return EXCEPTION_CONTINUE_SEARCH;
-            };
-
-            const PVOID handle = AddVectoredExceptionHandler(1, veh_handler);
-
-            u32 low, high;
-            asm volatile (
-                "rdmsr"
-                : "=a"(low), "=d"(high)
-                : "c"(msr_index)
-            );
-
-            RemoveVectoredExceptionHandler(handle);
-
-            return !g_msr_faulted;
-        #endif
-        };
+    [[nodiscard]] static bool svm_exceptions() {
+    #if (x86)
+        if (!cpu::is_amd()) {
+            debug("SVM_EXCEPTIONS: AMD CPU not detected, skipping");
+            return false;
+        }
 
-        if (try_read(random_msr)) {
-            debug("MSR: Detected hypervisor not correctly handling #GP");
-            return true;
+        if (util::hyper_x() == HYPERV_ARTIFACT_VM) {
+            return false;
         }
 
-        return false;
-    #endif
-    }
+        u32 eax = 0, ebx = 0, ecx = 0, edx = 0;
+        cpu::cpuid(eax, ebx, ecx, edx, 0x80000001);
+        const bool svmcpuid_visible = ((ecx >> 2) & 1) != 0;
 
+        const HMODULE ntdll = util::get_ntdll();
+        if (!ntdll) {
+            return false;
+        }
 
-    /**
-     * @brief Check whether KVM attempts to patch a mismatched hypercall instruction
-     * @link https://lists.nongnu.org/archive/html/qemu-devel/2025-07/msg05044.html
-     * @category Windows, x86
-     * @implements VM::KVM_INTERCEPTION
-     */
-    [[nodiscard]] static bool kvm_interception() {
-    #if (!x86)
-        return false;
-    #else
         using nt_allocate_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, ULONG_PTR, PSIZE_T, ULONG, ULONG);
         using nt_protect_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG, PULONG);
         using nt_free_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG);
         using nt_flush_instruction_cache_t = NTSTATUS(__stdcall*)(HANDLE, PVOID, SIZE_T);
-        using nt_close_t = NTSTATUS(__stdcall*)(HANDLE);
 
-        const HMODULE ntdll = util::get_ntdll();
-        if (!ntdll) return false;
+        const char* names[] = {
+            "NtAllocateVirtualMemory",
+            "NtProtectVirtualMemory",
+            "NtFreeVirtualMemory",
+            "NtFlushInstructionCache"
+        };
 
-        const char* names[] = { "NtAllocateVirtualMemory", "NtProtectVirtualMemory", "NtFreeVirtualMemory", "NtFlushInstructionCache", "NtClose" };
         void* funcs[ARRAYSIZE(names)] = {};
         util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
 
@@ -12289,957 +15197,1073 @@ public:
         const auto nt_protect_virtual_memory = reinterpret_cast<nt_protect_virtual_memory_t>(funcs[1]);
         const auto nt_free_virtual_memory = reinterpret_cast<nt_free_virtual_memory_t>(funcs[2]);
         const auto nt_flush_instruction_cache = reinterpret_cast<nt_flush_instruction_cache_t>(funcs[3]);
-        const auto nt_close = reinterpret_cast<nt_close_t>(funcs[4]);
 
-        if (!nt_allocate_virtual_memory || !nt_protect_virtual_memory || !nt_free_virtual_memory || !nt_flush_instruction_cache || !nt_close)
+        if (!nt_allocate_virtual_memory || !nt_protect_virtual_memory || !nt_free_virtual_memory || !nt_flush_instruction_cache) {
             return false;
+        }
 
-        // VMCALL (0F 01 C1) + RET (C3) and VMMCALL (0F 01 D9) + RET (C3)
-        constexpr BYTE opcodes[2][4] = {
-            { 0x0F, 0x01, 0xC1, 0xC3 },
-            { 0x0F, 0x01, 0xD9, 0xC3 }
-        };
+        constexpr std::array<std::array<u8, 4>, 5> opcodes{ {
+            { 0x0F, 0x01, 0xD8, 0xC3 }, // VMRUN
+            { 0x0F, 0x01, 0xDA, 0xC3 }, // VMLOAD
+            { 0x0F, 0x01, 0xDB, 0xC3 }, // VMSAVE
+            { 0x0F, 0x01, 0xDD, 0xC3 }, // CLGI
+            { 0x0F, 0x01, 0xDF, 0xC3 }  // INVLPGA
+        } };
 
+        constexpr SIZE_T opcode_size = 4;
         const HANDLE current_process = reinterpret_cast<HANDLE>(-1);
-        bool is_kvm_detected = false; // KVM-specific behavior, detector is 100% sure is running under KVM
-        bool generic_hypervisor = false; // behavior present in KVM but other hypervisors might replicate it as well
 
-        for (int i = 0; i < 2; ++i) {
+        for (const auto& opcode : opcodes) {
             PVOID base_address = nullptr;
             SIZE_T region_size = 0x1000;
 
-            // memory as RWX initially to write the opcode
+            auto free_region = [&]() {
+                if (base_address) {
+                    SIZE_T free_size = 0;
+                    nt_free_virtual_memory(current_process, &base_address, &free_size, MEM_RELEASE);
+                    base_address = nullptr;
+                }
+            };
+
             NTSTATUS status = nt_allocate_virtual_memory(
-                current_process, &base_address, 0, &region_size,
-                MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+                current_process,
+                &base_address,
+                0,
+                &region_size,
+                MEM_COMMIT | MEM_RESERVE,
+                PAGE_EXECUTE_READWRITE
+            );
 
-            if (!NT_SUCCESS(status))
+            if (!NT_SUCCESS(status)) {
                 continue;
+            }
 
-            // copy stuff to page
-            memcpy(base_address, opcodes[i], sizeof(opcodes[i]));
-
-            nt_flush_instruction_cache(current_process, base_address, sizeof(opcodes[i]));
+            memcpy(base_address, opcode.data(), opcode_size);
+            nt_flush_instruction_cache(current_process, base_address, opcode_size);
 
             ULONG old_protect = 0;
             PVOID protect_address = base_address;
             SIZE_T protect_size = region_size;
 
-            // change memory protection to RX because it is what breaks KVM's instruction patching attempt
             status = nt_protect_virtual_memory(
-                current_process, &protect_address, &protect_size,
-                PAGE_EXECUTE_READ, &old_protect);
+                current_process,
+                &protect_address,
+                &protect_size,
+                PAGE_EXECUTE_READ,
+                &old_protect
+            );
 
-            if (NT_SUCCESS(status)) {
-                nt_flush_instruction_cache(current_process, base_address, sizeof(opcodes[i]));
-                DWORD exception_status = 0;
+            if (!NT_SUCCESS(status)) {
+                free_region();
+                continue;
+            }
 
-                __try {
-                    const auto execute_hypercall = reinterpret_cast<void(*)()>(base_address);
-                    execute_hypercall();
-                    generic_hypervisor = true; // if no exception occurs then a hypervisor handled it, this is default KVM behavior
-                    debug("KVM_INTERCEPTION: Detected a hypervisor intercepting hypercalls");
-                }
-                __except (exception_status = GetExceptionCode(), EXCEPTION_EXECUTE_HANDLER) {
-                    // if it's #PF instead of #UD then old KVM quirk is present
-                    if (exception_status == EXCEPTION_ACCESS_VIOLATION) {
-                        debug("KVM_INTERCEPTION: Detected KVM attempting to patch instructions on the fly");
-                        is_kvm_detected = true;
-                    }
-                }
+            nt_flush_instruction_cache(current_process, base_address, opcode_size);
+
+            DWORD exception_status = 0;
+            bool fault_hit = false;
+
+            __try {
+                reinterpret_cast<void(*)()>(base_address)();
+            }
+            __except (exception_status = GetExceptionCode(), EXCEPTION_EXECUTE_HANDLER) {
+                fault_hit = true;
             }
 
-            SIZE_T free_size = 0;
-            nt_free_virtual_memory(current_process, &base_address, &free_size, MEM_RELEASE);
+            free_region();
 
-            if (is_kvm_detected) {
-                return core::add(brand_enum::KVM);
+            if (!fault_hit) {
+                continue;
             }
-            else if (generic_hypervisor) {
-                return true;
+
+            if (exception_status == EXCEPTION_ILLEGAL_INSTRUCTION) {
+                continue;
+            }
+
+            if (svmcpuid_visible) {
+                debug("SVM_EXCEPTIONS: Detected SVM hypervisor");
+            }
+            else {
+                debug("SVM_EXCEPTIONS: Detected SVM hypervisor hiding CPU capabilities");
+                return core::add(brand_enum::NULL_BRAND, 150);
             }
+
+            return true;
         }
- 
-        return false;
     #endif
+        return false;
     }
 
+    // ADD NEW TECHNIQUE FUNCTION HERE
 
-    /**
-     * @brief Check whether a hypervisor uses EPT/NPT hooking to intercept hardware breakpoints
-     * @note This hypervisor detection also affects debuggers
-     * @category Windows, x86
-     * @implements VM::HYPERVISOR_HOOK
-     */
-    [[nodiscard]] static bool hypervisor_hook() {
-    #if (!x86)
-        return false;
-    #else
-        if (util::is_running_under_translator()) return false;
-        const HMODULE ntdll = util::get_ntdll();
-        if (!ntdll) return false;
-
-        const char* names[] = {
-            "NtAllocateVirtualMemory",
-            "NtFreeVirtualMemory",
-            "NtGetContextThread",
-            "NtSetContextThread",
-            "RtlAddVectoredExceptionHandler",
-            "RtlRemoveVectoredExceptionHandler",
-            "NtProtectVirtualMemory",
-            "NtQuerySystemInformation",
-            "NtCreateThreadEx",
-            "NtWaitForSingleObject",
-            "NtClose",
-            "NtSetInformationThread"
-        };
-        void* funcs[ARRAYSIZE(names)] = {};
-        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
 
-        using nt_allocate_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, ULONG_PTR, PSIZE_T, ULONG, ULONG);
-        using nt_free_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG);
-        using net_get_context_thread_t = NTSTATUS(__stdcall*)(HANDLE, PCONTEXT);
-        using nt_set_context_thread_t = NTSTATUS(__stdcall*)(HANDLE, PCONTEXT);
-        using rtl_add_vectored_exception_handler_t = PVOID(__stdcall*)(ULONG, PVECTORED_EXCEPTION_HANDLER);
-        using rtl_remove_vectored_exception_handler_t = ULONG(__stdcall*)(PVOID);
-        using nt_protect_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG, PULONG);
-        using nt_query_system_information_t = NTSTATUS(__stdcall*)(ULONG, PVOID, ULONG, PULONG);
-        using nt_create_thread_ex_t = NTSTATUS(__stdcall*)(PHANDLE, ACCESS_MASK, PVOID, HANDLE, PVOID, PVOID, ULONG, ULONG_PTR, SIZE_T, SIZE_T, PVOID);
-        using nt_wait_for_single_object_t = NTSTATUS(__stdcall*)(HANDLE, BOOLEAN, PLARGE_INTEGER);
-        using nt_close_t = NTSTATUS(__stdcall*)(HANDLE);
-        using nt_set_information_thread_t = NTSTATUS(__stdcall*)(HANDLE, ULONG, PVOID, ULONG);
+    
 
-        // volatile ensures these are loaded from stack after SEH unwind when compiled with aggressive optimizations
-        nt_allocate_virtual_memory_t volatile nt_allocate_virtual_memory = reinterpret_cast<nt_allocate_virtual_memory_t>(funcs[0]);
-        nt_free_virtual_memory_t volatile nt_free_virtual_memory = reinterpret_cast<nt_free_virtual_memory_t>(funcs[1]);
-        net_get_context_thread_t volatile nt_get_context_thread = reinterpret_cast<net_get_context_thread_t>(funcs[2]);
-        nt_set_context_thread_t volatile nt_set_context_thread = reinterpret_cast<nt_set_context_thread_t>(funcs[3]);
-        rtl_add_vectored_exception_handler_t volatile rtl_add_vectored_exception_handler = reinterpret_cast<rtl_add_vectored_exception_handler_t>(funcs[4]);
-        rtl_remove_vectored_exception_handler_t volatile rtl_remove_vectored_exception_handler = reinterpret_cast<rtl_remove_vectored_exception_handler_t>(funcs[5]);
-        nt_protect_virtual_memory_t volatile nt_protect_virtual_memory = reinterpret_cast<nt_protect_virtual_memory_t>(funcs[6]);
+    #if (CLANG)
+        #pragma clang diagnostic pop
+    #endif
+#endif
 
-        nt_query_system_information_t volatile nt_query_system_information = reinterpret_cast<nt_query_system_information_t>(funcs[7]);
-        nt_create_thread_ex_t volatile nt_create_thread_ex = reinterpret_cast<nt_create_thread_ex_t>(funcs[8]);
-        nt_wait_for_single_object_t volatile nt_wait_for_single_object = reinterpret_cast<nt_wait_for_single_object_t>(funcs[9]);
-        nt_close_t volatile nt_close = reinterpret_cast<nt_close_t>(funcs[10]);
-        nt_set_information_thread_t volatile nt_set_information_thread = reinterpret_cast<nt_set_information_thread_t>(funcs[11]);
+#if (MSVC)
+    #pragma endregion
+#endif
 
-        if (!nt_allocate_virtual_memory || !nt_free_virtual_memory || !nt_get_context_thread ||
-            !nt_set_context_thread || !rtl_add_vectored_exception_handler || !rtl_remove_vectored_exception_handler ||
-            !nt_protect_virtual_memory || !nt_query_system_information || !nt_create_thread_ex ||
-            !nt_wait_for_single_object || !nt_close || !nt_set_information_thread) {
-            return false;
-        }
+    /* ============================================================================================== *
+     *                                                                                                *                                                                                               *
+     *                                        CORE SECTION                                            *
+     *                                                                                                *
+     * ============================================================================================== */
+    struct core {
+        // rough latency class of a technique, the cheapest evidence is collected first for VM::detect() and VM::percentage()
+        enum class cost : u8 {
+            CPUID,  // cpuid leaves and other plain register reads
+            CPU,    // instruction level probes like traps, exceptions and timing loops
+            IO,     // a handful of file reads, syscalls or registry queries
+            SCAN,   // walks directories, processes, devices or firmware tables
+            EXEC    // spawns a process or sleeps
+        };
 
-        HANDLE current_process = reinterpret_cast<HANDLE>(-1);
-        HANDLE current_thread = reinterpret_cast<HANDLE>(-2);
+        struct technique {
+            u8 points = 0;                // this is the certainty score between 0 and 100
+            bool(*run)();                 // this is the technique function itself
+            cost cost_class = cost::IO;   // how expensive the technique is expected to be
 
-        // explicitly decay lambdas to raw function pointers to eliminate C2712 unwinding requirement errors
-        using execute_throws_t = bool(*)(void*);
-        execute_throws_t execute_throws = [](void* pointer) -> bool {
-            __try {
-                util::execute_unchecked(pointer); // breakpoint hit
-            }
-            __except (EXCEPTION_EXECUTE_HANDLER) {
-                return true;
-            }
-            return false;
+            constexpr technique() : run(nullptr) {}
+            constexpr technique(u8 points, bool(*run)(), cost cost_class) : points(points), run(run), cost_class(cost_class) {}
         };
 
-        using find_double_cc_ntdll_t = void* (*)(HMODULE);
-        find_double_cc_ntdll_t find_double_cc_ntdll = [](HMODULE module) -> void* {
-            if (!module) return nullptr;
-
-            // parse PE headers to find executable sections
-            auto* dos_header = reinterpret_cast<PIMAGE_DOS_HEADER>(module);
-            if (dos_header->e_magic != IMAGE_DOS_SIGNATURE) return nullptr;
+        struct custom_technique {
+            u8 points;
+            u16 id;
+            bool(*run)();
+        };
 
-            auto* nt_headers = reinterpret_cast<PIMAGE_NT_HEADERS>(reinterpret_cast<u8*>(module) + dos_header->e_lfanew);
-            if (nt_headers->Signature != IMAGE_NT_SIGNATURE) return nullptr;
+        // entry for the initialization list
+        struct technique_entry { // NOLINT(cppcoreguidelines-pro-type-member-init)
+            enum_flags id;
+            technique tech;
+        };
 
-            auto* section = IMAGE_FIRST_SECTION(nt_headers);
-            for (WORD i = 0; i < nt_headers->FileHeader.NumberOfSections; ++i, ++section) {
+        // entry for brand scoreboard
+        struct brand_entry {
+            brand_enum name;
+            brand_score_t score;
+        };
 
-                // only scan memory marked as executable
-                if ((section->Characteristics & IMAGE_SCN_MEM_EXECUTE) != 0) {
-                    u8* ptr = reinterpret_cast<u8*>(module) + section->VirtualAddress;
-                    size_t size = section->Misc.VirtualSize;
+        // the actual table, which is derived from the list above and will be 
+        // used for most functionalities related to technique interactions
+        static std::array<technique, enum_size + 1> technique_table;
 
-                    if (size < 2) {
-                        continue;
-                    }
+        static std::vector<VM::core::custom_technique> custom_table; // users should not have a limit of how many functions they should add, this is the only exception of a heap-allocated object in our core
+        static size_t custom_table_size;
 
-                    for (size_t j = 0; j < size - 1; ++j) {
-                        if (ptr[j] == 0xCC && ptr[j + 1] == 0xCC) {
-                            // by returning ptr[j + 1], executing it will safely run 0xC3 (after overwrite)
-                            // if we overwrite j+1 with 0xC3 and call it, it immediately returns
-                            return &ptr[j + 1];
-                        }
-                    }
-                }
-            }
-            return nullptr;
-        };
+        // derived from the brand contributions kept in the cache, see rebuild_scoreboard()
+        static std::array<brand_entry, MAX_BRANDS> brand_scoreboard;
+        static std::mutex scoreboard_mutex;
+        static std::atomic<u32> scoreboard_generation;
 
-        using find_double_cc_t = void* (*)(void*);
-        find_double_cc_t find_double_cc = [](void* pointer_in_page) -> void* {
-            // align down to the start of the 4KB page
-            auto* ptr = reinterpret_cast<u8*>(reinterpret_cast<uintptr_t>(pointer_in_page) & ~0xFFF);
+        // last measured runtime of each technique in nanoseconds, 0 if it hasn't been run yet
+        static std::array<std::atomic<u32>, enum_size + 1> technique_latency;
 
-            for (size_t i = 0; i < (0x1000 - 1); ++i) {
-                if (ptr[i] == 0xCC && ptr[i + 1] == 0xCC) {
-                    return &ptr[i + 1];
-                }
-            }
-            return nullptr;
-        };
+        // Temporary storage to capture which brand was detected by the currently running technique.
+        // thread_local ensures each thread running run_all() has its own independent copy.
+        static thread_local brand_enum last_detected_brand;
+        static thread_local u8 last_detected_score;
 
-        void* pointer = find_double_cc_ntdll(ntdll);
-        if (!pointer) {
-            void* current_func_ptr = reinterpret_cast<void*>(&hypervisor_hook);
-            pointer = find_double_cc(current_func_ptr);
-            if (!pointer) return false;
-        }
+        // VM::detected_count_num holds the count of whichever run ended last in the whole process,
+        // this is the one of the calling thread's last run for the functions that read it right after
+        static thread_local u8 last_detected_count;
 
-        // executing CC natively should throw
-        if (!execute_throws(pointer)) {
-            return false; // SEH is broken or code isn't actually CC
-        }
+        // core::add() calls are recorded instead of applied while a technique runs, and kept with its cached result
+        using brand_contribution = memo::brand_contribution;
 
-        // overwrite CC with C3 (RET)
-        PVOID base_address = pointer;
-        SIZE_T prot_region_size = 1;
-        ULONG old_protect = 0;
+        static thread_local std::vector<brand_contribution>* brand_journal;
 
-        // NtProtectVirtualMemory modifies BaseAddress and RegionSize to page boundaries,
-        // so we must reset them on subsequent calls
-        NTSTATUS status = nt_protect_virtual_memory(current_process, &base_address, &prot_region_size, PAGE_EXECUTE_READWRITE, &old_protect);
-        if (status < 0) return false;
+        // core::add() calls made outside of a technique run, like from a custom technique
+        static std::vector<brand_contribution> external_journal;
 
-        *static_cast<volatile u8*>(pointer) = 0xC3;
+        // result of a technique that was already run by the VM::PARALLEL executor, waiting to be merged
+        struct technique_outcome {
+            bool dispatched = false;
+            bool result = false;
+            u8 points = 0;
+            brand_enum brand = brand_enum::NULL_BRAND;
+            u64 elapsed_ns = 0;
+            std::vector<brand_contribution> journal;
+            std::exception_ptr error;
+        };
 
-        base_address = pointer;
-        prot_region_size = 1;
-        ULONG dummy_protect = 0;
-        status = nt_protect_virtual_memory(current_process, &base_address, &prot_region_size, old_protect, &dummy_protect);
-        if (status < 0) return false;
+        // 1. one brand, custom score
+        static bool add(const brand_enum p_brand, u8 score) noexcept {
+            return add_score(p_brand, brand_enum::NULL_BRAND, score);
+        }
 
-        bool hook_detected = false;
+        // 2. one brand, default score
+        static bool add(const brand_enum p_brand) noexcept {
+            return add_score(p_brand, brand_enum::NULL_BRAND, 0);
+        }
 
-        // test if write was swallowed by the hypervisor on the current core
-        if (execute_throws(pointer)) {
-            hook_detected = true;
+        // 3. two brands, default score
+        static bool add(const brand_enum p_brand, const brand_enum extra_brand) noexcept {
+            return add_score(p_brand, extra_brand, 0);
         }
-        else {
-            // now try on all cores, total hardware processors
-            struct SYSTEM_BASIC_INFORMATION_LOCAL {
-                ULONG Reserved;
-                ULONG TimerResolution;
-                ULONG PageSize;
-                ULONG NumberOfPhysicalPages;
-                ULONG LowestPhysicalPageNumber;
-                ULONG HighestPhysicalPageNumber;
-                ULONG AllocationGranularity;
-                ULONG_PTR MinimumUserModeAddress;
-                ULONG_PTR MaximumUserModeAddress;
-                ULONG_PTR ActiveProcessorsAffinityMask;
-                CCHAR NumberOfProcessors;
-            };
 
-            SYSTEM_BASIC_INFORMATION_LOCAL sys_info{};
-            ULONG ret_len = 0;
-            ULONG num_processors = 1;
+        static bool add_score(const brand_enum p_brand, const brand_enum extra_brand, u8 score) noexcept {
+            last_detected_brand = p_brand;
+            last_detected_score = score; // Store for the engine to read
 
-            // 0 = SystemBasicInformation
-            status = nt_query_system_information(0, &sys_info, sizeof(sys_info), &ret_len);
-            if (status < 0) {
-                return false;
+            // techniques only record what they found, the scoreboard 
+            // is rebuilt from the cache in technique order afterwards
+            if (brand_journal != nullptr) {
+                brand_journal->push_back({ p_brand, extra_brand });
+                return true;
             }
-            num_processors = sys_info.NumberOfProcessors;
 
-            volatile LONG did_anyone_throw = 0;
+            const std::lock_guard<std::mutex> lock(scoreboard_mutex);
+            external_journal.push_back({ p_brand, extra_brand });
+            tally(p_brand, extra_brand);
+            return true;
+        }
 
-            for (ULONG i = 0; i < num_processors && i < 256; ++i) {
-                // pin the current thread to physical core i
-                ULONG_PTR affinity = (ULONG_PTR)1 << i;
-                status = nt_set_information_thread(current_thread, 4 /* ThreadAffinityMask */, &affinity, sizeof(affinity));
-                if (status < 0) {
-                    return false;
-                }
+        // replays the brand contributions of every cached technique in technique table order, so the 
+        // scoreboard is the same no matter in which order or on which thread the techniques were run
+        static void rebuild_scoreboard() {
+            const u32 generation = memo::cache_generation.load(std::memory_order_acquire);
 
-                __try {
-                    util::execute_unchecked(pointer);
-                }
-                __except (EXCEPTION_EXECUTE_HANDLER) {
-                    did_anyone_throw = 1;
-                }
+            // nothing was stored since the last rebuild, which is always the case once everything is cached
+            if (generation == scoreboard_generation.load(std::memory_order_acquire)) {
+                return;
             }
 
-            if (did_anyone_throw != 0) {
-                hook_detected = true;
-            }
-        }
+            const std::lock_guard<std::mutex> lock(scoreboard_mutex);
 
-        PVOID src_page = nullptr;
-        PVOID dst_page = nullptr;
-        SIZE_T region_size = 0x2000;
+            for (auto& entry : brand_scoreboard) {
+                entry.score = 0;
+            }
 
-        // allocate source and destination pages
-        const NTSTATUS status_src = nt_allocate_virtual_memory(current_process, &src_page, 0, &region_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-        const NTSTATUS status_dst = nt_allocate_virtual_memory(current_process, &dst_page, 0, &region_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+            for (u16 i = 0; i < memo::cache_table.size(); ++i) {
+                if (!memo::is_cached(i)) {
+                    continue;
+                }
 
-        if (status_src < 0 || status_dst < 0) {
-            if (src_page) {
-                SIZE_T free_size = 0;
-                nt_free_virtual_memory(current_process, &src_page, &free_size, MEM_RELEASE);
+                for (const brand_contribution& contribution : memo::cache_table.at(i).journal) {
+                    tally(contribution.brand, contribution.extra_brand);
+                }
             }
-            if (dst_page) {
-                SIZE_T free_size = 0;
-                nt_free_virtual_memory(current_process, &dst_page, &free_size, MEM_RELEASE);
+
+            for (const brand_contribution& contribution : external_journal) {
+                tally(contribution.brand, contribution.extra_brand);
             }
-            return false;
+
+            scoreboard_generation.store(generation, std::memory_order_release);
         }
 
-        // initialize src memory
-        __stosb(static_cast<PBYTE>(src_page), 0xAB, 0x2000);
+        // a separate scoreboard out of only the cached techniques that the flags select
+        static std::array<brand_entry, MAX_BRANDS> scoreboard_for(const flagset& flags) {
+            std::array<brand_entry, MAX_BRANDS> scoreboard = empty_scoreboard();
 
-        thread_local static volatile bool ermsb_trap_detected = false;
-        ermsb_trap_detected = false;
+            for (u8 i = technique_begin; i < technique_end; ++i) {
+                if (!is_selected(flags, i) || !memo::is_cached(i)) {
+                    continue;
+                }
 
-        // capture-less local lambda decays to PVECTORED_EXCEPTION_HANDLER function pointer
-        auto veh_handler = [](PEXCEPTION_POINTERS ctx) -> LONG {
-            if (ctx->ExceptionRecord->ExceptionCode == EXCEPTION_SINGLE_STEP) {
-                ermsb_trap_detected = true;
-                return EXCEPTION_CONTINUE_EXECUTION;
+                for (const brand_contribution& contribution : memo::cache_table.at(i).journal) {
+                    tally(scoreboard, contribution.brand, contribution.extra_brand);
+                }
             }
-            return EXCEPTION_CONTINUE_SEARCH;
-        };
 
-        const PVOID veh_handle = rtl_add_vectored_exception_handler(1, static_cast<PVECTORED_EXCEPTION_HANDLER>(veh_handler));
-        if (!veh_handle) {
-            SIZE_T free_size = 0;
-            nt_free_virtual_memory(current_process, &src_page, &free_size, MEM_RELEASE);
-            nt_free_virtual_memory(current_process, &dst_page, &free_size, MEM_RELEASE);
-            return false;
+            return scoreboard;
         }
 
-        CONTEXT ctx{};
-        ctx.ContextFlags = CONTEXT_DEBUG_REGISTERS;
-        status = nt_get_context_thread(current_thread, &ctx);
+        static std::array<brand_entry, MAX_BRANDS> scoreboard_snapshot() {
+            const std::lock_guard<std::mutex> lock(scoreboard_mutex);
+            return brand_scoreboard;
+        }
 
-        if (status < 0) {
-            rtl_remove_vectored_exception_handler(veh_handle);
-            SIZE_T free_size = 0;
-            nt_free_virtual_memory(current_process, &src_page, &free_size, MEM_RELEASE);
-            nt_free_virtual_memory(current_process, &dst_page, &free_size, MEM_RELEASE);
-            return false;
+        static void tally(const brand_enum p_brand, const brand_enum extra_brand) noexcept {
+            tally(brand_scoreboard, p_brand, extra_brand);
         }
 
-        // set hw breakpoint inside the source page
-        ctx.Dr0 = reinterpret_cast<DWORD64>(src_page) + 0x1000;
+        // same as above, but for any scoreboard like the one of a VM::context
+        static void tally(std::array<brand_entry, MAX_BRANDS>& scoreboard, const brand_enum p_brand, const brand_enum extra_brand) noexcept {
+            brand_score_t brand_score = scoreboard.at(static_cast<u8>(p_brand)).score;
 
-        // Dr7 = 0x30001
-        // bit 0      = 1
-        // bits 17:16 = 11b
-        // bits 19:18 = 00b
-        ctx.Dr7 = 0x30001;
-        status = nt_set_context_thread(current_thread, &ctx);
-        if (status < 0) {
-            rtl_remove_vectored_exception_handler(veh_handle);
-            SIZE_T free_size = 0;
-            nt_free_virtual_memory(current_process, &src_page, &free_size, MEM_RELEASE);
-            nt_free_virtual_memory(current_process, &dst_page, &free_size, MEM_RELEASE);
-            return false;
-        }
+            scoreboard.at(static_cast<u8>(p_brand)) = { p_brand, ++brand_score };
 
-        __try {
-            __movsb(static_cast<PBYTE>(dst_page), static_cast<PBYTE>(src_page), 0x2000);
+            if (extra_brand != brand_enum::NULL_BRAND) {
+                scoreboard.at(static_cast<u8>(extra_brand)) = { extra_brand, ++brand_score };
+            }
         }
-        __except (EXCEPTION_EXECUTE_HANDLER) {
-            // veh will already detect if Dr0 fired successfully
+
+        // every brand with a score above 0, in brand order
+        static brand_list_t active_brands(const std::array<brand_entry, MAX_BRANDS>& scoreboard) {
+            brand_list_t active = {};
+            active.reserve(MAX_BRANDS);
+
+            for (size_t i = 0; i < MAX_BRANDS; ++i) {
+                if (scoreboard.at(i).score > 0) {
+                    active.emplace_back(std::make_pair(scoreboard.at(i).name, scoreboard.at(i).score));
+                }
+            }
+
+            return active;
         }
 
-        rtl_remove_vectored_exception_handler(veh_handle);
+        static std::array<brand_entry, MAX_BRANDS> empty_scoreboard() noexcept {
+            std::array<brand_entry, MAX_BRANDS> scoreboard{};
 
-        ctx.Dr0 = 0;
-        ctx.Dr7 = 0;
-        status = nt_set_context_thread(current_thread, &ctx);
-        if (status < 0) {
-            SIZE_T free_size = 0;
-            nt_free_virtual_memory(current_process, &src_page, &free_size, MEM_RELEASE);
-            nt_free_virtual_memory(current_process, &dst_page, &free_size, MEM_RELEASE);
-            return false;
+            for (u8 i = 0; i < MAX_BRANDS; i++) {
+                scoreboard.at(i) = { static_cast<brand_enum>(i), 0 };
+            }
+
+            return scoreboard;
         }
 
-        SIZE_T free_size = 0;
-        nt_free_virtual_memory(current_process, &src_page, &free_size, MEM_RELEASE);
-        nt_free_virtual_memory(current_process, &dst_page, &free_size, MEM_RELEASE);
+        // assert if the flag is enabled, far better expression than typing std::bitset member functions
+        [[nodiscard]] static bool is_disabled(const flagset& flags, const u8 flag_bit) noexcept {
+            if (flag_bit >= flags.size()) {
+                return true;
+            }
 
-        return hook_detected || !ermsb_trap_detected;
-    #endif
-    }
+            return !flags.test(flag_bit);
+        }
 
+        // same as above but for checking enabled flags
+        [[nodiscard]] static bool is_enabled(const flagset& flags, const u8 flag_bit) noexcept {
+            if (flag_bit >= flags.size()) {
+                return false;
+            }
 
-    /**
-     * @brief Check whether a hypervisor delays trap flags over exiting instructions
-     * @category Windows, x86
-     * @implements VM::SINGLE_STEP
-     */
-    [[nodiscard]] static bool single_step() {
-    #if (!x86)
-        return false;
-    #else
-        const HMODULE ntdll = util::get_ntdll();
-        if (!ntdll) return false;
+            return flags.test(flag_bit);
+        }
 
-        const char* names[] = {
-            "NtAllocateVirtualMemory",
-            "NtProtectVirtualMemory",
-            "NtFlushInstructionCache",
-            "NtFreeVirtualMemory"
-        };
+        // the most expensive cost class allowed by the VM::TIER_* settings, the cheapest one wins if there's more than one
+        [[nodiscard]] static cost tier_limit(const flagset& flags) noexcept {
+            if (flags.test(TIER_FAST)) {
+                return cost::CPUID;
+            }
 
-        void* funcs[ARRAYSIZE(names)] = {};
-        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+            if (flags.test(TIER_IO)) {
+                return cost::SCAN;
+            }
 
-        using NtAllocateVirtualMemory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, ULONG_PTR, PSIZE_T, ULONG, ULONG);
-        using NtProtectVirtualMemory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG, PULONG);
-        using NtFlushInstructionCache_t = NTSTATUS(__stdcall*)(HANDLE, PVOID, SIZE_T);
-        using NtFreeVirtualMemory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG);
+            return cost::EXEC;
+        }
 
-        const auto nt_allocate_virtual_memory = reinterpret_cast<NtAllocateVirtualMemory_t>(funcs[0]);
-        const auto nt_protect_virtual_memory = reinterpret_cast<NtProtectVirtualMemory_t>(funcs[1]);
-        const auto nt_flush_instruction_cache = reinterpret_cast<NtFlushInstructionCache_t>(funcs[2]);
-        const auto nt_free_virtual_memory = reinterpret_cast<NtFreeVirtualMemory_t>(funcs[3]);
+        // true if a VM::TIER_* setting leaves some techniques out
+        [[nodiscard]] static bool is_tiered(const flagset& flags) noexcept {
+            return (tier_limit(flags) != cost::EXEC);
+        }
 
-        if (!nt_allocate_virtual_memory || !nt_protect_virtual_memory ||
-            !nt_flush_instruction_cache || !nt_free_virtual_memory) {
-            return false;
+        // whether a technique should be run at all, which means it's enabled and within the tier
+        [[nodiscard]] static bool is_selected(const flagset& flags, const u8 technique_id) noexcept {
+            return (
+                is_enabled(flags, technique_id) &&
+                (technique_table.at(technique_id).cost_class <= tier_limit(flags))
+            );
         }
 
-        const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
+        [[nodiscard]] static bool are_techniques_empty(const flagset& flags) {
+            for (std::size_t i = technique_begin; i < technique_end; i++) {
+                if (flags.test(i)) {
+                    return false;
+                }
+            }
 
-        constexpr unsigned char shellcode[] = {
-            0x9C,                                     // pushfq (x64) / pushfd (x86)
-            0x81, 0x0C, 0x24, 0x00, 0x01, 0x00, 0x00, // or dword ptr [rsp/esp], 0x100 (sets TF)
-            0x9D,                                     // popfq (x64) / popfd (x86)
-            0x31, 0xC0,                               // xor eax, eax
-            0x0F, 0xA2,                               // cpuid
-            0xC7, 0xB2,                               // db 0xC7, 0xB2 (invalid opcode)
-            0xC3                                      // ret
-        };
+            return true;
+        }
 
-        PVOID base_address = nullptr;
-        SIZE_T region_size = sizeof(shellcode);
-        constexpr u32 STATUS_SUCCESS = 0x00000000u;
+        [[nodiscard]] static bool is_setting_flag_set(const flagset& flags) {
+            for (std::size_t i = settings_begin; i < settings_end; i++) {
+                if (flags.test(i)) {
+                    return true;
+                }
+            }
 
-        if (nt_allocate_virtual_memory(current_process, &base_address, 0, &region_size,
-            MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE) != STATUS_SUCCESS) {
             return false;
         }
 
-        memcpy(base_address, shellcode, sizeof(shellcode));
+        // techniques that may run on a VM::PARALLEL worker thread. Everything else stays on the calling 
+        // thread, either because it lazily fills the shared cpu/memo caches (leaf_cache, cpu_brand, 
+        // threadcount), because it's timing based, or simply because it hasn't been checked for shared 
+        // state yet. The ones below only read files, directories and sockets through locals and the 
+        // run's util::file_cache, so a technique has to be audited the same way before it's added here
+        [[nodiscard]] static bool is_parallel_safe(const enum_flags flag) noexcept {
+            switch (flag) {
+                case FIRMWARE:
+                case DEVICES:
+                case SMBIOS_VM_BIT:
+                case KMSG:
+                case CVENDOR:
+                case QEMU_FW_CFG:
+                case SYSTEMD:
+                case CTYPE:
+                case DOCKERENV:
+                case DMIDECODE:
+                case DMESG:
+                case HWMON:
+                case LINUX_USER_HOST:
+                case VMWARE_IOMEM:
+                case VMWARE_IOPORTS:
+                case VMWARE_SCSI:
+                case VMWARE_DMESG:
+                case QEMU_VIRTUAL_DMI:
+                case QEMU_USB:
+                case HYPERVISOR_DIR:
+                case VBOX_MODULE:
+                case SYSINFO_PROC:
+                case DMI_SCAN:
+                case PODMAN_FILE:
+                case WSL_PROC:
+                case FILE_ACCESS_HISTORY:
+                case MAC:
+                case CONTAINER_PID:
+                case BLUESTACKS_FOLDERS:
+                case TEMPERATURE:
+                case CGROUP:
+                case PROCESSES:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        // how long the result of a technique stays valid in milliseconds, see VM::refresh(). These can 
+        // change without a reboot or differ between processes on the same boot (like one inside a 
+        // container and one outside of it), everything else is CPU or firmware evidence and never expires
+        [[nodiscard]] static u32 lifetime_of(const enum_flags flag) noexcept {
+            switch (flag) {
+                case PROCESSES:
+                    return 5000;
+                case CGROUP:
+                case CONTAINER_PID:
+                case DOCKERENV:
+                case PODMAN_FILE:
+                    return 30000;
+                case LINUX_USER_HOST:
+                case FILE_ACCESS_HISTORY:
+                case MAC:
+                case TIMER:
+                    return 60000;
+                default:
+                    return 0;
+            }
+        }
 
-        ULONG old_protect = 0;
-        SIZE_T protect_size = sizeof(shellcode);
-        if (nt_protect_virtual_memory(current_process, &base_address, &protect_size,
-            PAGE_EXECUTE_READ, &old_protect) != STATUS_SUCCESS) {
-            SIZE_T free_size = 0; 
-            nt_free_virtual_memory(current_process, &base_address, &free_size, MEM_RELEASE);
-            return false;
+        [[nodiscard]] static bool is_volatile(const enum_flags flag) noexcept {
+            return (lifetime_of(flag) != 0);
         }
 
-        nt_flush_instruction_cache(current_process, base_address, sizeof(shellcode));
+        // runs a single technique while recording its core::add() calls instead of applying them
+        static void run_journaled(const u8 technique_id, technique_outcome& outcome) noexcept {
+            const technique& technique_data = technique_table.at(technique_id);
+            const util::file_cache_scope file_scope; // only a new one if this isn't part of a whole run
+            std::vector<brand_contribution>* const outer_journal = brand_journal;
 
-        bool is_vm = false;
-        DWORD exc_code = 0;
+            brand_journal = &outcome.journal;
+            last_detected_brand = brand_enum::NULL_BRAND;
+            last_detected_score = 0;
 
-        __try {
-            using func_ptr = void(*)();
-            const auto func = reinterpret_cast<func_ptr>(base_address);
-            func();
+            const auto start = std::chrono::steady_clock::now();
 
-            is_vm = true;
-        }
-        __except (exc_code = GetExceptionCode(), EXCEPTION_EXECUTE_HANDLER) {
-            if (exc_code == EXCEPTION_SINGLE_STEP) {
-                // trap flag single-step exception triggered on CPUID
-                is_vm = false;
+            try {
+                outcome.result = technique_data.run();
+            } catch (...) {
+                // rethrown by run_all() at the position the serial loop would have thrown it
+                outcome.error = std::current_exception();
             }
-            else {
-                // hypervisor delayed the trap flag over cpuid, execution fell through into 
-                // the bad bytes (C7 B2) causing EXCEPTION_ILLEGAL_INSTRUCTION
-                is_vm = true;
+
+            const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+            outcome.elapsed_ns = static_cast<u64>(elapsed.count());
+            technique_latency.at(technique_id).store(
+                static_cast<u32>(std::min<u64>(std::max<u64>(outcome.elapsed_ns, 1), std::numeric_limits<u32>::max())),
+                std::memory_order_relaxed
+            );
+
+            if (outcome.result) {
+                outcome.points = (last_detected_score > 0) ? last_detected_score : technique_data.points;
+                outcome.brand = last_detected_brand;
             }
-        }
 
-        SIZE_T free_size = 0; 
-        nt_free_virtual_memory(current_process, &base_address, &free_size, MEM_RELEASE);
+            outcome.dispatched = true;
+            brand_journal = outer_journal;
+        }
 
-        return is_vm;
-    #endif
-    }
+        // caches the outcome of a technique run by the calling thread, or gives up its claim if it threw
+        static void publish_outcome(const u8 technique_id, technique_outcome& outcome) {
+            if (outcome.error) {
+                memo::release_technique(technique_id);
+                return;
+            }
 
+            memo::cache_store(
+                technique_id, 
+                outcome.result, 
+                (outcome.result ? outcome.points : static_cast<u8>(0)), 
+                outcome.brand, 
+                std::move(outcome.journal)
+            );
+        }
 
-    /**
-     * @brief Check whether a hypervisor does not correctly emulate instructions in compatibility mode
-     * @category Windows, x86_64
-     * @implements VM::EIP_OVERFLOW
-     */
-    [[nodiscard]] static bool eip_overflow() {
-    #if (!x86_64) 
-        // this requires mapping executable memory at the end of the 4GB address space (0xFFFF0000) so an instruction can wrap the 32 bit boundary
-        // because NtAllocateVirtualMemory will always return 0xC0000018 (STATUS_CONFLICTING_ADDRESSES) we physically cannot place an instruction at 0xFFFFFFFE
-        return false; 
-    #else   
-        #pragma pack(push, 1)
-        struct iretq_frame {
-            u64 ip;
-            u64 cs;
-        };
-        #pragma pack(pop)
+        // true if the calling thread has to run the technique, false if it's cached
+        // (possibly after waiting for another thread that was running it)
+        static bool claim_or_wait(const u8 technique_id) {
+            while (!memo::is_cached(technique_id)) {
+                if (memo::claim_technique(technique_id)) {
+                    return true;
+                }
 
-        static bool hypervisor_detected = true;
-        static uintptr_t g_recovery_pad = 0;
-        static u64 g_saved_rsp = 0;
+                memo::wait_for_technique(technique_id);
+            }
 
-        const HMODULE ntdll = util::get_ntdll();
-        if (!ntdll) return false;
+            return false;
+        }
 
-        const char* names[] = {
-            "NtAllocateVirtualMemory",
-            "NtProtectVirtualMemory",
-            "NtFlushInstructionCache",
-            "NtFreeVirtualMemory",
-            "RtlAddVectoredExceptionHandler",
-            "RtlRemoveVectoredExceptionHandler"
-        };
+        // nominal runtime of each cost class in nanoseconds, only used until a technique has been measured
+        [[nodiscard]] static u32 nominal_latency(const cost cost_class) noexcept {
+            switch (cost_class) {
+                case cost::CPUID: return 1000;
+                case cost::CPU: return 50000;
+                case cost::IO: return 20000;
+                case cost::SCAN: return 1000000;
+                case cost::EXEC: return 30000000;
+            }
 
-        void* funcs[ARRAYSIZE(names)] = {};
-        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+            return 1000000;
+        }
 
-        using nt_allocate_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, ULONG_PTR, PSIZE_T, ULONG, ULONG);
-        using nt_protect_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG, PULONG);
-        using nt_flush_instruction_cache_t = NTSTATUS(__stdcall*)(HANDLE, PVOID, SIZE_T);
-        using nt_free_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG);
-        using rtl_add_vectored_exception_handler_t = PVOID(__stdcall*)(ULONG, PVECTORED_EXCEPTION_HANDLER);
-        using rtl_remove_vectored_exception_handler_t = ULONG(__stdcall*)(PVOID);
+        [[nodiscard]] static u32 expected_latency(const u8 technique_id) noexcept {
+            const u32 measured = technique_latency.at(technique_id).load(std::memory_order_relaxed);
 
-        const auto nt_allocate_virtual_memory = reinterpret_cast<nt_allocate_virtual_memory_t>(funcs[0]);
-        const auto nt_protect_virtual_memory = reinterpret_cast<nt_protect_virtual_memory_t>(funcs[1]);
-        const auto nt_flush_instruction_cache = reinterpret_cast<nt_flush_instruction_cache_t>(funcs[2]);
-        const auto nt_free_virtual_memory = reinterpret_cast<nt_free_virtual_memory_t>(funcs[3]);
-        const auto rtl_add_vectored_exception_handler = reinterpret_cast<rtl_add_vectored_exception_handler_t>(funcs[4]);
-        const auto rtl_remove_vectored_exception_handler = reinterpret_cast<rtl_remove_vectored_exception_handler_t>(funcs[5]);
+            if (measured > 0) {
+                return measured;
+            }
 
-        if (!nt_allocate_virtual_memory || !nt_protect_virtual_memory ||
-            !nt_flush_instruction_cache || !nt_free_virtual_memory ||
-            !rtl_add_vectored_exception_handler || !rtl_remove_vectored_exception_handler) {
-            return false;
+            return nominal_latency(technique_table.at(technique_id).cost_class);
         }
 
-        const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
-
-        auto eip_overflow_veh = [](PEXCEPTION_POINTERS exc_info) -> LONG {
-            // check for the expected access violation
-            if (exc_info->ExceptionRecord->ExceptionCode == EXCEPTION_ACCESS_VIOLATION) {
-                DWORD64 fault_ip = exc_info->ContextRecord->Rip;
-                DWORD cs_reg = exc_info->ContextRecord->SegCs;
+        // the order in which run_all() visits the enabled techniques. With a shortcut, the
+        // techniques expected to give the most points per nanosecond come first so the threshold 
+        // is reached with the least work, cached ones are free and thus always at the front.
+        // Ties keep the technique table order
+        [[nodiscard]] static std::vector<u8> schedule(const flagset& flags, const bool by_yield) {
+            std::vector<u8> order;
+            order.reserve(technique_end - technique_begin);
 
-                // verify EIP correctly truncated and wrapped to 0x0 in 32-bit mode
-                // if hypervisor only supports x86_64, RIP will be 0x100000000
-                if (fault_ip == 0x0 && cs_reg == 0x23) {
-                    hypervisor_detected = false;
+            for (u8 i = technique_begin; i < technique_end; ++i) {
+                if (technique_table.at(i).run && core::is_selected(flags, i)) {
+                    order.push_back(i);
                 }
             }
 
-            if (g_recovery_pad != 0) {
-                exc_info->ContextRecord->SegCs = 0x33;
-                exc_info->ContextRecord->Rip = g_recovery_pad;   // cleanup shellcode
-                exc_info->ContextRecord->Rsp = g_saved_rsp;
-                return EXCEPTION_CONTINUE_EXECUTION;
+            if (!by_yield) {
+                return order;
             }
 
-            return EXCEPTION_CONTINUE_SEARCH;
-        };
-
-        const PVOID handler_ptr = rtl_add_vectored_exception_handler(1, static_cast<PVECTORED_EXCEPTION_HANDLER>(eip_overflow_veh));
-        if (!handler_ptr) return false;
+            // snapshot, the latencies might be updated by other threads while sorting
+            std::array<u32, enum_size + 1> latency{};
 
-        // shellcode byte arrays for ms x64 fastcall (rcx=frame, rdx=stack32, r8=&g_saved_rsp)
-        constexpr unsigned char switch_stub[] = {
-            0x53, 0x55, 0x57, 0x56, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57, // push rbx, rbp, rdi, rsi, r12-r15
-            0x49, 0x89, 0x20,                                                       // mov qword ptr [r8], rsp
-            0x66, 0x8C, 0xD0,                                                       // mov ax, ss
-            0x50,                                                                   // push rax
-            0x52,                                                                   // push rdx
-            0x9C,                                                                   // pushfq
-            0x48, 0x8B, 0x41, 0x08,                                                 // mov rax, qword ptr [rcx + 8]
-            0x50,                                                                   // push rax
-            0x48, 0x8B, 0x01,                                                       // mov rax, qword ptr [rcx]
-            0x50,                                                                   // push rax
-            0x48, 0xCF                                                              // iretq
-        };
+            for (const u8 id : order) {
+                latency.at(id) = (memo::is_cached(id) ? 1 : expected_latency(id));
+            }
 
-        constexpr unsigned char recover_stub[] = {
-            0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5E, 0x5F, 0x5D, 0x5B, // pop r15-r12, rsi, rdi, rbp, rbx
-            0xC3                                                                    // ret
-        };
+            std::stable_sort(order.begin(), order.end(), [&latency](const u8 a, const u8 b) {
+                return (
+                    static_cast<u64>(technique_table.at(a).points) * latency.at(b) >
+                    static_cast<u64>(technique_table.at(b).points) * latency.at(a)
+                );
+            });
 
-        // memory for execution stubs
-        PVOID shellcode_base = nullptr;
-        SIZE_T shellcode_size = sizeof(switch_stub) + sizeof(recover_stub);
-        if (nt_allocate_virtual_memory(current_process, &shellcode_base, 0, &shellcode_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE) < 0) {
-            rtl_remove_vectored_exception_handler(handler_ptr);
-            return false;
+            return order;
         }
 
-        // map stub bytes into allocated chunk
-        u8* code_ptr = static_cast<u8*>(shellcode_base);
-        for (size_t i = 0; i < sizeof(switch_stub); ++i) code_ptr[i] = switch_stub[i];
-
-        u8* rec_ptr = code_ptr + sizeof(switch_stub);
-        for (size_t i = 0; i < sizeof(recover_stub); ++i) rec_ptr[i] = recover_stub[i];
-
-        // executable memory protection
-        ULONG old_protect = 0;
-        nt_protect_virtual_memory(current_process, &shellcode_base, &shellcode_size, PAGE_EXECUTE_READ, &old_protect);
-        nt_flush_instruction_cache(current_process, shellcode_base, shellcode_size);
+        // shared between a VM::*_async() call and its caller, the run stops before the next technique once cancelled
+        struct cancel_token {
+            std::shared_ptr<std::atomic<bool>> state = std::make_shared<std::atomic<bool>>(false);
 
-        // recovery jump target for veh
-        g_recovery_pad = reinterpret_cast<uintptr_t>(rec_ptr);
+            void cancel() const noexcept {
+                state->store(true, std::memory_order_release);
+            }
 
-        // dynamically allocate a 32-bit compatible stack (must reside below 4GB)
-        PVOID stack32_base = nullptr;
-        SIZE_T stack32_size = 0x10000;
-        for (uintptr_t addr = 0x20000000; addr < 0x80000000; addr += 0x10000000) {
-            stack32_base = reinterpret_cast<PVOID>(addr);
-            if (nt_allocate_virtual_memory(current_process, &stack32_base, 0, &stack32_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE) >= 0) {
-                break;
+            bool is_cancelled() const noexcept {
+                return state->load(std::memory_order_acquire);
             }
-            stack32_base = nullptr;
-        }
+        };
 
-        if (!stack32_base) {
-            SIZE_T free_size = 0;
-            nt_free_virtual_memory(current_process, &shellcode_base, &free_size, MEM_RELEASE);
-            rtl_remove_vectored_exception_handler(handler_ptr);
-            return false;
-        }
+        // stored in the future of a VM::*_async() call that was cancelled before it could finish
+        struct detection_cancelled : public std::runtime_error {
+            detection_cancelled() : std::runtime_error("VM detection was cancelled before all the techniques were run") {}
+        };
 
-        // align stack pointer
-        uintptr_t stack32_ptr = reinterpret_cast<uintptr_t>(stack32_base) + 0x10000 - 0x20;
+        // outcome of a single technique, passed to the VM::for_each_technique() callback
+        struct technique_report {
+            enum_flags technique;
+            bool detected;
+            u8 points;            // 0 if not detected
+            const char* brand;    // "Unknown" if the technique didn't point to a specific brand
+            u64 elapsed_ns;       // 0 if the result came from the cache
+            bool cached;
+        };
 
-        // high-boundary 32-bit execution target
-        PVOID boundary_base = reinterpret_cast<PVOID>(0xFFFF0000ULL);
-        SIZE_T boundary_size = 0x10000ULL;
-        NTSTATUS alloc_status = nt_allocate_virtual_memory(current_process, &boundary_base, 0, &boundary_size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+        // returning false stops the run
+        using technique_callback = std::function<bool(const technique_report&)>;
+
+        // optional limits for a single run_all() call, used by the VM::*_within(), VM::*_async() and VM::for_each_technique() functions
+        struct run_control {
+            bool has_deadline = false;
+            std::chrono::steady_clock::time_point deadline{};
+            std::vector<enum_flags>* skipped = nullptr; // techniques left out because of the deadline
+            const std::atomic<bool>* cancelled = nullptr;
+            const technique_callback* on_technique = nullptr;
+            bool skip_custom = false; // a VM::context runs its own custom techniques
+        };
 
-        if (alloc_status >= 0) {
-            if (boundary_base == reinterpret_cast<PVOID>(0xFFFF0000ULL)) {
-                // inject cpuid at the strict end of the compat-mode space
-                u8* execution_target = reinterpret_cast<u8*>(0xFFFFFFFEULL);
-                execution_target[0] = 0x0F;
-                execution_target[1] = 0xA2;
+        [[nodiscard]] static bool is_cancelled(const run_control* control) noexcept {
+            return (
+                (control != nullptr) &&
+                (control->cancelled != nullptr) &&
+                control->cancelled->load(std::memory_order_acquire)
+            );
+        }
 
-                iretq_frame frame = {};
-                frame.ip = 0xFFFFFFFEULL;
-                frame.cs = 0x23;
+        // handle of a detection running in the background, see VM::detect_async(). It owns the thread of
+        // the detection, so dropping it cancels the detection and waits for the current technique to end
+        template <typename T>
+        struct async_result {
+            std::future<T> future;
+            cancel_token token;
+            std::thread worker;
+
+            async_result() = default;
+
+            async_result(async_result&& other) noexcept
+                : future(std::move(other.future)), token(other.token), worker(std::move(other.worker)) {}
+
+            async_result& operator=(async_result&& other) noexcept {
+                if (this != &other) {
+                    stop();
+                    future = std::move(other.future);
+                    token = other.token;
+                    worker = std::move(other.worker);
+                }
 
-                // dispatch hardware context switch shellcode
-                auto switch_func = reinterpret_cast<void(*)(iretq_frame*, uintptr_t, u64*)>(code_ptr);
-                switch_func(&frame, stack32_ptr, &g_saved_rsp);
+                return *this;
             }
-            SIZE_T free_size = 0;
-            nt_free_virtual_memory(current_process, &boundary_base, &free_size, MEM_RELEASE);
-        }
 
-        SIZE_T free_size = 0;
-        nt_free_virtual_memory(current_process, &stack32_base, &free_size, MEM_RELEASE);
+            ~async_result() {
+                stop();
+            }
 
-        free_size = 0;
-        nt_free_virtual_memory(current_process, &shellcode_base, &free_size, MEM_RELEASE);
+            // blocks until the result is available, throws VM::detection_cancelled if it was cancelled
+            T get() {
+                return future.get();
+            }
 
-        rtl_remove_vectored_exception_handler(handler_ptr);
+            // false once get() has taken the result
+            bool is_ready() const {
+                return (
+                    future.valid() &&
+                    (future.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+                );
+            }
 
-        return hypervisor_detected;
-    #endif  
-    }
+            void cancel() const noexcept {
+                token.cancel();
+            }
 
+        private:
+            void stop() noexcept {
+                if (worker.joinable()) {
+                    token.cancel();
+                    worker.join();
+                }
+            }
+        };
 
-    /**
-     * @brief Check whether a hypervisor leaks EFER.SVME into guest context via SVM instruction fault type
-     * @category Windows, x86
-     * @implements VM::SVM_EXCEPTIONS
-     */
-    [[nodiscard]] static bool svm_exceptions() {
-    #if (x86)
-        if (!cpu::is_amd()) {
-            debug("SVM_EXCEPTIONS: AMD CPU not detected, skipping");
-            return false;
-        }
+        // runs the techniques on a separate thread and hands the actual result over to finish(), which then only reads the cache
+        template <typename T>
+        static async_result<T> launch_async(const flagset& flags, const bool shortcut, T(*finish)(const flagset&)) {
+            async_result<T> handle;
+            const cancel_token token = handle.token;
 
-        if (util::hyper_x() == HYPERV_ARTIFACT_VM) {
-            return false;
-        }
+            std::promise<T> promise;
+            handle.future = promise.get_future();
 
-        u32 eax = 0, ebx = 0, ecx = 0, edx = 0;
-        cpu::cpuid(eax, ebx, ecx, edx, 0x80000001);
-        const bool svmcpuid_visible = ((ecx >> 2) & 1) != 0;
+            handle.worker = std::thread([flags, shortcut, finish, token](std::promise<T> result) {
+                try {
+                    const memo::detection_guard guard;
 
-        const HMODULE ntdll = util::get_ntdll();
-        if (!ntdll) {
-            return false;
-        }
+                    run_control control;
+                    control.cancelled = token.state.get();
 
-        using nt_allocate_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, ULONG_PTR, PSIZE_T, ULONG, ULONG);
-        using nt_protect_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG, PULONG);
-        using nt_free_virtual_memory_t = NTSTATUS(__stdcall*)(HANDLE, PVOID*, PSIZE_T, ULONG);
-        using nt_flush_instruction_cache_t = NTSTATUS(__stdcall*)(HANDLE, PVOID, SIZE_T);
+                    run_all(flags, shortcut, &control);
+
+                    result.set_value(finish(flags));
+                } catch (...) {
+                    result.set_exception(std::current_exception());
+                }
+            }, std::move(promise));
 
-        const char* names[] = {
-            "NtAllocateVirtualMemory",
-            "NtProtectVirtualMemory",
-            "NtFreeVirtualMemory",
-            "NtFlushInstructionCache"
-        };
+            return handle;
+        }
 
-        void* funcs[ARRAYSIZE(names)] = {};
-        util::get_function_address(ntdll, names, funcs, ARRAYSIZE(names));
+        static run_control make_deadline(const std::chrono::microseconds budget, std::vector<enum_flags>& skipped) {
+            run_control control;
+            control.has_deadline = true;
+            control.deadline = std::chrono::steady_clock::now() + budget;
+            control.skipped = &skipped;
+            return control;
+        }
 
-        const auto nt_allocate_virtual_memory = reinterpret_cast<nt_allocate_virtual_memory_t>(funcs[0]);
-        const auto nt_protect_virtual_memory = reinterpret_cast<nt_protect_virtual_memory_t>(funcs[1]);
-        const auto nt_free_virtual_memory = reinterpret_cast<nt_free_virtual_memory_t>(funcs[2]);
-        const auto nt_flush_instruction_cache = reinterpret_cast<nt_flush_instruction_cache_t>(funcs[3]);
+        // 150, or 300 if VM::HIGH_THRESHOLD is enabled
+        [[nodiscard]] static u16 threshold_for(const flagset& flags) noexcept {
+            return (core::is_enabled(flags, HIGH_THRESHOLD) ? high_threshold_score : threshold_score);
+        }
 
-        if (!nt_allocate_virtual_memory || !nt_protect_virtual_memory || !nt_free_virtual_memory || !nt_flush_instruction_cache) {
-            return false;
+        [[nodiscard]] static u8 score_to_percentage(const u16 points, const flagset& flags) noexcept {
+            // the percentage will be set to 99%, because a score 
+            // of 100 is not entirely robust. 150 is more robust
+            // in my opinion, which is why you need a score of
+            // above 150 to get to 100% 
+            if (points >= threshold_for(flags)) {
+                return 100;
+            } else if (points >= 100) {
+                return 99;
+            }
+
+            return static_cast<u8>(std::min<u16>(points, 99));
         }
 
-        constexpr std::array<std::array<u8, 4>, 5> opcodes{ {
-            { 0x0F, 0x01, 0xD8, 0xC3 }, // VMRUN
-            { 0x0F, 0x01, 0xDA, 0xC3 }, // VMLOAD
-            { 0x0F, 0x01, 0xDB, 0xC3 }, // VMSAVE
-            { 0x0F, 0x01, 0xDD, 0xC3 }, // CLGI
-            { 0x0F, 0x01, 0xDF, 0xC3 }  // INVLPGA
-        } };
+        // the VM::is_hardened() rules, which look for techniques that should've been detected together but weren't.
+        // A rule is only applied if every technique it compares is selected in the flags, so a VM::context or a 
+        // tier never runs or looks at a technique it left out, and a missing result isn't mistaken for a clean one
+        [[nodiscard]] static bool hardening_rules(const flagset& flags) {
+            auto selected = [&flags](const std::initializer_list<enum_flags> techniques) -> bool {
+                for (const enum_flags technique : techniques) {
+                    if (!is_selected(flags, technique)) {
+                        return false;
+                    }
+                }
 
-        constexpr SIZE_T opcode_size = 4;
-        const HANDLE current_process = reinterpret_cast<HANDLE>(-1);
+                return true;
+            };
 
-        for (const auto& opcode : opcodes) {
-            PVOID base_address = nullptr;
-            SIZE_T region_size = 0x1000;
+            // Helper to get the specific brand associated with a technique using the cache
+            auto detected_brand = [](const enum_flags flag) -> enum brand_enum {
+                if (!VM::check(flag)) {
+                    return brand_enum::NULL_BRAND;
+                }
+                return memo::cache_fetch(flag).brand_name;
+            };
 
-            auto free_region = [&]() {
-                if (base_address) {
-                    SIZE_T free_size = 0;
-                    nt_free_virtual_memory(current_process, &base_address, &free_size, MEM_RELEASE);
-                    base_address = nullptr;
+            // whether the hypervisor bit or string found anything, Hyper-V's root partition included
+            auto hypervisor_seen = []() -> bool {
+                if (VM::check(VM::HYPERVISOR_BIT) || VM::check(VM::HYPERVISOR_STR)) {
+                    return true;
                 }
+
+                const brand_enum bit_brand = memo::cache_fetch(VM::HYPERVISOR_BIT).brand_name;
+                const brand_enum str_brand = memo::cache_fetch(VM::HYPERVISOR_STR).brand_name;
+
+                return (
+                    (bit_brand == brand_enum::HYPERV_ROOT) || 
+                    (str_brand == brand_enum::HYPERV_ROOT)
+                );
             };
 
-            NTSTATUS status = nt_allocate_virtual_memory(
-                current_process,
-                &base_address,
-                0,
-                &region_size,
-                MEM_COMMIT | MEM_RESERVE,
-                PAGE_EXECUTE_READWRITE
+            const enum brand_enum firmware_brand = (
+                is_selected(flags, VM::FIRMWARE) ? 
+                detected_brand(VM::FIRMWARE) : 
+                brand_enum::NULL_BRAND
             );
 
-            if (!NT_SUCCESS(status)) {
-                continue;
+            // rule 1: if VM::FIRMWARE is detected, so should VM::HYPERVISOR_BIT or VM::HYPERVISOR_STR
+            if (
+                firmware_brand != brand_enum::NULL_BRAND && 
+                selected({ VM::HYPERVISOR_BIT, VM::HYPERVISOR_STR }) && 
+                !hypervisor_seen()
+            ) {
+                debug("is_hardened(): firmware and hypervisor bit/str are not detected together");
+                return true;
             }
 
-            memcpy(base_address, opcode.data(), opcode_size);
-            nt_flush_instruction_cache(current_process, base_address, opcode_size);
+        #if (LINUX)
+            // rule 2: if VM::FIRMWARE is detected, so should VM::CVENDOR (QEMU or VBOX)
+            if ((firmware_brand == brand_enum::QEMU || firmware_brand == brand_enum::VBOX) && selected({ VM::CVENDOR })) {
+                const enum brand_enum cvendor_brand = detected_brand(VM::CVENDOR);
+                if (firmware_brand != cvendor_brand) {
+                    debug("is_hardened(): firmware and chassis vendor brands do not match");
+                    return true;
+                }
+            }
+        #endif
 
-            ULONG old_protect = 0;
-            PVOID protect_address = base_address;
-            SIZE_T protect_size = region_size;
+        #if (WINDOWS)
+            // rule 3: if VM::ACPI_SIGNATURE (QEMU) is detected, so should VM::FIRMWARE (QEMU)
+            if (selected({ VM::ACPI_SIGNATURE, VM::FIRMWARE })) {
+                const enum brand_enum acpi_brand = detected_brand(VM::ACPI_SIGNATURE);
+                if (acpi_brand == brand_enum::QEMU && firmware_brand != brand_enum::QEMU) {
+                    debug("is_hardened(): firmware and ACPI signature are not detected together");
+                    return true;
+                }
+            }
 
-            status = nt_protect_virtual_memory(
-                current_process,
-                &protect_address,
-                &protect_size,
-                PAGE_EXECUTE_READ,
-                &old_protect
+            // rule 4: if VM::TRAP or VM::NVRAM is detected, so should VM::HYPERVISOR_BIT or VM::HYPERVISOR_STR
+            const bool trap_or_nvram = (
+                (selected({ VM::TRAP }) && VM::check(VM::TRAP)) ||
+                (selected({ VM::NVRAM }) && VM::check(VM::NVRAM))
             );
 
-            if (!NT_SUCCESS(status)) {
-                free_region();
-                continue;
+            if (trap_or_nvram && selected({ VM::HYPERVISOR_BIT, VM::HYPERVISOR_STR }) && !hypervisor_seen()) {
+                debug("is_hardened(): trap/NVRAM and hypervisor bit/str are not detected together");
+                return true;
             }
+        #endif
 
-            nt_flush_instruction_cache(current_process, base_address, opcode_size);
-
-            DWORD exception_status = 0;
-            bool fault_hit = false;
+            return false;
+        }
 
-            __try {
-                reinterpret_cast<void(*)()>(base_address)();
-            }
-            __except (exception_status = GetExceptionCode(), EXCEPTION_EXECUTE_HANDLER) {
-                fault_hit = true;
+        // what the detections fall back to when the score isn't enough. A tier only gets the rules over its 
+        // own techniques, since VM::is_hardened() would run the firmware and file based ones it left out
+        [[nodiscard]] static bool hardened_for(const flagset& flags) {
+            if (is_tiered(flags)) {
+                return hardening_rules(flags);
             }
 
-            free_region();
+            return VM::is_hardened();
+        }
 
-            if (!fault_hit) {
-                continue;
+        // whether the technique is expected to finish before the deadline of the run. Techniques can't be
+        // interrupted once they're started, so this is the only place the deadline is enforced. A technique
+        // is only started if both its nominal cost and its last measured runtime fit in what's left, which
+        // makes the budget an estimate: a technique that's slower than both on this machine still overruns it
+        [[nodiscard]] static bool fits_budget(const run_control* control, const u8 technique_id) {
+            if ((control == nullptr) || !control->has_deadline) {
+                return true;
             }
 
-            if (exception_status == EXCEPTION_ILLEGAL_INSTRUCTION) {
-                continue;
-            }
+            const auto now = std::chrono::steady_clock::now();
 
-            if (svmcpuid_visible) {
-                debug("SVM_EXCEPTIONS: Detected SVM hypervisor");
-            }
-            else {
-                debug("SVM_EXCEPTIONS: Detected SVM hypervisor hiding CPU capabilities");
-                return core::add(brand_enum::NULL_BRAND, 150);
+            if (now >= control->deadline) {
+                return false;
             }
 
-            return true;
-        }
-    #endif
-        return false;
-    }
+            const auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(control->deadline - now);
+            const u32 nominal = nominal_latency(technique_table.at(technique_id).cost_class);
+            const u32 expected = std::max(nominal, expected_latency(technique_id));
 
-    // ADD NEW TECHNIQUE FUNCTION HERE
+            return (expected <= static_cast<u64>(remaining.count()));
+        }
 
+    #if (LINUX)
+        // every pseudo-file the selected and uncached techniques are going to read, for VM::PREFETCH.
+        // The paths have to be spelled exactly like the techniques spell them to be found in the cache
+        [[nodiscard]] static std::vector<std::string> prefetch_inputs(const flagset& flags) {
+            struct input {
+                enum_flags technique;
+                const char* path;
+            };
 
-    
+            static const input inputs[] = {
+                { THREAD_MISMATCH, "/sys/devices/system/cpu/cpu0/topology/thread_siblings_list" },
+                { THREAD_MISMATCH, "/proc/cpuinfo" },
+                { SYSTEMD, "/proc/sys/kernel/osrelease" },
+                { SYSTEMD, "/proc/self/status" },
+                { SYSTEMD, "/run/systemd/container" },
+                { SYSTEMD, "/run/host/container-manager" },
+                { SYSTEMD, "/proc/1/sched" },
+                { SYSTEMD, "/sys/hypervisor/type" },
+                { SYSTEMD, "/proc/xen/capabilities" },
+                { SYSTEMD, "/proc/device-tree/hypervisor/compatible" },
+                { SYSTEMD, "/proc/cpuinfo" },
+                { SYSTEMD, "/proc/sysinfo" },
+                { VMWARE_IOMEM, "/proc/iomem" },
+                { VMWARE_IOPORTS, "/proc/ioports" },
+                { VMWARE_SCSI, "/proc/scsi/scsi" },
+                { QEMU_VIRTUAL_DMI, "/sys/devices/virtual/dmi/id/sys_vendor" },
+                { QEMU_VIRTUAL_DMI, "/sys/devices/virtual/dmi/id/modalias" },
+                { QEMU_USB, "/sys/kernel/debug/usb/devices" },
+                { HYPERVISOR_DIR, "/sys/hypervisor/type" },
+                { UML_CPU, "/proc/cpuinfo" },
+                { VBOX_MODULE, "/proc/modules" },
+                { SYSINFO_PROC, "/proc/sysinfo" }
+            };
 
-    #if (CLANG)
-        #pragma clang diagnostic pop
-    #endif
-#endif
+            // without root the SMBIOS techniques fall back to these, see util::smbios()
+            static const char* const dmi_attributes[] = {
+                "bios_vendor", "sys_vendor", "product_name", "product_version", "product_family", "product_sku",
+                "board_vendor", "board_name", "chassis_vendor", "chassis_asset_tag", "chassis_type"
+            };
 
-#if (MSVC)
-    #pragma endregion
-#endif
+            auto wanted = [&flags](const enum_flags technique) -> bool {
+                return (core::is_selected(flags, technique) && !memo::is_cached(technique));
+            };
 
-    /* ============================================================================================== *
-     *                                                                                                *                                                                                               *
-     *                                        CORE SECTION                                            *
-     *                                                                                                *
-     * ============================================================================================== */
-    struct core {
-        struct technique {
-            u8 points = 0;                // this is the certainty score between 0 and 100
-            bool(*run)();                 // this is the technique function itself
+            std::vector<std::string> paths;
 
-            constexpr technique() : run(nullptr) {}
-            constexpr technique(u8 points, bool(*run)()) : points(points), run(run) {}
-        };
+            auto add = [&paths](std::string path) {
+                if (std::find(paths.begin(), paths.end(), path) == paths.end()) {
+                    paths.push_back(std::move(path));
+                }
+            };
 
-        struct custom_technique {
-            u8 points;
-            u16 id;
-            bool(*run)();
-        };
+            for (const input& entry : inputs) {
+                if (wanted(entry.technique)) {
+                    add(entry.path);
+                }
+            }
 
-        // entry for the initialization list
-        struct technique_entry { // NOLINT(cppcoreguidelines-pro-type-member-init)
-            enum_flags id;
-            technique tech;
-        };
+            const bool smbios_wanted = (
+                wanted(DMIDECODE) || wanted(SMBIOS_VM_BIT) || wanted(DMI_SCAN) ||
+                wanted(CVENDOR) || wanted(CTYPE) || wanted(SYSTEMD)
+            );
 
-        // entry for brand scoreboard
-        struct brand_entry {
-            brand_enum name;
-            brand_score_t score;
-        };
+            if (smbios_wanted && (access("/sys/firmware/dmi/tables/DMI", R_OK) != 0)) {
+                for (const char* attribute : dmi_attributes) {
+                    add(std::string("/sys/class/dmi/id/") + attribute);
+                }
+            }
 
-        // the actual table, which is derived from the list above and will be 
-        // used for most functionalities related to technique interactions
-        static std::array<technique, enum_size + 1> technique_table;
+            // any of these gathers all of the container evidence, see util::containers()
+            const bool containers_wanted = (
+                wanted(CGROUP) || wanted(CONTAINER_PID) || wanted(DOCKERENV) || wanted(PODMAN_FILE) || wanted(PROCESSES)
+            );
 
-        static std::vector<VM::core::custom_technique> custom_table; // users should not have a limit of how many functions they should add, this is the only exception of a heap-allocated object in our core
-        static size_t custom_table_size;
+            if (containers_wanted) {
+                add("/proc/self/cgroup");
+                add("/proc/self/mountinfo");
+                add("/proc/self/status");
+            }
 
-        static std::array<brand_entry, MAX_BRANDS> brand_scoreboard;
+            // one vendor and device attribute per PCI device, and one serial per disk
+            using name_filter = bool (*)(const char*);
 
-        // Temporary storage to capture which brand was detected by the currently running technique.
-        // thread_local ensures each thread running run_all() has its own independent copy.
-        static thread_local brand_enum last_detected_brand;
-        static thread_local u8 last_detected_score;
+            auto add_entries = [&add](const char* directory, const char* attribute_a, const char* attribute_b, const name_filter keep) {
+                DIR* dir = opendir(directory);
 
-        // 1. one brand, custom score
-        static bool add(const brand_enum p_brand, u8 score) noexcept {
-            return add_score(p_brand, brand_enum::NULL_BRAND, score);
-        }
+                if (dir == nullptr) {
+                    return;
+                }
 
-        // 2. one brand, default score
-        static bool add(const brand_enum p_brand) noexcept {
-            return add_score(p_brand, brand_enum::NULL_BRAND, 0);
-        }
+                while (const struct dirent* ent = readdir(dir)) {
+                    if ((ent->d_name[0] == '.') || ((keep != nullptr) && !keep(ent->d_name))) {
+                        continue;
+                    }
 
-        // 3. two brands, default score
-        static bool add(const brand_enum p_brand, const brand_enum extra_brand) noexcept {
-            return add_score(p_brand, extra_brand, 0);
-        }
+                    const std::string base = std::string(directory) + "/" + ent->d_name;
+                    add(base + attribute_a);
 
-        static bool add_score(const brand_enum p_brand, const brand_enum extra_brand, u8 score) noexcept {
-            last_detected_brand = p_brand;
-            last_detected_score = score; // Store for the engine to read
+                    if (attribute_b != nullptr) {
+                        add(base + attribute_b);
+                    }
+                }
 
-            brand_score_t brand_score = brand_scoreboard.at(static_cast<u8>(p_brand)).score;
+                closedir(dir);
+            };
 
-            brand_scoreboard.at(static_cast<u8>(p_brand)) = { p_brand, ++brand_score };
+            if (wanted(DEVICES)) {
+                add_entries("/sys/bus/pci/devices", "/vendor", "/device", nullptr);
+            }
 
-            if (extra_brand != brand_enum::NULL_BRAND) {
-                brand_scoreboard.at(static_cast<u8>(extra_brand)) = { extra_brand, ++brand_score };
+            if (wanted(DISK_SERIAL)) {
+                // the same disks disk_serial_number() looks at
+                add_entries("/sys/block", "/device/serial", nullptr, [](const char* name) -> bool {
+                    return (
+                        !strncmp(name, "nvme", 4) ||
+                        !strncmp(name, "sd", 2) ||
+                        !strncmp(name, "sg", 2) ||
+                        !strncmp(name, "hd", 2) ||
+                        !strncmp(name, "vd", 2)
+                    );
+                });
             }
 
-            return true;
+            return paths;
         }
+    #endif
 
-        // assert if the flag is enabled, far better expression than typing std::bitset member functions
-        [[nodiscard]] static bool is_disabled(const flagset& flags, const u8 flag_bit) noexcept {
-            if (flag_bit >= flags.size()) {
-                return true;
+        // VM::PARALLEL executor, runs every enabled and uncached technique over a small worker pool.
+        // Each outcome is cached as soon as it's done, and since the scoreboard is rebuilt from the 
+        // cache in technique order the result is exactly the same as with the serial loop
+        static std::vector<technique_outcome> run_parallel(const flagset& flags, const run_control* control) {
+            std::vector<technique_outcome> outcomes(technique_end);
+            std::vector<u8> serial_queue;
+            std::vector<u8> parallel_queue;
+
+            for (u8 i = technique_begin; i < technique_end; ++i) {
+                const enum_flags technique_macro = static_cast<enum_flags>(i);
+
+                if (
+                    (!technique_table.at(i).run) ||
+                    (!core::is_selected(flags, technique_macro)) ||
+                    (memo::is_cached(technique_macro))
+                ) {
+                    continue;
+                }
+
+                if (is_parallel_safe(technique_macro)) {
+                    parallel_queue.push_back(i);
+                } else {
+                    serial_queue.push_back(i);
+                }
             }
 
-            return !flags.test(flag_bit);
-        }
+            // claimed techniques are cached right away, so other threads never wait on this whole run
+            auto run_claimed = [&outcomes, control](const u8 id) {
+                if (is_cancelled(control) || !fits_budget(control, id) || !memo::claim_technique(id)) {
+                    return;
+                }
 
-        // same as above but for checking enabled flags
-        [[nodiscard]] static bool is_enabled(const flagset& flags, const u8 flag_bit) noexcept {
-            if (flag_bit >= flags.size()) {
-                return false;
+                run_journaled(id, outcomes.at(id));
+                publish_outcome(id, outcomes.at(id));
+            };
+
+            util::file_cache* const shared_cache = util::active_file_cache;
+
+            // these are cheap, so they're run before any worker is spawned 
+            // which also warms up the caches for the parallel ones
+            for (const u8 id : serial_queue) {
+                run_claimed(id);
             }
 
-            return flags.test(flag_bit);
-        }
+            std::atomic<size_t> next_index{ 0 };
 
-        [[nodiscard]] static bool are_techniques_empty(const flagset& flags) {
-            for (std::size_t i = technique_begin; i < technique_end; i++) {
-                if (flags.test(i)) {
-                    return false;
+            auto drain = [&]() noexcept {
+                const util::file_cache_scope file_scope(shared_cache);
+                const memo::inherited_detection detection;
+
+                for (size_t n = next_index++; n < parallel_queue.size(); n = next_index++) {
+                    run_claimed(parallel_queue.at(n));
+                }
+            };
+
+            const size_t worker_count = std::min<size_t>(memo::threadcount::fetch(), parallel_queue.size());
+            std::vector<std::thread> pool;
+            pool.reserve(worker_count);
+
+            // the calling thread is a worker as well, so failing to spawn a thread isn't fatal
+            for (size_t i = 1; i < worker_count; ++i) {
+                try {
+                    pool.emplace_back(drain);
+                } catch (...) {
+                    break;
                 }
             }
 
-            return true;
-        }
+            drain();
 
-        [[nodiscard]] static bool is_setting_flag_set(const flagset& flags) {
-            for (std::size_t i = settings_begin; i < settings_end; i++) {
-                if (flags.test(i)) {
-                    return true;
-                }
+            for (std::thread& worker : pool) {
+                worker.join();
             }
 
-            return false;
+            return outcomes;
         }
 
         // run every VM detection mechanism in the technique table
-        static u16 run_all(const flagset& flags, const bool shortcut = false) {
+        static u16 run_all(const flagset& flags, const bool shortcut = false, const run_control* control = nullptr) {
+            const memo::detection_guard guard;
             u16 points = 0;
-            detected_count_num.store(0);
+            u8 detected = 0;
 
             u16 threshold_points = threshold_score;
 
@@ -13248,54 +16272,133 @@ public:
                 threshold_points = high_threshold_score;
             }
 
-            for (size_t i = technique_begin; i < technique_end; ++i) {
-                const enum_flags technique_macro = static_cast<enum_flags>(i);
-                const technique& technique_data = technique_table.at(i);
+            const bool has_deadline = ((control != nullptr) && control->has_deadline);
+            const technique_callback* on_technique = ((control != nullptr) ? control->on_technique : nullptr);
+            const bool persistent = core::is_enabled(flags, PERSIST);
+            const bool shared = core::is_enabled(flags, SHARED);
 
-                // skip empty entries
-                if (!technique_data.run) {
-                    continue;
+            // every technique of this run shares the same file reads
+            const util::file_cache_scope file_scope;
+
+            // whatever another process already found on this boot is cached before anything is scheduled
+            if (shared) {
+                memo::shared::load();
+            }
+
+            if (persistent) {
+                memo::persist::load();
+            }
+
+        #if (LINUX)
+            // only what's still going to run is worth reading ahead
+            if (core::is_enabled(flags, PREFETCH)) {
+                util::prefetch_files(prefetch_inputs(flags));
+            }
+        #endif
+
+            // techniques are visited by expected yield when a shortcut is allowed, when there's
+            // a deadline to meet or when the results are streamed to a callback, see schedule()
+            const std::vector<u8> order = schedule(flags, (shortcut || has_deadline || (on_technique != nullptr)));
+
+            std::vector<technique_outcome> outcomes;
+
+        #if (LINUX)
+            if (core::is_enabled(flags, PARALLEL)) {
+                outcomes = run_parallel(flags, control);
+            }
+        #endif
+
+            if (outcomes.empty()) {
+                outcomes.resize(technique_end);
+            }
+
+            // the scoreboard is only rebuilt once the run is over, and this is also specific to 
+            // VM::detected_count() which returns the number of techniques that found a VM
+            auto finish = [&]() {
+                rebuild_scoreboard();
+                detected_count_num.store(detected);
+                last_detected_count = detected;
+
+                if (shared) {
+                    memo::shared::save();
                 }
 
-                // check if the technique is disabled
-                if (core::is_disabled(flags, technique_macro)) {
-                    continue;
+                if (persistent) {
+                    memo::persist::save();
+                }
+            };
+
+            // hands a single outcome to the VM::for_each_technique() callback, false means the caller wants to stop
+            auto report = [&](const enum_flags technique_macro, const memo::data_t& data, const u64 elapsed_ns) -> bool {
+                if (on_technique == nullptr) {
+                    return true;
                 }
 
-                // check if the technique is cached already
-                if (memo::is_cached(technique_macro)) {
-                    const memo::data_t data = memo::cache_fetch(technique_macro);
+                const technique_report entry = {
+                    technique_macro,
+                    data.result,
+                    (data.result ? data.points : static_cast<u8>(0)),
+                    brands::brand_enum_to_string(data.brand_name),
+                    elapsed_ns,
+                    data.cached
+                };
 
-                    if (data.result) {
-                        points += data.points;
-                        detected_count_num++;
+                try {
+                    return (*on_technique)(entry);
+                } catch (...) {
+                    finish();
+                    throw;
+                }
+            };
+
+            for (const u8 i : order) {
+                const enum_flags technique_macro = static_cast<enum_flags>(i);
+
+                // techniques that were already run by the VM::PARALLEL executor are cached by now
+                technique_outcome& outcome = outcomes.at(i);
+
+                if (!outcome.dispatched && !memo::is_cached(technique_macro)) {
+                    if (is_cancelled(control)) {
+                        finish();
+                        throw detection_cancelled();
                     }
 
-                    continue;
+                    // not cached either, so a later run without a deadline will still pick it up
+                    if (!fits_budget(control, i)) {
+                        debug("run_all: skipped ", flag_to_string(technique_macro), " because of the deadline");
+
+                        if (control->skipped != nullptr) {
+                            control->skipped->push_back(technique_macro);
+                        }
+
+                        continue;
+                    }
+
+                    // another thread might be running the same technique, in which case its result is used instead
+                    if (claim_or_wait(i)) {
+                        run_journaled(i, outcome);
+                        publish_outcome(i, outcome);
+                    }
                 }
 
-                // reset the last detected brand before running
-                last_detected_brand = brand_enum::NULL_BRAND;
-                last_detected_score = 0;
+                if (outcome.error) {
+                    finish();
+                    std::rethrow_exception(outcome.error);
+                }
 
-                // run the technique
-                const bool result = technique_data.run();
+                const memo::data_t data = memo::cache_fetch(technique_macro);
 
-                if (result) {
-                    // determine which points to use: Override or Default
-                    const u8 points_to_add = (last_detected_score > 0) ? last_detected_score : technique_data.points;
-
-                    points += points_to_add;
-                    // this is specific to VM::detected_count() which 
-                    // returns the number of techniques that found a VM.
-                    detected_count_num++;
-
-                    // retrieve the brand that was set during execution (if any)
-                    const enum brand_enum detected_brand = (last_detected_brand != brand_enum::NULL_BRAND) ? last_detected_brand : brand_enum::NULL_BRAND;
-                    // store the current technique result to the cache
-                    memo::cache_store(technique_macro, result, points_to_add, detected_brand);
-                } else {
-                    memo::cache_store(technique_macro, false, 0);
+                if (data.result) {
+                    points += data.points;
+                    detected++;
+                }
+
+                // only what this thread ran itself is reported as fresh
+                const bool ran_here = outcome.dispatched;
+
+                if (!report(technique_macro, { data.result, data.points, !ran_here, data.brand_name }, (ran_here ? outcome.elapsed_ns : 0))) {
+                    finish();
+                    return points;
                 }
 
                 // for things like VM::detect() and VM::percentage(),
@@ -13304,12 +16407,20 @@ public:
                 // (unless the threshold is set to be higher, but it's the 
                 // same story here nonetheless, except the threshold is 300)
                 if (shortcut && (points >= threshold_points)) {
+                    finish();
                     return points;
                 }
             }
 
-            // for custom VM techniques, won't be used most of the time
-            if (!core::custom_table.empty()) {
+            finish();
+
+            // for custom VM techniques, won't be used most of the time.
+            // Nothing is known about what they do, so they're left out by the cheaper tiers
+            if (
+                !core::custom_table.empty() && 
+                ((control == nullptr) || !control->skip_custom) &&
+                !is_tiered(flags)
+            ) {
                 for (const auto& technique : core::custom_table) {
 
                     // if cached, return that result
@@ -13319,10 +16430,15 @@ public:
                         if (data.result) {
                             points += data.points;
                             detected_count_num++;
+                            last_detected_count++;
                         }
                         continue;
                     }
 
+                    if (is_cancelled(control)) {
+                        throw detection_cancelled();
+                    }
+
                     // run the custom technique
                     const bool result = technique.run();
 
@@ -13330,6 +16446,7 @@ public:
                     if (result) {
                         points += technique.points;
                         detected_count_num++;
+                        last_detected_count++;
                     }
 
                     // cache the result
@@ -13362,8 +16479,8 @@ public:
           * enabled, while the latter will toggle those bits (if there's any) after 
           * the arg_handler processing is done.
           */
-        static flagset flag_collector;
-        static flagset disabled_flag_collector;
+        static thread_local flagset flag_collector;
+        static thread_local flagset disabled_flag_collector;
 
         // alternative settings method
         struct settings {
@@ -13397,6 +16514,13 @@ public:
             flags.flip(NULL_ARG);
             flags.flip(DYNAMIC);
             flags.flip(MULTIPLE);
+            flags.flip(PARALLEL);
+            flags.flip(TIER_FAST);
+            flags.flip(TIER_IO);
+            flags.flip(TIER_EXEC);
+            flags.flip(PERSIST);
+            flags.flip(SHARED);
+            flags.flip(PREFETCH);
             flags.flip(ALL);
         }
 
@@ -13536,6 +16660,21 @@ public:
 
     using settings = core::settings;
 
+    using cancel_token = core::cancel_token;
+    using detection_cancelled = core::detection_cancelled;
+
+    template <typename T>
+    using async_result = core::async_result<T>;
+
+    using technique_report = core::technique_report;
+
+    // return type of the VM::*_within() functions
+    template <typename T>
+    struct budget_result {
+        T value{};
+        std::vector<enum_flags> skipped; // techniques that weren't run because they didn't fit in the budget
+    };
+
     /**
      * @brief Check for a specific technique based on flag argument
      * @param u8 (flags from VM wrapper)
@@ -13551,8 +16690,12 @@ public:
     #if (SOURCE_LOCATION_SUPPORTED)
         VMAWARE_UNUSED(loc);
     #endif
+        const memo::detection_guard guard;
+
         if (util::is_unsupported(flag_bit)) {
-            memo::cache_store(flag_bit, false, 0);
+            if (memo::claim_technique(flag_bit)) {
+                memo::cache_store(flag_bit, false, 0);
+            }
             return false;
         }
 
@@ -13573,7 +16716,14 @@ public:
         if (
             (flag_bit == HIGH_THRESHOLD) ||
             (flag_bit == DYNAMIC) ||
-            (flag_bit == MULTIPLE)
+            (flag_bit == MULTIPLE) ||
+            (flag_bit == PARALLEL) ||
+            (flag_bit == TIER_FAST) ||
+            (flag_bit == TIER_IO) ||
+            (flag_bit == TIER_EXEC) ||
+            (flag_bit == PERSIST) ||
+            (flag_bit == SHARED) ||
+            (flag_bit == PREFETCH)
         ) {
             throw_error("Flag argument must be a technique flag and not a settings flag");
         }
@@ -13584,155 +16734,441 @@ public:
             return data.result;
         }
 
-        if (flag_bit >= technique_end) {
-            return false;
+        if (flag_bit >= technique_end) {
+            return false;
+        }
+
+        const core::technique& pair = core::technique_table.at(flag_bit);
+
+        if (pair.run) {
+            // if another thread is running the same technique, its result is returned instead
+            if (!core::claim_or_wait(flag_bit)) {
+                return memo::cache_fetch(flag_bit).result;
+            }
+
+            core::technique_outcome outcome;
+            core::run_journaled(flag_bit, outcome);
+            core::publish_outcome(flag_bit, outcome);
+
+            if (outcome.error) {
+                std::rethrow_exception(outcome.error);
+            }
+
+            if (outcome.result) {
+                detected_count_num++;
+                core::last_detected_count++;
+            }
+
+            core::rebuild_scoreboard();
+            return outcome.result;
+        }
+
+        throw_error("Flag is not known or not implemented");
+        return false; // useless but whatever
+    }
+
+
+    /**
+     * @brief Fetch the VM brand
+     * @param any flag combination in VM structure or nothing (VM::MULTIPLE can be added)
+     * @return const char*
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#vmbrand
+     */
+    template <typename ...Args>
+    static std::string brand(Args ...args) {
+        const flagset flags = core::arg_handler(args...);
+        return brand(flags);
+    }
+
+
+    static std::string brand(const settings& settings) {
+        const flagset flags = settings.flag_collector;
+        return brand(flags);
+    }
+
+
+    static std::string brand(const flagset& flags = core::generate_default()) {
+        const memo::detection_guard guard;
+
+        // is the multiple setting flag enabled?
+        const bool is_multiple = core::is_enabled(flags, MULTIPLE);
+
+        if (is_multiple) {
+            return brands::brand_multiple(flags);
+        }
+
+        const enum brand_enum b = brands::brand_single(flags);
+        return brands::brand_enum_to_string(b);
+    }
+
+
+    /**
+     * @brief Detect if running inside a VM
+     * @param any flag combination in VM structure or nothing
+     * @return bool
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#vmdetect
+     */
+    template <typename ...Args>
+    static bool detect(Args ...args) {
+        // fetch all the flags in a std::bitset
+        const flagset flags = core::arg_handler(args...);
+        return detect(flags);
+    }
+
+
+    static bool detect(const settings& settings) {
+        const flagset flags = settings.flag_collector;
+        return detect(flags);
+    }
+
+
+    static bool detect(const flagset &flags = core::generate_default()) {
+        const memo::detection_guard guard;
+
+        // run all the techniques based on the 
+        // flags above, and get a total score 
+        const u16 points = core::run_all(flags, SHORTCUT);
+
+        u16 threshold = threshold_score;
+
+        // if high threshold is set, the bar
+        // will be 300. If not, leave it as 150
+        if (core::is_enabled(flags, HIGH_THRESHOLD)) {
+            threshold = high_threshold_score;
+        }
+
+        if (points >= threshold) {
+            return true;
+        }
+
+        // this is added as a last ditch attempt to detect a VM, 
+        // because if there are indications of hardening then logically 
+        // it should in fact be a VM.
+        return (core::hardened_for(flags));
+    }
+
+
+    /**
+     * @brief Get the percentage of how likely it's a VM
+     * @param any flag combination in VM structure or nothing
+     * @return std::uint8_t
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#vmpercentage
+     */
+    template <typename ...Args>
+    static u8 percentage(Args ...args) {
+        // fetch all the flags in a std::bitset
+        const flagset flags = core::arg_handler(args...);
+        return percentage(flags);
+    }
+
+
+    static u8 percentage(const settings& settings) {
+        const flagset flags = settings.flag_collector;
+        return percentage(flags);
+    }
+
+
+    static u8 percentage(const flagset &flags = core::generate_default()) {
+        // run all the techniques based on the 
+        // flags above, and get a total score
+        const u16 points = core::run_all(flags, SHORTCUT);
+
+        return core::score_to_percentage(points, flags);
+    }
+
+
+    /**
+     * @brief Detect if running inside a VM, but only run the techniques that are expected to fit in the time budget
+     * @param budget (maximum time to spend, techniques are run from the cheapest evidence to the most expensive one)
+     * @param any flag combination in VM structure or nothing
+     * @return VM::budget_result<bool> (the verdict and the techniques that were skipped)
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#advanced-vmdetect_within
+     */
+    template <typename ...Args>
+    static budget_result<bool> detect_within(const std::chrono::microseconds budget, Args ...args) {
+        const flagset flags = core::arg_handler(args...);
+        return detect_within(budget, flags);
+    }
+
+
+    static budget_result<bool> detect_within(const std::chrono::microseconds budget, const settings& settings) {
+        const flagset flags = settings.flag_collector;
+        return detect_within(budget, flags);
+    }
+
+
+    static budget_result<bool> detect_within(const std::chrono::microseconds budget, const flagset& flags = core::generate_default()) {
+        const memo::detection_guard guard;
+
+        budget_result<bool> result;
+        const core::run_control control = core::make_deadline(budget, result.skipped);
+
+        const u16 points = core::run_all(flags, SHORTCUT, &control);
+
+        // is_hardened() runs its own set of techniques, so it's only 
+        // consulted if nothing had to be skipped and everything is cached
+        result.value = (
+            (points >= core::threshold_for(flags)) ||
+            (result.skipped.empty() && core::hardened_for(flags))
+        );
+
+        return result;
+    }
+
+
+    /**
+     * @brief Get the percentage of how likely it's a VM, but only run the techniques that are expected to fit in the time budget
+     * @param budget (maximum time to spend, techniques are run from the cheapest evidence to the most expensive one)
+     * @param any flag combination in VM structure or nothing
+     * @return VM::budget_result<std::uint8_t> (the percentage and the techniques that were skipped)
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#advanced-vmdetect_within
+     */
+    template <typename ...Args>
+    static budget_result<u8> percentage_within(const std::chrono::microseconds budget, Args ...args) {
+        const flagset flags = core::arg_handler(args...);
+        return percentage_within(budget, flags);
+    }
+
+
+    static budget_result<u8> percentage_within(const std::chrono::microseconds budget, const settings& settings) {
+        const flagset flags = settings.flag_collector;
+        return percentage_within(budget, flags);
+    }
+
+
+    static budget_result<u8> percentage_within(const std::chrono::microseconds budget, const flagset& flags = core::generate_default()) {
+        budget_result<u8> result;
+        const core::run_control control = core::make_deadline(budget, result.skipped);
+
+        const u16 points = core::run_all(flags, SHORTCUT, &control);
+
+        result.value = core::score_to_percentage(points, flags);
+        return result;
+    }
+
+
+    /**
+     * @brief Fetch the VM brand, but only run the techniques that are expected to fit in the time budget
+     * @param budget (maximum time to spend, techniques are run from the cheapest evidence to the most expensive one)
+     * @param any flag combination in VM structure or nothing (VM::MULTIPLE can be added)
+     * @return VM::budget_result<std::string> (the brand and the techniques that were skipped)
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#advanced-vmdetect_within
+     */
+    template <typename ...Args>
+    static budget_result<std::string> brand_within(const std::chrono::microseconds budget, Args ...args) {
+        const flagset flags = core::arg_handler(args...);
+        return brand_within(budget, flags);
+    }
+
+
+    static budget_result<std::string> brand_within(const std::chrono::microseconds budget, const settings& settings) {
+        const flagset flags = settings.flag_collector;
+        return brand_within(budget, flags);
+    }
+
+
+    static budget_result<std::string> brand_within(const std::chrono::microseconds budget, const flagset& flags = core::generate_default()) {
+        const memo::detection_guard guard;
+
+        budget_result<std::string> result;
+
+        // a full run already happened, so there's nothing left to spend the budget on
+        if (memo::brand_list::is_cached()) {
+            result.value = brand(flags);
+            return result;
+        }
+
+        const core::run_control control = core::make_deadline(budget, result.skipped);
+
+        const u16 score = core::run_all(flags, false, &control);
+
+        if (result.skipped.empty()) {
+            // every technique is cached by now, so this only builds and caches the brand list
+            result.value = brand(flags);
+            return result;
+        }
+
+        // partial results are never cached, a later VM::brand() call still runs the skipped techniques
+        const brand_list_t list = brands::rank_brands(score);
+
+        if (core::is_enabled(flags, MULTIPLE)) {
+            result.value = brands::brand_multiple(list);
+        } else {
+            result.value = brands::brand_enum_to_string(brands::brand_single(list));
         }
 
-        const core::technique& pair = core::technique_table.at(flag_bit);
+        return result;
+    }
 
-        if (auto run_fn = pair.run) {
-            core::last_detected_brand = brand_enum::NULL_BRAND;
-            core::last_detected_score = 0;
 
-            const bool result = run_fn();
+    /**
+     * @brief Detect if running inside a VM without blocking, the techniques are run on a separate thread
+     * @param any flag combination in VM structure or nothing
+     * @return VM::async_result<bool> (call .get() for the result or .cancel() to stop before the next technique)
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#advanced-vmdetect_async
+     */
+    template <typename ...Args>
+    static async_result<bool> detect_async(Args ...args) {
+        const flagset flags = core::arg_handler(args...);
+        return detect_async(flags);
+    }
 
-            const u8 points_to_add = (core::last_detected_score > 0) ? core::last_detected_score : pair.points;
 
-            if (result) {
-                detected_count_num++;
-            }
+    static async_result<bool> detect_async(const settings& settings) {
+        const flagset flags = settings.flag_collector;
+        return detect_async(flags);
+    }
 
-            memo::cache_store(flag_bit, result, result ? points_to_add : 0, core::last_detected_brand);
-            return result;
-        }
 
-        throw_error("Flag is not known or not implemented");
-        return false; // useless but whatever
+    static async_result<bool> detect_async(const flagset& flags = core::generate_default()) {
+        return core::launch_async<bool>(flags, SHORTCUT, [](const flagset& f) { return detect(f); });
     }
 
 
     /**
-     * @brief Fetch the VM brand
-     * @param any flag combination in VM structure or nothing (VM::MULTIPLE can be added)
-     * @return const char*
-     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#vmbrand
+     * @brief Get the percentage of how likely it's a VM without blocking, the techniques are run on a separate thread
+     * @param any flag combination in VM structure or nothing
+     * @return VM::async_result<std::uint8_t> (call .get() for the result or .cancel() to stop before the next technique)
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#advanced-vmdetect_async
      */
     template <typename ...Args>
-    static std::string brand(Args ...args) {
+    static async_result<u8> percentage_async(Args ...args) {
         const flagset flags = core::arg_handler(args...);
-        return brand(flags);
+        return percentage_async(flags);
     }
 
 
-    static std::string brand(const settings& settings) {
+    static async_result<u8> percentage_async(const settings& settings) {
         const flagset flags = settings.flag_collector;
-        return brand(flags);
+        return percentage_async(flags);
     }
 
 
-    static std::string brand(const flagset& flags = core::generate_default()) {
-        // is the multiple setting flag enabled?
-        const bool is_multiple = core::is_enabled(flags, MULTIPLE);
+    static async_result<u8> percentage_async(const flagset& flags = core::generate_default()) {
+        return core::launch_async<u8>(flags, SHORTCUT, [](const flagset& f) { return percentage(f); });
+    }
 
-        if (is_multiple) {
-            return brands::brand_multiple(flags);
-        }
 
-        const enum brand_enum b = brands::brand_single(flags);
-        return brands::brand_enum_to_string(b);
+    /**
+     * @brief Fetch the VM brand without blocking, the techniques are run on a separate thread
+     * @param any flag combination in VM structure or nothing (VM::MULTIPLE can be added)
+     * @return VM::async_result<std::string> (call .get() for the result or .cancel() to stop before the next technique)
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#advanced-vmdetect_async
+     */
+    template <typename ...Args>
+    static async_result<std::string> brand_async(Args ...args) {
+        const flagset flags = core::arg_handler(args...);
+        return brand_async(flags);
+    }
+
+
+    static async_result<std::string> brand_async(const settings& settings) {
+        const flagset flags = settings.flag_collector;
+        return brand_async(flags);
+    }
+
+
+    static async_result<std::string> brand_async(const flagset& flags = core::generate_default()) {
+        return core::launch_async<std::string>(flags, false, [](const flagset& f) { return brand(f); });
     }
 
 
     /**
-     * @brief Detect if running inside a VM
+     * @brief Fetch the conclusion message without blocking, the techniques are run on a separate thread
      * @param any flag combination in VM structure or nothing
-     * @return bool
-     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#vmdetect
+     * @return VM::async_result<std::string> (call .get() for the result or .cancel() to stop before the next technique)
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#advanced-vmdetect_async
      */
     template <typename ...Args>
-    static bool detect(Args ...args) {
-        // fetch all the flags in a std::bitset
+    static async_result<std::string> conclusion_async(Args ...args) {
         const flagset flags = core::arg_handler(args...);
-        return detect(flags);
+        return conclusion_async(flags);
     }
 
 
-    static bool detect(const settings& settings) {
+    static async_result<std::string> conclusion_async(const settings& settings) {
         const flagset flags = settings.flag_collector;
-        return detect(flags);
+        return conclusion_async(flags);
     }
 
 
-    static bool detect(const flagset &flags = core::generate_default()) {
-        // run all the techniques based on the 
-        // flags above, and get a total score 
-        const u16 points = core::run_all(flags, SHORTCUT);
+    static async_result<std::string> conclusion_async(const flagset& flags = core::generate_default()) {
+        return core::launch_async<std::string>(flags, false, [](const flagset& f) { return conclusion(f); });
+    }
 
-        u16 threshold = threshold_score;
 
-        // if high threshold is set, the bar
-        // will be 300. If not, leave it as 150
-        if (core::is_enabled(flags, HIGH_THRESHOLD)) {
-            threshold = high_threshold_score;
-        }
+    /**
+     * @brief Run the techniques one by one and report each outcome to a callback as soon as it's known
+     * @param callback (any callable taking a const VM::technique_report&, return false to stop early)
+     * @param any flag combination in VM structure or nothing
+     * @return std::uint8_t (the percentage based on the techniques that were run)
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#advanced-vmfor_each_technique
+     */
+    template <typename ...Args>
+    static u8 for_each_technique(const core::technique_callback& callback, Args ...args) {
+        const flagset flags = core::arg_handler(args...);
+        return for_each_technique(callback, flags);
+    }
 
-        if (points >= threshold) {
-            return true;
-        }
 
-        // this is added as a last ditch attempt to detect a VM, 
-        // because if there are indications of hardening then logically 
-        // it should in fact be a VM.
-        return (is_hardened());
+    static u8 for_each_technique(const core::technique_callback& callback, const settings& settings) {
+        const flagset flags = settings.flag_collector;
+        return for_each_technique(callback, flags);
+    }
+
+
+    static u8 for_each_technique(const core::technique_callback& callback, const flagset& flags = core::generate_default()) {
+        core::run_control control;
+        control.on_technique = &callback;
+
+        const u16 points = core::run_all(flags, false, &control);
+
+        return core::score_to_percentage(points, flags);
     }
 
 
     /**
-     * @brief Get the percentage of how likely it's a VM
+     * @brief Run again the techniques whose cached result has expired, and reuse every other one
      * @param any flag combination in VM structure or nothing
-     * @return std::uint8_t
-     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#vmpercentage
+     * @return std::uint8_t (the updated percentage)
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#advanced-vmrefresh
      */
     template <typename ...Args>
-    static u8 percentage(Args ...args) {
-        // fetch all the flags in a std::bitset
+    static u8 refresh(Args ...args) {
         const flagset flags = core::arg_handler(args...);
-        return percentage(flags);
+        return refresh(flags);
     }
 
 
-    static u8 percentage(const settings& settings) {
+    static u8 refresh(const settings& settings) {
         const flagset flags = settings.flag_collector;
-        return percentage(flags);
+        return refresh(flags);
     }
 
 
-    static u8 percentage(const flagset &flags = core::generate_default()) {
-        // run all the techniques based on the 
-        // flags above, and get a total score
-        const u16 points = core::run_all(flags, SHORTCUT);
+    static u8 refresh(const flagset& flags = core::generate_default()) {
+        // only the forgetting needs the detections on other threads out of the way, 
+        // running the techniques again is shared with them like any other detection
+        {
+            const memo::refresh_guard guard;
+            const u64 now = memo::now_ms();
+            bool expired = false;
 
-        u8 percent = 0;
-        u16 threshold = threshold_score;
+            for (u8 id = technique_begin; id < technique_end; ++id) {
+                if (core::is_selected(flags, id)) {
+                    expired = memo::expire(id, core::lifetime_of(static_cast<enum_flags>(id)), now) || expired;
+                }
+            }
 
-        // set to 300 if high threshold is enabled
-        if (core::is_enabled(flags, HIGH_THRESHOLD)) {
-            threshold = high_threshold_score;
+            // the brand, conclusion and so on have to be worked out again from the new results
+            if (expired) {
+                memo::reset_verdicts();
+            }
         }
 
-        // the percentage will be set to 99%, because a score 
-        // of 100 is not entirely robust. 150 is more robust
-        // in my opinion, which is why you need a score of
-        // above 150 to get to 100% 
-        if (points >= threshold) {
-            percent = 100;
-        } else if (points >= 100) {
-            percent = 99;
-        } else {
-            percent = static_cast<u8>(std::min<u16>(points, 99));
-        }
+        const u16 points = core::run_all(flags);
 
-        return percent;
+        return core::score_to_percentage(points, flags);
     }
 
 
@@ -13896,6 +17332,13 @@ public:
             case HIGH_THRESHOLD: return "HIGH_THRESHOLD"; 
             case DYNAMIC: return "DYNAMIC"; 
             case MULTIPLE: return "MULTIPLE"; 
+            case PARALLEL: return "PARALLEL"; 
+            case TIER_FAST: return "TIER_FAST"; 
+            case TIER_IO: return "TIER_IO"; 
+            case TIER_EXEC: return "TIER_EXEC"; 
+            case PERSIST: return "PERSIST"; 
+            case SHARED: return "SHARED"; 
+            case PREFETCH: return "PREFETCH"; 
             default: return "Unknown flag";
         }
     }
@@ -13920,6 +17363,8 @@ public:
 
 
     static std::vector<enum_flags> detected_enums(const flagset &flags = core::generate_default()) {
+        const memo::detection_guard guard;
+
         std::vector<enum_flags> tmp;
 
         // this will loop through all the enums in the technique_vector variable,
@@ -13928,7 +17373,7 @@ public:
             const enum_flags technique_enum = static_cast<enum_flags>(i);
 
             if (
-                (flags.test(technique_enum)) &&
+                (core::is_selected(flags, technique_enum)) &&
                 (check(technique_enum))
             ) {
                 tmp.push_back(technique_enum);
@@ -13961,7 +17406,7 @@ public:
         // run all the techniques, which will set the detected_count variable 
         core::run_all(flags);
 
-        return detected_count_num.load();
+        return core::last_detected_count;
     }
 
 
@@ -13984,8 +17429,14 @@ public:
 
 
     static std::string type(const flagset &flags = core::generate_default()) {
-        const brand_list_t& list = brands::brand_list(flags);
+        const memo::detection_guard guard;
+
+        return type_of(brands::brand_list(flags), flags);
+    }
+
 
+    // the type of the brand list that is already known, see VM::type()
+    static std::string type_of(const brand_list_t& list, const flagset& flags) {
         if (core::is_enabled(flags, MULTIPLE)) {
             if (list.size() > 1) {
                 return "Unknown";
@@ -14092,13 +17543,24 @@ public:
 
 
     static std::string conclusion(const flagset &flags = core::generate_default()) {
-        if (memo::conclusion::cached) {
+        const memo::detection_guard guard;
+
+        const bool tiered = core::is_tiered(flags);
+
+        if (!tiered && memo::conclusion::is_cached()) {
             return memo::conclusion::fetch();
         }
 
         const u8 percent_tmp = percentage(flags);
-        const bool has_hardener = is_hardened();
-        
+        const bool has_hardener = core::hardened_for(flags);
+
+        return conclusion_of(percent_tmp, has_hardener, flags, nullptr, !tiered);
+    }
+
+
+    // builds the conclusion message out of results that are already known. The brand list is 
+    // only fetched (or taken from the list argument if there's one) when the message needs it
+    static std::string conclusion_of(const u8 percent_tmp, const bool has_hardener, const flagset& flags, const brand_list_t* known_list, const bool memoize = true) {
         constexpr const char* very_unlikely = "Very unlikely";
         constexpr const char* unlikely = "Unlikely";
         constexpr const char* potentially = "Potentially";
@@ -14108,7 +17570,7 @@ public:
         constexpr const char* inside_vm = "Running inside";
         
         auto make_conclusion = [&](const char* category) -> std::string {
-            const brand_list_t& list = brands::brand_list(flags);
+            const brand_list_t list = ((known_list != nullptr) ? *known_list : brands::brand_list(flags));
 
             const brand_enum first_brand = brands::brand_single(list);
 
@@ -14155,7 +17617,7 @@ public:
                 brand_str = "unknown";
             } else {
                 if (core::is_enabled(flags, MULTIPLE)) {
-                    brand_str = brands::brand_multiple(flags);
+                    brand_str = ((known_list != nullptr) ? brands::brand_multiple(list) : brands::brand_multiple(flags));
                 } else {
                     brand_str = brands::brand_enum_to_string(first_brand);
                 }
@@ -14169,7 +17631,9 @@ public:
                 // Hyper-V artifacts are an exception due to how unique the circumstance is
                 (first_brand == brand_enum::HYPERV_ROOT ? "" : " VM");
 
-            memo::conclusion::store(result.c_str());
+            if (memoize) {
+                memo::conclusion::store(result.c_str());
+            }
 
             return result;
         };
@@ -14201,79 +17665,20 @@ public:
      * @return bool
      */
     static bool is_hardened() {
-        if (memo::hardened::cached) {
-            return memo::hardened::result;
-        }
-
-        auto hardened_logic = []() -> bool {
-            // Helper to get the specific brand associated with a technique using the cache
-            auto detected_brand = [](const enum_flags flag) -> enum brand_enum {
-                if (!check(flag)) {
-                    return brand_enum::NULL_BRAND;
-                }
-                if (memo::cache_table.at(flag).has_value) {
-                    return memo::cache_table.at(flag).brand_name;
-                }
-                return brand_enum::NULL_BRAND;
-            };
-
-            const bool hv_present = (check(VM::HYPERVISOR_BIT) || check(VM::HYPERVISOR_STR));
-            const bool has_hyper_x = []() {
-                if (check(VM::HYPERVISOR_BIT) || check(VM::HYPERVISOR_STR)) {
-                    return false;
-                }
-
-                const brand_enum bit_brand = memo::cache_table.at(VM::HYPERVISOR_BIT).brand_name;
-                const brand_enum str_brand = memo::cache_table.at(VM::HYPERVISOR_STR).brand_name;
-
-                return (
-                    (bit_brand == brand_enum::HYPERV_ROOT) || 
-                    (str_brand == brand_enum::HYPERV_ROOT)
-                );
-            }();
-
-            // rule 1: if VM::FIRMWARE is detected, so should VM::HYPERVISOR_BIT or VM::HYPERVISOR_STR
-            const enum brand_enum firmware_brand = detected_brand(VM::FIRMWARE);
-            if (firmware_brand != brand_enum::NULL_BRAND && !hv_present && !has_hyper_x) {
-                debug("is_hardened(): firmware and hypervisor bit/str are not detected together");
-                return true;
-            }
-
-        #if (LINUX)
-            // rule 2: if VM::FIRMWARE is detected, so should VM::CVENDOR (QEMU or VBOX)
-            if (firmware_brand == brand_enum::QEMU || firmware_brand == brand_enum::VBOX) {
-                const enum brand_enum cvendor_brand = detected_brand(VM::CVENDOR);
-                if (firmware_brand != cvendor_brand) {
-                    debug("is_hardened(): firmware and chassis vendor brands do not match");
-                    return true;
-                }
-            }
-        #endif
-
-        #if (WINDOWS)
-            // rule 3: if VM::ACPI_SIGNATURE (QEMU) is detected, so should VM::FIRMWARE (QEMU)
-            const enum brand_enum acpi_brand = detected_brand(VM::ACPI_SIGNATURE);
-            if (acpi_brand == brand_enum::QEMU && firmware_brand != brand_enum::QEMU) {
-                debug("is_hardened(): firmware and ACPI signature are not detected together");
-                return true;
-            }
+        const memo::detection_guard guard;
 
-            // rule 4: if VM::TRAP or VM::NVRAM is detected, so should VM::HYPERVISOR_BIT or VM::HYPERVISOR_STR
-            if ((check(VM::TRAP) || check(VM::NVRAM)) && !hv_present && !has_hyper_x) {
-                debug("is_hardened(): trap/NVRAM and hypervisor bit/str are not detected together");
-                return true;
-            }
-        #endif
+        if (memo::hardened::is_cached()) {
+            return memo::hardened::fetch();
+        }
 
-            return false;
-        };
+        flagset all;
+        core::generate_all(all);
 
-        const bool result = hardened_logic();
+        const bool result = core::hardening_rules(all);
 
-        memo::hardened::result = result;
-        memo::hardened::cached = true;
+        memo::hardened::store(result);
 
-        return result;
+        return memo::hardened::fetch();
     }
 
 
@@ -14300,17 +17705,50 @@ public:
             initialise(flags);
         }
 
-        // having this design avoids some niche errors
+        // having this design avoids some niche errors.
+        // Every field is derived from a single full run instead of having each public
+        // function walk the technique table, the cache and the brand list on its own
         void initialise(const flagset& flags) {
-            brand = VM::brand(flags);
-            type = VM::type(flags);
-            conclusion = VM::conclusion(flags);
-            is_vm = VM::detect(flags);
-            is_hardened = VM::is_hardened();
-            percentage = VM::percentage(flags);
-            detected_count = VM::detected_count(flags);
+            const memo::detection_guard guard;
+
+            const u16 points = core::run_all(flags);
+
+            // read right away, VM::is_hardened() might run a few more techniques
+            detected_count = core::last_detected_count;
+
+            // the brand list is cached from here on, so VM::brand() and VM::type() don't run anything.
+            // A tier only sees part of the techniques though, so nothing is cached for it
+            const bool tiered = core::is_tiered(flags);
+            const brand_list_t list = (
+                tiered ? 
+                brands::rank_brands(points, core::active_brands(core::scoreboard_for(flags))) : 
+                brands::cache_brand_list(points)
+            );
+
+            brand = (core::is_enabled(flags, MULTIPLE) ? brands::brand_multiple(list) : brands::brand_enum_to_string(brands::brand_single(list)));
+            type = VM::type_of(list, flags);
+            is_hardened = core::hardened_for(flags);
+            is_vm = ((points >= core::threshold_for(flags)) || is_hardened);
+            percentage = core::score_to_percentage(points, flags);
+            conclusion = (
+                (!tiered && memo::conclusion::is_cached()) ? 
+                std::string(memo::conclusion::fetch()) : 
+                VM::conclusion_of(percentage, is_hardened, flags, &list, !tiered)
+            );
             technique_count = VM::technique_count;
-            detected_techniques = VM::detected_enums(flags);
+            detected_techniques = [&]() -> std::vector<enum_flags> {
+                std::vector<enum_flags> tmp{};
+
+                for (u8 i = technique_begin; i < technique_end; ++i) {
+                    const enum_flags technique_enum = static_cast<enum_flags>(i);
+
+                    if (core::is_selected(flags, technique_enum) && memo::cache_fetch(technique_enum).result) {
+                        tmp.push_back(technique_enum);
+                    }
+                }
+
+                return tmp;
+            }();
             detected_technique_strings = [&]() -> std::vector<std::string> {
                 std::vector<std::string> tmp{};
                 tmp.reserve(detected_techniques.size());
@@ -14325,57 +17763,239 @@ public:
         }
 
     };
+
+
+    /**
+     * @brief An independently configured detection with its own flags, custom techniques, scoreboard and results
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#advanced-vmcontext
+     *
+     * The technique results themselves are still shared with the rest of the process since 
+     * they don't depend on any setting, so a context never runs a technique that already ran.
+     * Everything derived from them (the score, the brand and so on) only covers what the 
+     * context enabled, and VM::DISABLE() or VM::add_custom() elsewhere don't affect it.
+     */
+    struct context {
+        template <typename ...Args>
+        explicit context(Args ...args) : flags(core::arg_handler(args...)) {}
+
+        explicit context(const settings& settings) : flags(settings.flag_collector) {}
+
+        explicit context(const flagset& p_flags) : flags(p_flags) {}
+
+        context(const context&) = delete;
+        context& operator=(const context&) = delete;
+
+        // only counted by this context, the results are thrown away by the next reset()
+        void add_custom(const u8 percent, bool(*detection_func)()) {
+            if (percent > 100) {
+                throw std::invalid_argument("Percentage parameter must be between 0 and 100. Consult the documentation's parameters for VM::context::add_custom()");
+            }
+
+            const std::lock_guard<std::mutex> lock(mutex);
+            custom_table.push_back({ percent, 0, detection_func });
+            evaluated = false;
+        }
+
+        bool detect() {
+            const std::lock_guard<std::mutex> lock(mutex);
+            evaluate();
+            return (points >= core::threshold_for(flags)) || hardened;
+        }
+
+        u8 percentage() {
+            const std::lock_guard<std::mutex> lock(mutex);
+            evaluate();
+            return core::score_to_percentage(points, flags);
+        }
+
+        std::string brand() {
+            const std::lock_guard<std::mutex> lock(mutex);
+            evaluate();
+
+            if (core::is_enabled(flags, MULTIPLE)) {
+                return brands::brand_multiple(list);
+            }
+
+            return brands::brand_enum_to_string(brands::brand_single(list));
+        }
+
+        std::string type() {
+            const std::lock_guard<std::mutex> lock(mutex);
+            evaluate();
+            return VM::type_of(list, flags);
+        }
+
+        std::string conclusion() {
+            const std::lock_guard<std::mutex> lock(mutex);
+            evaluate();
+            return VM::conclusion_of(core::score_to_percentage(points, flags), hardened, flags, &list, false);
+        }
+
+        u8 detected_count() {
+            const std::lock_guard<std::mutex> lock(mutex);
+            evaluate();
+            return detected;
+        }
+
+        std::vector<enum_flags> detected_enums() {
+            const std::lock_guard<std::mutex> lock(mutex);
+            evaluate();
+
+            std::vector<enum_flags> tmp{};
+
+            for (u8 i = technique_begin; i < technique_end; ++i) {
+                const enum_flags technique_enum = static_cast<enum_flags>(i);
+
+                if (core::is_selected(flags, technique_enum) && memo::cache_fetch(technique_enum).result) {
+                    tmp.push_back(technique_enum);
+                }
+            }
+
+            return tmp;
+        }
+
+        // forgets the results of this context, the shared technique results are left alone
+        void reset() {
+            const std::lock_guard<std::mutex> lock(mutex);
+            evaluated = false;
+        }
+
+    private:
+        const flagset flags;
+        std::vector<core::custom_technique> custom_table;
+
+        // everything below is guarded by the mutex
+        std::mutex mutex;
+        bool evaluated = false;
+        u16 points = 0;
+        u8 detected = 0;
+        bool hardened = false;
+        brand_list_t list;
+
+        // a single full run, every query afterwards is answered from what it left behind
+        void evaluate() {
+            if (evaluated) {
+                return;
+            }
+
+            const memo::detection_guard guard;
+
+            core::run_control control;
+            control.skip_custom = true;
+
+            u16 score = core::run_all(flags, false, &control);
+            u8 count = core::last_detected_count;
+
+            // the scoreboard is rebuilt out of the techniques this context enabled
+            std::array<core::brand_entry, MAX_BRANDS> scoreboard = core::scoreboard_for(flags);
+
+            // same as core::run_all(), the cheaper tiers leave custom techniques out
+            const bool run_custom = !core::is_tiered(flags);
+
+            for (const core::custom_technique& technique : custom_table) {
+                if (!run_custom) {
+                    break;
+                }
+
+                std::vector<core::brand_contribution> journal;
+                std::vector<core::brand_contribution>* const outer_journal = core::brand_journal;
+
+                // core::add() calls from here on only end up in this context
+                core::brand_journal = &journal;
+
+                bool result = false;
+
+                try {
+                    result = technique.run();
+                } catch (...) {
+                    core::brand_journal = outer_journal;
+                    throw;
+                }
+
+                core::brand_journal = outer_journal;
+
+                if (result) {
+                    score = static_cast<u16>(score + technique.points);
+                    count++;
+                }
+
+                for (const core::brand_contribution& contribution : journal) {
+                    core::tally(scoreboard, contribution.brand, contribution.extra_brand);
+                }
+            }
+
+            points = score;
+            detected = count;
+            hardened = core::hardening_rules(flags); // only reads the results of the run above
+            list = brands::rank_brands(points, core::active_brands(scoreboard));
+            evaluated = true;
+        }
+    };
 };
 
 // ============= EXTERNAL DEFINITIONS =============
 // These are added here due to warnings related to C++17 inline variables for C++ standards that are under 17
 // It's easier to just group them together rather than having C++17<= preprocessors with inline stuff
 char VM::memo::conclusion::cache[512] = { 0 };
-bool VM::memo::conclusion::cached = false;
+std::atomic<VM::u8> VM::memo::conclusion::state{ VM::memo::SLOT_EMPTY };
 
 // scoreboard list of brands, if a VM detection technique detects a brand, that will be incremented here as a single point
-std::array<VM::core::brand_entry, VM::MAX_BRANDS> VM::core::brand_scoreboard = []() {
-    std::array<VM::core::brand_entry, VM::MAX_BRANDS> arr{};
-
-    for (u8 i = 0; i < MAX_BRANDS; i++) {
-        arr.at(i) = { static_cast<brand_enum>(i), 0 };
-    }
-
-    return arr;
-}();
+std::mutex VM::core::scoreboard_mutex;
+std::atomic<VM::u32> VM::core::scoreboard_generation{ 0 };
+std::vector<VM::core::brand_contribution> VM::core::external_journal;
+std::array<VM::core::brand_entry, VM::MAX_BRANDS> VM::core::brand_scoreboard = VM::core::empty_scoreboard();
 
 // initial definitions for cache items because C++ forbids in-class initializations
 std::array<VM::memo::cache_entry, VM::enum_size + 1> VM::memo::cache_table{};
+std::mutex VM::memo::refresh_lock::mutex;
+std::condition_variable VM::memo::refresh_lock::changed;
+VM::u32 VM::memo::refresh_lock::readers = 0;
+VM::u32 VM::memo::refresh_lock::writers_waiting = 0;
+bool VM::memo::refresh_lock::writer = false;
+thread_local VM::u32 VM::memo::refresh_lock::depth = 0;
+std::atomic<VM::u32> VM::memo::cache_generation{ 0 };
+std::atomic<VM::u8> VM::memo::persist::state{ VM::memo::SLOT_EMPTY };
+std::atomic<VM::u32> VM::memo::persist::saved_generation{ 0 };
+std::atomic<VM::u8> VM::memo::shared::state{ VM::memo::SLOT_EMPTY };
+std::atomic<VM::u32> VM::memo::shared::published_generation{ 0 };
+VM::memo::shared::segment_t* VM::memo::shared::segment = nullptr;
 enum VM::brand_enum VM::memo::single_brand::brand_cache = brand_enum::NULL_BRAND;
 std::string VM::memo::multi_brand::brand_cache;
 char VM::memo::cpu_brand::brand_cache[128] = { 0 };
 char VM::memo::bios_info::manufacturer[256] = { 0 };
 char VM::memo::bios_info::model[128] = { 0 };
-bool VM::memo::single_brand::cached = false;
-bool VM::memo::multi_brand::cached = false;
-bool VM::memo::cpu_brand::cached = false;
-bool VM::memo::bios_info::cached = false;
-bool VM::memo::hyperx::cached = false;
+std::atomic<VM::u8> VM::memo::single_brand::state{ VM::memo::SLOT_EMPTY };
+std::atomic<VM::u8> VM::memo::multi_brand::state{ VM::memo::SLOT_EMPTY };
+std::atomic<VM::u8> VM::memo::cpu_brand::state{ VM::memo::SLOT_EMPTY };
+std::atomic<VM::u8> VM::memo::bios_info::state{ VM::memo::SLOT_EMPTY };
+std::atomic<VM::u8> VM::memo::hyperx::slot{ VM::memo::SLOT_EMPTY };
 bool VM::memo::hardened::result = false;
-bool VM::memo::hardened::cached = false;
-VM::u32 VM::memo::threadcount::threadcount_cache = 0;
+std::atomic<VM::u8> VM::memo::hardened::state{ VM::memo::SLOT_EMPTY };
+std::atomic<VM::u32> VM::memo::threadcount::threadcount_cache{ 0 };
 VM::hyperx_state VM::memo::hyperx::state = VM::HYPERV_UNKNOWN;
 std::array<VM::memo::leaf_entry, VM::memo::leaf_cache::CAPACITY> VM::memo::leaf_cache::table{};
 std::size_t VM::memo::leaf_cache::count = 0;
 std::size_t VM::memo::leaf_cache::next_index = 0;
+std::mutex VM::memo::leaf_cache::mutex;
 VM::brand_list_t VM::memo::brand_list::cache = {};
-bool VM::memo::brand_list::cached = false;
+std::atomic<VM::u8> VM::memo::brand_list::state{ VM::memo::SLOT_EMPTY };
 
+thread_local VM::util::file_cache* VM::util::active_file_cache = nullptr;
+thread_local std::unique_ptr<VM::util::file_cache> VM::util::idle_file_cache;
+std::atomic<VM::u32> VM::util::file_cache::total_reads{ 0 };
+std::atomic<VM::u32> VM::util::file_cache::total_hits{ 0 };
 thread_local enum VM::brand_enum VM::core::last_detected_brand = VM::brand_enum::NULL_BRAND;
 thread_local VM::u8 VM::core::last_detected_score = 0;
+thread_local VM::u8 VM::core::last_detected_count = 0;
+thread_local std::vector<VM::core::brand_contribution>* VM::core::brand_journal = nullptr;
 
 // these are basically the base values for the core::arg_handler function.
 // It's like a bucket that will collect all the bits enabled. If for example 
 // VM::detect(VM::HIGH_THRESHOLD) is passed, the HIGH_THRESHOLD bit will be 
 // collected to this flagset (std::bitset) variable, and eventually be provided
 // as the return value for actual end-user functions like VM::detect() to operate on.
-VM::flagset VM::core::flag_collector;
-VM::flagset VM::core::disabled_flag_collector;
+thread_local VM::flagset VM::core::flag_collector;
+thread_local VM::flagset VM::core::disabled_flag_collector;
 
 
 std::atomic<VM::u8> VM::detected_count_num{0};
@@ -14395,115 +18015,119 @@ std::vector<VM::core::custom_technique> VM::core::custom_table = {
 }; 
 size_t VM::core::custom_table_size = 0;
 
+// last measured runtime of each technique, filled in by VM::core::run_journaled()
+std::array<std::atomic<VM::u32>, VM::enum_size + 1> VM::core::technique_latency{};
+
 // the 0~100 points are debatable, but we think it's fine how it is. Feel free to disagree
 std::array<VM::core::technique, VM::enum_size + 1> VM::core::technique_table = []() {
     std::array<VM::core::technique, VM::enum_size + 1> table{};
-    // FORMAT: { VM::<ID>, { certainty%, function pointer } },
+    using cost = VM::core::cost;
+    // FORMAT: { VM::<ID>, { certainty%, function pointer, cost class } },
     const VM::core::technique_entry entries[] = {
         // START OF TECHNIQUE TABLE
         #if (WINDOWS)
-            {VM::TRAP, {100, VM::trap}},
-            {VM::KVM_INTERCEPTION, {150, VM::kvm_interception}},
-            {VM::SVM_EXCEPTIONS, {150, VM::svm_exceptions}},
-            {VM::INTERRUPT_SHADOW, {100, VM::interrupt_shadow}},
-            {VM::EIP_OVERFLOW, {100, VM::eip_overflow}},
-            {VM::HYPERVISOR_HOOK, {100, VM::hypervisor_hook}},
-            {VM::SINGLE_STEP, {100, VM::single_step}},
-            {VM::NVRAM, {100, VM::nvram}},
-            {VM::CPU_HEURISTIC, {90, VM::cpu_heuristic}},
-            {VM::ACPI_SIGNATURE, {100, VM::acpi_signature}},
-            {VM::CLOCK, {45, VM::clock}},
-            {VM::POWER_CAPABILITIES, {25, VM::power_capabilities}},
-            {VM::GPU_CAPABILITIES, {25, VM::gpu_capabilities}},
-            {VM::MSR, {100, VM::msr}},
-            {VM::VIRTUAL_PROCESSORS, {100, VM::virtual_processors}},
-            {VM::WINE, {100, VM::wine}},
-            {VM::DBVM, {150, VM::dbvm}},
-            {VM::UD, {100, VM::ud}},
-            {VM::IVSHMEM, {100, VM::ivshmem}},
-            {VM::DRIVERS, {100, VM::drivers}},
-            {VM::HYPERVISOR_QUERY, {100, VM::hypervisor_query}},
-            {VM::HANDLES, {100, VM::device_handles}},
-            {VM::KERNEL_OBJECTS, {100, VM::kernel_objects}},
-            {VM::DLL, {50, VM::dll}},
-            {VM::AUDIO, {25, VM::audio}},
-            {VM::DISPLAY, {25, VM::display}},
-            {VM::VMWARE_BACKDOOR, {100, VM::vmware_backdoor}},
-            {VM::VIRTUAL_REGISTRY, {90, VM::virtual_registry}},
-            {VM::MUTEX, {100, VM::mutex}},
-            {VM::VPC_INVALID, {75, VM::vpc_invalid}},
-            {VM::VMWARE_STR, {35, VM::vmware_str}},
-            {VM::GAMARUE, {10, VM::gamarue}},
-            {VM::CUCKOO_DIR, {30, VM::cuckoo_dir}},
-            {VM::CUCKOO_PIPE, {30, VM::cuckoo_pipe}},
+            {VM::TRAP, {100, VM::trap, cost::CPU}},
+            {VM::KVM_INTERCEPTION, {150, VM::kvm_interception, cost::CPU}},
+            {VM::SVM_EXCEPTIONS, {150, VM::svm_exceptions, cost::CPU}},
+            {VM::INTERRUPT_SHADOW, {100, VM::interrupt_shadow, cost::CPU}},
+            {VM::EIP_OVERFLOW, {100, VM::eip_overflow, cost::CPU}},
+            {VM::HYPERVISOR_HOOK, {100, VM::hypervisor_hook, cost::CPU}},
+            {VM::SINGLE_STEP, {100, VM::single_step, cost::CPU}},
+            {VM::NVRAM, {100, VM::nvram, cost::IO}},
+            {VM::CPU_HEURISTIC, {90, VM::cpu_heuristic, cost::CPU}},
+            {VM::ACPI_SIGNATURE, {100, VM::acpi_signature, cost::SCAN}},
+            {VM::CLOCK, {45, VM::clock, cost::CPU}},
+            {VM::POWER_CAPABILITIES, {25, VM::power_capabilities, cost::IO}},
+            {VM::GPU_CAPABILITIES, {25, VM::gpu_capabilities, cost::SCAN}},
+            {VM::MSR, {100, VM::msr, cost::CPU}},
+            {VM::VIRTUAL_PROCESSORS, {100, VM::virtual_processors, cost::CPUID}},
+            {VM::WINE, {100, VM::wine, cost::IO}},
+            {VM::DBVM, {150, VM::dbvm, cost::CPU}},
+            {VM::UD, {100, VM::ud, cost::CPU}},
+            {VM::IVSHMEM, {100, VM::ivshmem, cost::SCAN}},
+            {VM::DRIVERS, {100, VM::drivers, cost::SCAN}},
+            {VM::HYPERVISOR_QUERY, {100, VM::hypervisor_query, cost::IO}},
+            {VM::HANDLES, {100, VM::device_handles, cost::IO}},
+            {VM::KERNEL_OBJECTS, {100, VM::kernel_objects, cost::SCAN}},
+            {VM::DLL, {50, VM::dll, cost::IO}},
+            {VM::AUDIO, {25, VM::audio, cost::SCAN}},
+            {VM::DISPLAY, {25, VM::display, cost::IO}},
+            {VM::VMWARE_BACKDOOR, {100, VM::vmware_backdoor, cost::CPU}},
+            {VM::VIRTUAL_REGISTRY, {90, VM::virtual_registry, cost::SCAN}},
+            {VM::MUTEX, {100, VM::mutex, cost::IO}},
+            {VM::VPC_INVALID, {75, VM::vpc_invalid, cost::CPU}},
+            {VM::VMWARE_STR, {35, VM::vmware_str, cost::CPU}},
+            {VM::GAMARUE, {10, VM::gamarue, cost::IO}},
+            {VM::CUCKOO_DIR, {30, VM::cuckoo_dir, cost::IO}},
+            {VM::CUCKOO_PIPE, {30, VM::cuckoo_pipe, cost::IO}},
         #endif
 
         #if (LINUX || WINDOWS)
-            {VM::FIRMWARE, {100, VM::firmware}},
-            {VM::DEVICES, {95, VM::pci_devices}},
-            {VM::SYSTEM_REGISTERS, {50, VM::system_registers}},
-            {VM::AZURE, {30, VM::azure}},
-            {VM::BOOT_LOGO, {100, VM::boot_logo}},
-            {VM::DISK_SERIAL, {100, VM::disk_serial_number}},
+            {VM::FIRMWARE, {100, VM::firmware, cost::SCAN}},
+            {VM::DEVICES, {95, VM::pci_devices, cost::SCAN}},
+            {VM::SYSTEM_REGISTERS, {50, VM::system_registers, cost::CPU}},
+            {VM::AZURE, {30, VM::azure, cost::IO}},
+            {VM::BOOT_LOGO, {100, VM::boot_logo, cost::IO}},
+            {VM::DISK_SERIAL, {100, VM::disk_serial_number, cost::IO}},
         #endif
 
         #if (LINUX)
-            {VM::SMBIOS_VM_BIT, {50, VM::smbios_vm_bit}},
-            {VM::KMSG, {5, VM::kmsg}},
-            {VM::CVENDOR, {65, VM::chassis_vendor}},
-            {VM::QEMU_FW_CFG, {70, VM::qemu_fw_cfg}},
-            {VM::SYSTEMD, {35, VM::systemd_virt}},
-            {VM::CTYPE, {20, VM::chassis_type}},
-            {VM::DOCKERENV, {30, VM::dockerenv}},
-            {VM::DMIDECODE, {55, VM::dmidecode}},
-            {VM::DMESG, {55, VM::dmesg}},
-            {VM::HWMON, {35, VM::hwmon}},
-            {VM::LINUX_USER_HOST, {10, VM::linux_user_host}},
-            {VM::VMWARE_IOMEM, {65, VM::vmware_iomem}},
-            {VM::VMWARE_IOPORTS, {70, VM::vmware_ioports}},
-            {VM::VMWARE_SCSI, {40, VM::vmware_scsi}},
-            {VM::VMWARE_DMESG, {65, VM::vmware_dmesg}},
-            {VM::QEMU_VIRTUAL_DMI, {40, VM::qemu_virtual_dmi}},
-            {VM::QEMU_USB, {20, VM::qemu_USB}},
-            {VM::HYPERVISOR_DIR, {20, VM::hypervisor_dir}},
-            {VM::UML_CPU, {80, VM::uml_cpu}},
-            {VM::VBOX_MODULE, {15, VM::vbox_module}},
-            {VM::SYSINFO_PROC, {15, VM::sysinfo_proc}},
-            {VM::DMI_SCAN, {50, VM::dmi_scan}},
-            {VM::PODMAN_FILE, {5, VM::podman_file}},
-            {VM::WSL_PROC, {30, VM::wsl_proc_subdir}},
-            {VM::FILE_ACCESS_HISTORY, {15, VM::file_access_history}},
-            {VM::MAC, {20, VM::mac_address_check}},
-            {VM::CONTAINER_PID, {75, VM::container_proc_id}},
-            {VM::BLUESTACKS_FOLDERS, {5, VM::bluestacks}},
-            {VM::AMD_SEV_MSR, {50, VM::amd_sev_msr}},
-            {VM::TEMPERATURE, {20, VM::temperature}},
-            {VM::CGROUP, {70, VM::cgroup}},
-            {VM::PROCESSES, {40, VM::processes}},
+            {VM::SMBIOS_VM_BIT, {50, VM::smbios_vm_bit, cost::IO}},
+            {VM::KMSG, {5, VM::kmsg, cost::IO}},
+            {VM::CVENDOR, {65, VM::chassis_vendor, cost::IO}},
+            {VM::QEMU_FW_CFG, {70, VM::qemu_fw_cfg, cost::IO}},
+            {VM::SYSTEMD, {35, VM::systemd_virt, cost::IO}},
+            {VM::CTYPE, {20, VM::chassis_type, cost::IO}},
+            {VM::DOCKERENV, {30, VM::dockerenv, cost::IO}},
+            {VM::DMIDECODE, {55, VM::dmidecode, cost::IO}},
+            {VM::DMESG, {55, VM::dmesg, cost::IO}},
+            {VM::HWMON, {35, VM::hwmon, cost::IO}},
+            {VM::LINUX_USER_HOST, {10, VM::linux_user_host, cost::IO}},
+            {VM::VMWARE_IOMEM, {65, VM::vmware_iomem, cost::IO}},
+            {VM::VMWARE_IOPORTS, {70, VM::vmware_ioports, cost::IO}},
+            {VM::VMWARE_SCSI, {40, VM::vmware_scsi, cost::IO}},
+            {VM::VMWARE_DMESG, {65, VM::vmware_dmesg, cost::IO}},
+            {VM::QEMU_VIRTUAL_DMI, {40, VM::qemu_virtual_dmi, cost::IO}},
+            {VM::QEMU_USB, {20, VM::qemu_USB, cost::IO}},
+            {VM::HYPERVISOR_DIR, {20, VM::hypervisor_dir, cost::IO}},
+            {VM::UML_CPU, {80, VM::uml_cpu, cost::IO}},
+            {VM::VBOX_MODULE, {15, VM::vbox_module, cost::IO}},
+            {VM::SYSINFO_PROC, {15, VM::sysinfo_proc, cost::IO}},
+            {VM::DMI_SCAN, {50, VM::dmi_scan, cost::IO}},
+            {VM::PODMAN_FILE, {5, VM::podman_file, cost::IO}},
+            {VM::WSL_PROC, {30, VM::wsl_proc_subdir, cost::IO}},
+            {VM::FILE_ACCESS_HISTORY, {15, VM::file_access_history, cost::IO}},
+            {VM::MAC, {20, VM::mac_address_check, cost::IO}},
+            {VM::CONTAINER_PID, {75, VM::container_proc_id, cost::IO}},
+            {VM::BLUESTACKS_FOLDERS, {5, VM::bluestacks, cost::IO}},
+            {VM::AMD_SEV_MSR, {50, VM::amd_sev_msr, cost::IO}},
+            {VM::TEMPERATURE, {20, VM::temperature, cost::IO}},
+            {VM::CGROUP, {70, VM::cgroup, cost::IO}},
+            {VM::PROCESSES, {40, VM::processes, cost::SCAN}},
         #endif    
 
         #if (LINUX || APPLE)
-            {VM::THREAD_COUNT, {35, VM::thread_count}},
+            {VM::THREAD_COUNT, {35, VM::thread_count, cost::IO}},
         #endif
 
         #if (APPLE)
-            {VM::MAC_MEMSIZE, {15, VM::hw_memsize}},
-            {VM::MAC_IOKIT, {100, VM::io_kit}},
-            {VM::MAC_SIP, {100, VM::mac_sip}},
-            {VM::IOREG_GREP, {100, VM::ioreg_grep}},
-            {VM::HWMODEL, {100, VM::hwmodel}},
-            {VM::MAC_SYS, {100, VM::mac_sys}},
+            {VM::MAC_MEMSIZE, {15, VM::hw_memsize, cost::EXEC}},
+            {VM::MAC_IOKIT, {100, VM::io_kit, cost::SCAN}},
+            {VM::MAC_SIP, {100, VM::mac_sip, cost::EXEC}},
+            {VM::IOREG_GREP, {100, VM::ioreg_grep, cost::EXEC}},
+            {VM::HWMODEL, {100, VM::hwmodel, cost::IO}},
+            {VM::MAC_SYS, {100, VM::mac_sys, cost::EXEC}},
         #endif
 
-        {VM::TIMER, {95, VM::timer}},
-        {VM::THREAD_MISMATCH, {50, VM::thread_mismatch}},
-        {VM::VMID, {100, VM::vmid}},
-        {VM::CPU_BRAND, {95, VM::cpu_brand}},
-        {VM::CPUID_SIGNATURE, {95, VM::cpuid_signature}},
-        {VM::HYPERVISOR_STR, {100, VM::hypervisor_str}},
-        {VM::HYPERVISOR_BIT, {100, VM::hypervisor_bit}},
-        {VM::BOCHS_CPU, {100, VM::bochs_cpu}},
-        {VM::KGT_SIGNATURE, {80, VM::intel_kgt_signature}}
+        {VM::TIMER, {95, VM::timer, cost::CPU}},
+        {VM::THREAD_MISMATCH, {50, VM::thread_mismatch, cost::IO}},
+        {VM::VMID, {100, VM::vmid, cost::CPUID}},
+        {VM::CPU_BRAND, {95, VM::cpu_brand, cost::CPUID}},
+        {VM::CPUID_SIGNATURE, {95, VM::cpuid_signature, cost::CPUID}},
+        {VM::HYPERVISOR_STR, {100, VM::hypervisor_str, cost::CPUID}},
+        {VM::HYPERVISOR_BIT, {100, VM::hypervisor_bit, cost::CPUID}},
+        {VM::BOCHS_CPU, {100, VM::bochs_cpu, cost::CPUID}},
+        {VM::KGT_SIGNATURE, {80, VM::intel_kgt_signature, cost::CPUID}}
         // END OF TECHNIQUE TABLE
     };
 